@@ -85,6 +85,8 @@ function( CreateDocLibKTX )
         lib/astc_encode.cpp
         lib/basis_encode.cpp
         lib/basis_transcode.cpp
+        lib/block_decode.cpp
+        lib/redeflate.cpp
         lib/strings.c
         lib/glloader.c
         lib/hashlist.c
@@ -96,6 +98,7 @@ function( CreateDocLibKTX )
         lib/vkloader.c
         lib/writer1.c
         lib/writer2.c
+        lib/zstdfilter.c
     )
     add_docs_cmake(libktx.doc)
 endfunction()
@@ -115,8 +118,10 @@ function( CreateDocKTXTools )
 
     doxygen_add_docs(
         ktxtools.doc
+        tools/dds2ktx2/dds2ktx2.cpp
         tools/ktxinfo/ktxinfo.cpp
         tools/ktx2check/ktx2check.cpp
+        tools/ktx2img/ktx2img.cpp
         tools/ktx2ktx2/ktx2ktx2.cpp
         tools/ktxsc/ktxsc.cpp
         tools/toktx/toktx.cc
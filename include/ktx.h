@@ -134,6 +134,15 @@ extern "C" {
  * @brief Key string for standard writer supercompression parameter metadata.
  */
 #define KTX_WRITER_SCPARAMS_KEY "KTXwriterScParams"
+/**
+ * @~English
+ * @brief Key string for libktx per-level content hash metadata.
+ *
+ * The value is the XXH64 of each level's stored data as a little-endian
+ * 64-bit integer, level 0 first. It is not a KTX key so it does not have
+ * the KTX prefix.
+ */
+#define KTX_LEVEL_HASHES_KEY "libktxLevelXXH64"
 /**
  * @~English
  * @brief Standard KTX 1 format for 1D orientation value.
@@ -438,6 +447,33 @@ typedef KTX_error_code
                      ktx_uint64_t faceLodSize,
                      void* pixels, void* userdata);
 
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Signature of function called by ktxTexture2_IterateLoadImages() to
+ *        receive the data of a single image.
+ *
+ * @param [in] miplevel        MIP level from 0 to the max level which is
+ *                             dependent on the texture size.
+ * @param [in] layer           array layer, 0 for non-array textures.
+ * @param [in] faceSlice       for cube maps, one of the 6 cube faces in the
+ *                             order +X, -X, +Y, -Y, +Z, -Z, 0 to 5; for 3D
+ *                             textures, the depth slice; otherwise 0.
+ * @param [in] width           width of the image.
+ * @param [in] height          height of the image or, for 1D textures
+ *                             textures, 1.
+ * @param [in] imageSize       number of bytes of data pointed at by
+ *                             @p pixels.
+ * @param [in] pixels          pointer to the image data.
+ * @param [in,out] userdata    pointer for the application to pass data to and
+ *                             from the callback function.
+ */
+typedef KTX_error_code
+    (* PFNKTXIMAGEITERCB)(int miplevel, int layer, int faceSlice,
+                          int width, int height,
+                          ktx_uint64_t imageSize,
+                          void* pixels, void* userdata);
+
 /* Don't use KTX_APIENTRYP to avoid a Doxygen bug. */
 typedef void (KTX_APIENTRY* PFNKTEXDESTROY)(ktxTexture* This);
 typedef KTX_error_code
@@ -673,6 +709,14 @@ typedef enum ktxSupercmpScheme {
     KTX_SS_BEGIN_RANGE = KTX_SS_NONE,
     KTX_SS_END_RANGE = KTX_SS_ZSTD,
     KTX_SS_BEGIN_VENDOR_RANGE = 0x10000,
+    KTX_SS_ZSTD_SHUFFLE_DELTA = 0x10001,
+        /*!< libktx vendor scheme. ZStd supercompression of data
+             pre-filtered by splitting each row into byte planes and
+             delta coding them. */
+    KTX_SS_ZSTD_BLOCK_SPLIT = 0x10002,
+        /*!< libktx vendor scheme. ZStd supercompression of block-compressed
+             data pre-filtered by splitting each row of blocks into byte
+             planes. */
     KTX_SS_END_VENDOR_RANGE = 0x1ffff,
     KTX_SS_BEGIN_RESERVED = 0x20000,
     KTX_SUPERCOMPRESSION_BASIS = KTX_SS_BASIS_LZ,
@@ -681,6 +725,28 @@ typedef enum ktxSupercmpScheme {
         /*!< @deprecated Will be removed before v4 release. Use  KTX_SS_ZSTD instead. */
 } ktxSupercmpScheme;
 
+/**
+ * @~English
+ * @brief Enumerators identifying the reversible filters that can be applied
+ *        to the data before Zstd deflation.
+ *
+ * @sa ktxTexture2_DeflateZstdFiltered().
+ */
+typedef enum ktx_zstd_filter_e {
+    KTX_ZSTD_FILTER_NONE = 0,
+        /*!< No filter. The data is supercompressed with KTX_SS_ZSTD. */
+    KTX_ZSTD_FILTER_SHUFFLE_DELTA = 1,
+        /*!< Split the bytes of each element of a row into planes and delta
+             code each plane. For uncompressed formats with multi-byte
+             components. The data is supercompressed with
+             KTX_SS_ZSTD_SHUFFLE_DELTA. */
+    KTX_ZSTD_FILTER_BLOCK_SPLIT = 2,
+        /*!< Split the bytes of the blocks of each row of blocks into planes
+             so the byte-aligned fields of the blocks, e.g. endpoints and
+             indices, are in separate streams. For block-compressed formats.
+             The data is supercompressed with KTX_SS_ZSTD_BLOCK_SPLIT. */
+} ktx_zstd_filter_e;
+
 /**
  * @class ktxTexture2
  * @~English
@@ -938,6 +1004,61 @@ ktxTexture_GetElementSize(ktxTexture* This);
 KTX_API ktx_size_t KTX_APIENTRY
 ktxTexture_GetDataSize(ktxTexture* This);
 
+/**
+ * @memberof ktxTexture
+ * @~English
+ * @brief Structure describing one subresource of a ktxTexture.
+ *
+ * A subresource is the image of one mip level, array layer and face. For
+ * 3D textures it includes all the depth slices of the level. Sizes and
+ * pitches are in bytes and count whole blocks for compressed formats.
+ */
+typedef struct ktxSubresourceLayout {
+    ktx_uint32_t level;   /*!< Mip level of the subresource. */
+    ktx_uint32_t layer;   /*!< Array layer of the subresource. */
+    ktx_uint32_t face;    /*!< Cube map face of the subresource. */
+    ktx_uint32_t width;   /*!< Width of the subresource in texels. */
+    ktx_uint32_t height;  /*!< Height of the subresource in texels. */
+    ktx_uint32_t depth;   /*!< Number of depth slices. */
+    ktx_size_t offset;    /*!< Offset of the subresource from the start of
+                               the data. */
+    ktx_size_t size;      /*!< Size of the subresource. */
+    ktx_uint32_t rowPitch;  /*!< Bytes from the start of one row of blocks to
+                                 the next. */
+    ktx_uint32_t rowCount;  /*!< Number of rows of blocks in a slice. */
+    ktx_size_t slicePitch;  /*!< Bytes from the start of one depth slice to
+                                 the next. */
+    ktx_uint32_t rowSize;   /*!< Bytes of texel data in a row, excluding
+                                 any padding. */
+    ktx_uint32_t blockWidth;  /*!< Width of the format's blocks in texels.
+                                   1 for uncompressed formats. */
+    ktx_uint32_t blockHeight; /*!< Height of the format's blocks in texels. */
+    ktx_uint32_t blockDepth;  /*!< Depth of the format's blocks in texels. */
+    ktx_uint32_t blockSize;   /*!< Size of a block, or texel, in bytes. */
+} ktxSubresourceLayout;
+
+/*
+ * Returns the layout of every subresource of a ktxTexture, either in the
+ * texture's data or re-laid out with the given alignments.
+ */
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture_GetSubresourceLayouts(ktxTexture* This,
+                                 ktx_uint32_t rowAlignment,
+                                 ktx_uint32_t subresourceAlignment,
+                                 ktxSubresourceLayout* pLayouts,
+                                 ktx_uint32_t* pNumLayouts,
+                                 ktx_size_t* pTotalSize);
+
+/*
+ * Copies the images of a ktxTexture to a buffer laid out as described by
+ * layouts returned from ktxTexture_GetSubresourceLayouts.
+ */
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture_CopyToSubresourceLayouts(ktxTexture* This,
+                                    const ktxSubresourceLayout* pLayouts,
+                                    ktx_uint32_t numLayouts,
+                                    ktx_uint8_t* pDst, ktx_size_t dstSize);
+
 /* Uploads a texture to OpenGL {,ES}. */
 KTX_API KTX_error_code KTX_APIENTRY
 ktxTexture_GLUpload(ktxTexture* This, GLuint* pTexture, GLenum* pTarget,
@@ -1045,12 +1166,62 @@ ktxTexture2_CreateFromStream(ktxStream* stream,
                              ktxTextureCreateFlags createFlags,
                              ktxTexture2** newTex);
 
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_CreateFromShared(const char* name,
+                             ktxTextureCreateFlags createFlags,
+                             ktxTexture2** newTex);
+
 KTX_API KTX_error_code KTX_APIENTRY
 ktxTexture2_CompressBasis(ktxTexture2* This, ktx_uint32_t quality);
 
 KTX_API KTX_error_code KTX_APIENTRY
 ktxTexture2_DeflateZstd(ktxTexture2* This, ktx_uint32_t level);
 
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_DeflateZstdFiltered(ktxTexture2* This, ktx_uint32_t level,
+                                ktx_zstd_filter_e filter);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_DeflateZstdToStream(ktxTexture2* This, ktxStream* dststr,
+                                ktx_uint32_t level);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_DeflateZstdToStdioStream(ktxTexture2* This, FILE* dstsstr,
+                                     ktx_uint32_t level);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_DeflateZstdToNamedFile(ktxTexture2* This,
+                                   const char* const dstname,
+                                   ktx_uint32_t level);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_WriteAlignedToStream(ktxTexture2* This, ktxStream* dststr,
+                                 ktx_uint32_t alignment);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_WriteAlignedToStdioStream(ktxTexture2* This, FILE* dstsstr,
+                                      ktx_uint32_t alignment);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_WriteAlignedToNamedFile(ktxTexture2* This,
+                                    const char* const dstname,
+                                    ktx_uint32_t alignment);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_WriteAlignedToMemory(ktxTexture2* This,
+                                 ktx_uint8_t** ppDstBytes, ktx_size_t* pSize,
+                                 ktx_uint32_t alignment);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_RedeflateZstd(ktxTexture2* This, ktx_uint32_t level,
+                          ktx_zstd_filter_e filter, ktx_uint32_t threadCount);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_AddLevelHashes(ktxTexture2* This);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_PublishShared(ktxTexture2* This, const char* name);
+
 KTX_API void KTX_APIENTRY
 ktxTexture2_GetComponentInfo(ktxTexture2* This, ktx_uint32_t* numComponents,
                              ktx_uint32_t* componentByteLength);
@@ -1067,6 +1238,30 @@ ktxTexture2_GetPremultipliedAlpha(ktxTexture2* This);
 KTX_API ktx_bool_t KTX_APIENTRY
 ktxTexture2_NeedsTranscoding(ktxTexture2* This);
 
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_IterateLoadImages(ktxTexture2* This, PFNKTXIMAGEITERCB iterCb,
+                              void* userdata);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_GetLevelHash(ktxTexture2* This, ktx_uint32_t level,
+                         ktx_uint64_t* pHash);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_VerifyLevelHash(ktxTexture2* This, ktx_uint32_t level);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_VerifyLevelHashes(ktxTexture2* This, ktx_uint32_t threadCount,
+                              ktx_uint32_t* pBadLevel);
+
+KTX_API ktx_bool_t KTX_APIENTRY
+ktxTexture2_IsSharedViewValid(ktxTexture2* This);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_GetSharedRefCount(const char* name, ktx_uint32_t* pCount);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_InvalidateShared(const char* name);
+
 /**
  * @~English
  * @brief Flags specifiying UASTC encoding options.
@@ -1232,6 +1427,9 @@ ktxTexture2_CompressAstcEx(ktxTexture2* This, ktxAstcParams* params);
 KTX_API KTX_error_code KTX_APIENTRY
 ktxTexture2_CompressAstc(ktxTexture2* This, ktx_uint32_t quality);
 
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_DecodeBlockCompressed(ktxTexture2* This, ktx_uint32_t threadCount);
+
 /**
  * @memberof ktxTexture2
  * @~English
@@ -1395,6 +1593,261 @@ typedef struct ktxBasisParams {
 KTX_API KTX_error_code KTX_APIENTRY
 ktxTexture2_CompressBasisEx(ktxTexture2* This, ktxBasisParams* params);
 
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_CreateFromBasis(const ktx_uint8_t* bytes, ktx_size_t size,
+                            ktxTexture2** newTex);
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Structure describing one decoded image passed to
+ *        ktxTexture2_CreateFromImages.
+ *
+ * Pixels are tightly packed rows of @c componentCount unsigned normalized
+ * components of @c componentSize bytes each, first row at the top.
+ */
+typedef struct ktxSourceImage {
+    const ktx_uint8_t* pData;
+        /*!< Pointer to the pixels. */
+    ktx_uint32_t width;
+        /*!< Width of the image in pixels. */
+    ktx_uint32_t height;
+        /*!< Height of the image in pixels. */
+    ktx_uint32_t componentCount;
+        /*!< Number of components per pixel, 1 to 4. */
+    ktx_uint32_t componentSize;
+        /*!< Size of each component in bytes, 1 or 2. */
+    ktx_uint32_t oetf;
+        /*!< Transfer function of the pixels, KHR_DF_TRANSFER_SRGB or
+             KHR_DF_TRANSFER_LINEAR.
+         */
+    ktx_uint32_t primaries;
+        /*!< Color primaries of the pixels, one of the KHR_DF_PRIMARIES
+             values. All images must have the same primaries.
+         */
+    ktx_uint32_t level;
+        /*!< Mip level the image is for. */
+    ktx_uint32_t layer;
+        /*!< Array layer the image is for. */
+    ktx_uint32_t faceSlice;
+        /*!< Cube map face or, for 3D textures, depth slice the image is
+             for.
+         */
+} ktxSourceImage;
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Options for the handling of the edges of images when generating
+ *        mip levels with ktxTexture2_CreateFromImages.
+ */
+typedef enum ktx_image_wrap_mode_e {
+    KTX_IMAGE_WRAP_CLAMP = 0,
+        /*!< Clamp to the edge texels. */
+    KTX_IMAGE_WRAP_REPEAT = 1,
+        /*!< Wrap around to the opposite edge. */
+    KTX_IMAGE_WRAP_REFLECT = 2,
+        /*!< Reflect at the edge. */
+} ktx_image_wrap_mode_e;
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Structure for passing parameters to ktxTexture2_CreateFromImages.
+ *
+ * Passing a struct initialized to 0, apart from @c structSize, creates a
+ * single layer 2D texture holding exactly the images given with no
+ * processing other than copying.
+ */
+typedef struct ktxImageParams {
+    ktx_uint32_t structSize;
+        /*!< Size of this struct. Used so library can tell which version
+             of struct is being passed.
+         */
+    ktx_uint32_t threadCount;
+        /*!< Maximum number of threads used to process images. 0 means use
+             as many as the hardware supports.
+         */
+    ktx_uint32_t numLevels;
+        /*!< Number of mip levels in the texture. 0 means a full pyramid
+             when @c generateMipmaps is set and otherwise the number of
+             levels for which images are given.
+         */
+    ktx_uint32_t numLayers;
+        /*!< Number of array layers. 0 is treated as 1. */
+    ktx_bool_t isArray;
+        /*!< Set if the texture is an array texture. */
+    ktx_bool_t cubemap;
+        /*!< Set if the images are the 6 faces of a cube map. */
+    ktx_uint32_t baseDepth;
+        /*!< Depth of a 3D texture. 0 means the texture is not 3D. */
+    ktx_bool_t generateMipmaps;
+        /*!< Generate levels 1 and up from the level 0 images. Only level 0
+             images may be given.
+         */
+    ktx_uint32_t resizeWidth;
+        /*!< If non-zero, resize the images to this width. Only level 0
+             images may be given.
+         */
+    ktx_uint32_t resizeHeight;
+        /*!< If non-zero, resize the images to this height. */
+    ktx_uint32_t convertOetf;
+        /*!< If not KHR_DF_TRANSFER_UNSPECIFIED, convert the images to this
+             transfer function, KHR_DF_TRANSFER_SRGB or
+             KHR_DF_TRANSFER_LINEAR.
+         */
+    ktx_uint32_t targetComponentCount;
+        /*!< If non-zero, the number of components in the texture. Missing
+             components are filled with 0 or, for alpha, 1.
+         */
+    char inputSwizzle[4];
+        /*!< A swizzle to apply to the images. It must match the regular
+             expression /^[rgba01]{4}$/ or be all 0 for no swizzle. Selecting
+             a component the images do not have gives their last component.
+         */
+    ktx_bool_t lowerLeftMapsToS0T0;
+        /*!< Flip the images vertically so the first row is at the bottom.
+             The KTXorientation metadata is set to match.
+         */
+    ktx_bool_t normalize;
+        /*!< Normalize the images, and generated mip levels, as normal
+             maps.
+         */
+    const char* mipFilter;
+        /*!< Name of the filter used for resizing and generating mip levels.
+             NULL means "lanczos4".
+         */
+    float mipFilterScale;
+        /*!< Scale of the filter. 0 means 1.0. */
+    ktx_uint32_t mipWrapMode;
+        /*!< How the edges are handled when generating mip levels, one of
+             the ktx_image_wrap_mode_e values.
+         */
+} ktxImageParams;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_CreateFromImages(const ktxSourceImage* images,
+                             ktx_uint32_t numImages,
+                             const ktxImageParams* params,
+                             ktxTexture2** newTex);
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Structure for passing parameters to
+ *        ktxTexture2_CreateCubemapFromEquirect.
+ *
+ * Passing a struct initialized to 0, apart from @c structSize, creates a
+ * VK_FORMAT_R16G16B16A16_SFLOAT cube map with a full chain of GGX
+ * prefiltered mip levels.
+ */
+typedef struct ktxCubemapParams {
+    ktx_uint32_t structSize;
+        /*!< Size of this struct. Used so library can tell which version
+             of struct is being passed.
+         */
+    ktx_uint32_t threadCount;
+        /*!< Maximum number of threads used. 0 means use as many as the
+             hardware supports.
+         */
+    ktx_uint32_t faceSize;
+        /*!< Width and height of the cube faces. 0 means a quarter of the
+             width of the panorama.
+         */
+    ktx_uint32_t numLevels;
+        /*!< Number of mip levels. 0 means a full pyramid. */
+    ktx_uint32_t vkFormat;
+        /*!< Format of the texture, VK_FORMAT_R16G16B16A16_SFLOAT or
+             VK_FORMAT_R32G32B32A32_SFLOAT. 0 means the former.
+         */
+    ktx_bool_t boxFilterMips;
+        /*!< Generate levels 1 and up with a box filter instead of
+             prefiltering them for specular image based lighting.
+         */
+    ktx_uint32_t sampleCount;
+        /*!< Number of GGX samples per texel when prefiltering. 0 means
+             512.
+         */
+} ktxCubemapParams;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_CreateCubemapFromEquirect(const float* pixels,
+                                      ktx_uint32_t width,
+                                      ktx_uint32_t height,
+                                      ktx_uint32_t componentCount,
+                                      const ktxCubemapParams* params,
+                                      ktxTexture2** newTex);
+
+/**
+ * @~English
+ * @brief Filters used by a ktxTextureSampler within and between levels.
+ */
+typedef enum ktxSamplerFilter {
+    KTX_SAMPLER_FILTER_NEAREST = 0,
+        /*!< Use the nearest texel or level. */
+    KTX_SAMPLER_FILTER_LINEAR = 1
+        /*!< Blend the 2x2 nearest texels or the 2 nearest levels. */
+} ktxSamplerFilter;
+
+/**
+ * @~English
+ * @brief How a ktxTextureSampler handles coordinates outside [0, 1].
+ */
+typedef enum ktxSamplerAddressMode {
+    KTX_SAMPLER_ADDRESS_REPEAT = 0,
+        /*!< Tile the image. */
+    KTX_SAMPLER_ADDRESS_MIRRORED_REPEAT = 1,
+        /*!< Tile the image, mirroring every other tile. */
+    KTX_SAMPLER_ADDRESS_CLAMP_TO_EDGE = 2
+        /*!< Repeat the edge texels. */
+} ktxSamplerAddressMode;
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Structure for passing parameters to ktxTexture2_CreateSampler.
+ *
+ * Passing a struct initialized to 0, apart from @c structSize, creates a
+ * point sampler that repeats the images. Set @c filter to
+ * @c KTX_SAMPLER_FILTER_LINEAR for bilinear sampling and also
+ * @c mipmapFilter for trilinear sampling.
+ */
+typedef struct ktxSamplerParams {
+    ktx_uint32_t structSize;
+        /*!< Size of this struct. Used so library can tell which version
+             of struct is being passed.
+         */
+    ktxSamplerFilter filter;
+        /*!< Filter used within a level. */
+    ktxSamplerFilter mipmapFilter;
+        /*!< Filter used between levels. */
+    ktxSamplerAddressMode addressModeU;
+        /*!< Handling of s coordinates outside [0, 1]. */
+    ktxSamplerAddressMode addressModeV;
+        /*!< Handling of t coordinates outside [0, 1]. */
+    ktx_uint32_t cacheBlocks;
+        /*!< Number of decoded blocks the sampler keeps. 0 means 64.
+             Values above 2^20 are clamped to 2^20. */
+} ktxSamplerParams;
+
+/**
+ * @~English
+ * @brief Opaque handle of a sampler made by ktxTexture2_CreateSampler.
+ */
+typedef struct ktxTextureSampler ktxTextureSampler;
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_CreateSampler(ktxTexture2* This, const ktxSamplerParams* params,
+                          ktxTextureSampler** newSampler);
+
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTextureSampler_Sample(ktxTextureSampler* This, ktx_uint32_t layer,
+                         ktx_uint32_t face, float s, float t, float lod,
+                         float rgba[4]);
+
+KTX_API void KTX_APIENTRY
+ktxTextureSampler_Destroy(ktxTextureSampler* This);
+
 /**
  * @~English
  * @brief Enumerators for specifying the transcode target format.
@@ -1557,6 +2010,23 @@ typedef enum ktx_transcode_flag_bits_e {
         /*!< Request higher quality transcode of UASTC to BC1, BC3, ETC2_EAC_R11 and
              ETC2_EAC_RG11. The flag is unused by other UASTC transcoders.
          */
+    KTX_TF_TRANSCODE_IN_PLACE = 0x10000,
+        /*!< Transcode UASTC into the texture's existing image data instead
+             of a new allocation when the target's blocks are no larger than
+             UASTC's, i.e. ETC1, ETC2, EAC, BC1, BC3, BC4, BC5, BC7 and
+             ASTC 4x4. Peak memory use is halved. The allocation is shrunk
+             afterwards for the 8 byte block targets. If transcoding fails
+             the image data is left partially transcoded. Ignored for other
+             targets and for ETC1S.
+         */
+    KTX_TF_MULTITHREAD = 0x20000,
+        /*!< Transcode using a thread per hardware thread. UASTC images are
+             split into bands of block rows, except for PVRTC1 targets which
+             need whole images. ETC1S images are transcoded in parallel a
+             whole image at a time, as BasisLZ decoding of an image is
+             sequential, and not at all for video. Ignored when transcoding
+             in place.
+         */
 } ktx_transcode_flag_bits_e;
 typedef ktx_uint32_t ktx_transcode_flags;
 
@@ -61,6 +61,10 @@ extern "C" {
  *
  * @c vkGetInstanceProcAddr and @c vkGetDeviceProcAddr should be set, others
  * are optional.
+ *
+ * Commands of optional extensions and features, such as
+ * VK_EXT_host_image_copy and sparse binding, are not members. They are
+ * retrieved with @c vkGetDeviceProcAddr when needed.
  */
 typedef struct ktxVulkanFunctions {
     // These are functions pointers we need to perform our vulkan duties.
@@ -132,6 +136,62 @@ KTX_API void KTX_APIENTRY
 ktxVulkanTexture_Destruct(ktxVulkanTexture* This, VkDevice device,
                           const VkAllocationCallbacks* pAllocator);
 
+/**
+ * @class ktxVulkanSparseTexture
+ * @~English
+ * @brief Struct for returning information about a sparse resident Vulkan
+ *        texture image created by ktxTexture_VkUploadSparse.
+ *
+ * Levels smaller than the sparse block size are packed into the mip tail,
+ * which is always resident. The larger levels are divided into tiles of
+ * @c tileExtent texels which are made resident, or not, with
+ * ktxVulkanSparseTexture_PageIn and ktxVulkanSparseTexture_PageOut.
+ *
+ * Creation of these objects is internal to ktxTexture_VkUploadSparse.
+ */
+typedef struct ktxVulkanSparseTexture
+{
+    ktxVulkanTexture vkTexture; /*!< Information about the image. Its
+                                     @c deviceMemory is the memory bound
+                                     to the mip tail. */
+    VkExtent3D tileExtent; /*!< Size of a tile in texels. */
+    uint32_t mipTailFirstLod; /*!< First level in the mip tail. Equal to
+                                   @c vkTexture.levelCount if there is no
+                                   mip tail. */
+    VkDeviceSize pageSize; /*!< Size of the memory bound to each tile. */
+    uint32_t memoryTypeIndex; /*!< Memory type used for the tiles. */
+    uint32_t numTiles; /*!< Total number of tiles outside the mip tail. */
+    uint32_t pagesPerBlock; /*!< Number of @c pageSize pages in each block
+                                 of device memory allocated for tiles. */
+    uint32_t numBlocks; /*!< Number of blocks allocated so far. */
+    VkDeviceMemory* pBlockMemory; /*!< The blocks from which tile pages are
+                                       taken. Managed by the
+                                       ktxVulkanSparseTexture functions. */
+    uint32_t* pTilePage; /*!< One more than the page, numbered across the
+                              blocks, bound to each tile or 0 if the tile
+                              is not resident. Managed by the
+                              ktxVulkanSparseTexture functions. */
+    uint32_t* pFreePages; /*!< Stack of allocated pages not bound to any
+                               tile. Managed by the ktxVulkanSparseTexture
+                               functions. */
+    uint32_t numFreePages; /*!< Number of pages in @c pFreePages. */
+} ktxVulkanSparseTexture;
+
+/**
+ * @~English
+ * @brief A tile of a ktxVulkanSparseTexture.
+ *
+ * @c x, @c y and @c z are in units of the texture's @c tileExtent.
+ */
+typedef struct ktxVulkanSparseTile {
+    uint32_t level;      /*!< Mip level of the tile. */
+    uint32_t arrayLayer; /*!< Vulkan array layer of the tile,
+                              i.e. layer * numFaces + face. */
+    uint32_t x;          /*!< Tile column. */
+    uint32_t y;          /*!< Tile row. */
+    uint32_t z;          /*!< Tile depth slice. */
+} ktxVulkanSparseTile;
+
 
 
 
@@ -180,6 +240,29 @@ typedef struct ktxVulkanDeviceInfo {
 } ktxVulkanDeviceInfo;
 
 
+/**
+ * @~English
+ * @brief Flags for the ktxTexture_VkUploadEx_WithFlags functions.
+ */
+typedef enum ktxVulkanUploadFlagBits {
+    KTX_VK_UPLOAD_CONVERT_FORMAT_BIT = 0x00000001,
+        /*!< If the device does not support the texture's format, upload to
+             the nearest supported format, converting the texels during
+             the copy. Only lossless conversions are made. */
+    KTX_VK_UPLOAD_CONVERT_FORMAT_LOSSY_BIT = 0x00000002,
+        /*!< With @c KTX_VK_UPLOAD_CONVERT_FORMAT_BIT, also allow narrowing
+             32- and 64-bit float formats to smaller float formats. */
+    KTX_VK_UPLOAD_KAISER_MIPMAPS_BIT = 0x00000004,
+        /*!< When mipmaps have to be generated on the CPU because the device
+             cannot blit the texture's format, filter them with a Kaiser
+             windowed sinc instead of a box filter. Sharper, but slower. */
+    KTX_VK_UPLOAD_HOST_IMAGE_COPY_BIT = 0x00000008
+        /*!< Load optimally tiled images with VK_EXT_host_image_copy when
+             possible. Only set this if the application enabled both the
+             extension and its @c hostImageCopy feature on the device. */
+} ktxVulkanUploadFlagBits;
+typedef ktx_uint32_t ktxVulkanUploadFlags;
+
 KTX_API ktxVulkanDeviceInfo* KTX_APIENTRY
 ktxVulkanDeviceInfo_CreateEx(VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice device,
                            VkQueue queue, VkCommandPool cmdPool,
@@ -216,6 +299,13 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
                       VkImageUsageFlags usageFlags,
                       VkImageLayout finalLayout);
 KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture_VkUploadEx_WithFlags(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
+                                ktxVulkanTexture* vkTexture,
+                                VkImageTiling tiling,
+                                VkImageUsageFlags usageFlags,
+                                VkImageLayout finalLayout,
+                                ktxVulkanUploadFlags uploadFlags);
+KTX_API KTX_error_code KTX_APIENTRY
 ktxTexture_VkUpload(ktxTexture* texture, ktxVulkanDeviceInfo* vdi,
                     ktxVulkanTexture *vkTexture);
 KTX_API KTX_error_code KTX_APIENTRY
@@ -225,6 +315,13 @@ ktxTexture1_VkUploadEx(ktxTexture1* This, ktxVulkanDeviceInfo* vdi,
                        VkImageUsageFlags usageFlags,
                        VkImageLayout finalLayout);
 KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture1_VkUploadEx_WithFlags(ktxTexture1* This, ktxVulkanDeviceInfo* vdi,
+                                 ktxVulkanTexture* vkTexture,
+                                 VkImageTiling tiling,
+                                 VkImageUsageFlags usageFlags,
+                                 VkImageLayout finalLayout,
+                                 ktxVulkanUploadFlags uploadFlags);
+KTX_API KTX_error_code KTX_APIENTRY
 ktxTexture1_VkUpload(ktxTexture1* texture, ktxVulkanDeviceInfo* vdi,
                     ktxVulkanTexture *vkTexture);
 KTX_API KTX_error_code KTX_APIENTRY
@@ -234,9 +331,36 @@ ktxTexture2_VkUploadEx(ktxTexture2* This, ktxVulkanDeviceInfo* vdi,
                        VkImageUsageFlags usageFlags,
                        VkImageLayout finalLayout);
 KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture2_VkUploadEx_WithFlags(ktxTexture2* This, ktxVulkanDeviceInfo* vdi,
+                                 ktxVulkanTexture* vkTexture,
+                                 VkImageTiling tiling,
+                                 VkImageUsageFlags usageFlags,
+                                 VkImageLayout finalLayout,
+                                 ktxVulkanUploadFlags uploadFlags);
+KTX_API KTX_error_code KTX_APIENTRY
 ktxTexture2_VkUpload(ktxTexture2* texture, ktxVulkanDeviceInfo* vdi,
                      ktxVulkanTexture *vkTexture);
 
+KTX_API KTX_error_code KTX_APIENTRY
+ktxTexture_VkUploadSparse(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
+                          ktxVulkanSparseTexture* sparseTexture,
+                          VkImageUsageFlags usageFlags,
+                          VkImageLayout finalLayout);
+KTX_API void KTX_APIENTRY
+ktxVulkanSparseTexture_GetTileCount(const ktxVulkanSparseTexture* This,
+                                    uint32_t level, VkExtent3D* pTileCount);
+KTX_API KTX_error_code KTX_APIENTRY
+ktxVulkanSparseTexture_PageIn(ktxVulkanSparseTexture* This, ktxTexture* texture,
+                              ktxVulkanDeviceInfo* vdi, uint32_t numTiles,
+                              const ktxVulkanSparseTile* pTiles);
+KTX_API KTX_error_code KTX_APIENTRY
+ktxVulkanSparseTexture_PageOut(ktxVulkanSparseTexture* This,
+                               ktxVulkanDeviceInfo* vdi, uint32_t numTiles,
+                               const ktxVulkanSparseTile* pTiles);
+KTX_API void KTX_APIENTRY
+ktxVulkanSparseTexture_Destruct(ktxVulkanSparseTexture* This, VkDevice device,
+                                const VkAllocationCallbacks* pAllocator);
+
 KTX_API VkFormat KTX_APIENTRY
 ktxTexture_GetVkFormat(ktxTexture* This);
 
@@ -737,7 +737,7 @@ ktxTexture2_CompressAstcEx(ktxTexture2* This, ktxAstcParams* params) {
     free(This->pDfd);
     This->pDfd = prototype->pDfd;
     prototype->pDfd = 0;
-    free(This->pData);
+    ktxTexture2_freeData(This);
     This->pData = prototype->pData;
     This->dataSize = prototype->dataSize;
     prototype->pData = 0;
@@ -18,7 +18,10 @@
  * @author Mark Callow, www.edgewise-consulting.com
  */
 
+#include <algorithm>
 #include <inttypes.h>
+#include <mutex>
+#include <new>
 #include <stdlib.h>
 #include <zstd.h>
 #include <KHR/khr_df.h>
@@ -246,7 +249,7 @@ ktxTexture2_rewriteDfd4BasisLzETC1S(ktxTexture2* This,
                        + newSampleCount * KHR_DF_WORD_SAMPLEWORDS;
     ndbSize *= sizeof(uint32_t);
     uint32_t ndfdSize = ndbSize + 1 * sizeof(uint32_t);
-    uint32_t* ndfd = (uint32_t *)malloc(ndfdSize);
+    uint32_t* ndfd = (uint32_t *)calloc(1, ndfdSize);
     uint32_t* nbdb = ndfd + 1;
 
     if (!ndfd)
@@ -315,7 +318,7 @@ ktxTexture2_rewriteDfd4Uastc(ktxTexture2* This,
                        + 1 * KHR_DF_WORD_SAMPLEWORDS;
     ndbSize *= sizeof(uint32_t);
     uint32_t ndfdSize = ndbSize + 1 * sizeof(uint32_t);
-    uint32_t* ndfd = (uint32_t *)malloc(ndfdSize);
+    uint32_t* ndfd = (uint32_t *)calloc(1, ndfdSize);
     uint32_t* nbdb = ndfd + 1;
 
     if (!ndfd)
@@ -363,7 +366,203 @@ ktxTexture2_rewriteDfd4Uastc(ktxTexture2* This,
     return KTX_SUCCESS;
 }
 
-static bool basisuEncoderInitialized = false;
+// The level index, supercompression global data and image data made from the
+// slices of a .basis file. They are built before This is modified so that a
+// failed allocation leaves This unchanged. Buffers not given to a texture by
+// ktxTexture2_installBasisSlices are freed on destruction.
+struct basisSlices {
+    std::vector<ktxLevelIndexEntry> levelIndex;
+    ktx_uint32_t requiredLevelAlignment = 1;
+    uint8_t* bgd = nullptr;
+    size_t bgdSize = 0;
+    uint8_t* data = nullptr;
+    ktx_size_t dataSize = 0;
+
+    basisSlices() = default;
+    basisSlices(const basisSlices&) = delete;
+    basisSlices& operator=(const basisSlices&) = delete;
+    ~basisSlices() {
+        delete[] bgd;
+        free(data);
+    }
+};
+
+// Copy the slices of the .basis file @p bf to @p out, creating a level index
+// for This and, for ETC1S, its supercompression global data, which includes
+// the codebooks and tables. @p rgbSlices gives, in KTX image order, i.e. by
+// level then layer, face and z slice, the index in the basis slice
+// descriptions of the slice holding each image. Each image's alpha slice, if
+// the file is ETC1S with alpha, immediately follows its RGB slice. This is
+// only read.
+//
+// 3 things to remember about offsets:
+//    1. levelIndex offsets are relative to This->pData;
+//    2. In the ktx image descriptors, slice offsets are relative to the
+//       start of the mip level;
+//    3. basis_slice_desc offsets are relative to the start of the file.
+static KTX_error_code
+ktxTexture2_copyBasisSlices(const ktxTexture2* This, const uint8_t* bf,
+                            const std::vector<uint32_t>& rgbSlices,
+                            basisSlices& out)
+{
+    const basis_file_header& bfh =
+                            *reinterpret_cast<const basis_file_header*>(bf);
+    const basis_slice_desc* slices =
+                            reinterpret_cast<const basis_slice_desc*>(
+                                &bf[bfh.m_slice_desc_file_ofs]);
+    bool uastc = bfh.m_tex_format == (int)basis_tex_format::cUASTC4x4;
+    bool alphaSlices = !uastc
+                       && (bfh.m_flags & cBASISHeaderFlagHasAlphaSlices);
+    uint32_t num_images = (uint32_t)rgbSlices.size();
+    ktxBasisLzEtc1sImageDesc* kimages = nullptr;
+
+    out.levelIndex.resize(This->numLevels);
+    out.requiredLevelAlignment = uastc ? 4 * 4 : 1;
+
+    if (!uastc) {
+        //
+        // Allocate supercompression global data and write its header.
+        //
+        out.bgdSize = sizeof(ktxBasisLzGlobalHeader)
+                    + sizeof(ktxBasisLzEtc1sImageDesc) * num_images
+                    + bfh.m_endpoint_cb_file_size
+                    + bfh.m_selector_cb_file_size
+                    + bfh.m_tables_file_size;
+        out.bgd = new (std::nothrow) ktx_uint8_t[out.bgdSize];
+        if (!out.bgd)
+            return KTX_OUT_OF_MEMORY;
+        ktxBasisLzGlobalHeader& bgdh =
+                            *reinterpret_cast<ktxBasisLzGlobalHeader*>(out.bgd);
+        bgdh.endpointCount = (uint16_t)bfh.m_total_endpoints;
+        bgdh.endpointsByteLength = bfh.m_endpoint_cb_file_size;
+        bgdh.selectorCount = (uint16_t)bfh.m_total_selectors;
+        bgdh.selectorsByteLength = bfh.m_selector_cb_file_size;
+        bgdh.tablesByteLength = bfh.m_tables_file_size;
+        bgdh.extendedByteLength = 0;
+        kimages = BGD_ETC1S_IMAGE_DESCS(out.bgd);
+
+        //
+        // Copy the global code books & huffman tables to global data.
+        //
+        uint8_t* dstptr = reinterpret_cast<uint8_t*>(&kimages[num_images]);
+        // Copy the endpoints ...
+        memcpy(dstptr,
+               &bf[bfh.m_endpoint_cb_file_ofs],
+               bfh.m_endpoint_cb_file_size);
+        dstptr += bgdh.endpointsByteLength;
+        // selectors ...
+        memcpy(dstptr,
+               &bf[bfh.m_selector_cb_file_ofs],
+               bfh.m_selector_cb_file_size);
+        dstptr += bgdh.selectorsByteLength;
+        // and the huffman tables.
+        memcpy(dstptr,
+               &bf[bfh.m_tables_file_ofs],
+               bfh.m_tables_file_size);
+
+        assert((size_t)(dstptr + bgdh.tablesByteLength - out.bgd)
+               <= out.bgdSize);
+    }
+
+    //
+    // Work out the level byte lengths and write the index of slice
+    // descriptions to the global data.
+    //
+    std::vector<uint32_t> levelFirstImage(This->numLevels);
+    uint32_t image = 0;
+    for (uint32_t level = 0; level < This->numLevels; level++) {
+        uint32_t depth = MAX(1, This->baseDepth >> level);
+        uint32_t levelImageCount = This->numLayers * This->numFaces * depth;
+        uint32_t level_byte_length = 0;
+
+        levelFirstImage[level] = image;
+        for (uint32_t i = 0; i < levelImageCount; i++, image++) {
+            const basis_slice_desc& rgb = slices[rgbSlices[image]];
+            if (kimages) {
+                kimages[image].rgbSliceByteOffset = level_byte_length;
+                kimages[image].rgbSliceByteLength = rgb.m_file_size;
+            }
+            level_byte_length += rgb.m_file_size;
+            if (alphaSlices) {
+                const basis_slice_desc& alpha = slices[rgbSlices[image] + 1];
+                kimages[image].alphaSliceByteOffset = level_byte_length;
+                kimages[image].alphaSliceByteLength = alpha.m_file_size;
+                level_byte_length += alpha.m_file_size;
+            } else if (kimages) {
+                kimages[image].alphaSliceByteOffset = 0;
+                kimages[image].alphaSliceByteLength = 0;
+            }
+            if (kimages) {
+                // Set the PFrame flag, inverse of the .basis IFrame flag.
+                if (This->isVideo) {
+                    // Extract FrameIsIFrame
+                    kimages[image].imageFlags =
+                                    (rgb.m_flags & ~cSliceDescFlagsHasAlpha);
+                    // Set our flag to the inverse.
+                    kimages[image].imageFlags ^= cSliceDescFlagsFrameIsIFrame;
+                } else {
+                    kimages[image].imageFlags = 0;
+                }
+            }
+        }
+        out.levelIndex[level].byteLength = level_byte_length;
+        out.levelIndex[level].uncompressedByteLength =
+                                                uastc ? level_byte_length : 0;
+        out.dataSize += _KTX_PADN(out.requiredLevelAlignment,
+                                  level_byte_length);
+    }
+    assert(image == num_images);
+
+    out.data = (uint8_t*) malloc(out.dataSize);
+    if (!out.data)
+        return KTX_OUT_OF_MEMORY;
+
+    //
+    // Copy in the compressed image data, smallest level first.
+    //
+    uint64_t level_offset = 0;
+    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
+        uint32_t levelEnd = level + 1 < (int32_t)This->numLevels
+                            ? levelFirstImage[level + 1] : num_images;
+        uint8_t* dst = out.data + level_offset;
+
+        out.levelIndex[level].byteOffset = level_offset;
+        for (image = levelFirstImage[level]; image < levelEnd; image++) {
+            uint32_t s = rgbSlices[image];
+            for (uint32_t n = 0; n < (alphaSlices ? 2u : 1u); n++, s++) {
+                memcpy(dst, &bf[slices[s].m_file_ofs], slices[s].m_file_size);
+                dst += slices[s].m_file_size;
+            }
+        }
+        level_offset += _KTX_PADN(out.requiredLevelAlignment,
+                                  out.levelIndex[level].byteLength);
+    }
+    return KTX_SUCCESS;
+}
+
+// Give the level index and buffers of @p slices to This. Cannot fail. This
+// must have no image data or supercompression global data.
+static void
+ktxTexture2_installBasisSlices(ktxTexture2* This, basisSlices& slices)
+{
+    ktxTexture2_private& priv = *This->_private;
+
+    assert(This->pData == NULL && priv._supercompressionGlobalData == NULL);
+    std::copy(slices.levelIndex.begin(), slices.levelIndex.end(),
+              priv._levelIndex);
+    priv._requiredLevelAlignment = slices.requiredLevelAlignment;
+    if (slices.bgd) {
+        priv._supercompressionGlobalData = slices.bgd;
+        priv._sgdByteLength = slices.bgdSize;
+        slices.bgd = nullptr;
+    }
+    This->pData = slices.data;
+    This->dataSize = slices.dataSize;
+    slices.data = nullptr;
+}
+
+// Encodes may run concurrently on different textures.
+static std::once_flag basisuEncoderInitialized;
 
 /**
  * @memberof ktxTexture2
@@ -444,15 +643,14 @@ ktxTexture2_CompressBasisEx(ktxTexture2* This, ktxBasisParams* params)
             return result;
     }
 
-    if (!basisuEncoderInitialized) {
+    std::call_once(basisuEncoderInitialized, []() {
         // force_serialization uses a mutex to serialize when multiple command
         // queues per thread are used. We shouldn't need to worry about this.
         // How to decide whether to use OpenCL?
         basisu_encoder_init((BASISU_SUPPORT_OPENCL ? true : false)/*use_opencl*/
                             /*opencl_force_serialization = false*/);
         //atexit(basisu_encoder_deinit);
-        basisuEncoderInitialized = true;
-    }
+    });
 
     basis_compressor_params cparams;
     cparams.m_read_source_images = false; // Don't read from source files.
@@ -605,8 +803,8 @@ ktxTexture2_CompressBasisEx(ktxTexture2* This, ktxBasisParams* params)
         }
     }
 
-    free(This->pData); // No longer needed. Reduce memory footprint.
-    This->pData = NULL;
+    // No longer needed. Reduce memory footprint.
+    ktxTexture2_freeData(This);
     This->dataSize = 0;
 
     //
@@ -828,154 +1026,19 @@ ktxTexture2_CompressBasisEx(ktxTexture2* This, ktxBasisParams* params)
 
     assert(bfh.m_total_images == num_images);
 
-    uint8_t* bgd = nullptr;
-    size_t bgd_size;
-    uint32_t image_data_size = 0;
-    ktxTexture2_private& priv = *This->_private;
-    uint32_t base_offset = bfh.m_slice_desc_file_ofs;
-    const basis_slice_desc* slice
-            = reinterpret_cast<const basis_slice_desc*>(&bf[base_offset]);
-    std::vector<uint32_t> level_file_offsets(This->numLevels);
-
-    if (params->uastc) {
-        for (uint32_t level = 0; level < This->numLevels; level++) {
-            uint32_t depth = MAX(1, This->baseDepth >> level);
-            uint32_t levelByteLength = 0;
-            uint32_t levelImageCount = This->numLayers * This->numFaces * depth;
-
-            level_file_offsets[level] = slice->m_file_ofs;
-            for (uint32_t image = 0; image < levelImageCount; image++, slice++) {
-                image_data_size += slice->m_file_size;
-                levelByteLength += slice->m_file_size;
-            }
-            priv._levelIndex[level].byteLength = levelByteLength;
-            priv._levelIndex[level].uncompressedByteLength = levelByteLength;
-        }
-    } else {
-        //
-        // Allocate supercompression global data and write its header.
-        //
-        uint32_t image_desc_size = sizeof(ktxBasisLzEtc1sImageDesc);
-
-        bgd_size = sizeof(ktxBasisLzGlobalHeader)
-                 + image_desc_size * num_images
-                 + bfh.m_endpoint_cb_file_size + bfh.m_selector_cb_file_size
-                 + bfh.m_tables_file_size;
-        bgd = new ktx_uint8_t[bgd_size];
-        ktxBasisLzGlobalHeader& bgdh = *reinterpret_cast<ktxBasisLzGlobalHeader*>(bgd);
-        bgdh.endpointCount = (uint16_t)bfh.m_total_endpoints;
-        bgdh.endpointsByteLength = bfh.m_endpoint_cb_file_size;
-        bgdh.selectorCount = (uint16_t)bfh.m_total_selectors;
-        bgdh.selectorsByteLength = bfh.m_selector_cb_file_size;
-        bgdh.tablesByteLength = bfh.m_tables_file_size;
-        bgdh.extendedByteLength = 0;
-
-        //
-        // Write the index of slice descriptions to the global data.
-        //
-
-        ktxBasisLzEtc1sImageDesc* kimages = BGD_ETC1S_IMAGE_DESCS(bgd);
-
-        // 3 things to remember about offsets:
-        //    1. levelIndex offsets at this point are relative to This->pData;
-        //    2. In the ktx image descriptors, slice offsets are relative to the
-        //       start of the mip level;
-        //    3. basis_slice_desc offsets are relative to the end of the basis
-        //       header. Hence base_offset set above is used to rebase offsets
-        //       relative to the start of the slice data.
-
-        // Assumption here is that slices produced by the compressor are in the
-        // same order as we passed them in above, i.e. ordered by mip level.
-        // Note also that slice->m_level_index is always 0, unless the compressor
-        // generated mip levels, so essentially useless. Alpha slices are always
-        // the odd numbered slices.
-        uint32_t image = 0;
-        for (uint32_t level = 0; level < This->numLevels; level++) {
-            uint32_t depth = MAX(1, This->baseDepth >> level);
-            uint32_t level_byte_length = 0;
-
-            assert(!(slice->m_flags & cSliceDescFlagsHasAlpha));
-            level_file_offsets[level] = slice->m_file_ofs;
-            for (uint32_t layer = 0; layer < This->numLayers; layer++) {
-                uint32_t faceSlices = This->numFaces == 1 ? depth
-                                                          : This->numFaces;
-                for (uint32_t faceSlice = 0; faceSlice < faceSlices; faceSlice++) {
-                    level_byte_length += slice->m_file_size;
-                    kimages[image].rgbSliceByteOffset = slice->m_file_ofs
-                                                   - level_file_offsets[level];
-                    kimages[image].rgbSliceByteLength = slice->m_file_size;
-                    if (bfh.m_flags & cBASISHeaderFlagHasAlphaSlices) {
-                        slice++;
-                        level_byte_length += slice->m_file_size;
-                        kimages[image].alphaSliceByteOffset =
-                                slice->m_file_ofs - level_file_offsets[level];
-                        kimages[image].alphaSliceByteLength =
-                                slice->m_file_size;
-                    } else {
-                        kimages[image].alphaSliceByteOffset = 0;
-                        kimages[image].alphaSliceByteLength = 0;
-                    }
-                    // Set the PFrame flag, inverse of the .basis IFrame flag.
-                    if (This->isVideo) {
-                        // Extract FrameIsIFrame
-                        kimages[image].imageFlags =
-                                    (slice->m_flags & ~cSliceDescFlagsHasAlpha);
-                        // Set our flag to the inverse.
-                        kimages[image].imageFlags ^=
-                                    cSliceDescFlagsFrameIsIFrame;
-                    } else {
-                        kimages[image].imageFlags = 0;
-                    }
-                    slice++;
-                    image++;
-                }
-            }
-            priv._levelIndex[level].byteLength = level_byte_length;
-            priv._levelIndex[level].uncompressedByteLength = 0;
-            image_data_size += level_byte_length;
-        }
-
-        //
-        // Copy the global code books & huffman tables to global data.
-        //
-
-        // Slightly sleazy but as image is now the last valid index in the
-        // slice description array plus 1, &kimages[image] points at the first
-        // byte where the endpoints, etc. must be written.
-        uint8_t* dstptr = reinterpret_cast<uint8_t*>(&kimages[image]);
-        // Copy the endpoints ...
-        memcpy(dstptr,
-               &bf[bfh.m_endpoint_cb_file_ofs],
-               bfh.m_endpoint_cb_file_size);
-        dstptr += bgdh.endpointsByteLength;
-        // selectors ...
-        memcpy(dstptr,
-               &bf[bfh.m_selector_cb_file_ofs],
-               bfh.m_selector_cb_file_size);
-        dstptr += bgdh.selectorsByteLength;
-        // and the huffman tables.
-        memcpy(dstptr,
-               &bf[bfh.m_tables_file_ofs],
-               bfh.m_tables_file_size);
-
-        assert((size_t)(dstptr + bgdh.tablesByteLength - bgd) <= bgd_size);
-
-        //
-        // We have a complete global data package.
-        //
-
-        priv._supercompressionGlobalData = bgd;
-        priv._sgdByteLength = bgd_size;
-    }
+    // Slices produced by the compressor are in the same order as we passed
+    // the images in above, i.e. ordered by mip level. Note that
+    // slice->m_level_index is always 0, unless the compressor generated mip
+    // levels, so essentially useless. ETC1S alpha slices are always the odd
+    // numbered slices.
+    std::vector<uint32_t> rgbSlices(num_images);
+    uint32_t sliceStride = !params->uastc
+                           && (bfh.m_flags & cBASISHeaderFlagHasAlphaSlices)
+                           ? 2 : 1;
+    for (uint32_t image = 0; image < num_images; image++)
+        rgbSlices[image] = image * sliceStride;
 
-    //
-    // Update This texture and copy compressed image data to it.
-    //
-
-    // Declare here so can use goto cleanup.
-    uint8_t* new_data = 0;
     ktxFormatSize& formatSize = This->_protected->_formatSize;
-    uint64_t level_offset = 0;
 
     // Since we've left m_check_for_alpha set and m_force_alpha unset in
     // the compressor parameters, the basis encoder will have removed an input
@@ -987,68 +1050,37 @@ ktxTexture2_CompressBasisEx(ktxTexture2* This, ktxBasisParams* params)
         alphaContent = eNone;
     }
 
-    new_data = (uint8_t*) malloc(image_data_size);
-    if (!new_data) {
-        result = KTX_OUT_OF_MEMORY;
-        goto cleanup;
-    }
+    basisSlices newSlices;
+    result = ktxTexture2_copyBasisSlices(This, bf.data(), rgbSlices,
+                                         newSlices);
+    if (result != KTX_SUCCESS) return result;
 
     // Delayed modifying texture until here so it's after points of
-    // possible failure.
+    // possible failure. The DFD rewrites only replace This->pDfd once their
+    // allocation has succeeded.
     if (params->uastc) {
         result = ktxTexture2_rewriteDfd4Uastc(This, alphaContent,
                                               isLuminance,
                                               comp_mapping);
-        if (result != KTX_SUCCESS) goto cleanup;
-
-        // Reflect this in the formatSize
-        ktxFormatSize_initFromDfd(&formatSize, This->pDfd);
-        // and the requiredLevelAlignment.
-        priv._requiredLevelAlignment = 4 * 4;
+        if (result != KTX_SUCCESS) return result;
     } else {
         result = ktxTexture2_rewriteDfd4BasisLzETC1S(This, alphaContent,
                                                      isLuminance,
                                                      comp_mapping);
-        if (result != KTX_SUCCESS) goto cleanup;
+        if (result != KTX_SUCCESS) return result;
 
         This->supercompressionScheme = KTX_SS_BASIS_LZ;
-        // Reflect this in the formatSize
-        ktxFormatSize_initFromDfd(&formatSize, This->pDfd);
-        // and the requiredLevelAlignment.
-        priv._requiredLevelAlignment = 1;
     }
+    // Reflect this in the formatSize.
+    ktxFormatSize_initFromDfd(&formatSize, This->pDfd);
     This->vkFormat = VK_FORMAT_UNDEFINED;
     This->isCompressed = KTX_TRUE;
 
     // Block-compressed textures never need byte swapping so typeSize is 1.
     assert(This->_protected->_typeSize == 1);
 
-    // Copy in the compressed image data.
-
-    This->pData = new_data;
-
-    This->dataSize = image_data_size;
-
-    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
-        priv._levelIndex[level].byteOffset = level_offset;
-        // byteLength was set in loop above
-        memcpy(This->pData + level_offset,
-               &bf[level_file_offsets[level]],
-               priv._levelIndex[level].byteLength);
-        level_offset += _KTX_PADN(priv._requiredLevelAlignment,
-                                  priv._levelIndex[level].byteLength);
-    }
-
+    ktxTexture2_installBasisSlices(This, newSlices);
     return KTX_SUCCESS;
-
-cleanup:
-    if (bgd) {
-        delete bgd;
-        priv._supercompressionGlobalData = 0;
-        priv._sgdByteLength = 0;
-    }
-    if (new_data) free(new_data);
-    return result;
 }
 
 extern "C" KTX_API const ktx_uint32_t KTX_ETC1S_DEFAULT_COMPRESSION_LEVEL
@@ -1095,3 +1127,273 @@ ktxTexture2_CompressBasis(ktxTexture2* This, ktx_uint32_t quality)
 
     return ktxTexture2_CompressBasisEx(This, &params);
 }
+
+/**
+ * @memberof ktxTexture2
+ * @ingroup writer
+ * @~English
+ * @brief Create a ktxTexture2 from a .basis file in memory.
+ *
+ * The ETC1S or UASTC slices of the .basis file are repacked into a KTX2
+ * texture without transcoding or re-encoding them, so the result is
+ * bit-for-bit the same data as produced by the Basis Universal encoder.
+ * ETC1S files become BasisLZ supercompressed textures holding the file's
+ * codebooks and Huffman tables in the supercompression global data. UASTC
+ * files become textures with no supercompression to which, for example,
+ * ktxTexture2_DeflateZstd() can then be applied.
+ *
+ * The .basis texture type determines the KTX texture type: 2D images become
+ * an array texture if there is more than one image, cubemap arrays become
+ * cubemaps or cubemap arrays, video frames become an array texture with
+ * KTXanimData metadata and volumes become a 3D texture. KTXorientation
+ * metadata is added to reflect the file's Y flip flag. The image data is
+ * loaded.
+ *
+ * @param[in] bytes pointer to the memory containing the .basis file.
+ * @param[in] size  length of the .basis file in bytes.
+ * @param[in,out] newTex  pointer to a location in which store the address of
+ *                        the newly created texture.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE Either @p bytes or @p newTex is NULL or
+ *                              @p size is 0.
+ * @exception KTX_UNKNOWN_FILE_FORMAT
+ *                              The data is not a .basis file.
+ * @exception KTX_FILE_DATA_ERROR
+ *                              The file is truncated or its header or slice
+ *                              descriptions are inconsistent.
+ * @exception KTX_UNSUPPORTED_FEATURE
+ *                              The file version is not supported, the file
+ *                              uses an external global codebook, its images
+ *                              have differing sizes or numbers of levels, its
+ *                              level sizes do not follow the KTX rule or it is
+ *                              a volume with mip levels.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory to create the texture.
+ */
+extern "C" KTX_error_code
+ktxTexture2_CreateFromBasis(const ktx_uint8_t* bytes, ktx_size_t size,
+                            ktxTexture2** newTex)
+{
+    // The version of the .basis format supported by the transcoder.
+    const uint32_t basisVersion = 0x13;
+    // The number of levels of a texture with 16 bit dimensions, enough
+    // for .basis files.
+    const uint32_t maxLevels = 17;
+
+    if (bytes == NULL || size == 0 || newTex == NULL)
+        return KTX_INVALID_VALUE;
+    *newTex = NULL;
+
+    if (size < sizeof(basis_file_header))
+        return KTX_UNKNOWN_FILE_FORMAT;
+
+    const basis_file_header& bfh =
+                        *reinterpret_cast<const basis_file_header*>(bytes);
+    if (bfh.m_sig != basis_file_header::cBASISSigValue)
+        return KTX_UNKNOWN_FILE_FORMAT;
+    if (bfh.m_ver != basisVersion)
+        return KTX_UNSUPPORTED_FEATURE;
+    if (bfh.m_header_size != sizeof(basis_file_header)
+        || size < sizeof(basis_file_header) + (ktx_size_t)bfh.m_data_size
+        || bfh.m_total_images == 0
+        || bfh.m_total_slices < bfh.m_total_images
+        || bfh.m_slice_desc_file_ofs > size
+        || (size - bfh.m_slice_desc_file_ofs) / sizeof(basis_slice_desc)
+              < bfh.m_total_slices)
+        return KTX_FILE_DATA_ERROR;
+    if (bfh.m_tex_format > (int)basis_tex_format::cUASTC4x4)
+        return KTX_FILE_DATA_ERROR;
+
+    bool uastc = bfh.m_tex_format == (int)basis_tex_format::cUASTC4x4;
+    bool alphaSlices = !uastc
+                       && (bfh.m_flags & cBASISHeaderFlagHasAlphaSlices);
+    if (!uastc) {
+        if (bfh.m_flags & cBASISHeaderFlagUsesGlobalCodebook)
+            return KTX_UNSUPPORTED_FEATURE;
+        if ((ktx_size_t)bfh.m_endpoint_cb_file_ofs
+                + bfh.m_endpoint_cb_file_size > size
+            || (ktx_size_t)bfh.m_selector_cb_file_ofs
+                + bfh.m_selector_cb_file_size > size
+            || (ktx_size_t)bfh.m_tables_file_ofs
+                + bfh.m_tables_file_size > size)
+            return KTX_FILE_DATA_ERROR;
+    }
+
+    //
+    // Find the slice holding each level of each image.
+    //
+    const basis_slice_desc* slices =
+                        reinterpret_cast<const basis_slice_desc*>(
+                            &bytes[bfh.m_slice_desc_file_ofs]);
+    uint32_t numImages = bfh.m_total_images;
+    std::vector<uint32_t> sliceOf(numImages * maxLevels, UINT32_MAX);
+    for (uint32_t s = 0; s < bfh.m_total_slices; s++) {
+        const basis_slice_desc& slice = slices[s];
+        if ((ktx_size_t)slice.m_file_ofs + slice.m_file_size > size
+            || slice.m_image_index >= numImages
+            || slice.m_level_index >= maxLevels)
+            return KTX_FILE_DATA_ERROR;
+        if (alphaSlices && (slice.m_flags & cSliceDescFlagsHasAlpha)) {
+            // Must immediately follow the RGB slice of the same image.
+            if (s == 0
+                || slices[s - 1].m_flags & cSliceDescFlagsHasAlpha
+                || slices[s - 1].m_image_index != slice.m_image_index
+                || slices[s - 1].m_level_index != slice.m_level_index)
+                return KTX_FILE_DATA_ERROR;
+            continue;
+        }
+        if (alphaSlices && (s + 1 == bfh.m_total_slices
+            || !(slices[s + 1].m_flags & cSliceDescFlagsHasAlpha)))
+            return KTX_FILE_DATA_ERROR;
+        uint32_t& entry = sliceOf[slice.m_image_index * maxLevels
+                                  + slice.m_level_index];
+        if (entry != UINT32_MAX)
+            return KTX_FILE_DATA_ERROR;
+        entry = s;
+    }
+
+    uint32_t numLevels = 0;
+    while (numLevels < maxLevels && sliceOf[numLevels] != UINT32_MAX)
+        numLevels++;
+    if (numLevels == 0)
+        return KTX_FILE_DATA_ERROR;
+
+    const basis_slice_desc& base = slices[sliceOf[0]];
+    uint32_t baseWidth = base.m_orig_width;
+    uint32_t baseHeight = base.m_orig_height;
+    if (baseWidth == 0 || baseHeight == 0)
+        return KTX_FILE_DATA_ERROR;
+    for (uint32_t image = 0; image < numImages; image++) {
+        for (uint32_t level = 0; level < maxLevels; level++) {
+            uint32_t s = sliceOf[image * maxLevels + level];
+            if ((s != UINT32_MAX) != (level < numLevels))
+                return KTX_UNSUPPORTED_FEATURE;
+            if (s == UINT32_MAX)
+                continue;
+            if (slices[s].m_orig_width != MAX(1u, baseWidth >> level)
+                || slices[s].m_orig_height != MAX(1u, baseHeight >> level))
+                return KTX_UNSUPPORTED_FEATURE;
+        }
+    }
+
+    //
+    // Map the texture type.
+    //
+    ktxTextureCreateInfo createInfo = {};
+    createInfo.vkFormat = (bfh.m_flags & cBASISHeaderFlagSRGB)
+                          ? VK_FORMAT_R8G8B8A8_SRGB
+                          : VK_FORMAT_R8G8B8A8_UNORM;
+    createInfo.baseWidth = baseWidth;
+    createInfo.baseHeight = baseHeight;
+    createInfo.baseDepth = 1;
+    createInfo.numDimensions = 2;
+    createInfo.numLevels = numLevels;
+    createInfo.numLayers = numImages;
+    createInfo.numFaces = 1;
+    createInfo.isArray = numImages > 1;
+    createInfo.generateMipmaps = KTX_FALSE;
+
+    switch (bfh.m_tex_type) {
+      case cBASISTexType2D:
+        break;
+      case cBASISTexType2DArray:
+      case cBASISTexTypeVideoFrames:
+        createInfo.isArray = KTX_TRUE;
+        break;
+      case cBASISTexTypeCubemapArray:
+        if (numImages % 6 != 0)
+            return KTX_FILE_DATA_ERROR;
+        createInfo.numFaces = 6;
+        createInfo.numLayers = numImages / 6;
+        createInfo.isArray = createInfo.numLayers > 1;
+        break;
+      case cBASISTexTypeVolume:
+        // Each z slice of a .basis volume has its own mip levels.
+        if (numLevels > 1)
+            return KTX_UNSUPPORTED_FEATURE;
+        createInfo.baseDepth = numImages;
+        createInfo.numDimensions = 3;
+        createInfo.numLayers = 1;
+        createInfo.isArray = KTX_FALSE;
+        break;
+      default:
+        return KTX_FILE_DATA_ERROR;
+    }
+
+    // KTX images are ordered by layer then face or z slice, which for all
+    // texture types is the order of the .basis image indices.
+    std::vector<uint32_t> rgbSlices;
+    rgbSlices.reserve(numLevels * numImages);
+    for (uint32_t level = 0; level < numLevels; level++) {
+        for (uint32_t image = 0; image < numImages; image++)
+            rgbSlices.push_back(sliceOf[image * maxLevels + level]);
+    }
+
+    ktxTexture2* This;
+    KTX_error_code result = ktxTexture2_Create(&createInfo,
+                                               KTX_TEXTURE_CREATE_NO_STORAGE,
+                                               &This);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    alpha_content_e alphaContent =
+                        (bfh.m_flags & cBASISHeaderFlagHasAlphaSlices)
+                        ? eAlpha : eNone;
+    if (uastc) {
+        result = ktxTexture2_rewriteDfd4Uastc(This, alphaContent, false,
+                                              nullptr);
+    } else {
+        result = ktxTexture2_rewriteDfd4BasisLzETC1S(This, alphaContent,
+                                                     false, nullptr);
+        This->supercompressionScheme = KTX_SS_BASIS_LZ;
+    }
+    if (result != KTX_SUCCESS)
+        goto cleanup;
+    ktxFormatSize_initFromDfd(&This->_protected->_formatSize, This->pDfd);
+    This->vkFormat = VK_FORMAT_UNDEFINED;
+    This->isCompressed = KTX_TRUE;
+
+    {
+        char orientation[4] = { 'r', 'd', 'i', '\0' };
+        if (bfh.m_flags & cBASISHeaderFlagYFlipped)
+            orientation[1] = 'u';
+        orientation[This->numDimensions] = '\0';
+        This->orientation.y = (ktxOrientationY)orientation[1];
+        result = ktxHashList_AddKVPair(&This->kvDataHead, KTX_ORIENTATION_KEY,
+                                       This->numDimensions + 1,
+                                       orientation);
+        if (result != KTX_SUCCESS)
+            goto cleanup;
+    }
+
+    if (bfh.m_tex_type == cBASISTexTypeVideoFrames) {
+        This->isVideo = KTX_TRUE;
+        This->duration = bfh.m_us_per_frame;
+        This->timescale = 1000000;
+        This->loopcount = 0;
+        ktx_uint32_t animData[3] = {
+            This->duration, This->timescale, This->loopcount
+        };
+        result = ktxHashList_AddKVPair(&This->kvDataHead, KTX_ANIMDATA_KEY,
+                                       sizeof(animData), animData);
+        if (result != KTX_SUCCESS)
+            goto cleanup;
+    }
+
+    {
+        basisSlices newSlices;
+        result = ktxTexture2_copyBasisSlices(This, bytes, rgbSlices,
+                                             newSlices);
+        if (result != KTX_SUCCESS)
+            goto cleanup;
+        ktxTexture2_installBasisSlices(This, newSlices);
+    }
+
+    *newTex = This;
+    return KTX_SUCCESS;
+
+cleanup:
+    ktxTexture2_Destroy(This);
+    return result;
+}
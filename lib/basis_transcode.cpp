@@ -20,6 +20,12 @@
 
 #include <inttypes.h>
 #include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
 #include <KHR/khr_df.h>
 
 #include "dfdutils/dfd.h"
@@ -57,6 +63,107 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
                            ktxTexture2* prototype,
                            ktx_transcode_fmt_e outputFormat,
                            ktx_transcode_flags transcodeFlags);
+KTX_error_code
+ktxTexture2_transcodeUastcInPlace(ktxTexture2* This,
+                                  alpha_content_e alphaContent,
+                                  ktxTexture2* prototype,
+                                  ktx_transcode_fmt_e outputFormat,
+                                  ktx_transcode_flags transcodeFlags);
+
+/*
+ * True if UASTC can be transcoded to @p outputFormat a block at a time
+ * into no more space than the input.
+ */
+static bool
+isInPlaceTarget(ktx_transcode_fmt_e outputFormat)
+{
+    switch (outputFormat) {
+      case KTX_TTF_ETC1_RGB:
+      case KTX_TTF_ETC2_RGBA:
+      case KTX_TTF_ETC2_EAC_R11:
+      case KTX_TTF_ETC2_EAC_RG11:
+      case KTX_TTF_BC1_RGB:
+      case KTX_TTF_BC3_RGBA:
+      case KTX_TTF_BC4_R:
+      case KTX_TTF_BC5_RG:
+      case KTX_TTF_BC7_RGBA:
+      case KTX_TTF_ASTC_4x4_RGBA:
+        return true;
+      default:
+        // PVRTC1 needs whole images. Uncompressed targets are larger.
+        return false;
+    }
+}
+
+/*
+ * Arguments for a transcode_image call covering one image or, for UASTC,
+ * a band of block rows of one.
+ */
+struct transcodeJob {
+    ktx_uint8_t* pDst;
+    ktx_uint32_t dstLength;   // In blocks or, if uncompressed, pixels.
+    ktx_uint32_t level;
+    ktx_uint32_t blocksX, blocksY;
+    ktx_uint32_t width, height;
+    ktx_uint32_t offset, length;
+    ktx_uint32_t alphaOffset, alphaLength; // ETC1S only.
+    ktx_uint32_t stateIndex;
+};
+
+/*
+ * Run @p transcode on each of @p jobs. Unless @p multithread the jobs are
+ * run in order with the states selected by their stateIndex, as video needs.
+ * Otherwise they are shared among a thread per hardware thread, each with
+ * its own state. Returns false if any call failed.
+ */
+template<typename F>
+static bool
+runTranscodeJobs(const std::vector<transcodeJob>& jobs, bool multithread,
+                 std::vector<basisu_transcoder_state>& xcoderStates,
+                 F transcode)
+{
+    if (!multithread) {
+        for (const auto& job : jobs) {
+            if (!transcode(job, xcoderStates[job.stateIndex]))
+                return false;
+        }
+        return true;
+    }
+
+    std::atomic<size_t> nextJob(0);
+    std::atomic<bool> failed(false);
+    auto worker = [&]() {
+        basisu_transcoder_state xcoderState;
+        for (;;) {
+            size_t i = nextJob++;
+            if (i >= jobs.size() || failed)
+                break;
+            try {
+                if (!transcode(jobs[i], xcoderState))
+                    failed = true;
+            } catch (std::bad_alloc&) {
+                // Must not escape the thread.
+                failed = true;
+            }
+        }
+    };
+
+    size_t threadCount = std::max(1U, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, jobs.size());
+    std::vector<std::thread> threads;
+    try {
+        for (size_t i = 1; i < threadCount; i++)
+            threads.emplace_back(worker);
+    } catch (std::system_error&) {
+        // Continue with the threads that were started.
+    } catch (std::bad_alloc&) {
+        // Likewise.
+    }
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+    return !failed;
+}
 
 /**
  * @memberof ktxTexture2
@@ -97,6 +204,12 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
  *
  * The following @p transcodeFlags are available.
  *
+ * @c KTX_TF_MULTITHREAD spreads the work across the hardware threads. UASTC
+ * images are split into bands of block rows so even a single large image
+ * benefits. BasisLZ/ETC1S images can only be transcoded a whole image at a
+ * time so only textures with several images, e.g. mipmaps or array layers,
+ * benefit. ETC1S video is always transcoded on the calling thread.
+ *
  * @sa ktxtexture2_CompressBasis().
  *
  * @param[in]   This         pointer to the ktxTexture2 object of interest.
@@ -287,9 +400,21 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
     }
 
 
+    // The transcode is done in place only when the data is known to be
+    // writable, i.e. not a view of a shared texture.
+    const bool inPlace = (transcodeFlags & KTX_TF_TRANSCODE_IN_PLACE)
+                         && textureFormat == basis_tex_format::cUASTC4x4
+                         && isInPlaceTarget(outputFormat)
+                         && priv._sharedRegion == nullptr;
+    // Not a Basis Universal decode flag.
+    transcodeFlags &= ~KTX_TF_TRANSCODE_IN_PLACE;
+    if (inPlace)
+        transcodeFlags &= ~KTX_TF_MULTITHREAD;
+
     // Create a prototype texture to use for calculating sizes in the target
     // format and, as useful side effects, provide us with a properly sized
-    // data allocation and the DFD for the target format.
+    // data allocation, unless transcoding in place, and the DFD for the
+    // target format.
     ktxTextureCreateInfo createInfo;
     createInfo.glInternalformat = 0;
     createInfo.vkFormat = vkFormat;
@@ -306,7 +431,9 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
 
     KTX_error_code result;
     ktxTexture2* prototype;
-    result = ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+    result = ktxTexture2_Create(&createInfo,
+                                inPlace ? KTX_TEXTURE_CREATE_NO_STORAGE
+                                        : KTX_TEXTURE_CREATE_ALLOC_STORAGE,
                                 &prototype);
 
     if (result != KTX_SUCCESS) {
@@ -343,6 +470,10 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
         result = ktxTexture2_transcodeLzEtc1s(This, alphaContent,
                                             prototype, outputFormat,
                                             transcodeFlags);
+    } else if (inPlace) {
+        result = ktxTexture2_transcodeUastcInPlace(This, alphaContent,
+                                                   prototype, outputFormat,
+                                                   transcodeFlags);
     } else {
         result = ktxTexture2_transcodeUastc(This, alphaContent,
                                             prototype, outputFormat,
@@ -367,11 +498,22 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
         free(This->pDfd);
         This->pDfd = prototype->pDfd;
         prototype->pDfd = 0;
-        free(This->pData);
-        This->pData = prototype->pData;
-        This->dataSize = prototype->dataSize;
-        prototype->pData = 0;
-        prototype->dataSize = 0;
+        if (inPlace) {
+            // Release the space freed by smaller output blocks. If realloc
+            // fails the original, larger, allocation is still valid.
+            ktx_size_t dataSize = protoPriv._levelIndex[0].byteOffset
+                                + protoPriv._levelIndex[0].byteLength;
+            ktx_uint8_t* pData = (ktx_uint8_t*)realloc(This->pData, dataSize);
+            if (pData != nullptr)
+                This->pData = pData;
+            This->dataSize = dataSize;
+        } else {
+            ktxTexture2_freeData(This);
+            This->pData = prototype->pData;
+            This->dataSize = prototype->dataSize;
+            prototype->pData = 0;
+            prototype->dataSize = 0;
+        }
     }
     ktxTexture2_Destroy(prototype);
     return result;
@@ -457,9 +599,18 @@ ktxTexture2_transcodeLzEtc1s(ktxTexture2* This,
     DECLARE_PRIVATE(priv, This);
     DECLARE_PRIVATE(protoPriv, prototype);
     KTX_error_code result = KTX_SUCCESS;
+    std::vector<transcodeJob> jobs;
 
     assert(This->supercompressionScheme == KTX_SS_BASIS_LZ);
 
+    // The Huffman coded selectors and endpoints of an image must be decoded
+    // in order so only whole images can be transcoded in parallel. Video
+    // P-frames depend on the previous frame so must be decoded in order too.
+    const bool multithread = (transcodeFlags & KTX_TF_MULTITHREAD)
+                             && !This->isVideo;
+    // Not a Basis Universal decode flag.
+    transcodeFlags &= ~KTX_TF_MULTITHREAD;
+
     uint8_t* bgd = priv._supercompressionGlobalData;
     ktxBasisLzGlobalHeader& bgdh = *reinterpret_cast<ktxBasisLzGlobalHeader*>(bgd);
     if (!(bgdh.endpointsByteLength && bgdh.selectorsByteLength && bgdh.tablesByteLength)) {
@@ -540,7 +691,6 @@ ktxTexture2_transcodeLzEtc1s(ktxTexture2* This,
     for (int32_t level = This->numLevels - 1; level >= 0; level--) {
         uint64_t levelOffset = ktxTexture2_levelDataOffset(This, level);
         uint64_t writeOffset = levelOffsetWrite;
-        uint64_t writeOffsetBlocks = levelOffsetWrite / outputBlockByteLength;
         uint32_t levelWidth = MAX(1, This->baseWidth >> level);
         uint32_t levelHeight = MAX(1, This->baseHeight >> level);
         // ETC1S texel block dimensions
@@ -562,11 +712,12 @@ ktxTexture2_transcodeLzEtc1s(ktxTexture2* This,
         for (; image < endImage; image++) {
             const ktxBasisLzEtc1sImageDesc& imageDesc = imageDescs[image];
 
-            basisu_transcoder_state& xcoderState = xcoderStates[stateIndex];
+            transcodeJob job;
             // We have face0 [face1 ...] within each layer. Use `stateIndex`
             // rather than a double loop of layers and faceSlices as this
             // works for 3d texture and non-array cube maps as well as
             // cube map arrays without special casing.
+            job.stateIndex = stateIndex;
             if (++stateIndex == xcoderStates.size())
                 stateIndex = 0;
 
@@ -578,22 +729,56 @@ ktxTexture2_transcodeLzEtc1s(ktxTexture2* This,
                     return KTX_FILE_DATA_ERROR;
             }
 
-            bool status;
-            status = bit.transcode_image(
+            job.pDst = pXcodedData + writeOffset;
+            job.dstLength = (uint32_t)(xcodedDataLength
+                                       - writeOffset / outputBlockByteLength);
+            job.level = level;
+            job.blocksX = levelBlocksX;
+            job.blocksY = levelBlocksY;
+            job.width = levelWidth;
+            job.height = levelHeight;
+            job.offset = (uint32_t)(levelOffset + imageDesc.rgbSliceByteOffset);
+            job.length = imageDesc.rgbSliceByteLength;
+            job.alphaOffset
+                = (uint32_t)(levelOffset + imageDesc.alphaSliceByteOffset);
+            job.alphaLength = imageDesc.alphaSliceByteLength;
+            try {
+                jobs.push_back(job);
+            } catch (std::bad_alloc&) {
+                result = KTX_OUT_OF_MEMORY;
+                goto cleanup;
+            }
+
+            writeOffset += levelImageSizeOut;
+            levelSizeOut += levelImageSizeOut;
+        } // end images loop
+        protoLevelIndex[level].byteOffset = levelOffsetWrite;
+        protoLevelIndex[level].byteLength = levelSizeOut;
+        protoLevelIndex[level].uncompressedByteLength = levelSizeOut;
+        levelOffsetWrite += levelSizeOut;
+        assert(levelOffsetWrite == writeOffset);
+        // In case of transcoding to uncompressed.
+        levelOffsetWrite = _KTX_PADN(protoPriv._requiredLevelAlignment,
+                                     levelOffsetWrite);
+    } // level loop
+
+    if (!runTranscodeJobs(jobs, multithread, xcoderStates,
+            [&](const transcodeJob& job, basisu_transcoder_state& xcoderState) {
+                return bit.transcode_image(
                       (transcoder_texture_format)outputFormat,
-                      pXcodedData + writeOffset,
-                      (uint32_t)(xcodedDataLength - writeOffsetBlocks),
+                      job.pDst,
+                      job.dstLength,
                       This->pData,
                       (uint32_t)This->dataSize,
-                      levelBlocksX,
-                      levelBlocksY,
-                      levelWidth,
-                      levelHeight,
-                      level,
-                      (uint32_t)(levelOffset + imageDesc.rgbSliceByteOffset),
-                      imageDesc.rgbSliceByteLength,
-                      (uint32_t)(levelOffset + imageDesc.alphaSliceByteOffset),
-                      imageDesc.alphaSliceByteLength,
+                      job.blocksX,
+                      job.blocksY,
+                      job.width,
+                      job.height,
+                      job.level,
+                      job.offset,
+                      job.length,
+                      job.alphaOffset,
+                      job.alphaLength,
                       transcodeFlags,
                       alphaContent != eNone,
                       isVideo,
@@ -608,23 +793,10 @@ ktxTexture2_transcodeLzEtc1s(ktxTexture2* This,
                       &xcoderState,
                       0  // output_rows_in_pixels
                       );
-            if (!status) {
-                result = KTX_TRANSCODE_FAILED;
-                goto cleanup;
-            }
-
-            writeOffset += levelImageSizeOut;
-            levelSizeOut += levelImageSizeOut;
-        } // end images loop
-        protoLevelIndex[level].byteOffset = levelOffsetWrite;
-        protoLevelIndex[level].byteLength = levelSizeOut;
-        protoLevelIndex[level].uncompressedByteLength = levelSizeOut;
-        levelOffsetWrite += levelSizeOut;
-        assert(levelOffsetWrite == writeOffset);
-        // In case of transcoding to uncompressed.
-        levelOffsetWrite = _KTX_PADN(protoPriv._requiredLevelAlignment,
-                                     levelOffsetWrite);
-    } // level loop
+            })) {
+        result = KTX_TRANSCODE_FAILED;
+        goto cleanup;
+    }
 
     result = KTX_SUCCESS;
 
@@ -652,16 +824,27 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
     ktxLevelIndexEntry* protoLevelIndex = protoPriv._levelIndex;
     ktx_size_t levelOffsetWrite = 0;
 
+    // UASTC blocks are independent so, except for PVRTC1 which needs whole
+    // images, the images can be split into bands of block rows that are
+    // transcoded in parallel.
+    const bool multithread = (transcodeFlags & KTX_TF_MULTITHREAD) != 0;
+    const bool splitImages = multithread
+                             && (isInPlaceTarget(outputFormat)
+                                 || !prototype->isCompressed);
+    const ktx_uint32_t bandBlockRows = 16;
+    // Not a Basis Universal decode flag.
+    transcodeFlags &= ~KTX_TF_MULTITHREAD;
+
     basisu_lowlevel_uastc_transcoder uit;
     // See comment on same declaration in transcodeEtc1s.
     std::vector<basisu_transcoder_state> xcoderStates;
     xcoderStates.resize(This->isVideo ? This->numFaces : 1);
+    std::vector<transcodeJob> jobs;
 
     for (ktx_int32_t level = This->numLevels - 1; level >= 0; level--)
     {
         ktx_uint32_t depth;
         uint64_t writeOffset = levelOffsetWrite;
-        uint64_t writeOffsetBlocks = levelOffsetWrite / outputBlockByteLength;
         ktx_size_t levelImageSizeIn, levelImageOffsetIn;
         ktx_size_t levelImageSizeOut, levelSizeOut;
         ktx_uint32_t levelImageCount;
@@ -671,6 +854,12 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
         const uint32_t bw = 4, bh = 4;
         uint32_t levelBlocksX = (levelWidth + (bw - 1)) / bw;
         uint32_t levelBlocksY = (levelHeight + (bh - 1)) / bh;
+        uint32_t bandRows = splitImages ? bandBlockRows : levelBlocksY;
+        // Size of the output for a row of blocks.
+        ktx_size_t rowSizeOut = prototype->isCompressed
+                              ? levelBlocksX * outputBlockByteLength
+                              : (ktx_size_t)levelWidth * bh
+                                * outputBlockByteLength;
         uint32_t stateIndex = 0;
 
         depth = MAX(1, This->baseDepth  >> level);
@@ -684,26 +873,62 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
 
         levelImageOffsetIn = ktxTexture2_levelDataOffset(This, level);
         levelSizeOut = 0;
-        bool status;
         for (uint32_t image = 0; image < levelImageCount; image++) {
-            basisu_transcoder_state& xcoderState = xcoderStates[stateIndex];
+            transcodeJob job;
             // See comment before same lines in transcodeEtc1s.
+            job.stateIndex = stateIndex;
             if (++stateIndex == xcoderStates.size())
                 stateIndex = 0;
 
-            status = uit.transcode_image(
+            job.level = level;
+            job.blocksX = levelBlocksX;
+            job.width = levelWidth;
+            job.alphaOffset = job.alphaLength = 0;
+            for (uint32_t row = 0; row < levelBlocksY; row += bandRows) {
+                ktx_size_t bandOffsetOut = writeOffset + row * rowSizeOut;
+                job.pDst = pXcodedData + bandOffsetOut;
+                job.dstLength = (uint32_t)(xcodedDataLength
+                                     - bandOffsetOut / outputBlockByteLength);
+                job.blocksY = MIN(bandRows, levelBlocksY - row);
+                job.height = MIN(job.blocksY * bh, levelHeight - row * bh);
+                job.offset = (uint32_t)(levelImageOffsetIn
+                                        + row * levelBlocksX * 16);
+                job.length = job.blocksX * job.blocksY * 16;
+                try {
+                    jobs.push_back(job);
+                } catch (std::bad_alloc&) {
+                    return KTX_OUT_OF_MEMORY;
+                }
+            }
+            writeOffset += levelImageSizeOut;
+            levelSizeOut += levelImageSizeOut;
+            levelImageOffsetIn += levelImageSizeIn;
+        }
+        protoLevelIndex[level].byteOffset = levelOffsetWrite;
+        // writeOffset will be equal to total size of the images in the level.
+        protoLevelIndex[level].byteLength = levelSizeOut;
+        protoLevelIndex[level].uncompressedByteLength = levelSizeOut;
+        levelOffsetWrite += levelSizeOut;
+    }
+    // In case of transcoding to uncompressed.
+    levelOffsetWrite = _KTX_PADN(protoPriv._requiredLevelAlignment,
+                                 levelOffsetWrite);
+
+    if (!runTranscodeJobs(jobs, multithread, xcoderStates,
+            [&](const transcodeJob& job, basisu_transcoder_state& xcoderState) {
+                return uit.transcode_image(
                           (transcoder_texture_format)outputFormat,
-                          pXcodedData + writeOffset,
-                          (uint32_t)(xcodedDataLength - writeOffsetBlocks),
+                          job.pDst,
+                          job.dstLength,
                           This->pData,
                           (uint32_t)This->dataSize,
-                          levelBlocksX,
-                          levelBlocksY,
-                          levelWidth,
-                          levelHeight,
-                          level,
-                          (uint32_t)levelImageOffsetIn,
-                          (uint32_t)levelImageSizeIn,
+                          job.blocksX,
+                          job.blocksY,
+                          job.width,
+                          job.height,
+                          job.level,
+                          job.offset,
+                          job.length,
                           transcodeFlags,
                           alphaContent != eNone,
                           This->isVideo, // is_video
@@ -714,20 +939,102 @@ ktxTexture2_transcodeUastc(ktxTexture2* This,
                           -1, // channel0
                           -1  // channel1
                           );
+            })) {
+        return KTX_TRANSCODE_FAILED;
+    }
+    return KTX_SUCCESS;
+}
+
+/*
+ * Transcode UASTC to a format whose blocks are no larger than UASTC's,
+ * writing the output over the input.
+ *
+ * The output is packed from the start of the data in the same order as the
+ * input, smallest level first, so the output for any block row starts no
+ * later than the row's input. Each row is copied to a small buffer before
+ * transcoding so its output can overwrite it; rows not yet read always lie
+ * beyond the end of the output written so far.
+ */
+KTX_error_code
+ktxTexture2_transcodeUastcInPlace(ktxTexture2* This,
+                                  alpha_content_e alphaContent,
+                                  ktxTexture2* prototype,
+                                  ktx_transcode_fmt_e outputFormat,
+                                  ktx_transcode_flags transcodeFlags)
+{
+    assert(This->supercompressionScheme == KTX_SS_NONE);
+
+    ktx_uint32_t outputBlockByteLength
+                      = prototype->_protected->_formatSize.blockSizeInBits / 8;
+    const ktx_uint32_t inputBlockByteLength = 16;
+    DECLARE_PRIVATE(protoPriv, prototype);
+    ktxLevelIndexEntry* protoLevelIndex = protoPriv._levelIndex;
+    ktx_size_t levelOffsetWrite = 0;
+
+    assert(outputBlockByteLength <= inputBlockByteLength);
+
+    basisu_lowlevel_uastc_transcoder uit;
+    std::vector<ktx_uint8_t> rowBuf;
+    try {
+        rowBuf.resize(((This->baseWidth + 3) / 4) * inputBlockByteLength);
+    } catch (std::bad_alloc&) {
+        return KTX_OUT_OF_MEMORY;
+    }
+
+    for (ktx_int32_t level = This->numLevels - 1; level >= 0; level--)
+    {
+        uint32_t levelWidth = MAX(1, This->baseWidth >> level);
+        uint32_t levelHeight = MAX(1, This->baseHeight >> level);
+        uint32_t depth = MAX(1, This->baseDepth  >> level);
+        // UASTC texel block dimensions
+        const uint32_t bw = 4, bh = 4;
+        uint32_t levelBlocksX = (levelWidth + (bw - 1)) / bw;
+        uint32_t levelBlocksY = (levelHeight + (bh - 1)) / bh;
+        ktx_uint32_t levelRowCount
+                = This->numLayers * This->numFaces * depth * levelBlocksY;
+        ktx_size_t rowSizeIn = levelBlocksX * inputBlockByteLength;
+        ktx_size_t rowSizeOut = levelBlocksX * outputBlockByteLength;
+        ktx_uint8_t* pIn = This->pData + ktxTexture2_levelDataOffset(This,
+                                                                     level);
+        ktx_uint8_t* pOut;
+
+        levelOffsetWrite = _KTX_PADN(protoPriv._requiredLevelAlignment,
+                                     levelOffsetWrite);
+        pOut = This->pData + levelOffsetWrite;
+
+        for (ktx_uint32_t row = 0; row < levelRowCount; row++) {
+            ktx_uint32_t blockY = row % levelBlocksY;
+            uint32_t rowHeight = MIN(bh, levelHeight - blockY * bh);
+
+            assert(pOut <= pIn);
+            memcpy(rowBuf.data(), pIn, rowSizeIn);
+            bool status = uit.transcode_image(
+                          (transcoder_texture_format)outputFormat,
+                          pOut,
+                          levelBlocksX,
+                          rowBuf.data(),
+                          (uint32_t)rowSizeIn,
+                          levelBlocksX,
+                          1,
+                          levelWidth,
+                          rowHeight,
+                          level,
+                          0,
+                          (uint32_t)rowSizeIn,
+                          transcodeFlags,
+                          alphaContent != eNone,
+                          This->isVideo
+                          );
             if (!status)
                 return KTX_TRANSCODE_FAILED;
-            writeOffset += levelImageSizeOut;
-            levelSizeOut += levelImageSizeOut;
-            levelImageOffsetIn += levelImageSizeIn;
+            pIn += rowSizeIn;
+            pOut += rowSizeOut;
         }
         protoLevelIndex[level].byteOffset = levelOffsetWrite;
-        // writeOffset will be equal to total size of the images in the level.
-        protoLevelIndex[level].byteLength = levelSizeOut;
-        protoLevelIndex[level].uncompressedByteLength = levelSizeOut;
-        levelOffsetWrite += levelSizeOut;
+        protoLevelIndex[level].byteLength = levelRowCount * rowSizeOut;
+        protoLevelIndex[level].uncompressedByteLength
+                                        = protoLevelIndex[level].byteLength;
+        levelOffsetWrite += protoLevelIndex[level].byteLength;
     }
-    // In case of transcoding to uncompressed.
-    levelOffsetWrite = _KTX_PADN(protoPriv._requiredLevelAlignment,
-                                 levelOffsetWrite);
     return KTX_SUCCESS;
 }
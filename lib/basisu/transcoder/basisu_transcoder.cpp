@@ -37,6 +37,29 @@
 	#endif
 #endif
 
+// SIMD is only used to pack pixels to 16-bit formats, which are stored little endian.
+#ifndef BASISD_USE_SSE2
+	#if !BASISD_IS_BIG_ENDIAN && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+		#define BASISD_USE_SSE2 (1)
+	#else
+		#define BASISD_USE_SSE2 (0)
+	#endif
+#endif
+
+#ifndef BASISD_USE_NEON
+	#if !BASISD_IS_BIG_ENDIAN && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+		#define BASISD_USE_NEON (1)
+	#else
+		#define BASISD_USE_NEON (0)
+	#endif
+#endif
+
+#if BASISD_USE_SSE2
+	#include <emmintrin.h>
+#elif BASISD_USE_NEON
+	#include <arm_neon.h>
+#endif
+
 // Using unaligned loads and stores causes errors when using UBSan. Jam it off.
 #if defined(__has_feature)
 #if __has_feature(undefined_behavior_sanitizer)
@@ -207,6 +230,72 @@ namespace basist
 #endif
 	}
 
+	static bool g_packed_selector_kernels = true;
+
+	bool get_packed_selector_kernels()
+	{
+		return g_packed_selector_kernels;
+	}
+
+	void set_packed_selector_kernels(bool enabled)
+	{
+		g_packed_selector_kernels = enabled;
+	}
+
+	// Translates the 16 2-bit selectors of pSelector through a 4 entry table, entry s in bits [s*2, s*2+1] of trans.
+	// The result keeps the raw selector layout, row y in bits [y*8, y*8+7]. The masks of the texels using each selector
+	// are disjoint and the entries fit in 2 bits, so the products can't carry into a neighbouring texel.
+	static inline uint32_t translate_selectors_2bit(const selector* pSelector, uint32_t trans)
+	{
+		const uint32_t raw = pSelector->get_raw_selectors();
+		const uint32_t l = raw & 0x55555555, h = (raw >> 1) & 0x55555555;
+
+		return (~(h | l) & 0x55555555) * (trans & 3) + (l & ~h) * ((trans >> 2) & 3) + (h & ~l) * ((trans >> 4) & 3) + (h & l) * ((trans >> 6) & 3);
+	}
+
+	// Moves bit i of the low 16 bits of v to bit i*3.
+	static inline uint64_t spread_bits_3(uint32_t v)
+	{
+		uint64_t x = v & 0xFFFF;
+		x = (x | (x << 16)) & 0x0000FF0000FFULL;
+		x = (x | (x << 8)) & 0x00F00F00F00FULL;
+		x = (x | (x << 4)) & 0x0C30C30C30C3ULL;
+		return (x | (x << 2)) & 0x249249249249ULL;
+	}
+
+	// Reverses the low 16 bits of v.
+	static inline uint32_t reverse_16_bits(uint32_t v)
+	{
+		v = ((v >> 1) & 0x5555) | ((v & 0x5555) << 1);
+		v = ((v >> 2) & 0x3333) | ((v & 0x3333) << 2);
+		v = ((v >> 4) & 0x0F0F) | ((v & 0x0F0F) << 4);
+		return ((v >> 8) & 0x00FF) | ((v & 0x00FF) << 8);
+	}
+
+	// Translates 16 2-bit selectors, selector i's low bit in bit i of l and its high bit in bit i of h, through a 4 entry
+	// table, entry s in bits [s*3, s*3+2] of trans. Selector i's result goes to bits [i*3, i*3+2].
+	static inline uint64_t translate_selectors_3bit(uint32_t l, uint32_t h, uint32_t trans)
+	{
+		const uint64_t sl = spread_bits_3(l), sh = spread_bits_3(h), m = 0x249249249249ULL;
+
+		return (~(sh | sl) & m) * (trans & 7) + (sl & ~sh) * ((trans >> 3) & 7) + (sh & ~sl) * ((trans >> 6) & 7) + (sh & sl) * ((trans >> 9) & 7);
+	}
+
+	// Returns the 48 selector bits of a BC4 block, texel (x,y) at bit (y*4+x)*3.
+	static inline uint64_t translate_selectors_bc4(const selector* pSelector, uint32_t trans)
+	{
+		const uint32_t raw = pSelector->get_raw_selectors();
+		return translate_selectors_3bit(compact_even_bits(raw), compact_even_bits(raw >> 1), trans);
+	}
+
+	// Returns the 48 selector bits of an EAC block, texel (x,y) at bit 45-(x*4+y)*3.
+	static inline uint64_t translate_selectors_eac(const selector* pSelector, uint32_t trans)
+	{
+		const uint32_t raw = pSelector->get_raw_selectors();
+		return translate_selectors_3bit(reverse_16_bits(transpose_4x4_bits(compact_even_bits(raw))),
+			reverse_16_bits(transpose_4x4_bits(compact_even_bits(raw >> 1))), trans);
+	}
+
 	inline uint16_t byteswap_uint16(uint16_t v)
 	{
 		return static_cast<uint16_t>((v >> 8) | (v << 8));
@@ -218,6 +307,128 @@ namespace basist
 
 	static inline uint8_t mul_8(uint32_t v, uint32_t q) { v = v * q + 128; return (uint8_t)((v + (v >> 8)) >> 8); }
 
+	// Writes the palette entries chosen by pSelector to the first max_x by max_y pixels of a block at pDst, a whole row at a
+	// time. Bits set in keep_mask are kept from the existing pixels, so color and alpha can be written separately.
+	template<typename T>
+	static inline void write_selected_pixels(uint8_t* pDst, uint32_t row_pitch_in_bytes, const selector* pSelector, const T* pPalette, uint32_t max_x, uint32_t max_y, T keep_mask = 0)
+	{
+		for (uint32_t y = 0; y < max_y; y++)
+		{
+			const uint32_t s = pSelector->m_selectors[y];
+			T row[4] = { pPalette[s & 3], pPalette[(s >> 2) & 3], pPalette[(s >> 4) & 3], pPalette[s >> 6] };
+
+			if (max_x == 4)
+			{
+				if (keep_mask)
+				{
+					T cur[4];
+					memcpy(cur, pDst, sizeof(cur));
+					for (uint32_t x = 0; x < 4; x++)
+						row[x] |= cur[x] & keep_mask;
+				}
+				memcpy(pDst, row, sizeof(row));
+			}
+			else
+			{
+				for (uint32_t x = 0; x < max_x; x++)
+				{
+					T cur = 0;
+					if (keep_mask)
+						memcpy(&cur, pDst + x * sizeof(T), sizeof(T));
+					cur = (cur & keep_mask) | row[x];
+					memcpy(pDst + x * sizeof(T), &cur, sizeof(T));
+				}
+			}
+
+			pDst += row_pitch_in_bytes;
+		}
+	}
+
+	// Packs the first max_x by max_y pixels of a 4x4 block to 16-bit little endian pixels at pDst. Component c is scaled with
+	// mul_8() by scale[c] then multiplied by weight[c], a power of 2 placing it in the pixel. Gives the same result as the scalar code.
+	static void pack_block_pixels_16(const color32* pPixels, uint8_t* pDst, uint32_t row_pitch_in_bytes, uint32_t max_x, uint32_t max_y, const uint16_t scale[4], const uint16_t weight[4])
+	{
+#if BASISD_USE_SSE2
+		const __m128i zero = _mm_setzero_si128(), round = _mm_set1_epi16(128);
+		const __m128i scales = _mm_setr_epi16(scale[0], scale[1], scale[2], scale[3], scale[0], scale[1], scale[2], scale[3]);
+		const __m128i weights = _mm_setr_epi16(weight[0], weight[1], weight[2], weight[3], weight[0], weight[1], weight[2], weight[3]);
+
+		for (uint32_t y = 0; y < max_y; y++)
+		{
+			const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pPixels + y * 4));
+
+			// mul_8() on 16-bit lanes, which can't overflow as v * q + 128 < 2^15.
+			__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(p, zero), scales), round);
+			__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(p, zero), scales), round);
+			lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+			hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+			// Place the components and add pairs, giving the 2 halves of each pixel, then add the halves.
+			lo = _mm_shuffle_epi32(_mm_madd_epi16(lo, weights), _MM_SHUFFLE(3, 1, 2, 0));
+			hi = _mm_shuffle_epi32(_mm_madd_epi16(hi, weights), _MM_SHUFFLE(3, 1, 2, 0));
+			__m128i px = _mm_add_epi32(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+
+			// Sign extend the low 16 bits so the signed saturating pack keeps them as they are.
+			px = _mm_srai_epi32(_mm_slli_epi32(px, 16), 16);
+			px = _mm_packs_epi32(px, px);
+
+			if (max_x == 4)
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(pDst), px);
+			else
+			{
+				uint16_t row[8];
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(row), px);
+				memcpy(pDst, row, max_x * sizeof(uint16_t));
+			}
+
+			pDst += row_pitch_in_bytes;
+		}
+#elif BASISD_USE_NEON
+		const uint16_t scales8[8] = { scale[0], scale[1], scale[2], scale[3], scale[0], scale[1], scale[2], scale[3] };
+		const uint16_t weights8[8] = { weight[0], weight[1], weight[2], weight[3], weight[0], weight[1], weight[2], weight[3] };
+		const uint16x8_t scales = vld1q_u16(scales8), weights = vld1q_u16(weights8), round = vdupq_n_u16(128);
+
+		for (uint32_t y = 0; y < max_y; y++)
+		{
+			const uint8x16_t p = vld1q_u8(reinterpret_cast<const uint8_t*>(pPixels + y * 4));
+
+			uint16x8_t lo = vmlaq_u16(round, vmovl_u8(vget_low_u8(p)), scales);
+			uint16x8_t hi = vmlaq_u16(round, vmovl_u8(vget_high_u8(p)), scales);
+			lo = vmulq_u16(vshrq_n_u16(vaddq_u16(lo, vshrq_n_u16(lo, 8)), 8), weights);
+			hi = vmulq_u16(vshrq_n_u16(vaddq_u16(hi, vshrq_n_u16(hi, 8)), 8), weights);
+
+			// The placed components don't overlap so adding them pairwise twice assembles the pixels.
+			const uint16x4_t px = vpadd_u16(vpadd_u16(vget_low_u16(lo), vget_high_u16(lo)), vpadd_u16(vget_low_u16(hi), vget_high_u16(hi)));
+
+			if (max_x == 4)
+				vst1_u16(reinterpret_cast<uint16_t*>(pDst), px);
+			else
+			{
+				uint16_t row[4];
+				vst1_u16(row, px);
+				memcpy(pDst, row, max_x * sizeof(uint16_t));
+			}
+
+			pDst += row_pitch_in_bytes;
+		}
+#else
+		for (uint32_t y = 0; y < max_y; y++)
+		{
+			for (uint32_t x = 0; x < max_x; x++)
+			{
+				const color32& c = pPixels[y * 4 + x];
+
+				const uint32_t packed = mul_8(c.r, scale[0]) * weight[0] + mul_8(c.g, scale[1]) * weight[1] + mul_8(c.b, scale[2]) * weight[2] + mul_8(c.a, scale[3]) * weight[3];
+
+				pDst[x * 2 + 0] = (uint8_t)(packed & 0xFF);
+				pDst[x * 2 + 1] = (uint8_t)((packed >> 8) & 0xFF);
+			}
+
+			pDst += row_pitch_in_bytes;
+		}
+#endif
+	}
+
 	uint16_t crc16(const void* r, size_t size, uint16_t crc)
 	{
 		crc = ~crc;
@@ -2140,6 +2351,17 @@ namespace basist
 			pDst_block->set_low_color((uint16_t)max16);
 			pDst_block->set_high_color((uint16_t)min16);
 
+			if (g_packed_selector_kernels)
+			{
+				// BC1 packs its selectors like the raw ETC1S selectors.
+				const uint32_t sels = translate_selectors_2bit(pSelector, l | (l << 2) | (l << 4) | (h << 6));
+				pDst_block->m_selectors[0] = static_cast<uint8_t>(sels);
+				pDst_block->m_selectors[1] = static_cast<uint8_t>(sels >> 8);
+				pDst_block->m_selectors[2] = static_cast<uint8_t>(sels >> 16);
+				pDst_block->m_selectors[3] = static_cast<uint8_t>(sels >> 24);
+				return;
+			}
+
 			for (uint32_t y = 0; y < 4; y++)
 			{
 				for (uint32_t x = 0; x < 4; x++)
@@ -2717,6 +2939,18 @@ namespace basist
 			pDst_block->set_low_alpha(r0);
 			pDst_block->set_high_alpha(r1);
 
+			if (g_packed_selector_kernels)
+			{
+				uint32_t trans = 0;
+				for (uint32_t s = 0; s < 4; s++)
+					trans |= ((s == high_selector) ? 1U : 0U) << (s * 3);
+
+				const uint64_t sels = translate_selectors_bc4(pSelector, trans);
+				for (uint32_t i = 0; i < 6; i++)
+					pDst_block->m_selectors[i] = static_cast<uint8_t>(sels >> (i * 8));
+				return;
+			}
+
 			// TODO: Optimize this
 			for (uint32_t y = 0; y < 4; y++)
 			{
@@ -2742,6 +2976,14 @@ namespace basist
 		pDst_block->set_low_alpha(pTable_entry->m_lo);
 		pDst_block->set_high_alpha(pTable_entry->m_hi);
 
+		if (g_packed_selector_kernels)
+		{
+			const uint64_t sels = translate_selectors_bc4(pSelector, pTable_entry->m_trans);
+			for (uint32_t i = 0; i < 6; i++)
+				pDst_block->m_selectors[i] = static_cast<uint8_t>(sels >> (i * 8));
+			return;
+		}
+
 		// TODO: Optimize this (like ETC1->BC1)
 		for (uint32_t y = 0; y < 4; y++)
 		{
@@ -4215,6 +4457,29 @@ namespace basist
 			pDst_block->m_lo.m_g1 = g1 >> 1;
 			pDst_block->m_lo.m_b1 = b1 >> 1;
 
+			if (g_packed_selector_kernels)
+			{
+				// The low selector maps to 0, the other one to 3. The first texel's selector must have its MSB clear.
+				uint32_t trans = 0xFF ^ (3 << (low_selector * 2));
+				if (pSelector->get_selector(0, 0) != low_selector)
+				{
+					pDst_block->m_lo.m_r0 = r1 >> 1;
+					pDst_block->m_lo.m_g0 = g1 >> 1;
+					pDst_block->m_lo.m_b0 = b1 >> 1;
+
+					pDst_block->m_lo.m_r1 = r0 >> 1;
+					pDst_block->m_lo.m_g1 = g0 >> 1;
+					pDst_block->m_lo.m_b1 = b0 >> 1;
+
+					trans ^= 0xFF;
+				}
+
+				// Drop the first texel's MSB, which is 0.
+				const uint32_t sels = translate_selectors_2bit(pSelector, trans);
+				set_block_bits((uint8_t*)pDst, (sels & 1) | (sels >> 1), 31, 66);
+				return;
+			}
+
 			uint32_t output_low_selector = 0, output_bit_offset = 0, output_bits = 0;
 
 			for (uint32_t y = 0; y < 4; y++)
@@ -4272,8 +4537,8 @@ namespace basist
 
 		const uint8_t* pSelectors_xlat = &g_etc1_to_bc7_m5_selector_mappings[best_mapping][0];
 
-		uint32_t s_inv = 0;
-		if (pSelectors_xlat[pSelector->get_selector(0, 0)] & 2)
+		const uint32_t s_inv = (pSelectors_xlat[pSelector->get_selector(0, 0)] & 2) ? 3 : 0;
+		if (s_inv)
 		{
 			pDst_block->m_lo.m_r0 = pTable_r[best_mapping].m_hi;
 			pDst_block->m_lo.m_g0 = pTable_g[best_mapping].m_hi;
@@ -4282,8 +4547,6 @@ namespace basist
 			pDst_block->m_lo.m_r1 = pTable_r[best_mapping].m_lo;
 			pDst_block->m_lo.m_g1 = pTable_g[best_mapping].m_lo;
 			pDst_block->m_lo.m_b1 = pTable_b[best_mapping].m_lo;
-			
-			s_inv = 3;
 		}
 		else
 		{
@@ -4296,6 +4559,16 @@ namespace basist
 			pDst_block->m_lo.m_b1 = pTable_b[best_mapping].m_hi;
 		}
 
+		if (g_packed_selector_kernels)
+		{
+			const uint32_t trans = (pSelectors_xlat[0] | (pSelectors_xlat[1] << 2) | (pSelectors_xlat[2] << 4) | (pSelectors_xlat[3] << 6)) ^ (s_inv ? 0xFF : 0);
+
+			// Drop the first texel's MSB, which is 0.
+			const uint32_t sels = translate_selectors_2bit(pSelector, trans);
+			set_block_bits((uint8_t*)pDst, (sels & 1) | (sels >> 1), 31, 66);
+			return;
+		}
+
 		uint32_t output_bits = 0, output_bit_ofs = 0;
 
 		for (uint32_t y = 0; y < 4; y++)
@@ -4347,6 +4620,25 @@ namespace basist
 			pDst_block->m_lo.m_a1_0 = block_colors[high_selector] & 63;
 			pDst_block->m_hi.m_a1_1 = block_colors[high_selector] >> 6;
 
+			if (g_packed_selector_kernels)
+			{
+				// The low selector maps to 0, the other one to 3. The first texel's selector must have its MSB clear.
+				uint32_t trans = 0xFF ^ (3 << (low_selector * 2));
+				if (pSelector->get_selector(0, 0) != low_selector)
+				{
+					pDst_block->m_lo.m_a0 = block_colors[high_selector];
+					pDst_block->m_lo.m_a1_0 = block_colors[low_selector] & 63;
+					pDst_block->m_hi.m_a1_1 = block_colors[low_selector] >> 6;
+
+					trans ^= 0xFF;
+				}
+
+				// Drop the first texel's MSB, which is 0.
+				const uint32_t sels = translate_selectors_2bit(pSelector, trans);
+				set_block_bits((uint8_t*)pDst, (sels & 1) | (sels >> 1), 31, 97);
+				return;
+			}
+
 			uint32_t output_low_selector = 0, output_bit_offset = 0, output_bits = 0;
 
 			for (uint32_t y = 0; y < 4; y++)
@@ -4390,6 +4682,25 @@ namespace basist
 		pDst_block->m_lo.m_a1_0 = pTable->m_hi & 63;
 		pDst_block->m_hi.m_a1_1 = pTable->m_hi >> 6;
 
+		if (g_packed_selector_kernels)
+		{
+			// The first texel's selector must have its MSB clear.
+			uint32_t trans = pTable->m_trans;
+			if ((trans >> (pSelector->get_selector(0, 0) * 2)) & 2)
+			{
+				pDst_block->m_lo.m_a0 = pTable->m_hi;
+				pDst_block->m_lo.m_a1_0 = pTable->m_lo & 63;
+				pDst_block->m_hi.m_a1_1 = pTable->m_lo >> 6;
+
+				trans ^= 0xFF;
+			}
+
+			// Drop the first texel's MSB, which is 0.
+			const uint32_t sels = translate_selectors_2bit(pSelector, trans);
+			set_block_bits((uint8_t*)pDst, (sels & 1) | (sels >> 1), 31, 97);
+			return;
+		}
+
 		uint32_t output_bit_offset = 0, output_bits = 0, selector_trans = pTable->m_trans;
 
 		for (uint32_t y = 0; y < 4; y++)
@@ -4468,6 +4779,12 @@ namespace basist
 		pDst_block->m_table = pTable_entry->m_table_mul >> 4;
 		pDst_block->m_multiplier = pTable_entry->m_table_mul & 15;
 
+		if (g_packed_selector_kernels)
+		{
+			pDst_block->set_selector_bits(translate_selectors_eac(pSelector, pTable_entry->m_trans));
+			return;
+		}
+
 		uint64_t selector_bits = 0;
 
 		for (uint32_t y = 0; y < 4; y++)
@@ -4787,6 +5104,12 @@ namespace basist
 		pDst_block->m_table = pTable_entry->m_table_mul >> 4;
 		pDst_block->m_multiplier = pTable_entry->m_table_mul & 15;
 
+		if (g_packed_selector_kernels)
+		{
+			pDst_block->set_selector_bits(translate_selectors_eac(pSelector, pTable_entry->m_trans));
+			return;
+		}
+
 		uint64_t selector_bits = 0;
 
 		for (uint32_t y = 0; y < 4; y++)
@@ -7642,6 +7965,16 @@ namespace basist
 			{
 				for (uint32_t i = 0; i < num_selectors; i++)
 				{
+					if (g_packed_selector_kernels)
+					{
+						uint32_t raw = 0;
+						for (uint32_t j = 0; j < 4; j++)
+							raw |= sym_codec.get_bits(8) << (j * 8);
+
+						m_local_selectors[i].set_raw_selectors(raw);
+						continue;
+					}
+
 					for (uint32_t j = 0; j < 4; j++)
 					{
 						uint32_t cur_byte = sym_codec.get_bits(8);
@@ -7671,6 +8004,20 @@ namespace basist
 
 				for (uint32_t i = 0; i < num_selectors; i++)
 				{
+					if (g_packed_selector_kernels)
+					{
+						uint32_t raw = 0;
+						for (uint32_t j = 0; j < 4; j++)
+						{
+							uint32_t cur_byte = i ? (sym_codec.decode_huffman(delta_selector_pal_model) ^ prev_bytes[j]) : sym_codec.get_bits(8);
+							prev_bytes[j] = static_cast<uint8_t>(cur_byte);
+							raw |= cur_byte << (j * 8);
+						}
+
+						m_local_selectors[i].set_raw_selectors(raw);
+						continue;
+					}
+
 					if (!i)
 					{
 						for (uint32_t j = 0; j < 4; j++)
@@ -8315,71 +8662,21 @@ namespace basist
 				{
 					assert(sizeof(uint32_t) == output_block_or_pixel_stride_in_bytes);
 					uint8_t* pDst_pixels = static_cast<uint8_t*>(pDst_blocks) + (block_x * 4 + block_y * 4 * output_row_pitch_in_blocks_or_pixels) * sizeof(uint32_t);
-										
+
 					const uint32_t max_x = basisu::minimum<int>(4, (int)output_row_pitch_in_blocks_or_pixels - (int)block_x * 4);
 					const uint32_t max_y = basisu::minimum<int>(4, (int)output_rows_in_pixels - (int)block_y * 4);
-					
+
 					int colors[4];
 					decoder_etc_block::get_block_colors5_g(colors, pEndpoints->m_color5, pEndpoints->m_inten5);
 
-					if (max_x == 4)
-					{
-						for (uint32_t y = 0; y < max_y; y++)
-						{
-							const uint32_t s = pSelector->m_selectors[y];
-
-							pDst_pixels[3] = static_cast<uint8_t>(colors[s & 3]);
-							pDst_pixels[3+4] = static_cast<uint8_t>(colors[(s >> 2) & 3]);
-							pDst_pixels[3+8] = static_cast<uint8_t>(colors[(s >> 4) & 3]);
-							pDst_pixels[3+12] = static_cast<uint8_t>(colors[(s >> 6) & 3]);
-							
-							pDst_pixels += output_row_pitch_in_blocks_or_pixels * sizeof(uint32_t);
-						}
-					}
-					else
-					{
-						for (uint32_t y = 0; y < max_y; y++)
-						{
-							const uint32_t s = pSelector->m_selectors[y];
-
-							for (uint32_t x = 0; x < max_x; x++)
-								pDst_pixels[3 + 4 * x] = static_cast<uint8_t>(colors[(s >> (x * 2)) & 3]);
-
-							pDst_pixels += output_row_pitch_in_blocks_or_pixels * sizeof(uint32_t);
-						}
-					}
+					uint32_t packed_colors[4];
+					for (uint32_t i = 0; i < 4; i++)
+						packed_colors[i] = color32(0, 0, 0, colors[i]).m;
 
+					write_selected_pixels(pDst_pixels, output_row_pitch_in_blocks_or_pixels * sizeof(uint32_t), pSelector, packed_colors, max_x, max_y, color32(255, 255, 255, 0).m);
 					break;
 				}
 				case block_format::cRGB32:
-				{
-					assert(sizeof(uint32_t) == output_block_or_pixel_stride_in_bytes);
-					uint8_t* pDst_pixels = static_cast<uint8_t*>(pDst_blocks) + (block_x * 4 + block_y * 4 * output_row_pitch_in_blocks_or_pixels) * sizeof(uint32_t);
-
-					const uint32_t max_x = basisu::minimum<int>(4, (int)output_row_pitch_in_blocks_or_pixels - (int)block_x * 4);
-					const uint32_t max_y = basisu::minimum<int>(4, (int)output_rows_in_pixels - (int)block_y * 4);
-
-					color32 colors[4];
-					decoder_etc_block::get_block_colors5(colors, pEndpoints->m_color5, pEndpoints->m_inten5);
-					
-					for (uint32_t y = 0; y < max_y; y++)
-					{
-						const uint32_t s = pSelector->m_selectors[y];
-
-						for (uint32_t x = 0; x < max_x; x++)
-						{
-							const color32& c = colors[(s >> (x * 2)) & 3];
-
-							pDst_pixels[0 + 4 * x] = c.r;
-							pDst_pixels[1 + 4 * x] = c.g;
-							pDst_pixels[2 + 4 * x] = c.b;
-						}
-
-						pDst_pixels += output_row_pitch_in_blocks_or_pixels * sizeof(uint32_t);
-					}
-
-					break;
-				}
 				case block_format::cRGBA32:
 				{
 					assert(sizeof(uint32_t) == output_block_or_pixel_stride_in_bytes);
@@ -8391,23 +8688,14 @@ namespace basist
 					color32 colors[4];
 					decoder_etc_block::get_block_colors5(colors, pEndpoints->m_color5, pEndpoints->m_inten5);
 
-					for (uint32_t y = 0; y < max_y; y++)
-					{
-						const uint32_t s = pSelector->m_selectors[y];
-
-						for (uint32_t x = 0; x < max_x; x++)
-						{
-							const color32& c = colors[(s >> (x * 2)) & 3];
+					// RGB32 keeps the alpha already in the output.
+					const uint32_t a = (fmt == block_format::cRGBA32) ? 255 : 0;
 
-							pDst_pixels[0 + 4 * x] = c.r;
-							pDst_pixels[1 + 4 * x] = c.g;
-							pDst_pixels[2 + 4 * x] = c.b;
-							pDst_pixels[3 + 4 * x] = 255;
-						}
-
-						pDst_pixels += output_row_pitch_in_blocks_or_pixels * sizeof(uint32_t);
-					}
+					uint32_t packed_colors[4];
+					for (uint32_t i = 0; i < 4; i++)
+						packed_colors[i] = color32(colors[i].r, colors[i].g, colors[i].b, a).m;
 
+					write_selected_pixels(pDst_pixels, output_row_pitch_in_blocks_or_pixels * sizeof(uint32_t), pSelector, packed_colors, max_x, max_y, a ? 0 : color32(0, 0, 0, 255).m);
 					break;
 				}
 				case block_format::cRGB565:
@@ -8442,58 +8730,10 @@ namespace basist
 						}
 					}
 
-					for (uint32_t y = 0; y < max_y; y++)
-					{
-						const uint32_t s = pSelector->m_selectors[y];
-
-						for (uint32_t x = 0; x < max_x; x++)
-							reinterpret_cast<uint16_t *>(pDst_pixels)[x] = packed_colors[(s >> (x * 2)) & 3];
-
-						pDst_pixels += output_row_pitch_in_blocks_or_pixels * sizeof(uint16_t);
-					}
-
+					write_selected_pixels(pDst_pixels, output_row_pitch_in_blocks_or_pixels * sizeof(uint16_t), pSelector, packed_colors, max_x, max_y);
 					break;
 				}
 				case block_format::cRGBA4444_COLOR:
-				{
-					assert(sizeof(uint16_t) == output_block_or_pixel_stride_in_bytes);
-					uint8_t* pDst_pixels = static_cast<uint8_t*>(pDst_blocks) + (block_x * 4 + block_y * 4 * output_row_pitch_in_blocks_or_pixels) * sizeof(uint16_t);
-
-					const uint32_t max_x = basisu::minimum<int>(4, (int)output_row_pitch_in_blocks_or_pixels - (int)block_x * 4);
-					const uint32_t max_y = basisu::minimum<int>(4, (int)output_rows_in_pixels - (int)block_y * 4);
-
-					color32 colors[4];
-					decoder_etc_block::get_block_colors5(colors, pEndpoints->m_color5, pEndpoints->m_inten5);
-
-					uint16_t packed_colors[4];
-					for (uint32_t i = 0; i < 4; i++)
-					{
-						packed_colors[i] = static_cast<uint16_t>((mul_8(colors[i].r, 15) << 12) | (mul_8(colors[i].g, 15) << 8) | (mul_8(colors[i].b, 15) << 4));
-					}
-
-					for (uint32_t y = 0; y < max_y; y++)
-					{
-						const uint32_t s = pSelector->m_selectors[y];
-
-						for (uint32_t x = 0; x < max_x; x++)
-						{
-							uint16_t cur = reinterpret_cast<uint16_t*>(pDst_pixels)[x];
-							if (BASISD_IS_BIG_ENDIAN)
-								cur = byteswap_uint16(cur);
-
-							cur = (cur & 0xF) | packed_colors[(s >> (x * 2)) & 3];
-							
-							if (BASISD_IS_BIG_ENDIAN)
-								cur = byteswap_uint16(cur);
-
-							reinterpret_cast<uint16_t*>(pDst_pixels)[x] = cur;
-						}
-
-						pDst_pixels += output_row_pitch_in_blocks_or_pixels * sizeof(uint16_t);
-					}
-
-					break;
-				}
 				case block_format::cRGBA4444_COLOR_OPAQUE:
 				{
 					assert(sizeof(uint16_t) == output_block_or_pixel_stride_in_bytes);
@@ -8505,24 +8745,21 @@ namespace basist
 					color32 colors[4];
 					decoder_etc_block::get_block_colors5(colors, pEndpoints->m_color5, pEndpoints->m_inten5);
 
+					// The non-opaque variant keeps the alpha nibble already in the output.
+					const bool opaque = (fmt == block_format::cRGBA4444_COLOR_OPAQUE);
+					uint16_t keep_mask = opaque ? 0 : 0xF;
+					if (BASISD_IS_BIG_ENDIAN)
+						keep_mask = byteswap_uint16(keep_mask);
+
 					uint16_t packed_colors[4];
 					for (uint32_t i = 0; i < 4; i++)
 					{
-						packed_colors[i] = static_cast<uint16_t>((mul_8(colors[i].r, 15) << 12) | (mul_8(colors[i].g, 15) << 8) | (mul_8(colors[i].b, 15) << 4) | 0xF);
+						packed_colors[i] = static_cast<uint16_t>((mul_8(colors[i].r, 15) << 12) | (mul_8(colors[i].g, 15) << 8) | (mul_8(colors[i].b, 15) << 4) | (opaque ? 0xF : 0));
 						if (BASISD_IS_BIG_ENDIAN)
 							packed_colors[i] = byteswap_uint16(packed_colors[i]);
 					}
 
-					for (uint32_t y = 0; y < max_y; y++)
-					{
-						const uint32_t s = pSelector->m_selectors[y];
-
-						for (uint32_t x = 0; x < max_x; x++)
-							reinterpret_cast<uint16_t*>(pDst_pixels)[x] = packed_colors[(s >> (x * 2)) & 3];
-
-						pDst_pixels += output_row_pitch_in_blocks_or_pixels * sizeof(uint16_t);
-					}
-
+					write_selected_pixels(pDst_pixels, output_row_pitch_in_blocks_or_pixels * sizeof(uint16_t), pSelector, packed_colors, max_x, max_y, keep_mask);
 					break;
 				}
 				case block_format::cRGBA4444_ALPHA:
@@ -8544,18 +8781,7 @@ namespace basist
 							packed_colors[i] = byteswap_uint16(packed_colors[i]);
 					}
 
-					for (uint32_t y = 0; y < max_y; y++)
-					{
-						const uint32_t s = pSelector->m_selectors[y];
-
-						for (uint32_t x = 0; x < max_x; x++)
-						{
-							reinterpret_cast<uint16_t*>(pDst_pixels)[x] = packed_colors[(s >> (x * 2)) & 3];
-						}
-
-						pDst_pixels += output_row_pitch_in_blocks_or_pixels * sizeof(uint16_t);
-					}
-
+					write_selected_pixels(pDst_pixels, output_row_pitch_in_blocks_or_pixels * sizeof(uint16_t), pSelector, packed_colors, max_x, max_y);
 					break;
 				}
 				case block_format::cETC2_EAC_R11:
@@ -9398,15 +9624,10 @@ namespace basist
 
 						for (uint32_t y = 0; y < max_y; y++)
 						{
-							for (uint32_t x = 0; x < max_x; x++)
-							{
-								const color32& c = block_pixels[y][x];
-
-								pDst_pixels[0 + 4 * x] = c.r;
-								pDst_pixels[1 + 4 * x] = c.g;
-								pDst_pixels[2 + 4 * x] = c.b;
-								pDst_pixels[3 + 4 * x] = c.a;
-							}
+							if (max_x == 4)
+								memcpy(pDst_pixels, block_pixels[y], sizeof(block_pixels[y]));
+							else
+								memcpy(pDst_pixels, block_pixels[y], max_x * sizeof(color32));
 
 							pDst_pixels += output_row_pitch_in_blocks_or_pixels * sizeof(uint32_t);
 						}
@@ -9415,34 +9636,6 @@ namespace basist
 					}
 					case block_format::cRGB565:
 					case block_format::cBGR565:
-					{
-						color32 block_pixels[4][4];
-						status = unpack_uastc(*pSource_block, (color32*)block_pixels, false);
-
-						assert(sizeof(uint16_t) == output_block_or_pixel_stride_in_bytes);
-						uint8_t* pDst_pixels = static_cast<uint8_t*>(pDst_blocks) + (block_x * 4 + block_y * 4 * output_row_pitch_in_blocks_or_pixels) * sizeof(uint16_t);
-
-						const uint32_t max_x = basisu::minimum<int>(4, (int)output_row_pitch_in_blocks_or_pixels - (int)block_x * 4);
-						const uint32_t max_y = basisu::minimum<int>(4, (int)output_rows_in_pixels - (int)block_y * 4);
-
-						for (uint32_t y = 0; y < max_y; y++)
-						{
-							for (uint32_t x = 0; x < max_x; x++)
-							{
-								const color32& c = block_pixels[y][x];
-
-								const uint16_t packed = (fmt == block_format::cRGB565) ? static_cast<uint16_t>((mul_8(c.r, 31) << 11) | (mul_8(c.g, 63) << 5) | mul_8(c.b, 31)) :
-									static_cast<uint16_t>((mul_8(c.b, 31) << 11) | (mul_8(c.g, 63) << 5) | mul_8(c.r, 31));
-
-								pDst_pixels[x * 2 + 0] = (uint8_t)(packed & 0xFF);
-								pDst_pixels[x * 2 + 1] = (uint8_t)((packed >> 8) & 0xFF);
-							}
-
-							pDst_pixels += output_row_pitch_in_blocks_or_pixels * sizeof(uint16_t);
-						}
-
-						break;
-					}
 					case block_format::cRGBA4444:
 					{
 						color32 block_pixels[4][4];
@@ -9454,20 +9647,14 @@ namespace basist
 						const uint32_t max_x = basisu::minimum<int>(4, (int)output_row_pitch_in_blocks_or_pixels - (int)block_x * 4);
 						const uint32_t max_y = basisu::minimum<int>(4, (int)output_rows_in_pixels - (int)block_y * 4);
 
-						for (uint32_t y = 0; y < max_y; y++)
-						{
-							for (uint32_t x = 0; x < max_x; x++)
-							{
-								const color32& c = block_pixels[y][x];
-
-								const uint16_t packed = static_cast<uint16_t>((mul_8(c.r, 15) << 12) | (mul_8(c.g, 15) << 8) | (mul_8(c.b, 15) << 4) | mul_8(c.a, 15));
+						static const uint16_t s_scale_565[4] = { 31, 63, 31, 0 }, s_scale_4444[4] = { 15, 15, 15, 15 };
+						static const uint16_t s_weight_rgb565[4] = { 1 << 11, 1 << 5, 1, 0 }, s_weight_bgr565[4] = { 1, 1 << 5, 1 << 11, 0 }, s_weight_4444[4] = { 1 << 12, 1 << 8, 1 << 4, 1 };
 
-								pDst_pixels[x * 2 + 0] = (uint8_t)(packed & 0xFF);
-								pDst_pixels[x * 2 + 1] = (uint8_t)((packed >> 8) & 0xFF);
-							}
+						if (fmt == block_format::cRGBA4444)
+							pack_block_pixels_16(&block_pixels[0][0], pDst_pixels, output_row_pitch_in_blocks_or_pixels * sizeof(uint16_t), max_x, max_y, s_scale_4444, s_weight_4444);
+						else
+							pack_block_pixels_16(&block_pixels[0][0], pDst_pixels, output_row_pitch_in_blocks_or_pixels * sizeof(uint16_t), max_x, max_y, s_scale_565, (fmt == block_format::cRGB565) ? s_weight_rgb565 : s_weight_bgr565);
 
-							pDst_pixels += output_row_pitch_in_blocks_or_pixels * sizeof(uint16_t);
-						}
 						break;
 					}
 					default:
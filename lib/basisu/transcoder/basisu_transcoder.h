@@ -550,6 +550,12 @@ namespace basist
 	uint32_t get_debug_flags();
 	void set_debug_flags(uint32_t f);
 
+	// ETC1S selectors are unpacked and translated to the output format's selectors with packed kernels that handle all 16 selectors
+	// of a block at once. Disabling them selects the original per-texel code, which produces identical output. Don't change this
+	// while transcoding.
+	bool get_packed_selector_kernels();
+	void set_packed_selector_kernels(bool enabled);
+
 	// ------------------------------------------------------------------------------------------------------ 
 	// Optional .KTX2 file format support
 	// KTX2 reading optionally requires miniz or Zstd decompressors for supercompressed UASTC files.
@@ -703,6 +703,25 @@ namespace basist
 		bool operator!= (const endpoint& rhs) const { return !(*this == rhs); }
 	};
 
+	// Gathers bit 2i of v into bit i, i.e. one bit of each of the 16 2-bit selectors packed in v.
+	inline uint32_t compact_even_bits(uint32_t v)
+	{
+		v &= 0x55555555;
+		v = (v | (v >> 1)) & 0x33333333;
+		v = (v | (v >> 2)) & 0x0F0F0F0F;
+		v = (v | (v >> 4)) & 0x00FF00FF;
+		return (v | (v >> 8)) & 0x0000FFFF;
+	}
+
+	// Transposes a 4x4 bit matrix stored row major in the low 16 bits of v, so bit y*4+x moves to bit x*4+y.
+	inline uint32_t transpose_4x4_bits(uint32_t v)
+	{
+		uint32_t t = (v ^ (v >> 3)) & 0x0A0A;
+		v ^= t ^ (t << 3);
+		t = (v ^ (v >> 6)) & 0x00CC;
+		return v ^ t ^ (t << 6);
+	}
+
 	struct selector
 	{
 		// Plain selectors (2-bits per value)
@@ -752,6 +771,42 @@ namespace basist
 			}
 		}
 
+		// Sets all 16 selectors from their raw form, row y in bits [y*8, y*8+7] and 2 bits per texel, then updates the flags.
+		// Same result as calling set_selector() for each texel followed by init_flags(), but works on all texels at once.
+		void set_raw_selectors(uint32_t raw)
+		{
+			m_selectors[0] = static_cast<uint8_t>(raw);
+			m_selectors[1] = static_cast<uint8_t>(raw >> 8);
+			m_selectors[2] = static_cast<uint8_t>(raw >> 16);
+			m_selectors[3] = static_cast<uint8_t>(raw >> 24);
+
+			// Low and high bit of each selector, one bit per texel in raster order.
+			const uint32_t l = compact_even_bits(raw);
+			const uint32_t h = compact_even_bits(raw >> 1);
+
+			// Selectors 0-3 are ETC1 selectors 3, 2, 0, 1: the ETC1 MSB is the inverted high bit and the
+			// LSB is set for selectors 0 and 3. ETC1 orders the texels column major.
+			const uint32_t etc1_msb = transpose_4x4_bits(~h & 0xFFFF);
+			const uint32_t etc1_lsb = transpose_4x4_bits(~(h ^ l) & 0xFFFF);
+
+			m_bytes[0] = static_cast<uint8_t>(etc1_msb >> 8);
+			m_bytes[1] = static_cast<uint8_t>(etc1_msb);
+			m_bytes[2] = static_cast<uint8_t>(etc1_lsb >> 8);
+			m_bytes[3] = static_cast<uint8_t>(etc1_lsb);
+
+			const uint32_t used = ((~(h | l) & 0xFFFF) ? 1 : 0) | ((l & ~h) ? 2 : 0) | ((h & ~l) ? 4 : 0) | ((h & l) ? 8 : 0);
+
+			m_lo_selector = static_cast<uint8_t>((used & 1) ? 0 : ((used & 2) ? 1 : ((used & 4) ? 2 : 3)));
+			m_hi_selector = static_cast<uint8_t>((used & 8) ? 3 : ((used & 4) ? 2 : ((used & 2) ? 1 : 0)));
+			m_num_unique_selectors = static_cast<uint8_t>((used & 1) + ((used >> 1) & 1) + ((used >> 2) & 1) + (used >> 3));
+		}
+
+		// Returns the raw selectors, row y in bits [y*8, y*8+7] and 2 bits per texel.
+		inline uint32_t get_raw_selectors() const
+		{
+			return m_selectors[0] | (m_selectors[1] << 8) | (m_selectors[2] << 16) | (static_cast<uint32_t>(m_selectors[3]) << 24);
+		}
+
 		// Returned selector value ranges from 0-3 and is a direct index into g_etc1_inten_tables.
 		inline uint32_t get_selector(uint32_t x, uint32_t y) const
 		{
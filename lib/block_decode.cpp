@@ -0,0 +1,516 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2010-2020 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file block_decode.cpp
+ * @~English
+ *
+ * @brief Function for decoding block-compressed images to 8-bit
+ *        uncompressed images so they can be re-encoded.
+ *
+ * BCn blocks are decoded with the basisu GPU texture unpackers, ETC2 and
+ * EAC blocks with the ETC decoder also used by the OpenGL loader's
+ * software unpacker and ASTC blocks with astcenc.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <KHR/khr_df.h>
+
+#include "ktx.h"
+#include "ktxint.h"
+#include "texture2.h"
+#include "vkformat_enum.h"
+#include "block_decode.h"
+
+#include "basisu/transcoder/basisu_transcoder.h"
+#include "basisu/transcoder/basisu_transcoder_uastc.h"
+#include "astc-encoder/Source/astcenc.h"
+
+// From etcdec.cxx.
+typedef unsigned int uint;
+typedef unsigned char uint8;
+
+extern void decompressBlockETC2c(uint block_part1, uint block_part2, uint8* img,
+                                 int width, int height, int startx, int starty,
+                                 int channels);
+extern void decompressBlockETC21BitAlphaC(uint block_part1, uint block_part2,
+                                          uint8* img, uint8* alphaimg,
+                                          int width, int height,
+                                          int startx, int starty,
+                                          int channels);
+extern void decompressBlockAlphaC(uint8* data, uint8* img,
+                                  int width, int height, int startx, int starty,
+                                  int channels);
+extern void setupAlphaTable();
+
+using basisu::color_rgba;
+
+namespace {
+
+inline uint
+readBigEndian4byteWord(const ktx_uint8_t* s)
+{
+    return ((uint)s[0] << 24) | ((uint)s[1] << 16) | ((uint)s[2] << 8) | s[3];
+}
+
+} // namespace
+
+bool
+lookupBlockCodec(VkFormat vkFormat, blockCodec& codec,
+                 ktx_uint32_t& numComponents)
+{
+    switch (vkFormat) {
+      case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+      case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        codec = blockCodec::bc1; numComponents = 3; return true;
+      case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+      case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        codec = blockCodec::bc1a; numComponents = 4; return true;
+      case VK_FORMAT_BC2_UNORM_BLOCK:
+      case VK_FORMAT_BC2_SRGB_BLOCK:
+        codec = blockCodec::bc2; numComponents = 4; return true;
+      case VK_FORMAT_BC3_UNORM_BLOCK:
+      case VK_FORMAT_BC3_SRGB_BLOCK:
+        codec = blockCodec::bc3; numComponents = 4; return true;
+      case VK_FORMAT_BC4_UNORM_BLOCK:
+        codec = blockCodec::bc4; numComponents = 1; return true;
+      case VK_FORMAT_BC5_UNORM_BLOCK:
+        codec = blockCodec::bc5; numComponents = 2; return true;
+      case VK_FORMAT_BC7_UNORM_BLOCK:
+      case VK_FORMAT_BC7_SRGB_BLOCK:
+        codec = blockCodec::bc7; numComponents = 4; return true;
+      case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+      case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+        codec = blockCodec::etc2; numComponents = 3; return true;
+      case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+      case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+        codec = blockCodec::etc2a1; numComponents = 4; return true;
+      case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+      case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+        codec = blockCodec::etc2a8; numComponents = 4; return true;
+      case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+        codec = blockCodec::eacR11; numComponents = 1; return true;
+      case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+        codec = blockCodec::eacRG11; numComponents = 2; return true;
+      default:
+        // The LDR 2D ASTC formats are contiguous and alternate UNORM, SRGB.
+        if (vkFormat >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK
+            && vkFormat <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK) {
+            codec = blockCodec::astc; numComponents = 4; return true;
+        }
+        return false;
+    }
+}
+
+void
+initBlockDecoders()
+{
+    static std::once_flag once;
+    std::call_once(once, [] {
+        setupAlphaTable();
+        basist::basisu_transcoder_init();
+    });
+}
+
+bool
+decodeBlock(blockCodec codec, const ktx_uint8_t* block, bool sRGB,
+            color_rgba* pixels)
+{
+    uint8* rgba = reinterpret_cast<uint8*>(pixels);
+
+    switch (codec) {
+      case blockCodec::bc1:
+        basisu::unpack_bc1(block, pixels, false);
+        break;
+      case blockCodec::bc1a:
+        basisu::unpack_bc1(block, pixels, true);
+        break;
+      case blockCodec::bc2:
+        // Explicit 4-bit alpha followed by a BC1 color block.
+        basisu::unpack_bc1(block + 8, pixels, false);
+        for (uint32_t i = 0; i < 16; i++) {
+            uint8 a = (block[i / 2] >> ((i & 1) * 4)) & 0xf;
+            pixels[i].a = (uint8)(a | (a << 4));
+        }
+        break;
+      case blockCodec::bc3:
+        basisu::unpack_bc3(block, pixels);
+        break;
+      case blockCodec::bc4:
+        basisu::unpack_bc4(block, &pixels[0].r, sizeof(color_rgba));
+        break;
+      case blockCodec::bc5:
+        basisu::unpack_bc5(block, pixels);
+        break;
+      case blockCodec::bc7:
+        basisu::unpack_bc7(block, pixels);
+        break;
+      case blockCodec::etc2:
+        decompressBlockETC2c(readBigEndian4byteWord(block),
+                             readBigEndian4byteWord(block + 4),
+                             rgba, 4, 4, 0, 0, 4);
+        break;
+      case blockCodec::etc2a1:
+        decompressBlockETC21BitAlphaC(readBigEndian4byteWord(block),
+                                      readBigEndian4byteWord(block + 4),
+                                      rgba, nullptr, 4, 4, 0, 0, 4);
+        break;
+      case blockCodec::etc2a8:
+        decompressBlockAlphaC(const_cast<uint8*>(block), rgba + 3,
+                              4, 4, 0, 0, 4);
+        decompressBlockETC2c(readBigEndian4byteWord(block + 8),
+                             readBigEndian4byteWord(block + 12),
+                             rgba, 4, 4, 0, 0, 4);
+        break;
+      case blockCodec::eacR11:
+        basisu::unpack_etc2_eac_r(block, pixels, 0);
+        break;
+      case blockCodec::eacRG11:
+        basisu::unpack_etc2_eac_rg(block, pixels);
+        break;
+      case blockCodec::uastc:
+        return basist::unpack_uastc(
+                     *reinterpret_cast<const basist::uastc_block*>(block),
+                     reinterpret_cast<basist::color32*>(pixels), sRGB);
+      case blockCodec::astc:
+        assert(false && "ASTC is decoded with astcenc.");
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+struct decodeImageDesc {
+    ktx_uint32_t width;
+    ktx_uint32_t height;
+    ktx_size_t srcOffset;
+    ktx_size_t srcSize;
+    ktx_size_t dstOffset;
+};
+
+struct decodeJob {
+    blockCodec codec;
+    ktx_uint32_t blockWidth;
+    ktx_uint32_t blockHeight;
+    ktx_uint32_t blockBytes;
+    ktx_uint32_t numComponents;
+    bool sRGB;
+    const ktx_uint8_t* src;
+    ktx_uint8_t* dst;
+    std::vector<decodeImageDesc> images;
+    std::atomic<ktx_uint32_t> nextImage;
+    std::vector<KTX_error_code> results;
+};
+
+VkFormat
+uncompressedFormat(ktx_uint32_t numComponents, bool sRGB)
+{
+    switch (numComponents) {
+      case 1: return sRGB ? VK_FORMAT_R8_SRGB : VK_FORMAT_R8_UNORM;
+      case 2: return sRGB ? VK_FORMAT_R8G8_SRGB : VK_FORMAT_R8G8_UNORM;
+      case 3: return sRGB ? VK_FORMAT_R8G8B8_SRGB : VK_FORMAT_R8G8B8_UNORM;
+      default: return sRGB ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+    }
+}
+
+/* Copy a w x h RGBA region to the output keeping numComponents. */
+void
+storePixels(const color_rgba* pixels, ktx_uint32_t pixelsPitch,
+            ktx_uint32_t w, ktx_uint32_t h,
+            ktx_uint8_t* dst, ktx_uint32_t dstPitch,
+            ktx_uint32_t numComponents)
+{
+    for (ktx_uint32_t y = 0; y < h; y++) {
+        const ktx_uint8_t* s =
+            reinterpret_cast<const ktx_uint8_t*>(pixels + y * pixelsPitch);
+        ktx_uint8_t* d = dst + (ktx_size_t)y * dstPitch;
+        if (numComponents == 4) {
+            memcpy(d, s, w * 4);
+        } else {
+            for (ktx_uint32_t x = 0; x < w; x++)
+                for (ktx_uint32_t c = 0; c < numComponents; c++)
+                    d[x * numComponents + c] = s[x * 4 + c];
+        }
+    }
+}
+
+KTX_error_code
+decodeBlocks(const decodeJob& job, const decodeImageDesc& image)
+{
+    ktx_uint32_t blocksX = (image.width + 3) / 4;
+    ktx_uint32_t blocksY = (image.height + 3) / 4;
+    ktx_uint32_t dstPitch = image.width * job.numComponents;
+    const ktx_uint8_t* block = job.src + image.srcOffset;
+    ktx_uint8_t* dst = job.dst + image.dstOffset;
+    color_rgba pixels[16];
+
+    if ((ktx_size_t)blocksX * blocksY * job.blockBytes != image.srcSize)
+        return KTX_FILE_DATA_ERROR;
+
+    for (ktx_uint32_t by = 0; by < blocksY; by++) {
+        for (ktx_uint32_t bx = 0; bx < blocksX; bx++) {
+            for (auto& p : pixels)
+                p.set(0, 0, 0, 255);
+            decodeBlock(job.codec, block, job.sRGB, pixels);
+            block += job.blockBytes;
+            storePixels(pixels, 4,
+                        std::min(4U, image.width - bx * 4),
+                        std::min(4U, image.height - by * 4),
+                        dst + (ktx_size_t)by * 4 * dstPitch
+                            + bx * 4 * job.numComponents,
+                        dstPitch, job.numComponents);
+        }
+    }
+    return KTX_SUCCESS;
+}
+
+KTX_error_code
+decodeAstc(const decodeJob& job, const decodeImageDesc& image,
+           astcenc_context* context)
+{
+    std::vector<color_rgba> pixels;
+    try {
+        pixels.resize((ktx_size_t)image.width * image.height);
+    } catch (std::bad_alloc&) {
+        return KTX_OUT_OF_MEMORY;
+    }
+
+    void* slices[1] = { pixels.data() };
+    astcenc_image out;
+    out.dim_x = image.width;
+    out.dim_y = image.height;
+    out.dim_z = 1;
+    out.data_type = ASTCENC_TYPE_U8;
+    out.data = slices;
+    const astcenc_swizzle swizzle{ASTCENC_SWZ_R, ASTCENC_SWZ_G,
+                                  ASTCENC_SWZ_B, ASTCENC_SWZ_A};
+
+    astcenc_error error = astcenc_decompress_image(context,
+                                                   job.src + image.srcOffset,
+                                                   image.srcSize, &out,
+                                                   &swizzle, 0);
+    astcenc_decompress_reset(context);
+    if (error != ASTCENC_SUCCESS)
+        return KTX_FILE_DATA_ERROR;
+
+    storePixels(pixels.data(), image.width, image.width, image.height,
+                job.dst + image.dstOffset, image.width * job.numComponents,
+                job.numComponents);
+    return KTX_SUCCESS;
+}
+
+void
+decodeWorker(decodeJob* job)
+{
+    astcenc_context* context = nullptr;
+    KTX_error_code contextResult = KTX_SUCCESS;
+    ktx_uint32_t i;
+
+    if (job->codec == blockCodec::astc) {
+        astcenc_config config;
+        astcenc_error error = astcenc_config_init(
+                job->sRGB ? ASTCENC_PRF_LDR_SRGB : ASTCENC_PRF_LDR,
+                job->blockWidth, job->blockHeight, 1,
+                ASTCENC_PRE_FASTEST, ASTCENC_FLG_DECOMPRESS_ONLY, &config);
+        if (error == ASTCENC_SUCCESS)
+            error = astcenc_context_alloc(&config, 1, &context);
+        if (error != ASTCENC_SUCCESS)
+            contextResult = error == ASTCENC_ERR_OUT_OF_MEM
+                          ? KTX_OUT_OF_MEMORY : KTX_INVALID_OPERATION;
+    }
+
+    while ((i = job->nextImage++) < job->images.size()) {
+        if (contextResult != KTX_SUCCESS)
+            job->results[i] = contextResult;
+        else if (context)
+            job->results[i] = decodeAstc(*job, job->images[i], context);
+        else
+            job->results[i] = decodeBlocks(*job, job->images[i]);
+    }
+    if (context)
+        astcenc_context_free(context);
+}
+
+} // namespace
+
+/**
+ * @memberof ktxTexture2
+ * @ingroup writer
+ * @~English
+ * @brief Decode a texture with block-compressed images to 8-bit
+ *        uncompressed images.
+ *
+ * The decoded images replace the original images and the texture's fields
+ * including the DFD are modified to reflect the new state, after which the
+ * texture can be passed to ktxTexture2_CompressBasisEx() or
+ * ktxTexture2_CompressAstcEx(). The key/value data is unchanged.
+ *
+ * The following source formats are supported: the UNORM and SRGB variants
+ * of BC1, BC2, BC3, BC7, ETC2 and the 2D ASTC LDR formats and the UNORM
+ * variants of BC4, BC5 and EAC. The decoded format has the same transfer
+ * function and only as many components as the source format, i.e. R8 for
+ * BC4 and EAC R11, R8G8 for BC5 and EAC RG11, R8G8B8 for BC1 RGB and ETC2
+ * RGB and R8G8B8A8 for the rest.
+ *
+ * Images are decoded in parallel by up to @p threadCount threads.
+ *
+ * @param[in] This        pointer to the ktxTexture2 object of interest.
+ * @param[in] threadCount maximum number of threads to use. 0 is treated
+ *                        as 1.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE     @p This is NULL.
+ * @exception KTX_INVALID_OPERATION The texture's images are supercompressed
+ *                                  or are not block compressed.
+ * @exception KTX_UNSUPPORTED_TEXTURE_TYPE
+ *                                  The texture's format cannot be decoded.
+ * @exception KTX_FILE_DATA_ERROR   An image could not be decoded.
+ * @exception KTX_OUT_OF_MEMORY     Not enough memory for the decoded images.
+ */
+extern "C" KTX_error_code
+ktxTexture2_DecodeBlockCompressed(ktxTexture2* This, ktx_uint32_t threadCount)
+{
+    KTX_error_code result;
+
+    if (This == nullptr)
+        return KTX_INVALID_VALUE;
+
+    if (This->supercompressionScheme != KTX_SS_NONE || !This->isCompressed)
+        return KTX_INVALID_OPERATION;
+
+    blockCodec codec;
+    ktx_uint32_t numComponents;
+    const ktxFormatSize& formatSize = This->_protected->_formatSize;
+    if (!lookupBlockCodec((VkFormat)This->vkFormat, codec, numComponents)
+        || formatSize.blockDepth > 1)
+        return KTX_UNSUPPORTED_TEXTURE_TYPE;
+
+    if (This->pData == NULL) {
+        result = ktxTexture2_LoadImageData(This, nullptr, 0);
+        if (result != KTX_SUCCESS)
+            return result;
+    }
+
+    bool sRGB = KHR_DFDVAL(This->pDfd + 1, TRANSFER) == KHR_DF_TRANSFER_SRGB;
+    VkFormat vkFormat = uncompressedFormat(numComponents, sRGB);
+
+    // Create a prototype texture to use for calculating sizes in the target
+    // format and, as useful side effects, provide us with a properly sized
+    // data allocation and the DFD for the target format.
+    ktxTextureCreateInfo createInfo;
+    createInfo.glInternalformat = 0;
+    createInfo.vkFormat = vkFormat;
+    createInfo.baseWidth = This->baseWidth;
+    createInfo.baseHeight = This->baseHeight;
+    createInfo.baseDepth = This->baseDepth;
+    createInfo.generateMipmaps = This->generateMipmaps;
+    createInfo.isArray = This->isArray;
+    createInfo.numDimensions = This->numDimensions;
+    createInfo.numFaces = This->numFaces;
+    createInfo.numLayers = This->numLayers;
+    createInfo.numLevels = This->numLevels;
+    createInfo.pDfd = nullptr;
+
+    ktxTexture2* prototype;
+    result = ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+                                &prototype);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    decodeJob job;
+    job.codec = codec;
+    job.blockWidth = formatSize.blockWidth;
+    job.blockHeight = formatSize.blockHeight;
+    job.blockBytes = formatSize.blockSizeInBits / 8;
+    job.numComponents = numComponents;
+    job.sRGB = sRGB;
+    job.src = This->pData;
+    job.dst = prototype->pData;
+    job.nextImage = 0;
+
+    try {
+        for (ktx_uint32_t level = 0; level < This->numLevels; level++) {
+            decodeImageDesc image;
+            image.width = MAX(1, This->baseWidth >> level);
+            image.height = MAX(1, This->baseHeight >> level);
+            image.srcOffset = ktxTexture2_levelDataOffset(This, level);
+            image.srcSize = ktxTexture_calcImageSize(ktxTexture(This), level,
+                                                     KTX_FORMAT_VERSION_TWO);
+            image.dstOffset = ktxTexture2_levelDataOffset(prototype, level);
+            ktx_size_t dstSize =
+                ktxTexture_calcImageSize(ktxTexture(prototype), level,
+                                         KTX_FORMAT_VERSION_TWO);
+            ktx_uint32_t levelImages = This->numLayers * This->numFaces
+                                       * MAX(1, This->baseDepth >> level);
+            for (ktx_uint32_t i = 0; i < levelImages; i++) {
+                job.images.push_back(image);
+                image.srcOffset += image.srcSize;
+                image.dstOffset += dstSize;
+            }
+        }
+        job.results.resize(job.images.size(), KTX_SUCCESS);
+    } catch (std::bad_alloc&) {
+        ktxTexture2_Destroy(prototype);
+        return KTX_OUT_OF_MEMORY;
+    }
+
+    if (codec == blockCodec::etc2a8)
+        initBlockDecoders();
+
+    threadCount = std::max(1U, std::min(threadCount,
+                                        (ktx_uint32_t)job.images.size()));
+    std::vector<std::thread> threads;
+    try {
+        for (ktx_uint32_t i = 1; i < threadCount; i++)
+            threads.emplace_back(decodeWorker, &job);
+    } catch (std::system_error&) {
+        // Continue with the threads that were started.
+    }
+    decodeWorker(&job);
+    for (auto& thread : threads)
+        thread.join();
+
+    for (KTX_error_code imageResult : job.results) {
+        if (imageResult != KTX_SUCCESS) {
+            ktxTexture2_Destroy(prototype);
+            return imageResult;
+        }
+    }
+
+    // Fix up the current (This) texture.
+    ktxTexture2_private& protoPriv = *prototype->_private;
+    memcpy(&This->_protected->_formatSize,
+           &prototype->_protected->_formatSize, sizeof(ktxFormatSize));
+    This->vkFormat = vkFormat;
+    This->isCompressed = prototype->isCompressed;
+    This->_private->_requiredLevelAlignment =
+                                    protoPriv._requiredLevelAlignment;
+    memcpy(This->_private->_levelIndex, protoPriv._levelIndex,
+           This->numLevels * sizeof(ktxLevelIndexEntry));
+    // Move the DFD and data from the prototype to This.
+    free(This->pDfd);
+    This->pDfd = prototype->pDfd;
+    prototype->pDfd = 0;
+    ktxTexture2_freeData(This);
+    This->pData = prototype->pData;
+    This->dataSize = prototype->dataSize;
+    prototype->pData = 0;
+    prototype->dataSize = 0;
+
+    ktxTexture2_Destroy(prototype);
+    return KTX_SUCCESS;
+}
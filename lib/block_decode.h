@@ -0,0 +1,51 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2010-2020 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file block_decode.h
+ * @~English
+ *
+ * @brief Internal interface to the single block decoders shared by
+ *        ktxTexture2_DecodeBlockCompressed() and the texture sampler.
+ */
+
+#ifndef BLOCK_DECODE_H
+#define BLOCK_DECODE_H
+
+#include "ktx.h"
+#include "vkformat_enum.h"
+
+#include "basisu/encoder/basisu_gpu_texture.h"
+
+enum class blockCodec { bc1, bc1a, bc2, bc3, bc4, bc5, bc7,
+                        etc2, etc2a1, etc2a8, eacR11, eacRG11, astc, uastc };
+
+/*
+ * Map @p vkFormat to a codec and the number of components it decodes to.
+ * Returns false for formats that cannot be decoded to 8-bit UNORM. UASTC,
+ * which has no VkFormat, is never returned.
+ */
+bool lookupBlockCodec(VkFormat vkFormat, blockCodec& codec,
+                      ktx_uint32_t& numComponents);
+
+/*
+ * Make the tables the decoders need before decoding ETC2 with alpha or
+ * UASTC blocks. Only the first call does any work. Thread safe.
+ */
+void initBlockDecoders();
+
+/*
+ * Decode a 4x4 block to RGBA. Components the codec does not produce are
+ * left as they are in @p pixels. @p sRGB only affects UASTC. ASTC blocks
+ * must be decoded with astcenc. Returns false if the block is invalid.
+ */
+bool decodeBlock(blockCodec codec, const ktx_uint8_t* block, bool sRGB,
+                 basisu::color_rgba* pixels);
+
+#endif /* BLOCK_DECODE_H */
@@ -17,6 +17,10 @@
  * @author Mark Callow, HI Corporation
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+  #define _GNU_SOURCE 1    // For O_DIRECT.
+#endif
+
 #include <assert.h>
 #include <errno.h>
 #include <inttypes.h>
@@ -30,6 +34,10 @@
 #include <sys/types.h>     // For stat.h on Windows
 #define __USE_MISC 1       // For declaration of S_IF...
 #include <sys/stat.h>
+#if !defined(_WIN32)
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
 
 #include "ktx.h"
 #include "ktxint.h"
@@ -338,6 +346,87 @@ KTX_error_code ktxFileStream_getsize(ktxStream* str, ktx_size_t* size)
     return KTX_SUCCESS;
 }
 
+/**
+ * @~English
+ * @brief Read bytes from a ktxFileStream bypassing the system's file cache.
+ *
+ * Reads with O_DIRECT or F_NOCACHE, where available, straight into @p dst
+ * leaving the stream position unchanged. @p dst, @p count and @p offset must
+ * be multiples of KTX_DIRECT_IO_ALIGNMENT. Reading stops early at the end of
+ * the file.
+ *
+ * @param [in]  str     pointer to the ktxStream from which to read.
+ * @param [out] dst     pointer to the memory in which to read.
+ * @param [in]  count   number of bytes to read.
+ * @param [in]  offset  file offset from which to read.
+ * @param [out] pNumRead pointer to location to write the number of bytes
+ *                      read.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_OPERATION direct reads are not supported by the
+ *                                  platform or the file's file system. The
+ *                                  caller should use an ordinary read.
+ * @exception KTX_FILE_READ_ERROR  an error occurred while reading the file.
+ */
+KTX_error_code
+ktxFileStream_readDirect(ktxStream* str, void* dst, ktx_size_t count,
+                         ktx_off_t offset, ktx_size_t* pNumRead)
+{
+    assert(str && str->type == eStreamTypeFile);
+    assert((uintptr_t)dst % KTX_DIRECT_IO_ALIGNMENT == 0);
+    assert(count % KTX_DIRECT_IO_ALIGNMENT == 0);
+    assert(offset % KTX_DIRECT_IO_ALIGNMENT == 0);
+
+    *pNumRead = 0;
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__) \
+    && (defined(O_DIRECT) || defined(F_NOCACHE))
+    {
+        int fd = fileno(str->data.file);
+        int flags = fcntl(fd, F_GETFL);
+        KTX_error_code result = KTX_SUCCESS;
+        ktx_size_t numRead = 0;
+
+        if (flags == -1)
+            return KTX_INVALID_OPERATION;
+#if defined(O_DIRECT)
+        if (fcntl(fd, F_SETFL, flags | O_DIRECT) == -1)
+            return KTX_INVALID_OPERATION;
+#else
+        if (fcntl(fd, F_NOCACHE, 1) == -1)
+            return KTX_INVALID_OPERATION;
+#endif
+        while (numRead < count) {
+            ssize_t n = pread(fd, (ktx_uint8_t*)dst + numRead,
+                              count - numRead, offset + numRead);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                // EINVAL on the first read means the file system does not
+                // support direct I/O.
+                result = numRead == 0 && errno == EINVAL
+                       ? KTX_INVALID_OPERATION : KTX_FILE_READ_ERROR;
+                break;
+            }
+            numRead += n;
+            // A partial block means the end of the file has been reached.
+            if (n == 0 || numRead % KTX_DIRECT_IO_ALIGNMENT)
+                break;
+        }
+#if defined(O_DIRECT)
+        (void)fcntl(fd, F_SETFL, flags);
+#else
+        (void)fcntl(fd, F_NOCACHE, 0);
+#endif
+        *pNumRead = numRead;
+        return result;
+    }
+#else
+    (void)dst; (void)count; (void)offset;
+    return KTX_INVALID_OPERATION;
+#endif
+}
+
 /**
  * @~English
  * @brief Initialize a ktxFileStream.
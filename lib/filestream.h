@@ -24,4 +24,14 @@ KTX_error_code ktxFileStream_construct(ktxStream* str, FILE* file,
 
 void ktxFileStream_destruct(ktxStream* str);
 
+/*
+ * Alignment of file offsets, sizes and buffers for ktxFileStream_readDirect.
+ * Satisfies the logical block size of the usual storage devices.
+ */
+#define KTX_DIRECT_IO_ALIGNMENT 4096
+
+KTX_error_code ktxFileStream_readDirect(ktxStream* str, void* dst,
+                                        ktx_size_t count, ktx_off_t offset,
+                                        ktx_size_t* pNumRead);
+
 #endif /* FILESTREAM_H */
@@ -16,15 +16,20 @@
 #define IMAGE_HPP
 
 #include <math.h>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
+#include <system_error>
+#include <thread>
 #include <vector>
 #include <KHR/khr_df.h>
 
-#include "argparser.h"
 #include "unused.h"
-#include "encoder/basisu_resampler.h"
-#include "encoder/basisu_resampler_filters.h"
+#include "basisu/encoder/basisu_resampler.h"
+#include "basisu/encoder/basisu_resampler_filters.h"
 
 typedef float (*OETFFunc)(float const, float const);
 
@@ -421,20 +426,6 @@ class Image {
         this->primaries = nprimaries;
     }
 
-    typedef Image* (*CreateFunction)(FILE* f, bool transformOETF,
-                                     rescale_e rescale);
-    static const std::vector<CreateFunction> CreateFunctions;
-
-    static Image* CreateFromNPBM(FILE*, bool transformOETF = true,
-                                 rescale_e rescale = eNoRescale);
-    static Image* CreateFromJPG(FILE* f, bool transformOETF = true,
-                                rescale_e rescale = eNoRescale);
-    static Image* CreateFromPNG(FILE* f, bool transformOETF = true,
-                                rescale_e rescale = eNoRescale);
-    static Image* CreateFromFile(const _tstring& name,
-                                 bool transformOETF = true,
-                                 rescale_e rescale = eNoRescale);
-
     virtual operator uint8_t*() = 0;
 
     virtual size_t getByteCount() const = 0;
@@ -447,6 +438,13 @@ class Image {
                           float filter_scale = 1.0f,
                           basisu::Resampler::Boundary_Op wrapMode
                           = basisu::Resampler::Boundary_Op::BOUNDARY_CLAMP) = 0;
+    virtual void resampleDepth(const std::vector<Image*>& src,
+                               uint32_t dst_z, uint32_t dst_depth,
+                               bool srgb = false,
+                               const char *pFilter = "lanczos4",
+                               float filter_scale = 1.0f,
+                               basisu::Resampler::Boundary_Op wrapMode
+                          = basisu::Resampler::Boundary_Op::BOUNDARY_CLAMP) = 0;
     virtual Image& yflip() = 0;
     virtual Image& transformOETF(OETFFunc decode, OETFFunc encode,
                                  float gamma = 1.0f) = 0;
@@ -686,6 +684,55 @@ class ImageT : public Image {
           delete resamplers[i];
     }
 
+    // Set this image to slice dst_z of a volume dst_depth slices deep made
+    // by resampling along z the volume whose slices are src. The slices must
+    // be images of this type and size. Filtering matches resample so the two
+    // together make a separable 3D filter.
+    virtual void resampleDepth(const std::vector<Image*>& src,
+                               uint32_t dst_z, uint32_t dst_depth,
+                               bool srgb, const char *pFilter,
+                               float filter_scale,
+                               basisu::Resampler::Boundary_Op wrapMode)
+    {
+        using namespace basisu;
+
+        assert(dst_z < dst_depth && src.size() > 0);
+        // Only the contributor list is used. It is the same for x and z.
+        Resampler resampler((int)src.size(), 1, dst_depth, 1, wrapMode,
+                            0.0f, 1.0f, pFilter, nullptr, nullptr,
+                            filter_scale, filter_scale, 0, 0);
+        checkResamplerStatus(resampler, pFilter);
+        const Resampler::Contrib_List& clist
+                                   = resampler.get_clist_x()[dst_z];
+
+        std::vector<float> srgb_to_linear_table;
+        if (srgb) {
+            srgb_to_linear_table.resize(Color::one() + 1);
+            for (uint32_t i = 0; i <= Color::one(); ++i)
+                srgb_to_linear_table[i] = decode_sRGB((float)i / Color::one());
+        }
+
+        for (uint32_t p = 0; p < getPixelCount(); ++p) {
+            for (uint32_t ci = 0; ci < getComponentCount(); ++ci) {
+                const bool linear_flag = !srgb || (ci == 3);
+                float sum = 0.0f;
+                for (uint32_t j = 0; j < clist.n; ++j) {
+                    const ImageT& slice
+                        = static_cast<const ImageT&>(*src[clist.p[j].pixel]);
+                    assert(slice.width == width && slice.height == height);
+                    const uint32_t v = slice.pixels[p][ci];
+                    sum += clist.p[j].weight
+                         * (linear_flag ? (float)v / Color::one()
+                                        : srgb_to_linear_table[v]);
+                }
+                sum = cclamp(sum, 0.0f, 1.0f);
+                if (!linear_flag)
+                    sum = encode_sRGB(sum);
+                pixels[p].set(ci, (componentType)(sum * Color::one() + .5f));
+            }
+        }
+    }
+
     virtual ImageT& yflip() {
         uint32_t rowSize = width * sizeof(Color);
         // Minimize memory use by only buffering a single row.
@@ -867,6 +914,59 @@ class rgba16image : public ImageT<uint16_t, 4> {
         : MyImageT(w, h, data) { }
 };
 
+// Resample the volume whose depth slices are src to the volume whose slices
+// are dst. The dst images must all be the same size and of the same type as
+// the src images. Each dst slice is filtered first along z, then within the
+// slice. Slices are processed in parallel by up to threadCount threads. The
+// first exception thrown by any of them is rethrown.
+inline void
+resampleVolume(const std::vector<Image*>& src, const std::vector<Image*>& dst,
+               bool srgb, const char *pFilter, float filter_scale,
+               basisu::Resampler::Boundary_Op wrapMode, uint32_t threadCount)
+{
+    std::atomic<uint32_t> next(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto worker = [&]() {
+        uint32_t z;
+        while ((z = next++) < dst.size()) {
+            try {
+                std::unique_ptr<Image> filtered;
+                Image* slice = src[z];
+                if (dst.size() != src.size()) {
+                    filtered.reset(src[0]->createImage(src[0]->getWidth(),
+                                                       src[0]->getHeight()));
+                    filtered->resampleDepth(src, z, (uint32_t)dst.size(),
+                                            srgb, pFilter, filter_scale,
+                                            wrapMode);
+                    slice = filtered.get();
+                }
+                slice->resample(*dst[z], srgb, pFilter, filter_scale,
+                                wrapMode);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+    };
+
+    threadCount = maximum(1U, minimum(threadCount, (uint32_t)dst.size()));
+    std::vector<std::thread> threads;
+    try {
+        for (uint32_t i = 1; i < threadCount; i++)
+            threads.emplace_back(worker);
+    } catch (std::system_error&) {
+        // Continue with the threads that were started.
+    }
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+    if (error)
+        std::rethrow_exception(error);
+}
+
 #endif /* IMAGE_HPP */
 
 
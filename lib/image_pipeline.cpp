@@ -0,0 +1,1110 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2010-2020 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file image_pipeline.cpp
+ * @~English
+ *
+ * @brief Functions for creating a texture from decoded images, applying the
+ *        same processing as toktx, and for baking cube maps for image based
+ *        lighting from equirectangular panoramas.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <KHR/khr_df.h>
+
+#include "ktx.h"
+#include "ktxint.h"
+#include "texture2.h"
+#include "vkformat_enum.h"
+#include "vkformat_convert.h"
+#include "image.hpp"
+
+namespace {
+
+/*
+ * Run @p func for each index in [0, @p count) on up to @p threadCount
+ * threads. Returns the first error by index.
+ */
+template<typename Func>
+KTX_error_code
+parallelFor(ktx_uint32_t count, ktx_uint32_t threadCount, Func func)
+{
+    std::atomic<ktx_int32_t> next(0);
+    std::vector<KTX_error_code> results(count, KTX_SUCCESS);
+    auto worker = [&]() {
+        ktx_int32_t i;
+        while ((i = next++) < (ktx_int32_t)count) {
+            try {
+                results[i] = func((ktx_uint32_t)i);
+            } catch (std::bad_alloc&) {
+                results[i] = KTX_OUT_OF_MEMORY;
+            } catch (std::runtime_error&) {
+                // Only the resampler throws this and the filter name has
+                // already been checked so the image must be too large.
+                results[i] = KTX_INVALID_OPERATION;
+            }
+        }
+    };
+
+    threadCount = std::max(1U, std::min(threadCount, count));
+    std::vector<std::thread> threads;
+    try {
+        for (ktx_uint32_t i = 1; i < threadCount; i++)
+            threads.emplace_back(worker);
+    } catch (std::system_error&) {
+        // Continue with the threads that were started.
+    }
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+
+    for (auto result : results) {
+        if (result != KTX_SUCCESS)
+            return result;
+    }
+    return KTX_SUCCESS;
+}
+
+Image*
+createImage(ktx_uint32_t componentCount, ktx_uint32_t componentSize,
+            ktx_uint32_t width, ktx_uint32_t height)
+{
+    if (componentSize == 2) {
+        switch (componentCount) {
+          case 1: return new r16image(width, height);
+          case 2: return new rg16image(width, height);
+          case 3: return new rgb16image(width, height);
+          default: return new rgba16image(width, height);
+        }
+    } else {
+        switch (componentCount) {
+          case 1: return new r8image(width, height);
+          case 2: return new rg8image(width, height);
+          case 3: return new rgb8image(width, height);
+          default: return new rgba8image(width, height);
+        }
+    }
+}
+
+/*
+ * Create a new image of the same type and attributes as @p image.
+ */
+Image*
+createImageLike(Image& image, ktx_uint32_t width, ktx_uint32_t height)
+{
+    Image* newImage = image.createImage(width, height);
+    newImage->setOetf(image.getOetf());
+    newImage->setColortype(image.getColortype());
+    newImage->setPrimaries(image.getPrimaries());
+    return newImage;
+}
+
+VkFormat
+imageFormat(ktx_uint32_t componentCount, ktx_uint32_t componentSize,
+            bool srgb)
+{
+    static const VkFormat unorm8[] = {
+        VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8_UNORM,
+        VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_R8G8B8A8_UNORM
+    };
+    static const VkFormat srgb8[] = {
+        VK_FORMAT_R8_SRGB, VK_FORMAT_R8G8_SRGB,
+        VK_FORMAT_R8G8B8_SRGB, VK_FORMAT_R8G8B8A8_SRGB
+    };
+    static const VkFormat unorm16[] = {
+        VK_FORMAT_R16_UNORM, VK_FORMAT_R16G16_UNORM,
+        VK_FORMAT_R16G16B16_UNORM, VK_FORMAT_R16G16B16A16_UNORM
+    };
+
+    if (componentSize == 2)
+        return unorm16[componentCount - 1];
+    return srgb ? srgb8[componentCount - 1] : unorm8[componentCount - 1];
+}
+
+basisu::Resampler::Boundary_Op
+boundaryOp(ktx_uint32_t wrapMode)
+{
+    switch (wrapMode) {
+      case KTX_IMAGE_WRAP_REPEAT:
+        return basisu::Resampler::Boundary_Op::BOUNDARY_WRAP;
+      case KTX_IMAGE_WRAP_REFLECT:
+        return basisu::Resampler::Boundary_Op::BOUNDARY_REFLECT;
+      default:
+        return basisu::Resampler::Boundary_Op::BOUNDARY_CLAMP;
+    }
+}
+
+struct pipeline {
+    const ktxSourceImage* images;
+    ktx_uint32_t numImages;
+    const ktxImageParams* params;
+    const char* filter;
+    float filterScale;
+    std::string swizzle;
+    ktx_uint32_t componentCount;
+    ktx_uint32_t oetf;
+    ktxTexture2* texture;
+    std::vector<std::unique_ptr<Image>> processed;
+};
+
+/*
+ * Copy source image @p i and apply OETF conversion, resizing, flipping,
+ * normalization, component count change and swizzle in the same order as
+ * toktx.
+ */
+KTX_error_code
+processImage(pipeline& p, ktx_uint32_t i)
+{
+    const ktxSourceImage& src = p.images[i];
+    const ktxImageParams& params = *p.params;
+    std::unique_ptr<Image> image(createImage(src.componentCount,
+                                             src.componentSize,
+                                             src.width, src.height));
+
+    memcpy((uint8_t*)*image, src.pData, image->getByteCount());
+    image->setColortype((Image::colortype_e)(Image::eR
+                                             + src.componentCount - 1));
+    image->setOetf((khr_df_transfer_e)src.oetf);
+    image->setPrimaries((khr_df_primaries_e)src.primaries);
+
+    if (params.convertOetf != KHR_DF_TRANSFER_UNSPECIFIED
+        && params.convertOetf != src.oetf) {
+        OETFFunc decode, encode;
+        if (src.oetf == KHR_DF_TRANSFER_SRGB)
+            decode = decode_sRGB;
+        else
+            decode = decode_linear;
+        if (params.convertOetf == KHR_DF_TRANSFER_SRGB)
+            encode = encode_sRGB;
+        else
+            encode = encode_linear;
+        image->transformOETF(decode, encode);
+        image->setOetf((khr_df_transfer_e)params.convertOetf);
+    }
+
+    if (params.resizeWidth != 0
+        && (params.resizeWidth != src.width
+            || params.resizeHeight != src.height)) {
+        std::unique_ptr<Image> scaled(createImageLike(*image,
+                                                      params.resizeWidth,
+                                                      params.resizeHeight));
+        image->resample(*scaled, image->getOetf() == KHR_DF_TRANSFER_SRGB,
+                        p.filter, p.filterScale,
+                        basisu::Resampler::Boundary_Op::BOUNDARY_CLAMP);
+        image = std::move(scaled);
+    }
+
+    if (image->getHeight() > 1 && params.lowerLeftMapsToS0T0)
+        image->yflip();
+
+    if (params.normalize)
+        image->normalize();
+
+    if (p.componentCount != image->getComponentCount()) {
+        std::unique_ptr<Image> newImage(createImage(p.componentCount,
+                                                    src.componentSize,
+                                                    image->getWidth(),
+                                                    image->getHeight()));
+        switch (p.componentCount) {
+          case 1: image->copyToR(*newImage); break;
+          case 2: image->copyToRG(*newImage); break;
+          case 3: image->copyToRGB(*newImage); break;
+          default: image->copyToRGBA(*newImage); break;
+        }
+        image = std::move(newImage);
+    }
+
+    if (p.swizzle.size() > 0)
+        image->swizzle(p.swizzle);
+
+    p.processed[i] = std::move(image);
+    return KTX_SUCCESS;
+}
+
+/*
+ * Store processed image @p i in the texture and, if requested, generate
+ * its mip levels from it.
+ */
+KTX_error_code
+storeImage(pipeline& p, ktx_uint32_t i)
+{
+    const ktxSourceImage& src = p.images[i];
+    const ktxImageParams& params = *p.params;
+    std::unique_ptr<Image> image = std::move(p.processed[i]);
+    KTX_error_code result;
+
+    result = ktxTexture2_SetImageFromMemory(p.texture, src.level, src.layer,
+                                            src.faceSlice, *image,
+                                            image->getByteCount());
+    if (result != KTX_SUCCESS || !params.generateMipmaps)
+        return result;
+    if (params.baseDepth > 1) {
+        // The levels of a 3D texture are made from all its slices by
+        // generateVolumeLevels.
+        p.processed[i] = std::move(image);
+        return KTX_SUCCESS;
+    }
+
+    basisu::Resampler::Boundary_Op wrapMode = boundaryOp(params.mipWrapMode);
+    for (ktx_uint32_t level = 1; level < p.texture->numLevels; level++) {
+        std::unique_ptr<Image> levelImage(createImageLike(*image,
+                    std::max(1U, image->getWidth() >> level),
+                    std::max(1U, image->getHeight() >> level)));
+        image->resample(*levelImage,
+                        image->getOetf() == KHR_DF_TRANSFER_SRGB,
+                        p.filter, p.filterScale, wrapMode);
+        if (params.normalize)
+            levelImage->normalize();
+        result = ktxTexture2_SetImageFromMemory(p.texture, level, src.layer,
+                                                src.faceSlice, *levelImage,
+                                                levelImage->getByteCount());
+        if (result != KTX_SUCCESS)
+            return result;
+    }
+    return KTX_SUCCESS;
+}
+
+/*
+ * Generate levels 1 and up of each layer of a 3D texture from its level 0
+ * slices, filtering across the slices as well as within them. Slices are
+ * processed in parallel by up to @p threadCount threads.
+ */
+KTX_error_code
+generateVolumeLevels(pipeline& p, ktx_uint32_t threadCount)
+{
+    const ktxImageParams& params = *p.params;
+    basisu::Resampler::Boundary_Op wrapMode = boundaryOp(params.mipWrapMode);
+    std::vector<std::vector<Image*>> volumes(p.texture->numLayers,
+                                 std::vector<Image*>(p.texture->baseDepth));
+    for (ktx_uint32_t i = 0; i < p.numImages; i++)
+        volumes[p.images[i].layer][p.images[i].faceSlice]
+                                                    = p.processed[i].get();
+
+    for (ktx_uint32_t layer = 0; layer < p.texture->numLayers; layer++) {
+        const std::vector<Image*>& base = volumes[layer];
+        for (ktx_uint32_t level = 1; level < p.texture->numLevels; level++) {
+            ktx_uint32_t depth = std::max(1U, p.texture->baseDepth >> level);
+            std::vector<std::unique_ptr<Image>> slices(depth);
+            std::vector<Image*> dst(depth);
+            for (ktx_uint32_t z = 0; z < depth; z++) {
+                slices[z].reset(createImageLike(*base[0],
+                            std::max(1U, base[0]->getWidth() >> level),
+                            std::max(1U, base[0]->getHeight() >> level)));
+                dst[z] = slices[z].get();
+            }
+            resampleVolume(base, dst,
+                           base[0]->getOetf() == KHR_DF_TRANSFER_SRGB,
+                           p.filter, p.filterScale, wrapMode, threadCount);
+            for (ktx_uint32_t z = 0; z < depth; z++) {
+                if (params.normalize)
+                    dst[z]->normalize();
+                KTX_error_code result
+                    = ktxTexture2_SetImageFromMemory(p.texture, level, layer,
+                                                     z, *dst[z],
+                                                     dst[z]->getByteCount());
+                if (result != KTX_SUCCESS)
+                    return result;
+            }
+        }
+    }
+    return KTX_SUCCESS;
+}
+
+/*
+ * Add KTXorientation metadata matching the row order of the images.
+ */
+KTX_error_code
+addOrientation(ktxTexture2* texture, bool lowerLeftMapsToS0T0)
+{
+    char orientation[4];
+
+    orientation[0] = 'r';
+    orientation[1] = 0;
+    if (texture->numDimensions > 1) {
+        orientation[1] = lowerLeftMapsToS0T0 ? 'u' : 'd';
+        orientation[2] = 0;
+        if (texture->numDimensions > 2) {
+            orientation[2] = lowerLeftMapsToS0T0 ? 'o' : 'i';
+            orientation[3] = 0;
+        }
+    }
+    return ktxHashList_AddKVPair(&texture->kvDataHead, KTX_ORIENTATION_KEY,
+                                 (unsigned int)strlen(orientation) + 1,
+                                 orientation);
+}
+
+} // namespace
+
+/**
+ * @memberof ktxTexture2
+ * @ingroup writer
+ * @~English
+ * @brief Create a texture from decoded images, processing them as toktx
+ *        does.
+ *
+ * Each image in @p images is copied and, in this order, converted to
+ * @c params->convertOetf, resized to @c params->resizeWidth x
+ * @c params->resizeHeight, flipped if @c params->lowerLeftMapsToS0T0 is set,
+ * normalized, given @c params->targetComponentCount components and
+ * swizzled by @c params->inputSwizzle. The result is stored at the image's
+ * level, layer and faceSlice. If @c params->generateMipmaps is set the
+ * remaining levels are then generated from it with @c params->mipFilter.
+ * For 3D textures they are generated from all the depth slices of a layer,
+ * filtering along z as well as x and y.
+ * Images are processed in parallel by up to @c params->threadCount threads.
+ *
+ * The texture's format is the 8-bit UNORM or SRGB, or 16-bit UNORM, format
+ * with the resulting number of components and transfer function. There are
+ * no 16-bit SRGB formats so 16-bit sRGB images, which are still resampled
+ * as sRGB, are stored in the UNORM format, as toktx has always done. Its
+ * dimensions come from the level 0 images. Every image of every level,
+ * layer and face or depth slice in the texture, or only those of level 0
+ * when generating mipmaps, must be given exactly once. KTXorientation
+ * metadata is added. No KTXwriter or KTXswizzle metadata is added.
+ *
+ * Decoding image files is left to the application. toktx decodes them and
+ * creates its textures with this function.
+ *
+ * @param[in] images     pointer to an array of @p numImages images.
+ * @param[in] numImages  number of images in @p images.
+ * @param[in] params     pointer to the processing parameters.
+ * @param[in,out] newTex pointer to a location in which store the address of
+ *                       the newly created texture.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p images, @p params or @p newTex is NULL,
+ *                              @p numImages is 0, @c params->structSize is
+ *                              wrong, a parameter is out of range, an image
+ *                              has an invalid or mismatched attribute, is
+ *                              the wrong size for its level or does not fit
+ *                              in the texture, or an image is missing or
+ *                              given more than once.
+ * @exception KTX_INVALID_OPERATION
+ *                              images other than level 0 are given while
+ *                              resizing or generating mipmaps or an image is
+ *                              too large for the resampler.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory to create the texture.
+ */
+extern "C" KTX_error_code
+ktxTexture2_CreateFromImages(const ktxSourceImage* images,
+                             ktx_uint32_t numImages,
+                             const ktxImageParams* params,
+                             ktxTexture2** newTex)
+{
+    if (images == nullptr || numImages == 0 || params == nullptr
+        || newTex == nullptr)
+        return KTX_INVALID_VALUE;
+    if (params->structSize != sizeof(struct ktxImageParams))
+        return KTX_INVALID_VALUE;
+    *newTex = nullptr;
+
+    pipeline p;
+    p.images = images;
+    p.numImages = numImages;
+    p.params = params;
+    p.filter = params->mipFilter ? params->mipFilter : "lanczos4";
+    p.filterScale = params->mipFilterScale != 0.0f ? params->mipFilterScale
+                                                   : 1.0f;
+    if (basisu::find_resample_filter(p.filter) < 0)
+        return KTX_INVALID_VALUE;
+
+    if (params->convertOetf != KHR_DF_TRANSFER_UNSPECIFIED
+        && params->convertOetf != KHR_DF_TRANSFER_SRGB
+        && params->convertOetf != KHR_DF_TRANSFER_LINEAR)
+        return KTX_INVALID_VALUE;
+    if (params->targetComponentCount > 4)
+        return KTX_INVALID_VALUE;
+    if ((params->resizeWidth == 0) != (params->resizeHeight == 0))
+        return KTX_INVALID_VALUE;
+    if (params->mipWrapMode > KTX_IMAGE_WRAP_REFLECT)
+        return KTX_INVALID_VALUE;
+
+    //
+    // Check the images agree with each other.
+    //
+    const ktxSourceImage* base = nullptr;
+    ktx_uint32_t maxLevel = 0;
+    for (ktx_uint32_t i = 0; i < numImages; i++) {
+        const ktxSourceImage& image = images[i];
+        if (image.pData == nullptr || image.width == 0 || image.height == 0
+            || image.componentCount < 1 || image.componentCount > 4
+            || (image.componentSize != 1 && image.componentSize != 2)
+            || (image.oetf != KHR_DF_TRANSFER_SRGB
+                && image.oetf != KHR_DF_TRANSFER_LINEAR))
+            return KTX_INVALID_VALUE;
+        if (image.level == 0 && base == nullptr)
+            base = &image;
+        maxLevel = std::max(maxLevel, image.level);
+    }
+    if (base == nullptr)
+        return KTX_INVALID_VALUE;
+    if (maxLevel > 0 && (params->generateMipmaps || params->resizeWidth))
+        return KTX_INVALID_OPERATION;
+    for (ktx_uint32_t i = 0; i < numImages; i++) {
+        const ktxSourceImage& image = images[i];
+        if (image.componentSize != base->componentSize
+            || image.primaries != base->primaries
+            || image.width != std::max(1U, base->width >> image.level)
+            || image.height != std::max(1U, base->height >> image.level))
+            return KTX_INVALID_VALUE;
+        if (params->targetComponentCount == 0
+            && image.componentCount != base->componentCount)
+            return KTX_INVALID_VALUE;
+        if (params->convertOetf == KHR_DF_TRANSFER_UNSPECIFIED
+            && image.oetf != base->oetf)
+            return KTX_INVALID_VALUE;
+    }
+
+    p.componentCount = params->targetComponentCount
+                     ? params->targetComponentCount : base->componentCount;
+    p.oetf = params->convertOetf != KHR_DF_TRANSFER_UNSPECIFIED
+           ? params->convertOetf : base->oetf;
+
+    if (params->inputSwizzle[0] != 0) {
+        for (ktx_uint32_t c = 0; c < 4; c++) {
+            if (params->inputSwizzle[c] == 0
+                || strchr("rgba01", params->inputSwizzle[c]) == nullptr)
+                return KTX_INVALID_VALUE;
+        }
+        p.swizzle.assign(params->inputSwizzle, 4);
+    }
+
+    //
+    // Work out the shape of the texture.
+    //
+    ktxTextureCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.vkFormat = imageFormat(p.componentCount, base->componentSize,
+                                      p.oetf == KHR_DF_TRANSFER_SRGB);
+    createInfo.baseWidth = params->resizeWidth ? params->resizeWidth
+                                               : base->width;
+    createInfo.baseHeight = params->resizeHeight ? params->resizeHeight
+                                                 : base->height;
+    createInfo.baseDepth = std::max(1U, params->baseDepth);
+    if (params->baseDepth > 0)
+        createInfo.numDimensions = 3;
+    else if (createInfo.baseHeight == 1)
+        createInfo.numDimensions = 1;
+    else
+        createInfo.numDimensions = 2;
+    createInfo.numLayers = std::max(1U, params->numLayers);
+    createInfo.numFaces = params->cubemap ? 6 : 1;
+    createInfo.isArray = params->isArray;
+    createInfo.generateMipmaps = KTX_FALSE;
+
+    if (params->cubemap
+        && (params->baseDepth > 0
+            || createInfo.baseWidth != createInfo.baseHeight))
+        return KTX_INVALID_VALUE;
+
+    ktx_uint32_t maxLevels = 1;
+    for (ktx_uint32_t dim = std::max(createInfo.baseWidth,
+                                     std::max(createInfo.baseHeight,
+                                              createInfo.baseDepth));
+         dim > 1; dim >>= 1)
+        maxLevels++;
+    if (params->numLevels != 0)
+        createInfo.numLevels = params->numLevels;
+    else if (params->generateMipmaps)
+        createInfo.numLevels = maxLevels;
+    else
+        createInfo.numLevels = maxLevel + 1;
+    if (createInfo.numLevels > maxLevels || createInfo.numLevels <= maxLevel)
+        return KTX_INVALID_VALUE;
+
+    // Check each image that is needed is given once.
+    ktx_uint32_t suppliedLevels = params->generateMipmaps
+                                ? 1 : createInfo.numLevels;
+    std::vector<ktx_uint32_t> levelStart(suppliedLevels + 1, 0);
+    for (ktx_uint32_t level = 0; level < suppliedLevels; level++) {
+        ktx_uint32_t numFaceSlices = params->cubemap ? 6
+                     : std::max(1U, createInfo.baseDepth >> level);
+        levelStart[level + 1] = levelStart[level]
+                              + createInfo.numLayers * numFaceSlices;
+    }
+    if (numImages != levelStart[suppliedLevels])
+        return KTX_INVALID_VALUE;
+    std::vector<bool> given(numImages, false);
+    for (ktx_uint32_t i = 0; i < numImages; i++) {
+        const ktxSourceImage& image = images[i];
+        ktx_uint32_t numFaceSlices = (levelStart[image.level + 1]
+                                      - levelStart[image.level])
+                                   / createInfo.numLayers;
+        if (image.layer >= createInfo.numLayers
+            || image.faceSlice >= numFaceSlices)
+            return KTX_INVALID_VALUE;
+        ktx_uint32_t slot = levelStart[image.level]
+                          + image.layer * numFaceSlices + image.faceSlice;
+        if (given[slot])
+            return KTX_INVALID_VALUE;
+        given[slot] = true;
+    }
+
+    ktx_uint32_t threadCount = params->threadCount;
+    if (threadCount == 0)
+        threadCount = std::thread::hardware_concurrency();
+
+    KTX_error_code result;
+    try {
+        p.processed.resize(numImages);
+    } catch (std::bad_alloc&) {
+        return KTX_OUT_OF_MEMORY;
+    }
+    result = parallelFor(numImages, threadCount,
+                         [&p](ktx_uint32_t i) { return processImage(p, i); });
+    if (result != KTX_SUCCESS)
+        return result;
+
+    result = ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+                                &p.texture);
+    if (result != KTX_SUCCESS)
+        return result;
+    if (base->primaries != KHR_DF_PRIMARIES_BT709)
+        KHR_DFDSETVAL(p.texture->pDfd + 1, PRIMARIES, base->primaries);
+
+    result = parallelFor(numImages, threadCount,
+                         [&p](ktx_uint32_t i) { return storeImage(p, i); });
+    if (result == KTX_SUCCESS && params->generateMipmaps
+        && params->baseDepth > 1) {
+        try {
+            result = generateVolumeLevels(p, threadCount);
+        } catch (std::bad_alloc&) {
+            result = KTX_OUT_OF_MEMORY;
+        } catch (std::runtime_error&) {
+            // As in parallelFor, the image must be too large.
+            result = KTX_INVALID_OPERATION;
+        }
+    }
+    if (result == KTX_SUCCESS)
+        result = addOrientation(p.texture, params->lowerLeftMapsToS0T0);
+    if (result != KTX_SUCCESS) {
+        ktxTexture2_Destroy(p.texture);
+        return result;
+    }
+    *newTex = p.texture;
+    return KTX_SUCCESS;
+}
+
+namespace {
+
+const float pi = 3.14159265358979f;
+
+/*
+ * One level of a cube map being baked. Texels are 4 component floats.
+ *
+ * The baking code is scalar. The prefilter's cost is in sampleCube, called
+ * once per GGX sample, whose face selection and bilinear gathers are data
+ * dependent so the compiler does not vectorize them. Only the short
+ * per-component loops may be. Rows are spread across threads instead.
+ */
+struct cubeLevel {
+    ktx_uint32_t size;
+    std::vector<float> texels;  // 6 faces of size * size texels.
+
+    float* face(ktx_uint32_t f) { return &texels[f * size * size * 4]; }
+    const float* face(ktx_uint32_t f) const {
+        return &texels[f * size * size * 4];
+    }
+};
+
+struct cubeBake {
+    std::vector<float> panorama;  // RGBA copy of the input.
+    ktx_uint32_t width;
+    ktx_uint32_t height;
+    std::vector<cubeLevel> levels;
+};
+
+/*
+ * Set @p dir to the normalized direction through point (@p s, @p t), each
+ * in [-1, 1], of cube map face @p face using the Vulkan and OpenGL face
+ * conventions.
+ */
+void
+faceDirection(ktx_uint32_t face, float s, float t, float dir[3])
+{
+    switch (face) {
+      case 0: dir[0] = 1.0f; dir[1] = -t; dir[2] = -s; break;
+      case 1: dir[0] = -1.0f; dir[1] = -t; dir[2] = s; break;
+      case 2: dir[0] = s; dir[1] = 1.0f; dir[2] = t; break;
+      case 3: dir[0] = s; dir[1] = -1.0f; dir[2] = -t; break;
+      case 4: dir[0] = s; dir[1] = -t; dir[2] = 1.0f; break;
+      default: dir[0] = -s; dir[1] = -t; dir[2] = -1.0f; break;
+    }
+    float len = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1]
+                          + dir[2] * dir[2]);
+    dir[0] /= len; dir[1] /= len; dir[2] /= len;
+}
+
+/*
+ * Inverse of faceDirection. @p s and @p t are returned in [0, 1].
+ */
+void
+directionFace(const float dir[3], ktx_uint32_t& face, float& s, float& t)
+{
+    float ax = std::fabs(dir[0]), ay = std::fabs(dir[1]);
+    float az = std::fabs(dir[2]);
+    float ma, sc, tc;
+
+    if (ax >= ay && ax >= az) {
+        face = dir[0] > 0 ? 0 : 1;
+        ma = ax;
+        sc = dir[0] > 0 ? -dir[2] : dir[2];
+        tc = -dir[1];
+    } else if (ay >= az) {
+        face = dir[1] > 0 ? 2 : 3;
+        ma = ay;
+        sc = dir[0];
+        tc = dir[1] > 0 ? dir[2] : -dir[2];
+    } else {
+        face = dir[2] > 0 ? 4 : 5;
+        ma = az;
+        sc = dir[2] > 0 ? dir[0] : -dir[0];
+        tc = -dir[1];
+    }
+    s = (sc / ma + 1.0f) * 0.5f;
+    t = (tc / ma + 1.0f) * 0.5f;
+}
+
+/*
+ * Bilinearly sample the RGBA float image @p image at texel coordinates
+ * (@p x, @p y). Coordinates wrap horizontally if @p wrap is set and are
+ * otherwise clamped.
+ */
+void
+sampleBilinear(const float* image, ktx_uint32_t width, ktx_uint32_t height,
+               float x, float y, bool wrap, float out[4])
+{
+    x -= 0.5f;
+    y -= 0.5f;
+    float fx = std::floor(x), fy = std::floor(y);
+    float ax = x - fx, ay = y - fy;
+    ktx_int32_t w = (ktx_int32_t)width, h = (ktx_int32_t)height;
+    ktx_int32_t x0 = (ktx_int32_t)fx, y0 = (ktx_int32_t)fy;
+    ktx_int32_t x1 = x0 + 1, y1 = y0 + 1;
+
+    if (wrap) {
+        x0 = (x0 % w + w) % w;
+        x1 = (x1 % w + w) % w;
+    } else {
+        x0 = std::min(std::max(x0, 0), w - 1);
+        x1 = std::min(std::max(x1, 0), w - 1);
+    }
+    y0 = std::min(std::max(y0, 0), h - 1);
+    y1 = std::min(std::max(y1, 0), h - 1);
+
+    const float* p00 = &image[(y0 * w + x0) * 4];
+    const float* p10 = &image[(y0 * w + x1) * 4];
+    const float* p01 = &image[(y1 * w + x0) * 4];
+    const float* p11 = &image[(y1 * w + x1) * 4];
+    for (ktx_uint32_t c = 0; c < 4; c++) {
+        out[c] = (p00[c] * (1.0f - ax) + p10[c] * ax) * (1.0f - ay)
+               + (p01[c] * (1.0f - ax) + p11[c] * ax) * ay;
+    }
+}
+
+/*
+ * Sample the box filtered levels of @p bake in direction @p dir at level of
+ * detail @p lod, blending between the two nearest levels.
+ */
+void
+sampleCube(const cubeBake& bake, const float dir[3], float lod, float out[4])
+{
+    ktx_uint32_t face;
+    float s, t;
+    directionFace(dir, face, s, t);
+
+    lod = std::min(std::max(lod, 0.0f), (float)(bake.levels.size() - 1));
+    ktx_uint32_t level = (ktx_uint32_t)lod;
+    float frac = lod - level;
+    const cubeLevel& l0 = bake.levels[level];
+    sampleBilinear(l0.face(face), l0.size, l0.size, s * l0.size,
+                   t * l0.size, false, out);
+    if (frac > 0.0f) {
+        const cubeLevel& l1 = bake.levels[level + 1];
+        float texel[4];
+        sampleBilinear(l1.face(face), l1.size, l1.size, s * l1.size,
+                       t * l1.size, false, texel);
+        for (ktx_uint32_t c = 0; c < 4; c++)
+            out[c] += (texel[c] - out[c]) * frac;
+    }
+}
+
+/*
+ * Project row @p row, counting across all faces, of level 0 from the
+ * panorama. The centre of the panorama faces +Z and its top row +Y.
+ */
+KTX_error_code
+projectRow(cubeBake& bake, ktx_uint32_t row)
+{
+    cubeLevel& level = bake.levels[0];
+    ktx_uint32_t face = row / level.size, y = row % level.size;
+    float* texel = level.face(face) + y * level.size * 4;
+    float t = 2.0f * (y + 0.5f) / level.size - 1.0f;
+
+    for (ktx_uint32_t x = 0; x < level.size; x++, texel += 4) {
+        float dir[3];
+        faceDirection(face, 2.0f * (x + 0.5f) / level.size - 1.0f, t, dir);
+        float u = 0.5f + std::atan2(dir[0], dir[2]) / (2.0f * pi);
+        float v = std::acos(std::min(std::max(dir[1], -1.0f), 1.0f)) / pi;
+        sampleBilinear(bake.panorama.data(), bake.width, bake.height,
+                       u * bake.width, v * bake.height, true, texel);
+    }
+    return KTX_SUCCESS;
+}
+
+/*
+ * Box filter row @p row, counting across all faces, of level @p l from
+ * level @p l - 1.
+ */
+KTX_error_code
+downsampleRow(cubeBake& bake, ktx_uint32_t l, ktx_uint32_t row)
+{
+    const cubeLevel& src = bake.levels[l - 1];
+    cubeLevel& dst = bake.levels[l];
+    ktx_uint32_t face = row / dst.size, y = row % dst.size;
+    ktx_uint32_t y0 = std::min(2 * y, src.size - 1);
+    ktx_uint32_t y1 = std::min(2 * y + 1, src.size - 1);
+    const float* row0 = src.face(face) + y0 * src.size * 4;
+    const float* row1 = src.face(face) + y1 * src.size * 4;
+    float* texel = dst.face(face) + y * dst.size * 4;
+
+    for (ktx_uint32_t x = 0; x < dst.size; x++, texel += 4) {
+        ktx_uint32_t x0 = std::min(2 * x, src.size - 1) * 4;
+        ktx_uint32_t x1 = std::min(2 * x + 1, src.size - 1) * 4;
+        for (ktx_uint32_t c = 0; c < 4; c++) {
+            texel[c] = (row0[x0 + c] + row0[x1 + c]
+                        + row1[x0 + c] + row1[x1 + c]) * 0.25f;
+        }
+    }
+    return KTX_SUCCESS;
+}
+
+struct ggxSample {
+    float l[3];    // Direction in the tangent space of the texel.
+    float weight;  // N dot L.
+    float lod;     // Level of the box filtered chain to sample.
+};
+
+/*
+ * GGX importance samples for @p roughness, using the Hammersley sequence.
+ * With the view direction equal to the normal, as is usual for prefiltered
+ * specular maps, they are the same for every texel. Each sample's level of
+ * detail is chosen from the solid angle it covers, as in filtered importance
+ * sampling, so few samples are needed.
+ */
+std::vector<ggxSample>
+ggxSamples(float roughness, ktx_uint32_t sampleCount, ktx_uint32_t baseSize)
+{
+    std::vector<ggxSample> samples;
+    float a = roughness * roughness;
+    float a2 = a * a;
+    float texelSolidAngle = 4.0f * pi / (6.0f * baseSize * baseSize);
+
+    for (ktx_uint32_t i = 0; i < sampleCount; i++) {
+        ktx_uint32_t bits = i;
+        bits = (bits << 16) | (bits >> 16);
+        bits = ((bits & 0x55555555) << 1) | ((bits & 0xAAAAAAAA) >> 1);
+        bits = ((bits & 0x33333333) << 2) | ((bits & 0xCCCCCCCC) >> 2);
+        bits = ((bits & 0x0F0F0F0F) << 4) | ((bits & 0xF0F0F0F0) >> 4);
+        bits = ((bits & 0x00FF00FF) << 8) | ((bits & 0xFF00FF00) >> 8);
+        float xi1 = (float)i / sampleCount;
+        float xi2 = bits * 2.3283064365386963e-10f;
+
+        float phi = 2.0f * pi * xi1;
+        float cosTheta = std::sqrt((1.0f - xi2) / (1.0f + (a2 - 1.0f) * xi2));
+        float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+        // L = 2 (V.H) H - V with V = N = (0, 0, 1).
+        ggxSample sample;
+        sample.l[0] = 2.0f * cosTheta * sinTheta * std::cos(phi);
+        sample.l[1] = 2.0f * cosTheta * sinTheta * std::sin(phi);
+        sample.l[2] = 2.0f * cosTheta * cosTheta - 1.0f;
+        sample.weight = sample.l[2];
+        if (sample.weight <= 0.0f)
+            continue;
+
+        // pdf = D (N.H) / (4 (V.H)) which is D / 4 as V = N.
+        float d = cosTheta * cosTheta * (a2 - 1.0f) + 1.0f;
+        float pdf = a2 / (pi * d * d) / 4.0f;
+        float sampleSolidAngle = 1.0f / (sampleCount * pdf);
+        sample.lod = std::max(0.5f * std::log2(sampleSolidAngle
+                                               / texelSolidAngle) + 1.0f,
+                              0.0f);
+        samples.push_back(sample);
+    }
+    return samples;
+}
+
+/*
+ * Prefilter row @p row, counting across all faces, of level @p dst with
+ * @p samples.
+ */
+KTX_error_code
+prefilterRow(const cubeBake& bake, const std::vector<ggxSample>& samples,
+             cubeLevel& dst, ktx_uint32_t row)
+{
+    ktx_uint32_t face = row / dst.size, y = row % dst.size;
+    float* texel = dst.face(face) + y * dst.size * 4;
+    float t = 2.0f * (y + 0.5f) / dst.size - 1.0f;
+
+    for (ktx_uint32_t x = 0; x < dst.size; x++, texel += 4) {
+        float n[3], tx[3], ty[3];
+        faceDirection(face, 2.0f * (x + 0.5f) / dst.size - 1.0f, t, n);
+        // Tangent frame: tx = normalize(up x n), ty = n x tx.
+        if (std::fabs(n[2]) < 0.999f) {
+            tx[0] = -n[1]; tx[1] = n[0]; tx[2] = 0.0f;
+        } else {
+            tx[0] = 0.0f; tx[1] = -n[2]; tx[2] = n[1];
+        }
+        float len = std::sqrt(tx[0] * tx[0] + tx[1] * tx[1]
+                              + tx[2] * tx[2]);
+        tx[0] /= len; tx[1] /= len; tx[2] /= len;
+        ty[0] = n[1] * tx[2] - n[2] * tx[1];
+        ty[1] = n[2] * tx[0] - n[0] * tx[2];
+        ty[2] = n[0] * tx[1] - n[1] * tx[0];
+
+        float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float totalWeight = 0.0f;
+        for (const ggxSample& sample : samples) {
+            float dir[3], color[4];
+            for (ktx_uint32_t c = 0; c < 3; c++) {
+                dir[c] = tx[c] * sample.l[0] + ty[c] * sample.l[1]
+                       + n[c] * sample.l[2];
+            }
+            sampleCube(bake, dir, sample.lod, color);
+            for (ktx_uint32_t c = 0; c < 4; c++)
+                sum[c] += color[c] * sample.weight;
+            totalWeight += sample.weight;
+        }
+        for (ktx_uint32_t c = 0; c < 4; c++)
+            texel[c] = sum[c] / totalWeight;
+    }
+    return KTX_SUCCESS;
+}
+
+} // namespace
+
+/**
+ * @memberof ktxTexture2
+ * @ingroup writer
+ * @~English
+ * @brief Create a cube map for image based lighting from an
+ *        equirectangular panorama.
+ *
+ * The panorama is projected onto the faces of level 0, sampling it
+ * bilinearly. Its centre maps to +Z and its top row to +Y. Unless
+ * @c params->boxFilterMips is set, each level @e l above 0 of the
+ * @e n levels is then prefiltered with the GGX distribution for roughness
+ * @e l / (@e n - 1), as expected by glTF and most other physically based
+ * renderers for specular lighting. Prefiltering samples a box filtered mip
+ * chain of level 0 so the cost does not grow with the size of the faces.
+ * Work is split across faces and rows and done by up to
+ * @c params->threadCount threads.
+ *
+ * The texture holds linear values in a VK_FORMAT_R16G16B16A16_SFLOAT or
+ * VK_FORMAT_R32G32B32A32_SFLOAT format, ready for an HDR block compressor
+ * or for upload as is. Alpha is 1 if the panorama has no alpha component.
+ * KTXorientation metadata is added.
+ *
+ * @param[in] pixels     pointer to the panorama, tightly packed rows of
+ *                       @p componentCount linear float components, first
+ *                       row at the top.
+ * @param[in] width      width of the panorama in pixels.
+ * @param[in] height     height of the panorama in pixels.
+ * @param[in] componentCount number of components per pixel, 3 or 4.
+ * @param[in] params     pointer to the parameters.
+ * @param[in,out] newTex pointer to a location in which store the address of
+ *                       the newly created texture.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p pixels, @p params or @p newTex is NULL,
+ *                              @p width or @p height is 0,
+ *                              @p componentCount is not 3 or 4,
+ *                              @c params->structSize is wrong, or
+ *                              @c params->vkFormat or
+ *                              @c params->numLevels is not supported.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory to bake the texture.
+ */
+extern "C" KTX_error_code
+ktxTexture2_CreateCubemapFromEquirect(const float* pixels,
+                                      ktx_uint32_t width,
+                                      ktx_uint32_t height,
+                                      ktx_uint32_t componentCount,
+                                      const ktxCubemapParams* params,
+                                      ktxTexture2** newTex)
+{
+    if (pixels == nullptr || params == nullptr || newTex == nullptr
+        || width == 0 || height == 0
+        || (componentCount != 3 && componentCount != 4))
+        return KTX_INVALID_VALUE;
+    if (params->structSize != sizeof(struct ktxCubemapParams))
+        return KTX_INVALID_VALUE;
+    *newTex = nullptr;
+
+    VkFormat vkFormat = params->vkFormat ? (VkFormat)params->vkFormat
+                                         : VK_FORMAT_R16G16B16A16_SFLOAT;
+    ktxFormatConversion toHalf;
+    if (vkFormat == VK_FORMAT_R16G16B16A16_SFLOAT) {
+        ktxFormatConversion conversions[KTX_MAX_FORMAT_CONVERSIONS];
+        ktx_uint32_t count
+            = ktxFormatConversion_candidates(VK_FORMAT_R32G32B32A32_SFLOAT,
+                                             KTX_TRUE, conversions);
+        for (ktx_uint32_t i = 0; i < count; i++) {
+            if (conversions[i].dstFormat == vkFormat)
+                toHalf = conversions[i];
+        }
+    } else if (vkFormat != VK_FORMAT_R32G32B32A32_SFLOAT) {
+        return KTX_INVALID_VALUE;
+    }
+
+    ktx_uint32_t faceSize = params->faceSize ? params->faceSize
+                                             : std::max(1U, width / 4);
+    ktx_uint32_t maxLevels = 1;
+    for (ktx_uint32_t dim = faceSize; dim > 1; dim >>= 1)
+        maxLevels++;
+    ktx_uint32_t numLevels = params->numLevels ? params->numLevels
+                                               : maxLevels;
+    if (numLevels > maxLevels)
+        return KTX_INVALID_VALUE;
+    ktx_uint32_t sampleCount = params->sampleCount ? params->sampleCount
+                                                   : 512;
+    ktx_uint32_t threadCount = params->threadCount;
+    if (threadCount == 0)
+        threadCount = std::thread::hardware_concurrency();
+
+    cubeBake bake;
+    KTX_error_code result;
+    try {
+        bake.width = width;
+        bake.height = height;
+        bake.panorama.resize((size_t)width * height * 4);
+        for (size_t i = 0; i < (size_t)width * height; i++) {
+            for (ktx_uint32_t c = 0; c < 4; c++) {
+                bake.panorama[i * 4 + c] = c < componentCount
+                                         ? pixels[i * componentCount + c]
+                                         : 1.0f;
+            }
+        }
+        bake.levels.resize(numLevels);
+        for (ktx_uint32_t level = 0; level < numLevels; level++) {
+            bake.levels[level].size = std::max(1U, faceSize >> level);
+            bake.levels[level].texels.resize((size_t)6 * 4
+                                             * bake.levels[level].size
+                                             * bake.levels[level].size);
+        }
+    } catch (std::bad_alloc&) {
+        return KTX_OUT_OF_MEMORY;
+    }
+
+    result = parallelFor(6 * faceSize, threadCount,
+                         [&bake](ktx_uint32_t row) {
+                             return projectRow(bake, row);
+                         });
+    for (ktx_uint32_t level = 1; level < numLevels
+                                 && result == KTX_SUCCESS; level++) {
+        result = parallelFor(6 * bake.levels[level].size, threadCount,
+                             [&bake, level](ktx_uint32_t row) {
+                                 return downsampleRow(bake, level, row);
+                             });
+    }
+    if (result != KTX_SUCCESS)
+        return result;
+
+    // The prefiltered levels replace the box filtered ones only once all
+    // have been made, as each samples the whole box filtered chain.
+    std::vector<cubeLevel> prefiltered;
+    if (!params->boxFilterMips && numLevels > 1) {
+        try {
+            prefiltered.resize(numLevels);
+            for (ktx_uint32_t level = 1; level < numLevels; level++) {
+                std::vector<ggxSample> samples
+                    = ggxSamples((float)level / (numLevels - 1), sampleCount,
+                                 faceSize);
+                cubeLevel& dst = prefiltered[level];
+                dst.size = bake.levels[level].size;
+                dst.texels.resize(bake.levels[level].texels.size());
+                result = parallelFor(6 * dst.size, threadCount,
+                                     [&](ktx_uint32_t row) {
+                                         return prefilterRow(bake, samples,
+                                                             dst, row);
+                                     });
+                if (result != KTX_SUCCESS)
+                    return result;
+            }
+        } catch (std::bad_alloc&) {
+            return KTX_OUT_OF_MEMORY;
+        }
+        for (ktx_uint32_t level = 1; level < numLevels; level++)
+            bake.levels[level] = std::move(prefiltered[level]);
+    }
+
+    ktxTextureCreateInfo createInfo;
+    memset(&createInfo, 0, sizeof(createInfo));
+    createInfo.vkFormat = vkFormat;
+    createInfo.baseWidth = faceSize;
+    createInfo.baseHeight = faceSize;
+    createInfo.baseDepth = 1;
+    createInfo.numDimensions = 2;
+    createInfo.numLevels = numLevels;
+    createInfo.numLayers = 1;
+    createInfo.numFaces = 6;
+    createInfo.isArray = KTX_FALSE;
+    createInfo.generateMipmaps = KTX_FALSE;
+
+    ktxTexture2* texture;
+    result = ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+                                &texture);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    std::vector<ktx_uint8_t> half;
+    try {
+        if (vkFormat == VK_FORMAT_R16G16B16A16_SFLOAT)
+            half.resize((size_t)faceSize * faceSize * 8);
+    } catch (std::bad_alloc&) {
+        ktxTexture2_Destroy(texture);
+        return KTX_OUT_OF_MEMORY;
+    }
+    for (ktx_uint32_t level = 0; level < numLevels
+                                 && result == KTX_SUCCESS; level++) {
+        const cubeLevel& l = bake.levels[level];
+        size_t texelCount = (size_t)l.size * l.size;
+        for (ktx_uint32_t face = 0; face < 6 && result == KTX_SUCCESS;
+             face++) {
+            const ktx_uint8_t* src = (const ktx_uint8_t*)l.face(face);
+            ktx_size_t srcSize = texelCount * 16;
+            if (vkFormat == VK_FORMAT_R16G16B16A16_SFLOAT) {
+                ktxFormatConversion_convert(&toHalf, src, half.data(),
+                                            texelCount);
+                src = half.data();
+                srcSize = texelCount * 8;
+            }
+            result = ktxTexture2_SetImageFromMemory(texture, level, 0, face,
+                                                    src, srcSize);
+        }
+    }
+    if (result == KTX_SUCCESS)
+        result = addOrientation(texture, false);
+    if (result != KTX_SUCCESS) {
+        ktxTexture2_Destroy(texture);
+        return result;
+    }
+    *newTex = texture;
+    return KTX_SUCCESS;
+}
@@ -30,6 +30,10 @@
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 #endif
 
+#ifndef MIN
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#endif
+
 #define QUOTE(x) #x
 #define STR(x) QUOTE(x)
 
@@ -211,6 +215,11 @@ KTX_error_code _ktxUnpackETC(const GLubyte* srcETC, const GLenum srcFormat,
                              GLenum* format, GLenum* internalFormat, GLenum* type,
                              GLint R16Formats, GLboolean supportsSRGB);
 
+/*
+ * ktxZstdErrorToKtx: Map a Zstandard compression error to a KTX error code.
+ */
+KTX_error_code ktxZstdErrorToKtx(size_t zstdResult);
+
 /*
  * Pad nbytes to next multiple of n
  */
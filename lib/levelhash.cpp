@@ -0,0 +1,399 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2010-2020 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file levelhash.cpp
+ * @~English
+ *
+ * @brief Functions for computing and verifying the per-level content
+ *        hashes stored in a texture's metadata.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "ktx.h"
+#include "ktxint.h"
+#include "texture2.h"
+
+namespace {
+
+/*
+ * XXH64 with seed 0, as specified in xxHash's xxhash_spec.md. It is
+ * implemented here because the copy of xxHash inside the bundled Zstd is
+ * private to that library.
+ */
+const ktx_uint64_t prime64_1 = 0x9E3779B185EBCA87ULL;
+const ktx_uint64_t prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+const ktx_uint64_t prime64_3 = 0x165667B19E3779F9ULL;
+const ktx_uint64_t prime64_4 = 0x85EBCA77C2B2AE63ULL;
+const ktx_uint64_t prime64_5 = 0x27D4EB2F165667C5ULL;
+
+inline ktx_uint64_t
+rotl64(ktx_uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+// Byte-wise little-endian loads. Compilers turn these into single loads.
+inline ktx_uint64_t
+read64(const ktx_uint8_t* p)
+{
+    return (ktx_uint64_t)p[0]       | (ktx_uint64_t)p[1] << 8
+         | (ktx_uint64_t)p[2] << 16 | (ktx_uint64_t)p[3] << 24
+         | (ktx_uint64_t)p[4] << 32 | (ktx_uint64_t)p[5] << 40
+         | (ktx_uint64_t)p[6] << 48 | (ktx_uint64_t)p[7] << 56;
+}
+
+inline ktx_uint32_t
+read32(const ktx_uint8_t* p)
+{
+    return (ktx_uint32_t)p[0]       | (ktx_uint32_t)p[1] << 8
+         | (ktx_uint32_t)p[2] << 16 | (ktx_uint32_t)p[3] << 24;
+}
+
+inline ktx_uint64_t
+xxh64Round(ktx_uint64_t acc, ktx_uint64_t input)
+{
+    acc += input * prime64_2;
+    acc = rotl64(acc, 31);
+    return acc * prime64_1;
+}
+
+inline ktx_uint64_t
+xxh64MergeRound(ktx_uint64_t acc, ktx_uint64_t val)
+{
+    acc ^= xxh64Round(0, val);
+    return acc * prime64_1 + prime64_4;
+}
+
+ktx_uint64_t
+xxh64(const ktx_uint8_t* p, ktx_size_t len)
+{
+    ktx_size_t remaining = len;
+    ktx_uint64_t h;
+
+    if (remaining >= 32) {
+        ktx_uint64_t v1 = prime64_1 + prime64_2;
+        ktx_uint64_t v2 = prime64_2;
+        ktx_uint64_t v3 = 0;
+        ktx_uint64_t v4 = 0 - prime64_1;
+        do {
+            v1 = xxh64Round(v1, read64(p));
+            v2 = xxh64Round(v2, read64(p + 8));
+            v3 = xxh64Round(v3, read64(p + 16));
+            v4 = xxh64Round(v4, read64(p + 24));
+            p += 32;
+            remaining -= 32;
+        } while (remaining >= 32);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh64MergeRound(h, v1);
+        h = xxh64MergeRound(h, v2);
+        h = xxh64MergeRound(h, v3);
+        h = xxh64MergeRound(h, v4);
+    } else {
+        h = prime64_5;
+    }
+    h += len;
+
+    for (; remaining >= 8; p += 8, remaining -= 8) {
+        h ^= xxh64Round(0, read64(p));
+        h = rotl64(h, 27) * prime64_1 + prime64_4;
+    }
+    if (remaining >= 4) {
+        h ^= read32(p) * prime64_1;
+        h = rotl64(h, 23) * prime64_2 + prime64_3;
+        p += 4;
+        remaining -= 4;
+    }
+    for (; remaining > 0; p++, remaining--) {
+        h ^= *p * prime64_5;
+        h = rotl64(h, 11) * prime64_1;
+    }
+
+    h ^= h >> 33;
+    h *= prime64_2;
+    h ^= h >> 29;
+    h *= prime64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+struct hashJob {
+    ktxTexture2* texture;
+    const ktx_uint8_t* data;
+    std::atomic<ktx_int32_t> nextLevel;
+    ktx_uint64_t* hashes;
+};
+
+void
+hashWorker(hashJob* job)
+{
+    const ktxLevelIndexEntry* index = job->texture->_private->_levelIndex;
+    ktx_int32_t level;
+
+    // Level 0 is the largest so start there for better load balancing.
+    while ((level = job->nextLevel++) < (ktx_int32_t)job->texture->numLevels) {
+        job->hashes[level] = xxh64(job->data + index[level].byteOffset,
+                                   index[level].byteLength);
+    }
+}
+
+/*
+ * Return the hash recorded for @p level in @p *pHash.
+ */
+KTX_error_code
+getRecordedHash(ktxTexture2* This, ktx_uint32_t level, ktx_uint64_t* pHash)
+{
+    unsigned int valueLen;
+    ktx_uint8_t* value;
+    KTX_error_code result;
+
+    result = ktxHashList_FindValue(&This->kvDataHead, KTX_LEVEL_HASHES_KEY,
+                                   &valueLen, (void**)&value);
+    if (result != KTX_SUCCESS)
+        return result;
+    if (valueLen != This->numLevels * sizeof(ktx_uint64_t))
+        return KTX_FILE_DATA_ERROR;
+    *pHash = read64(value + level * sizeof(ktx_uint64_t));
+    return KTX_SUCCESS;
+}
+
+/*
+ * Read the data of levels @p firstLevel to @p lastLevel, as stored in the
+ * file, from the texture's source stream. Offsets in the returned buffer
+ * are those of the level index less the offset of @p lastLevel.
+ */
+KTX_error_code
+readStoredLevels(ktxTexture2* This, ktx_uint32_t firstLevel,
+                 ktx_uint32_t lastLevel, std::vector<ktx_uint8_t>& data)
+{
+    ktxTexture_protected* prtctd = This->_protected;
+    ktxTexture2_private* priv = This->_private;
+    const ktxLevelIndexEntry* index = priv->_levelIndex;
+    // Levels are stored smallest first.
+    ktx_uint64_t start = index[lastLevel].byteOffset;
+    ktx_uint64_t end = index[firstLevel].byteOffset
+                     + index[firstLevel].byteLength;
+    KTX_error_code result;
+
+    try {
+        data.resize(end - start);
+    } catch (std::bad_alloc&) {
+        return KTX_OUT_OF_MEMORY;
+    }
+    result = prtctd->_stream.setpos(&prtctd->_stream,
+                                    priv->_firstLevelFileOffset + start);
+    if (result != KTX_SUCCESS)
+        return result;
+    return prtctd->_stream.read(&prtctd->_stream, data.data(), data.size());
+}
+
+} // namespace
+
+/**
+ * @internal
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Compute the hash of each level of @p pData.
+ *
+ * Level @e n is the @c byteLength bytes at offset @c byteOffset of the
+ * texture's level index. Levels are hashed in parallel by up to
+ * @p threadCount threads.
+ *
+ * @param[in] This        pointer to the ktxTexture2 object of interest.
+ * @param[in] pData       pointer to the level data.
+ * @param[in] threadCount maximum number of threads to use. 0 means use
+ *                        as many as the hardware supports.
+ * @param[out] pHashes    array of numLevels hashes to fill.
+ */
+void
+ktxTexture2_calcLevelHashes(ktxTexture2* This, const ktx_uint8_t* pData,
+                            ktx_uint32_t threadCount, ktx_uint64_t* pHashes)
+{
+    hashJob job;
+    job.texture = This;
+    job.data = pData;
+    job.nextLevel = 0;
+    job.hashes = pHashes;
+
+    if (threadCount == 0)
+        threadCount = std::thread::hardware_concurrency();
+    threadCount = std::max(1U, std::min(threadCount, This->numLevels));
+    std::vector<std::thread> threads;
+    try {
+        for (ktx_uint32_t i = 1; i < threadCount; i++)
+            threads.emplace_back(hashWorker, &job);
+    } catch (std::system_error&) {
+        // Continue with the threads that were started.
+    }
+    hashWorker(&job);
+    for (auto& thread : threads)
+        thread.join();
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Return the content hash recorded for a level.
+ *
+ * The hash is the XXH64, with seed 0, of the level's data as stored in
+ * the file, i.e. after any supercompression. Identical hashes identify
+ * levels that can be shared between files.
+ *
+ * @param[in] This      pointer to the ktxTexture2 object of interest.
+ * @param[in] level     the level of interest.
+ * @param[out] pHash    pointer to where the hash will be written.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE  @p This or @p pHash is NULL or @p level is
+ *                               out of range.
+ * @exception KTX_NOT_FOUND      the texture has no level hashes.
+ * @exception KTX_FILE_DATA_ERROR the level hash metadata is the wrong size.
+ */
+KTX_error_code
+ktxTexture2_GetLevelHash(ktxTexture2* This, ktx_uint32_t level,
+                         ktx_uint64_t* pHash)
+{
+    if (This == nullptr || pHash == nullptr || level >= This->numLevels)
+        return KTX_INVALID_VALUE;
+
+    return getRecordedHash(This, level, pHash);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Check the data of a level against its recorded content hash.
+ *
+ * If the image data has not been loaded only the level of interest is read
+ * from the source stream. Otherwise the loaded data is checked. Since the
+ * hashes are of the stored data, they are removed when Zstd supercompressed
+ * data is inflated on load.
+ *
+ * @param[in] This      pointer to the ktxTexture2 object of interest.
+ * @param[in] level     the level to check.
+ *
+ * @return  KTX_SUCCESS if the data matches the hash, other KTX_* enum
+ *          values otherwise.
+ *
+ * @exception KTX_INVALID_VALUE     @p This is NULL or @p level is out of
+ *                                  range.
+ * @exception KTX_INVALID_OPERATION the texture has neither image data nor
+ *                                  a source stream.
+ * @exception KTX_NOT_FOUND         the texture has no level hashes.
+ * @exception KTX_FILE_DATA_ERROR   the level's data does not match its hash.
+ */
+KTX_error_code
+ktxTexture2_VerifyLevelHash(ktxTexture2* This, ktx_uint32_t level)
+{
+    if (This == nullptr || level >= This->numLevels)
+        return KTX_INVALID_VALUE;
+
+    ktx_uint64_t recorded;
+    KTX_error_code result = getRecordedHash(This, level, &recorded);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    const ktxLevelIndexEntry& entry = This->_private->_levelIndex[level];
+    ktx_uint64_t hash;
+    if (This->pData != nullptr) {
+        hash = xxh64(This->pData + entry.byteOffset, entry.byteLength);
+    } else if (This->_protected->_stream.data.file != nullptr) {
+        std::vector<ktx_uint8_t> data;
+        result = readStoredLevels(This, level, level, data);
+        if (result != KTX_SUCCESS)
+            return result;
+        hash = xxh64(data.data(), data.size());
+    } else {
+        return KTX_INVALID_OPERATION;
+    }
+    return hash == recorded ? KTX_SUCCESS : KTX_FILE_DATA_ERROR;
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Check the data of every level against its recorded content hash.
+ *
+ * Levels are hashed in parallel by up to @p threadCount threads. If the
+ * image data has not been loaded it is read from the source stream into a
+ * temporary buffer. See ktxTexture2_VerifyLevelHash().
+ *
+ * @param[in] This        pointer to the ktxTexture2 object of interest.
+ * @param[in] threadCount maximum number of threads to use. 0 is treated
+ *                        as 1.
+ * @param[out] pBadLevel  if not NULL and a level does not match, set to
+ *                        the lowest numbered such level.
+ *
+ * @return  KTX_SUCCESS if all levels match their hashes, other KTX_* enum
+ *          values otherwise.
+ *
+ * @exception KTX_INVALID_VALUE     @p This is NULL.
+ * @exception KTX_INVALID_OPERATION the texture has neither image data nor
+ *                                  a source stream.
+ * @exception KTX_NOT_FOUND         the texture has no level hashes.
+ * @exception KTX_FILE_DATA_ERROR   a level's data does not match its hash
+ *                                  or the hash metadata is the wrong size.
+ * @exception KTX_OUT_OF_MEMORY     not enough memory to read the data.
+ */
+KTX_error_code
+ktxTexture2_VerifyLevelHashes(ktxTexture2* This, ktx_uint32_t threadCount,
+                              ktx_uint32_t* pBadLevel)
+{
+    if (This == nullptr)
+        return KTX_INVALID_VALUE;
+
+    ktx_uint64_t recorded;
+    KTX_error_code result = getRecordedHash(This, 0, &recorded);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    std::vector<ktx_uint8_t> data;
+    const ktx_uint8_t* pData;
+    if (This->pData != nullptr) {
+        pData = This->pData;
+    } else if (This->_protected->_stream.data.file != nullptr) {
+        // A stream cannot be shared between threads so read everything.
+        result = readStoredLevels(This, 0, This->numLevels - 1, data);
+        if (result != KTX_SUCCESS)
+            return result;
+        // The smallest level is first so offsets are unchanged.
+        assert(This->_private->_levelIndex[This->numLevels - 1].byteOffset
+               == 0);
+        pData = data.data();
+    } else {
+        return KTX_INVALID_OPERATION;
+    }
+
+    std::vector<ktx_uint64_t> hashes;
+    try {
+        hashes.resize(This->numLevels);
+    } catch (std::bad_alloc&) {
+        return KTX_OUT_OF_MEMORY;
+    }
+    ktxTexture2_calcLevelHashes(This, pData, std::max(1U, threadCount),
+                                hashes.data());
+
+    for (ktx_uint32_t level = 0; level < This->numLevels; level++) {
+        getRecordedHash(This, level, &recorded);
+        if (hashes[level] != recorded) {
+            if (pBadLevel != nullptr)
+                *pBadLevel = level;
+            return KTX_FILE_DATA_ERROR;
+        }
+    }
+    return KTX_SUCCESS;
+}
@@ -0,0 +1,258 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2010-2020 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file redeflate.cpp
+ * @~English
+ *
+ * @brief Function for changing the Zstd compression level or filter of
+ *        already deflated image data without inflating the whole texture.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <zstd.h>
+#include <zstd_errors.h>
+
+#include "ktx.h"
+#include "ktxint.h"
+#include "texture2.h"
+
+namespace {
+
+struct redeflateJob {
+    ktxTexture2* texture;
+    const ktx_uint8_t* deflatedData;
+    ktx_uint32_t compressionLevel;
+    ktx_zstd_filter_e filter;
+    std::atomic<ktx_int32_t> nextLevel;
+    std::vector<std::vector<ktx_uint8_t>> redeflated;
+    std::vector<KTX_error_code> results;
+};
+
+/*
+ * Inflate, unfilter, refilter and deflate one level. Only the buffers for
+ * this level are allocated.
+ */
+KTX_error_code
+redeflateLevel(redeflateJob& job, ktx_uint32_t level,
+               ZSTD_DCtx* dctx, ZSTD_CCtx* cctx)
+{
+    ktxTexture2* This = job.texture;
+    const ktxLevelIndexEntry& entry = This->_private->_levelIndex[level];
+    std::vector<ktx_uint8_t> inflated, filtered;
+    const ktx_uint8_t* pSrc;
+    size_t result;
+
+    try {
+        inflated.resize(entry.uncompressedByteLength);
+    } catch (std::bad_alloc&) {
+        return KTX_OUT_OF_MEMORY;
+    }
+    result = ZSTD_decompressDCtx(dctx, inflated.data(), inflated.size(),
+                                 job.deflatedData + entry.byteOffset,
+                                 entry.byteLength);
+    if (ZSTD_isError(result)) {
+        if (ZSTD_getErrorCode(result) == ZSTD_error_memory_allocation)
+            return KTX_OUT_OF_MEMORY;
+        return KTX_FILE_DATA_ERROR;
+    }
+    if (result != inflated.size())
+        return KTX_FILE_DATA_ERROR;
+
+    KTX_error_code kresult =
+        ktxTexture2_unfilterInflatedData(This, level, inflated.data(),
+                                         inflated.size());
+    if (kresult != KTX_SUCCESS)
+        return kresult;
+
+    pSrc = inflated.data();
+    if (job.filter != KTX_ZSTD_FILTER_NONE) {
+        try {
+            filtered.resize(inflated.size());
+        } catch (std::bad_alloc&) {
+            return KTX_OUT_OF_MEMORY;
+        }
+        ktxTexture2_filterLevelData(This, level, job.filter, pSrc,
+                                    filtered.data(), filtered.size());
+        pSrc = filtered.data();
+    }
+
+    std::vector<ktx_uint8_t>& out = job.redeflated[level];
+    try {
+        out.resize(ZSTD_compressBound(inflated.size()));
+    } catch (std::bad_alloc&) {
+        return KTX_OUT_OF_MEMORY;
+    }
+    // Use the same call as ktxTexture2_DeflateZstdFiltered so the output is
+    // identical to deflating the original data.
+    result = ZSTD_compressCCtx(cctx, out.data(), out.size(),
+                               pSrc, inflated.size(), job.compressionLevel);
+    if (ZSTD_isError(result))
+        return ktxZstdErrorToKtx(result);
+    out.resize(result);
+    out.shrink_to_fit();
+    return KTX_SUCCESS;
+}
+
+void
+redeflateWorker(redeflateJob* job)
+{
+    ZSTD_DCtx* dctx = ZSTD_createDCtx();
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    ktx_int32_t level;
+
+    // Level 0 is the largest so start there for better load balancing.
+    while ((level = job->nextLevel++) < (ktx_int32_t)job->texture->numLevels) {
+        if (dctx == nullptr || cctx == nullptr)
+            job->results[level] = KTX_OUT_OF_MEMORY;
+        else
+            job->results[level] = redeflateLevel(*job, level, dctx, cctx);
+    }
+    ZSTD_freeDCtx(dctx);
+    ZSTD_freeCCtx(cctx);
+}
+
+} // namespace
+
+/**
+ * @memberof ktxTexture2
+ * @ingroup writer
+ * @~English
+ * @brief Re-deflate Zstd supercompressed image data with a different
+ *        compression level or filter.
+ *
+ * @p This must have been created from a stream without
+ * KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT and its supercompressionScheme must
+ * be KTX_SS_ZSTD or one of the libktx filtered Zstd schemes. The deflated
+ * data is read from the stream and each level is inflated, unfiltered,
+ * filtered with @p filter and deflated again independently, so only one
+ * inflated level per thread is in memory at any time. Levels are processed
+ * in parallel by up to @p threadCount threads.
+ *
+ * The result is identical to loading the image data and then calling
+ * ktxTexture2_DeflateZstdFiltered() with the same @p level and @p filter.
+ * On success the texture holds the new deflated data and its source stream
+ * is released, as after ktxTexture_LoadImageData().
+ *
+ * @param[in] This        pointer to the ktxTexture2 object of interest.
+ * @param[in] level       set speed vs compression ratio trade-off. Values
+ *                        between 1 and 22 are accepted. The lower the level
+ *                        the faster.
+ * @param[in] filter      the filter to apply before deflation.
+ * @param[in] threadCount maximum number of threads to use. 0 is treated
+ *                        as 1.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE     @p This is NULL or @p filter is not a
+ *                                  valid filter.
+ * @exception KTX_INVALID_OPERATION the texture's data is not Zstd
+ *                                  supercompressed, the data has already
+ *                                  been loaded, the texture was not created
+ *                                  from a stream or @p filter is not
+ *                                  supported for the texture's format.
+ * @exception KTX_FILE_DATA_ERROR   the deflated data is corrupt.
+ * @exception KTX_OUT_OF_MEMORY     not enough memory for the new data.
+ */
+KTX_error_code
+ktxTexture2_RedeflateZstd(ktxTexture2* This, ktx_uint32_t level,
+                          ktx_zstd_filter_e filter, ktx_uint32_t threadCount)
+{
+    if (This == nullptr)
+        return KTX_INVALID_VALUE;
+
+    if (This->classId != ktxTexture2_c
+        || !IS_ZSTD_SCHEME(This->supercompressionScheme))
+        return KTX_INVALID_OPERATION;
+
+    ktxTexture_protected* prtctd = This->_protected;
+    ktxTexture2_private* priv = This->_private;
+    if (This->pData != nullptr || prtctd->_stream.data.file == nullptr)
+        // Data already loaded or texture not created from a stream.
+        return KTX_INVALID_OPERATION;
+
+    ktxSupercmpScheme newScheme;
+    KTX_error_code result = ktxTexture2_zstdFilterScheme(This, filter,
+                                                         &newScheme);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    // The deflated data is small enough to read at once and a stream
+    // cannot be shared between threads.
+    std::vector<ktx_uint8_t> deflated;
+    try {
+        deflated.resize(This->dataSize);
+    } catch (std::bad_alloc&) {
+        return KTX_OUT_OF_MEMORY;
+    }
+    result = prtctd->_stream.setpos(&prtctd->_stream,
+                                    priv->_firstLevelFileOffset);
+    if (result != KTX_SUCCESS)
+        return result;
+    result = prtctd->_stream.read(&prtctd->_stream, deflated.data(),
+                                  deflated.size());
+    if (result != KTX_SUCCESS)
+        return result;
+
+    redeflateJob job;
+    job.texture = This;
+    job.deflatedData = deflated.data();
+    job.compressionLevel = level;
+    job.filter = filter;
+    job.nextLevel = 0;
+    job.redeflated.resize(This->numLevels);
+    job.results.resize(This->numLevels, KTX_SUCCESS);
+
+    threadCount = std::max(1U, std::min(threadCount, This->numLevels));
+    std::vector<std::thread> threads;
+    try {
+        for (ktx_uint32_t i = 1; i < threadCount; i++)
+            threads.emplace_back(redeflateWorker, &job);
+    } catch (std::system_error&) {
+        // Continue with the threads that were started.
+    }
+    redeflateWorker(&job);
+    for (auto& thread : threads)
+        thread.join();
+
+    ktx_size_t dataSize = 0;
+    for (ktx_uint32_t i = 0; i < This->numLevels; i++) {
+        if (job.results[i] != KTX_SUCCESS)
+            return job.results[i];
+        dataSize += job.redeflated[i].size();
+    }
+
+    ktx_uint8_t* pData = (ktx_uint8_t*)malloc(dataSize);
+    if (pData == nullptr)
+        return KTX_OUT_OF_MEMORY;
+
+    // Smallest level first, matching ktxTexture2_DeflateZstdFiltered.
+    ktx_size_t levelOffset = 0;
+    for (ktx_int32_t i = This->numLevels - 1; i >= 0; i--) {
+        std::vector<ktx_uint8_t>& levelData = job.redeflated[i];
+        memcpy(pData + levelOffset, levelData.data(), levelData.size());
+        priv->_levelIndex[i].byteOffset = levelOffset;
+        priv->_levelIndex[i].byteLength = levelData.size();
+        levelOffset += levelData.size();
+    }
+
+    This->pData = pData;
+    This->dataSize = dataSize;
+    This->supercompressionScheme = newScheme;
+    priv->_requiredLevelAlignment = 1;
+    // No further need for stream or file offset.
+    prtctd->_stream.destruct(&prtctd->_stream);
+    priv->_firstLevelFileOffset = 0;
+    return KTX_SUCCESS;
+}
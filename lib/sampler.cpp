@@ -0,0 +1,524 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2010-2020 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file sampler.cpp
+ * @~English
+ *
+ * @brief Functions for sampling textures on the CPU directly from their
+ *        block-compressed data.
+ *
+ * Blocks are decoded with the decoders used by
+ * ktxTexture2_DecodeBlockCompressed() when a sample first touches them and
+ * kept in a small direct mapped cache owned by the sampler.
+ *
+ * The decoders are the scalar ones. There are no SIMD block decoders; the
+ * saving comes from decoding only the blocks that are sampled.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <new>
+#include <vector>
+#include <KHR/khr_df.h>
+
+#include "ktx.h"
+#include "ktxint.h"
+#include "texture2.h"
+#include "vkformat_enum.h"
+#include "block_decode.h"
+
+#include "astc-encoder/Source/astcenc.h"
+
+using basisu::color_rgba;
+
+struct ktxTextureSampler {
+    ktxTexture2* texture;
+    ktxSamplerParams params;
+    bool compressed;
+    blockCodec codec;
+    bool sRGB;
+    ktx_uint32_t blockWidth;
+    ktx_uint32_t blockHeight;
+    ktx_uint32_t blockBytes;
+    // Components in each texel of uncompressed textures.
+    ktx_uint32_t numComponents;
+    astcenc_context* astcContext;
+    // Offset of each level's first image in texture->pData and the size
+    // of the level's images.
+    std::vector<ktx_size_t> levelOffsets;
+    std::vector<ktx_size_t> imageSizes;
+    // Direct mapped cache of decoded blocks, keyed by their offset in
+    // texture->pData.
+    ktx_uint32_t cacheShift;
+    std::vector<ktx_size_t> cacheKeys;
+    std::vector<color_rgba> cacheTexels;
+    float unormTable[256];
+    float srgbTable[256];
+};
+
+namespace {
+
+const ktx_size_t emptyKey = ~(ktx_size_t)0;
+// Larger requests for ktxSamplerParams::cacheBlocks are clamped to this.
+const ktx_uint32_t maxCacheBlocks = 1u << 20;
+
+bool
+lookupUncompressed(VkFormat vkFormat, ktx_uint32_t& numComponents)
+{
+    switch (vkFormat) {
+      case VK_FORMAT_R8_UNORM:
+      case VK_FORMAT_R8_SRGB:
+        numComponents = 1; return true;
+      case VK_FORMAT_R8G8_UNORM:
+      case VK_FORMAT_R8G8_SRGB:
+        numComponents = 2; return true;
+      case VK_FORMAT_R8G8B8_UNORM:
+      case VK_FORMAT_R8G8B8_SRGB:
+        numComponents = 3; return true;
+      case VK_FORMAT_R8G8B8A8_UNORM:
+      case VK_FORMAT_R8G8B8A8_SRGB:
+        numComponents = 4; return true;
+      default:
+        return false;
+    }
+}
+
+/* Map texel coordinate @p i to [0, @p size) as @p mode says. */
+inline ktx_int32_t
+wrapCoord(ktx_int32_t i, ktx_int32_t size, ktxSamplerAddressMode mode)
+{
+    switch (mode) {
+      case KTX_SAMPLER_ADDRESS_MIRRORED_REPEAT: {
+        ktx_int32_t m = i % (2 * size);
+        if (m < 0)
+            m += 2 * size;
+        return m < size ? m : 2 * size - 1 - m;
+      }
+      case KTX_SAMPLER_ADDRESS_CLAMP_TO_EDGE:
+        return std::min(std::max(i, 0), size - 1);
+      default: {
+        ktx_int32_t m = i % size;
+        return m < 0 ? m + size : m;
+      }
+    }
+}
+
+/* Reduce texel space coordinate @p u, which must be finite, to a range that
+ * fits in ktx_int32_t without changing the texels @p mode maps it to. */
+inline float
+reduceCoord(float u, ktx_int32_t size, ktxSamplerAddressMode mode)
+{
+    switch (mode) {
+      case KTX_SAMPLER_ADDRESS_MIRRORED_REPEAT:
+        // fmod is exact so the fraction, i.e. the filter weight, is kept.
+        return std::fmod(u, 2.0f * size);
+      case KTX_SAMPLER_ADDRESS_CLAMP_TO_EDGE:
+        return std::min(std::max(u, -1.0f), (float)size);
+      default:
+        return std::fmod(u, (float)size);
+    }
+}
+
+/* Convert a decoded texel to float, linearizing sRGB color components. */
+inline void
+texelToFloat(const ktxTextureSampler& sampler, const color_rgba& texel,
+             float rgba[4])
+{
+    const float* colorTable = sampler.sRGB ? sampler.srgbTable
+                                           : sampler.unormTable;
+    rgba[0] = colorTable[texel.r];
+    rgba[1] = colorTable[texel.g];
+    rgba[2] = colorTable[texel.b];
+    rgba[3] = sampler.unormTable[texel.a];
+}
+
+/* Return the decoded block at @p blockOffset, decoding it if needed. */
+const color_rgba*
+fetchBlock(ktxTextureSampler& sampler, ktx_size_t blockOffset)
+{
+    ktx_uint32_t blockTexels = sampler.blockWidth * sampler.blockHeight;
+    ktx_size_t blockIndex = blockOffset / sampler.blockBytes;
+    ktx_size_t slot = (ktx_size_t)(((ktx_uint64_t)blockIndex
+                                    * 0x9E3779B97F4A7C15ULL)
+                                   >> sampler.cacheShift);
+    color_rgba* texels = &sampler.cacheTexels[slot * blockTexels];
+
+    if (sampler.cacheKeys[slot] == blockOffset)
+        return texels;
+
+    const ktx_uint8_t* block = sampler.texture->pData + blockOffset;
+    for (ktx_uint32_t i = 0; i < blockTexels; i++)
+        texels[i].set(0, 0, 0, 255);
+    if (sampler.codec == blockCodec::astc) {
+        void* slices[1] = { texels };
+        astcenc_image out;
+        out.dim_x = sampler.blockWidth;
+        out.dim_y = sampler.blockHeight;
+        out.dim_z = 1;
+        out.data_type = ASTCENC_TYPE_U8;
+        out.data = slices;
+        const astcenc_swizzle swizzle{ASTCENC_SWZ_R, ASTCENC_SWZ_G,
+                                      ASTCENC_SWZ_B, ASTCENC_SWZ_A};
+        if (astcenc_decompress_image(sampler.astcContext, block,
+                                     sampler.blockBytes, &out, &swizzle, 0)
+            != ASTCENC_SUCCESS) {
+            sampler.cacheKeys[slot] = emptyKey;
+            return nullptr;
+        }
+    } else if (!decodeBlock(sampler.codec, block, sampler.sRGB, texels)) {
+        sampler.cacheKeys[slot] = emptyKey;
+        return nullptr;
+    }
+    sampler.cacheKeys[slot] = blockOffset;
+    return texels;
+}
+
+/* Fetch texel (@p x, @p y) of the image at @p imageOffset in @p level. */
+KTX_error_code
+fetchTexel(ktxTextureSampler& sampler, ktx_uint32_t level,
+           ktx_size_t imageOffset, ktx_uint32_t x, ktx_uint32_t y,
+           float rgba[4])
+{
+    ktx_uint32_t width = MAX(1, sampler.texture->baseWidth >> level);
+
+    if (!sampler.compressed) {
+        const ktx_uint8_t* texel = sampler.texture->pData + imageOffset
+                                 + ((ktx_size_t)y * width + x)
+                                   * sampler.numComponents;
+        color_rgba decoded(0, 0, 0, 255);
+        for (ktx_uint32_t c = 0; c < sampler.numComponents; c++)
+            decoded[c] = texel[c];
+        texelToFloat(sampler, decoded, rgba);
+        return KTX_SUCCESS;
+    }
+
+    ktx_uint32_t blocksX = (width + sampler.blockWidth - 1)
+                           / sampler.blockWidth;
+    ktx_uint32_t bx = x / sampler.blockWidth;
+    ktx_uint32_t by = y / sampler.blockHeight;
+    const color_rgba* texels
+        = fetchBlock(sampler, imageOffset
+                              + ((ktx_size_t)by * blocksX + bx)
+                                * sampler.blockBytes);
+    if (texels == nullptr)
+        return KTX_FILE_DATA_ERROR;
+    texelToFloat(sampler, texels[(y % sampler.blockHeight) * sampler.blockWidth
+                                 + x % sampler.blockWidth], rgba);
+    return KTX_SUCCESS;
+}
+
+/* Sample one level with the sampler's filter. */
+KTX_error_code
+sampleLevel(ktxTextureSampler& sampler, ktx_uint32_t level,
+            ktx_uint32_t image, float s, float t, float rgba[4])
+{
+    const ktxSamplerParams& params = sampler.params;
+    ktx_int32_t width = MAX(1, sampler.texture->baseWidth >> level);
+    ktx_int32_t height = MAX(1, sampler.texture->baseHeight >> level);
+    ktx_size_t imageOffset = sampler.levelOffsets[level]
+                           + image * sampler.imageSizes[level];
+
+    // s and t are finite but scaling may overflow.
+    if (!std::isfinite(s * width) || !std::isfinite(t * height))
+        return KTX_INVALID_VALUE;
+
+    if (params.filter == KTX_SAMPLER_FILTER_NEAREST) {
+        float u = reduceCoord(s * width, width, params.addressModeU);
+        float v = reduceCoord(t * height, height, params.addressModeV);
+        ktx_int32_t x = wrapCoord((ktx_int32_t)std::floor(u), width,
+                                  params.addressModeU);
+        ktx_int32_t y = wrapCoord((ktx_int32_t)std::floor(v), height,
+                                  params.addressModeV);
+        return fetchTexel(sampler, level, imageOffset, x, y, rgba);
+    }
+
+    float u = reduceCoord(s * width - 0.5f, width, params.addressModeU);
+    float v = reduceCoord(t * height - 0.5f, height, params.addressModeV);
+    float fu = std::floor(u);
+    float fv = std::floor(v);
+    float a = u - fu;
+    float b = v - fv;
+    ktx_int32_t xs[2], ys[2];
+    xs[0] = wrapCoord((ktx_int32_t)fu, width, params.addressModeU);
+    xs[1] = wrapCoord((ktx_int32_t)fu + 1, width, params.addressModeU);
+    ys[0] = wrapCoord((ktx_int32_t)fv, height, params.addressModeV);
+    ys[1] = wrapCoord((ktx_int32_t)fv + 1, height, params.addressModeV);
+    const float weights[4] = { (1 - a) * (1 - b), a * (1 - b),
+                               (1 - a) * b, a * b };
+
+    for (ktx_uint32_t c = 0; c < 4; c++)
+        rgba[c] = 0.0f;
+    for (ktx_uint32_t i = 0; i < 4; i++) {
+        float texel[4];
+        KTX_error_code result = fetchTexel(sampler, level, imageOffset,
+                                           xs[i & 1], ys[i >> 1], texel);
+        if (result != KTX_SUCCESS)
+            return result;
+        for (ktx_uint32_t c = 0; c < 4; c++)
+            rgba[c] += weights[i] * texel[c];
+    }
+    return KTX_SUCCESS;
+}
+
+} // namespace
+
+/**
+ * @memberof ktxTexture2
+ * @ingroup writer
+ * @~English
+ * @brief Create a sampler for fetching filtered texels on the CPU.
+ *
+ * Samples are taken directly from the texture's images. Block-compressed
+ * images are not decoded up front. Instead each block is decoded when a
+ * sample first touches it and kept in a cache of
+ * @c params->cacheBlocks blocks, so memory use stays close to the size of
+ * the compressed data.
+ *
+ * The following formats are supported: the UNORM and SRGB variants of
+ * BC1, BC2, BC3, BC7, ETC2 and the 2D ASTC LDR formats, the UNORM variants
+ * of BC4, BC5 and EAC, UASTC and the 8-bit UNORM and SRGB R, RG, RGB and
+ * RGBA formats. Textures supercompressed with BasisLZ must be transcoded
+ * first. Zstd and zlib supercompressed textures are inflated when their
+ * data is loaded.
+ *
+ * If the image data has not been loaded it is loaded into the texture.
+ * The texture must outlive the sampler and its data must not be changed
+ * while the sampler exists.
+ *
+ * A sampler is not thread safe. Create one per thread. Several samplers
+ * may share a texture whose data is loaded.
+ *
+ * @param[in] This        pointer to the ktxTexture2 object to sample.
+ * @param[in] params      pointer to the sampling parameters.
+ * @param[in,out] newSampler pointer to a location in which to store the
+ *                        address of the new sampler.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE     @p This, @p params or @p newSampler is
+ *                                  NULL, @c params->structSize is wrong or
+ *                                  a filter or address mode is invalid.
+ * @exception KTX_UNSUPPORTED_TEXTURE_TYPE
+ *                                  The texture is 3D or its format or
+ *                                  supercompression scheme is not
+ *                                  supported.
+ * @exception KTX_OUT_OF_MEMORY     Not enough memory for the sampler.
+ */
+extern "C" KTX_error_code
+ktxTexture2_CreateSampler(ktxTexture2* This, const ktxSamplerParams* params,
+                          ktxTextureSampler** newSampler)
+{
+    KTX_error_code result;
+
+    if (This == nullptr || params == nullptr || newSampler == nullptr)
+        return KTX_INVALID_VALUE;
+    if (params->structSize != sizeof(struct ktxSamplerParams))
+        return KTX_INVALID_VALUE;
+    if (params->filter > KTX_SAMPLER_FILTER_LINEAR
+        || params->mipmapFilter > KTX_SAMPLER_FILTER_LINEAR
+        || params->addressModeU > KTX_SAMPLER_ADDRESS_CLAMP_TO_EDGE
+        || params->addressModeV > KTX_SAMPLER_ADDRESS_CLAMP_TO_EDGE)
+        return KTX_INVALID_VALUE;
+    *newSampler = nullptr;
+
+    if (This->numDimensions == 3
+        || This->supercompressionScheme == KTX_SS_BASIS_LZ)
+        return KTX_UNSUPPORTED_TEXTURE_TYPE;
+
+    blockCodec codec = blockCodec::bc1;
+    ktx_uint32_t numComponents = 4;
+    bool compressed = true;
+    const ktxFormatSize& formatSize = This->_protected->_formatSize;
+    if (KHR_DFDVAL(This->pDfd + 1, MODEL) == KHR_DF_MODEL_UASTC) {
+        codec = blockCodec::uastc;
+    } else if (lookupBlockCodec((VkFormat)This->vkFormat, codec,
+                                numComponents)) {
+        if (formatSize.blockDepth > 1)
+            return KTX_UNSUPPORTED_TEXTURE_TYPE;
+    } else if (lookupUncompressed((VkFormat)This->vkFormat, numComponents)) {
+        compressed = false;
+    } else {
+        return KTX_UNSUPPORTED_TEXTURE_TYPE;
+    }
+
+    if (This->pData == nullptr) {
+        result = ktxTexture2_LoadImageData(This, nullptr, 0);
+        if (result != KTX_SUCCESS)
+            return result;
+    }
+    // Loading inflates zstd data but data loaded before, or deflated since,
+    // is still supercompressed and can't be sampled.
+    if (This->supercompressionScheme != KTX_SS_NONE)
+        return KTX_UNSUPPORTED_TEXTURE_TYPE;
+
+    ktxTextureSampler* sampler = new (std::nothrow) ktxTextureSampler;
+    if (sampler == nullptr)
+        return KTX_OUT_OF_MEMORY;
+    sampler->texture = This;
+    sampler->params = *params;
+    sampler->compressed = compressed;
+    sampler->codec = codec;
+    sampler->sRGB = KHR_DFDVAL(This->pDfd + 1, TRANSFER)
+                    == KHR_DF_TRANSFER_SRGB;
+    sampler->blockWidth = formatSize.blockWidth;
+    sampler->blockHeight = formatSize.blockHeight;
+    sampler->blockBytes = formatSize.blockSizeInBits / 8;
+    sampler->numComponents = numComponents;
+    sampler->astcContext = nullptr;
+    for (ktx_uint32_t i = 0; i < 256; i++) {
+        float c = i / 255.0f;
+        sampler->unormTable[i] = c;
+        sampler->srgbTable[i] = c <= 0.04045f
+                              ? c / 12.92f
+                              : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    // A power of 2, at least 2, so the hash can be shifted down to a slot.
+    // Clamped to maxCacheBlocks so the shift can't overflow.
+    const ktx_uint32_t wantedBlocks = params->cacheBlocks
+                                    ? std::min(params->cacheBlocks,
+                                               maxCacheBlocks)
+                                    : 64;
+    ktx_uint32_t cacheBlocks = 2;
+    sampler->cacheShift = 63;
+    while (cacheBlocks < wantedBlocks) {
+        cacheBlocks <<= 1;
+        sampler->cacheShift--;
+    }
+    try {
+        for (ktx_uint32_t level = 0; level < This->numLevels; level++) {
+            ktx_size_t offset;
+            result = ktxTexture2_GetImageOffset(This, level, 0, 0, &offset);
+            if (result != KTX_SUCCESS) {
+                delete sampler;
+                return result;
+            }
+            sampler->levelOffsets.push_back(offset);
+            sampler->imageSizes.push_back(
+                    ktxTexture_GetImageSize(ktxTexture(This), level));
+        }
+        if (compressed) {
+            sampler->cacheKeys.assign(cacheBlocks, emptyKey);
+            sampler->cacheTexels.resize((size_t)cacheBlocks
+                                        * sampler->blockWidth
+                                        * sampler->blockHeight);
+        }
+    } catch (std::bad_alloc&) {
+        delete sampler;
+        return KTX_OUT_OF_MEMORY;
+    }
+
+    if (codec == blockCodec::astc) {
+        astcenc_config config;
+        astcenc_error error = astcenc_config_init(
+                sampler->sRGB ? ASTCENC_PRF_LDR_SRGB : ASTCENC_PRF_LDR,
+                sampler->blockWidth, sampler->blockHeight, 1,
+                ASTCENC_PRE_FASTEST, ASTCENC_FLG_DECOMPRESS_ONLY, &config);
+        if (error == ASTCENC_SUCCESS)
+            error = astcenc_context_alloc(&config, 1, &sampler->astcContext);
+        if (error != ASTCENC_SUCCESS) {
+            delete sampler;
+            return error == ASTCENC_ERR_OUT_OF_MEM ? KTX_OUT_OF_MEMORY
+                                                   : KTX_INVALID_OPERATION;
+        }
+    } else if (codec == blockCodec::etc2a8 || codec == blockCodec::uastc) {
+        initBlockDecoders();
+    }
+
+    *newSampler = sampler;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTextureSampler
+ * @ingroup writer
+ * @~English
+ * @brief Sample a texture at normalized coordinates.
+ *
+ * Texels are filtered as described by the sampler's ktxSamplerParams. The
+ * result is RGBA in [0, 1]. Components the format lacks are 0 except alpha,
+ * which is 1. Color components of sRGB textures are converted to linear
+ * before filtering, as GPUs do. Texel centres are at half-integer
+ * coordinates. Cube maps are sampled one face at a time, without filtering
+ * across edges.
+ *
+ * @param[in] This   pointer to the sampler.
+ * @param[in] layer  array layer to sample.
+ * @param[in] face   cube map face to sample. 0 for other textures.
+ * @param[in] s      horizontal coordinate. 0 and 1 are the left and right
+ *                   edges of the image.
+ * @param[in] t      vertical coordinate. 0 and 1 are the first and last
+ *                   rows.
+ * @param[in] lod    level of detail. It is clamped to the levels of the
+ *                   texture.
+ * @param[out] rgba  the sampled color.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE     @p This or @p rgba is NULL, @p layer
+ *                                  or @p face is out of range or @p s or
+ *                                  @p t is not finite or too large to
+ *                                  scale to texels.
+ * @exception KTX_FILE_DATA_ERROR   A block could not be decoded.
+ */
+extern "C" KTX_error_code
+ktxTextureSampler_Sample(ktxTextureSampler* This, ktx_uint32_t layer,
+                         ktx_uint32_t face, float s, float t, float lod,
+                         float rgba[4])
+{
+    if (This == nullptr || rgba == nullptr)
+        return KTX_INVALID_VALUE;
+    ktxTexture2* texture = This->texture;
+    if (layer >= texture->numLayers || face >= texture->numFaces)
+        return KTX_INVALID_VALUE;
+    if (!std::isfinite(s) || !std::isfinite(t))
+        return KTX_INVALID_VALUE;
+
+    ktx_uint32_t image = layer * texture->numFaces + face;
+    float maxLod = (float)(texture->numLevels - 1);
+    if (!(lod > 0.0f))  // Also catches NaN.
+        lod = 0.0f;
+    lod = std::min(lod, maxLod);
+
+    if (This->params.mipmapFilter == KTX_SAMPLER_FILTER_NEAREST)
+        return sampleLevel(*This, (ktx_uint32_t)std::floor(lod + 0.5f),
+                           image, s, t, rgba);
+
+    ktx_uint32_t level = (ktx_uint32_t)lod;
+    float f = lod - level;
+    KTX_error_code result = sampleLevel(*This, level, image, s, t, rgba);
+    if (result != KTX_SUCCESS || f == 0.0f)
+        return result;
+    float next[4];
+    result = sampleLevel(*This, level + 1, image, s, t, next);
+    for (ktx_uint32_t c = 0; c < 4; c++)
+        rgba[c] += f * (next[c] - rgba[c]);
+    return result;
+}
+
+/**
+ * @memberof ktxTextureSampler
+ * @ingroup writer
+ * @~English
+ * @brief Destroy a sampler made by ktxTexture2_CreateSampler.
+ *
+ * The texture is not destroyed.
+ *
+ * @param[in] This pointer to the sampler. May be NULL.
+ */
+extern "C" void
+ktxTextureSampler_Destroy(ktxTextureSampler* This)
+{
+    if (This == nullptr)
+        return;
+    if (This->astcContext)
+        astcenc_context_free(This->astcContext);
+    delete This;
+}
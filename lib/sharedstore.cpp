@@ -0,0 +1,479 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2010-2020 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file sharedstore.cpp
+ * @~English
+ *
+ * @brief Named shared memory regions holding KTX files and the ktxTexture2
+ *        functions for viewing them from several processes.
+ *
+ * Each region is a POSIX shared memory object. Its first page holds a
+ * header with the region's state and the count of attached views. The KTX
+ * file follows at the start of the second page so it can be mapped
+ * separately, read-only, by the viewing processes.
+ */
+
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <string>
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "ktx.h"
+#include "ktxint.h"
+#include "sharedstore.h"
+#include "texture2.h"
+
+#if !defined(_WIN32)
+
+namespace {
+
+const ktx_uint8_t sharedIdentifier[8] = {
+    0xAB, 'K', 'T', 'X', 'S', 'H', 'M', 0xBB
+};
+
+enum sharedState : ktx_uint32_t {
+    eSharedWriting = 0, // Zero-filled by ftruncate.
+    eSharedReady = 1,
+    eSharedInvalid = 2
+};
+
+struct sharedHeader {
+    ktx_uint8_t identifier[8];
+    std::atomic<ktx_uint32_t> state;
+    std::atomic<ktx_uint32_t> refCount;
+    ktx_uint64_t fileOffset;
+    ktx_uint64_t fileSize;
+};
+
+// The header is shared between processes so its atomics must not need
+// a process-local lock.
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "Lock-free 32-bit atomics needed.");
+
+/*
+ * Return the shared memory object name for @p name or an empty string if
+ * @p name is not usable.
+ */
+std::string
+objectName(const char* name)
+{
+    if (name == nullptr || *name == '\0' || strchr(name, '/') != nullptr
+        || strlen(name) > 200)
+        return std::string();
+    return std::string("/") + name;
+}
+
+KTX_error_code
+openError()
+{
+    return errno == ENOENT ? KTX_NOT_FOUND : KTX_FILE_OPEN_FAILED;
+}
+
+/*
+ * Map the header of the region called @p name. The region has to be fully
+ * created, though not necessarily published.
+ */
+KTX_error_code
+mapHeader(const char* name, sharedHeader** ppHeader, int* pFd)
+{
+    std::string path = objectName(name);
+    if (path.empty())
+        return KTX_INVALID_VALUE;
+
+    int fd = shm_open(path.c_str(), O_RDWR, 0);
+    if (fd < 0)
+        return openError();
+
+    struct stat st;
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if (fstat(fd, &st) != 0 || st.st_size < pageSize) {
+        // Still being created.
+        close(fd);
+        return KTX_NOT_FOUND;
+    }
+    void* header = mmap(nullptr, pageSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, fd, 0);
+    if (header == MAP_FAILED) {
+        close(fd);
+        return KTX_FILE_OPEN_FAILED;
+    }
+    *ppHeader = static_cast<sharedHeader*>(header);
+    if (pFd != nullptr)
+        *pFd = fd;
+    else
+        close(fd);
+    return KTX_SUCCESS;
+}
+
+void
+unmapHeader(sharedHeader* header)
+{
+    munmap(header, sysconf(_SC_PAGESIZE));
+}
+
+} // namespace
+
+struct ktxSharedRegion {
+    sharedHeader* header;
+    ktx_uint8_t* data;
+    ktx_size_t dataSize;
+};
+
+KTX_error_code
+ktxSharedRegion_create(const char* name, ktx_size_t size,
+                       ktxSharedRegion** ppRegion, ktx_uint8_t** ppData)
+{
+    std::string path = objectName(name);
+    if (path.empty())
+        return KTX_INVALID_VALUE;
+
+    long pageSize = sysconf(_SC_PAGESIZE);
+    // Readers need write access to the header to count references.
+    int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        return errno == EEXIST ? KTX_INVALID_OPERATION : KTX_FILE_OPEN_FAILED;
+
+    KTX_error_code result = KTX_OUT_OF_MEMORY;
+    void* header = MAP_FAILED;
+    void* data = MAP_FAILED;
+    ktxSharedRegion* region = new (std::nothrow) ktxSharedRegion;
+    if (region == nullptr)
+        goto cleanup;
+    if (ftruncate(fd, pageSize + size) != 0)
+        goto cleanup;
+    header = mmap(nullptr, pageSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                  fd, 0);
+    if (header == MAP_FAILED)
+        goto cleanup;
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                fd, pageSize);
+    if (data == MAP_FAILED)
+        goto cleanup;
+    close(fd);
+
+    region->header = static_cast<sharedHeader*>(header);
+    region->data = static_cast<ktx_uint8_t*>(data);
+    region->dataSize = size;
+    memcpy(region->header->identifier, sharedIdentifier,
+           sizeof(sharedIdentifier));
+    region->header->fileOffset = pageSize;
+    region->header->fileSize = size;
+    *ppRegion = region;
+    *ppData = region->data;
+    return KTX_SUCCESS;
+
+cleanup:
+    if (header != MAP_FAILED)
+        munmap(header, pageSize);
+    close(fd);
+    shm_unlink(path.c_str());
+    delete region;
+    return result;
+}
+
+void
+ktxSharedRegion_publish(ktxSharedRegion* region)
+{
+    region->header->state.store(eSharedReady, std::memory_order_release);
+    munmap(region->data, region->dataSize);
+    unmapHeader(region->header);
+    delete region;
+}
+
+KTX_error_code
+ktxSharedRegion_attach(const char* name, ktxSharedRegion** ppRegion,
+                       const ktx_uint8_t** ppData, ktx_size_t* pSize)
+{
+    sharedHeader* header;
+    int fd;
+    KTX_error_code result = mapHeader(name, &header, &fd);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    struct stat st;
+    long pageSize = sysconf(_SC_PAGESIZE);
+    void* data;
+    ktxSharedRegion* region;
+    if (header->state.load(std::memory_order_acquire) != eSharedReady) {
+        result = KTX_NOT_FOUND;
+        goto cleanup;
+    }
+    if (memcmp(header->identifier, sharedIdentifier, sizeof(sharedIdentifier))
+        || header->fileOffset != (ktx_uint64_t)pageSize
+        || fstat(fd, &st) != 0
+        || (ktx_uint64_t)st.st_size < header->fileOffset + header->fileSize) {
+        result = KTX_FILE_DATA_ERROR;
+        goto cleanup;
+    }
+
+    header->refCount++;
+    // Don't hand out views of a region invalidated while attaching.
+    if (header->state.load(std::memory_order_acquire) != eSharedReady) {
+        header->refCount--;
+        result = KTX_NOT_FOUND;
+        goto cleanup;
+    }
+    data = mmap(nullptr, header->fileSize, PROT_READ, MAP_SHARED, fd,
+                header->fileOffset);
+    region = new (std::nothrow) ktxSharedRegion;
+    if (data == MAP_FAILED || region == nullptr) {
+        if (data != MAP_FAILED)
+            munmap(data, header->fileSize);
+        header->refCount--;
+        result = KTX_OUT_OF_MEMORY;
+        goto cleanup;
+    }
+    close(fd);
+    region->header = header;
+    region->data = static_cast<ktx_uint8_t*>(data);
+    region->dataSize = header->fileSize;
+    *ppRegion = region;
+    *ppData = region->data;
+    *pSize = region->dataSize;
+    return KTX_SUCCESS;
+
+cleanup:
+    unmapHeader(header);
+    close(fd);
+    return result;
+}
+
+void
+ktxSharedRegion_detach(ktxSharedRegion* region)
+{
+    region->header->refCount--;
+    munmap(region->data, region->dataSize);
+    unmapHeader(region->header);
+    delete region;
+}
+
+ktx_bool_t
+ktxSharedRegion_isValid(ktxSharedRegion* region)
+{
+    return region->header->state.load(std::memory_order_acquire)
+           == eSharedReady;
+}
+
+#else /* _WIN32 */
+
+// Not yet implemented on Windows where named file mappings would be used.
+
+KTX_error_code
+ktxSharedRegion_create(const char*, ktx_size_t, ktxSharedRegion**,
+                       ktx_uint8_t**)
+{
+    return KTX_INVALID_OPERATION;
+}
+
+void ktxSharedRegion_publish(ktxSharedRegion*) { }
+
+KTX_error_code
+ktxSharedRegion_attach(const char*, ktxSharedRegion**, const ktx_uint8_t**,
+                       ktx_size_t*)
+{
+    return KTX_INVALID_OPERATION;
+}
+
+void ktxSharedRegion_detach(ktxSharedRegion*) { }
+ktx_bool_t ktxSharedRegion_isValid(ktxSharedRegion*) { return KTX_FALSE; }
+
+#endif /* _WIN32 */
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Create a read-only view of a texture published in shared memory.
+ *
+ * The texture must have been published by ktxTexture2_PublishShared(),
+ * in this or another process. The image data of the new texture is not
+ * copied. @c pData points into a read-only mapping of the shared pages so
+ * any number of processes can view a texture while it occupies memory
+ * only once. The header, DFD and metadata are copied as usual.
+ *
+ * Each view holds a reference, see ktxTexture2_GetSharedRefCount(), that
+ * is dropped by ktxTexture_Destroy(). The image data must not be written
+ * through @c pData. Functions that replace the image data, such as
+ * ktxTexture2_TranscodeBasis() or ktxTexture2_DeflateZstd(), work on a
+ * private copy and drop the view's reference.
+ *
+ * @param[in] name        the name under which the texture was published.
+ * @param[in] createFlags bitmask requesting specific actions during
+ *                        creation. KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT
+ *                        is implied.
+ * @param[in,out] newTex  pointer to a location in which store the address
+ *                        of the newly created texture.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE     @p name is not a valid name or
+ *                                  @p newTex is NULL.
+ * @exception KTX_NOT_FOUND         no texture is published as @p name or
+ *                                  it has been invalidated.
+ * @exception KTX_INVALID_OPERATION shared textures are not supported on
+ *                                  this platform.
+ * @exception KTX_FILE_DATA_ERROR   the shared region is not a KTX texture.
+ * @exception KTX_OUT_OF_MEMORY     not enough memory for the texture.
+ */
+KTX_error_code
+ktxTexture2_CreateFromShared(const char* name,
+                             ktxTextureCreateFlags createFlags,
+                             ktxTexture2** newTex)
+{
+    if (newTex == nullptr)
+        return KTX_INVALID_VALUE;
+
+    ktxSharedRegion* region;
+    const ktx_uint8_t* bytes;
+    ktx_size_t size;
+    KTX_error_code result = ktxSharedRegion_attach(name, &region, &bytes,
+                                                   &size);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    ktxTexture2* tex;
+    result = ktxTexture2_CreateFromMemory(bytes, size,
+                        createFlags & ~KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                        &tex);
+    if (result != KTX_SUCCESS) {
+        ktxSharedRegion_detach(region);
+        return result;
+    }
+
+    ktxTexture_protected* prtctd = tex->_protected;
+    ktxTexture2_private* priv = tex->_private;
+    if (priv->_firstLevelFileOffset + tex->dataSize > size) {
+        ktxTexture2_Destroy(tex);
+        ktxSharedRegion_detach(region);
+        return KTX_FILE_DATA_ERROR;
+    }
+    // Point the image data at the shared pages, exactly as though it had
+    // been loaded from the file.
+    tex->pData = (ktx_uint8_t*)bytes + priv->_firstLevelFileOffset;
+    priv->_sharedRegion = region;
+    // No further need for stream or file offset.
+    prtctd->_stream.destruct(&prtctd->_stream);
+    priv->_firstLevelFileOffset = 0;
+    *newTex = tex;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Query whether a texture is a view of a shared texture that is
+ *        still valid.
+ *
+ * A publisher can invalidate a shared texture, e.g. because its source has
+ * changed, with ktxTexture2_InvalidateShared(). Existing views keep working
+ * but should be replaced by a view of the new version when this returns
+ * KTX_FALSE.
+ *
+ * @param[in] This      pointer to the ktxTexture2 object of interest.
+ *
+ * @return KTX_TRUE if @p This is a view of a texture that has not been
+ *         invalidated, KTX_FALSE otherwise.
+ */
+ktx_bool_t
+ktxTexture2_IsSharedViewValid(ktxTexture2* This)
+{
+    if (This == nullptr || This->_private->_sharedRegion == nullptr)
+        return KTX_FALSE;
+    return ktxSharedRegion_isValid(This->_private->_sharedRegion);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Return the number of views of a shared texture.
+ *
+ * Views created in all processes are counted. A view held by a process
+ * that exits without destroying it is never released so the count is a
+ * guide for deciding when to republish or invalidate, not a lifetime. The
+ * system keeps the pages of an invalidated texture until the last
+ * mapping has gone.
+ *
+ * @param[in] name      the name under which the texture was published.
+ * @param[out] pCount   pointer to where the count will be written.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE     @p name is not a valid name or
+ *                                  @p pCount is NULL.
+ * @exception KTX_NOT_FOUND         no texture is published as @p name.
+ * @exception KTX_INVALID_OPERATION shared textures are not supported on
+ *                                  this platform.
+ */
+KTX_error_code
+ktxTexture2_GetSharedRefCount(const char* name, ktx_uint32_t* pCount)
+{
+    if (pCount == nullptr)
+        return KTX_INVALID_VALUE;
+#if !defined(_WIN32)
+    sharedHeader* header;
+    KTX_error_code result = mapHeader(name, &header, nullptr);
+    if (result != KTX_SUCCESS)
+        return result;
+    *pCount = header->refCount.load();
+    unmapHeader(header);
+    return KTX_SUCCESS;
+#else
+    (void)name;
+    return KTX_INVALID_OPERATION;
+#endif
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Invalidate and remove a shared texture.
+ *
+ * The name is removed so no new views can be created and it can be used
+ * to publish a new version. Existing views remain usable, as the pages
+ * stay mapped, but ktxTexture2_IsSharedViewValid() returns KTX_FALSE for
+ * them.
+ *
+ * @param[in] name      the name under which the texture was published.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE     @p name is not a valid name.
+ * @exception KTX_NOT_FOUND         no texture is published as @p name.
+ * @exception KTX_INVALID_OPERATION shared textures are not supported on
+ *                                  this platform.
+ */
+KTX_error_code
+ktxTexture2_InvalidateShared(const char* name)
+{
+#if !defined(_WIN32)
+    sharedHeader* header;
+    KTX_error_code result = mapHeader(name, &header, nullptr);
+    if (result == KTX_SUCCESS) {
+        header->state.store(eSharedInvalid, std::memory_order_release);
+        unmapHeader(header);
+    } else if (result != KTX_NOT_FOUND) {
+        return result;
+    }
+    // Also removes a region left behind by a publisher that died while
+    // creating it.
+    if (shm_unlink(objectName(name).c_str()) != 0)
+        return openError();
+    return KTX_SUCCESS;
+#else
+    (void)name;
+    return KTX_INVALID_OPERATION;
+#endif
+}
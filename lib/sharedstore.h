@@ -0,0 +1,60 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2010-2020 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file sharedstore.h
+ * @~English
+ *
+ * @brief Internal interface to named shared memory regions holding KTX
+ *        files that several processes can map.
+ */
+
+#ifndef SHAREDSTORE_H
+#define SHAREDSTORE_H
+
+#include "ktx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A process's mapping of a shared region. Opaque outside sharedstore.cpp.
+ */
+typedef struct ktxSharedRegion ktxSharedRegion;
+
+/*
+ * Create a new region called @p name with room for a KTX file of @p size
+ * bytes. The region is not visible to ktxSharedRegion_attach() until
+ * ktxSharedRegion_publish() is called.
+ */
+KTX_error_code ktxSharedRegion_create(const char* name, ktx_size_t size,
+                                      ktxSharedRegion** ppRegion,
+                                      ktx_uint8_t** ppData);
+/* Make a created region available and release this process's mapping. */
+void ktxSharedRegion_publish(ktxSharedRegion* region);
+
+/*
+ * Map the KTX file in the published region called @p name read-only and
+ * add a reference to it.
+ */
+KTX_error_code ktxSharedRegion_attach(const char* name,
+                                      ktxSharedRegion** ppRegion,
+                                      const ktx_uint8_t** ppData,
+                                      ktx_size_t* pSize);
+/* Drop the reference added by attach and unmap the region. */
+void ktxSharedRegion_detach(ktxSharedRegion* region);
+/* KTX_FALSE once the region has been invalidated. */
+ktx_bool_t ktxSharedRegion_isValid(ktxSharedRegion* region);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHAREDSTORE_H */
@@ -118,6 +118,8 @@ ktxSupercompressionSchemeString(ktxSupercmpScheme scheme)
       case KTX_SS_NONE: return "KTX_SS_NONE";
       case KTX_SS_BASIS_LZ: return "KTX_SS_BASIS_LZ";
       case KTX_SS_ZSTD: return "KTX_SS_ZSTD";
+      case KTX_SS_ZSTD_SHUFFLE_DELTA: return "KTX_SS_ZSTD_SHUFFLE_DELTA";
+      case KTX_SS_ZSTD_BLOCK_SPLIT: return "KTX_SS_ZSTD_BLOCK_SPLIT";
       default:
         if (scheme < KTX_SS_BEGIN_VENDOR_RANGE
             || scheme >= KTX_SS_BEGIN_RESERVED)
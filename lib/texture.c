@@ -233,6 +233,8 @@ ktxTexture_destruct(ktxTexture* This)
         ktxHashList_Destruct(&This->kvDataHead);
     if (This->kvData != NULL)
         free(This->kvData);
+    // ktxTexture2_destruct has already released the data of ktxTexture2s,
+    // which may be a view of a shared texture.
     if (This->pData != NULL)
         free(This->pData);
     free(This->_protected);
@@ -887,6 +889,248 @@ ktxTexture_rowInfo(ktxTexture* This, ktx_uint32_t level,
     return pitch;
  }
 
+/**
+ * @internal
+ * @brief Describe where a subresource is in a ktxTexture's data.
+ *
+ * The block counts are calculated as in ktxTexture_calcImageSize and
+ * ktxTexture_layerSize so they match the texture's data.
+ */
+static void
+ktxTexture_subresourceLayout(ktxTexture* This, ktx_uint32_t level,
+                             ktx_uint32_t layer, ktx_uint32_t face,
+                             ktxSubresourceLayout* pLayout)
+{
+    DECLARE_PROTECTED(ktxTexture);
+    ktxFormatVersionEnum fv = This->classId == ktxTexture1_c
+                              ? KTX_FORMAT_VERSION_ONE : KTX_FORMAT_VERSION_TWO;
+    ktxFormatSize* formatSize = &prtctd->_formatSize;
+    ktx_uint32_t blockCountX, blockCountY, blockCountZ;
+    ktx_size_t imageSize;
+
+    pLayout->level = level;
+    pLayout->layer = layer;
+    pLayout->face = face;
+    pLayout->width = MAX(1, This->baseWidth >> level);
+    pLayout->height = MAX(1, This->baseHeight >> level);
+    pLayout->depth = MAX(1, This->baseDepth >> level);
+    pLayout->blockWidth = formatSize->blockWidth;
+    pLayout->blockHeight = formatSize->blockHeight;
+    pLayout->blockDepth = formatSize->blockDepth;
+    pLayout->blockSize = formatSize->blockSizeInBits / 8;
+
+    blockCountX = (ktx_uint32_t)ceilf((float)(This->baseWidth >> level)
+                                      / formatSize->blockWidth);
+    blockCountY = (ktx_uint32_t)ceilf((float)(This->baseHeight >> level)
+                                      / formatSize->blockHeight);
+    blockCountX = MAX(formatSize->minBlocksX, blockCountX);
+    blockCountY = MAX(formatSize->minBlocksX, blockCountY);
+    blockCountZ = MAX(1, (This->baseDepth / formatSize->blockDepth) >> level);
+
+    imageSize = ktxTexture_calcImageSize(This, level, fv);
+    pLayout->rowSize = blockCountX * pLayout->blockSize;
+    pLayout->rowCount = blockCountY;
+    pLayout->rowPitch = (ktx_uint32_t)(imageSize / blockCountY);
+    pLayout->slicePitch = imageSize;
+    pLayout->size = imageSize * blockCountZ;
+    ktxTexture_GetImageOffset(This, level, layer, face, &pLayout->offset);
+}
+
+/**
+ * @memberof ktxTexture
+ * @~English
+ * @brief Return the layout of every subresource of a ktxTexture.
+ *
+ * A subresource is the image of one mip level, array layer and cube map
+ * face. For 3D textures it includes all the depth slices of the level.
+ * The layouts are returned in the order used by Direct3D 12 for
+ * subresource indices: level varies fastest, then face, then layer, i.e.
+ * the index of a subresource is
+ * <tt>(layer * numFaces + face) * numLevels + level</tt>. This saves
+ * engines that upload the images with their own Direct3D 12, Metal or
+ * Vulkan code from calling ktxTexture_GetImageOffset(),
+ * ktxTexture_GetRowPitch() and @c GetImageSize for every subresource.
+ *
+ * If @p rowAlignment and @p subresourceAlignment are both 0 the layouts
+ * describe where the images are in the texture's own data. Otherwise they
+ * describe a new layout of the images, one after the other in the above
+ * order, in which the pitch between rows of blocks is a multiple of
+ * @p rowAlignment and the offset of each subresource is a multiple of
+ * @p subresourceAlignment. Depth slices directly follow each other. For
+ * example pass 256 and 512 for a Direct3D 12 upload buffer. An alignment
+ * of 0 is treated as 1. Use ktxTexture_CopyToSubresourceLayouts() to copy
+ * the images into the new layout.
+ *
+ * Call this once with @p pLayouts set to @c NULL to retrieve the number of
+ * subresources in @p pNumLayouts, and the total size, then again with
+ * @p pLayouts pointing to an array of that many elements.
+ *
+ * @param[in]     This          pointer to the ktxTexture object of interest.
+ * @param[in]     rowAlignment  alignment of rows in the returned layout.
+ * @param[in]     subresourceAlignment alignment of the subresources in the
+ *                              returned layout.
+ * @param[out]    pLayouts      pointer to an array to receive the layouts or
+ *                              @c NULL.
+ * @param[in,out] pNumLayouts   pointer to the number of elements in
+ *                              @p pLayouts. Receives the number of
+ *                              subresources.
+ * @param[out]    pTotalSize    pointer to a location to receive the number
+ *                              of bytes needed for the layout. May be
+ *                              @c NULL.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This or @p pNumLayouts is @c NULL or
+ *                              @p pLayouts has fewer elements than there
+ *                              are subresources.
+ * @exception KTX_INVALID_OPERATION The texture's data is supercompressed so
+ *                                  the images have no fixed location.
+ */
+KTX_error_code
+ktxTexture_GetSubresourceLayouts(ktxTexture* This,
+                                 ktx_uint32_t rowAlignment,
+                                 ktx_uint32_t subresourceAlignment,
+                                 ktxSubresourceLayout* pLayouts,
+                                 ktx_uint32_t* pNumLayouts,
+                                 ktx_size_t* pTotalSize)
+{
+    ktx_bool_t relayout = rowAlignment != 0 || subresourceAlignment != 0;
+    ktx_uint32_t numLayouts;
+    ktx_uint32_t layer, face, level;
+    ktx_size_t offset = 0;
+
+    if (This == NULL || pNumLayouts == NULL)
+        return KTX_INVALID_VALUE;
+
+    if (This->classId == ktxTexture2_c
+        && ((ktxTexture2*)This)->supercompressionScheme != KTX_SS_NONE)
+        return KTX_INVALID_OPERATION;
+
+    numLayouts = This->numLevels * This->numLayers * This->numFaces;
+    if (pLayouts != NULL && *pNumLayouts < numLayouts)
+        return KTX_INVALID_VALUE;
+    *pNumLayouts = numLayouts;
+    rowAlignment = MAX(1, rowAlignment);
+    subresourceAlignment = MAX(1, subresourceAlignment);
+
+    for (layer = 0; layer < This->numLayers; layer++) {
+        for (face = 0; face < This->numFaces; face++) {
+            for (level = 0; level < This->numLevels; level++) {
+                ktxSubresourceLayout layout;
+                ktx_uint32_t numSlices;
+
+                ktxTexture_subresourceLayout(This, level, layer, face, &layout);
+                if (relayout) {
+                    numSlices = (ktx_uint32_t)(layout.size / layout.slicePitch);
+                    offset = (offset + subresourceAlignment - 1)
+                             / subresourceAlignment * subresourceAlignment;
+                    layout.offset = offset;
+                    layout.rowPitch = (layout.rowSize + rowAlignment - 1)
+                                      / rowAlignment * rowAlignment;
+                    layout.slicePitch
+                                = (ktx_size_t)layout.rowPitch * layout.rowCount;
+                    layout.size = layout.slicePitch * numSlices;
+                    offset += layout.size;
+                }
+                if (pLayouts != NULL)
+                    *pLayouts++ = layout;
+            }
+        }
+    }
+    if (pTotalSize != NULL)
+        *pTotalSize = relayout ? offset : This->dataSize;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTexture
+ * @~English
+ * @brief Copy the images of a ktxTexture to a buffer with a different
+ *        layout.
+ *
+ * Copies each subresource in @p pLayouts from the texture's data to
+ * @p pDst at the offset and with the row and slice pitches given by its
+ * layout. @p pLayouts is usually an array returned by
+ * ktxTexture_GetSubresourceLayouts(), for example with the alignments
+ * needed for a graphics API's upload buffer, and may be a subset of it.
+ * Subresources whose pitches match those in the texture's data are copied
+ * in one operation. Others are copied a row at a time. Padding in the
+ * destination is left untouched.
+ *
+ * @param[in]     This          pointer to the ktxTexture object of interest.
+ * @param[in]     pLayouts      pointer to an array of the layouts of the
+ *                              subresources to copy.
+ * @param[in]     numLayouts    number of elements in @p pLayouts.
+ * @param[out]    pDst          pointer to the destination buffer.
+ * @param[in]     dstSize       size of the buffer pointed at by @p pDst.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This, @p pLayouts or @p pDst is @c NULL.
+ * @exception KTX_INVALID_VALUE A layout does not match a subresource of the
+ *                              texture or does not fit in @p dstSize bytes.
+ * @exception KTX_INVALID_OPERATION The texture's images have not been loaded
+ *                                  or are supercompressed.
+ */
+KTX_error_code
+ktxTexture_CopyToSubresourceLayouts(ktxTexture* This,
+                                    const ktxSubresourceLayout* pLayouts,
+                                    ktx_uint32_t numLayouts,
+                                    ktx_uint8_t* pDst, ktx_size_t dstSize)
+{
+    ktx_uint32_t i;
+
+    if (This == NULL || pLayouts == NULL || pDst == NULL)
+        return KTX_INVALID_VALUE;
+
+    if (This->pData == NULL)
+        return KTX_INVALID_OPERATION;
+    if (This->classId == ktxTexture2_c
+        && ((ktxTexture2*)This)->supercompressionScheme != KTX_SS_NONE)
+        return KTX_INVALID_OPERATION;
+
+    for (i = 0; i < numLayouts; i++) {
+        const ktxSubresourceLayout* dst = &pLayouts[i];
+        ktxSubresourceLayout src;
+        ktx_uint32_t numSlices, slice, row;
+
+        if (dst->level >= This->numLevels || dst->layer >= This->numLayers
+            || dst->face >= This->numFaces)
+            return KTX_INVALID_VALUE;
+        ktxTexture_subresourceLayout(This, dst->level, dst->layer, dst->face,
+                                     &src);
+        numSlices = (ktx_uint32_t)(src.size / src.slicePitch);
+        if (dst->rowSize != src.rowSize || dst->rowCount != src.rowCount
+            || dst->rowPitch < src.rowSize
+            || dst->slicePitch < (ktx_size_t)dst->rowPitch * src.rowCount
+            || dst->offset > dstSize
+            || dst->slicePitch * (numSlices - 1)
+               + (ktx_size_t)dst->rowPitch * (src.rowCount - 1) + src.rowSize
+               > dstSize - dst->offset)
+            return KTX_INVALID_VALUE;
+
+        if (dst->rowPitch == src.rowPitch && dst->slicePitch == src.slicePitch) {
+            // Same layout. Copy in one go, less any trailing row padding,
+            // which may not fit in the destination.
+            memcpy(pDst + dst->offset, This->pData + src.offset,
+                   src.size - (src.rowPitch - src.rowSize));
+            continue;
+        }
+        for (slice = 0; slice < numSlices; slice++) {
+            const ktx_uint8_t* pSrcRow = This->pData + src.offset
+                                         + slice * src.slicePitch;
+            ktx_uint8_t* pDstRow = pDst + dst->offset
+                                   + slice * dst->slicePitch;
+            for (row = 0; row < src.rowCount; row++) {
+                memcpy(pDstRow, pSrcRow, src.rowSize);
+                pSrcRow += src.rowPitch;
+                pDstRow += dst->rowPitch;
+            }
+        }
+    }
+    return KTX_SUCCESS;
+}
+
 /**
  * @memberof ktxTexture @private
  * @~English
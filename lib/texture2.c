@@ -31,8 +31,10 @@
 #include "ktxint.h"
 #include "filestream.h"
 #include "memstream.h"
+#include "sharedstore.h"
 #include "texture2.h"
 #include "unused.h"
+#include "zstdfilter.h"
 #include "vk_format.h"
 
 // FIXME: Test this #define and put it in a header somewhere.
@@ -534,6 +536,7 @@ ktxTexture2_constructCopy(ktxTexture2* This, ktxTexture2* orig)
         goto cleanup;
     }
     memcpy(This->_private, orig->_private, privateSize);
+    This->_private->_sharedRegion = NULL; // The copy owns its data.
     if (orig->_private->_sgdByteLength > 0) {
         This->_private->_supercompressionGlobalData
                         = (ktx_uint8_t*)malloc(orig->_private->_sgdByteLength);
@@ -1069,6 +1072,7 @@ ktxTexture2_destruct(ktxTexture2* This)
 {
     if (This->pDfd) free(This->pDfd);
     if (This->_private) {
+      ktxTexture2_freeData(This);
       ktx_uint8_t* sgd = This->_private->_supercompressionGlobalData;
       if (sgd) free(sgd);
       free(This->_private);
@@ -1806,7 +1810,8 @@ ktxTexture2_NeedsTranscoding(ktxTexture2* This)
  *
  * If supercompressionScheme == KTX_SS_NONE or
  * KTX_SS_BASIS_LZ, returns the value of @c This->dataSize
- * else if supercompressionScheme == KTX_SS_ZSTD,  it returns the
+ * else if supercompressionScheme is KTX_SS_ZSTD or one of the libktx
+ * filtered Zstd vendor schemes, it returns the
  * sum of the uncompressed sizes of each mip level plus space for the level padding. With no
  * supercompression the data size and uncompressed data size are the same. For Basis
  * supercompression the uncompressed size cannot be known until the data is transcoded
@@ -1822,6 +1827,8 @@ ktxTexture2_GetDataSizeUncompressed(ktxTexture2* This)
       case KTX_SS_NONE:
         return This->dataSize;
       case KTX_SS_ZSTD:
+      case KTX_SS_ZSTD_SHUFFLE_DELTA:
+      case KTX_SS_ZSTD_BLOCK_SPLIT:
       {
             ktx_size_t uncompressedSize = 0;
             ktx_uint32_t uncompressedLevelAlignment;
@@ -2008,7 +2015,7 @@ ktxTexture2_IterateLoadLevelFaces(ktxTexture2* This, PFNKTXITERCB iterCb,
         return KTX_INVALID_OPERATION;
 
     if (This->supercompressionScheme != KTX_SS_NONE &&
-        This->supercompressionScheme != KTX_SS_ZSTD)
+        !IS_ZSTD_SCHEME(This->supercompressionScheme))
         return KTX_INVALID_OPERATION;
 
     if (iterCb == NULL)
@@ -2025,7 +2032,7 @@ ktxTexture2_IterateLoadLevelFaces(ktxTexture2* This, PFNKTXITERCB iterCb,
     dataBuf = malloc(dataSize);
     if (!dataBuf)
         return KTX_OUT_OF_MEMORY;
-    if (This->supercompressionScheme == KTX_SS_ZSTD) {
+    if (IS_ZSTD_SCHEME(This->supercompressionScheme)) {
         uncompressedDataSize = levelIndex[0].uncompressedByteLength;
         uncompressedDataBuf = malloc(uncompressedDataSize);
         if (!uncompressedDataBuf) {
@@ -2065,7 +2072,7 @@ ktxTexture2_IterateLoadLevelFaces(ktxTexture2* This, PFNKTXITERCB iterCb,
         if (result != KTX_SUCCESS)
             goto cleanup;
 
-        if (This->supercompressionScheme == KTX_SS_ZSTD) {
+        if (IS_ZSTD_SCHEME(This->supercompressionScheme)) {
             levelSize =
                 ZSTD_decompressDCtx(dctx, uncompressedDataBuf,
                                   uncompressedDataSize,
@@ -2082,6 +2089,10 @@ ktxTexture2_IterateLoadLevelFaces(ktxTexture2* This, PFNKTXITERCB iterCb,
                     return KTX_FILE_DATA_ERROR;
                 }
             }
+            result = ktxTexture2_unfilterInflatedData(This, level, pData,
+                                                      levelSize);
+            if (result != KTX_SUCCESS)
+                goto cleanup;
             // We don't fix up the texture's dataSize, levelIndex or
             // _requiredAlignment because after this function completes there
             // is no way to get at the texture's data.
@@ -2152,10 +2163,233 @@ cleanup:
     return result;
 }
 
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Iterate over the images in a ktxTexture2 object while loading the
+ *        image data, one image at a time.
+ *
+ * This operates similarly to ktxTexture2_IterateLoadLevelFaces() except that
+ * @p iterCb is called once for each image, i.e. each array layer, cube face
+ * and depth slice of each level, rather than once per level or face. The
+ * images are read from the ktxTexture2's source into a buffer the size of a
+ * single base level image. If the data is Zstd supercompressed, i.e.
+ * supercompressionScheme is KTX_SS_ZSTD, KTX_SS_ZSTD_SHUFFLE_DELTA or
+ * KTX_SS_ZSTD_BLOCK_SPLIT, it is inflated with the Zstd streaming API
+ * through a small, fixed size input window and @p iterCb is called as soon
+ * as each image has been decoded and unfiltered, so memory use is independent of the level size and the number of layers. It
+ * is additionally bounded by the Zstd window the data was deflated with,
+ * which the decoder must keep when a frame is larger than it.
+ *
+ * The callback function must copy the image data if it wishes to preserve it
+ * as the buffer is reused for each image and is freed when this function
+ * exits. Levels are visited from smallest to largest, the order in which
+ * they are stored in the file.
+ *
+ * Intended for use only when supercompressionScheme == KTX_SS_NONE or one of
+ * the Zstd schemes. As there is no access to the ktxTexture's data on conclusion
+ * of this function, destroying the texture on completion is recommended.
+ *
+ * @param[in]     This     pointer to the ktxTexture2 object of interest.
+ * @param[in,out] iterCb   the address of a callback function which is called
+ *                         with the data for each image.
+ * @param[in,out] userdata the address of application-specific data which is
+ *                         passed to the callback along with the image data.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error. The
+ *          following are returned directly by this function. @p iterCb may
+ *          return these for other causes or may return additional errors.
+ *
+ * @exception KTX_FILE_DATA_ERROR   the size of a level does not match the
+ *                                  size of its images or the deflated data
+ *                                  is corrupt.
+ * @exception KTX_INVALID_OPERATION the ktxTexture2 was not created from a
+ *                                  stream, i.e there is no data to load, or
+ *                                  this ktxTexture2's images have already
+ *                                  been loaded.
+ * @exception KTX_INVALID_OPERATION
+ *                          supercompressionScheme is not KTX_SS_NONE or
+ *                          one of the Zstd schemes.
+ * @exception KTX_INVALID_VALUE     @p This is @c NULL or @p iterCb is @c NULL.
+ * @exception KTX_OUT_OF_MEMORY     not enough memory to allocate the image
+ *                                  buffer or the Zstd decompression context.
+ */
+KTX_error_code
+ktxTexture2_IterateLoadImages(ktxTexture2* This, PFNKTXIMAGEITERCB iterCb,
+                              void* userdata)
+{
+    DECLARE_PROTECTED(ktxTexture);
+    ktxStream* stream = (ktxStream *)&prtctd->_stream;
+    ktxLevelIndexEntry* levelIndex;
+    KTX_error_code  result = KTX_SUCCESS;
+    ktx_uint8_t*    imageBuf = NULL;
+    ktx_uint8_t*    inBuf = NULL;
+    size_t          inBufSize = 0;
+    ZSTD_DStream*   dstream = NULL;
+
+    if (This == NULL)
+        return KTX_INVALID_VALUE;
+
+    if (This->classId != ktxTexture2_c)
+        return KTX_INVALID_OPERATION;
+
+    if (This->supercompressionScheme != KTX_SS_NONE &&
+        !IS_ZSTD_SCHEME(This->supercompressionScheme))
+        return KTX_INVALID_OPERATION;
+
+    if (iterCb == NULL)
+        return KTX_INVALID_VALUE;
+
+    if (prtctd->_stream.data.file == NULL)
+        // This Texture not created from a stream or images are already loaded.
+        return KTX_INVALID_OPERATION;
+
+    levelIndex = This->_private->_levelIndex;
+
+    // Allocate memory sufficient for a base level image.
+    imageBuf = malloc(ktxTexture_calcImageSize(ktxTexture(This), 0,
+                                               KTX_FORMAT_VERSION_TWO));
+    if (!imageBuf)
+        return KTX_OUT_OF_MEMORY;
+    if (IS_ZSTD_SCHEME(This->supercompressionScheme)) {
+        inBufSize = ZSTD_DStreamInSize();
+        inBuf = malloc(inBufSize);
+        dstream = ZSTD_createDStream();
+        if (!inBuf || !dstream) {
+            result = KTX_OUT_OF_MEMORY;
+            goto cleanup;
+        }
+    }
+
+    for (ktx_int32_t level = This->numLevels - 1; level >= 0; --level)
+    {
+        ZSTD_inBuffer input = { inBuf, 0, 0 };
+        ktx_uint64_t deflatedRemaining = levelIndex[level].byteLength;
+        ktx_uint32_t width, height, depth, numImages, imagesPerLayer;
+        ktx_size_t imageSize;
+
+        width = MAX(1, This->baseWidth  >> level);
+        height = MAX(1, This->baseHeight >> level);
+        depth = MAX(1, This->baseDepth  >> level);
+        // Cube maps cannot be 3D so at most one of these is > 1.
+        imagesPerLayer = This->numFaces * depth;
+        numImages = This->numLayers * imagesPerLayer;
+
+        imageSize = ktxTexture_calcImageSize(ktxTexture(This), level,
+                                             KTX_FORMAT_VERSION_TWO);
+        if (imageSize * numImages != levelIndex[level].uncompressedByteLength) {
+            result = KTX_FILE_DATA_ERROR;
+            goto cleanup;
+        }
+
+        // Use setpos so we skip any padding.
+        result = stream->setpos(stream,
+                                ktxTexture2_levelFileOffset(This, level));
+        if (result != KTX_SUCCESS)
+            goto cleanup;
+
+        if (dstream)
+            ZSTD_DCtx_reset(dstream, ZSTD_reset_session_only);
+
+        for (ktx_uint32_t image = 0; image < numImages; image++) {
+            if (!dstream) {
+                result = stream->read(stream, imageBuf, imageSize);
+                if (result != KTX_SUCCESS)
+                    goto cleanup;
+            } else {
+                ZSTD_outBuffer output = { imageBuf, imageSize, 0 };
+                while (output.pos < output.size) {
+                    size_t zr;
+                    if (input.pos == input.size) {
+                        if (deflatedRemaining == 0) {
+                            // Level data ended before all images decoded.
+                            result = KTX_FILE_DATA_ERROR;
+                            goto cleanup;
+                        }
+                        input.size = (size_t)MIN(inBufSize, deflatedRemaining);
+                        input.pos = 0;
+                        result = stream->read(stream, inBuf, input.size);
+                        if (result != KTX_SUCCESS)
+                            goto cleanup;
+                        deflatedRemaining -= input.size;
+                    }
+                    zr = ZSTD_decompressStream(dstream, &output, &input);
+                    if (ZSTD_isError(zr)) {
+                        if (ZSTD_getErrorCode(zr) == ZSTD_error_memory_allocation)
+                            result = KTX_OUT_OF_MEMORY;
+                        else
+                            result = KTX_FILE_DATA_ERROR;
+                        goto cleanup;
+                    }
+                    if (zr == 0 && output.pos < output.size) {
+                        // Frame ended before the image was complete.
+                        result = KTX_FILE_DATA_ERROR;
+                        goto cleanup;
+                    }
+                }
+                result = ktxTexture2_unfilterInflatedData(This, level,
+                                                          imageBuf, imageSize);
+                if (result != KTX_SUCCESS)
+                    goto cleanup;
+            }
+
+#if IS_BIG_ENDIAN
+            switch (prtctd->_typeSize) {
+              case 2:
+                _ktxSwapEndian16((ktx_uint16_t*)imageBuf, imageSize / 2);
+                break;
+              case 4:
+                _ktxSwapEndian32((ktx_uint32_t*)imageBuf, imageSize / 4);
+                break;
+              case 8:
+                _ktxSwapEndian64((ktx_uint64_t*)imageBuf, imageSize / 8);
+                break;
+            }
+#endif
+
+            result = iterCb(level, image / imagesPerLayer,
+                            image % imagesPerLayer, width, height,
+                            imageSize, imageBuf, userdata);
+            if (result != KTX_SUCCESS)
+                goto cleanup;
+        }
+    }
+
+    // No further need for this.
+    stream->destruct(stream);
+    This->_private->_firstLevelFileOffset = 0;
+cleanup:
+    free(imageBuf);
+    free(inBuf);
+    if (dstream) ZSTD_freeDStream(dstream);
+
+    return result;
+}
+
 KTX_error_code
 ktxTexture2_inflateZstdInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
                            ktx_uint8_t* pInflatedData,
                            ktx_size_t inflatedDataCapacity);
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Return true if the file offsets of all levels of a texture not yet
+ *        loaded are multiples of @p alignment.
+ *
+ * @param[in] This      pointer to the ktxTexture2 object of interest.
+ * @param[in] alignment alignment to check.
+ */
+static ktx_bool_t
+ktxTexture2_levelsAreAligned(ktxTexture2* This, ktx_uint64_t alignment)
+{
+    for (ktx_uint32_t level = 0; level < This->numLevels; level++) {
+        if (ktxTexture2_levelFileOffset(This, level) % alignment != 0)
+            return KTX_FALSE;
+    }
+    return KTX_TRUE;
+}
+
 /**
  * @memberof ktxTexture2
  * @~English
@@ -2170,6 +2404,14 @@ ktxTexture2_inflateZstdInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
  * The texture's levelIndex, dataSize, DFD  and supercompressionScheme will
  * all be updated after successful inflation to reflect the inflated data.
  *
+ * When the source is a file whose levels all start at multiples of 4 KiB,
+ * such as those written by ktxTexture2_WriteAlignedToStream(), and the
+ * data is not supercompressed with Zstd, the data is read with direct I/O,
+ * bypassing the system's file cache, on platforms and file systems that
+ * support it. An internally allocated buffer is suitably aligned. A buffer
+ * provided by the caller must start at a multiple of 4 KiB and have room
+ * for the data size rounded up to a multiple of 4 KiB for this to happen.
+ *
  * @param[in] This pointer to the ktxTexture object of interest.
  * @param[in] pBuffer pointer to the buffer in which to load the image data.
  * @param[in] bufSize size of the buffer pointed at by @p pBuffer.
@@ -2194,6 +2436,8 @@ ktxTexture2_LoadImageData(ktxTexture2* This,
     ktx_uint8_t*    pReadBuf;
     KTX_error_code  result = KTX_SUCCESS;
     ktx_size_t inflatedDataCapacity = ktxTexture2_GetDataSizeUncompressed(This);
+    ktx_size_t destCapacity;
+    ktx_size_t directReadSize = 0;
 
     if (This == NULL)
         return KTX_INVALID_VALUE;
@@ -2205,18 +2449,38 @@ ktxTexture2_LoadImageData(ktxTexture2* This,
         // This Texture not created from a stream or images already loaded;
         return KTX_INVALID_OPERATION;
 
+    if (!IS_ZSTD_SCHEME(This->supercompressionScheme)
+        && prtctd->_stream.type == eStreamTypeFile
+        && ktxTexture2_levelsAreAligned(This, KTX_DIRECT_IO_ALIGNMENT)) {
+        directReadSize = (This->dataSize + KTX_DIRECT_IO_ALIGNMENT - 1)
+                         / KTX_DIRECT_IO_ALIGNMENT * KTX_DIRECT_IO_ALIGNMENT;
+    }
+
     if (pBuffer == NULL) {
-        This->pData = malloc(inflatedDataCapacity);
-        if (This->pData == NULL)
-            return KTX_OUT_OF_MEMORY;
+#if !defined(_WIN32)
+        if (directReadSize != 0
+            && posix_memalign((void**)&This->pData, KTX_DIRECT_IO_ALIGNMENT,
+                              directReadSize) != 0) {
+            This->pData = NULL;
+        }
+#endif
+        if (This->pData != NULL) {
+            destCapacity = directReadSize;
+        } else {
+            This->pData = malloc(inflatedDataCapacity);
+            if (This->pData == NULL)
+                return KTX_OUT_OF_MEMORY;
+            destCapacity = inflatedDataCapacity;
+        }
         pDest = This->pData;
     } else if (bufSize < inflatedDataCapacity) {
         return KTX_INVALID_VALUE;
     } else {
         pDest = pBuffer;
+        destCapacity = bufSize;
     }
 
-    if (This->supercompressionScheme == KTX_SS_ZSTD) {
+    if (IS_ZSTD_SCHEME(This->supercompressionScheme)) {
         // Create buffer to hold deflated data.
         pDeflatedData = malloc(This->dataSize);
         if (pDeflatedData == NULL)
@@ -2226,31 +2490,56 @@ ktxTexture2_LoadImageData(ktxTexture2* This,
         pReadBuf = pDest;
     }
 
-    // Seek to data for first level as there may be padding between the
-    // metadata/sgd and the image data.
+    if (directReadSize != 0 && destCapacity >= directReadSize
+        && (uintptr_t)pReadBuf % KTX_DIRECT_IO_ALIGNMENT == 0) {
+        ktx_size_t numRead;
+
+        result = ktxFileStream_readDirect(&prtctd->_stream, pReadBuf,
+                                          directReadSize,
+                                          private->_firstLevelFileOffset,
+                                          &numRead);
+        if (result == KTX_SUCCESS && numRead < This->dataSize)
+            return KTX_FILE_UNEXPECTED_EOF;
+        if (result != KTX_SUCCESS && result != KTX_INVALID_OPERATION)
+            return result;
+        // KTX_INVALID_OPERATION means no direct I/O. Fall back to the
+        // stream's read.
+    } else {
+        result = KTX_INVALID_OPERATION;
+    }
 
-    result = prtctd->_stream.setpos(&prtctd->_stream,
-                                    private->_firstLevelFileOffset);
-    if (result != KTX_SUCCESS)
-        return result;
+    if (result != KTX_SUCCESS) {
+        // Seek to data for first level as there may be padding between the
+        // metadata/sgd and the image data.
 
-    result = prtctd->_stream.read(&prtctd->_stream, pReadBuf,
-                                  This->dataSize);
-    if (result != KTX_SUCCESS)
-        return result;
+        result = prtctd->_stream.setpos(&prtctd->_stream,
+                                        private->_firstLevelFileOffset);
+        if (result != KTX_SUCCESS)
+            return result;
 
-    if (This->supercompressionScheme == KTX_SS_ZSTD) {
+        result = prtctd->_stream.read(&prtctd->_stream, pReadBuf,
+                                      This->dataSize);
+        if (result != KTX_SUCCESS)
+            return result;
+    }
+
+    if (IS_ZSTD_SCHEME(This->supercompressionScheme)) {
         assert(pDeflatedData != NULL);
         result = ktxTexture2_inflateZstdInt(This, pDeflatedData, pDest,
                                             inflatedDataCapacity);
         free(pDeflatedData);
         if (result != KTX_SUCCESS) {
-            if (pBuffer == NULL) {
-                free(This->pData);
-                This->pData = 0;
-            }
+            if (pBuffer == NULL)
+                ktxTexture2_freeData(This);
             return result;
         }
+        // Level hashes are of the deflated data so no longer apply.
+        ktxHashListEntry* pEntry = NULL;
+        if (ktxHashList_FindEntry(&This->kvDataHead, KTX_LEVEL_HASHES_KEY,
+                                  &pEntry) == KTX_SUCCESS) {
+            ktxHashList_DeleteEntry(&This->kvDataHead, pEntry);
+            free(pEntry);
+        }
     }
 
     if (IS_BIG_ENDIAN) {
@@ -2284,6 +2573,27 @@ ktxTexture2_LoadImageData(ktxTexture2* This,
     return result;
 }
 
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Release the image data prior to replacing it.
+ *
+ * The data of a view of a shared texture is unmapped rather than freed.
+ *
+ * @param[in] This pointer to the ktxTexture2 object of interest.
+ */
+void
+ktxTexture2_freeData(ktxTexture2* This)
+{
+    if (This->_private->_sharedRegion) {
+        ktxSharedRegion_detach(This->_private->_sharedRegion);
+        This->_private->_sharedRegion = NULL;
+    } else {
+        free(This->pData);
+    }
+    This->pData = NULL;
+}
+
 /**
  * @memberof ktxTexture2 @private
  * @~English
@@ -2297,6 +2607,69 @@ ktx_uint64_t ktxTexture2_levelDataOffset(ktxTexture2* This, ktx_uint32_t level)
     return This->_private->_levelIndex[level].byteOffset;
 }
 
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Return the number of elements, texels or compressed blocks, in a
+ *        row of a level.
+ *
+ * @param[in] This  pointer to the ktxTexture2 object of interest.
+ * @param[in] level mip level of interest.
+ */
+ktx_uint32_t
+ktxTexture2_levelRowElements(ktxTexture2* This, ktx_uint32_t level)
+{
+    ktxFormatSize* formatSize = &This->_protected->_formatSize;
+    ktx_uint32_t width = MAX(1, This->baseWidth >> level);
+
+    return (width + formatSize->blockWidth - 1) / formatSize->blockWidth;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Undo the filter, if any, applied to inflated data before it was
+ *        deflated.
+ *
+ * @p pData must hold whole rows of @p level. For KTX_SS_ZSTD this does
+ * nothing.
+ *
+ * @param[in] This      pointer to the ktxTexture2 object of interest.
+ * @param[in] level     mip level of the data.
+ * @param[in,out] pData pointer to the inflated data to unfilter in place.
+ * @param[in] size      size in bytes of the data at @p pData.
+ *
+ * @exception KTX_FILE_DATA_ERROR @p size is not a multiple of the row size
+ *                                or the filter is not valid for the format.
+ * @exception KTX_OUT_OF_MEMORY   not enough memory for a row buffer.
+ */
+KTX_error_code
+ktxTexture2_unfilterInflatedData(ktxTexture2* This, ktx_uint32_t level,
+                                 ktx_uint8_t* pData, ktx_size_t size)
+{
+    DECLARE_PROTECTED(ktxTexture);
+
+    switch (This->supercompressionScheme) {
+      case KTX_SS_ZSTD:
+        return KTX_SUCCESS;
+      case KTX_SS_ZSTD_SHUFFLE_DELTA:
+        if (This->isCompressed)
+            return KTX_FILE_DATA_ERROR;
+        // blockSizeInBits was set to the inflated size on file load.
+        return ktxShuffleDelta_decode(pData, size,
+                                      ktxTexture2_levelRowElements(This, level),
+                                      prtctd->_formatSize.blockSizeInBits / 8);
+      case KTX_SS_ZSTD_BLOCK_SPLIT:
+        if (!This->isCompressed)
+            return KTX_FILE_DATA_ERROR;
+        return ktxBlockSplit_decode(pData, size,
+                                    ktxTexture2_levelRowElements(This, level),
+                                    prtctd->_formatSize.blockSizeInBits / 8);
+      default:
+        return KTX_INVALID_OPERATION;
+    }
+}
+
 /**
  * @memberof ktxTexture2 @private
  * @~English
@@ -2334,7 +2707,7 @@ ktxTexture2_inflateZstdInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
     if (pInflatedData == NULL)
         return KTX_INVALID_VALUE;
 
-    if (This->supercompressionScheme != KTX_SS_ZSTD)
+    if (!IS_ZSTD_SCHEME(This->supercompressionScheme))
         return KTX_INVALID_OPERATION;
 
     nindex = malloc(levelIndexByteLength);
@@ -2363,6 +2736,15 @@ ktxTexture2_inflateZstdInt(ktxTexture2* This, ktx_uint8_t* pDeflatedData,
                 return KTX_FILE_DATA_ERROR;
             }
         }
+        KTX_error_code result =
+            ktxTexture2_unfilterInflatedData(This, level,
+                                             pInflatedData + levelOffset,
+                                             levelByteLength);
+        if (result != KTX_SUCCESS) {
+            ZSTD_freeDCtx(dctx);
+            free(nindex);
+            return result;
+        }
         nindex[level].byteOffset = levelOffset;
         nindex[level].uncompressedByteLength = nindex[level].byteLength =
                                                             levelByteLength;
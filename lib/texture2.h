@@ -37,6 +37,8 @@ typedef struct ktxTexture2_private {
     ktx_uint64_t _firstLevelFileOffset; /*!< Always 0, unless the texture was
                                          created from a stream and the image
                                          data is not yet loaded. */
+    struct ktxSharedRegion* _sharedRegion; /*!< Set when pData points into
+                                                a shared texture's pages. */
     // Must be last so it can grow.
     ktxLevelIndexEntry _levelIndex[1]; /*!< Offsets in this index are from the
                                         start of the image data. Use
@@ -46,6 +48,11 @@ typedef struct ktxTexture2_private {
                                         index offset. */
 } ktxTexture2_private;
 
+/* True if scheme is one of the Zstd based supercompression schemes. */
+#define IS_ZSTD_SCHEME(scheme) \
+    ((scheme) == KTX_SS_ZSTD || (scheme) == KTX_SS_ZSTD_SHUFFLE_DELTA \
+     || (scheme) == KTX_SS_ZSTD_BLOCK_SPLIT)
+
 KTX_error_code
 ktxTexture2_LoadImageData(ktxTexture2* This,
                           ktx_uint8_t* pBuffer, ktx_size_t bufSize);
@@ -60,6 +67,23 @@ ktx_size_t ktxTexture2_calcLevelOffset(ktxTexture2* This, ktx_uint32_t level);
 ktx_uint32_t ktxTexture2_calcRequiredLevelAlignment(ktxTexture2* This);
 ktx_uint64_t ktxTexture2_levelFileOffset(ktxTexture2* This, ktx_uint32_t level);
 ktx_uint64_t ktxTexture2_levelDataOffset(ktxTexture2* This, ktx_uint32_t level);
+ktx_uint32_t ktxTexture2_levelRowElements(ktxTexture2* This,
+                                          ktx_uint32_t level);
+KTX_error_code ktxTexture2_zstdFilterScheme(ktxTexture2* This,
+                                            ktx_zstd_filter_e filter,
+                                            ktxSupercmpScheme* pScheme);
+void ktxTexture2_filterLevelData(ktxTexture2* This, ktx_uint32_t level,
+                                 ktx_zstd_filter_e filter,
+                                 const ktx_uint8_t* src, ktx_uint8_t* dst,
+                                 ktx_size_t size);
+KTX_error_code ktxTexture2_unfilterInflatedData(ktxTexture2* This,
+                                                ktx_uint32_t level,
+                                                ktx_uint8_t* pData,
+                                                ktx_size_t size);
+void ktxTexture2_freeData(ktxTexture2* This);
+void ktxTexture2_calcLevelHashes(ktxTexture2* This, const ktx_uint8_t* pData,
+                                 ktx_uint32_t threadCount,
+                                 ktx_uint64_t* pHashes);
 
 #ifdef __cplusplus
 }
@@ -27,6 +27,71 @@
 #include "vulkan/vulkan_core.h"
 #include "ktx.h"
 
+#if !defined(VK_EXT_host_image_copy)
+// The Vulkan headers in use predate VK_EXT_host_image_copy. Declare the
+// parts of it used by the loader.
+#define VK_EXT_host_image_copy 1
+#define VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME "VK_EXT_host_image_copy"
+#define VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_PROPERTIES_EXT \
+                                                ((VkStructureType)1000270001)
+#define VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT \
+                                                ((VkStructureType)1000270002)
+#define VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_EXT \
+                                                ((VkStructureType)1000270005)
+#define VK_STRUCTURE_TYPE_HOST_IMAGE_LAYOUT_TRANSITION_INFO_EXT \
+                                                ((VkStructureType)1000270006)
+#define VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT 0x00400000
+
+typedef VkFlags VkHostImageCopyFlagsEXT;
+
+typedef struct VkPhysicalDeviceHostImageCopyPropertiesEXT {
+    VkStructureType sType;
+    void* pNext;
+    uint32_t copySrcLayoutCount;
+    VkImageLayout* pCopySrcLayouts;
+    uint32_t copyDstLayoutCount;
+    VkImageLayout* pCopyDstLayouts;
+    uint8_t optimalTilingLayoutUUID[VK_UUID_SIZE];
+    VkBool32 identicalMemoryTypeRequirements;
+} VkPhysicalDeviceHostImageCopyPropertiesEXT;
+
+typedef struct VkMemoryToImageCopyEXT {
+    VkStructureType sType;
+    const void* pNext;
+    const void* pHostPointer;
+    uint32_t memoryRowLength;
+    uint32_t memoryImageHeight;
+    VkImageSubresourceLayers imageSubresource;
+    VkOffset3D imageOffset;
+    VkExtent3D imageExtent;
+} VkMemoryToImageCopyEXT;
+
+typedef struct VkCopyMemoryToImageInfoEXT {
+    VkStructureType sType;
+    const void* pNext;
+    VkHostImageCopyFlagsEXT flags;
+    VkImage dstImage;
+    VkImageLayout dstImageLayout;
+    uint32_t regionCount;
+    const VkMemoryToImageCopyEXT* pRegions;
+} VkCopyMemoryToImageInfoEXT;
+
+typedef struct VkHostImageLayoutTransitionInfoEXT {
+    VkStructureType sType;
+    const void* pNext;
+    VkImage image;
+    VkImageLayout oldLayout;
+    VkImageLayout newLayout;
+    VkImageSubresourceRange subresourceRange;
+} VkHostImageLayoutTransitionInfoEXT;
+
+typedef VkResult (VKAPI_PTR *PFN_vkCopyMemoryToImageEXT)(VkDevice device,
+                  const VkCopyMemoryToImageInfoEXT* pCopyMemoryToImageInfo);
+typedef VkResult (VKAPI_PTR *PFN_vkTransitionImageLayoutEXT)(VkDevice device,
+                  uint32_t transitionCount,
+                  const VkHostImageLayoutTransitionInfoEXT* pTransitions);
+#endif
+
 
 #if WINDOWS
 #define WINDOWS_LEAN_AND_MEAN
@@ -0,0 +1,339 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2010-2020 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file vkformat_convert.c
+ * @~English
+ *
+ * @brief Conversion of texel data to a related VkFormat.
+ *
+ * Used by the Vulkan loader to upload textures whose format the device
+ * cannot create images of, most often the 3 component formats such as
+ * R8G8B8_UNORM. These are widened to the matching 4 component format with
+ * alpha set to 1. When precision loss is acceptable 32- and 64-bit float
+ * formats can also be narrowed.
+ *
+ * Widening uses SSE2 or NEON when available. Both produce exactly the same
+ * output as the scalar code.
+ */
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include "ktx.h"
+#include "vkformat_convert.h"
+
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define KTX_CONVERT_USE_SSE2 1
+  #include <emmintrin.h>
+#else
+  #define KTX_CONVERT_USE_SSE2 0
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #define KTX_CONVERT_USE_NEON 1
+  #include <arm_neon.h>
+#else
+  #define KTX_CONVERT_USE_NEON 0
+#endif
+
+#define HALF_ONE 0x3C00
+#define FLOAT_ONE 0x3F800000
+
+static void
+setConversion(ktxFormatConversion* c, VkFormat srcFormat, VkFormat dstFormat,
+              ktx_uint32_t srcComponents, ktx_uint32_t dstComponents,
+              ktx_uint32_t srcComponentSize, ktx_uint32_t dstComponentSize,
+              ktxComponentConversion op, ktx_uint64_t one)
+{
+    c->srcFormat = srcFormat;
+    c->dstFormat = dstFormat;
+    c->srcComponents = srcComponents;
+    c->dstComponents = dstComponents;
+    c->srcComponentSize = srcComponentSize;
+    c->dstComponentSize = dstComponentSize;
+    c->op = op;
+    c->one = one;
+    c->lossy = op != KTX_COMPONENT_COPY;
+}
+
+ktx_uint32_t
+ktxFormatConversion_candidates(VkFormat format, ktx_bool_t allowLossy,
+                   ktxFormatConversion conversions[KTX_MAX_FORMAT_CONVERSIONS])
+{
+    // Alpha values for the 8 and 16-bit formats in VkFormat order:
+    // UNORM, SNORM, USCALED, SSCALED, UINT, SINT, then SRGB or SFLOAT.
+    static const ktx_uint8_t one8[] = { 0xff, 0x7f, 1, 1, 1, 1, 0xff };
+    static const ktx_uint16_t one16[] = {
+        0xffff, 0x7fff, 1, 1, 1, 1, HALF_ONE
+    };
+    // 16-bit float formats with 1 to 4 components. There is no
+    // R16G16B16_SFLOAT entry because it is as poorly supported as the
+    // 3 component formats being converted.
+    static const VkFormat f16[] = {
+        VK_FORMAT_R16_SFLOAT, VK_FORMAT_R16G16_SFLOAT,
+        VK_FORMAT_R16G16B16A16_SFLOAT, VK_FORMAT_R16G16B16A16_SFLOAT
+    };
+    ktx_uint32_t count = 0;
+
+    if (format >= VK_FORMAT_R8G8B8_UNORM && format <= VK_FORMAT_B8G8R8_SRGB) {
+        // R8G8B8 and B8G8R8 to R8G8B8A8 and B8G8R8A8.
+        ktx_uint32_t i = (format - VK_FORMAT_R8G8B8_UNORM) % 7;
+        setConversion(&conversions[count++], format,
+                      (VkFormat)(format + 14), 3, 4, 1, 1,
+                      KTX_COMPONENT_COPY, one8[i]);
+    } else if (format >= VK_FORMAT_R16G16B16_UNORM
+               && format <= VK_FORMAT_R16G16B16_SFLOAT) {
+        ktx_uint32_t i = format - VK_FORMAT_R16G16B16_UNORM;
+        setConversion(&conversions[count++], format,
+                      (VkFormat)(format + 7), 3, 4, 2, 2,
+                      KTX_COMPONENT_COPY, one16[i]);
+    } else if (format >= VK_FORMAT_R32_UINT
+               && format <= VK_FORMAT_R32G32B32A32_SFLOAT) {
+        ktx_uint32_t components = (format - VK_FORMAT_R32_UINT) / 3 + 1;
+        ktx_bool_t isFloat = (format - VK_FORMAT_R32_UINT) % 3 == 2;
+        if (components == 3) {
+            setConversion(&conversions[count++], format,
+                          (VkFormat)(format + 3), 3, 4, 4, 4,
+                          KTX_COMPONENT_COPY, isFloat ? FLOAT_ONE : 1);
+        }
+        if (isFloat && allowLossy) {
+            setConversion(&conversions[count++], format, f16[components - 1],
+                          components, components == 3 ? 4 : components, 4, 2,
+                          KTX_COMPONENT_F32_TO_F16, HALF_ONE);
+        }
+    } else if (format >= VK_FORMAT_R64_UINT
+               && format <= VK_FORMAT_R64G64B64A64_SFLOAT) {
+        ktx_uint32_t components = (format - VK_FORMAT_R64_UINT) / 3 + 1;
+        ktx_bool_t isFloat = (format - VK_FORMAT_R64_UINT) % 3 == 2;
+        ktx_uint32_t dstComponents = components == 3 ? 4 : components;
+        if (isFloat && allowLossy) {
+            VkFormat f32 = (VkFormat)(VK_FORMAT_R32_SFLOAT
+                                      + (dstComponents - 1) * 3);
+            setConversion(&conversions[count++], format, f32,
+                          components, dstComponents, 8, 4,
+                          KTX_COMPONENT_F64_TO_F32, FLOAT_ONE);
+            setConversion(&conversions[count++], format,
+                          f16[components - 1], components, dstComponents,
+                          8, 2, KTX_COMPONENT_F64_TO_F16, HALF_ONE);
+        }
+    }
+    assert(count <= KTX_MAX_FORMAT_CONVERSIONS);
+    return count;
+}
+
+/*
+ * Round a float to the nearest half, ties to even. Values too large for a
+ * half become infinity. NaNs stay NaNs.
+ */
+ktx_uint16_t
+ktxFloatToHalf(float f)
+{
+    ktx_uint32_t x, absx, sign;
+
+    memcpy(&x, &f, sizeof(x));
+    sign = (x >> 16) & 0x8000;
+    absx = x & 0x7fffffff;
+    if (absx >= 0x7f800000) {
+        // Inf or NaN. Keep the top of the NaN payload and make sure a NaN
+        // does not turn into Inf.
+        return (ktx_uint16_t)(sign | 0x7c00 | (absx > 0x7f800000
+                                       ? 0x200 | ((absx >> 13) & 0x3ff) : 0));
+    }
+    if (absx >= 0x477ff000) {
+        // >= 65520 rounds to Inf.
+        return (ktx_uint16_t)(sign | 0x7c00);
+    }
+    if (absx < 0x38800000) {
+        // Below the smallest normal half, 2^-14. The subnormal mantissa is
+        // the value in units of 2^-24. Scaling by a power of 2 is exact.
+        float a;
+        memcpy(&a, &absx, sizeof(a));
+        return (ktx_uint16_t)(sign | (ktx_uint32_t)lrintf(a * 16777216.0f));
+    }
+    // Rebias the exponent then round the mantissa from 23 to 10 bits. A
+    // carry out of the mantissa correctly increments the exponent.
+    absx -= 0x38000000;
+    absx += 0xfff + ((absx >> 13) & 1);
+    return (ktx_uint16_t)(sign | (absx >> 13));
+}
+
+float
+ktxHalfToFloat(ktx_uint16_t h)
+{
+    ktx_uint32_t sign = (ktx_uint32_t)(h & 0x8000) << 16;
+    ktx_uint32_t exponent = (h >> 10) & 0x1f;
+    ktx_uint32_t mantissa = h & 0x3ff;
+    ktx_uint32_t x;
+    float f;
+
+    if (exponent == 0) {
+        // Zero or subnormal. Exact in float.
+        f = (float)mantissa / 16777216.0f;
+        return sign ? -f : f;
+    }
+    if (exponent == 0x1f)
+        x = sign | 0x7f800000 | (mantissa << 13);
+    else
+        x = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+static void
+storeOne(ktx_uint8_t* dst, ktx_uint64_t one, ktx_uint32_t size)
+{
+    switch (size) {
+      case 1: { ktx_uint8_t v = (ktx_uint8_t)one; *dst = v; break; }
+      case 2: { ktx_uint16_t v = (ktx_uint16_t)one; memcpy(dst, &v, 2); break; }
+      case 4: { ktx_uint32_t v = (ktx_uint32_t)one; memcpy(dst, &v, 4); break; }
+      default: memcpy(dst, &one, 8); break;
+    }
+}
+
+/*
+ * Widen 3 component texels to 4 components. Returns the number of texels
+ * done so the caller can finish any remainder.
+ */
+static ktx_size_t
+widenSimd(const ktxFormatConversion* c, const ktx_uint8_t* src,
+          ktx_uint8_t* dst, ktx_size_t numTexels)
+{
+    ktx_size_t i = 0;
+#if KTX_CONVERT_USE_SSE2
+    // Each iteration reads 16 bytes holding 16 / (4 * size) whole texels
+    // plus part of the next and writes 16 bytes. Byte shifts move each
+    // texel to its place; masks clear the bytes of neighbouring texels.
+    ktx_uint32_t size = c->srcComponentSize;
+    ktx_uint32_t perVec = 4 / size;
+    ktx_uint8_t oneBytes[16], keep[4][16];
+    __m128i alpha, mask[4];
+
+    memset(oneBytes, 0, sizeof(oneBytes));
+    memset(keep, 0, sizeof(keep));
+    for (ktx_uint32_t t = 0; t < perVec; t++) {
+        storeOne(&oneBytes[(t * 4 + 3) * size], c->one, size);
+        memset(&keep[t][t * 4 * size], 0xff, 3 * size);
+    }
+    alpha = _mm_loadu_si128((const __m128i*)oneBytes);
+    for (ktx_uint32_t t = 0; t < perVec; t++)
+        mask[t] = _mm_loadu_si128((const __m128i*)keep[t]);
+
+    // Stop while 16 bytes can still be read.
+    for (; (numTexels - i) * 3 * size >= 16; i += perVec) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i * 3 * size));
+        __m128i r = _mm_or_si128(_mm_and_si128(v, mask[0]), alpha);
+        switch (size) {
+          case 1:
+            r = _mm_or_si128(r, _mm_and_si128(_mm_slli_si128(v, 1), mask[1]));
+            r = _mm_or_si128(r, _mm_and_si128(_mm_slli_si128(v, 2), mask[2]));
+            r = _mm_or_si128(r, _mm_and_si128(_mm_slli_si128(v, 3), mask[3]));
+            break;
+          case 2:
+            r = _mm_or_si128(r, _mm_and_si128(_mm_slli_si128(v, 2), mask[1]));
+            break;
+          default:
+            break;
+        }
+        _mm_storeu_si128((__m128i*)(dst + i * 4 * size), r);
+    }
+#elif KTX_CONVERT_USE_NEON
+    switch (c->srcComponentSize) {
+      case 1: {
+        uint8x16_t one = vdupq_n_u8((ktx_uint8_t)c->one);
+        for (; numTexels - i >= 16; i += 16) {
+            uint8x16x3_t v = vld3q_u8(src + i * 3);
+            uint8x16x4_t r = {{ v.val[0], v.val[1], v.val[2], one }};
+            vst4q_u8(dst + i * 4, r);
+        }
+        break;
+      }
+      case 2: {
+        uint16x8_t one = vdupq_n_u16((ktx_uint16_t)c->one);
+        for (; numTexels - i >= 8; i += 8) {
+            uint16x8x3_t v = vld3q_u16((const uint16_t*)(src + i * 6));
+            uint16x8x4_t r = {{ v.val[0], v.val[1], v.val[2], one }};
+            vst4q_u16((uint16_t*)(dst + i * 8), r);
+        }
+        break;
+      }
+      default: {
+        uint32x4_t one = vdupq_n_u32((ktx_uint32_t)c->one);
+        for (; numTexels - i >= 4; i += 4) {
+            uint32x4x3_t v = vld3q_u32((const uint32_t*)(src + i * 12));
+            uint32x4x4_t r = {{ v.val[0], v.val[1], v.val[2], one }};
+            vst4q_u32((uint32_t*)(dst + i * 16), r);
+        }
+        break;
+      }
+    }
+#else
+    (void)c; (void)src; (void)dst; (void)numTexels;
+#endif
+    return i;
+}
+
+void
+ktxFormatConversion_convert(const ktxFormatConversion* c,
+                            const ktx_uint8_t* src, ktx_uint8_t* dst,
+                            ktx_size_t numTexels)
+{
+    ktx_uint32_t srcElementSize = ktxFormatConversion_srcElementSize(c);
+    ktx_uint32_t dstElementSize = ktxFormatConversion_dstElementSize(c);
+    ktx_size_t i = 0;
+
+    if (c->op == KTX_COMPONENT_COPY && c->srcComponentSize <= 4) {
+        assert(c->srcComponents == 3 && c->dstComponents == 4);
+        i = widenSimd(c, src, dst, numTexels);
+    }
+    src += i * srcElementSize;
+    dst += i * dstElementSize;
+    for (; i < numTexels; i++) {
+        for (ktx_uint32_t comp = 0; comp < c->dstComponents; comp++) {
+            ktx_uint8_t* d = dst + comp * c->dstComponentSize;
+            const ktx_uint8_t* s = src + comp * c->srcComponentSize;
+            if (comp >= c->srcComponents) {
+                storeOne(d, c->one, c->dstComponentSize);
+                continue;
+            }
+            switch (c->op) {
+              case KTX_COMPONENT_COPY:
+                memcpy(d, s, c->srcComponentSize);
+                break;
+              case KTX_COMPONENT_F32_TO_F16: {
+                float f;
+                ktx_uint16_t h;
+                memcpy(&f, s, sizeof(f));
+                h = ktxFloatToHalf(f);
+                memcpy(d, &h, sizeof(h));
+                break;
+              }
+              case KTX_COMPONENT_F64_TO_F32: {
+                double df;
+                float f;
+                memcpy(&df, s, sizeof(df));
+                f = (float)df;
+                memcpy(d, &f, sizeof(f));
+                break;
+              }
+              case KTX_COMPONENT_F64_TO_F16: {
+                double df;
+                ktx_uint16_t h;
+                memcpy(&df, s, sizeof(df));
+                h = ktxFloatToHalf((float)df);
+                memcpy(d, &h, sizeof(h));
+                break;
+              }
+            }
+        }
+        src += srcElementSize;
+        dst += dstElementSize;
+    }
+}
@@ -0,0 +1,84 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2010-2020 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Conversion of texel data to a related VkFormat, used when a device cannot
+ * create images of a texture's own format.
+ */
+
+#ifndef VKFORMAT_CONVERT_H
+#define VKFORMAT_CONVERT_H
+
+#include "ktx.h"
+#include "vkformat_enum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum ktxComponentConversion {
+    KTX_COMPONENT_COPY,        /* Components are copied unchanged. */
+    KTX_COMPONENT_F32_TO_F16,  /* Rounded to nearest even. */
+    KTX_COMPONENT_F64_TO_F32,  /* Rounded to nearest even. */
+    KTX_COMPONENT_F64_TO_F16   /* Via F32 so rounded twice. */
+} ktxComponentConversion;
+
+/*
+ * Describes how to convert texels of one format to another. Missing
+ * destination components, i.e. alpha, are set to @c one.
+ */
+typedef struct ktxFormatConversion {
+    VkFormat srcFormat;
+    VkFormat dstFormat;
+    ktx_uint32_t srcComponents;
+    ktx_uint32_t dstComponents;
+    ktx_uint32_t srcComponentSize;
+    ktx_uint32_t dstComponentSize;
+    ktxComponentConversion op;
+    ktx_uint64_t one;  /* 1.0 or 1 in the destination component encoding. */
+    ktx_bool_t lossy;
+} ktxFormatConversion;
+
+#define KTX_MAX_FORMAT_CONVERSIONS 3
+
+/*
+ * ktxFormatConversion_candidates: Fill @p conversions with the formats to
+ * which texels of @p format can be converted, in order of preference.
+ * Conversions that lose precision are included only if @p allowLossy is
+ * true. Returns the number of conversions, at most
+ * KTX_MAX_FORMAT_CONVERSIONS, and 0 for formats that are not converted.
+ */
+ktx_uint32_t ktxFormatConversion_candidates(VkFormat format,
+                         ktx_bool_t allowLossy,
+                         ktxFormatConversion conversions[KTX_MAX_FORMAT_CONVERSIONS]);
+
+/*
+ * ktxFormatConversion_convert: Convert @p numTexels texels from @p src to
+ * @p dst. @p src and @p dst must not overlap.
+ */
+void ktxFormatConversion_convert(const ktxFormatConversion* conversion,
+                                 const ktx_uint8_t* src, ktx_uint8_t* dst,
+                                 ktx_size_t numTexels);
+
+/*
+ * ktxFloatToHalf: Round @p f to the nearest half float, ties to even.
+ * ktxHalfToFloat: Widen a half float. The result is exact.
+ */
+ktx_uint16_t ktxFloatToHalf(float f);
+float ktxHalfToFloat(ktx_uint16_t h);
+
+#define ktxFormatConversion_srcElementSize(c) \
+    ((c)->srcComponents * (c)->srcComponentSize)
+#define ktxFormatConversion_dstElementSize(c) \
+    ((c)->dstComponents * (c)->dstComponentSize)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VKFORMAT_CONVERT_H */
@@ -33,6 +33,8 @@
 #include "texture1.h"
 #include "texture2.h"
 #include "vk_format.h"
+#include "vkformat_convert.h"
+#include "vkmipgen.h"
 
 // Macro to check and display Vulkan return results.
 // Use when the only possible errors are caused by invalid usage by this loader.
@@ -318,7 +320,6 @@ do {                             \
     LOAD_DEVICE_FUNC(funcs, device, vkGetImageMemoryRequirements);
     LOAD_DEVICE_FUNC(funcs, device, vkGetImageSubresourceLayout);
 
-
     This->vkFuncs = funcs;
 
     VkCommandBufferAllocateInfo cmdBufInfo = {
@@ -400,6 +401,62 @@ ktxVulkanDeviceInfo_getMemoryType(ktxVulkanDeviceInfo* This,
     return 0;
 }
 
+/*
+ * Commands of optional extensions and features. They are not members of
+ * ktxVulkanFunctions because ktxVulkanDeviceInfo, which embeds that, is
+ * allocated by applications so its size is part of the ABI. Instead they
+ * are retrieved through vkFuncs when needed. Those the device doesn't
+ * provide are NULL.
+ */
+typedef struct ktxVulkanExtensionFunctions {
+    PFN_vkGetPhysicalDeviceProperties2 vkGetPhysicalDeviceProperties2;
+    PFN_vkCopyMemoryToImageEXT vkCopyMemoryToImageEXT;
+    PFN_vkTransitionImageLayoutEXT vkTransitionImageLayoutEXT;
+    PFN_vkGetImageSparseMemoryRequirements vkGetImageSparseMemoryRequirements;
+    PFN_vkQueueBindSparse vkQueueBindSparse;
+} ktxVulkanExtensionFunctions;
+
+/* Get the VK_EXT_host_image_copy commands. vkGetDeviceProcAddr returns NULL
+ * for them unless the application enabled the extension. */
+static void
+ktxVulkanDeviceInfo_getHostImageCopyFunctions(ktxVulkanDeviceInfo* This,
+                                            ktxVulkanExtensionFunctions* pExt)
+{
+    pExt->vkCopyMemoryToImageEXT = (PFN_vkCopyMemoryToImageEXT)
+        This->vkFuncs.vkGetDeviceProcAddr(This->device,
+                                          "vkCopyMemoryToImageEXT");
+    pExt->vkTransitionImageLayoutEXT = (PFN_vkTransitionImageLayoutEXT)
+        This->vkFuncs.vkGetDeviceProcAddr(This->device,
+                                          "vkTransitionImageLayoutEXT");
+    pExt->vkGetPhysicalDeviceProperties2 = NULL;
+    if (pExt->vkCopyMemoryToImageEXT && pExt->vkTransitionImageLayoutEXT) {
+        // Needed to query the layouts the extension can copy to.
+        if (This->instance != VK_NULL_HANDLE)
+            pExt->vkGetPhysicalDeviceProperties2
+                = (PFN_vkGetPhysicalDeviceProperties2)
+                  This->vkFuncs.vkGetInstanceProcAddr(This->instance,
+                                            "vkGetPhysicalDeviceProperties2");
+        else
+            pExt->vkGetPhysicalDeviceProperties2
+                = (PFN_vkGetPhysicalDeviceProperties2)
+                  ktxLoadVulkanFunction("vkGetPhysicalDeviceProperties2");
+    }
+}
+
+/* Get the commands for sparse resident images. Devices without the
+ * sparseBinding feature may not provide them. */
+static void
+ktxVulkanDeviceInfo_getSparseFunctions(ktxVulkanDeviceInfo* This,
+                                       ktxVulkanExtensionFunctions* pExt)
+{
+    pExt->vkGetImageSparseMemoryRequirements
+        = (PFN_vkGetImageSparseMemoryRequirements)
+          This->vkFuncs.vkGetDeviceProcAddr(This->device,
+                                        "vkGetImageSparseMemoryRequirements");
+    pExt->vkQueueBindSparse = (PFN_vkQueueBindSparse)
+        This->vkFuncs.vkGetDeviceProcAddr(This->device, "vkQueueBindSparse");
+}
+
 //======================================================================
 //  ReadImages callbacks
 //======================================================================
@@ -413,6 +470,9 @@ typedef struct user_cbdata_optimal {
     ktx_uint8_t* dest;         // Pointer to mapped staging buffer.
     ktx_uint32_t elementSize;
     ktx_uint32_t numDimensions;
+    // The following are used only by optimalTilingConvertCallback
+    ktxTexture* texture;
+    const ktxFormatConversion* conversion;
 #if defined(_DEBUG)
     VkBufferImageCopy* regionsArrayEnd;
 #endif
@@ -564,12 +624,274 @@ optimalTilingPadCallback(int miplevel, int face,
     return KTX_SUCCESS;
 }
 
+/**
+ * @internal
+ * @~English
+ * @brief Callback for optimally tiled textures whose format must be converted
+ *        for the device.
+ *
+ * Like optimalTilingPadCallback but converts each row of texels to
+ * the format described by @c ud->conversion while copying it to the staging
+ * buffer. Source rows may be padded. As in optimalTilingPadCallback, the
+ * offset of the next region is rounded to a multiple of 4 and the converted
+ * element size, e.g. after the 2 byte texels of R32_SFLOAT to R16_SFLOAT.
+ *
+ * @copydetails PFNKTXITERCB
+ */
+static KTX_error_code
+optimalTilingConvertCallback(int miplevel, int face,
+                             int width, int height, int depth,
+                             ktx_uint64_t faceLodSize,
+                             void* pixels, void* userdata)
+{
+    user_cbdata_optimal* ud = (user_cbdata_optimal*)userdata;
+    const ktxFormatConversion* conversion = ud->conversion;
+    ktx_uint32_t srcRowPitch = ktxTexture_GetRowPitch(ud->texture, miplevel);
+    ktx_uint32_t dstElementSize = ktxFormatConversion_dstElementSize(conversion);
+    ktx_uint32_t dstRowPitch = width * dstElementSize;
+    ktx_uint64_t numRows = faceLodSize / srcRowPitch;
+    ktx_uint8_t* pSrc = pixels;
+
+#if defined(_DEBUG)
+    assert(ud->region < ud->regionsArrayEnd);
+#endif
+    assert(ud->offset % dstElementSize == 0 && ud->offset % 4 == 0);
+    ud->region->bufferOffset = ud->offset;
+
+    for (ktx_uint64_t row = 0; row < numRows; row++) {
+        ktxFormatConversion_convert(conversion, pSrc, ud->dest + ud->offset,
+                                    width);
+        ud->offset += dstRowPitch;
+        pSrc += srcRowPitch;
+    }
+
+    // Round to needed multiples for next region.
+    ud->offset = _KTX_PADN(lcm4(dstElementSize), ud->offset);
+
+    ud->region->bufferRowLength = 0;
+    ud->region->bufferImageHeight = 0;
+    ud->region->imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    ud->region->imageSubresource.mipLevel = miplevel;
+    ud->region->imageSubresource.baseArrayLayer = face;
+    ud->region->imageSubresource.layerCount = ud->numLayers * ud->numFaces;
+    ud->region->imageOffset.x = 0;
+    ud->region->imageOffset.y = 0;
+    ud->region->imageOffset.z = 0;
+    ud->region->imageExtent.width = width;
+    ud->region->imageExtent.height = height;
+    ud->region->imageExtent.depth = depth;
+
+    ud->region += 1;
+
+    return KTX_SUCCESS;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Callback staging the base level of textures whose other levels
+ *        are generated on the CPU.
+ *
+ * Copies the level 0 images to the staging buffer tightly packed, removing
+ * any source row padding, as the mipmap generator expects. Other levels are
+ * ignored. Copy regions are set up by generateCpuMipmaps.
+ *
+ * @copydetails PFNKTXITERCB
+ */
+static KTX_error_code
+cpuMipmapBaseCallback(int miplevel, int face,
+                      int width, int height, int depth,
+                      ktx_uint64_t faceLodSize,
+                      void* pixels, void* userdata)
+{
+    user_cbdata_optimal* ud = (user_cbdata_optimal*)userdata;
+    ktx_uint32_t srcRowPitch = ktxTexture_GetRowPitch(ud->texture, miplevel);
+    ktx_uint32_t rowPitch = width * ud->elementSize;
+    ktx_uint32_t imageIterations, row, numRows;
+    ktx_uint8_t* pSrc = pixels;
+    UNUSED(face);
+    UNUSED(faceLodSize);
+
+    if (miplevel != 0)
+        return KTX_SUCCESS;
+
+    if (ud->numDimensions == 3)
+        imageIterations = depth;
+    else if (ud->numLayers > 1)
+        imageIterations = ud->numLayers * ud->numFaces;
+    else
+        imageIterations = 1;
+    numRows = imageIterations * height;
+    for (row = 0; row < numRows; row++) {
+        memcpy(ud->dest + ud->offset, pSrc, rowPitch);
+        ud->offset += rowPitch;
+        pSrc += srcRowPitch;
+    }
+    return KTX_SUCCESS;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Return the offset of the next level after one of @p levelSize
+ *        bytes at @p offset in a staging buffer of CPU generated mipmaps.
+ *
+ * Level offsets must be multiples of 4 and the element size.
+ */
+static VkDeviceSize
+cpuMipmapNextOffset(VkDeviceSize offset, VkDeviceSize levelSize,
+                    ktx_uint32_t elementSize)
+{
+    VkDeviceSize alignment = lcm4(elementSize);
+    return (offset + levelSize + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Return the size of a staging buffer holding @p numLevels levels,
+ *        each of @p numLayers tightly packed images, of @p This.
+ */
+static VkDeviceSize
+cpuMipmapStagingSize(ktxTexture* This, ktx_uint32_t elementSize,
+                     ktx_uint32_t numLevels, ktx_uint32_t numLayers)
+{
+    VkDeviceSize size = 0;
+    ktx_uint32_t level;
+
+    for (level = 0; level < numLevels; level++) {
+        VkDeviceSize levelSize = (VkDeviceSize)elementSize * numLayers
+                                 * MAX(1, This->baseWidth >> level)
+                                 * MAX(1, This->baseHeight >> level)
+                                 * MAX(1, This->baseDepth >> level);
+        size = cpuMipmapNextOffset(size, levelSize, elementSize);
+    }
+    return size;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Generate mip levels 1 to @p numLevels - 1 on the CPU.
+ *
+ * Level 0 must already be tightly packed at the start of @p pStaging.
+ * Each level is filtered from the one before it and written after it in
+ * @p pStaging. A copy region is set up for every level, including level 0,
+ * in @p regions, which must have room for @p numLevels.
+ */
+static KTX_error_code
+generateCpuMipmaps(ktxTexture* This, VkFormat vkFormat,
+                   ktxMipmapFilter filter, ktx_uint32_t elementSize,
+                   ktx_uint32_t numLevels, ktx_uint32_t numLayers,
+                   ktx_uint8_t* pStaging, VkBufferImageCopy* regions)
+{
+    VkDeviceSize offset = 0;
+    ktx_uint32_t level;
+
+    for (level = 0; level < numLevels; level++) {
+        ktx_uint32_t width = MAX(1, This->baseWidth >> level);
+        ktx_uint32_t height = MAX(1, This->baseHeight >> level);
+        ktx_uint32_t depth = MAX(1, This->baseDepth >> level);
+        VkBufferImageCopy* region = &regions[level];
+
+        if (level > 0) {
+            const VkBufferImageCopy* prev = region - 1;
+            KTX_error_code result;
+
+            result = ktxMipmapGen_generateLevel(vkFormat, filter,
+                                        pStaging + prev->bufferOffset,
+                                        prev->imageExtent.width,
+                                        prev->imageExtent.height,
+                                        prev->imageExtent.depth,
+                                        numLayers, pStaging + offset);
+            if (result != KTX_SUCCESS)
+                return result;
+        }
+
+        region->bufferOffset = offset;
+        region->bufferRowLength = 0;
+        region->bufferImageHeight = 0;
+        region->imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region->imageSubresource.mipLevel = level;
+        region->imageSubresource.baseArrayLayer = 0;
+        region->imageSubresource.layerCount = numLayers;
+        region->imageOffset.x = 0;
+        region->imageOffset.y = 0;
+        region->imageOffset.z = 0;
+        region->imageExtent.width = width;
+        region->imageExtent.height = height;
+        region->imageExtent.depth = depth;
+
+        offset = cpuMipmapNextOffset(offset,
+                               (VkDeviceSize)elementSize * numLayers
+                               * width * height * depth,
+                               elementSize);
+    }
+    return KTX_SUCCESS;
+}
+
+typedef struct user_cbdata_host_copy {
+    VkMemoryToImageCopyEXT* region; // Specify destination region in image.
+    ktx_uint32_t numFaces;
+    ktx_uint32_t numLayers;
+#if defined(_DEBUG)
+    VkMemoryToImageCopyEXT* regionsArrayEnd;
+#endif
+} user_cbdata_host_copy;
+
+/**
+ * @internal
+ * @~English
+ * @brief Callback for copying textures with VK_EXT_host_image_copy.
+ *
+ * Like optimalTilingCallback but the region copies straight from
+ * @p pixels, the level's data in the texture's memory, instead of a
+ * staging buffer. The images must have no row padding.
+ *
+ * @copydetails PFNKTXITERCB
+ */
+static KTX_error_code
+hostImageCopyCallback(int miplevel, int face,
+                      int width, int height, int depth,
+                      ktx_uint64_t faceLodSize,
+                      void* pixels, void* userdata)
+{
+    user_cbdata_host_copy* ud = (user_cbdata_host_copy*)userdata;
+    UNUSED(faceLodSize);
+
+#if defined(_DEBUG)
+    assert(ud->region < ud->regionsArrayEnd);
+#endif
+    ud->region->sType = VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT;
+    ud->region->pNext = NULL;
+    ud->region->pHostPointer = pixels;
+    // These 2 are expressed in texels. 0 means tightly packed.
+    ud->region->memoryRowLength = 0;
+    ud->region->memoryImageHeight = 0;
+    ud->region->imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    ud->region->imageSubresource.mipLevel = miplevel;
+    ud->region->imageSubresource.baseArrayLayer = face;
+    ud->region->imageSubresource.layerCount = ud->numLayers * ud->numFaces;
+    ud->region->imageOffset.x = 0;
+    ud->region->imageOffset.y = 0;
+    ud->region->imageOffset.z = 0;
+    ud->region->imageExtent.width = width;
+    ud->region->imageExtent.height = height;
+    ud->region->imageExtent.depth = depth;
+
+    ud->region += 1;
+
+    return KTX_SUCCESS;
+}
+
 typedef struct user_cbdata_linear {
     ktxVulkanFunctions vkFuncs;
     VkImage destImage;
     VkDevice device;
     uint8_t* dest;   // Pointer to mapped Image memory
     ktxTexture* texture;
+    // Used only by linearTilingConvertCallback
+    const ktxFormatConversion* conversion;
 } user_cbdata_linear;
 
 /**
@@ -722,158 +1044,95 @@ linearTilingPadCallback(int miplevel, int face,
 }
 
 /**
- * @memberof ktxTexture
+ * @internal
  * @~English
- * @brief Create a Vulkan image object from a ktxTexture object.
- *
- * Creates a VkImage with @c VkFormat etc. matching the KTX data and uploads
- * the images.  Mipmaps will be generated if the @c ktxTexture's
- * @c generateMipmaps flag is set. Returns the handles of the created objects
- * and information about the texture in the @c ktxVulkanTexture pointed at by
- * @p vkTexture.
- *
- * The created VkImage will have @c VK_SHARING_MODE_EXCLUSIVE set thus the
- * resulting image will be usable only with queues of the same family as
- * the @c queue in the ktxVulkanDeviceInfo pointed to by @a vdi.
- *
- * @p usageFlags and thus acceptable usage of the created image may be
- * augmented as follows:
- * - with @c VK_IMAGE_USAGE_TRANSFER_DST_BIT if @p tiling is
- *   @c VK_IMAGE_TILING_OPTIMAL
- * - with <code>VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT</code>
- *   if @c generateMipmaps is set in the @c ktxTexture.
- *
- * Most Vulkan implementations support @c VK_IMAGE_TILING_LINEAR only for a very
- * limited number of formats and features. Generally @c VK_IMAGE_TILING_OPTIMAL
- * is preferred. The latter requires a staging buffer so will use more memory
- * during loading.
- *
- * @param[in] This          pointer to the ktxTexture from which to upload.
- * @param [in] vdi          pointer to a ktxVulkanDeviceInfo structure providing
- *                          information about the Vulkan device onto which to
- *                          load the texture.
- * @param [in,out] vkTexture pointer to a ktxVulkanTexture structure into which
- *                           the function writes information about the created
- *                           VkImage.
- * @param [in] tiling       type of tiling to use in the destination image
- *                          on the Vulkan device.
- * @param [in] usageFlags   a set of VkImageUsageFlags bits indicating the
- *                          intended usage of the destination image.
- * @param [in] finalLayout  a VkImageLayout value indicating the desired
- *                          final layout of the created image.
- *
- * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ * @brief Callback for linear tiled textures whose format must be converted
+ *        for the device.
  *
- * @exception KTX_INVALID_VALUE @p This, @p vdi or @p vkTexture is @c NULL.
- * @exception KTX_INVALID_OPERATION The ktxTexture contains neither images nor
- *                                  an active stream from which to read them.
- * @exception KTX_INVALID_OPERATION The combination of the ktxTexture's format,
- *                                  @p tiling and @p usageFlags is not supported
- *                                  by the physical device.
- * @exception KTX_INVALID_OPERATION Requested mipmap generation is not supported
- *                                  by the physical device for the combination
- *                                  of the ktxTexture's format and @p tiling.
- * @exception KTX_INVALID_OPERATION Number of mip levels or array layers exceeds
- *                                  the maximums supported for the ktxTexture's
- *                                  format and @p tiling.
- * @exception KTX_OUT_OF_MEMORY Sufficient memory could not be allocated on
- *                              either the CPU or the Vulkan device.
+ * Converts each row of texels to the format described by @c ud->conversion
+ * while copying it into the mapped Vulkan image at the row and image pitches
+ * the image's subresource layout reports.
  *
- * @sa ktxVulkanDeviceInfo_construct()
+ * @copydetails PFNKTXITERCB
  */
-KTX_error_code
-ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
-                      ktxVulkanTexture* vkTexture,
-                      VkImageTiling tiling,
-                      VkImageUsageFlags usageFlags,
-                      VkImageLayout finalLayout)
+static KTX_error_code
+linearTilingConvertCallback(int miplevel, int face,
+                            int width, int height, int depth,
+                            ktx_uint64_t faceLodSize,
+                            void* pixels, void* userdata)
 {
-    KTX_error_code           kResult;
-    VkFilter                 blitFilter = VK_FILTER_LINEAR;
-    VkFormat                 vkFormat;
-    VkImageType              imageType;
-    VkImageViewType          viewType;
-    VkImageCreateFlags       createFlags = 0;
-    VkImageFormatProperties  imageFormatProperties;
-    VkResult                 vResult;
-    VkCommandBufferBeginInfo cmdBufBeginInfo = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .pNext = NULL
-    };
-    VkImageCreateInfo        imageCreateInfo = {
-         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-         .pNext = NULL
-    };
-    VkMemoryAllocateInfo     memAllocInfo = {
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .pNext = NULL,
-        .allocationSize = 0,
-        .memoryTypeIndex = 0
+    user_cbdata_linear* ud = (user_cbdata_linear*)userdata;
+    ktxTexture* texture = ud->texture;
+    VkSubresourceLayout subResLayout;
+    VkDeviceSize imagePitch = 0;
+    ktx_uint32_t srcRowPitch;
+    ktx_uint32_t imageIterations = 1;
+    ktx_uint32_t image;
+    ktx_int32_t row;
+    ktx_uint8_t* pSrc = pixels;
+#if !defined(_MSC_VER) || _MSC_VER >= 1920
+    VkImageSubresource subRes = {
+      .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+      .mipLevel = miplevel,
+      .arrayLayer = face
     };
-    VkMemoryRequirements     memReqs;
-    ktx_uint32_t             numImageLayers, numImageLevels;
-    ktx_uint32_t elementSize = ktxTexture_GetElementSize(This);
-    ktx_bool_t               canUseFasterPath;
+#else
+    VkImageSubresource subRes = {0};
+    subRes.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    subRes.mipLevel = miplevel;
+    subRes.arrayLayer = face;
+#endif
 
-    if (!vdi || !This || !vkTexture) {
-        return KTX_INVALID_VALUE;
-    }
+    UNUSED(faceLodSize);
 
-    if (!This->pData && !ktxTexture_isActiveStream(This)) {
-        /* Nothing to upload. */
-        return KTX_INVALID_OPERATION;
+    ud->vkFuncs.vkGetImageSubresourceLayout(ud->device, ud->destImage, &subRes,
+                                &subResLayout);
+    srcRowPitch = ktxTexture_GetRowPitch(texture, miplevel);
+
+    // See linearTilingPadCallback for when arrayPitch and depthPitch are
+    // defined.
+    if (texture->numLayers > 1) {
+        imageIterations = texture->numLayers * texture->numFaces;
+        imagePitch = subResLayout.arrayPitch;
+    } else if (texture->numDimensions == 3) {
+        imageIterations = depth;
+        imagePitch = subResLayout.depthPitch;
     }
 
-    /* _ktxCheckHeader should have caught this. */
-    assert(This->numFaces == 6 ? This->numDimensions == 2 : VK_TRUE);
+    for (image = 0; image < imageIterations; image++) {
+        ktx_uint8_t* pDst = ud->dest + subResLayout.offset
+                          + imagePitch * image;
+        for (row = 0; row < height; row++) {
+            ktxFormatConversion_convert(ud->conversion, pSrc, pDst, width);
+            pDst += subResLayout.rowPitch;
+            pSrc += srcRowPitch;
+        }
+    }
+    return KTX_SUCCESS;
+}
 
-    numImageLayers = This->numLayers;
-    if (This->isCubemap) {
-        numImageLayers *= 6;
-        createFlags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
-    }
-
-    assert(This->numDimensions >= 1 && This->numDimensions <= 3);
-    switch (This->numDimensions) {
-      case 1:
-        imageType = VK_IMAGE_TYPE_1D;
-        viewType = This->isArray ?
-                        VK_IMAGE_VIEW_TYPE_1D_ARRAY : VK_IMAGE_VIEW_TYPE_1D;
-        break;
-      case 2:
-      default: // To keep compilers happy.
-        imageType = VK_IMAGE_TYPE_2D;
-        if (This->isCubemap)
-            viewType = This->isArray ?
-                        VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
-        else
-            viewType = This->isArray ?
-                        VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
-        break;
-      case 3:
-        imageType = VK_IMAGE_TYPE_3D;
-        /* 3D array textures not supported in Vulkan. Attempts to create or
-         * load them should have been trapped long before this.
-         */
-        assert(!This->isArray);
-        viewType = VK_IMAGE_VIEW_TYPE_3D;
-        break;
-    }
-
-    vkFormat = ktxTexture_GetVkFormat(This);
-    if (vkFormat == VK_FORMAT_UNDEFINED) {
-        return KTX_INVALID_OPERATION;
-    }
+/**
+ * @internal
+ * @~English
+ * @brief Check the device can create images of @p vkFormat for @p This.
+ *
+ * On success returns the number of levels the image needs and, if mipmaps
+ * are to be generated, the filter to use for blitting them. If the device
+ * cannot blit @p vkFormat and @p pCpuMipmaps is not @c NULL, succeeds when
+ * the levels can instead be generated on the CPU and sets *@p pCpuMipmaps.
+ */
+static KTX_error_code
+checkFormatSupport(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
+                   VkFormat vkFormat, VkImageType imageType,
+                   VkImageTiling tiling, VkImageUsageFlags usageFlags,
+                   VkImageCreateFlags createFlags,
+                   ktx_uint32_t* pNumImageLevels, VkFilter* pBlitFilter,
+                   ktx_bool_t* pCpuMipmaps)
+{
+    VkImageFormatProperties  imageFormatProperties;
+    VkResult                 vResult;
+    ktx_uint32_t             numImageLevels;
 
-    /* Get device properties for the requested image format */
-    if (tiling == VK_IMAGE_TILING_OPTIMAL) {
-        // Ensure we can copy from staging buffer to image.
-        usageFlags |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-    }
-    if (This->generateMipmaps) {
-        // Ensure we can blit between levels.
-        usageFlags |= (VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
-    }
     vResult = vdi->vkFuncs.vkGetPhysicalDeviceImageFormatProperties(vdi->physicalDevice,
                                                       vkFormat,
                                                       imageType,
@@ -903,13 +1162,18 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
         else
             formatFeatureFlags = formatProperties.linearTilingFeatures;
 
-        if ((formatFeatureFlags & neededFeatures) != neededFeatures)
-            return KTX_INVALID_OPERATION;
+        if ((formatFeatureFlags & neededFeatures) != neededFeatures) {
+            // Only the staging path can hold the levels made on the CPU.
+            if (pCpuMipmaps == NULL || tiling != VK_IMAGE_TILING_OPTIMAL
+                || !ktxMipmapGen_isSupported(vkFormat))
+                return KTX_INVALID_OPERATION;
+            *pCpuMipmaps = KTX_TRUE;
+        }
 
         if (formatFeatureFlags & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
-            blitFilter = VK_FILTER_LINEAR;
+            *pBlitFilter = VK_FILTER_LINEAR;
         else
-            blitFilter = VK_FILTER_NEAREST; // XXX INVALID_OP?
+            *pBlitFilter = VK_FILTER_NEAREST; // XXX INVALID_OP?
 
         max_dim = MAX(MAX(This->baseWidth, This->baseHeight), This->baseDepth);
         numImageLevels = (uint32_t)floor(log2(max_dim)) + 1;
@@ -920,192 +1184,709 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
     if (numImageLevels > imageFormatProperties.maxMipLevels) {
         return KTX_INVALID_OPERATION;
     }
+    *pNumImageLevels = numImageLevels;
+    return KTX_SUCCESS;
+}
 
-    if (This->classId == ktxTexture2_c) {
-        canUseFasterPath = KTX_TRUE;
-    } else {
-        ktx_uint32_t actualRowPitch = ktxTexture_GetRowPitch(This, 0);
-        ktx_uint32_t tightRowPitch = elementSize * This->baseWidth;
-        // If the texture's images do not have any row padding, we can use a
-        // faster path. Only uncompressed textures might have padding.
-        //
-        // The first test in the if will match compressed textures, because
-        // they all have a block size that is a multiple of 4, as well as
-        // a class of uncompressed textures that will never need padding.
-        //
-        // The second test matches textures whose level 0 has no padding. Any
-        // texture whose block size is not a multiple of 4 will need padding
-        // at some miplevel even if level 0 does not. So, if more than 1 level
-        // exists, we must use the slower path.
-        //
-        // Note all elementSizes > 4 Will be a multiple of 4, so only
-        // elementSizes of 1, 2 & 3 are a concern here.
-        if (elementSize % 4 == 0  /* There'll be no padding at any level. */
-               /* There is no padding at level 0 and no other levels. */
-            || (This->numLevels == 1 && actualRowPitch == tightRowPitch))
-            canUseFasterPath = KTX_TRUE;
-        else
-            canUseFasterPath = KTX_FALSE;
-    }
-
-    vkTexture->width = This->baseWidth;
-    vkTexture->height = This->baseHeight;
-    vkTexture->depth = This->baseDepth;
-    vkTexture->imageLayout = finalLayout;
-    vkTexture->imageFormat = vkFormat;
-    vkTexture->levelCount = numImageLevels;
-    vkTexture->layerCount = numImageLayers;
-    vkTexture->viewType = viewType;
-    vkTexture->vkDestroyImage = vdi->vkFuncs.vkDestroyImage;
-    vkTexture->vkFreeMemory = vdi->vkFuncs.vkFreeMemory;
-
-    VK_CHECK_RESULT(
-            vdi->vkFuncs.vkBeginCommandBuffer(vdi->cmdBuffer, &cmdBufBeginInfo)
-            );
-
-    if (tiling == VK_IMAGE_TILING_OPTIMAL)
-    {
-        // Create a host-visible staging buffer that contains the raw image data
-        VkBuffer stagingBuffer;
-        VkDeviceMemory stagingMemory;
-        VkBufferImageCopy* copyRegions;
-        VkDeviceSize textureSize;
-        VkBufferCreateInfo bufferCreateInfo = {
-          .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-          .pNext = NULL
-        };
-        VkImageSubresourceRange subresourceRange;
-        VkFence copyFence;
-        VkFenceCreateInfo fenceCreateInfo = {
-            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-            .pNext = NULL,
-            .flags = VK_FLAGS_NONE
-        };
-        VkSubmitInfo submitInfo = {
-            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-            .pNext = NULL
-        };
-        ktx_uint8_t* pMappedStagingBuffer;
-        ktx_uint32_t numCopyRegions;
-        user_cbdata_optimal cbData;
-
-
-        textureSize = ktxTexture_GetDataSizeUncompressed(This);
-        bufferCreateInfo.size = textureSize;
-        if (canUseFasterPath) {
-            /*
-             * Because all array layers and faces are the same size they can
-             * be copied in a single operation so there'll be 1 copy per mip
-             * level.
-             */
-            numCopyRegions = This->numLevels;
-        } else {
-            /*
-             * Have to copy all images individually into the staging
-             * buffer so we can place them at correct multiples of
-             * elementSize and 4 and also need a copy region per image
-             * in case they end up with padding between them.
-             */
-            numCopyRegions = This->isArray ? This->numLevels
-                                  : This->numLevels * This->numFaces;
-            /*
-             * Add extra space to allow for possible padding described
-             * above. A bit ad-hoc but it's only a small amount of
-             * memory.
-             */
-            bufferCreateInfo.size += numCopyRegions * elementSize * 4;
-        }
-        copyRegions = (VkBufferImageCopy*)malloc(sizeof(VkBufferImageCopy)
-                                                   * numCopyRegions);
-        if (copyRegions == NULL) {
-            return KTX_OUT_OF_MEMORY;
+/**
+ * @internal
+ * @~English
+ * @brief Check if images of @p vkFormat can be loaded with
+ *        VK_EXT_host_image_copy.
+ *
+ * The caller must have been told, by KTX_VK_UPLOAD_HOST_IMAGE_COPY_BIT,
+ * that the application enabled the extension and its @c hostImageCopy
+ * feature. The extension's commands must be available, the device must
+ * support host transfers to
+ * optimally tiled images of the format and @p finalLayout must be one of
+ * the layouts the device can copy to from the host.
+ */
+static ktx_bool_t
+canUseHostImageCopy(ktxVulkanDeviceInfo* vdi,
+                    const ktxVulkanExtensionFunctions* pExt,
+                    VkFormat vkFormat, VkImageType imageType,
+                    VkImageUsageFlags usageFlags,
+                    VkImageCreateFlags createFlags, VkImageLayout finalLayout)
+{
+    VkImageFormatProperties imageFormatProperties;
+    VkPhysicalDeviceHostImageCopyPropertiesEXT hostImageCopyProperties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_PROPERTIES_EXT,
+        .pNext = NULL
+    };
+    VkPhysicalDeviceProperties2 properties = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &hostImageCopyProperties
+    };
+    VkImageLayout* layouts;
+    ktx_bool_t supported = KTX_FALSE;
+
+    if (!pExt->vkCopyMemoryToImageEXT
+        || !pExt->vkTransitionImageLayoutEXT
+        || !pExt->vkGetPhysicalDeviceProperties2)
+        return KTX_FALSE;
+
+    if (vdi->vkFuncs.vkGetPhysicalDeviceImageFormatProperties(
+                               vdi->physicalDevice, vkFormat, imageType,
+                               VK_IMAGE_TILING_OPTIMAL,
+                               usageFlags | VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT,
+                               createFlags, &imageFormatProperties)
+        != VK_SUCCESS)
+        return KTX_FALSE;
+
+    // First query the number of layouts, then the layouts.
+    pExt->vkGetPhysicalDeviceProperties2(vdi->physicalDevice, &properties);
+    if (hostImageCopyProperties.copyDstLayoutCount == 0)
+        return KTX_FALSE;
+    layouts = (VkImageLayout*)malloc(sizeof(VkImageLayout)
+                               * hostImageCopyProperties.copyDstLayoutCount);
+    if (layouts == NULL)
+        return KTX_FALSE;
+    hostImageCopyProperties.copySrcLayoutCount = 0;
+    hostImageCopyProperties.pCopySrcLayouts = NULL;
+    hostImageCopyProperties.pCopyDstLayouts = layouts;
+    pExt->vkGetPhysicalDeviceProperties2(vdi->physicalDevice, &properties);
+    for (uint32_t i = 0; i < hostImageCopyProperties.copyDstLayoutCount; i++) {
+        if (layouts[i] == finalLayout) {
+            supported = KTX_TRUE;
+            break;
         }
+    }
+    free(layouts);
+    return supported;
+}
 
-        // This buffer is used as a transfer source for the buffer copy
-        bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-        bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-        VK_CHECK_RESULT(
-                vdi->vkFuncs.vkCreateBuffer(vdi->device, &bufferCreateInfo,
-                                       vdi->pAllocator, &stagingBuffer));
-
-        // Get memory requirements for the staging buffer (alignment,
-        // memory type bits)
-        vdi->vkFuncs.vkGetBufferMemoryRequirements(vdi->device, stagingBuffer, &memReqs);
+/**
+ * @internal
+ * @~English
+ * @brief Create an optimally tiled image and load it with
+ *        VK_EXT_host_image_copy.
+ *
+ * The images are copied by the host straight from the texture's data so
+ * neither a staging buffer nor a command buffer submission is needed.
+ * The texture's images must be loaded and have no row padding and mipmap
+ * generation must not be requested.
+ */
+static KTX_error_code
+hostImageCopyUpload(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
+                    const ktxVulkanExtensionFunctions* pExt,
+                    ktxVulkanTexture* vkTexture,
+                    VkImageType imageType, VkImageCreateFlags createFlags,
+                    VkImageUsageFlags usageFlags, VkImageLayout finalLayout)
+{
+    VkImageCreateInfo imageCreateInfo = {
+         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+         .pNext = NULL
+    };
+    VkMemoryAllocateInfo memAllocInfo = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = NULL
+    };
+    VkHostImageLayoutTransitionInfoEXT transitionInfo = {
+        .sType = VK_STRUCTURE_TYPE_HOST_IMAGE_LAYOUT_TRANSITION_INFO_EXT,
+        .pNext = NULL
+    };
+    VkCopyMemoryToImageInfoEXT copyInfo = {
+        .sType = VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_EXT,
+        .pNext = NULL
+    };
+    VkMemoryRequirements memReqs;
+    VkMemoryToImageCopyEXT* copyRegions;
+    user_cbdata_host_copy cbData;
+    VkResult vResult;
+
+    // There is 1 copy per level as all array layers and faces are the same
+    // size and, without padding, contiguous.
+    copyRegions = (VkMemoryToImageCopyEXT*)malloc(
+                              sizeof(VkMemoryToImageCopyEXT) * This->numLevels);
+    if (copyRegions == NULL) {
+        return KTX_OUT_OF_MEMORY;
+    }
 
-        memAllocInfo.allocationSize = memReqs.size;
-        // Get memory type index for a host visible buffer
-        memAllocInfo.memoryTypeIndex = ktxVulkanDeviceInfo_getMemoryType(
-                vdi,
-                memReqs.memoryTypeBits,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-              | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        );
+    imageCreateInfo.imageType = imageType;
+    imageCreateInfo.flags = createFlags;
+    imageCreateInfo.format = vkTexture->imageFormat;
+    imageCreateInfo.mipLevels = vkTexture->levelCount;
+    imageCreateInfo.arrayLayers = vkTexture->layerCount;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageCreateInfo.usage = usageFlags | VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageCreateInfo.extent.width = vkTexture->width;
+    imageCreateInfo.extent.height = vkTexture->height;
+    imageCreateInfo.extent.depth = vkTexture->depth;
 
-        vResult = vdi->vkFuncs.vkAllocateMemory(vdi->device, &memAllocInfo,
-                                  vdi->pAllocator, &stagingMemory);
-        if (vResult != VK_SUCCESS) {
-            return KTX_OUT_OF_MEMORY;
-        }
-        VK_CHECK_RESULT(
-                vdi->vkFuncs.vkBindBufferMemory(vdi->device, stagingBuffer,
-                                           stagingMemory, 0));
+    VK_CHECK_RESULT(
+            vdi->vkFuncs.vkCreateImage(vdi->device, &imageCreateInfo,
+                                       vdi->pAllocator, &vkTexture->image));
 
-        VK_CHECK_RESULT(
-                vdi->vkFuncs.vkMapMemory(vdi->device, stagingMemory, 0,
-                                    memReqs.size, 0,
-                                    (void **)&pMappedStagingBuffer));
+    vdi->vkFuncs.vkGetImageMemoryRequirements(vdi->device, vkTexture->image,
+                                              &memReqs);
+    memAllocInfo.allocationSize = memReqs.size;
+    memAllocInfo.memoryTypeIndex = ktxVulkanDeviceInfo_getMemoryType(
+                                          vdi, memReqs.memoryTypeBits,
+                                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    vResult = vdi->vkFuncs.vkAllocateMemory(vdi->device, &memAllocInfo,
+                                            vdi->pAllocator,
+                                            &vkTexture->deviceMemory);
+    if (vResult != VK_SUCCESS) {
+        vdi->vkFuncs.vkDestroyImage(vdi->device, vkTexture->image,
+                                    vdi->pAllocator);
+        free(copyRegions);
+        return KTX_OUT_OF_MEMORY;
+    }
+    VK_CHECK_RESULT(
+            vdi->vkFuncs.vkBindImageMemory(vdi->device, vkTexture->image,
+                                           vkTexture->deviceMemory, 0));
+
+    // The image is copied to directly in finalLayout.
+    transitionInfo.image = vkTexture->image;
+    transitionInfo.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    transitionInfo.newLayout = finalLayout;
+    transitionInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    transitionInfo.subresourceRange.baseMipLevel = 0;
+    transitionInfo.subresourceRange.levelCount = vkTexture->levelCount;
+    transitionInfo.subresourceRange.baseArrayLayer = 0;
+    transitionInfo.subresourceRange.layerCount = vkTexture->layerCount;
+    VK_CHECK_RESULT(
+            pExt->vkTransitionImageLayoutEXT(vdi->device, 1, &transitionInfo));
 
-        cbData.offset = 0;
-        cbData.region = copyRegions;
-        cbData.numFaces = This->numFaces;
-        cbData.numLayers = This->numLayers;
-        cbData.dest = pMappedStagingBuffer;
-        cbData.elementSize = elementSize;
-        cbData.numDimensions = This->numDimensions;
+    cbData.region = copyRegions;
+    cbData.numFaces = This->numFaces;
+    cbData.numLayers = This->numLayers;
 #if defined(_DEBUG)
-        cbData.regionsArrayEnd = copyRegions + numCopyRegions;
+    cbData.regionsArrayEnd = copyRegions + This->numLevels;
 #endif
-        if (canUseFasterPath) {
-            // Bulk load the data to the staging buffer and iterate
-            // over levels.
-
-            if (This->pData) {
-                // Image data has already been loaded. Copy to staging
-                // buffer.
-                assert(This->dataSize <= memAllocInfo.allocationSize);
-                memcpy(pMappedStagingBuffer, This->pData, This->dataSize);
-            } else {
-                /* Load the image data directly into the staging buffer. */
-                /* The strange cast quiets an Xcode warning when building
-                 * for the Generic iOS Device where size_t is 32-bit even
-                 * when building for arm64. */
-                kResult = ktxTexture_LoadImageData(This,
-                                      pMappedStagingBuffer,
-                                      (ktx_size_t)memAllocInfo.allocationSize);
-                if (kResult != KTX_SUCCESS)
-                    return kResult;
-            }
+    ktxTexture_IterateLevels(This, hostImageCopyCallback, &cbData);
+
+    copyInfo.flags = 0;
+    copyInfo.dstImage = vkTexture->image;
+    copyInfo.dstImageLayout = finalLayout;
+    copyInfo.regionCount = This->numLevels;
+    copyInfo.pRegions = copyRegions;
+    vResult = pExt->vkCopyMemoryToImageEXT(vdi->device, &copyInfo);
+    free(copyRegions);
+    if (vResult != VK_SUCCESS) {
+        ktxVulkanTexture_Destruct(vkTexture, vdi->device, vdi->pAllocator);
+        return vResult == VK_ERROR_OUT_OF_HOST_MEMORY
+               || vResult == VK_ERROR_OUT_OF_DEVICE_MEMORY
+               ? KTX_OUT_OF_MEMORY : KTX_INVALID_OPERATION;
+    }
+    return KTX_SUCCESS;
+}
 
-            // Iterate over mip levels to set up the copy regions.
-            kResult = ktxTexture_IterateLevels(This,
-                                               optimalTilingCallback,
-                                               &cbData);
-            // XXX Check for possible errors.
-        } else {
-            // Iterate over face-levels with callback that copies the
-            // face-levels to Vulkan-valid offsets in the staging buffer while
-            // removing padding. Using face-levels minimizes pre-staging-buffer
-            // buffering, in the event the data is not already loaded.
+/**
+ * @memberof ktxTexture
+ * @~English
+ * @brief Create a Vulkan image object from a ktxTexture object.
+ *
+ * Creates a VkImage with @c VkFormat etc. matching the KTX data and uploads
+ * the images.  Mipmaps will be generated if the @c ktxTexture's
+ * @c generateMipmaps flag is set. Returns the handles of the created objects
+ * and information about the texture in the @c ktxVulkanTexture pointed at by
+ * @p vkTexture.
+ *
+ * The created VkImage will have @c VK_SHARING_MODE_EXCLUSIVE set thus the
+ * resulting image will be usable only with queues of the same family as
+ * the @c queue in the ktxVulkanDeviceInfo pointed to by @a vdi.
+ *
+ * @p usageFlags and thus acceptable usage of the created image may be
+ * augmented as follows:
+ * - with @c VK_IMAGE_USAGE_TRANSFER_DST_BIT if @p tiling is
+ *   @c VK_IMAGE_TILING_OPTIMAL
+ * - with <code>VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT</code>
+ *   if @c generateMipmaps is set in the @c ktxTexture.
+ *
+ * Most Vulkan implementations support @c VK_IMAGE_TILING_LINEAR only for a very
+ * limited number of formats and features. Generally @c VK_IMAGE_TILING_OPTIMAL
+ * is preferred. The latter requires a staging buffer so will use more memory
+ * during loading.
+ *
+ * If @c KTX_VK_UPLOAD_HOST_IMAGE_COPY_BIT is given to
+ * ktxTexture_VkUploadEx_WithFlags, telling that the application has enabled
+ * the @c VK_EXT_host_image_copy device extension and its @c hostImageCopy
+ * feature, optimally tiled images are instead copied by the host straight from the texture's data with
+ * @c vkCopyMemoryToImageEXT, needing neither a staging buffer nor a queue
+ * submission. This is done when the images are already loaded, have no
+ * row padding, need neither format conversion nor mipmap generation and
+ * the device supports host copies of the format to @p finalLayout. The
+ * image's usage is then augmented with
+ * @c VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT. Otherwise the staging buffer
+ * is used.
+ *
+ * Mipmaps are normally generated by blitting each level from the one
+ * before it. When the device cannot blit the format with @p tiling
+ * @c VK_IMAGE_TILING_OPTIMAL, they are instead generated on the CPU, in the
+ * staging buffer, for uncompressed formats whose components are 8, 16 or
+ * 32 bits. A box filter is used unless
+ * @c KTX_VK_UPLOAD_KAISER_MIPMAPS_BIT is given to
+ * ktxTexture_VkUploadEx_WithFlags. sRGB formats are filtered in linear
+ * space.
+ *
+ * @param[in] This          pointer to the ktxTexture from which to upload.
+ * @param [in] vdi          pointer to a ktxVulkanDeviceInfo structure providing
+ *                          information about the Vulkan device onto which to
+ *                          load the texture.
+ * @param [in,out] vkTexture pointer to a ktxVulkanTexture structure into which
+ *                           the function writes information about the created
+ *                           VkImage.
+ * @param [in] tiling       type of tiling to use in the destination image
+ *                          on the Vulkan device.
+ * @param [in] usageFlags   a set of VkImageUsageFlags bits indicating the
+ *                          intended usage of the destination image.
+ * @param [in] finalLayout  a VkImageLayout value indicating the desired
+ *                          final layout of the created image.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This, @p vdi or @p vkTexture is @c NULL.
+ * @exception KTX_INVALID_OPERATION The ktxTexture contains neither images nor
+ *                                  an active stream from which to read them.
+ * @exception KTX_INVALID_OPERATION The combination of the ktxTexture's format,
+ *                                  @p tiling and @p usageFlags is not supported
+ *                                  by the physical device.
+ * @exception KTX_INVALID_OPERATION Requested mipmap generation is not supported
+ *                                  by the physical device for the combination
+ *                                  of the ktxTexture's format and @p tiling
+ *                                  and cannot be done on the CPU.
+ * @exception KTX_INVALID_OPERATION Number of mip levels or array layers exceeds
+ *                                  the maximums supported for the ktxTexture's
+ *                                  format and @p tiling.
+ * @exception KTX_OUT_OF_MEMORY Sufficient memory could not be allocated on
+ *                              either the CPU or the Vulkan device.
+ *
+ * @sa ktxVulkanDeviceInfo_construct()
+ * @sa ktxTexture_VkUploadEx_WithFlags() to load textures whose format the
+ *     device does not support.
+ */
+KTX_error_code
+ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
+                      ktxVulkanTexture* vkTexture,
+                      VkImageTiling tiling,
+                      VkImageUsageFlags usageFlags,
+                      VkImageLayout finalLayout)
+{
+    return ktxTexture_VkUploadEx_WithFlags(This, vdi, vkTexture, tiling,
+                                           usageFlags, finalLayout, 0);
+}
+
+/**
+ * @memberof ktxTexture
+ * @~English
+ * @brief Create a Vulkan image object from a ktxTexture object with
+ *        additional control over the upload.
+ *
+ * As ktxTexture_VkUploadEx() with the addition of @p uploadFlags.
+ *
+ * When @p uploadFlags includes @c KTX_VK_UPLOAD_CONVERT_FORMAT_BIT and the
+ * device does not support the texture's format for the requested @p tiling,
+ * @p usageFlags and mipmap generation, the image is instead created with
+ * the nearest supported format and the texels are converted while being
+ * copied to the staging buffer or, for linear tiling, the image. No
+ * intermediate texture is created. The conversions are
+ *
+ * - R8G8B8_* and B8G8R8_* to R8G8B8A8_* and B8G8R8A8_*,
+ * - R16G16B16_* to R16G16B16A16_*,
+ * - R32G32B32_* to R32G32B32A32_*,
+ *
+ * with alpha set to 1. If @p uploadFlags also includes
+ * @c KTX_VK_UPLOAD_CONVERT_FORMAT_LOSSY_BIT, 32-bit float formats may be
+ * narrowed to 16-bit float and 64-bit float formats to 32- or 16-bit float.
+ * Lossless conversions are preferred. The format used is returned in
+ * @c vkTexture->imageFormat.
+ *
+ * Conversion is not available for block-compressed formats.
+ *
+ * When @p uploadFlags includes @c KTX_VK_UPLOAD_HOST_IMAGE_COPY_BIT,
+ * optimally tiled images may be loaded with VK_EXT_host_image_copy as
+ * described below. The application must have enabled the extension's
+ * @c hostImageCopy feature as that can't be queried here.
+ *
+ * @copydetails ktxTexture::ktxTexture_VkUploadEx
+ * @param [in] uploadFlags  a set of @c ktxVulkanUploadFlagBits.
+ */
+KTX_error_code
+ktxTexture_VkUploadEx_WithFlags(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
+                                ktxVulkanTexture* vkTexture,
+                                VkImageTiling tiling,
+                                VkImageUsageFlags usageFlags,
+                                VkImageLayout finalLayout,
+                                ktxVulkanUploadFlags uploadFlags)
+{
+    KTX_error_code           kResult;
+    VkFilter                 blitFilter = VK_FILTER_LINEAR;
+    VkFormat                 vkFormat;
+    VkImageType              imageType;
+    VkImageViewType          viewType;
+    VkImageCreateFlags       createFlags = 0;
+    VkResult                 vResult;
+    ktxFormatConversion      conversions[KTX_MAX_FORMAT_CONVERSIONS];
+    const ktxFormatConversion* conversion = NULL;
+    VkCommandBufferBeginInfo cmdBufBeginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = NULL
+    };
+    VkImageCreateInfo        imageCreateInfo = {
+         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+         .pNext = NULL
+    };
+    VkMemoryAllocateInfo     memAllocInfo = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = NULL,
+        .allocationSize = 0,
+        .memoryTypeIndex = 0
+    };
+    VkMemoryRequirements     memReqs;
+    ktx_uint32_t             numImageLayers, numImageLevels;
+    ktx_uint32_t elementSize = ktxTexture_GetElementSize(This);
+    ktx_bool_t               canUseFasterPath;
+    ktx_bool_t               cpuMipmaps = KTX_FALSE;
+
+    if (!vdi || !This || !vkTexture) {
+        return KTX_INVALID_VALUE;
+    }
+
+    if (!This->pData && !ktxTexture_isActiveStream(This)) {
+        /* Nothing to upload. */
+        return KTX_INVALID_OPERATION;
+    }
+
+    /* _ktxCheckHeader should have caught this. */
+    assert(This->numFaces == 6 ? This->numDimensions == 2 : VK_TRUE);
+
+    numImageLayers = This->numLayers;
+    if (This->isCubemap) {
+        numImageLayers *= 6;
+        createFlags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+    }
+
+    assert(This->numDimensions >= 1 && This->numDimensions <= 3);
+    switch (This->numDimensions) {
+      case 1:
+        imageType = VK_IMAGE_TYPE_1D;
+        viewType = This->isArray ?
+                        VK_IMAGE_VIEW_TYPE_1D_ARRAY : VK_IMAGE_VIEW_TYPE_1D;
+        break;
+      case 2:
+      default: // To keep compilers happy.
+        imageType = VK_IMAGE_TYPE_2D;
+        if (This->isCubemap)
+            viewType = This->isArray ?
+                        VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
+        else
+            viewType = This->isArray ?
+                        VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+        break;
+      case 3:
+        imageType = VK_IMAGE_TYPE_3D;
+        /* 3D array textures not supported in Vulkan. Attempts to create or
+         * load them should have been trapped long before this.
+         */
+        assert(!This->isArray);
+        viewType = VK_IMAGE_VIEW_TYPE_3D;
+        break;
+    }
+
+    vkFormat = ktxTexture_GetVkFormat(This);
+    if (vkFormat == VK_FORMAT_UNDEFINED) {
+        return KTX_INVALID_OPERATION;
+    }
+
+    /* Get device properties for the requested image format */
+    if (tiling == VK_IMAGE_TILING_OPTIMAL) {
+        // Ensure we can copy from staging buffer to image.
+        usageFlags |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    }
+    if (This->generateMipmaps) {
+        // Ensure we can blit between levels.
+        usageFlags |= (VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+    }
+    kResult = checkFormatSupport(This, vdi, vkFormat, imageType, tiling,
+                                 usageFlags, createFlags,
+                                 &numImageLevels, &blitFilter, &cpuMipmaps);
+    if (kResult == KTX_INVALID_OPERATION
+        && (uploadFlags & KTX_VK_UPLOAD_CONVERT_FORMAT_BIT)) {
+        ktx_uint32_t numConversions, i;
+        cpuMipmaps = KTX_FALSE;
+        numConversions = ktxFormatConversion_candidates(vkFormat,
+                     (uploadFlags & KTX_VK_UPLOAD_CONVERT_FORMAT_LOSSY_BIT) != 0,
+                     conversions);
+        for (i = 0; i < numConversions; i++) {
+            kResult = checkFormatSupport(This, vdi, conversions[i].dstFormat,
+                                         imageType, tiling, usageFlags,
+                                         createFlags,
+                                         &numImageLevels, &blitFilter, NULL);
+            if (kResult == KTX_SUCCESS) {
+                conversion = &conversions[i];
+                vkFormat = conversion->dstFormat;
+                break;
+            }
+        }
+    }
+    if (kResult != KTX_SUCCESS) {
+        return kResult;
+    }
+
+    if (conversion) {
+        // Every image has to pass through the converter.
+        canUseFasterPath = KTX_FALSE;
+    } else if (This->classId == ktxTexture2_c) {
+        canUseFasterPath = KTX_TRUE;
+    } else {
+        ktx_uint32_t actualRowPitch = ktxTexture_GetRowPitch(This, 0);
+        ktx_uint32_t tightRowPitch = elementSize * This->baseWidth;
+        // If the texture's images do not have any row padding, we can use a
+        // faster path. Only uncompressed textures might have padding.
+        //
+        // The first test in the if will match compressed textures, because
+        // they all have a block size that is a multiple of 4, as well as
+        // a class of uncompressed textures that will never need padding.
+        //
+        // The second test matches textures whose level 0 has no padding. Any
+        // texture whose block size is not a multiple of 4 will need padding
+        // at some miplevel even if level 0 does not. So, if more than 1 level
+        // exists, we must use the slower path.
+        //
+        // Note all elementSizes > 4 Will be a multiple of 4, so only
+        // elementSizes of 1, 2 & 3 are a concern here.
+        if (elementSize % 4 == 0  /* There'll be no padding at any level. */
+               /* There is no padding at level 0 and no other levels. */
+            || (This->numLevels == 1 && actualRowPitch == tightRowPitch))
+            canUseFasterPath = KTX_TRUE;
+        else
+            canUseFasterPath = KTX_FALSE;
+    }
+
+    vkTexture->width = This->baseWidth;
+    vkTexture->height = This->baseHeight;
+    vkTexture->depth = This->baseDepth;
+    vkTexture->imageLayout = finalLayout;
+    vkTexture->imageFormat = vkFormat;
+    vkTexture->levelCount = numImageLevels;
+    vkTexture->layerCount = numImageLayers;
+    vkTexture->viewType = viewType;
+    vkTexture->vkDestroyImage = vdi->vkFuncs.vkDestroyImage;
+    vkTexture->vkFreeMemory = vdi->vkFuncs.vkFreeMemory;
+
+    // Whether the hostImageCopy feature is enabled can't be queried so the
+    // caller has to say.
+    if ((uploadFlags & KTX_VK_UPLOAD_HOST_IMAGE_COPY_BIT)
+        && tiling == VK_IMAGE_TILING_OPTIMAL && This->pData && canUseFasterPath
+        && !This->generateMipmaps) {
+        ktxVulkanExtensionFunctions ext;
+
+        ktxVulkanDeviceInfo_getHostImageCopyFunctions(vdi, &ext);
+        if (canUseHostImageCopy(vdi, &ext, vkFormat, imageType, usageFlags,
+                                createFlags, finalLayout)) {
+            // Copy from the texture's data without staging or submission.
+            return hostImageCopyUpload(This, vdi, &ext, vkTexture, imageType,
+                                       createFlags, usageFlags, finalLayout);
+        }
+    }
+
+    VK_CHECK_RESULT(
+            vdi->vkFuncs.vkBeginCommandBuffer(vdi->cmdBuffer, &cmdBufBeginInfo)
+            );
+
+    if (tiling == VK_IMAGE_TILING_OPTIMAL)
+    {
+        // Create a host-visible staging buffer that contains the raw image data
+        VkBuffer stagingBuffer;
+        VkDeviceMemory stagingMemory;
+        VkBufferImageCopy* copyRegions;
+        VkDeviceSize textureSize;
+        VkBufferCreateInfo bufferCreateInfo = {
+          .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+          .pNext = NULL
+        };
+        VkImageSubresourceRange subresourceRange;
+        VkFence copyFence;
+        VkFenceCreateInfo fenceCreateInfo = {
+            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+            .pNext = NULL,
+            .flags = VK_FLAGS_NONE
+        };
+        VkSubmitInfo submitInfo = {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = NULL
+        };
+        ktx_uint8_t* pMappedStagingBuffer;
+        ktx_uint32_t numCopyRegions;
+        user_cbdata_optimal cbData;
+
+
+        textureSize = ktxTexture_GetDataSizeUncompressed(This);
+        if (conversion) {
+            // Converted images are tightly packed. Any padding in the
+            // source only makes this larger than needed.
+            textureSize = textureSize
+                          / ktxFormatConversion_srcElementSize(conversion)
+                          * ktxFormatConversion_dstElementSize(conversion);
+        }
+        bufferCreateInfo.size = textureSize;
+        if (cpuMipmaps) {
+            // Level 0 and all the levels generated from it, tightly packed.
+            bufferCreateInfo.size = cpuMipmapStagingSize(This, elementSize,
+                                                         numImageLevels,
+                                                         numImageLayers);
+            numCopyRegions = numImageLevels;
+        } else if (canUseFasterPath) {
+            /*
+             * Because all array layers and faces are the same size they can
+             * be copied in a single operation so there'll be 1 copy per mip
+             * level.
+             */
+            numCopyRegions = This->numLevels;
+        } else {
+            /*
+             * Have to copy all images individually into the staging
+             * buffer so we can place them at correct multiples of
+             * elementSize and 4 and also need a copy region per image
+             * in case they end up with padding between them.
+             */
+            numCopyRegions = This->isArray ? This->numLevels
+                                  : This->numLevels * This->numFaces;
+            /*
+             * Add extra space to allow for possible padding described
+             * above. A bit ad-hoc but it's only a small amount of
+             * memory. Converted regions are padded to multiples of the
+             * converted element size.
+             */
+            if (conversion) {
+                bufferCreateInfo.size += numCopyRegions
+                    * (lcm4(ktxFormatConversion_dstElementSize(conversion)) - 1);
+            } else {
+                bufferCreateInfo.size += numCopyRegions * elementSize * 4;
+            }
+        }
+        copyRegions = (VkBufferImageCopy*)malloc(sizeof(VkBufferImageCopy)
+                                                   * numCopyRegions);
+        if (copyRegions == NULL) {
+            return KTX_OUT_OF_MEMORY;
+        }
+
+        // This buffer is used as a transfer source for the buffer copy
+        bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VK_CHECK_RESULT(
+                vdi->vkFuncs.vkCreateBuffer(vdi->device, &bufferCreateInfo,
+                                       vdi->pAllocator, &stagingBuffer));
+
+        // Get memory requirements for the staging buffer (alignment,
+        // memory type bits)
+        vdi->vkFuncs.vkGetBufferMemoryRequirements(vdi->device, stagingBuffer, &memReqs);
+
+        memAllocInfo.allocationSize = memReqs.size;
+        // Get memory type index for a host visible buffer
+        memAllocInfo.memoryTypeIndex = ktxVulkanDeviceInfo_getMemoryType(
+                vdi,
+                memReqs.memoryTypeBits,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+              | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
+
+        vResult = vdi->vkFuncs.vkAllocateMemory(vdi->device, &memAllocInfo,
+                                  vdi->pAllocator, &stagingMemory);
+        if (vResult != VK_SUCCESS) {
+            return KTX_OUT_OF_MEMORY;
+        }
+        VK_CHECK_RESULT(
+                vdi->vkFuncs.vkBindBufferMemory(vdi->device, stagingBuffer,
+                                           stagingMemory, 0));
+
+        VK_CHECK_RESULT(
+                vdi->vkFuncs.vkMapMemory(vdi->device, stagingMemory, 0,
+                                    memReqs.size, 0,
+                                    (void **)&pMappedStagingBuffer));
+
+        cbData.offset = 0;
+        cbData.region = copyRegions;
+        cbData.numFaces = This->numFaces;
+        cbData.numLayers = This->numLayers;
+        cbData.dest = pMappedStagingBuffer;
+        cbData.elementSize = elementSize;
+        cbData.numDimensions = This->numDimensions;
+        cbData.texture = This;
+        cbData.conversion = conversion;
+#if defined(_DEBUG)
+        cbData.regionsArrayEnd = copyRegions + numCopyRegions;
+#endif
+        if (cpuMipmaps) {
+            // Stage level 0 then filter each level from the one before.
+            if (This->pData) {
+                kResult = ktxTexture_IterateLevelFaces(
+                                            This,
+                                            cpuMipmapBaseCallback,
+                                            &cbData);
+            } else {
+                kResult = ktxTexture_IterateLoadLevelFaces(
+                                            This,
+                                            cpuMipmapBaseCallback,
+                                            &cbData);
+            }
+            if (kResult == KTX_SUCCESS) {
+                ktxMipmapFilter filter
+                    = (uploadFlags & KTX_VK_UPLOAD_KAISER_MIPMAPS_BIT)
+                      ? KTX_MIPMAP_FILTER_KAISER : KTX_MIPMAP_FILTER_BOX;
+                kResult = generateCpuMipmaps(This, vkFormat, filter,
+                                             elementSize, numImageLevels,
+                                             numImageLayers,
+                                             pMappedStagingBuffer,
+                                             copyRegions);
+            }
+            if (kResult != KTX_SUCCESS) {
+                vdi->vkFuncs.vkUnmapMemory(vdi->device, stagingMemory);
+                vdi->vkFuncs.vkFreeMemory(vdi->device, stagingMemory,
+                                          vdi->pAllocator);
+                vdi->vkFuncs.vkDestroyBuffer(vdi->device, stagingBuffer,
+                                             vdi->pAllocator);
+                free(copyRegions);
+                return kResult;
+            }
+        } else if (canUseFasterPath) {
+            // Bulk load the data to the staging buffer and iterate
+            // over levels.
+
+            if (This->pData) {
+                // Image data has already been loaded. Copy to staging
+                // buffer.
+                assert(This->dataSize <= memAllocInfo.allocationSize);
+                memcpy(pMappedStagingBuffer, This->pData, This->dataSize);
+            } else {
+                /* Load the image data directly into the staging buffer. */
+                /* The strange cast quiets an Xcode warning when building
+                 * for the Generic iOS Device where size_t is 32-bit even
+                 * when building for arm64. */
+                kResult = ktxTexture_LoadImageData(This,
+                                      pMappedStagingBuffer,
+                                      (ktx_size_t)memAllocInfo.allocationSize);
+                if (kResult != KTX_SUCCESS)
+                    return kResult;
+            }
+
+            // Iterate over mip levels to set up the copy regions.
+            kResult = ktxTexture_IterateLevels(This,
+                                               optimalTilingCallback,
+                                               &cbData);
+            // XXX Check for possible errors.
+        } else {
+            // Iterate over face-levels with callback that copies the
+            // face-levels to Vulkan-valid offsets in the staging buffer while
+            // removing padding, and converting if necessary. Using
+            // face-levels minimizes pre-staging-buffer buffering, in the
+            // event the data is not already loaded.
+            PFNKTXITERCB callback = conversion ? optimalTilingConvertCallback
+                                               : optimalTilingPadCallback;
             if (This->pData) {
                 kResult = ktxTexture_IterateLevelFaces(
                                             This,
-                                            optimalTilingPadCallback,
+                                            callback,
                                             &cbData);
             } else {
                 kResult = ktxTexture_IterateLoadLevelFaces(
                                             This,
-                                            optimalTilingPadCallback,
+                                            callback,
                                             &cbData);
                 // XXX Check for possible errors.
             }
@@ -1150,7 +1931,8 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
 
         subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
         subresourceRange.baseMipLevel = 0;
-        subresourceRange.levelCount = This->numLevels;
+        subresourceRange.levelCount = cpuMipmaps ? numImageLevels
+                                                 : This->numLevels;
         subresourceRange.baseArrayLayer = 0;
         subresourceRange.layerCount = numImageLayers;
 
@@ -1174,13 +1956,14 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
 
         free(copyRegions);
 
-        if (This->generateMipmaps) {
+        if (This->generateMipmaps && !cpuMipmaps) {
             generateMipmaps(vkTexture, vdi,
                             blitFilter, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
         } else {
             // Transition image layout to finalLayout after all mip levels
             // have been copied.
-            // In this case numImageLevels == This->numLevels
+            // In this case numImageLevels == This->numLevels or all levels
+            // were generated on the CPU.
             //subresourceRange.levelCount = numImageLevels;
             setImageLayout(
                 vdi->vkFuncs,
@@ -1275,7 +2058,11 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
         cbData.destImage = mappableImage;
         cbData.device = vdi->device;
         cbData.texture = This;
-        callback = canUseFasterPath ?
+        cbData.conversion = conversion;
+        if (conversion)
+            callback = linearTilingConvertCallback;
+        else
+            callback = canUseFasterPath ?
                          linearTilingCallback : linearTilingPadCallback;
 
         // Map image memory
@@ -1293,149 +2080,1161 @@ ktxTexture_VkUploadEx(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
                                                    callback,
                                                    &cbData);
         }
-        // XXX Check for possible errors
-
-        vdi->vkFuncs.vkUnmapMemory(vdi->device, mappableMemory);
+        // XXX Check for possible errors
+
+        vdi->vkFuncs.vkUnmapMemory(vdi->device, mappableMemory);
+
+        // Linear tiled images can be directly used as textures.
+        vkTexture->image = mappableImage;
+        vkTexture->deviceMemory = mappableMemory;
+
+        if (This->generateMipmaps) {
+            generateMipmaps(vkTexture, vdi,
+                            blitFilter,
+                            VK_IMAGE_LAYOUT_PREINITIALIZED);
+        } else {
+            VkImageSubresourceRange subresourceRange;
+            subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            subresourceRange.baseMipLevel = 0;
+            subresourceRange.levelCount = numImageLevels;
+            subresourceRange.baseArrayLayer = 0;
+            subresourceRange.layerCount = numImageLayers;
+
+           // Transition image layout to finalLayout.
+            setImageLayout(
+                vdi->vkFuncs,
+                vdi->cmdBuffer,
+                vkTexture->image,
+                VK_IMAGE_LAYOUT_PREINITIALIZED,
+                finalLayout,
+                subresourceRange);
+        }
+
+        // Submit command buffer containing image layout commands
+        VK_CHECK_RESULT(vdi->vkFuncs.vkEndCommandBuffer(vdi->cmdBuffer));
+
+        submitInfo.waitSemaphoreCount = 0;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &vdi->cmdBuffer;
+
+        VK_CHECK_RESULT(vdi->vkFuncs.vkQueueSubmit(vdi->queue, 1, &submitInfo, nullFence));
+        VK_CHECK_RESULT(vdi->vkFuncs.vkQueueWaitIdle(vdi->queue));
+    }
+    return KTX_SUCCESS;
+}
+
+
+/** @memberof ktxTexture
+ * @~English
+ * @brief Create a Vulkan image object from a ktxTexture object.
+ *
+ * Calls ktxTexture_VkUploadEx() with the most commonly used options:
+ * VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT and
+ * VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+ *
+ * @sa ktxTexture_VkUploadEx() for details and use that for complete
+ *     control.
+ */
+KTX_error_code
+ktxTexture_VkUpload(ktxTexture* texture, ktxVulkanDeviceInfo* vdi,
+                    ktxVulkanTexture *vkTexture)
+{
+    return ktxTexture_VkUploadEx(ktxTexture(texture), vdi, vkTexture,
+                                 VK_IMAGE_TILING_OPTIMAL,
+                                 VK_IMAGE_USAGE_SAMPLED_BIT,
+                                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+/** @memberof ktxTexture1
+ * @~English
+ * @brief Create a Vulkan image object from a ktxTexture1 object.
+ *
+ * This simplly calls ktxTexture_VkUploadEx.
+ *
+ * @copydetails ktxTexture::ktxTexture_VkUploadEx
+ */
+KTX_error_code
+ktxTexture1_VkUploadEx(ktxTexture1* This, ktxVulkanDeviceInfo* vdi,
+                       ktxVulkanTexture* vkTexture,
+                       VkImageTiling tiling,
+                       VkImageUsageFlags usageFlags,
+                       VkImageLayout finalLayout)
+{
+    return ktxTexture_VkUploadEx(ktxTexture(This), vdi, vkTexture,
+                                 tiling, usageFlags, finalLayout);
+}
+
+/** @memberof ktxTexture1
+ * @~English
+ * @brief Create a Vulkan image object from a ktxTexture1 object with
+ *        additional control over the upload.
+ *
+ * This simply calls ktxTexture_VkUploadEx_WithFlags.
+ *
+ * @copydetails ktxTexture::ktxTexture_VkUploadEx_WithFlags
+ */
+KTX_error_code
+ktxTexture1_VkUploadEx_WithFlags(ktxTexture1* This, ktxVulkanDeviceInfo* vdi,
+                                 ktxVulkanTexture* vkTexture,
+                                 VkImageTiling tiling,
+                                 VkImageUsageFlags usageFlags,
+                                 VkImageLayout finalLayout,
+                                 ktxVulkanUploadFlags uploadFlags)
+{
+    return ktxTexture_VkUploadEx_WithFlags(ktxTexture(This), vdi, vkTexture,
+                                           tiling, usageFlags, finalLayout,
+                                           uploadFlags);
+}
+
+/** @memberof ktxTexture1
+ * @~English
+ * @brief Create a Vulkan image object from a ktxTexture1 object.
+ *
+ * Calls ktxTexture_VkUploadEx() with the most commonly used options:
+ * VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT and
+ * VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+ *
+ * @sa ktxTexture_VkUploadEx() for details and use that for complete
+ *     control.
+ */
+KTX_error_code
+ktxTexture1_VkUpload(ktxTexture1* texture, ktxVulkanDeviceInfo* vdi,
+                     ktxVulkanTexture *vkTexture)
+{
+    return ktxTexture_VkUploadEx(ktxTexture(texture), vdi, vkTexture,
+                                 VK_IMAGE_TILING_OPTIMAL,
+                                 VK_IMAGE_USAGE_SAMPLED_BIT,
+                                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+/** @memberof ktxTexture2
+ * @~English
+ * @brief Create a Vulkan image object from a ktxTexture2 object.
+ *
+ * This simplly calls ktxTexture_VkUploadEx.
+ *
+ * @copydetails ktxTexture::ktxTexture_VkUploadEx
+ */
+KTX_error_code
+ktxTexture2_VkUploadEx(ktxTexture2* This, ktxVulkanDeviceInfo* vdi,
+                       ktxVulkanTexture* vkTexture,
+                       VkImageTiling tiling,
+                       VkImageUsageFlags usageFlags,
+                       VkImageLayout finalLayout)
+{
+    return ktxTexture_VkUploadEx(ktxTexture(This), vdi, vkTexture,
+                                 tiling, usageFlags, finalLayout);
+}
+
+/** @memberof ktxTexture2
+ * @~English
+ * @brief Create a Vulkan image object from a ktxTexture2 object with
+ *        additional control over the upload.
+ *
+ * This simply calls ktxTexture_VkUploadEx_WithFlags.
+ *
+ * @copydetails ktxTexture::ktxTexture_VkUploadEx_WithFlags
+ */
+KTX_error_code
+ktxTexture2_VkUploadEx_WithFlags(ktxTexture2* This, ktxVulkanDeviceInfo* vdi,
+                                 ktxVulkanTexture* vkTexture,
+                                 VkImageTiling tiling,
+                                 VkImageUsageFlags usageFlags,
+                                 VkImageLayout finalLayout,
+                                 ktxVulkanUploadFlags uploadFlags)
+{
+    return ktxTexture_VkUploadEx_WithFlags(ktxTexture(This), vdi, vkTexture,
+                                           tiling, usageFlags, finalLayout,
+                                           uploadFlags);
+}
+
+/** @memberof ktxTexture2
+ * @~English
+ * @brief Create a Vulkan image object from a ktxTexture2 object.
+ *
+ * Calls ktxTexture_VkUploadEx() with the most commonly used options:
+ * VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT and
+ * VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+ *
+ * @sa ktxTexture2_VkUploadEx() for details and use that for complete
+ *     control.
+ */
+KTX_error_code
+ktxTexture2_VkUpload(ktxTexture2* This, ktxVulkanDeviceInfo* vdi,
+                     ktxVulkanTexture *vkTexture)
+{
+    return ktxTexture_VkUploadEx(ktxTexture(This), vdi, vkTexture,
+                                 VK_IMAGE_TILING_OPTIMAL,
+                                 VK_IMAGE_USAGE_SAMPLED_BIT,
+                                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+//======================================================================
+//  Sparse resident images
+//======================================================================
+
+/*
+ * Size of the blocks of device memory from which tile pages are taken.
+ * Pooling keeps the number of allocations well below the device's
+ * maxMemoryAllocationCount, which may be as low as 4096.
+ */
+#define SPARSE_BLOCK_SIZE (16 * 1024 * 1024)
+
+/*
+ * A box of texels in one level and array layer of an image. Used to
+ * describe both tiles and whole mip tail levels.
+ */
+typedef struct sparse_box {
+    uint32_t level;
+    uint32_t arrayLayer;
+    VkOffset3D offset;
+    VkExtent3D extent;
+} sparse_box;
+
+static VkExtent3D
+sparseLevelExtent(const ktxVulkanTexture* vkTexture, uint32_t level)
+{
+    VkExtent3D extent;
+    extent.width = MAX(1, vkTexture->width >> level);
+    extent.height = MAX(1, vkTexture->height >> level);
+    extent.depth = MAX(1, vkTexture->depth >> level);
+    return extent;
+}
+
+/* Find the index of @p pTile in This->pTilePage. */
+static ktx_bool_t
+sparseTileIndex(const ktxVulkanSparseTexture* This,
+                const ktxVulkanSparseTile* pTile, uint32_t* pIndex)
+{
+    VkExtent3D count;
+    uint32_t index = 0;
+
+    if (pTile->level >= This->mipTailFirstLod
+        || pTile->arrayLayer >= This->vkTexture.layerCount)
+        return KTX_FALSE;
+    for (uint32_t level = 0; level < pTile->level; level++) {
+        ktxVulkanSparseTexture_GetTileCount(This, level, &count);
+        index += count.width * count.height * count.depth
+                 * This->vkTexture.layerCount;
+    }
+    ktxVulkanSparseTexture_GetTileCount(This, pTile->level, &count);
+    if (pTile->x >= count.width || pTile->y >= count.height
+        || pTile->z >= count.depth)
+        return KTX_FALSE;
+    index += pTile->arrayLayer * count.width * count.height * count.depth;
+    index += (pTile->z * count.height + pTile->y) * count.width + pTile->x;
+    *pIndex = index;
+    return KTX_TRUE;
+}
+
+/* Tiles at the right, bottom and back edges are clipped to the level. */
+static sparse_box
+sparseTileBox(const ktxVulkanSparseTexture* This,
+              const ktxVulkanSparseTile* pTile)
+{
+    VkExtent3D levelExtent = sparseLevelExtent(&This->vkTexture, pTile->level);
+    sparse_box box;
+
+    box.level = pTile->level;
+    box.arrayLayer = pTile->arrayLayer;
+    box.offset.x = (int32_t)(pTile->x * This->tileExtent.width);
+    box.offset.y = (int32_t)(pTile->y * This->tileExtent.height);
+    box.offset.z = (int32_t)(pTile->z * This->tileExtent.depth);
+    box.extent.width = MIN(This->tileExtent.width,
+                           levelExtent.width - (uint32_t)box.offset.x);
+    box.extent.height = MIN(This->tileExtent.height,
+                            levelExtent.height - (uint32_t)box.offset.y);
+    box.extent.depth = MIN(This->tileExtent.depth,
+                           levelExtent.depth - (uint32_t)box.offset.z);
+    return box;
+}
+
+/* Size of the tightly packed blocks of @p pBox. */
+static VkDeviceSize
+sparseBoxDataSize(const ktxFormatSize* formatSize, const sparse_box* pBox)
+{
+    uint32_t blockDepth = MAX(1, formatSize->blockDepth);
+    VkDeviceSize blocksX, blocksY, blocksZ;
+
+    blocksX = (pBox->extent.width + formatSize->blockWidth - 1)
+              / formatSize->blockWidth;
+    blocksY = (pBox->extent.height + formatSize->blockHeight - 1)
+              / formatSize->blockHeight;
+    blocksZ = (pBox->extent.depth + blockDepth - 1) / blockDepth;
+    return blocksX * blocksY * blocksZ * (formatSize->blockSizeInBits / 8);
+}
+
+/* Copy the blocks of @p pBox from @p texture, tightly packed, to @p pDst. */
+static KTX_error_code
+sparseCopyBox(ktxTexture* texture, const sparse_box* pBox, ktx_uint8_t* pDst)
+{
+    const ktxFormatSize* formatSize = &texture->_protected->_formatSize;
+    uint32_t blockDepth = MAX(1, formatSize->blockDepth);
+    uint32_t blockSize = formatSize->blockSizeInBits / 8;
+    uint32_t blocksX, blocksY, blocksZ;
+    ktx_uint32_t rowPitch;
+    ktx_size_t imageOffset, imageSize, rowSize;
+    KTX_error_code result;
+
+    result = ktxTexture_GetImageOffset(texture, pBox->level,
+                                       pBox->arrayLayer / texture->numFaces,
+                                       pBox->arrayLayer % texture->numFaces,
+                                       &imageOffset);
+    if (result != KTX_SUCCESS)
+        return result;
+    rowPitch = ktxTexture_GetRowPitch(texture, pBox->level);
+    imageSize = ktxTexture_GetImageSize(texture, pBox->level);
+
+    blocksX = (pBox->extent.width + formatSize->blockWidth - 1)
+              / formatSize->blockWidth;
+    blocksY = (pBox->extent.height + formatSize->blockHeight - 1)
+              / formatSize->blockHeight;
+    blocksZ = (pBox->extent.depth + blockDepth - 1) / blockDepth;
+    rowSize = (ktx_size_t)blocksX * blockSize;
+    for (uint32_t z = 0; z < blocksZ; z++) {
+        ktx_uint8_t* pSlice = texture->pData + imageOffset
+                   + (pBox->offset.z / blockDepth + z) * imageSize
+                   + (pBox->offset.x / formatSize->blockWidth) * blockSize;
+        for (uint32_t y = 0; y < blocksY; y++) {
+            memcpy(pDst,
+                   pSlice + (ktx_size_t)(pBox->offset.y / formatSize->blockHeight
+                                         + y) * rowPitch,
+                   rowSize);
+            pDst += rowSize;
+        }
+    }
+    return KTX_SUCCESS;
+}
+
+/*
+ * Write to @p pRanges the subresources containing @p pBoxes, merging
+ * adjacent layers of a level. @p pRanges must have room for @p numBoxes
+ * ranges.
+ */
+static KTX_error_code
+sparseBoxRanges(const ktxVulkanSparseTexture* This, uint32_t numBoxes,
+                const sparse_box* pBoxes, VkImageSubresourceRange* pRanges,
+                uint32_t* pNumRanges)
+{
+    uint32_t layerCount = This->vkTexture.layerCount;
+    uint32_t numRanges = 0;
+    ktx_uint8_t* touched;
+
+    touched = (ktx_uint8_t*)calloc(This->vkTexture.levelCount * layerCount,
+                                   sizeof(ktx_uint8_t));
+    if (touched == NULL)
+        return KTX_OUT_OF_MEMORY;
+    for (uint32_t i = 0; i < numBoxes; i++)
+        touched[pBoxes[i].level * layerCount + pBoxes[i].arrayLayer] = 1;
+    for (uint32_t level = 0; level < This->vkTexture.levelCount; level++) {
+        for (uint32_t layer = 0; layer < layerCount; layer++) {
+            VkImageSubresourceRange* range;
+
+            if (!touched[level * layerCount + layer])
+                continue;
+            if (numRanges > 0) {
+                range = &pRanges[numRanges - 1];
+                if (range->baseMipLevel == level
+                    && range->baseArrayLayer + range->layerCount == layer) {
+                    range->layerCount++;
+                    continue;
+                }
+            }
+            range = &pRanges[numRanges++];
+            range->aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            range->baseMipLevel = level;
+            range->levelCount = 1;
+            range->baseArrayLayer = layer;
+            range->layerCount = 1;
+        }
+    }
+    free(touched);
+    *pNumRanges = numRanges;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @internal
+ * @~English
+ * @brief Copy boxes of texels from a ktxTexture to a sparse image.
+ *
+ * If @p oldLayout is @c UNDEFINED, i.e. the image has just been created,
+ * the whole image is transitioned to @c TRANSFER_DST_OPTIMAL for the
+ * copies then to the texture's @c imageLayout. Otherwise only the
+ * subresources containing the boxes are transitioned, from and back to
+ * @p oldLayout, so other resident tiles can stay in use. The memory for
+ * the boxes must already be bound.
+ */
+static KTX_error_code
+sparseUpload(ktxVulkanSparseTexture* This, ktxTexture* texture,
+             ktxVulkanDeviceInfo* vdi, uint32_t numBoxes,
+             const sparse_box* pBoxes, VkImageLayout oldLayout)
+{
+    const ktxFormatSize* formatSize = &texture->_protected->_formatSize;
+    uint32_t alignment = lcm4(formatSize->blockSizeInBits / 8);
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+    VkBufferImageCopy* copyRegions = NULL;
+    VkDeviceSize stagingSize = 0;
+    VkBufferCreateInfo bufferCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .pNext = NULL
+    };
+    VkMemoryAllocateInfo memAllocInfo = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = NULL
+    };
+    VkCommandBufferBeginInfo cmdBufBeginInfo = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = NULL
+    };
+    VkFenceCreateInfo fenceCreateInfo = {
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+        .pNext = NULL,
+        .flags = VK_FLAGS_NONE
+    };
+    VkSubmitInfo submitInfo = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = NULL
+    };
+    VkImageSubresourceRange* ranges = NULL;
+    VkMemoryRequirements memReqs;
+    VkFence copyFence;
+    ktx_uint8_t* pMappedStagingBuffer;
+    uint32_t numRanges;
+    KTX_error_code result = KTX_SUCCESS;
+
+    ranges = (VkImageSubresourceRange*)malloc(
+                             sizeof(VkImageSubresourceRange) * MAX(1, numBoxes));
+    if (ranges == NULL)
+        return KTX_OUT_OF_MEMORY;
+    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED) {
+        ranges[0].aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        ranges[0].baseMipLevel = 0;
+        ranges[0].levelCount = This->vkTexture.levelCount;
+        ranges[0].baseArrayLayer = 0;
+        ranges[0].layerCount = This->vkTexture.layerCount;
+        numRanges = 1;
+    } else {
+        result = sparseBoxRanges(This, numBoxes, pBoxes, ranges, &numRanges);
+        if (result != KTX_SUCCESS) {
+            free(ranges);
+            return result;
+        }
+    }
+
+    if (numBoxes > 0) {
+        copyRegions = (VkBufferImageCopy*)calloc(numBoxes,
+                                                 sizeof(VkBufferImageCopy));
+        if (copyRegions == NULL) {
+            free(ranges);
+            return KTX_OUT_OF_MEMORY;
+        }
+        for (uint32_t i = 0; i < numBoxes; i++) {
+            // Offsets must be a multiple of the block size and of 4.
+            stagingSize = (stagingSize + alignment - 1) / alignment * alignment;
+            copyRegions[i].bufferOffset = stagingSize;
+            copyRegions[i].imageSubresource.aspectMask
+                                                = VK_IMAGE_ASPECT_COLOR_BIT;
+            copyRegions[i].imageSubresource.mipLevel = pBoxes[i].level;
+            copyRegions[i].imageSubresource.baseArrayLayer
+                                                = pBoxes[i].arrayLayer;
+            copyRegions[i].imageSubresource.layerCount = 1;
+            copyRegions[i].imageOffset = pBoxes[i].offset;
+            copyRegions[i].imageExtent = pBoxes[i].extent;
+            stagingSize += sparseBoxDataSize(formatSize, &pBoxes[i]);
+        }
+
+        bufferCreateInfo.size = stagingSize;
+        bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        VK_CHECK_RESULT(
+                vdi->vkFuncs.vkCreateBuffer(vdi->device, &bufferCreateInfo,
+                                            vdi->pAllocator, &stagingBuffer));
+        vdi->vkFuncs.vkGetBufferMemoryRequirements(vdi->device, stagingBuffer,
+                                                   &memReqs);
+        memAllocInfo.allocationSize = memReqs.size;
+        memAllocInfo.memoryTypeIndex = ktxVulkanDeviceInfo_getMemoryType(
+                vdi,
+                memReqs.memoryTypeBits,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+              | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
+        if (vdi->vkFuncs.vkAllocateMemory(vdi->device, &memAllocInfo,
+                                          vdi->pAllocator, &stagingMemory)
+            != VK_SUCCESS) {
+            result = KTX_OUT_OF_MEMORY;
+            goto cleanup;
+        }
+        VK_CHECK_RESULT(
+                vdi->vkFuncs.vkBindBufferMemory(vdi->device, stagingBuffer,
+                                                stagingMemory, 0));
+        VK_CHECK_RESULT(
+                vdi->vkFuncs.vkMapMemory(vdi->device, stagingMemory, 0,
+                                         memReqs.size, 0,
+                                         (void **)&pMappedStagingBuffer));
+        for (uint32_t i = 0; i < numBoxes && result == KTX_SUCCESS; i++) {
+            result = sparseCopyBox(texture, &pBoxes[i],
+                           pMappedStagingBuffer + copyRegions[i].bufferOffset);
+        }
+        vdi->vkFuncs.vkUnmapMemory(vdi->device, stagingMemory);
+        if (result != KTX_SUCCESS)
+            goto cleanup;
+    }
 
-        // Linear tiled images can be directly used as textures.
-        vkTexture->image = mappableImage;
-        vkTexture->deviceMemory = mappableMemory;
+    VK_CHECK_RESULT(
+            vdi->vkFuncs.vkBeginCommandBuffer(vdi->cmdBuffer, &cmdBufBeginInfo));
 
-        if (This->generateMipmaps) {
-            generateMipmaps(vkTexture, vdi,
-                            blitFilter,
-                            VK_IMAGE_LAYOUT_PREINITIALIZED);
-        } else {
-            VkImageSubresourceRange subresourceRange;
-            subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            subresourceRange.baseMipLevel = 0;
-            subresourceRange.levelCount = numImageLevels;
-            subresourceRange.baseArrayLayer = 0;
-            subresourceRange.layerCount = numImageLayers;
+    for (uint32_t i = 0; i < numRanges; i++) {
+        setImageLayout(vdi->vkFuncs, vdi->cmdBuffer, This->vkTexture.image,
+                       oldLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       ranges[i]);
+    }
+    if (numBoxes > 0) {
+        vdi->vkFuncs.vkCmdCopyBufferToImage(
+                vdi->cmdBuffer, stagingBuffer,
+                This->vkTexture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                numBoxes, copyRegions);
+    }
+    for (uint32_t i = 0; i < numRanges; i++) {
+        setImageLayout(vdi->vkFuncs, vdi->cmdBuffer, This->vkTexture.image,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       This->vkTexture.imageLayout, ranges[i]);
+    }
 
-           // Transition image layout to finalLayout.
-            setImageLayout(
-                vdi->vkFuncs,
-                vdi->cmdBuffer,
-                vkTexture->image,
-                VK_IMAGE_LAYOUT_PREINITIALIZED,
-                finalLayout,
-                subresourceRange);
-        }
+    VK_CHECK_RESULT(vdi->vkFuncs.vkEndCommandBuffer(vdi->cmdBuffer));
+    VK_CHECK_RESULT(
+            vdi->vkFuncs.vkCreateFence(vdi->device, &fenceCreateInfo,
+                                       vdi->pAllocator, &copyFence));
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &vdi->cmdBuffer;
+    VK_CHECK_RESULT(
+            vdi->vkFuncs.vkQueueSubmit(vdi->queue, 1, &submitInfo, copyFence));
+    VK_CHECK_RESULT(
+            vdi->vkFuncs.vkWaitForFences(vdi->device, 1, &copyFence,
+                                         VK_TRUE, DEFAULT_FENCE_TIMEOUT));
+    vdi->vkFuncs.vkDestroyFence(vdi->device, copyFence, vdi->pAllocator);
 
-        // Submit command buffer containing image layout commands
-        VK_CHECK_RESULT(vdi->vkFuncs.vkEndCommandBuffer(vdi->cmdBuffer));
+cleanup:
+    if (numBoxes > 0) {
+        vdi->vkFuncs.vkFreeMemory(vdi->device, stagingMemory, vdi->pAllocator);
+        vdi->vkFuncs.vkDestroyBuffer(vdi->device, stagingBuffer,
+                                     vdi->pAllocator);
+    }
+    free(copyRegions);
+    free(ranges);
+    return result;
+}
 
-        submitInfo.waitSemaphoreCount = 0;
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &vdi->cmdBuffer;
+/* Bind, or with VK_NULL_HANDLE memory unbind, memory to tiles. */
+static KTX_error_code
+sparseBindTiles(ktxVulkanSparseTexture* This, ktxVulkanDeviceInfo* vdi,
+                uint32_t numBinds, const VkSparseImageMemoryBind* pBinds)
+{
+    ktxVulkanExtensionFunctions ext;
+    VkSparseImageMemoryBindInfo imageBindInfo;
+    VkBindSparseInfo bindInfo = {
+        .sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO,
+        .pNext = NULL
+    };
 
-        VK_CHECK_RESULT(vdi->vkFuncs.vkQueueSubmit(vdi->queue, 1, &submitInfo, nullFence));
-        VK_CHECK_RESULT(vdi->vkFuncs.vkQueueWaitIdle(vdi->queue));
-    }
+    ktxVulkanDeviceInfo_getSparseFunctions(vdi, &ext);
+    if (!ext.vkQueueBindSparse)
+        return KTX_INVALID_OPERATION;
+    imageBindInfo.image = This->vkTexture.image;
+    imageBindInfo.bindCount = numBinds;
+    imageBindInfo.pBinds = pBinds;
+    bindInfo.imageBindCount = 1;
+    bindInfo.pImageBinds = &imageBindInfo;
+    if (ext.vkQueueBindSparse(vdi->queue, 1, &bindInfo,
+                              VK_NULL_HANDLE) != VK_SUCCESS)
+        return KTX_OUT_OF_MEMORY;
+    // Binding happens on the queue. Wait so following copies and frees
+    // see it.
+    VK_CHECK_RESULT(vdi->vkFuncs.vkQueueWaitIdle(vdi->queue));
     return KTX_SUCCESS;
 }
 
+/* Make a bind for @p pTile of @p memory at @p memoryOffset. */
+static VkSparseImageMemoryBind
+sparseTileBind(const ktxVulkanSparseTexture* This,
+               const ktxVulkanSparseTile* pTile, VkDeviceMemory memory,
+               VkDeviceSize memoryOffset)
+{
+    sparse_box box = sparseTileBox(This, pTile);
+    VkSparseImageMemoryBind bind;
+
+    bind.subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    bind.subresource.mipLevel = pTile->level;
+    bind.subresource.arrayLayer = pTile->arrayLayer;
+    bind.offset = box.offset;
+    bind.extent = box.extent;
+    bind.memory = memory;
+    bind.memoryOffset = memoryOffset;
+    bind.flags = 0;
+    return bind;
+}
+
+/*
+ * Allocate another block of tile pages and push its pages on the free
+ * list, lowest last so it is used first.
+ */
+static KTX_error_code
+sparseAllocBlock(ktxVulkanSparseTexture* This, ktxVulkanDeviceInfo* vdi)
+{
+    VkMemoryAllocateInfo memAllocInfo = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = NULL
+    };
+    uint32_t firstPage = This->numBlocks * This->pagesPerBlock;
+
+    memAllocInfo.allocationSize = This->pageSize * This->pagesPerBlock;
+    memAllocInfo.memoryTypeIndex = This->memoryTypeIndex;
+    if (vdi->vkFuncs.vkAllocateMemory(vdi->device, &memAllocInfo,
+                                      vdi->pAllocator,
+                                      &This->pBlockMemory[This->numBlocks])
+        != VK_SUCCESS)
+        return KTX_OUT_OF_MEMORY;
+    This->numBlocks++;
+    for (uint32_t i = This->pagesPerBlock; i > 0; i--)
+        This->pFreePages[This->numFreePages++] = firstPage + i - 1;
+    return KTX_SUCCESS;
+}
 
-/** @memberof ktxTexture
+/**
+ * @memberof ktxTexture
  * @~English
- * @brief Create a Vulkan image object from a ktxTexture object.
+ * @brief Create a sparse resident Vulkan image object from a ktxTexture
+ *        object.
  *
- * Calls ktxTexture_VkUploadEx() with the most commonly used options:
- * VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT and
- * VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+ * Creates an optimally tiled VkImage with
+ * @c VK_IMAGE_CREATE_SPARSE_BINDING_BIT and
+ * @c VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT matching the KTX data. Only the
+ * mip tail, the levels smaller than a sparse block, is made resident and
+ * uploaded. Tiles of the larger levels are later made resident and
+ * uploaded with ktxVulkanSparseTexture_PageIn and released with
+ * ktxVulkanSparseTexture_PageOut. Until then reads of them return values
+ * as described by the device's @c residencyNonResidentStrict property.
  *
- * @sa ktxTexture_VkUploadEx() for details and use that for complete
- *     control.
+ * Memory is bound on @c vdi->queue which must support sparse binding
+ * operations. The device's @c sparseBinding and the appropriate
+ * @c sparseResidency* features must be enabled.
+ *
+ * The texture's images must be loaded and must not be supercompressed.
+ * Block compressed formats are supported. Mipmap generation is not.
+ *
+ * @param[in] This          pointer to the ktxTexture from which to upload.
+ * @param [in] vdi          pointer to a ktxVulkanDeviceInfo structure
+ *                          providing information about the Vulkan device
+ *                          onto which to load the texture.
+ * @param [in,out] sparseTexture pointer to a ktxVulkanSparseTexture
+ *                               structure into which the function writes
+ *                               information about the created image. Free
+ *                               its resources with
+ *                               ktxVulkanSparseTexture_Destruct.
+ * @param [in] usageFlags   a set of VkImageUsageFlags bits indicating the
+ *                          intended usage of the destination image.
+ * @param [in] finalLayout  a VkImageLayout value indicating the desired
+ *                          final layout of the created image.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE   @p This, @p vdi or @p sparseTexture is
+ *                                @c NULL.
+ * @exception KTX_INVALID_OPERATION The texture's images are not loaded or
+ *                                  are supercompressed, mipmap generation
+ *                                  is requested, the texture is 1D or the
+ *                                  device does not support sparse resident
+ *                                  images of the texture's format and size.
+ * @exception KTX_OUT_OF_MEMORY   Sufficient memory could not be allocated
+ *                                on either the CPU or the Vulkan device.
  */
 KTX_error_code
-ktxTexture_VkUpload(ktxTexture* texture, ktxVulkanDeviceInfo* vdi,
-                    ktxVulkanTexture *vkTexture)
+ktxTexture_VkUploadSparse(ktxTexture* This, ktxVulkanDeviceInfo* vdi,
+                          ktxVulkanSparseTexture* sparseTexture,
+                          VkImageUsageFlags usageFlags,
+                          VkImageLayout finalLayout)
 {
-    return ktxTexture_VkUploadEx(ktxTexture(texture), vdi, vkTexture,
-                                 VK_IMAGE_TILING_OPTIMAL,
-                                 VK_IMAGE_USAGE_SAMPLED_BIT,
-                                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    ktxVulkanTexture* vkTexture;
+    VkImageCreateInfo imageCreateInfo = {
+         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+         .pNext = NULL
+    };
+    VkMemoryAllocateInfo memAllocInfo = {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = NULL
+    };
+    VkSparseImageOpaqueMemoryBindInfo opaqueBindInfo;
+    VkBindSparseInfo bindInfo = {
+        .sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO,
+        .pNext = NULL
+    };
+    VkSparseImageMemoryRequirements* sparseReqs = NULL;
+    VkSparseMemoryBind* tailBinds = NULL;
+    sparse_box* tailBoxes = NULL;
+    ktxVulkanExtensionFunctions ext;
+    VkMemoryRequirements memReqs;
+    VkImageCreateFlags createFlags = VK_IMAGE_CREATE_SPARSE_BINDING_BIT
+                                   | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT;
+    VkImageType imageType;
+    VkImageViewType viewType;
+    VkFormat vkFormat;
+    VkFilter blitFilter;
+    VkDeviceSize tailMemorySize = 0;
+    uint32_t numSparseReqs = 0, numTailBinds = 0, numTailBoxes = 0;
+    uint32_t numImageLevels, numImageLayers;
+    KTX_error_code result;
+
+    if (!This || !vdi || !sparseTexture) {
+        return KTX_INVALID_VALUE;
+    }
+    if (!This->pData || This->generateMipmaps || This->numDimensions == 1) {
+        return KTX_INVALID_OPERATION;
+    }
+    if (This->classId == ktxTexture2_c
+        && ((ktxTexture2*)This)->supercompressionScheme != KTX_SS_NONE) {
+        return KTX_INVALID_OPERATION;
+    }
+    ktxVulkanDeviceInfo_getSparseFunctions(vdi, &ext);
+    if (!ext.vkGetImageSparseMemoryRequirements || !ext.vkQueueBindSparse) {
+        return KTX_INVALID_OPERATION;
+    }
+
+    vkFormat = ktxTexture_GetVkFormat(This);
+    if (vkFormat == VK_FORMAT_UNDEFINED) {
+        return KTX_INVALID_OPERATION;
+    }
+
+    numImageLayers = This->numLayers;
+    if (This->isCubemap) {
+        numImageLayers *= 6;
+        createFlags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+    }
+    if (This->numDimensions == 3) {
+        imageType = VK_IMAGE_TYPE_3D;
+        viewType = VK_IMAGE_VIEW_TYPE_3D;
+    } else {
+        imageType = VK_IMAGE_TYPE_2D;
+        if (This->isCubemap)
+            viewType = This->isArray ?
+                        VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
+        else
+            viewType = This->isArray ?
+                        VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+    }
+
+    usageFlags |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    // Fails if the format can't be sparse resident.
+    result = checkFormatSupport(This, vdi, vkFormat, imageType,
+                                VK_IMAGE_TILING_OPTIMAL, usageFlags,
+                                createFlags, &numImageLevels, &blitFilter,
+                                NULL);
+    if (result != KTX_SUCCESS) {
+        return result;
+    }
+
+    memset(sparseTexture, 0, sizeof(*sparseTexture));
+    vkTexture = &sparseTexture->vkTexture;
+    vkTexture->width = This->baseWidth;
+    vkTexture->height = This->baseHeight;
+    vkTexture->depth = This->baseDepth;
+    vkTexture->imageLayout = finalLayout;
+    vkTexture->imageFormat = vkFormat;
+    vkTexture->levelCount = numImageLevels;
+    vkTexture->layerCount = numImageLayers;
+    vkTexture->viewType = viewType;
+    vkTexture->vkDestroyImage = vdi->vkFuncs.vkDestroyImage;
+    vkTexture->vkFreeMemory = vdi->vkFuncs.vkFreeMemory;
+
+    imageCreateInfo.imageType = imageType;
+    imageCreateInfo.flags = createFlags;
+    imageCreateInfo.format = vkFormat;
+    imageCreateInfo.mipLevels = numImageLevels;
+    imageCreateInfo.arrayLayers = numImageLayers;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageCreateInfo.usage = usageFlags;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageCreateInfo.extent.width = vkTexture->width;
+    imageCreateInfo.extent.height = vkTexture->height;
+    imageCreateInfo.extent.depth = vkTexture->depth;
+    if (vdi->vkFuncs.vkCreateImage(vdi->device, &imageCreateInfo,
+                                   vdi->pAllocator, &vkTexture->image)
+        != VK_SUCCESS) {
+        return KTX_OUT_OF_MEMORY;
+    }
+
+    // The alignment is the size of a sparse block.
+    vdi->vkFuncs.vkGetImageMemoryRequirements(vdi->device, vkTexture->image,
+                                              &memReqs);
+    sparseTexture->pageSize = memReqs.alignment;
+    sparseTexture->memoryTypeIndex = ktxVulkanDeviceInfo_getMemoryType(
+                                          vdi, memReqs.memoryTypeBits,
+                                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    ext.vkGetImageSparseMemoryRequirements(vdi->device, vkTexture->image,
+                                           &numSparseReqs, NULL);
+    sparseReqs = (VkSparseImageMemoryRequirements*)malloc(
+                     sizeof(VkSparseImageMemoryRequirements) * numSparseReqs);
+    // 2 aspects, color and metadata, each with a tail per layer.
+    tailBinds = (VkSparseMemoryBind*)malloc(
+                     sizeof(VkSparseMemoryBind) * 2 * numImageLayers);
+    if (sparseReqs == NULL || tailBinds == NULL) {
+        result = KTX_OUT_OF_MEMORY;
+        goto cleanup;
+    }
+    ext.vkGetImageSparseMemoryRequirements(vdi->device, vkTexture->image,
+                                           &numSparseReqs, sparseReqs);
+
+    result = KTX_INVALID_OPERATION; // Unless there is a color aspect.
+    for (uint32_t i = 0; i < numSparseReqs && numTailBinds < 2 * numImageLayers;
+         i++) {
+        const VkSparseImageMemoryRequirements* req = &sparseReqs[i];
+        VkImageAspectFlags aspectMask = req->formatProperties.aspectMask;
+        uint32_t numTails;
+
+        if (aspectMask & VK_IMAGE_ASPECT_COLOR_BIT) {
+            sparseTexture->tileExtent = req->formatProperties.imageGranularity;
+            sparseTexture->mipTailFirstLod = MIN(req->imageMipTailFirstLod,
+                                                 numImageLevels);
+            result = KTX_SUCCESS;
+            if (sparseTexture->mipTailFirstLod == numImageLevels)
+                continue; // No mip tail.
+        } else if (!(aspectMask & VK_IMAGE_ASPECT_METADATA_BIT)) {
+            continue;
+        }
+        numTails = req->formatProperties.flags
+                   & VK_SPARSE_IMAGE_FORMAT_SINGLE_MIPTAIL_BIT
+                   ? 1 : numImageLayers;
+        for (uint32_t tail = 0; tail < numTails; tail++) {
+            VkSparseMemoryBind* bind = &tailBinds[numTailBinds++];
+            bind->resourceOffset = req->imageMipTailOffset
+                                   + tail * req->imageMipTailStride;
+            bind->size = req->imageMipTailSize;
+            bind->memoryOffset = tailMemorySize;
+            bind->flags = aspectMask & VK_IMAGE_ASPECT_METADATA_BIT
+                          ? VK_SPARSE_MEMORY_BIND_METADATA_BIT : 0;
+            tailMemorySize += (req->imageMipTailSize + memReqs.alignment - 1)
+                              / memReqs.alignment * memReqs.alignment;
+        }
+    }
+    if (result != KTX_SUCCESS)
+        goto cleanup;
+
+    for (uint32_t level = 0; level < sparseTexture->mipTailFirstLod; level++) {
+        VkExtent3D count;
+        ktxVulkanSparseTexture_GetTileCount(sparseTexture, level, &count);
+        sparseTexture->numTiles += count.width * count.height * count.depth
+                                   * numImageLayers;
+    }
+    if (sparseTexture->numTiles > 0) {
+        // Blocks are allocated as tiles are paged in. There are never more
+        // than are needed to make every tile resident.
+        uint32_t maxBlocks;
+
+        sparseTexture->pagesPerBlock = (uint32_t)MIN(sparseTexture->numTiles,
+                                MAX(1, SPARSE_BLOCK_SIZE / memReqs.alignment));
+        maxBlocks = (sparseTexture->numTiles + sparseTexture->pagesPerBlock - 1)
+                    / sparseTexture->pagesPerBlock;
+        sparseTexture->pBlockMemory = (VkDeviceMemory*)calloc(
+                                          maxBlocks, sizeof(VkDeviceMemory));
+        sparseTexture->pTilePage = (uint32_t*)calloc(sparseTexture->numTiles,
+                                                     sizeof(uint32_t));
+        sparseTexture->pFreePages = (uint32_t*)malloc(sizeof(uint32_t)
+                                * maxBlocks * sparseTexture->pagesPerBlock);
+        if (sparseTexture->pBlockMemory == NULL
+            || sparseTexture->pTilePage == NULL
+            || sparseTexture->pFreePages == NULL) {
+            result = KTX_OUT_OF_MEMORY;
+            goto cleanup;
+        }
+    }
+
+    if (numTailBinds > 0) {
+        memAllocInfo.allocationSize = tailMemorySize;
+        memAllocInfo.memoryTypeIndex = sparseTexture->memoryTypeIndex;
+        if (vdi->vkFuncs.vkAllocateMemory(vdi->device, &memAllocInfo,
+                                          vdi->pAllocator,
+                                          &vkTexture->deviceMemory)
+            != VK_SUCCESS) {
+            result = KTX_OUT_OF_MEMORY;
+            goto cleanup;
+        }
+        for (uint32_t i = 0; i < numTailBinds; i++)
+            tailBinds[i].memory = vkTexture->deviceMemory;
+        opaqueBindInfo.image = vkTexture->image;
+        opaqueBindInfo.bindCount = numTailBinds;
+        opaqueBindInfo.pBinds = tailBinds;
+        bindInfo.imageOpaqueBindCount = 1;
+        bindInfo.pImageOpaqueBinds = &opaqueBindInfo;
+        if (ext.vkQueueBindSparse(vdi->queue, 1, &bindInfo,
+                                  VK_NULL_HANDLE) != VK_SUCCESS) {
+            result = KTX_OUT_OF_MEMORY;
+            goto cleanup;
+        }
+        VK_CHECK_RESULT(vdi->vkFuncs.vkQueueWaitIdle(vdi->queue));
+    }
+
+    // Upload the whole of each level in the mip tail.
+    numTailBoxes = (numImageLevels - sparseTexture->mipTailFirstLod)
+                   * numImageLayers;
+    if (numTailBoxes > 0) {
+        tailBoxes = (sparse_box*)malloc(sizeof(sparse_box) * numTailBoxes);
+        if (tailBoxes == NULL) {
+            result = KTX_OUT_OF_MEMORY;
+            goto cleanup;
+        }
+        numTailBoxes = 0;
+        for (uint32_t level = sparseTexture->mipTailFirstLod;
+             level < numImageLevels; level++) {
+            for (uint32_t layer = 0; layer < numImageLayers; layer++) {
+                sparse_box* box = &tailBoxes[numTailBoxes++];
+                box->level = level;
+                box->arrayLayer = layer;
+                box->offset.x = box->offset.y = box->offset.z = 0;
+                box->extent = sparseLevelExtent(vkTexture, level);
+            }
+        }
+    }
+    result = sparseUpload(sparseTexture, This, vdi, numTailBoxes, tailBoxes,
+                          VK_IMAGE_LAYOUT_UNDEFINED);
+
+cleanup:
+    free(sparseReqs);
+    free(tailBinds);
+    free(tailBoxes);
+    if (result != KTX_SUCCESS)
+        ktxVulkanSparseTexture_Destruct(sparseTexture, vdi->device,
+                                        vdi->pAllocator);
+    return result;
 }
 
-/** @memberof ktxTexture1
+/**
+ * @memberof ktxVulkanSparseTexture
  * @~English
- * @brief Create a Vulkan image object from a ktxTexture1 object.
- *
- * This simplly calls ktxTexture_VkUploadEx.
+ * @brief Return the number of tiles in each dimension of a level.
  *
- * @copydetails ktxTexture::ktxTexture_VkUploadEx
+ * @param[in]  This       pointer to the ktxVulkanSparseTexture of interest.
+ * @param[in]  level      the mip level of interest.
+ * @param[out] pTileCount pointer to where to write the counts. They are
+ *                        all 0 for levels in the mip tail.
  */
-KTX_error_code
-ktxTexture1_VkUploadEx(ktxTexture1* This, ktxVulkanDeviceInfo* vdi,
-                       ktxVulkanTexture* vkTexture,
-                       VkImageTiling tiling,
-                       VkImageUsageFlags usageFlags,
-                       VkImageLayout finalLayout)
+void
+ktxVulkanSparseTexture_GetTileCount(const ktxVulkanSparseTexture* This,
+                                    uint32_t level, VkExtent3D* pTileCount)
 {
-    return ktxTexture_VkUploadEx(ktxTexture(This), vdi, vkTexture,
-                                 tiling, usageFlags, finalLayout);
+    if (level >= This->mipTailFirstLod) {
+        pTileCount->width = pTileCount->height = pTileCount->depth = 0;
+    } else {
+        VkExtent3D extent = sparseLevelExtent(&This->vkTexture, level);
+        pTileCount->width = (extent.width + This->tileExtent.width - 1)
+                            / This->tileExtent.width;
+        pTileCount->height = (extent.height + This->tileExtent.height - 1)
+                             / This->tileExtent.height;
+        pTileCount->depth = (extent.depth + This->tileExtent.depth - 1)
+                            / This->tileExtent.depth;
+    }
 }
 
-/** @memberof ktxTexture1
+/**
+ * @memberof ktxVulkanSparseTexture
  * @~English
- * @brief Create a Vulkan image object from a ktxTexture1 object.
+ * @brief Make tiles of a sparse texture resident and upload their texels.
  *
- * Calls ktxTexture_VkUploadEx() with the most commonly used options:
- * VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT and
- * VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+ * A page of @c pageSize bytes is bound to each tile that is not already
+ * resident then the tile's texels are copied from @p texture via a staging
+ * buffer. Pages are taken from blocks of device memory holding
+ * @c pagesPerBlock pages each, reusing pages released by
+ * ktxVulkanSparseTexture_PageOut before allocating a new block. Tiles that
+ * are already resident are skipped. Only the levels and layers containing
+ * the tiles are transitioned for the copies. They are in the image's
+ * @c imageLayout again when the function returns.
  *
- * @sa ktxTexture_VkUploadEx() for details and use that for complete
- *     control.
+ * @param[in] This      pointer to the ktxVulkanSparseTexture to update.
+ * @param[in] texture   pointer to the ktxTexture the image was created
+ *                      from. Its images must still be loaded.
+ * @param[in] vdi       pointer to the ktxVulkanDeviceInfo used to create
+ *                      the image.
+ * @param[in] numTiles  number of tiles in @p pTiles.
+ * @param[in] pTiles    pointer to an array of the tiles to make resident.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE   @p This, @p texture, @p vdi or @p pTiles is
+ *                                @c NULL or a tile is outside the image or
+ *                                in the mip tail.
+ * @exception KTX_INVALID_OPERATION The texture's images are not loaded.
+ * @exception KTX_OUT_OF_MEMORY   Sufficient memory could not be allocated
+ *                                on either the CPU or the Vulkan device.
  */
 KTX_error_code
-ktxTexture1_VkUpload(ktxTexture1* texture, ktxVulkanDeviceInfo* vdi,
-                     ktxVulkanTexture *vkTexture)
+ktxVulkanSparseTexture_PageIn(ktxVulkanSparseTexture* This, ktxTexture* texture,
+                              ktxVulkanDeviceInfo* vdi, uint32_t numTiles,
+                              const ktxVulkanSparseTile* pTiles)
 {
-    return ktxTexture_VkUploadEx(ktxTexture(texture), vdi, vkTexture,
-                                 VK_IMAGE_TILING_OPTIMAL,
-                                 VK_IMAGE_USAGE_SAMPLED_BIT,
-                                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    VkSparseImageMemoryBind* binds;
+    sparse_box* boxes;
+    uint32_t* indices;
+    uint32_t numBinds = 0, index, page;
+    ktx_bool_t bound = KTX_FALSE;
+    KTX_error_code result = KTX_SUCCESS;
+
+    if (!This || !texture || !vdi || (numTiles > 0 && !pTiles))
+        return KTX_INVALID_VALUE;
+    if (!texture->pData)
+        return KTX_INVALID_OPERATION;
+    for (uint32_t i = 0; i < numTiles; i++) {
+        if (!sparseTileIndex(This, &pTiles[i], &index))
+            return KTX_INVALID_VALUE;
+    }
+    if (numTiles == 0)
+        return KTX_SUCCESS;
+
+    binds = (VkSparseImageMemoryBind*)malloc(
+                                   sizeof(VkSparseImageMemoryBind) * numTiles);
+    boxes = (sparse_box*)malloc(sizeof(sparse_box) * numTiles);
+    indices = (uint32_t*)malloc(sizeof(uint32_t) * numTiles);
+    if (binds == NULL || boxes == NULL || indices == NULL) {
+        result = KTX_OUT_OF_MEMORY;
+        goto cleanup;
+    }
+
+    for (uint32_t i = 0; i < numTiles; i++) {
+        sparseTileIndex(This, &pTiles[i], &index);
+        if (This->pTilePage[index] != 0)
+            continue; // Already resident or repeated in pTiles.
+        if (This->numFreePages == 0) {
+            result = sparseAllocBlock(This, vdi);
+            if (result != KTX_SUCCESS)
+                break;
+        }
+        page = This->pFreePages[--This->numFreePages];
+        This->pTilePage[index] = page + 1;
+        indices[numBinds] = index;
+        binds[numBinds] = sparseTileBind(This, &pTiles[i],
+                               This->pBlockMemory[page / This->pagesPerBlock],
+                               (page % This->pagesPerBlock) * This->pageSize);
+        boxes[numBinds++] = sparseTileBox(This, &pTiles[i]);
+    }
+    if (result == KTX_SUCCESS && numBinds > 0) {
+        result = sparseBindTiles(This, vdi, numBinds, binds);
+        bound = result == KTX_SUCCESS;
+    }
+    if (result == KTX_SUCCESS && numBinds > 0)
+        result = sparseUpload(This, texture, vdi, numBinds, boxes,
+                              This->vkTexture.imageLayout);
+    if (result != KTX_SUCCESS) {
+        // Leave the tiles non-resident.
+        if (bound) {
+            for (uint32_t i = 0; i < numBinds; i++)
+                binds[i].memory = VK_NULL_HANDLE;
+            sparseBindTiles(This, vdi, numBinds, binds);
+        }
+        // Return the pages in the reverse order they were taken.
+        for (uint32_t i = numBinds; i > 0; i--) {
+            index = indices[i - 1];
+            This->pFreePages[This->numFreePages++] = This->pTilePage[index] - 1;
+            This->pTilePage[index] = 0;
+        }
+    }
+
+cleanup:
+    free(binds);
+    free(boxes);
+    free(indices);
+    return result;
 }
 
-/** @memberof ktxTexture2
+/**
+ * @memberof ktxVulkanSparseTexture
  * @~English
- * @brief Create a Vulkan image object from a ktxTexture2 object.
+ * @brief Make tiles of a sparse texture non-resident.
  *
- * This simplly calls ktxTexture_VkUploadEx.
+ * Unbinds the memory of each resident tile in @p pTiles and returns its
+ * page to the free list for reuse by ktxVulkanSparseTexture_PageIn. The
+ * blocks of device memory are kept until ktxVulkanSparseTexture_Destruct.
+ * Tiles that are not resident are skipped. The application must ensure
+ * the device has finished using the tiles.
  *
- * @copydetails ktxTexture::ktxTexture_VkUploadEx
+ * @param[in] This      pointer to the ktxVulkanSparseTexture to update.
+ * @param[in] vdi       pointer to the ktxVulkanDeviceInfo used to create
+ *                      the image.
+ * @param[in] numTiles  number of tiles in @p pTiles.
+ * @param[in] pTiles    pointer to an array of the tiles to release.
+ *
+ * @return  KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE   @p This, @p vdi or @p pTiles is @c NULL or
+ *                                a tile is outside the image or in the mip
+ *                                tail.
+ * @exception KTX_OUT_OF_MEMORY   Sufficient memory could not be allocated
+ *                                on the CPU.
  */
 KTX_error_code
-ktxTexture2_VkUploadEx(ktxTexture2* This, ktxVulkanDeviceInfo* vdi,
-                       ktxVulkanTexture* vkTexture,
-                       VkImageTiling tiling,
-                       VkImageUsageFlags usageFlags,
-                       VkImageLayout finalLayout)
+ktxVulkanSparseTexture_PageOut(ktxVulkanSparseTexture* This,
+                               ktxVulkanDeviceInfo* vdi, uint32_t numTiles,
+                               const ktxVulkanSparseTile* pTiles)
 {
-    return ktxTexture_VkUploadEx(ktxTexture(This), vdi, vkTexture,
-                                 tiling, usageFlags, finalLayout);
+    VkSparseImageMemoryBind* binds;
+    uint32_t numBinds = 0, index;
+    KTX_error_code result = KTX_SUCCESS;
+
+    if (!This || !vdi || (numTiles > 0 && !pTiles))
+        return KTX_INVALID_VALUE;
+    for (uint32_t i = 0; i < numTiles; i++) {
+        if (!sparseTileIndex(This, &pTiles[i], &index))
+            return KTX_INVALID_VALUE;
+    }
+    if (numTiles == 0)
+        return KTX_SUCCESS;
+
+    binds = (VkSparseImageMemoryBind*)malloc(
+                                   sizeof(VkSparseImageMemoryBind) * numTiles);
+    if (binds == NULL)
+        return KTX_OUT_OF_MEMORY;
+
+    for (uint32_t i = 0; i < numTiles; i++) {
+        sparseTileIndex(This, &pTiles[i], &index);
+        if (This->pTilePage[index] == 0)
+            continue;
+        binds[numBinds++] = sparseTileBind(This, &pTiles[i], VK_NULL_HANDLE, 0);
+        This->pFreePages[This->numFreePages++] = This->pTilePage[index] - 1;
+        This->pTilePage[index] = 0;
+    }
+    if (numBinds > 0)
+        result = sparseBindTiles(This, vdi, numBinds, binds);
+    free(binds);
+    return result;
 }
 
-/** @memberof ktxTexture2
+/**
+ * @memberof ktxVulkanSparseTexture
  * @~English
- * @brief Create a Vulkan image object from a ktxTexture2 object.
+ * @brief Destructor for the object returned by ktxTexture_VkUploadSparse.
  *
- * Calls ktxTexture_VkUploadEx() with the most commonly used options:
- * VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT and
- * VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+ * Frees the blocks of tile memory and the memory of the mip tail and
+ * destroys the image.
  *
- * @sa ktxTexture2_VkUploadEx() for details and use that for complete
- *     control.
+ * @param This       pointer to the ktxVulkanSparseTexture to be destructed.
+ * @param device     handle to the Vulkan logical device to which the texture
+ *                   was loaded.
+ * @param pAllocator pointer to the allocator used during loading.
  */
-KTX_error_code
-ktxTexture2_VkUpload(ktxTexture2* This, ktxVulkanDeviceInfo* vdi,
-                     ktxVulkanTexture *vkTexture)
+void
+ktxVulkanSparseTexture_Destruct(ktxVulkanSparseTexture* This, VkDevice device,
+                                const VkAllocationCallbacks* pAllocator)
 {
-    return ktxTexture_VkUploadEx(ktxTexture(This), vdi, vkTexture,
-                                 VK_IMAGE_TILING_OPTIMAL,
-                                 VK_IMAGE_USAGE_SAMPLED_BIT,
-                                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    for (uint32_t i = 0; i < This->numBlocks; i++)
+        This->vkTexture.vkFreeMemory(device, This->pBlockMemory[i], pAllocator);
+    free(This->pBlockMemory);
+    free(This->pTilePage);
+    free(This->pFreePages);
+    This->pBlockMemory = NULL;
+    This->pTilePage = NULL;
+    This->pFreePages = NULL;
+    This->numBlocks = This->numFreePages = 0;
+    ktxVulkanTexture_Destruct(&This->vkTexture, device, pAllocator);
 }
 
 /** @memberof ktxTexture1
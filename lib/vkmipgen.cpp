@@ -0,0 +1,531 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2010-2020 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file vkmipgen.cpp
+ * @~English
+ *
+ * @brief Generation of mip levels on the CPU.
+ *
+ * Used by the Vulkan loader to generate mipmaps for formats the device
+ * cannot blit, which includes many integer formats and, on some mobile
+ * devices, 16-bit formats. Images are decoded to float, or double for
+ * 32-bit integers, filtered separably in x, y then z and encoded again.
+ * The 2x2 box filter of 4 component 8-bit unsigned texels, the most common
+ * case, uses SSE2 or NEON when available. Both produce exactly the same
+ * output as the scalar code.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "ktx.h"
+#include "vkformat_convert.h"
+#include "vkmipgen.h"
+
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define KTX_MIPGEN_USE_SSE2 1
+  #include <emmintrin.h>
+#else
+  #define KTX_MIPGEN_USE_SSE2 0
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #define KTX_MIPGEN_USE_NEON 1
+  #include <arm_neon.h>
+#else
+  #define KTX_MIPGEN_USE_NEON 0
+#endif
+
+namespace {
+
+enum class Encoding { Unorm, Snorm, Uint, Sint, Srgb, Sfloat };
+
+struct FormatInfo {
+    ktx_uint32_t numComponents;
+    ktx_uint32_t componentSize;
+    Encoding encoding;
+};
+
+bool
+getFormatInfo(VkFormat format, FormatInfo& info)
+{
+    switch (format) {
+#define FORMAT(f, n, s, e) \
+      case f: info = { n, s, Encoding::e }; return true
+#define FORMATS8(f, n) \
+      FORMAT(f##_UNORM, n, 1, Unorm); \
+      FORMAT(f##_SNORM, n, 1, Snorm); \
+      FORMAT(f##_UINT, n, 1, Uint); \
+      FORMAT(f##_SINT, n, 1, Sint); \
+      FORMAT(f##_SRGB, n, 1, Srgb)
+#define FORMATS16(f, n) \
+      FORMAT(f##_UNORM, n, 2, Unorm); \
+      FORMAT(f##_SNORM, n, 2, Snorm); \
+      FORMAT(f##_UINT, n, 2, Uint); \
+      FORMAT(f##_SINT, n, 2, Sint); \
+      FORMAT(f##_SFLOAT, n, 2, Sfloat)
+#define FORMATS32(f, n) \
+      FORMAT(f##_UINT, n, 4, Uint); \
+      FORMAT(f##_SINT, n, 4, Sint); \
+      FORMAT(f##_SFLOAT, n, 4, Sfloat)
+      FORMATS8(VK_FORMAT_R8, 1);
+      FORMATS8(VK_FORMAT_R8G8, 2);
+      FORMATS8(VK_FORMAT_R8G8B8, 3);
+      FORMATS8(VK_FORMAT_B8G8R8, 3);
+      FORMATS8(VK_FORMAT_R8G8B8A8, 4);
+      FORMATS8(VK_FORMAT_B8G8R8A8, 4);
+      FORMAT(VK_FORMAT_A8B8G8R8_UNORM_PACK32, 4, 1, Unorm);
+      FORMAT(VK_FORMAT_A8B8G8R8_SNORM_PACK32, 4, 1, Snorm);
+      FORMAT(VK_FORMAT_A8B8G8R8_UINT_PACK32, 4, 1, Uint);
+      FORMAT(VK_FORMAT_A8B8G8R8_SINT_PACK32, 4, 1, Sint);
+      FORMAT(VK_FORMAT_A8B8G8R8_SRGB_PACK32, 4, 1, Srgb);
+      FORMATS16(VK_FORMAT_R16, 1);
+      FORMATS16(VK_FORMAT_R16G16, 2);
+      FORMATS16(VK_FORMAT_R16G16B16, 3);
+      FORMATS16(VK_FORMAT_R16G16B16A16, 4);
+      FORMATS32(VK_FORMAT_R32, 1);
+      FORMATS32(VK_FORMAT_R32G32, 2);
+      FORMATS32(VK_FORMAT_R32G32B32, 3);
+      FORMATS32(VK_FORMAT_R32G32B32A32, 4);
+#undef FORMATS32
+#undef FORMATS16
+#undef FORMATS8
+#undef FORMAT
+      default:
+        return false;
+    }
+}
+
+float
+srgbToLinear(ktx_uint8_t v)
+{
+    static const std::vector<float> table = [] {
+        std::vector<float> t(256);
+        for (int i = 0; i < 256; i++) {
+            float c = i / 255.0f;
+            t[i] = c <= 0.04045f ? c / 12.92f
+                                 : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return t;
+    }();
+    return table[v];
+}
+
+float
+linearToSrgb(float l)
+{
+    if (!(l > 0.0f))
+        return 0.0f;
+    if (l >= 1.0f)
+        return 1.0f;
+    return l <= 0.0031308f ? l * 12.92f
+                           : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+}
+
+// Round to nearest, ties up, and clamp to [lo, hi].
+template<typename Acc>
+double
+roundClamp(Acc v, double lo, double hi)
+{
+    double r = std::floor((double)v + 0.5);
+    return r < lo ? lo : (r > hi ? hi : r);
+}
+
+template<typename Acc>
+void
+decode(const FormatInfo& fi, const ktx_uint8_t* src, size_t count, Acc* dst)
+{
+    for (size_t i = 0; i < count; i++) {
+        const ktx_uint8_t* s = src + i * fi.componentSize;
+        switch (fi.componentSize) {
+          case 1:
+            if (fi.encoding == Encoding::Srgb && i % fi.numComponents < 3)
+                dst[i] = (Acc)srgbToLinear(*s);
+            else if (fi.encoding == Encoding::Snorm
+                     || fi.encoding == Encoding::Sint)
+                dst[i] = (Acc)(int8_t)*s;
+            else
+                dst[i] = (Acc)*s;
+            break;
+          case 2: {
+            ktx_uint16_t v;
+            memcpy(&v, s, sizeof(v));
+            if (fi.encoding == Encoding::Sfloat)
+                dst[i] = (Acc)ktxHalfToFloat(v);
+            else if (fi.encoding == Encoding::Snorm
+                     || fi.encoding == Encoding::Sint)
+                dst[i] = (Acc)(ktx_int16_t)v;
+            else
+                dst[i] = (Acc)v;
+            break;
+          }
+          default: {
+            ktx_uint32_t v;
+            memcpy(&v, s, sizeof(v));
+            if (fi.encoding == Encoding::Sfloat) {
+                float f;
+                memcpy(&f, &v, sizeof(f));
+                dst[i] = (Acc)f;
+            } else if (fi.encoding == Encoding::Sint) {
+                dst[i] = (Acc)(ktx_int32_t)v;
+            } else {
+                dst[i] = (Acc)v;
+            }
+            break;
+          }
+        }
+    }
+}
+
+template<typename Acc>
+void
+encode(const FormatInfo& fi, const Acc* src, size_t count, ktx_uint8_t* dst)
+{
+    for (size_t i = 0; i < count; i++) {
+        ktx_uint8_t* d = dst + i * fi.componentSize;
+        bool isSigned = fi.encoding == Encoding::Snorm
+                        || fi.encoding == Encoding::Sint;
+        switch (fi.componentSize) {
+          case 1:
+            if (fi.encoding == Encoding::Srgb && i % fi.numComponents < 3)
+                *d = (ktx_uint8_t)roundClamp(linearToSrgb((float)src[i])
+                                             * 255.0f, 0, 255);
+            else if (isSigned)
+                *d = (ktx_uint8_t)(int8_t)roundClamp(src[i], -128, 127);
+            else
+                *d = (ktx_uint8_t)roundClamp(src[i], 0, 255);
+            break;
+          case 2: {
+            ktx_uint16_t v;
+            if (fi.encoding == Encoding::Sfloat)
+                v = ktxFloatToHalf((float)src[i]);
+            else if (isSigned)
+                v = (ktx_uint16_t)(ktx_int16_t)roundClamp(src[i], -32768,
+                                                          32767);
+            else
+                v = (ktx_uint16_t)roundClamp(src[i], 0, 65535);
+            memcpy(d, &v, sizeof(v));
+            break;
+          }
+          default: {
+            ktx_uint32_t v;
+            if (fi.encoding == Encoding::Sfloat) {
+                float f = (float)src[i];
+                memcpy(&v, &f, sizeof(v));
+            } else if (isSigned) {
+                v = (ktx_uint32_t)(ktx_int32_t)roundClamp(src[i],
+                                                          -2147483648.0,
+                                                          2147483647.0);
+            } else {
+                v = (ktx_uint32_t)roundClamp(src[i], 0, 4294967295.0);
+            }
+            memcpy(d, &v, sizeof(v));
+            break;
+          }
+        }
+    }
+}
+
+// The source texels, and their weights, contributing to one destination
+// texel. Indices outside the image are clamped to the edge.
+struct Contributor {
+    ktx_uint32_t first;
+    std::vector<double> weights;
+};
+
+double
+besselI0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+        if (term < sum * 1e-12)
+            break;
+    }
+    return sum;
+}
+
+double
+kaiser(double t)
+{
+    const double radius = 3.0, alpha = 4.0;
+    const double pi = 3.14159265358979323846;
+    double x = t / radius;
+    double window, sinc;
+
+    if (std::fabs(x) >= 1.0)
+        return 0.0;
+    window = besselI0(alpha * std::sqrt(1.0 - x * x)) / besselI0(alpha);
+    sinc = t == 0.0 ? 1.0 : std::sin(pi * t) / (pi * t);
+    return sinc * window;
+}
+
+std::vector<Contributor>
+makeContributors(ktx_uint32_t srcSize, ktx_uint32_t dstSize,
+                 ktxMipmapFilter filter)
+{
+    std::vector<Contributor> contributors(dstSize);
+    double scale = (double)srcSize / dstSize;
+    double radius = filter == KTX_MIPMAP_FILTER_BOX ? scale / 2 : 3.0 * scale;
+
+    for (ktx_uint32_t i = 0; i < dstSize; i++) {
+        Contributor& c = contributors[i];
+        double center = (i + 0.5) * scale;
+        ktx_int64_t lo = (ktx_int64_t)std::floor(center - radius);
+        ktx_int64_t hi = (ktx_int64_t)std::ceil(center + radius);
+        double sum = 0.0;
+
+        c.first = (ktx_uint32_t)std::max<ktx_int64_t>(0, lo);
+        c.weights.assign((size_t)(std::min<ktx_int64_t>(srcSize - 1, hi)
+                                  - c.first + 1), 0.0);
+        for (ktx_int64_t j = lo; j <= hi; j++) {
+            double w;
+            if (filter == KTX_MIPMAP_FILTER_BOX) {
+                // Overlap of texel j with the destination texel's area.
+                w = std::min(j + 1.0, center + radius)
+                    - std::max((double)j, center - radius);
+                w = std::max(0.0, w);
+            } else {
+                w = kaiser((j + 0.5 - center) / scale);
+            }
+            ktx_int64_t clamped = std::min<ktx_int64_t>(
+                                     srcSize - 1, std::max<ktx_int64_t>(0, j));
+            c.weights[(size_t)(clamped - c.first)] += w;
+            sum += w;
+        }
+        for (auto& w : c.weights)
+            w /= sum;
+    }
+    return contributors;
+}
+
+// Filter data laid out as [numOuter][srcSize][innerLength] along its
+// middle dimension.
+template<typename Acc>
+void
+filterDimension(const std::vector<Contributor>& contributors,
+                const Acc* src, Acc* dst, size_t numOuter, size_t srcSize,
+                size_t innerLength)
+{
+    size_t dstSize = contributors.size();
+    for (size_t o = 0; o < numOuter; o++) {
+        const Acc* s = src + o * srcSize * innerLength;
+        Acc* d = dst + o * dstSize * innerLength;
+        for (size_t i = 0; i < dstSize; i++) {
+            const Contributor& c = contributors[i];
+            Acc* out = d + i * innerLength;
+            std::fill(out, out + innerLength, (Acc)0);
+            for (size_t k = 0; k < c.weights.size(); k++) {
+                const Acc* in = s + (c.first + k) * innerLength;
+                Acc w = (Acc)c.weights[k];
+                for (size_t e = 0; e < innerLength; e++)
+                    out[e] += w * in[e];
+            }
+        }
+    }
+}
+
+template<typename Acc>
+void
+filterImage(const FormatInfo& fi, ktxMipmapFilter filter,
+            const ktx_uint8_t* src, ktx_uint32_t width, ktx_uint32_t height,
+            ktx_uint32_t depth, ktx_uint8_t* dst)
+{
+    ktx_uint32_t n = fi.numComponents;
+    ktx_uint32_t dstWidth = std::max(1U, width / 2);
+    ktx_uint32_t dstHeight = std::max(1U, height / 2);
+    ktx_uint32_t dstDepth = std::max(1U, depth / 2);
+    std::vector<Acc> a((size_t)width * height * depth * n);
+    std::vector<Acc> b;
+
+    decode(fi, src, a.size(), a.data());
+    // x, then y, then z. Each pass shrinks the data.
+    if (dstWidth != width) {
+        b.resize((size_t)dstWidth * height * depth * n);
+        filterDimension(makeContributors(width, dstWidth, filter),
+                        a.data(), b.data(), (size_t)height * depth, width, n);
+        a.swap(b);
+    }
+    if (dstHeight != height) {
+        b.resize((size_t)dstWidth * dstHeight * depth * n);
+        filterDimension(makeContributors(height, dstHeight, filter),
+                        a.data(), b.data(), depth, height,
+                        (size_t)dstWidth * n);
+        a.swap(b);
+    }
+    if (dstDepth != depth) {
+        b.resize((size_t)dstWidth * dstHeight * dstDepth * n);
+        filterDimension(makeContributors(depth, dstDepth, filter),
+                        a.data(), b.data(), 1, depth,
+                        (size_t)dstWidth * dstHeight * n);
+        a.swap(b);
+    }
+    encode(fi, a.data(), (size_t)dstWidth * dstHeight * dstDepth * n, dst);
+}
+
+// 2x2 box filter of 4 component 8-bit unsigned texels. Width and height
+// must be even.
+void
+box2x2Rgba8(const ktx_uint8_t* src, ktx_uint32_t width, ktx_uint32_t height,
+            ktx_uint8_t* dst)
+{
+    ktx_uint32_t dstWidth = width / 2;
+    for (ktx_uint32_t y = 0; y < height / 2; y++) {
+        const ktx_uint8_t* row0 = src + (size_t)(2 * y) * width * 4;
+        const ktx_uint8_t* row1 = row0 + (size_t)width * 4;
+        ktx_uint8_t* out = dst + (size_t)y * dstWidth * 4;
+        ktx_uint32_t x = 0;
+#if KTX_MIPGEN_USE_SSE2
+        // 4 source texels from each row make 2 destination texels.
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i two = _mm_set1_epi16(2);
+        for (; x + 2 <= dstWidth; x += 2) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+            __m128i b = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                                       _mm_unpacklo_epi8(b, zero));
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                                       _mm_unpackhi_epi8(b, zero));
+            // Add each even texel to the odd one following it.
+            lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+            hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+            __m128i sum = _mm_unpacklo_epi64(lo, hi);
+            sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+            _mm_storel_epi64((__m128i*)(out + x * 4),
+                             _mm_packus_epi16(sum, sum));
+        }
+#elif KTX_MIPGEN_USE_NEON
+        // 16 source texels from each row make 8 destination texels.
+        for (; x + 8 <= dstWidth; x += 8) {
+            uint8x16x4_t a = vld4q_u8(row0 + x * 8);
+            uint8x16x4_t b = vld4q_u8(row1 + x * 8);
+            uint8x8x4_t r;
+            for (int c = 0; c < 4; c++) {
+                uint16x8_t sum = vaddq_u16(vpaddlq_u8(a.val[c]),
+                                           vpaddlq_u8(b.val[c]));
+                r.val[c] = vrshrn_n_u16(sum, 2);
+            }
+            vst4_u8(out + x * 4, r);
+        }
+#endif
+        for (; x < dstWidth; x++) {
+            for (ktx_uint32_t c = 0; c < 4; c++) {
+                ktx_uint32_t sum = row0[x * 8 + c] + row0[x * 8 + 4 + c]
+                                 + row1[x * 8 + c] + row1[x * 8 + 4 + c];
+                out[x * 4 + c] = (ktx_uint8_t)((sum + 2) >> 2);
+            }
+        }
+    }
+}
+
+struct mipJob {
+    FormatInfo fi;
+    ktxMipmapFilter filter;
+    const ktx_uint8_t* src;
+    ktx_uint32_t width, height, depth;
+    ktx_uint32_t numImages;
+    ktx_uint8_t* dst;
+    std::atomic<ktx_uint32_t> nextImage;
+    std::atomic<bool> outOfMemory;
+};
+
+void
+mipWorker(mipJob* job)
+{
+    const FormatInfo& fi = job->fi;
+    size_t elementSize = (size_t)fi.numComponents * fi.componentSize;
+    size_t srcImageSize = (size_t)job->width * job->height * job->depth
+                          * elementSize;
+    size_t dstImageSize = (size_t)std::max(1U, job->width / 2)
+                          * std::max(1U, job->height / 2)
+                          * std::max(1U, job->depth / 2) * elementSize;
+    bool fastBox = job->filter == KTX_MIPMAP_FILTER_BOX
+                   && fi.numComponents == 4 && fi.componentSize == 1
+                   && (fi.encoding == Encoding::Unorm
+                       || fi.encoding == Encoding::Uint)
+                   && job->depth == 1 && job->width % 2 == 0
+                   && job->height % 2 == 0;
+
+    for (;;) {
+        ktx_uint32_t image = job->nextImage++;
+        if (image >= job->numImages)
+            break;
+        const ktx_uint8_t* src = job->src + image * srcImageSize;
+        ktx_uint8_t* dst = job->dst + image * dstImageSize;
+        try {
+            if (fastBox)
+                box2x2Rgba8(src, job->width, job->height, dst);
+            else if (fi.componentSize == 4 && fi.encoding != Encoding::Sfloat)
+                filterImage<double>(fi, job->filter, src, job->width,
+                                    job->height, job->depth, dst);
+            else
+                filterImage<float>(fi, job->filter, src, job->width,
+                                   job->height, job->depth, dst);
+        } catch (std::bad_alloc&) {
+            job->outOfMemory = true;
+        }
+    }
+}
+
+} // namespace
+
+extern "C" ktx_bool_t
+ktxMipmapGen_isSupported(VkFormat format)
+{
+    FormatInfo fi;
+    return getFormatInfo(format, fi);
+}
+
+extern "C" KTX_error_code
+ktxMipmapGen_generateLevel(VkFormat format, ktxMipmapFilter filter,
+                           const ktx_uint8_t* src, ktx_uint32_t width,
+                           ktx_uint32_t height, ktx_uint32_t depth,
+                           ktx_uint32_t numImages, ktx_uint8_t* dst)
+{
+    mipJob job;
+    ktx_uint32_t threadCount = 1;
+
+    if (!getFormatInfo(format, job.fi))
+        return KTX_INVALID_OPERATION;
+    job.filter = filter;
+    job.src = src;
+    job.width = width;
+    job.height = height;
+    job.depth = depth;
+    job.numImages = numImages;
+    job.dst = dst;
+    job.nextImage = 0;
+    job.outOfMemory = false;
+
+    // Threads only pay off when there is enough work to share.
+    if ((ktx_uint64_t)width * height * depth * numImages >= 64 * 1024)
+        threadCount = std::thread::hardware_concurrency();
+    threadCount = std::max(1U, std::min(threadCount, numImages));
+    std::vector<std::thread> threads;
+    try {
+        for (ktx_uint32_t i = 1; i < threadCount; i++)
+            threads.emplace_back(mipWorker, &job);
+    } catch (std::system_error&) {
+        // Continue with the threads that were started.
+    } catch (std::bad_alloc&) {
+        // Likewise.
+    }
+    mipWorker(&job);
+    for (auto& thread : threads)
+        thread.join();
+    return job.outOfMemory ? KTX_OUT_OF_MEMORY : KTX_SUCCESS;
+}
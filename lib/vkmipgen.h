@@ -0,0 +1,56 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2010-2020 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Generation of mip levels on the CPU, used by the Vulkan loader when the
+ * device cannot blit images of a texture's format.
+ */
+
+#ifndef VKMIPGEN_H
+#define VKMIPGEN_H
+
+#include "ktx.h"
+#include "vkformat_enum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum ktxMipmapFilter {
+    KTX_MIPMAP_FILTER_BOX,    /* Area weighted average. */
+    KTX_MIPMAP_FILTER_KAISER  /* Kaiser windowed sinc, radius 3 texels of
+                                 the smaller level. */
+} ktxMipmapFilter;
+
+/*
+ * ktxMipmapGen_isSupported: True if levels of @p format can be generated.
+ * These are the uncompressed, unpacked 8-, 16- and 32-bit formats.
+ */
+ktx_bool_t ktxMipmapGen_isSupported(VkFormat format);
+
+/*
+ * ktxMipmapGen_generateLevel: Filter @p numImages tightly packed images of
+ * @p width x @p height x @p depth texels from @p src to the next smaller
+ * level, each dimension halved and rounded down to at least 1, at @p dst.
+ * The images, i.e. array layers and faces, are filtered in parallel.
+ * sRGB components are filtered in linear space.
+ */
+KTX_error_code ktxMipmapGen_generateLevel(VkFormat format,
+                                          ktxMipmapFilter filter,
+                                          const ktx_uint8_t* src,
+                                          ktx_uint32_t width,
+                                          ktx_uint32_t height,
+                                          ktx_uint32_t depth,
+                                          ktx_uint32_t numImages,
+                                          ktx_uint8_t* dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VKMIPGEN_H */
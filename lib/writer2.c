@@ -36,7 +36,9 @@
 #include "ktxint.h"
 #include "filestream.h"
 #include "memstream.h"
+#include "sharedstore.h"
 #include "texture2.h"
+#include "zstdfilter.h"
 
 #include "dfdutils/dfd.h"
 #include "vkformat_enum.h"
@@ -191,7 +193,8 @@ appendLibId(ktxHashList* head, ktxHashListEntry* writerEntry)
  *                              specified level, layer & faceSlice.
  * @exception KTX_INVALID_OPERATION
  *                              No storage was allocated when the texture was
- *                              created.
+ *                              created or the texture is a read-only view of
+ *                              a shared texture.
  */
 KTX_error_code
 ktxTexture2_setImageFromStream(ktxTexture2* This, ktx_uint32_t level,
@@ -208,6 +211,10 @@ ktxTexture2_setImageFromStream(ktxTexture2* This, ktx_uint32_t level,
     if (!This->pData)
         return KTX_INVALID_OPERATION;
 
+    // A view's data is a read-only mapping of the shared pages.
+    if (This->_private->_sharedRegion)
+        return KTX_INVALID_OPERATION;
+
     result = ktxTexture_GetImageOffset(ktxTexture(This),
                                        level, layer, faceSlice,
                                        &imageByteOffset);
@@ -253,7 +260,8 @@ ktxTexture2_setImageFromStream(ktxTexture2* This, ktx_uint32_t level,
  *                              specified level, layer & faceSlice.
  * @exception KTX_INVALID_OPERATION
  *                              No storage was allocated when the texture was
- *                              created.
+ *                              created or the texture is a read-only view of
+ *                              a shared texture.
  */
 KTX_error_code
 ktxTexture2_SetImageFromStdioStream(ktxTexture2* This, ktx_uint32_t level,
@@ -298,7 +306,8 @@ ktxTexture2_SetImageFromStdioStream(ktxTexture2* This, ktx_uint32_t level,
  *                              specified level, layer & faceSlice.
  * @exception KTX_INVALID_OPERATION
  *                              No storage was allocated when the texture was
- *                              created.
+ *                              created or the texture is a read-only view of
+ *                              a shared texture.
  */
 KTX_error_code
 ktxTexture2_SetImageFromMemory(ktxTexture2* This, ktx_uint32_t level,
@@ -322,33 +331,76 @@ ktxTexture2_SetImageFromMemory(ktxTexture2* This, ktx_uint32_t level,
 ktx_bool_t __disableWriterMetadata__ = KTX_FALSE;
 #endif
 
+/** @internal
+ * @~English
+ * @brief Round @p nbytes up to a multiple of @p n.
+ *
+ * Unlike _KTX_PADN this is exact for sizes beyond the precision of a float.
+ */
+static ktx_uint64_t
+padn64(ktx_uint64_t n, ktx_uint64_t nbytes)
+{
+    return (nbytes + n - 1) / n * n;
+}
+
+/** @internal
+ * @~English
+ * @brief Write @p len zero bytes of padding to a ktxStream.
+ *
+ * @param[in] dststr    destination ktxStream.
+ * @param[in] len       number of bytes of padding to write.
+ */
+static KTX_error_code
+writePadding(ktxStream* dststr, ktx_uint64_t len)
+{
+    static const char padding[4096] = { 0 };
+    KTX_error_code result = KTX_SUCCESS;
+
+    while (len != 0 && result == KTX_SUCCESS) {
+        ktx_size_t count = (ktx_size_t)MIN(len, sizeof(padding));
+        result = dststr->write(dststr, padding, 1, count);
+        len -= count;
+    }
+    return result;
+}
+
 /**
- * @memberof ktxTexture2
+ * @memberof ktxTexture2 @private
  * @~English
- * @brief Write a ktxTexture object to a ktxStream in KTX format.
+ * @brief Write the header, level index, DFD, metadata and supercompression
+ *        global data of a ktxTexture2 to a ktxStream.
+ *
+ * On return the stream is positioned at the start of the first level's data.
  *
  * @param[in] This      pointer to the target ktxTexture object.
  * @param[in] dststr    destination ktxStream.
+ * @param[in] supercompressionScheme
+ *                      the scheme to record in the header.
+ * @param[in] pDfd      pointer to the DFD to write.
+ * @param[in] levelIndex pointer to the level index to write. Its offsets are
+ *                      relative to the start of the image data and are
+ *                      adjusted to file offsets as they are written.
+ * @param[in] requiredLevelAlignment
+ *                      alignment required for the start of the first level.
+ * @param[out] pDataOffset pointer to location to write the file offset of the
+ *                      first level's data.
  *
  * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
  *
- * @exception KTX_INVALID_VALUE @p This or @p dststr is NULL.
- * @exception KTX_INVALID_OPERATION
- *                              The ktxTexture does not contain any image data.
  * @exception KTX_INVALID_OPERATION
- *                              Both kvDataHead and kvData are set in the
- *                              ktxTexture
- * @exception KTX_INVALID_OPERATION
- *                              The length of the already set writerId metadata
- *                              plus the library's version id exceeds the
- *                              maximum allowed.
- * @exception KTX_FILE_OVERFLOW The file exceeded the maximum size supported by
- *                              the system.
+ *                              The metadata contains invalid or unrecognized
+ *                              KTX keys.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory for the adjusted level index.
  * @exception KTX_FILE_WRITE_ERROR
  *                              An error occurred while writing the file.
  */
-KTX_error_code
-ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
+static KTX_error_code
+ktxTexture2_writeFileHeaders(ktxTexture2* This, ktxStream* dststr,
+                             ktxSupercmpScheme supercompressionScheme,
+                             ktx_uint32_t* pDfd,
+                             const ktxLevelIndexEntry* levelIndex,
+                             ktx_uint32_t requiredLevelAlignment,
+                             ktx_uint64_t* pDataOffset)
 {
     DECLARE_PRIVATE(ktxTexture2);
     KTX_header2 header = { .identifier = KTX2_IDENTIFIER_REF };
@@ -357,17 +409,10 @@ ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
     ktx_uint8_t* pKvd;
     ktx_uint32_t align8PadLen = 0;
     ktx_uint64_t sgdLen;
-    ktx_uint32_t initialLevelPadLen;
+    ktx_uint64_t initialLevelPadLen;
     ktx_uint32_t levelIndexSize;
     ktx_uint64_t baseOffset;
 
-    if (!dststr) {
-        return KTX_INVALID_VALUE;
-    }
-
-    if (This->pData == NULL)
-        return KTX_INVALID_OPERATION;
-
     header.vkFormat = This->vkFormat;
     header.typeSize = This->_protected->_typeSize;
     header.pixelWidth = This->baseWidth;
@@ -378,14 +423,14 @@ ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
     header.faceCount = This->numFaces;
     assert (This->generateMipmaps? This->numLevels == 1 : This->numLevels >= 1);
     header.levelCount = This->generateMipmaps ? 0 : This->numLevels;
-    header.supercompressionScheme = This->supercompressionScheme;
+    header.supercompressionScheme = supercompressionScheme;
 
     levelIndexSize = sizeof(ktxLevelIndexEntry) * This->numLevels;
 
     baseOffset = sizeof(header) + levelIndexSize;
 
     header.dataFormatDescriptor.byteOffset = (uint32_t)baseOffset;
-    header.dataFormatDescriptor.byteLength = *This->pDfd;
+    header.dataFormatDescriptor.byteLength = *pDfd;
     baseOffset += header.dataFormatDescriptor.byteLength;
 
     ktxHashListEntry* pEntry;
@@ -450,34 +495,40 @@ ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
     header.supercompressionGlobalData.byteLength = sgdLen;
     baseOffset += sgdLen;
 
-    initialLevelPadLen = _KTX_PADN_LEN(This->_private->_requiredLevelAlignment,
-                                       baseOffset);
+    initialLevelPadLen = padn64(requiredLevelAlignment, baseOffset)
+                         - baseOffset;
     baseOffset += initialLevelPadLen;
 
     // write header and indices
     result = dststr->write(dststr, &header, sizeof(header), 1);
-    if (result != KTX_SUCCESS)
+    if (result != KTX_SUCCESS) {
+        free(pKvd);
         return result;
+    }
 
     // Create a copy of the level index with file-adjusted offsets and write it.
-    ktxLevelIndexEntry* levelIndex
+    ktxLevelIndexEntry* fileLevelIndex
                             = (ktxLevelIndexEntry*)malloc(levelIndexSize);
-    if (!levelIndex)
+    if (!fileLevelIndex) {
+        free(pKvd);
         return KTX_OUT_OF_MEMORY;
+    }
     for (ktx_uint32_t level = 0; level < This->numLevels; level++) {
-        levelIndex[level].byteLength = private->_levelIndex[level].byteLength;
-        levelIndex[level].uncompressedByteLength
-                         = private->_levelIndex[level].uncompressedByteLength;
-        levelIndex[level].byteOffset = private->_levelIndex[level].byteOffset;
-        levelIndex[level].byteOffset += baseOffset;
+        fileLevelIndex[level].byteLength = levelIndex[level].byteLength;
+        fileLevelIndex[level].uncompressedByteLength
+                         = levelIndex[level].uncompressedByteLength;
+        fileLevelIndex[level].byteOffset = levelIndex[level].byteOffset;
+        fileLevelIndex[level].byteOffset += baseOffset;
     }
-    result = dststr->write(dststr, levelIndex, levelIndexSize, 1);
-    free(levelIndex);
-    if (result != KTX_SUCCESS)
+    result = dststr->write(dststr, fileLevelIndex, levelIndexSize, 1);
+    free(fileLevelIndex);
+    if (result != KTX_SUCCESS) {
+        free(pKvd);
         return result;
+    }
 
    // write data format descriptor
-   result = dststr->write(dststr, This->pDfd, 1, *This->pDfd);
+   result = dststr->write(dststr, pDfd, 1, *pDfd);
 
    // write keyValueData
     if (kvdLen != 0) {
@@ -490,11 +541,10 @@ ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
         }
     }
 
-    char padding[32] = { 0 };
     // write supercompressionGlobalData & sgdPadding
     if (private->_sgdByteLength != 0) {
         if (align8PadLen) {
-            result = dststr->write(dststr, padding, 1, align8PadLen);
+            result = writePadding(dststr, align8PadLen);
             if (result != KTX_SUCCESS) {
                  return result;
             }
@@ -508,12 +558,160 @@ ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
     }
 
     if (initialLevelPadLen) {
-        result = dststr->write(dststr, padding, 1, initialLevelPadLen);
+        result = writePadding(dststr, initialLevelPadLen);
         if (result != KTX_SUCCESS) {
              return result;
         }
     }
 
+    *pDataOffset = baseOffset;
+    return KTX_SUCCESS;
+}
+
+/**
+ * @internal
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Set the level hash metadata from the texture's current data.
+ *
+ * @param[in] This      pointer to the target ktxTexture object.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ */
+static KTX_error_code
+ktxTexture2_setLevelHashes(ktxTexture2* This)
+{
+    ktx_uint32_t valueLen = This->numLevels * sizeof(ktx_uint64_t);
+    ktx_uint64_t* hashes;
+    ktx_uint8_t* value;
+    ktxHashListEntry* pEntry;
+    KTX_error_code result;
+
+    hashes = malloc(valueLen);
+    value = malloc(valueLen);
+    if (!hashes || !value) {
+        free(hashes);
+        free(value);
+        return KTX_OUT_OF_MEMORY;
+    }
+    ktxTexture2_calcLevelHashes(This, This->pData, 0, hashes);
+    // Store little-endian regardless of the host.
+    for (ktx_uint32_t level = 0; level < This->numLevels; level++) {
+        for (ktx_uint32_t i = 0; i < sizeof(ktx_uint64_t); i++) {
+            value[level * sizeof(ktx_uint64_t) + i]
+                                    = (ktx_uint8_t)(hashes[level] >> (i * 8));
+        }
+    }
+
+    pEntry = NULL;
+    if (ktxHashList_FindEntry(&This->kvDataHead, KTX_LEVEL_HASHES_KEY,
+                              &pEntry) == KTX_SUCCESS) {
+        ktxHashList_DeleteEntry(&This->kvDataHead, pEntry);
+        free(pEntry);
+    }
+    result = ktxHashList_AddKVPair(&This->kvDataHead, KTX_LEVEL_HASHES_KEY,
+                                   valueLen, value);
+    free(hashes);
+    free(value);
+    return result;
+}
+
+/**
+ * @memberof ktxTexture2
+ * @ingroup writer
+ * @~English
+ * @brief Record a content hash of each level in the texture's metadata.
+ *
+ * The hash of a level is the XXH64, with seed 0, of its data as stored in
+ * the file so files can be checked with ktxTexture2_VerifyLevelHashes()
+ * without parsing or transcoding the data, and identical levels in
+ * different files can be found by comparing hashes. The hashes are stored
+ * under ::KTX_LEVEL_HASHES_KEY. Levels are hashed in parallel.
+ *
+ * Once added, the hashes are recomputed each time the texture is written
+ * so they always match the written data, including after
+ * ktxTexture2_DeflateZstd() or ktxTexture2_CompressBasis(). They are not
+ * written by ktxTexture2_DeflateZstdToStream() because the deflated data
+ * is not known until after the metadata has been written.
+ *
+ * @param[in] This      pointer to the target ktxTexture object.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This is NULL.
+ * @exception KTX_INVALID_OPERATION
+ *                              The ktxTexture does not contain any image data.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory for the hashes.
+ */
+KTX_error_code
+ktxTexture2_AddLevelHashes(ktxTexture2* This)
+{
+    if (!This)
+        return KTX_INVALID_VALUE;
+
+    if (This->pData == NULL)
+        return KTX_INVALID_OPERATION;
+
+    return ktxTexture2_setLevelHashes(This);
+}
+
+/**
+ * @internal
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Write a ktxTexture2 object to a ktxStream in KTX format with the
+ *        start of each level aligned to @p levelAlignment.
+ *
+ * The levels are laid out afresh so any padding in the data of a texture
+ * loaded from a file is not carried into the output.
+ *
+ * @param[in] This      pointer to the target ktxTexture object.
+ * @param[in] dststr    destination ktxStream.
+ * @param[in] levelAlignment
+ *                      alignment of the file offset of each level. Must be
+ *                      a multiple of the texture's required alignment.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ */
+static KTX_error_code
+ktxTexture2_writeToStreamAligned(ktxTexture2* This, ktxStream* dststr,
+                                 ktx_uint32_t levelAlignment)
+{
+    DECLARE_PRIVATE(ktxTexture2);
+    KTX_error_code result;
+    ktx_uint64_t baseOffset;
+    ktx_uint64_t levelOffset = 0;
+    ktxLevelIndexEntry* levelIndex;
+    ktxHashListEntry* pEntry = NULL;
+
+    assert(levelAlignment % private->_requiredLevelAlignment == 0);
+
+    if (This->pData == NULL)
+        return KTX_INVALID_OPERATION;
+
+    levelIndex = malloc(sizeof(ktxLevelIndexEntry) * This->numLevels);
+    if (!levelIndex)
+        return KTX_OUT_OF_MEMORY;
+    // Levels are written smallest first.
+    for (ktx_int32_t level = This->numLevels-1; level >= 0; --level) {
+        levelIndex[level] = private->_levelIndex[level];
+        levelIndex[level].byteOffset = levelOffset;
+        levelOffset = padn64(levelAlignment,
+                             levelOffset + levelIndex[level].byteLength);
+    }
+
+    // Level hashes, if requested, must match the data being written.
+    result = KTX_SUCCESS;
+    if (ktxHashList_FindEntry(&This->kvDataHead, KTX_LEVEL_HASHES_KEY,
+                              &pEntry) == KTX_SUCCESS)
+        result = ktxTexture2_setLevelHashes(This);
+
+    if (result == KTX_SUCCESS)
+        result = ktxTexture2_writeFileHeaders(This, dststr,
+                                              This->supercompressionScheme,
+                                              This->pDfd, levelIndex,
+                                              levelAlignment, &baseOffset);
+
     // write the image data
     for (ktx_int32_t level = This->numLevels-1; level >= 0 && result == KTX_SUCCESS; --level)
     {
@@ -527,13 +725,13 @@ ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
         result = dststr->getpos(dststr, (ktx_off_t*)&pos);
         // Could fail if stdout is a pipe
         if (result == KTX_SUCCESS)
-            assert(pos == private->_levelIndex[level].byteOffset + baseOffset);
+            assert(pos == levelIndex[level].byteOffset + baseOffset);
         else
             assert(result == KTX_FILE_ISPIPE);
 #endif
 
         srcLevelOffset = ktxTexture2_levelDataOffset(This, level);
-        levelSize = private->_levelIndex[level].byteLength;
+        levelSize = levelIndex[level].byteLength;
 
 #if DUMP_IMAGE
         if (!This->isCompressed) {
@@ -559,17 +757,54 @@ ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
         result = dststr->write(dststr, This->pData + srcLevelOffset,
                                levelSize, 1);
         if (result == KTX_SUCCESS && level > 0) { // No padding at end.
-            ktx_uint32_t levelPadLen
-                       = _KTX_PADN_LEN(This->_private->_requiredLevelAlignment,
-                                       levelSize);
+            ktx_uint64_t levelPadLen = levelIndex[level-1].byteOffset
+                                     - levelIndex[level].byteOffset
+                                     - levelSize;
             if (levelPadLen != 0)
-              result = dststr->write(dststr, padding, 1, levelPadLen);
+              result = writePadding(dststr, levelPadLen);
         }
     }
 
+    free(levelIndex);
     return result;
 }
 
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Write a ktxTexture object to a ktxStream in KTX format.
+ *
+ * @param[in] This      pointer to the target ktxTexture object.
+ * @param[in] dststr    destination ktxStream.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This or @p dststr is NULL.
+ * @exception KTX_INVALID_OPERATION
+ *                              The ktxTexture does not contain any image data.
+ * @exception KTX_INVALID_OPERATION
+ *                              Both kvDataHead and kvData are set in the
+ *                              ktxTexture
+ * @exception KTX_INVALID_OPERATION
+ *                              The length of the already set writerId metadata
+ *                              plus the library's version id exceeds the
+ *                              maximum allowed.
+ * @exception KTX_FILE_OVERFLOW The file exceeded the maximum size supported by
+ *                              the system.
+ * @exception KTX_FILE_WRITE_ERROR
+ *                              An error occurred while writing the file.
+ */
+KTX_error_code
+ktxTexture2_WriteToStream(ktxTexture2* This, ktxStream* dststr)
+{
+    if (!dststr) {
+        return KTX_INVALID_VALUE;
+    }
+
+    return ktxTexture2_writeToStreamAligned(This, dststr,
+                                    This->_private->_requiredLevelAlignment);
+}
+
 /**
  * @memberof ktxTexture2
  * @~English
@@ -744,6 +979,353 @@ ktxTexture2_WriteToMemory(ktxTexture2* This,
 
 }
 
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Write a ktxTexture2 object to a ktxStream in KTX format with the
+ *        start of each level aligned to @p alignment bytes.
+ *
+ * The KTX2 specification only requires levels to start at a multiple of
+ * the texel block size and 4 but permits more padding. Aligning levels to
+ * the page size, e.g. 4 KiB, or to 64 KiB lets loaders read them with
+ * direct I/O, map them straight to staging memory and fetch them with
+ * cache-friendly HTTP range requests. The alignment actually used is the
+ * least common multiple of @p alignment and the alignment required by the
+ * texture's format so for formats whose texel block size is not a power of
+ * two it is a multiple of @p alignment. Images within a level are always
+ * tightly packed, as the specification requires.
+ *
+ * The start of the first level is aligned too so every level's
+ * byteOffset in the level index is a multiple of the alignment. Readers
+ * identify such files from the level index;
+ * ktxTexture2_LoadImageData() uses direct reads for them where the
+ * platform supports it.
+ *
+ * Padding costs up to @p alignment - 1 bytes per level, so small textures
+ * with many levels grow considerably when written with large alignments.
+ *
+ * @param[in] This      pointer to the target ktxTexture object.
+ * @param[in] dststr    destination ktxStream.
+ * @param[in] alignment alignment in bytes for the start of each level. 1
+ *                      gives the same layout as ktxTexture2_WriteToStream().
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This or @p dststr is NULL or @p alignment
+ *                              is 0.
+ * @exception KTX_INVALID_OPERATION
+ *                              The ktxTexture does not contain any image data.
+ * @exception KTX_INVALID_OPERATION
+ *                              The metadata contains invalid or unrecognized
+ *                              KTX keys.
+ * @exception KTX_FILE_OVERFLOW The file exceeded the maximum size supported by
+ *                              the system.
+ * @exception KTX_FILE_WRITE_ERROR
+ *                              An error occurred while writing the file.
+ */
+KTX_error_code
+ktxTexture2_WriteAlignedToStream(ktxTexture2* This, ktxStream* dststr,
+                                 ktx_uint32_t alignment)
+{
+    ktx_uint32_t required, a, b;
+
+    if (!This || !dststr || alignment == 0)
+        return KTX_INVALID_VALUE;
+
+    // Least common multiple of alignment and the required alignment.
+    required = This->_private->_requiredLevelAlignment;
+    a = alignment; b = required;
+    while (b != 0) {
+        ktx_uint32_t t = a % b;
+        a = b; b = t;
+    }
+    if ((ktx_uint64_t)alignment / a * required > UINT32_MAX)
+        return KTX_INVALID_VALUE;
+
+    return ktxTexture2_writeToStreamAligned(This, dststr,
+                                            alignment / a * required);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Write a ktxTexture2 object to a stdio stream in KTX format with the
+ *        start of each level aligned to @p alignment bytes.
+ *
+ * See ktxTexture2_WriteAlignedToStream() for details.
+ *
+ * @param[in] This      pointer to the target ktxTexture object.
+ * @param[in] dstsstr   destination stdio stream.
+ * @param[in] alignment alignment in bytes for the start of each level.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ */
+KTX_error_code
+ktxTexture2_WriteAlignedToStdioStream(ktxTexture2* This, FILE* dstsstr,
+                                      ktx_uint32_t alignment)
+{
+    ktxStream stream;
+    KTX_error_code result = KTX_SUCCESS;
+
+    if (!This)
+        return KTX_INVALID_VALUE;
+
+    result = ktxFileStream_construct(&stream, dstsstr, KTX_FALSE);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    return ktxTexture2_WriteAlignedToStream(This, &stream, alignment);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Write a ktxTexture2 object to a named file in KTX format with the
+ *        start of each level aligned to @p alignment bytes.
+ *
+ * See ktxTexture2_WriteAlignedToStream() for details.
+ *
+ * @param[in] This      pointer to the target ktxTexture object.
+ * @param[in] dstname   destination file name.
+ * @param[in] alignment alignment in bytes for the start of each level.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ */
+KTX_error_code
+ktxTexture2_WriteAlignedToNamedFile(ktxTexture2* This,
+                                    const char* const dstname,
+                                    ktx_uint32_t alignment)
+{
+    KTX_error_code result;
+    FILE* dst;
+
+    if (!This)
+        return KTX_INVALID_VALUE;
+
+    dst = fopen(dstname, "wb");
+    if (dst) {
+        result = ktxTexture2_WriteAlignedToStdioStream(This, dst, alignment);
+        fclose(dst);
+    } else
+        result = KTX_FILE_OPEN_FAILED;
+
+    return result;
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Write a ktxTexture2 object to block of memory in KTX format with
+ *        the start of each level aligned to @p alignment bytes.
+ *
+ * Memory is allocated by the function and the caller is responsible for
+ * freeing it. See ktxTexture2_WriteAlignedToStream() for details.
+ *
+ * @param[in]     This       pointer to the target ktxTexture object.
+ * @param[in,out] ppDstBytes pointer to location to write the address of
+ *                           the destination memory. The Application is
+ *                           responsible for freeing this memory.
+ * @param[in,out] pSize      pointer to location to write the size in bytes of
+ *                           the KTX data.
+ * @param[in]     alignment  alignment in bytes for the start of each level.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ */
+KTX_error_code
+ktxTexture2_WriteAlignedToMemory(ktxTexture2* This,
+                                 ktx_uint8_t** ppDstBytes, ktx_size_t* pSize,
+                                 ktx_uint32_t alignment)
+{
+    struct ktxStream dststr;
+    KTX_error_code result;
+    ktx_size_t strSize;
+
+    if (!This || !ppDstBytes || !pSize)
+        return KTX_INVALID_VALUE;
+
+    *ppDstBytes = NULL;
+
+    result = ktxMemStream_construct(&dststr, KTX_FALSE);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    result = ktxTexture2_WriteAlignedToStream(This, &dststr, alignment);
+    if(result != KTX_SUCCESS)
+    {
+        ktxMemStream_destruct(&dststr);
+        return result;
+    }
+
+    ktxMemStream_getdata(&dststr, ppDstBytes);
+    dststr.getsize(&dststr, &strSize);
+    *pSize = strSize;
+    ktxMemStream_destruct(&dststr);
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTexture2
+ * @ingroup writer
+ * @~English
+ * @brief Publish a ktxTexture2 in shared memory for viewing by other
+ *        processes.
+ *
+ * The texture is written, in KTX format, to a new POSIX shared memory
+ * object called @p name. Any process of the same user can then create a
+ * read-only view of it with ktxTexture2_CreateFromShared() whose image
+ * data is the shared pages. Transcode or inflate the texture before
+ * publishing so that views can be used directly.
+ *
+ * The shared texture persists after the publishing process exits until it
+ * is invalidated with ktxTexture2_InvalidateShared(). To publish a new
+ * version under the same name, invalidate the old one first.
+ *
+ * @p name must not contain '/'. Some systems, e.g. macOS, limit the length
+ * of shared memory names to 30 characters.
+ *
+ * @param[in] This      pointer to the target ktxTexture object.
+ * @param[in] name      name under which to publish the texture.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This is NULL or @p name is not a valid
+ *                              name.
+ * @exception KTX_INVALID_OPERATION
+ *                              The ktxTexture does not contain any image data,
+ *                              a texture is already published as @p name or
+ *                              shared textures are not supported on this
+ *                              platform.
+ * @exception KTX_FILE_OPEN_FAILED
+ *                              The shared memory object could not be created.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory for the shared texture.
+ */
+KTX_error_code
+ktxTexture2_PublishShared(ktxTexture2* This, const char* name)
+{
+    ktx_uint8_t* pFile;
+    ktx_size_t fileSize;
+    ktxSharedRegion* region;
+    ktx_uint8_t* pShared;
+    KTX_error_code result;
+
+    if (!This || !name)
+        return KTX_INVALID_VALUE;
+
+    // The file size is only known once it has been written.
+    result = ktxTexture2_WriteToMemory(This, &pFile, &fileSize);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    result = ktxSharedRegion_create(name, fileSize, &region, &pShared);
+    if (result == KTX_SUCCESS) {
+        memcpy(pShared, pFile, fileSize);
+        ktxSharedRegion_publish(region);
+    }
+    free(pFile);
+    return result;
+}
+
+/** @internal
+ * @~English
+ * @brief Map a Zstandard compression error to a KTX error code.
+ *
+ * @param[in] zstdResult  the value returned by the failing Zstd function.
+ */
+KTX_error_code
+ktxZstdErrorToKtx(size_t zstdResult)
+{
+    ZSTD_ErrorCode error = ZSTD_getErrorCode(zstdResult);
+    switch(error) {
+      case ZSTD_error_parameter_outOfBound:
+        return KTX_INVALID_VALUE;
+      case ZSTD_error_dstSize_tooSmall:
+#ifdef DEBUG
+        assert(false && "Deflate dstSize too small.");
+#endif
+        return KTX_OUT_OF_MEMORY;
+      case ZSTD_error_workSpace_tooSmall:
+#ifdef DEBUG
+        assert(false && "Deflate workspace too small.");
+#endif
+        return KTX_OUT_OF_MEMORY;
+      case ZSTD_error_memory_allocation:
+        return KTX_OUT_OF_MEMORY;
+      default:
+        // The remaining errors look like they should only
+        // occur during decompression but just in case.
+        return KTX_INVALID_OPERATION;
+    }
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Return the supercompression scheme used to signal a Zstd filter.
+ *
+ * @param[in] This     pointer to the ktxTexture2 object of interest.
+ * @param[in] filter   the filter to be applied.
+ * @param[out] pScheme pointer to where the scheme is written.
+ *
+ * @exception KTX_INVALID_OPERATION @p filter is not supported for the
+ *                                  texture's format.
+ * @exception KTX_INVALID_VALUE     @p filter is not a valid filter.
+ */
+KTX_error_code
+ktxTexture2_zstdFilterScheme(ktxTexture2* This, ktx_zstd_filter_e filter,
+                             ktxSupercmpScheme* pScheme)
+{
+    switch (filter) {
+      case KTX_ZSTD_FILTER_NONE:
+        *pScheme = KTX_SS_ZSTD;
+        break;
+      case KTX_ZSTD_FILTER_SHUFFLE_DELTA:
+        if (This->isCompressed || This->vkFormat == VK_FORMAT_UNDEFINED)
+            return KTX_INVALID_OPERATION;
+        *pScheme = KTX_SS_ZSTD_SHUFFLE_DELTA;
+        break;
+      case KTX_ZSTD_FILTER_BLOCK_SPLIT:
+        if (!This->isCompressed)
+            return KTX_INVALID_OPERATION;
+        *pScheme = KTX_SS_ZSTD_BLOCK_SPLIT;
+        break;
+      default:
+        return KTX_INVALID_VALUE;
+    }
+    return KTX_SUCCESS;
+}
+
+/**
+ * @memberof ktxTexture2 @private
+ * @~English
+ * @brief Apply a Zstd pre-filter to the data of a level.
+ *
+ * @param[in] This   pointer to the ktxTexture2 object of interest.
+ * @param[in] level  mip level of the data.
+ * @param[in] filter the filter to apply. Must not be KTX_ZSTD_FILTER_NONE
+ *                   and must have been accepted by
+ *                   ktxTexture2_zstdFilterScheme().
+ * @param[in] src    pointer to the level's data.
+ * @param[out] dst   pointer to where the filtered data is written.
+ * @param[in] size   size in bytes of the level's data.
+ */
+void
+ktxTexture2_filterLevelData(ktxTexture2* This, ktx_uint32_t level,
+                            ktx_zstd_filter_e filter,
+                            const ktx_uint8_t* src, ktx_uint8_t* dst,
+                            ktx_size_t size)
+{
+    ktx_uint32_t rowElements = ktxTexture2_levelRowElements(This, level);
+    ktx_uint32_t elementSize =
+                    This->_protected->_formatSize.blockSizeInBits / 8;
+
+    if (filter == KTX_ZSTD_FILTER_SHUFFLE_DELTA) {
+        ktxShuffleDelta_encode(src, dst, size, rowElements, elementSize);
+    } else {
+        assert(filter == KTX_ZSTD_FILTER_BLOCK_SPLIT);
+        ktxBlockSplit_encode(src, dst, size, rowElements, elementSize);
+    }
+}
+
 /**
  * @memberof ktxTexture2
  * @~English
@@ -759,23 +1341,80 @@ ktxTexture2_WriteToMemory(ktxTexture2* This,
  */
 KTX_error_code
 ktxTexture2_DeflateZstd(ktxTexture2* This, ktx_uint32_t compressionLevel)
+{
+    return ktxTexture2_DeflateZstdFiltered(This, compressionLevel,
+                                           KTX_ZSTD_FILTER_NONE);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Deflate the data in a ktxTexture2 object using Zstandard after
+ *        applying a reversible filter to make it more compressible.
+ *
+ * With KTX_ZSTD_FILTER_SHUFFLE_DELTA the bytes of the elements of each row
+ * are separated into planes, e.g. all the high bytes of an R16_UNORM row
+ * followed by all the low bytes, and each plane is delta coded. This
+ * typically improves the deflated size of data with multi-byte components,
+ * such as height fields and half or single precision float images,
+ * considerably. The texture's supercompressionScheme is set to
+ * KTX_SS_ZSTD_SHUFFLE_DELTA.
+ *
+ * With KTX_ZSTD_FILTER_BLOCK_SPLIT the bytes of the blocks of each row of
+ * blocks of a block-compressed format are separated into planes. This puts
+ * byte-aligned block fields, such as BC1 endpoints and selectors or the
+ * mode and endpoint bits at the start and the index bits at the end of BC7
+ * and ASTC blocks, into separate streams which deflate better than the
+ * interleaved blocks. The texture's supercompressionScheme is set to
+ * KTX_SS_ZSTD_BLOCK_SPLIT.
+ *
+ * These are libktx vendor schemes so files using them can only be read by
+ * libktx. The filter is undone transparently when the data is inflated on
+ * load.
+ *
+ * The texture's levelIndex, dataSize, DFD  and supercompressionScheme will
+ * all be updated after successful deflation to reflect the deflated data.
+ *
+ * @param[in] This pointer to the ktxTexture2 object of interest.
+ * @param[in] compressionLevel set speed vs compression ratio trade-off. Values
+ *            between 1 and 22 are accepted. The lower the level the faster. Values
+ *            above 20 should be used with caution as they require more memory.
+ * @param[in] filter the filter to apply before deflation.
+ *
+ * @exception KTX_INVALID_OPERATION
+ *                              The texture's data is already supercompressed
+ *                              or @p filter is not supported for the texture's
+ *                              format.
+ * @exception KTX_INVALID_VALUE @p filter is not a valid filter.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory for the deflated data.
+ */
+KTX_error_code
+ktxTexture2_DeflateZstdFiltered(ktxTexture2* This,
+                                ktx_uint32_t compressionLevel,
+                                ktx_zstd_filter_e filter)
 {
     ktx_uint32_t levelIndexByteLength =
                             This->numLevels * sizeof(ktxLevelIndexEntry);
     ktx_uint8_t* workBuf;
     ktx_uint8_t* cmpData;
+    ktx_uint8_t* filterBuf = NULL;
     ktx_size_t dstRemainingByteLength = 0;
     ktx_size_t byteLengthCmp = 0;
     ktx_size_t levelOffset = 0;
     ktxLevelIndexEntry* cindex = This->_private->_levelIndex;
     ktxLevelIndexEntry* nindex;
     ktx_uint8_t* pCmpDst;
-
-    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    ktxSupercmpScheme scheme;
+    KTX_error_code result;
+    ZSTD_CCtx* cctx;
 
     if (This->supercompressionScheme != KTX_SS_NONE)
         return KTX_INVALID_OPERATION;
 
+    result = ktxTexture2_zstdFilterScheme(This, filter, &scheme);
+    if (result != KTX_SUCCESS)
+        return result;
+
     // On rare occasions the deflated data can be a few bytes larger than
     // the source data. Calculating the dst buffer size using
     // ZSTD_compressBound provides a suitable size plus compression is said
@@ -790,42 +1429,40 @@ ktxTexture2_DeflateZstd(ktxTexture2* This, ktx_uint32_t compressionLevel)
     nindex = (ktxLevelIndexEntry*)workBuf;
     pCmpDst = &workBuf[levelIndexByteLength];
 
+    if (filter != KTX_ZSTD_FILTER_NONE) {
+        // Level 0 is the largest.
+        filterBuf = malloc(cindex[0].byteLength);
+        if (filterBuf == NULL) {
+            free(workBuf);
+            return KTX_OUT_OF_MEMORY;
+        }
+    }
+
+    cctx = ZSTD_createCCtx();
+    if (cctx == NULL) {
+        free(filterBuf);
+        free(workBuf);
+        return KTX_OUT_OF_MEMORY;
+    }
+
     for (int32_t level = This->numLevels - 1; level >= 0; level--) {
+        const ktx_uint8_t* pSrc = &This->pData[cindex[level].byteOffset];
+        if (filter != KTX_ZSTD_FILTER_NONE) {
+            ktxTexture2_filterLevelData(This, level, filter, pSrc, filterBuf,
+                                        cindex[level].byteLength);
+            pSrc = filterBuf;
+        }
         size_t levelByteLengthCmp =
             ZSTD_compressCCtx(cctx, pCmpDst + levelOffset,
                               dstRemainingByteLength,
-                              &This->pData[cindex[level].byteOffset],
+                              pSrc,
                               cindex[level].byteLength,
                               compressionLevel);
         if (ZSTD_isError(levelByteLengthCmp)) {
+            free(filterBuf);
             free(workBuf);
-            ZSTD_ErrorCode error = ZSTD_getErrorCode(levelByteLengthCmp);
-            switch(error) {
-              case ZSTD_error_parameter_outOfBound:
-                return KTX_INVALID_VALUE;
-              case ZSTD_error_dstSize_tooSmall:
-#ifdef DEBUG
-                assert(false && "Deflate dstSize too small.");
-#else
-                return KTX_OUT_OF_MEMORY;
-#endif
-              case ZSTD_error_workSpace_tooSmall:
-#ifdef DEBUG
-                assert(false && "Deflate workspace too small.");
-#else
-                return KTX_OUT_OF_MEMORY;
-#endif
-              case ZSTD_error_memory_allocation:
-                return KTX_OUT_OF_MEMORY;
-              default:
-                // The remaining errors look like they should only
-                // occur during decompression but just in case.
-#ifdef DEBUG
-                assert(true);
-#else
-                return KTX_INVALID_OPERATION;
-#endif
-            }
+            ZSTD_freeCCtx(cctx);
+            return ktxZstdErrorToKtx(levelByteLengthCmp);
         }
         nindex[level].byteOffset = levelOffset;
         nindex[level].uncompressedByteLength = cindex[level].byteLength;
@@ -835,6 +1472,7 @@ ktxTexture2_DeflateZstd(ktxTexture2* This, ktx_uint32_t compressionLevel)
         dstRemainingByteLength -= levelByteLengthCmp;
     }
     ZSTD_freeCCtx(cctx);
+    free(filterBuf);
 
     // Move the compressed data into a correctly sized buffer.
     cmpData = malloc(byteLengthCmp);
@@ -846,10 +1484,10 @@ ktxTexture2_DeflateZstd(ktxTexture2* This, ktx_uint32_t compressionLevel)
     memcpy(cmpData, pCmpDst, byteLengthCmp); // Copy data to sized buffer.
     memcpy(cindex, nindex, levelIndexByteLength); // Update level index
     free(workBuf);
-    free(This->pData);
+    ktxTexture2_freeData(This);
     This->pData = cmpData;
     This->dataSize = byteLengthCmp;
-    This->supercompressionScheme = KTX_SS_ZSTD;
+    This->supercompressionScheme = scheme;
     This->_private->_requiredLevelAlignment = 1;
     // Clear bytesPlane to indicate we're now unsized.
     uint32_t* bdb = This->pDfd + 1;
@@ -858,5 +1496,244 @@ ktxTexture2_DeflateZstd(ktxTexture2* This, ktx_uint32_t compressionLevel)
     return KTX_SUCCESS;
 }
 
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Write a ktxTexture2 object to a ktxStream in KTX format, deflating
+ *        the image data with Zstandard as it is written.
+ *
+ * The file is equivalent to that written by calling ktxTexture2_DeflateZstd()
+ * followed by ktxTexture2_WriteToStream() and its images decode identically,
+ * though the Zstd frames may differ byte for byte as they are made by a
+ * streaming compressor. The texture is not modified and no intermediate copy
+ * of the deflated data is made. Each level is compressed
+ * directly from the texture's data into the stream through a small, fixed
+ * size output buffer. Compression is done by a Zstd worker thread so
+ * compression of the next part of the data overlaps writing of the previous
+ * part. The level index is written with placeholder values and patched once
+ * the deflated sizes are known, so @p dststr must be seekable.
+ *
+ * @param[in] This      pointer to the target ktxTexture object.
+ * @param[in] dststr    destination ktxStream.
+ * @param[in] compressionLevel set speed vs compression ratio trade-off. Values
+ *            between 1 and 22 are accepted. The lower the level the faster.
+ *            Values above 20 should be used with caution as they require more
+ *            memory.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @exception KTX_INVALID_VALUE @p This or @p dststr is NULL.
+ * @exception KTX_INVALID_VALUE @p compressionLevel is out of range.
+ * @exception KTX_INVALID_OPERATION
+ *                              The ktxTexture does not contain any image data
+ *                              or its data is already supercompressed.
+ * @exception KTX_FILE_ISPIPE   @p dststr is not seekable.
+ * @exception KTX_OUT_OF_MEMORY Not enough memory for the compression context.
+ * @exception KTX_FILE_WRITE_ERROR
+ *                              An error occurred while writing the file.
+ */
+KTX_error_code
+ktxTexture2_DeflateZstdToStream(ktxTexture2* This, ktxStream* dststr,
+                                ktx_uint32_t compressionLevel)
+{
+    if (!This || !dststr)
+        return KTX_INVALID_VALUE;
+
+    DECLARE_PRIVATE(ktxTexture2);
+    ktx_uint32_t levelIndexByteLength =
+                            This->numLevels * sizeof(ktxLevelIndexEntry);
+    ktxLevelIndexEntry* cindex = private->_levelIndex;
+    ktxLevelIndexEntry* nindex;
+    ktx_uint32_t* pDfd;
+    ktx_uint8_t* outBuf;
+    size_t outBufSize;
+    ktx_off_t startPos, endPos;
+    ktx_uint64_t baseOffset;
+    ktx_size_t levelOffset = 0;
+    ZSTD_CCtx* cctx;
+    ktxHashListEntry* hashEntry = NULL;
+    size_t zr;
+    KTX_error_code result;
+
+    if (This->pData == NULL)
+        return KTX_INVALID_OPERATION;
+
+    if (This->supercompressionScheme != KTX_SS_NONE)
+        return KTX_INVALID_OPERATION;
+
+    // The level index has to be patched after the data is written.
+    result = dststr->getpos(dststr, &startPos);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    nindex = calloc(1, levelIndexByteLength);
+    // Clear bytesPlane in the written DFD to indicate the data is unsized.
+    pDfd = malloc(*This->pDfd);
+    outBufSize = ZSTD_CStreamOutSize();
+    outBuf = malloc(outBufSize);
+    cctx = ZSTD_createCCtx();
+    if (!nindex || !pDfd || !outBuf || !cctx) {
+        result = KTX_OUT_OF_MEMORY;
+        goto cleanup;
+    }
+    memcpy(pDfd, This->pDfd, *This->pDfd);
+    pDfd[1 + KHR_DF_WORD_BYTESPLANE0] = 0; /* bytesPlane3..0 = 0 */
+
+    zr = ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel,
+                                compressionLevel);
+    if (ZSTD_isError(zr)) {
+        result = ktxZstdErrorToKtx(zr);
+        goto cleanup;
+    }
+    // Compress in a worker thread so writing overlaps compression. Failure
+    // just means the library was built without multithreading; compression
+    // then runs synchronously.
+    (void)ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, 1);
+
+    // Level hashes of the deflated data cannot be known yet so leave out
+    // any that were added. They are restored afterwards.
+    if (ktxHashList_FindEntry(&This->kvDataHead, KTX_LEVEL_HASHES_KEY,
+                              &hashEntry) == KTX_SUCCESS) {
+        unsigned int valueLen;
+        void* value;
+
+        ktxHashList_DeleteEntry(&This->kvDataHead, hashEntry);
+        result = ktxTexture2_writeFileHeaders(This, dststr, KTX_SS_ZSTD, pDfd,
+                                              nindex, 1, &baseOffset);
+        ktxHashListEntry_GetValue(hashEntry, &valueLen, &value);
+        ktxHashList_AddKVPair(&This->kvDataHead, KTX_LEVEL_HASHES_KEY,
+                              valueLen, value);
+        free(hashEntry);
+    } else {
+        result = ktxTexture2_writeFileHeaders(This, dststr, KTX_SS_ZSTD, pDfd,
+                                              nindex, 1, &baseOffset);
+    }
+    if (result != KTX_SUCCESS)
+        goto cleanup;
+
+    for (int32_t level = This->numLevels - 1; level >= 0; level--) {
+        ZSTD_inBuffer input;
+        size_t remaining;
+        ktx_size_t levelByteLengthCmp = 0;
+
+        input.src = &This->pData[cindex[level].byteOffset];
+        input.size = cindex[level].byteLength;
+        input.pos = 0;
+        zr = ZSTD_CCtx_setPledgedSrcSize(cctx, cindex[level].byteLength);
+        if (ZSTD_isError(zr)) {
+            result = ktxZstdErrorToKtx(zr);
+            goto cleanup;
+        }
+        do {
+            ZSTD_outBuffer output = { outBuf, outBufSize, 0 };
+            remaining = ZSTD_compressStream2(cctx, &output, &input,
+                                             ZSTD_e_end);
+            if (ZSTD_isError(remaining)) {
+                result = ktxZstdErrorToKtx(remaining);
+                goto cleanup;
+            }
+            if (output.pos != 0) {
+                result = dststr->write(dststr, outBuf, 1, output.pos);
+                if (result != KTX_SUCCESS)
+                    goto cleanup;
+            }
+            levelByteLengthCmp += output.pos;
+        } while (remaining != 0);
+
+        nindex[level].byteOffset = levelOffset;
+        nindex[level].uncompressedByteLength = cindex[level].byteLength;
+        nindex[level].byteLength = levelByteLengthCmp;
+        levelOffset += levelByteLengthCmp;
+    }
+
+    // Patch the level index with the deflated sizes and offsets.
+    for (ktx_uint32_t level = 0; level < This->numLevels; level++)
+        nindex[level].byteOffset += baseOffset;
+    result = dststr->getpos(dststr, &endPos);
+    if (result != KTX_SUCCESS)
+        goto cleanup;
+    result = dststr->setpos(dststr, startPos + sizeof(KTX_header2));
+    if (result != KTX_SUCCESS)
+        goto cleanup;
+    result = dststr->write(dststr, nindex, levelIndexByteLength, 1);
+    if (result != KTX_SUCCESS)
+        goto cleanup;
+    result = dststr->setpos(dststr, endPos);
+
+cleanup:
+    ZSTD_freeCCtx(cctx);
+    free(outBuf);
+    free(pDfd);
+    free(nindex);
+    return result;
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Write a ktxTexture2 object to a stdio stream in KTX format,
+ *        deflating the image data with Zstandard as it is written.
+ *
+ * See ktxTexture2_DeflateZstdToStream() for details.
+ *
+ * @param[in] This      pointer to the target ktxTexture object.
+ * @param[in] dstsstr   destination stdio stream. Must be seekable.
+ * @param[in] compressionLevel set speed vs compression ratio trade-off.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ */
+KTX_error_code
+ktxTexture2_DeflateZstdToStdioStream(ktxTexture2* This, FILE* dstsstr,
+                                     ktx_uint32_t compressionLevel)
+{
+    ktxStream stream;
+    KTX_error_code result = KTX_SUCCESS;
+
+    if (!This)
+        return KTX_INVALID_VALUE;
+
+    result = ktxFileStream_construct(&stream, dstsstr, KTX_FALSE);
+    if (result != KTX_SUCCESS)
+        return result;
+
+    return ktxTexture2_DeflateZstdToStream(This, &stream, compressionLevel);
+}
+
+/**
+ * @memberof ktxTexture2
+ * @~English
+ * @brief Write a ktxTexture2 object to a named file in KTX format,
+ *        deflating the image data with Zstandard as it is written.
+ *
+ * See ktxTexture2_DeflateZstdToStream() for details.
+ *
+ * @param[in] This      pointer to the target ktxTexture object.
+ * @param[in] dstname   destination file name.
+ * @param[in] compressionLevel set speed vs compression ratio trade-off.
+ *
+ * @return      KTX_SUCCESS on success, other KTX_* enum values on error.
+ */
+KTX_error_code
+ktxTexture2_DeflateZstdToNamedFile(ktxTexture2* This,
+                                   const char* const dstname,
+                                   ktx_uint32_t compressionLevel)
+{
+    KTX_error_code result;
+    FILE* dst;
+
+    if (!This)
+        return KTX_INVALID_VALUE;
+
+    dst = fopen(dstname, "wb");
+    if (dst) {
+        result = ktxTexture2_DeflateZstdToStdioStream(This, dst,
+                                                      compressionLevel);
+        fclose(dst);
+    } else
+        result = KTX_FILE_OPEN_FAILED;
+
+    return result;
+}
+
 /** @} */
 
@@ -0,0 +1,301 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2010-2020 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @internal
+ * @file zstdfilter.c
+ * @~English
+ *
+ * @brief Reversible pre-filters for improving the Zstd compression ratio
+ *        of image data.
+ *
+ * The shuffle/delta filter targets uncompressed formats with multi-byte
+ * components, e.g. R16_UNORM height fields or R16G16B16A16_SFLOAT HDR
+ * images. The bytes of each element of a row are split into separate
+ * planes, so all the high bytes, which change slowly, are together, and
+ * each plane is then delta coded along the row.
+ *
+ * The block split filter targets block-compressed formats. Blocks are
+ * opaque 8 or 16 byte records to Zstd so the endpoints, mode bits and
+ * indices of neighbouring blocks are interleaved. Splitting the bytes of
+ * each row of blocks into planes separates the byte-aligned fields, e.g.
+ * BC1 endpoints from BC1 selectors and the mode and endpoint bits at the
+ * start of BC7 and ASTC blocks from the index bits at the end, into
+ * separate streams. Bit fields are not parsed so this works for any
+ * block-compressed format. No delta coding is done as it does not help
+ * block data.
+ *
+ * SSE2 versions are used for 2, 4, 8 and 16 byte elements when available.
+ * They produce exactly the same output as the scalar code.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ktx.h"
+#include "zstdfilter.h"
+
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define KTX_FILTER_USE_SSE2 1
+  #include <emmintrin.h>
+#else
+  #define KTX_FILTER_USE_SSE2 0
+#endif
+
+#if KTX_FILTER_USE_SSE2
+/*
+ * Transpose 16 elements of @p es bytes held in @p v[0..es-1] so that on
+ * return v[b] holds byte b of each of the elements. Each pass splits the
+ * even and odd bytes of adjacent pairs of vectors.
+ */
+static void
+transposeToPlanesSse2(__m128i* v, ktx_uint32_t es)
+{
+    const __m128i lowMask = _mm_set1_epi16(0x00ff);
+    ktx_uint32_t half = es / 2;
+    __m128i t[16];
+
+    for (ktx_uint32_t pass = 1; pass < es; pass *= 2) {
+        for (ktx_uint32_t j = 0; j < half; j++) {
+            __m128i a = v[2 * j], b = v[2 * j + 1];
+            t[j] = _mm_packus_epi16(_mm_and_si128(a, lowMask),
+                                    _mm_and_si128(b, lowMask));
+            t[j + half] = _mm_packus_epi16(_mm_srli_epi16(a, 8),
+                                           _mm_srli_epi16(b, 8));
+        }
+        memcpy(v, t, es * sizeof(__m128i));
+    }
+}
+
+/*
+ * Inverse of transposeToPlanesSse2.
+ */
+static void
+transposeFromPlanesSse2(__m128i* v, ktx_uint32_t es)
+{
+    ktx_uint32_t half = es / 2;
+    __m128i t[16];
+
+    for (ktx_uint32_t pass = 1; pass < es; pass *= 2) {
+        for (ktx_uint32_t j = 0; j < half; j++) {
+            t[2 * j] = _mm_unpacklo_epi8(v[j], v[j + half]);
+            t[2 * j + 1] = _mm_unpackhi_epi8(v[j], v[j + half]);
+        }
+        memcpy(v, t, es * sizeof(__m128i));
+    }
+}
+
+/* Inclusive prefix sum of the bytes of @p v plus @p carry. */
+static inline __m128i
+prefixSumSse2(__m128i v, __m128i carry)
+{
+    v = _mm_add_epi8(v, _mm_slli_si128(v, 1));
+    v = _mm_add_epi8(v, _mm_slli_si128(v, 2));
+    v = _mm_add_epi8(v, _mm_slli_si128(v, 4));
+    v = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+    return _mm_add_epi8(v, carry);
+}
+
+/* Broadcast the last byte of @p v to all bytes. */
+static inline __m128i
+broadcastLastSse2(__m128i v)
+{
+    v = _mm_srli_si128(v, 15);
+    v = _mm_unpacklo_epi8(v, v);
+    v = _mm_unpacklo_epi16(v, v);
+    return _mm_shuffle_epi32(v, 0);
+}
+#endif
+
+/*
+ * Replace each byte but the first with its difference from the previous
+ * byte. Runs from the end so it can be done in place.
+ */
+static void
+deltaEncodePlane(ktx_uint8_t* p, ktx_uint32_t n)
+{
+    ktx_uint32_t i = n;
+#if KTX_FILTER_USE_SSE2
+    // Each block reads the 16 bytes before it which are not yet modified.
+    while (i >= 17) {
+        __m128i cur, prev;
+        i -= 16;
+        cur = _mm_loadu_si128((const __m128i*)(p + i));
+        prev = _mm_loadu_si128((const __m128i*)(p + i - 1));
+        _mm_storeu_si128((__m128i*)(p + i), _mm_sub_epi8(cur, prev));
+    }
+#endif
+    for (; i > 1; i--)
+        p[i - 1] -= p[i - 2];
+}
+
+/* True if there is an SSE2 transpose for elements of @p es bytes. */
+#define SSE2_ELEMENT_SIZE(es) \
+    ((es) == 2 || (es) == 4 || (es) == 8 || (es) == 16)
+
+/*
+ * Split a row of @p numElements elements of @p elementSize bytes into
+ * @p elementSize planes of @p numElements bytes.
+ */
+static void
+shuffleRow(const ktx_uint8_t* src, ktx_uint8_t* dst,
+           ktx_uint32_t numElements, ktx_uint32_t elementSize)
+{
+    ktx_uint32_t i = 0;
+
+#if KTX_FILTER_USE_SSE2
+    if (SSE2_ELEMENT_SIZE(elementSize)) {
+        for (; i + 16 <= numElements; i += 16) {
+            __m128i v[16];
+            const ktx_uint8_t* s = src + i * elementSize;
+            for (ktx_uint32_t b = 0; b < elementSize; b++)
+                v[b] = _mm_loadu_si128((const __m128i*)(s + b * 16));
+            transposeToPlanesSse2(v, elementSize);
+            for (ktx_uint32_t b = 0; b < elementSize; b++)
+                _mm_storeu_si128((__m128i*)(dst + b * numElements + i), v[b]);
+        }
+    }
+#endif
+    for (; i < numElements; i++) {
+        for (ktx_uint32_t b = 0; b < elementSize; b++)
+            dst[b * numElements + i] = src[i * elementSize + b];
+    }
+}
+
+/*
+ * Inverse of shuffleRow. If @p prefixSum is true, each plane is also
+ * prefix summed to undo delta coding.
+ */
+static void
+unshuffleRow(const ktx_uint8_t* src, ktx_uint8_t* dst,
+             ktx_uint32_t numElements, ktx_uint32_t elementSize,
+             ktx_bool_t prefixSum)
+{
+    ktx_uint8_t acc[16] = { 0 };
+    ktx_uint32_t i = 0;
+
+#if KTX_FILTER_USE_SSE2
+    if (SSE2_ELEMENT_SIZE(elementSize)) {
+        __m128i carry[16];
+        for (ktx_uint32_t b = 0; b < elementSize; b++)
+            carry[b] = _mm_setzero_si128();
+        for (; i + 16 <= numElements; i += 16) {
+            __m128i v[16];
+            ktx_uint8_t* d = dst + i * elementSize;
+            for (ktx_uint32_t b = 0; b < elementSize; b++) {
+                v[b] = _mm_loadu_si128(
+                              (const __m128i*)(src + b * numElements + i));
+                if (prefixSum) {
+                    v[b] = prefixSumSse2(v[b], carry[b]);
+                    carry[b] = broadcastLastSse2(v[b]);
+                }
+            }
+            transposeFromPlanesSse2(v, elementSize);
+            for (ktx_uint32_t b = 0; b < elementSize; b++)
+                _mm_storeu_si128((__m128i*)(d + b * 16), v[b]);
+        }
+        for (ktx_uint32_t b = 0; b < elementSize; b++)
+            acc[b] = (ktx_uint8_t)_mm_cvtsi128_si32(carry[b]);
+    }
+#endif
+    for (ktx_uint32_t b = 0; b < elementSize; b++) {
+        const ktx_uint8_t* plane = src + b * numElements;
+        if (prefixSum) {
+            ktx_uint8_t a = b < 16 ? acc[b] : 0;
+            for (ktx_uint32_t j = i; j < numElements; j++) {
+                a += plane[j];
+                dst[j * elementSize + b] = a;
+            }
+        } else {
+            for (ktx_uint32_t j = i; j < numElements; j++)
+                dst[j * elementSize + b] = plane[j];
+        }
+    }
+}
+
+/*
+ * Undo a row filter in place, one row at a time through a row buffer.
+ */
+static KTX_error_code
+decodeRows(ktx_uint8_t* data, ktx_size_t size, ktx_uint32_t rowElements,
+           ktx_uint32_t elementSize, ktx_bool_t prefixSum)
+{
+    ktx_size_t rowBytes = (ktx_size_t)rowElements * elementSize;
+    ktx_uint8_t* row;
+
+    if (rowBytes == 0 || size % rowBytes != 0)
+        return KTX_FILE_DATA_ERROR;
+
+    row = malloc(rowBytes);
+    if (row == NULL)
+        return KTX_OUT_OF_MEMORY;
+    for (ktx_size_t offset = 0; offset < size; offset += rowBytes) {
+        unshuffleRow(data + offset, row, rowElements, elementSize, prefixSum);
+        memcpy(data + offset, row, rowBytes);
+    }
+    free(row);
+    return KTX_SUCCESS;
+}
+
+void
+ktxShuffleDelta_encodeRow(const ktx_uint8_t* src, ktx_uint8_t* dst,
+                          ktx_uint32_t numElements, ktx_uint32_t elementSize)
+{
+    shuffleRow(src, dst, numElements, elementSize);
+    for (ktx_uint32_t b = 0; b < elementSize; b++)
+        deltaEncodePlane(dst + b * numElements, numElements);
+}
+
+void
+ktxShuffleDelta_decodeRow(const ktx_uint8_t* src, ktx_uint8_t* dst,
+                          ktx_uint32_t numElements, ktx_uint32_t elementSize)
+{
+    unshuffleRow(src, dst, numElements, elementSize, KTX_TRUE);
+}
+
+void
+ktxShuffleDelta_encode(const ktx_uint8_t* src, ktx_uint8_t* dst,
+                       ktx_size_t size, ktx_uint32_t rowElements,
+                       ktx_uint32_t elementSize)
+{
+    ktx_size_t rowBytes = (ktx_size_t)rowElements * elementSize;
+
+    assert(size % rowBytes == 0);
+    for (ktx_size_t offset = 0; offset < size; offset += rowBytes) {
+        ktxShuffleDelta_encodeRow(src + offset, dst + offset,
+                                  rowElements, elementSize);
+    }
+}
+
+KTX_error_code
+ktxShuffleDelta_decode(ktx_uint8_t* data, ktx_size_t size,
+                       ktx_uint32_t rowElements, ktx_uint32_t elementSize)
+{
+    return decodeRows(data, size, rowElements, elementSize, KTX_TRUE);
+}
+
+void
+ktxBlockSplit_encode(const ktx_uint8_t* src, ktx_uint8_t* dst,
+                     ktx_size_t size, ktx_uint32_t rowBlocks,
+                     ktx_uint32_t blockSize)
+{
+    ktx_size_t rowBytes = (ktx_size_t)rowBlocks * blockSize;
+
+    assert(size % rowBytes == 0);
+    for (ktx_size_t offset = 0; offset < size; offset += rowBytes)
+        shuffleRow(src + offset, dst + offset, rowBlocks, blockSize);
+}
+
+KTX_error_code
+ktxBlockSplit_decode(ktx_uint8_t* data, ktx_size_t size,
+                     ktx_uint32_t rowBlocks, ktx_uint32_t blockSize)
+{
+    return decodeRows(data, size, rowBlocks, blockSize, KTX_FALSE);
+}
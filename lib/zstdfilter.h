@@ -0,0 +1,74 @@
+/* -*- tab-width: 4; -*- */
+/* vi: set sw=2 ts=4 expandtab: */
+
+/*
+ * Copyright 2010-2020 The Khronos Group Inc.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Reversible pre-filters applied to image data before Zstd deflation to
+ * make it more compressible and undone after inflation.
+ */
+
+#ifndef ZSTDFILTER_H
+#define ZSTDFILTER_H
+
+#include "ktx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * ktxShuffleDelta_encodeRow: Split a row of @p numElements elements, each
+ * @p elementSize bytes, into @p elementSize byte planes and delta code each
+ * plane. @p src and @p dst must not overlap.
+ */
+void ktxShuffleDelta_encodeRow(const ktx_uint8_t* src, ktx_uint8_t* dst,
+                               ktx_uint32_t numElements,
+                               ktx_uint32_t elementSize);
+
+/*
+ * ktxShuffleDelta_decodeRow: Inverse of ktxShuffleDelta_encodeRow.
+ */
+void ktxShuffleDelta_decodeRow(const ktx_uint8_t* src, ktx_uint8_t* dst,
+                               ktx_uint32_t numElements,
+                               ktx_uint32_t elementSize);
+
+/*
+ * ktxShuffleDelta_encode: Filter @p size bytes of rows each @p rowElements
+ * elements wide. @p size must be a multiple of the row size.
+ */
+void ktxShuffleDelta_encode(const ktx_uint8_t* src, ktx_uint8_t* dst,
+                            ktx_size_t size, ktx_uint32_t rowElements,
+                            ktx_uint32_t elementSize);
+
+/*
+ * ktxShuffleDelta_decode: Undo ktxShuffleDelta_encode in place.
+ */
+KTX_error_code ktxShuffleDelta_decode(ktx_uint8_t* data, ktx_size_t size,
+                                      ktx_uint32_t rowElements,
+                                      ktx_uint32_t elementSize);
+
+/*
+ * ktxBlockSplit_encode: Split the bytes of each row of @p rowBlocks
+ * compressed blocks, each @p blockSize bytes, into @p blockSize planes.
+ * @p size must be a multiple of the row size.
+ */
+void ktxBlockSplit_encode(const ktx_uint8_t* src, ktx_uint8_t* dst,
+                          ktx_size_t size, ktx_uint32_t rowBlocks,
+                          ktx_uint32_t blockSize);
+
+/*
+ * ktxBlockSplit_decode: Undo ktxBlockSplit_encode in place.
+ */
+KTX_error_code ktxBlockSplit_decode(ktx_uint8_t* data, ktx_size_t size,
+                                    ktx_uint32_t rowBlocks,
+                                    ktx_uint32_t blockSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZSTDFILTER_H */
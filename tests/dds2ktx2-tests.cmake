@@ -0,0 +1,110 @@
+# -*- tab-width: 4; -*-
+# vi: set sw=2 ts=4 expandtab:
+
+# Copyright 2026 The Khronos Group Inc.
+# SPDX-License-Identifier: Apache-2.0
+
+add_test( NAME dds2ktx2-test-help
+    COMMAND dds2ktx2 --help
+)
+set_tests_properties(
+    dds2ktx2-test-help
+PROPERTIES
+    PASS_REGULAR_EXPRESSION "^Usage: dds2ktx2"
+)
+
+add_test( NAME dds2ktx2-test-version
+    COMMAND dds2ktx2 --version
+)
+set_tests_properties(
+    dds2ktx2-test-version
+PROPERTIES
+    PASS_REGULAR_EXPRESSION "^dds2ktx2 v[0-9][0-9\\.]+"
+)
+
+# Why are there <test> and matching <test>-exit-code tests
+#
+# See comment under the same title in ./ktx2check-tests.cmake.
+
+add_test( NAME dds2ktx2-test-foobar
+    COMMAND dds2ktx2 --foobar
+)
+set_tests_properties(
+    dds2ktx2-test-foobar
+PROPERTIES
+    PASS_REGULAR_EXPRESSION "^Usage: dds2ktx2"
+)
+add_test( NAME dds2ktx2-test-foobar-exit-code
+    COMMAND dds2ktx2 --foobar
+)
+set_tests_properties(
+    dds2ktx2-test-foobar-exit-code
+PROPERTIES
+    WILL_FAIL TRUE
+)
+
+add_test( NAME dds2ktx2-test-many-in-one-out
+    COMMAND dds2ktx2 -o foo a.dds b.dds c.dds
+)
+set_tests_properties(
+    dds2ktx2-test-many-in-one-out
+PROPERTIES
+    PASS_REGULAR_EXPRESSION "^Can't use -o when there are multiple infiles."
+)
+add_test( NAME dds2ktx2-test-many-in-one-out-exit-code
+    COMMAND dds2ktx2 -o foo a.dds b.dds c.dds
+)
+set_tests_properties(
+    dds2ktx2-test-many-in-one-out-exit-code
+PROPERTIES
+    WILL_FAIL TRUE
+)
+
+set( IMG_DIR "${CMAKE_CURRENT_SOURCE_DIR}/testimages" )
+
+add_test( NAME dds2ktx2-test-ktx2-in
+    COMMAND dds2ktx2 -o foo CesiumLogoFlat.ktx2
+    WORKING_DIRECTORY ${IMG_DIR}
+)
+set_tests_properties(
+    dds2ktx2-test-ktx2-in
+PROPERTIES
+    PASS_REGULAR_EXPRESSION "Invalid DDS file: "
+)
+add_test( NAME dds2ktx2-test-ktx2-in-exit-code
+    COMMAND dds2ktx2 -o foo CesiumLogoFlat.ktx2
+    WORKING_DIRECTORY ${IMG_DIR}
+)
+set_tests_properties(
+    dds2ktx2-test-ktx2-in-exit-code
+PROPERTIES
+    WILL_FAIL TRUE
+)
+
+# The astc-encoder test data includes a 2D RGBA8 and 3D luminance DDS files.
+# Convert them, in parallel, and check the outputs are valid.
+set( DDS_DIR "${PROJECT_SOURCE_DIR}/lib/astc-encoder/Test" )
+
+add_test( NAME dds2ktx2-cnvrt-2d-and-3d
+    COMMAND ${BASH_EXECUTABLE} -c "cp ${DDS_DIR}/Data/Tiles/ldr.dds dds2ktx2.ldr.dds && cp ${DDS_DIR}/Images/Small/LDR-L/ldr-l-01-3.dds dds2ktx2.ldr-l-01-3.dds && $<TARGET_FILE:dds2ktx2> --test --zcmp 3 --threads 2 dds2ktx2.ldr.dds dds2ktx2.ldr-l-01-3.dds && rm dds2ktx2.ldr.dds dds2ktx2.ldr-l-01-3.dds && $<TARGET_FILE:ktx2check> dds2ktx2.ldr.ktx2 dds2ktx2.ldr-l-01-3.ktx2 && rm dds2ktx2.ldr.ktx2 dds2ktx2.ldr-l-01-3.ktx2"
+    WORKING_DIRECTORY ${IMG_DIR}
+)
+
+# mipMapCount must be ignored unless DDSD_MIPMAPCOUNT is set in the header
+# flags. ldr.dds doesn't set it so put garbage in the count.
+add_test( NAME dds2ktx2-unflagged-mipmapcount
+    COMMAND ${BASH_EXECUTABLE} -c "cp ${DDS_DIR}/Data/Tiles/ldr.dds dds2ktx2.mipcount.dds && printf '\\xff\\xff\\x00\\x00' | dd of=dds2ktx2.mipcount.dds bs=1 seek=28 conv=notrunc 2>/dev/null && $<TARGET_FILE:dds2ktx2> -o dds2ktx2.mipcount.ktx2 dds2ktx2.mipcount.dds && $<TARGET_FILE:ktx2check> dds2ktx2.mipcount.ktx2 && rm dds2ktx2.mipcount.dds dds2ktx2.mipcount.ktx2"
+    WORKING_DIRECTORY ${IMG_DIR}
+)
+
+# A header claiming far more data than the file holds must be rejected
+# before the texture's storage is allocated. Set the height to 2^30.
+add_test( NAME dds2ktx2-header-exceeds-file
+    COMMAND ${BASH_EXECUTABLE} -c "cp ${DDS_DIR}/Data/Tiles/ldr.dds dds2ktx2.huge.dds && printf '\\x00\\x00\\x00\\x40' | dd of=dds2ktx2.huge.dds bs=1 seek=12 conv=notrunc 2>/dev/null && $<TARGET_FILE:dds2ktx2> -o dds2ktx2.huge.ktx2 dds2ktx2.huge.dds; rm -f dds2ktx2.huge.dds dds2ktx2.huge.ktx2"
+    WORKING_DIRECTORY ${IMG_DIR}
+)
+set_tests_properties(
+    dds2ktx2-header-exceeds-file
+PROPERTIES
+    PASS_REGULAR_EXPRESSION "file is truncated"
+)
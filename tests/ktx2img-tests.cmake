@@ -0,0 +1,84 @@
+# -*- tab-width: 4; -*-
+# vi: set sw=2 ts=4 expandtab:
+
+# Copyright 2026 The Khronos Group Inc.
+# SPDX-License-Identifier: Apache-2.0
+
+add_test( NAME ktx2img-test-help
+    COMMAND ktx2img --help
+)
+set_tests_properties(
+    ktx2img-test-help
+PROPERTIES
+    PASS_REGULAR_EXPRESSION "^Usage: ktx2img"
+)
+
+add_test( NAME ktx2img-test-version
+    COMMAND ktx2img --version
+)
+set_tests_properties(
+    ktx2img-test-version
+PROPERTIES
+    PASS_REGULAR_EXPRESSION "^ktx2img v[0-9][0-9\\.]+"
+)
+
+# Why are there <test> and matching <test>-exit-code tests
+#
+# See comment under the same title in ./ktx2check-tests.cmake.
+
+add_test( NAME ktx2img-test-foobar
+    COMMAND ktx2img --foobar
+)
+set_tests_properties(
+    ktx2img-test-foobar
+PROPERTIES
+    PASS_REGULAR_EXPRESSION "^Usage: ktx2img"
+)
+add_test( NAME ktx2img-test-foobar-exit-code
+    COMMAND ktx2img --foobar
+)
+set_tests_properties(
+    ktx2img-test-foobar-exit-code
+PROPERTIES
+    WILL_FAIL TRUE
+)
+
+set( IMG_DIR "${CMAKE_CURRENT_SOURCE_DIR}/testimages" )
+
+# Extract the image of a file made by toktx then make a file from the
+# extracted PNG. It must be identical to the first.
+add_test( NAME ktx2img-round-trip
+    COMMAND ${BASH_EXECUTABLE} -c "$<TARGET_FILE:toktx> --test --t2 ktx2img.rt.ktx2 ../srcimages/level0.ppm && $<TARGET_FILE:ktx2img> ktx2img.rt.ktx2 && $<TARGET_FILE:toktx> --test --t2 ktx2img.rt2.ktx2 ktx2img.rt.png && diff ktx2img.rt.ktx2 ktx2img.rt2.ktx2 && rm ktx2img.rt.ktx2 ktx2img.rt2.ktx2 ktx2img.rt.png"
+    WORKING_DIRECTORY ${IMG_DIR}
+)
+
+# Transcode and extract a single level of a mipmapped UASTC file.
+add_test( NAME ktx2img-uastc-level
+    COMMAND ${BASH_EXECUTABLE} -c "$<TARGET_FILE:toktx> --test --t2 --genmipmap --encode uastc ktx2img.uastc.ktx2 ../srcimages/level0.ppm && $<TARGET_FILE:ktx2img> --level 2 --threads 2 ktx2img.uastc.ktx2 && test -f ktx2img.uastc_level2.png && ! test -f ktx2img.uastc_level0.png && rm ktx2img.uastc.ktx2 ktx2img.uastc_level2.png"
+    WORKING_DIRECTORY ${IMG_DIR}
+)
+
+# Extract a 1x1 R32G32B32A32_SFLOAT image, made with dds2ktx2 from a legacy
+# DDS file with FourCC 116, to an OpenEXR file. The texel is too small for
+# ZIP to shrink so the file ends with the uncompressed channels in A, B, G,
+# R order: 1.0, 2.0, 0.5, 1.0.
+add_test( NAME ktx2img-float-exr
+    COMMAND ${BASH_EXECUTABLE} -c "{ printf 'DDS \\x7c\\x00\\x00\\x00\\x07\\x10\\x00\\x00\\x01\\x00\\x00\\x00\\x01\\x00\\x00\\x00' && head -c 56 /dev/zero && printf '\\x20\\x00\\x00\\x00\\x04\\x00\\x00\\x00\\x74\\x00\\x00\\x00' && head -c 20 /dev/zero && printf '\\x00\\x10\\x00\\x00' && head -c 16 /dev/zero && printf '\\x00\\x00\\x80\\x3f\\x00\\x00\\x00\\x3f\\x00\\x00\\x00\\x40\\x00\\x00\\x80\\x3f'; } > ktx2img.float.dds && $<TARGET_FILE:dds2ktx2> -o ktx2img.float.ktx2 ktx2img.float.dds && $<TARGET_FILE:ktx2img> ktx2img.float.ktx2 && test $(head -c 4 ktx2img.float.exr | od -An -tx1 | tr -d ' \\n') = 762f3101 && test $(tail -c 16 ktx2img.float.exr | od -An -tx1 | tr -d ' \\n') = 0000803f000000400000003f0000803f && rm ktx2img.float.dds ktx2img.float.ktx2 ktx2img.float.exr"
+    WORKING_DIRECTORY ${IMG_DIR}
+)
+
+# Extract a 1x1 R16G16B16A16_UNORM image, made with dds2ktx2 from a legacy
+# DDS file with FourCC 36, to a 16-bit RGBA PNG: bit depth 16 and colour
+# type 6 in its IHDR. The row is too small for deflate to shrink so it is
+# stored as is, Up filter byte then big-endian components.
+add_test( NAME ktx2img-16bit-png
+    COMMAND ${BASH_EXECUTABLE} -c "{ printf 'DDS \\x7c\\x00\\x00\\x00\\x07\\x10\\x00\\x00\\x01\\x00\\x00\\x00\\x01\\x00\\x00\\x00' && head -c 56 /dev/zero && printf '\\x20\\x00\\x00\\x00\\x04\\x00\\x00\\x00\\x24\\x00\\x00\\x00' && head -c 20 /dev/zero && printf '\\x00\\x10\\x00\\x00' && head -c 16 /dev/zero && printf '\\x34\\x12\\x78\\x56\\xbc\\x9a\\xf0\\xde'; } > ktx2img.16bit.dds && $<TARGET_FILE:dds2ktx2> -o ktx2img.16bit.ktx2 ktx2img.16bit.dds && $<TARGET_FILE:ktx2img> ktx2img.16bit.ktx2 && test $(head -c 26 ktx2img.16bit.png | tail -c 2 | od -An -tx1 | tr -d ' \\n') = 1006 && od -An -tx1 ktx2img.16bit.png | tr -d ' \\n' | grep -q 02123456789abcdef0 && rm ktx2img.16bit.dds ktx2img.16bit.ktx2 ktx2img.16bit.png"
+    WORKING_DIRECTORY ${IMG_DIR}
+)
+
+# Extract several files in one run. A missing file among them is reported
+# but does not stop the others being extracted.
+add_test( NAME ktx2img-many-files
+    COMMAND ${BASH_EXECUTABLE} -c "$<TARGET_FILE:toktx> --test --t2 ktx2img.many1.ktx2 ../srcimages/level0.ppm && $<TARGET_FILE:toktx> --test --t2 ktx2img.many2.ktx2 ../srcimages/level1.ppm && $<TARGET_FILE:toktx> --test --t2 ktx2img.many3.ktx2 ../srcimages/level2.ppm && ! $<TARGET_FILE:ktx2img> --threads 2 ktx2img.many1.ktx2 ktx2img.missing.ktx2 ktx2img.many2.ktx2 ktx2img.many3.ktx2 2> ktx2img.many.err && grep -q ktx2img.missing.ktx2 ktx2img.many.err && test -f ktx2img.many1.png && test -f ktx2img.many2.png && test -f ktx2img.many3.png && rm ktx2img.many1.ktx2 ktx2img.many2.ktx2 ktx2img.many3.ktx2 ktx2img.many1.png ktx2img.many2.png ktx2img.many3.png ktx2img.many.err"
+    WORKING_DIRECTORY ${IMG_DIR}
+)
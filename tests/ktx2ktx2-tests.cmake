@@ -106,3 +106,10 @@ cnvrtcmpktx( 2d-bc2 pattern_02_bc2.ktx2 pattern_02_bc2.ktx "-f" )
 cnvrtcmpktx( 2d-array-astc texturearray_astc_8x8_unorm.ktx2 texturearray_astc_8x8_unorm.ktx "-f" )
 
 cnvrtcmpktx_implied_out( 2d-bc2 pattern_02_bc2 "-f" )
+
+# .basis files are repacked, in parallel when there are several, so check
+# each output is valid.
+add_test( NAME ktx2ktx2-repack-basis
+    COMMAND ${BASH_EXECUTABLE} -c "cp color_grid.basis ktx2ktx2.rp.color_grid.basis && cp alpha_simple.basis ktx2ktx2.rp.alpha_simple.basis && $<TARGET_FILE:ktx2ktx2> --test --threads 2 ktx2ktx2.rp.color_grid.basis ktx2ktx2.rp.alpha_simple.basis && rm ktx2ktx2.rp.color_grid.basis ktx2ktx2.rp.alpha_simple.basis && $<TARGET_FILE:ktx2check> ktx2ktx2.rp.color_grid.ktx2 ktx2ktx2.rp.alpha_simple.ktx2 && rm ktx2ktx2.rp.color_grid.ktx2 ktx2ktx2.rp.alpha_simple.ktx2"
+    WORKING_DIRECTORY ${IMG_DIR}
+)
@@ -23,10 +23,18 @@
   #endif
 #endif
 
+#include <algorithm>
 #include <string>
+#include <vector>
 #include <limits.h>
 #include <stdint.h>
 #include <string.h>
+#if !defined(_WIN32)
+  #include <sys/wait.h>
+  #include <unistd.h>
+#endif
+#include "vk_funcs.h"   // Must be included before ktxvulkan.h & vk_format.h.
+#include "ktxvulkan.h"
 #include "GL/glcorearb.h"
 #include "ktx.h"
 #include "ktxint.h"
@@ -36,6 +44,10 @@
 #include "gtest/gtest.h"
 #include "wthelper.h"
 #include "vk_format.h"
+extern "C" {
+  #include "memstream.h"
+  #include "vkformat_convert.h"
+}
 
 #define ROUNDING(x) \
         (3 - ((x + KTX_GL_UNPACK_ALIGNMENT-1) % KTX_GL_UNPACK_ALIGNMENT));
@@ -315,6 +327,17 @@ class ktxTextureTestBase : public ::testing::Test {
                                      faceLodSize, pixels);
     }
 
+    static KTX_error_code
+    imageIterCallback(int miplevel, int /*layer*/, int faceSlice,
+                      int width, int height,
+                      ktx_uint64_t imageSize,
+                      void* pixels, void* userdata)
+    {
+        ktxTextureTestBase* fixture = (ktxTextureTestBase*)userdata;
+        return fixture->iterCallback(miplevel, faceSlice, width, height, 1,
+                                     imageSize, pixels);
+    }
+
     TextureWriterTestHelper<component_type, numComponents, internalformat> helper;
     wthTexInfo& texinfo = helper.texinfo;
     ktxTextureCreateInfo& createInfo = helper.createInfo;
@@ -329,7 +352,7 @@ class ktxTextureTestBase : public ::testing::Test {
 
     ktx_size_t paddedImageDataSize;
     ktx_size_t& imageDataSize = helper.imageDataSize;
-    std::vector< std::vector < std::vector < std::vector<GLubyte>  > > >& imageData = helper.images;
+    std::vector< std::vector < std::vector < std::vector<component_type>  > > >& imageData = helper.images;
 
     std::vector<wthImageInfo>& images = helper.imageList;
 };
@@ -526,6 +549,7 @@ class ktxTexture2_IterateLevelFacesTest : public ktxTexture2TestBase<GLubyte, 4,
 class ktxTexture2_IterateLevelsTest : public ktxTexture2TestBase<GLubyte, 4, GL_RGBA8> { };
 class ktxTexture2_LoadImageDataTest : public ktxTexture2TestBase<GLubyte, 4, GL_RGBA8> { };
 class ktxTexture2_CreateCopyTest: public ktxTexture2TestBase<GLubyte, 4, GL_RGBA8> { };
+class ktxTexture2_IterateLoadImagesTest : public ktxTexture2TestBase<GLubyte, 4, GL_RGBA8>  { };
 
 /////////////////////////////////////////
 // ktxTexture_Create tests
@@ -919,6 +943,138 @@ TEST_F(ktxTexture2_IterateLevelFacesTest, IterateImages) {
     }
 }
 
+/////////////////////////////////////////
+// ktxTexture2_IterateLoadImages tests
+////////////////////////////////////////
+
+// Check that ktxTexture2_IterateLoadImages passes each image of the KTX2
+// file in @a file with the same bytes as ktxTexture2_LoadImageData loads.
+static void
+compareIterateLoadImages(const ktx_uint8_t* file, ktx_size_t fileLen)
+{
+    struct loadedImage {
+        int level, layer, faceSlice;
+        std::vector<ktx_uint8_t> data;
+    };
+    ktxTexture2* loaded;
+    ktxTexture2* iterated;
+    std::vector<loadedImage> images;
+
+    ASSERT_EQ(ktxTexture2_CreateFromMemory(file, fileLen,
+                                           KTX_TEXTURE_CREATE_NO_FLAGS,
+                                           &loaded), KTX_SUCCESS);
+    ASSERT_EQ(ktxTexture2_LoadImageData(loaded, nullptr, 0), KTX_SUCCESS);
+    ASSERT_EQ(ktxTexture2_CreateFromMemory(file, fileLen,
+                                           KTX_TEXTURE_CREATE_NO_FLAGS,
+                                           &iterated), KTX_SUCCESS);
+    auto collect = [](int miplevel, int layer, int faceSlice, int, int,
+                      ktx_uint64_t imageSize, void* pixels, void* userdata) {
+        auto* pImages = (std::vector<loadedImage>*)userdata;
+        const ktx_uint8_t* bytes = (const ktx_uint8_t*)pixels;
+        pImages->push_back({ miplevel, layer, faceSlice,
+                           std::vector<ktx_uint8_t>(bytes, bytes + imageSize) });
+        return KTX_SUCCESS;
+    };
+    EXPECT_EQ(ktxTexture2_IterateLoadImages(iterated, collect, &images),
+              KTX_SUCCESS);
+
+    ktx_size_t expectedImages = 0;
+    for (ktx_uint32_t level = 0; level < loaded->numLevels; level++) {
+        expectedImages += loaded->numLayers * loaded->numFaces
+                        * std::max(loaded->baseDepth >> level, 1U);
+    }
+    EXPECT_EQ(images.size(), expectedImages);
+    for (const loadedImage& image : images) {
+        ktx_size_t offset;
+        ASSERT_EQ(ktxTexture_GetImageOffset(ktxTexture(loaded), image.level,
+                                            image.layer, image.faceSlice,
+                                            &offset), KTX_SUCCESS);
+        ASSERT_EQ(image.data.size(),
+                  ktxTexture_GetImageSize(ktxTexture(loaded), image.level));
+        EXPECT_EQ(memcmp(image.data.data(), loaded->pData + offset,
+                         image.data.size()), 0)
+                  << "level " << image.level << " layer " << image.layer
+                  << " face/slice " << image.faceSlice;
+    }
+    ktxTexture_Destroy(ktxTexture(iterated));
+    ktxTexture_Destroy(ktxTexture(loaded));
+}
+
+TEST_F(ktxTexture2_IterateLoadImagesTest, InvalidOpWhenDataAlreadyLoaded) {
+    ktxTexture2* texture;
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                              KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                              &texture);
+        ASSERT_TRUE(result == KTX_SUCCESS);
+        EXPECT_EQ(ktxTexture2_IterateLoadImages(texture, imageIterCallback,
+                                                this),
+                  KTX_INVALID_OPERATION);
+        ktxTexture_Destroy(ktxTexture(texture));
+    }
+}
+
+TEST_F(ktxTexture2_IterateLoadImagesTest, IterateImages) {
+    ktxTexture2* texture;
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                              KTX_TEXTURE_CREATE_NO_FLAGS,
+                                              &texture);
+        ASSERT_TRUE(result == KTX_SUCCESS);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture2_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+
+        EXPECT_EQ(ktxTexture2_IterateLoadImages(texture, imageIterCallback,
+                                                this),
+                  KTX_SUCCESS);
+        EXPECT_EQ(iterCbCalls, mipLevels)
+                  << "No. of calls to iterCallback differs from number of mip levels";
+        ktxTexture_Destroy(ktxTexture(texture));
+    }
+}
+
+TEST_F(ktxTexture2_IterateLoadImagesTest, IterateImagesZstd) {
+    ktxTexture2* texture;
+    ktxStream dststr;
+    ktx_uint8_t* pDeflatedFile;
+    ktx_size_t deflatedFileLen;
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                              KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                              &texture);
+        ASSERT_TRUE(result == KTX_SUCCESS);
+        ASSERT_EQ(ktxMemStream_construct(&dststr, KTX_FALSE), KTX_SUCCESS);
+        EXPECT_EQ(ktxTexture2_DeflateZstdToStream(NULL, &dststr, 3),
+                  KTX_INVALID_VALUE);
+        ASSERT_EQ(ktxTexture2_DeflateZstdToStream(texture, &dststr, 3),
+                  KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+        ktxMemStream_getdata(&dststr, &pDeflatedFile);
+        dststr.getsize(&dststr, &deflatedFileLen);
+        ktxMemStream_destruct(&dststr);
+
+        result = ktxTexture2_CreateFromMemory(pDeflatedFile, deflatedFileLen,
+                                              KTX_TEXTURE_CREATE_NO_FLAGS,
+                                              &texture);
+        ASSERT_EQ(result, KTX_SUCCESS);
+        EXPECT_EQ(texture->supercompressionScheme, KTX_SS_ZSTD);
+        EXPECT_EQ(ktxTexture2_IterateLoadImages(texture, imageIterCallback,
+                                                this),
+                  KTX_SUCCESS);
+        EXPECT_EQ(iterCbCalls, mipLevels)
+                  << "No. of calls to iterCallback differs from number of mip levels";
+        ktxTexture_Destroy(ktxTexture(texture));
+        compareIterateLoadImages(pDeflatedFile, deflatedFileLen);
+        free(pDeflatedFile);
+    }
+}
+
 /////////////////////////////////////////
 // ktxTexture_IterateLevels tests
 ////////////////////////////////////////
@@ -2299,6 +2455,2362 @@ TEST_F(ktxTexture2_BasisCompressTest, Compress) {
     }
 }
 
+TEST_F(ktxTexture2_BasisCompressTest, TranscodeInPlace) {
+    const ktx_transcode_fmt_e formats[] = {
+        KTX_TTF_BC7_RGBA, KTX_TTF_ASTC_4x4_RGBA, KTX_TTF_BC1_RGB,
+        KTX_TTF_ETC2_EAC_R11
+    };
+    ktxBasisParams cparams = { };
+    cparams.structSize = sizeof(cparams);
+    cparams.uastc = KTX_TRUE;
+
+    if (ktxMemFile == NULL)
+        return;
+    for (ktx_transcode_fmt_e format : formats) {
+        ktxTexture2* texture;
+        ktxTexture2* reference;
+        ASSERT_EQ(ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                        KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                        &texture), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_CompressBasisEx(texture, &cparams), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_CreateCopy(texture, &reference), KTX_SUCCESS);
+
+        ktx_uint8_t* pData = texture->pData;
+        ASSERT_EQ(ktxTexture2_TranscodeBasis(texture, format,
+                                             KTX_TF_TRANSCODE_IN_PLACE),
+                  KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_TranscodeBasis(reference, format, 0),
+                  KTX_SUCCESS);
+        if (format != KTX_TTF_BC1_RGB && format != KTX_TTF_ETC2_EAC_R11) {
+            // Same block size so no reallocation.
+            EXPECT_EQ(texture->pData, pData);
+        }
+        EXPECT_EQ(texture->vkFormat, reference->vkFormat);
+        ASSERT_EQ(texture->dataSize, reference->dataSize) << format;
+        for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+            ASSERT_EQ(ktxTexture2_levelDataOffset(texture, level),
+                      ktxTexture2_levelDataOffset(reference, level));
+        }
+        EXPECT_EQ(memcmp(texture->pData, reference->pData,
+                         texture->dataSize), 0) << format;
+        ktxTexture_Destroy(ktxTexture(texture));
+        ktxTexture_Destroy(ktxTexture(reference));
+    }
+}
+
+TEST_F(ktxTexture2_BasisCompressTest, TranscodeMultithread) {
+    const ktx_transcode_fmt_e formats[] = {
+        KTX_TTF_RGBA32, KTX_TTF_RGB565, KTX_TTF_BGR565, KTX_TTF_RGBA4444,
+        KTX_TTF_BC7_RGBA
+    };
+
+    if (ktxMemFile == NULL)
+        return;
+    for (ktx_bool_t uastc : { KTX_FALSE, KTX_TRUE }) {
+        ktxBasisParams cparams = { };
+        cparams.structSize = sizeof(cparams);
+        cparams.uastc = uastc;
+        for (ktx_transcode_fmt_e format : formats) {
+            ktxTexture2* texture;
+            ktxTexture2* reference;
+            ASSERT_EQ(ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                        KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                        &texture), KTX_SUCCESS);
+            ASSERT_EQ(ktxTexture2_CompressBasisEx(texture, &cparams),
+                      KTX_SUCCESS);
+            ASSERT_EQ(ktxTexture2_CreateCopy(texture, &reference),
+                      KTX_SUCCESS);
+
+            ASSERT_EQ(ktxTexture2_TranscodeBasis(texture, format,
+                                                 KTX_TF_MULTITHREAD),
+                      KTX_SUCCESS);
+            ASSERT_EQ(ktxTexture2_TranscodeBasis(reference, format, 0),
+                      KTX_SUCCESS);
+            EXPECT_EQ(texture->vkFormat, reference->vkFormat);
+            ASSERT_EQ(texture->dataSize, reference->dataSize) << format;
+            for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+                ktx_size_t offset;
+                ktxTexture_GetImageOffset(ktxTexture(texture), level, 0, 0,
+                                          &offset);
+                // Compare the images, not the padding between levels.
+                ktx_size_t levelSize
+                        = ktxTexture_GetImageSize(ktxTexture(texture), level)
+                        * texture->numLayers * texture->numFaces;
+                EXPECT_EQ(memcmp(texture->pData + offset,
+                                 reference->pData + offset, levelSize), 0)
+                                 << format << " level " << level;
+            }
+            ktxTexture_Destroy(ktxTexture(texture));
+            ktxTexture_Destroy(ktxTexture(reference));
+        }
+    }
+}
+
+// Decode each level of @a texture, which must not be supercompressed, to
+// RGBA8 texels with the sampler, which doesn't use the transcoder.
+static std::vector<std::vector<ktx_uint8_t>>
+sampleLevels(ktxTexture2* texture)
+{
+    std::vector<std::vector<ktx_uint8_t>> levels(texture->numLevels);
+    ktxSamplerParams params;
+    ktxTextureSampler* sampler;
+
+    memset(&params, 0, sizeof(params));
+    params.structSize = sizeof(params);
+    if (ktxTexture2_CreateSampler(texture, &params, &sampler) != KTX_SUCCESS)
+        return levels;
+    for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+        ktx_uint32_t width = std::max(texture->baseWidth >> level, 1U);
+        ktx_uint32_t height = std::max(texture->baseHeight >> level, 1U);
+        for (ktx_uint32_t y = 0; y < height; y++) {
+            for (ktx_uint32_t x = 0; x < width; x++) {
+                float rgba[4];
+                ktxTextureSampler_Sample(sampler, 0, 0, (x + 0.5f) / width,
+                                         (y + 0.5f) / height, (float)level,
+                                         rgba);
+                for (float c : rgba)
+                    levels[level].push_back((ktx_uint8_t)(c * 255 + 0.5f));
+            }
+        }
+    }
+    ktxTextureSampler_Destroy(sampler);
+    return levels;
+}
+
+// Multithreaded transcoding splits images into bands of 16 block rows. Use
+// images taller than one band, with a partial last band and partial blocks
+// at the edges, and check the uncompressed targets against texels decoded
+// without the transcoder's row writers.
+TEST(ktxTexture2_TranscodeBasisTest, MultithreadBands) {
+    ktxTextureCreateInfo createInfo;
+    createInfo.vkFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    createInfo.baseWidth = 37;
+    createInfo.baseHeight = 150;
+    createInfo.baseDepth = 1;
+    createInfo.numDimensions = 2;
+    createInfo.numLevels = 3;
+    createInfo.numLayers = 1;
+    createInfo.numFaces = 1;
+    createInfo.isArray = KTX_FALSE;
+    createInfo.generateMipmaps = KTX_FALSE;
+
+    // mul_8 from the transcoder: v * q / 255, rounded.
+    auto quantize = [](ktx_uint32_t v, ktx_uint32_t q) {
+        v = v * q + 128;
+        return (v + (v >> 8)) >> 8;
+    };
+    const ktx_transcode_fmt_e formats[] = {
+        KTX_TTF_RGBA32, KTX_TTF_RGB565, KTX_TTF_BGR565, KTX_TTF_RGBA4444
+    };
+
+    for (ktx_bool_t uastc : { KTX_FALSE, KTX_TRUE }) {
+        ktxTexture2* source;
+        ASSERT_EQ(ktxTexture2_Create(&createInfo,
+                                     KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+                                     &source), KTX_SUCCESS);
+        for (ktx_uint32_t level = 0; level < createInfo.numLevels; level++) {
+            ktx_uint32_t width = std::max(createInfo.baseWidth >> level, 1U);
+            ktx_uint32_t height = std::max(createInfo.baseHeight >> level, 1U);
+            ktx_size_t offset;
+            ktxTexture_GetImageOffset(ktxTexture(source), level, 0, 0, &offset);
+            ktx_uint8_t* texel = source->pData + offset;
+            for (ktx_uint32_t y = 0; y < height; y++) {
+                for (ktx_uint32_t x = 0; x < width; x++) {
+                    *texel++ = (ktx_uint8_t)(x * 7 + y * 3);
+                    *texel++ = (ktx_uint8_t)(x * y);
+                    *texel++ = (ktx_uint8_t)(255 - y);
+                    *texel++ = (ktx_uint8_t)(x * 11 + y * 5);
+                }
+            }
+        }
+        ktxBasisParams cparams = { };
+        cparams.structSize = sizeof(cparams);
+        cparams.uastc = uastc;
+        ASSERT_EQ(ktxTexture2_CompressBasisEx(source, &cparams), KTX_SUCCESS);
+
+        std::vector<std::vector<ktx_uint8_t>> expected;
+        if (uastc) {
+            expected = sampleLevels(source);
+        } else {
+            // ETC1S transcodes to ETC1 without loss. Get the alpha slices
+            // from a second transcode that puts them in the color.
+            ktxTexture2* etc1;
+            ASSERT_EQ(ktxTexture2_CreateCopy(source, &etc1), KTX_SUCCESS);
+            ASSERT_EQ(ktxTexture2_TranscodeBasis(etc1, KTX_TTF_ETC1_RGB, 0),
+                      KTX_SUCCESS);
+            expected = sampleLevels(etc1);
+            ktxTexture_Destroy(ktxTexture(etc1));
+            ASSERT_EQ(ktxTexture2_CreateCopy(source, &etc1), KTX_SUCCESS);
+            ASSERT_EQ(ktxTexture2_TranscodeBasis(etc1, KTX_TTF_ETC1_RGB,
+                             KTX_TF_TRANSCODE_ALPHA_DATA_TO_OPAQUE_FORMATS),
+                      KTX_SUCCESS);
+            std::vector<std::vector<ktx_uint8_t>> alpha = sampleLevels(etc1);
+            ktxTexture_Destroy(ktxTexture(etc1));
+            for (size_t level = 0; level < expected.size(); level++) {
+                ASSERT_EQ(alpha[level].size(), expected[level].size());
+                for (size_t i = 0; i < expected[level].size(); i += 4)
+                    expected[level][i + 3] = alpha[level][i + 1];
+            }
+        }
+        ASSERT_EQ(expected.size(), createInfo.numLevels);
+
+        for (ktx_transcode_fmt_e format : formats) {
+            ktxTexture2* texture;
+            ASSERT_EQ(ktxTexture2_CreateCopy(source, &texture), KTX_SUCCESS);
+            ASSERT_EQ(ktxTexture2_TranscodeBasis(texture, format,
+                                                 KTX_TF_MULTITHREAD),
+                      KTX_SUCCESS);
+            for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+                ktx_size_t offset;
+                ktxTexture_GetImageOffset(ktxTexture(texture), level, 0, 0,
+                                          &offset);
+                const ktx_uint8_t* texel = texture->pData + offset;
+                const std::vector<ktx_uint8_t>& e = expected[level];
+                ASSERT_EQ(ktxTexture_GetImageSize(ktxTexture(texture), level),
+                          e.size() / (format == KTX_TTF_RGBA32 ? 1 : 2));
+                ktx_uint32_t mismatches = 0;
+                for (size_t i = 0; i < e.size(); i += 4) {
+                    if (format == KTX_TTF_RGBA32) {
+                        mismatches += memcmp(texel, &e[i], 4) != 0;
+                        texel += 4;
+                        continue;
+                    }
+                    ktx_uint32_t packed;
+                    if (format == KTX_TTF_RGB565)
+                        packed = quantize(e[i], 31) << 11
+                               | quantize(e[i + 1], 63) << 5
+                               | quantize(e[i + 2], 31);
+                    else if (format == KTX_TTF_BGR565)
+                        packed = quantize(e[i + 2], 31) << 11
+                               | quantize(e[i + 1], 63) << 5
+                               | quantize(e[i], 31);
+                    else
+                        packed = quantize(e[i], 15) << 12
+                               | quantize(e[i + 1], 15) << 8
+                               | quantize(e[i + 2], 15) << 4
+                               | quantize(e[i + 3], 15);
+                    mismatches += (ktx_uint32_t)(texel[0] | texel[1] << 8) != packed;
+                    texel += 2;
+                }
+                EXPECT_EQ(mismatches, 0U) << (uastc ? "UASTC " : "ETC1S ")
+                                          << format << " level " << level;
+            }
+            ktxTexture_Destroy(ktxTexture(texture));
+        }
+        ktxTexture_Destroy(ktxTexture(source));
+    }
+}
+
+TEST_F(ktxTexture2_BasisCompressTest, DecodeBlockCompressed) {
+    ktxTexture2* texture;
+    ktxTexture2* reference;
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                              KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                              &texture);
+        ASSERT_EQ(result, KTX_SUCCESS);
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                              KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                              &reference);
+        ASSERT_EQ(result, KTX_SUCCESS);
+
+        EXPECT_EQ(ktxTexture2_DecodeBlockCompressed(texture, 1),
+                  KTX_INVALID_OPERATION);
+        ASSERT_EQ(ktxTexture2_CompressBasis(texture, 0), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_CompressBasis(reference, 0), KTX_SUCCESS);
+        // ETC1S transcodes losslessly to ETC1 so decoding the ETC1 blocks
+        // must give the same pixels as transcoding to RGBA32.
+        ASSERT_EQ(ktxTexture2_TranscodeBasis(texture, KTX_TTF_ETC1_RGB, 0),
+                  KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_TranscodeBasis(reference, KTX_TTF_RGBA32, 0),
+                  KTX_SUCCESS);
+
+        result = ktxTexture2_DecodeBlockCompressed(texture, 4);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        EXPECT_FALSE(texture->isCompressed);
+        EXPECT_EQ(texture->vkFormat,
+                  reference->vkFormat == VK_FORMAT_R8G8B8A8_SRGB
+                  ? VK_FORMAT_R8G8B8_SRGB : VK_FORMAT_R8G8B8_UNORM);
+        for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+            ktx_size_t offset, refOffset;
+            ktxTexture_GetImageOffset(ktxTexture(texture), level, 0, 0,
+                                      &offset);
+            ktxTexture_GetImageOffset(ktxTexture(reference), level, 0, 0,
+                                      &refOffset);
+            ktx_size_t pixels = ktxTexture_GetImageSize(ktxTexture(texture),
+                                                        level) / 3;
+            ASSERT_EQ(pixels * 4,
+                      ktxTexture_GetImageSize(ktxTexture(reference), level));
+            for (ktx_size_t i = 0; i < pixels; i++) {
+                EXPECT_EQ(memcmp(texture->pData + offset + i * 3,
+                                 reference->pData + refOffset + i * 4, 3), 0)
+                    << "level " << level << " pixel " << i;
+            }
+        }
+        ktxTexture_Destroy(ktxTexture(texture));
+        ktxTexture_Destroy(ktxTexture(reference));
+    }
+}
+
+TEST_F(ktxTexture2_CreateTest, DecodeBlockCompressedUnsupported) {
+    ASSERT_EQ(create(VK_FORMAT_BC6H_UFLOAT_BLOCK, 16, 16, 1, 2, 1),
+              KTX_SUCCESS);
+    EXPECT_EQ(ktxTexture2_DecodeBlockCompressed(texture, 1),
+              KTX_UNSUPPORTED_TEXTURE_TYPE);
+}
+
+TEST_F(ktxTexture2_BasisCompressTest, DecodeBlockCompressedFromUastc) {
+    // Decoding the transcoded blocks must give nearly the same pixels as
+    // transcoding directly to RGBA32. BC7 and ASTC 4x4 are close to exact.
+    // The other transcoders approximate the UASTC endpoints.
+    const struct {
+        ktx_transcode_fmt_e format;
+        ktx_uint32_t components;
+        int tolerance;
+    } targets[] = {
+        { KTX_TTF_BC7_RGBA, 4, 2 },
+        { KTX_TTF_ASTC_4x4_RGBA, 4, 2 },
+        { KTX_TTF_ETC2_RGBA, 4, 4 },
+        { KTX_TTF_BC3_RGBA, 4, 4 },
+        { KTX_TTF_BC4_R, 1, 2 },
+        { KTX_TTF_BC5_RG, 2, 2 },
+        { KTX_TTF_ETC2_EAC_R11, 1, 2 },
+        { KTX_TTF_ETC2_EAC_RG11, 2, 2 },
+    };
+    ktxBasisParams cparams = { };
+    cparams.structSize = sizeof(cparams);
+    cparams.uastc = KTX_TRUE;
+
+    if (ktxMemFile == NULL)
+        return;
+    for (const auto& target : targets) {
+        ktxTexture2* texture;
+        ktxTexture2* reference;
+        ASSERT_EQ(ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                        KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                        &texture), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_CompressBasisEx(texture, &cparams), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_CreateCopy(texture, &reference), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_TranscodeBasis(texture, target.format, 0),
+                  KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_TranscodeBasis(reference, KTX_TTF_RGBA32, 0),
+                  KTX_SUCCESS);
+        // More than 1 thread so astcenc runs with a context per worker.
+        ASSERT_EQ(ktxTexture2_DecodeBlockCompressed(texture, 4), KTX_SUCCESS)
+            << target.format;
+        EXPECT_FALSE(texture->isCompressed);
+
+        int maxDiff = 0;
+        for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+            ktx_size_t offset, refOffset;
+            ktxTexture_GetImageOffset(ktxTexture(texture), level, 0, 0,
+                                      &offset);
+            ktxTexture_GetImageOffset(ktxTexture(reference), level, 0, 0,
+                                      &refOffset);
+            ktx_size_t pixels = ktxTexture_GetImageSize(ktxTexture(reference),
+                                                        level) / 4;
+            ASSERT_EQ(pixels * target.components,
+                      ktxTexture_GetImageSize(ktxTexture(texture), level));
+            for (ktx_size_t i = 0; i < pixels; i++) {
+                for (ktx_uint32_t c = 0; c < target.components; c++) {
+                    int diff = texture->pData[offset + i * target.components + c]
+                             - reference->pData[refOffset + i * 4 + c];
+                    maxDiff = std::max(maxDiff, std::abs(diff));
+                }
+            }
+        }
+        EXPECT_LE(maxDiff, target.tolerance) << target.format;
+        ktxTexture_Destroy(ktxTexture(texture));
+        ktxTexture_Destroy(ktxTexture(reference));
+    }
+}
+
+TEST_F(ktxTexture2_CreateTest, DecodeBlockCompressedBC2) {
+    // Explicit alpha rising from 0 to 15 in pixel order followed by a BC1
+    // block with color0 red and all selectors 0.
+    const ktx_uint8_t block[16] = {
+        0x10, 0x32, 0x54, 0x76, 0x98, 0xba, 0xdc, 0xfe,
+        0x00, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+    };
+
+    ASSERT_EQ(create(VK_FORMAT_BC2_UNORM_BLOCK, 4, 4), KTX_SUCCESS);
+    memcpy(texture->pData, block, sizeof(block));
+    ASSERT_EQ(ktxTexture2_DecodeBlockCompressed(texture, 1), KTX_SUCCESS);
+    EXPECT_EQ(texture->vkFormat, VK_FORMAT_R8G8B8A8_UNORM);
+    for (ktx_uint32_t i = 0; i < 16; i++) {
+        EXPECT_EQ(texture->pData[i * 4 + 0], 255) << i;
+        EXPECT_EQ(texture->pData[i * 4 + 1], 0) << i;
+        EXPECT_EQ(texture->pData[i * 4 + 2], 0) << i;
+        EXPECT_EQ(texture->pData[i * 4 + 3], i * 17) << i;
+    }
+}
+
+TEST_F(ktxTexture2_CreateTest, DecodeBlockCompressedETC2A1) {
+    // Differential mode red base color with the opaque bit clear. Selector
+    // 2, which is transparent black in this mode, is used for column 0 and
+    // selector 0, the unmodified base color, for the others.
+    const ktx_uint8_t block[8] = {
+        0xf8, 0x00, 0x00, 0x00, 0x00, 0x0f, 0x00, 0x00
+    };
+
+    ASSERT_EQ(create(VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK, 4, 4),
+              KTX_SUCCESS);
+    memcpy(texture->pData, block, sizeof(block));
+    ASSERT_EQ(ktxTexture2_DecodeBlockCompressed(texture, 1), KTX_SUCCESS);
+    EXPECT_EQ(texture->vkFormat, VK_FORMAT_R8G8B8A8_UNORM);
+    for (ktx_uint32_t y = 0; y < 4; y++) {
+        for (ktx_uint32_t x = 0; x < 4; x++) {
+            const ktx_uint8_t* pixel = texture->pData + (y * 4 + x) * 4;
+            const ktx_uint8_t expected = x == 0 ? 0 : 255;
+            EXPECT_EQ(pixel[0], expected) << x << "," << y;
+            EXPECT_EQ(pixel[1], 0) << x << "," << y;
+            EXPECT_EQ(pixel[2], 0) << x << "," << y;
+            EXPECT_EQ(pixel[3], expected) << x << "," << y;
+        }
+    }
+}
+
+TEST_F(ktxTexture2_BasisCompressTest, SampleBlockCompressed) {
+    ktxTexture2* texture;
+    ktxTexture2* reference;
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        for (ktxTexture2** t : { &texture, &reference }) {
+            result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                       KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                       t);
+            ASSERT_EQ(result, KTX_SUCCESS);
+            ASSERT_EQ(ktxTexture2_CompressBasis(*t, 0), KTX_SUCCESS);
+            ASSERT_EQ(ktxTexture2_TranscodeBasis(*t, KTX_TTF_ETC1_RGB, 0),
+                      KTX_SUCCESS);
+        }
+        ASSERT_EQ(ktxTexture2_DecodeBlockCompressed(reference, 1),
+                  KTX_SUCCESS);
+        bool sRGB = reference->vkFormat == VK_FORMAT_R8G8B8_SRGB;
+
+        ktxSamplerParams params;
+        memset(&params, 0, sizeof(params));
+        params.structSize = sizeof(params);
+        // Small enough that blocks are evicted.
+        params.cacheBlocks = 4;
+        ktxTextureSampler* sampler;
+        ASSERT_EQ(ktxTexture2_CreateSampler(texture, &params, &sampler),
+                  KTX_SUCCESS);
+        // Point samples at texel centres must match the decoded texture.
+        for (ktx_uint32_t level = 0; level < std::min(texture->numLevels, 2U);
+             level++) {
+            ktx_uint32_t width = std::max(1U, texture->baseWidth >> level);
+            ktx_uint32_t height = std::max(1U, texture->baseHeight >> level);
+            ktx_size_t offset;
+            ktxTexture_GetImageOffset(ktxTexture(reference), level, 0, 0,
+                                      &offset);
+            for (ktx_uint32_t y = 0; y < height; y++) {
+                for (ktx_uint32_t x = 0; x < width; x++) {
+                    float rgba[4];
+                    ASSERT_EQ(ktxTextureSampler_Sample(sampler, 0, 0,
+                                                       (x + 0.5f) / width,
+                                                       (y + 0.5f) / height,
+                                                       (float)level, rgba),
+                              KTX_SUCCESS);
+                    const ktx_uint8_t* texel = reference->pData + offset
+                                             + (y * width + x) * 3;
+                    for (ktx_uint32_t c = 0; c < 3; c++) {
+                        float v = texel[c] / 255.0f;
+                        if (sRGB)
+                            v = v <= 0.04045f ? v / 12.92f
+                                : std::pow((v + 0.055f) / 1.055f, 2.4f);
+                        EXPECT_NEAR(rgba[c], v, 1e-6f)
+                            << "level " << level << " texel " << x << ","
+                            << y;
+                    }
+                    EXPECT_EQ(rgba[3], 1.0f);
+                }
+            }
+        }
+        ktxTextureSampler_Destroy(sampler);
+        ktxTexture_Destroy(ktxTexture(texture));
+        ktxTexture_Destroy(ktxTexture(reference));
+    }
+}
+
+TEST_F(ktxTexture2_CreateTest, SampleFilters) {
+    ASSERT_EQ(create(VK_FORMAT_R8G8B8A8_UNORM, 4, 4, 1, 2, 2), KTX_SUCCESS);
+    ktx_size_t offset;
+    // Level 0 is 0 in column 0 and 255 elsewhere. Level 1 is all 51.
+    ktxTexture_GetImageOffset(ktxTexture(texture), 0, 0, 0, &offset);
+    for (ktx_uint32_t i = 0; i < 16; i++)
+        memset(texture->pData + offset + i * 4, i % 4 ? 255 : 0, 4);
+    ktxTexture_GetImageOffset(ktxTexture(texture), 1, 0, 0, &offset);
+    memset(texture->pData + offset, 51, 16);
+
+    ktxSamplerParams params;
+    memset(&params, 0, sizeof(params));
+    params.structSize = sizeof(params);
+    params.filter = KTX_SAMPLER_FILTER_LINEAR;
+    params.addressModeU = KTX_SAMPLER_ADDRESS_CLAMP_TO_EDGE;
+    ktxTextureSampler* sampler;
+    float rgba[4];
+    ASSERT_EQ(ktxTexture2_CreateSampler(texture, &params, &sampler),
+              KTX_SUCCESS);
+    // Halfway between columns 0 and 1.
+    ASSERT_EQ(ktxTextureSampler_Sample(sampler, 0, 0, 0.25f, 0.5f, 0, rgba),
+              KTX_SUCCESS);
+    EXPECT_FLOAT_EQ(rgba[0], 0.5f);
+    // Clamped at the left edge.
+    ASSERT_EQ(ktxTextureSampler_Sample(sampler, 0, 0, 0.0f, 0.5f, 0, rgba),
+              KTX_SUCCESS);
+    EXPECT_FLOAT_EQ(rgba[0], 0.0f);
+    EXPECT_EQ(ktxTextureSampler_Sample(sampler, 1, 0, 0, 0, 0, rgba),
+              KTX_INVALID_VALUE);
+    ktxTextureSampler_Destroy(sampler);
+
+    // Repeating blends the left edge with column 3.
+    params.addressModeU = KTX_SAMPLER_ADDRESS_REPEAT;
+    params.mipmapFilter = KTX_SAMPLER_FILTER_LINEAR;
+    ASSERT_EQ(ktxTexture2_CreateSampler(texture, &params, &sampler),
+              KTX_SUCCESS);
+    ASSERT_EQ(ktxTextureSampler_Sample(sampler, 0, 0, 0.0f, 0.5f, 0, rgba),
+              KTX_SUCCESS);
+    EXPECT_FLOAT_EQ(rgba[0], 0.5f);
+    // Trilinear, a quarter of the way to level 1.
+    ASSERT_EQ(ktxTextureSampler_Sample(sampler, 0, 0, 0.0f, 0.5f, 0.25f,
+                                       rgba), KTX_SUCCESS);
+    EXPECT_FLOAT_EQ(rgba[0], 0.75f * 0.5f + 0.25f * 0.2f);
+    // Lod is clamped to the last level.
+    ASSERT_EQ(ktxTextureSampler_Sample(sampler, 0, 0, 0.0f, 0.5f, 5.0f,
+                                       rgba), KTX_SUCCESS);
+    EXPECT_FLOAT_EQ(rgba[0], 0.2f);
+    ktxTextureSampler_Destroy(sampler);
+
+    params.structSize = 0;
+    EXPECT_EQ(ktxTexture2_CreateSampler(texture, &params, &sampler),
+              KTX_INVALID_VALUE);
+}
+
+TEST_F(ktxTexture2_CreateTest, SampleOutOfRangeCoordinates) {
+    ASSERT_EQ(create(VK_FORMAT_R8G8B8A8_UNORM, 4, 4, 1, 2, 1), KTX_SUCCESS);
+    // Column 0 is 0 and the others are 255.
+    for (ktx_uint32_t i = 0; i < 16; i++)
+        memset(texture->pData + i * 4, i % 4 ? 255 : 0, 4);
+
+    ktxSamplerParams params;
+    memset(&params, 0, sizeof(params));
+    params.structSize = sizeof(params);
+    ktxTextureSampler* sampler;
+    float rgba[4];
+    const ktxSamplerAddressMode modes[] = {
+        KTX_SAMPLER_ADDRESS_REPEAT, KTX_SAMPLER_ADDRESS_MIRRORED_REPEAT,
+        KTX_SAMPLER_ADDRESS_CLAMP_TO_EDGE
+    };
+    for (ktxSamplerFilter filter : { KTX_SAMPLER_FILTER_NEAREST,
+                                     KTX_SAMPLER_FILTER_LINEAR }) {
+        for (ktxSamplerAddressMode mode : modes) {
+            params.filter = filter;
+            params.addressModeU = params.addressModeV = mode;
+            ASSERT_EQ(ktxTexture2_CreateSampler(texture, &params, &sampler),
+                      KTX_SUCCESS);
+            // 1e10 * 4 is a multiple of both periods so lands on column 0
+            // except when clamped to column 3.
+            ASSERT_EQ(ktxTextureSampler_Sample(sampler, 0, 0, 1e10f, 0.5f, 0,
+                                               rgba), KTX_SUCCESS);
+            EXPECT_FLOAT_EQ(rgba[0],
+                     mode == KTX_SAMPLER_ADDRESS_CLAMP_TO_EDGE ? 1.0f : 0.0f)
+                     << filter << " " << mode;
+            ASSERT_EQ(ktxTextureSampler_Sample(sampler, 0, 0, -1e10f, 1e10f,
+                                               0, rgba), KTX_SUCCESS);
+            EXPECT_FLOAT_EQ(rgba[0], 0.0f) << filter << " " << mode;
+            EXPECT_EQ(ktxTextureSampler_Sample(sampler, 0, 0, NAN, 0.5f, 0,
+                                               rgba), KTX_INVALID_VALUE);
+            EXPECT_EQ(ktxTextureSampler_Sample(sampler, 0, 0, 0.5f, INFINITY,
+                                               0, rgba), KTX_INVALID_VALUE);
+            // Finite but overflows when scaled by the width.
+            EXPECT_EQ(ktxTextureSampler_Sample(sampler, 0, 0, 3e38f, 0.5f, 0,
+                                               rgba), KTX_INVALID_VALUE);
+            ktxTextureSampler_Destroy(sampler);
+        }
+    }
+}
+
+TEST_F(ktxTexture2_CreateTest, SampleUnsupported) {
+    ktxSamplerParams params;
+    ktxTextureSampler* sampler;
+    memset(&params, 0, sizeof(params));
+    params.structSize = sizeof(params);
+    ASSERT_EQ(create(VK_FORMAT_BC6H_UFLOAT_BLOCK, 16, 16, 1, 2, 1),
+              KTX_SUCCESS);
+    EXPECT_EQ(ktxTexture2_CreateSampler(texture, &params, &sampler),
+              KTX_UNSUPPORTED_TEXTURE_TYPE);
+}
+
+TEST_F(ktxTexture2_CreateTest, SampleSupercompressed) {
+    ktxSamplerParams params;
+    ktxTextureSampler* sampler;
+    memset(&params, 0, sizeof(params));
+    params.structSize = sizeof(params);
+    ASSERT_EQ(create(VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 16, 16, 1, 2, 1),
+              KTX_SUCCESS);
+    memset(texture->pData, 0, texture->dataSize);
+    // Too many blocks is clamped rather than overflowing the cache size.
+    params.cacheBlocks = 0xffffffff;
+    ASSERT_EQ(ktxTexture2_CreateSampler(texture, &params, &sampler),
+              KTX_SUCCESS);
+    ktxTextureSampler_Destroy(sampler);
+
+    // The loaded data is now zstd supercompressed so can't be sampled.
+    ASSERT_EQ(ktxTexture2_DeflateZstd(texture, 1), KTX_SUCCESS);
+    EXPECT_EQ(ktxTexture2_CreateSampler(texture, &params, &sampler),
+              KTX_UNSUPPORTED_TEXTURE_TYPE);
+}
+
+//----------------------------------------------------
+// Test fixture for ktxTexture2_CreateFromBasis
+//----------------------------------------------------
+
+class ktxTexture2_CreateFromBasisTest : public ::testing::Test {
+  protected:
+    // Write a minimal UASTC .basis file holding a single image of
+    // @a numLevels levels of @a width x @a height. Block bytes are
+    // numbered so the repacked data can be checked.
+    void makeUastcBasis(ktx_uint32_t width, ktx_uint32_t height,
+                        ktx_uint32_t numLevels)
+    {
+        const size_t headerSize = 77, sliceDescSize = 23;
+        size_t dataStart = headerSize + sliceDescSize * numLevels;
+
+        basis.assign(dataStart, 0);
+        put(0, ('B' << 8) | 's', 2);    // m_sig
+        put(2, 0x13, 2);                // m_ver
+        put(4, headerSize, 2);          // m_header_size
+        put(14, numLevels, 3);          // m_total_slices
+        put(17, 1, 3);                  // m_total_images
+        put(20, 1, 1);                  // m_tex_format = cUASTC4x4
+        put(65, headerSize, 4);         // m_slice_desc_file_ofs
+        for (ktx_uint32_t level = 0; level < numLevels; level++) {
+            ktx_uint32_t w = std::max(1u, width >> level);
+            ktx_uint32_t h = std::max(1u, height >> level);
+            ktx_uint32_t size = ((w + 3) / 4) * ((h + 3) / 4) * 16;
+            size_t desc = headerSize + sliceDescSize * level;
+            put(desc + 3, level, 1);                // m_level_index
+            put(desc + 5, w, 2);                    // m_orig_width
+            put(desc + 7, h, 2);                    // m_orig_height
+            put(desc + 9, (w + 3) / 4, 2);          // m_num_blocks_x
+            put(desc + 11, (h + 3) / 4, 2);         // m_num_blocks_y
+            put(desc + 13, basis.size(), 4);        // m_file_ofs
+            put(desc + 17, size, 4);                // m_file_size
+            for (ktx_uint32_t i = 0; i < size; i++)
+                basis.push_back((ktx_uint8_t)(level * 16 + i));
+        }
+        put(8, basis.size() - headerSize, 4);       // m_data_size
+    }
+
+    void put(size_t offset, size_t value, size_t bytes) {
+        for (size_t i = 0; i < bytes; i++)
+            basis[offset + i] = (ktx_uint8_t)(value >> (8 * i));
+    }
+
+    ~ktxTexture2_CreateFromBasisTest() {
+        if (texture)
+            ktxTexture_Destroy(ktxTexture(texture));
+    }
+
+    std::vector<ktx_uint8_t> basis;
+    ktxTexture2* texture = nullptr;
+};
+
+TEST_F(ktxTexture2_CreateFromBasisTest, RepacksUastcLevels) {
+    makeUastcBasis(8, 8, 4);
+    ASSERT_EQ(ktxTexture2_CreateFromBasis(basis.data(), basis.size(),
+                                          &texture), KTX_SUCCESS);
+    EXPECT_EQ(texture->numLevels, 4U);
+    EXPECT_EQ(texture->baseWidth, 8U);
+    EXPECT_EQ(texture->baseHeight, 8U);
+    EXPECT_EQ(texture->isArray, KTX_FALSE);
+    EXPECT_EQ(texture->supercompressionScheme, KTX_SS_NONE);
+    EXPECT_TRUE(ktxTexture2_NeedsTranscoding(texture));
+
+    for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+        ktx_size_t offset;
+        ktx_uint32_t size = level == 0 ? 64 : 16;
+        ASSERT_EQ(ktxTexture_GetImageOffset(ktxTexture(texture), level, 0, 0,
+                                            &offset), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture_GetImageSize(ktxTexture(texture), level), size);
+        for (ktx_uint32_t i = 0; i < size; i++) {
+            ASSERT_EQ(texture->pData[offset + i],
+                      (ktx_uint8_t)(level * 16 + i))
+                      << "Level " << level << " byte " << i;
+        }
+    }
+}
+
+TEST_F(ktxTexture2_CreateFromBasisTest, InvalidFiles) {
+    makeUastcBasis(8, 8, 1);
+    EXPECT_EQ(ktxTexture2_CreateFromBasis(nullptr, basis.size(), &texture),
+              KTX_INVALID_VALUE);
+    // Truncated.
+    EXPECT_EQ(ktxTexture2_CreateFromBasis(basis.data(), basis.size() - 1,
+                                          &texture), KTX_FILE_DATA_ERROR);
+    // Level 1 does not follow the KTX level size rule.
+    makeUastcBasis(8, 8, 2);
+    put(77 + 23 + 5, 3, 2);
+    EXPECT_EQ(ktxTexture2_CreateFromBasis(basis.data(), basis.size(),
+                                          &texture), KTX_UNSUPPORTED_FEATURE);
+    // Not a .basis file.
+    basis[0] = 'K';
+    EXPECT_EQ(ktxTexture2_CreateFromBasis(basis.data(), basis.size(),
+                                          &texture), KTX_UNKNOWN_FILE_FORMAT);
+    EXPECT_TRUE(texture == nullptr);
+}
+
+class ktxTexture2_DeflateZstdTest : public ktxTexture2TestBase<GLubyte, 4, GL_RGBA8>  { };
+
+/////////////////////////////////////////
+// ktxTexture2_DeflateZstd tests
+////////////////////////////////////////
+
+TEST_F(ktxTexture2_DeflateZstdTest, DeflateToStream) {
+    ktxTexture2* texture;
+    ktxTexture2* deflated;
+    ktxStream dststr;
+    ktx_uint8_t* pDeflatedFile;
+    ktx_size_t deflatedFileLen;
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                              KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                              &texture);
+        ASSERT_TRUE(result == KTX_SUCCESS);
+        ASSERT_TRUE(texture != NULL) << "ktxTexture_CreateFromMemory failed: "
+                                     << ktxErrorString(result);
+
+        ASSERT_EQ(ktxMemStream_construct(&dststr, KTX_FALSE), KTX_SUCCESS);
+        result = ktxTexture2_DeflateZstdToStream(texture, &dststr, 5);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        // Source texture must be untouched.
+        EXPECT_EQ(texture->supercompressionScheme, KTX_SS_NONE);
+        ktxMemStream_getdata(&dststr, &pDeflatedFile);
+        dststr.getsize(&dststr, &deflatedFileLen);
+        ktxMemStream_destruct(&dststr);
+
+        result = ktxTexture2_CreateFromMemory(pDeflatedFile, deflatedFileLen,
+                                              KTX_TEXTURE_CREATE_NO_FLAGS,
+                                              &deflated);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        EXPECT_EQ(deflated->supercompressionScheme, KTX_SS_ZSTD);
+        EXPECT_EQ(deflated->numLevels, texture->numLevels);
+        for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+            EXPECT_EQ(deflated->_private->_levelIndex[level].uncompressedByteLength,
+                      texture->_private->_levelIndex[level].byteLength);
+        }
+        result = ktxTexture2_LoadImageData(deflated, NULL, 0);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        EXPECT_EQ(deflated->dataSize, texture->dataSize);
+        EXPECT_EQ(memcmp(deflated->pData, texture->pData, texture->dataSize), 0);
+
+        ktxTexture_Destroy(ktxTexture(deflated));
+        ktxTexture_Destroy(ktxTexture(texture));
+        free(pDeflatedFile);
+    }
+}
+
+static void
+writeDeflated(ktxTexture2* texture, ktx_uint32_t level,
+              ktx_uint8_t** ppDst, ktx_size_t* pSize)
+{
+    ASSERT_EQ(ktxTexture2_DeflateZstd(texture, level), KTX_SUCCESS);
+    ASSERT_EQ(ktxTexture_WriteToMemory(ktxTexture(texture), ppDst, pSize),
+              KTX_SUCCESS);
+}
+
+TEST_F(ktxTexture2_DeflateZstdTest, RedeflateMatchesDeflate) {
+    ktxTexture2* texture;
+    ktx_uint8_t* pLevel3File;
+    ktx_uint8_t* pLevel9File;
+    ktx_uint8_t* pRedeflatedFile;
+    ktx_size_t level3FileLen, level9FileLen, redeflatedFileLen;
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        for (ktx_uint32_t level : { 3, 9 }) {
+            result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                                  KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                                  &texture);
+            ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+            // Data is loaded.
+            EXPECT_EQ(ktxTexture2_RedeflateZstd(texture, level,
+                                                KTX_ZSTD_FILTER_NONE, 1),
+                      KTX_INVALID_OPERATION);
+            if (level == 3)
+                writeDeflated(texture, level, &pLevel3File, &level3FileLen);
+            else
+                writeDeflated(texture, level, &pLevel9File, &level9FileLen);
+            ktxTexture_Destroy(ktxTexture(texture));
+        }
+
+        result = ktxTexture2_CreateFromMemory(pLevel3File, level3FileLen,
+                                              KTX_TEXTURE_CREATE_NO_FLAGS,
+                                              &texture);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        result = ktxTexture2_RedeflateZstd(texture, 9, KTX_ZSTD_FILTER_NONE, 4);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        result = ktxTexture_WriteToMemory(ktxTexture(texture),
+                                          &pRedeflatedFile, &redeflatedFileLen);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        ASSERT_EQ(redeflatedFileLen, level9FileLen);
+        EXPECT_EQ(memcmp(pRedeflatedFile, pLevel9File, level9FileLen), 0);
+
+        ktxTexture_Destroy(ktxTexture(texture));
+        free(pRedeflatedFile);
+        free(pLevel9File);
+        free(pLevel3File);
+    }
+}
+
+class ktxTexture2_WriteAlignedTest : public ktxTexture2TestBase<GLubyte, 3, GL_RGB8>  { };
+
+/////////////////////////////////////////
+// ktxTexture2_WriteAligned tests
+////////////////////////////////////////
+
+static void
+expectSameLevels(ktxTexture2* a, ktxTexture2* b)
+{
+    ASSERT_EQ(a->numLevels, b->numLevels);
+    for (ktx_uint32_t level = 0; level < a->numLevels; level++) {
+        ktxLevelIndexEntry& la = a->_private->_levelIndex[level];
+        ktxLevelIndexEntry& lb = b->_private->_levelIndex[level];
+        ASSERT_EQ(la.byteLength, lb.byteLength);
+        EXPECT_EQ(memcmp(a->pData + la.byteOffset, b->pData + lb.byteOffset,
+                         la.byteLength), 0) << "level " << level;
+    }
+}
+
+TEST_F(ktxTexture2_WriteAlignedTest, WriteAlignedToMemory) {
+    ktxTexture2* texture;
+    ktxTexture2* aligned;
+    ktx_uint8_t* pAlignedFile;
+    ktx_uint8_t* pRewrittenFile;
+    ktx_size_t alignedFileLen, rewrittenFileLen;
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                              KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                              &texture);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        EXPECT_EQ(ktxTexture2_WriteAlignedToMemory(texture, &pAlignedFile,
+                                                   &alignedFileLen, 0),
+                  KTX_INVALID_VALUE);
+        result = ktxTexture2_WriteAlignedToMemory(texture, &pAlignedFile,
+                                                  &alignedFileLen, 4096);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+
+        // RGB8 levels must also be 12 byte aligned so lcm(4096, 12) is used.
+        ktxLevelIndexEntry* levelIndex
+            = (ktxLevelIndexEntry*)(pAlignedFile + sizeof(KTX_header2));
+        for (ktx_uint32_t level = 0; level < texture->numLevels; level++)
+            EXPECT_EQ(levelIndex[level].byteOffset % 12288, 0U);
+
+        result = ktxTexture2_CreateFromMemory(pAlignedFile, alignedFileLen,
+                                              KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                              &aligned);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        expectSameLevels(texture, aligned);
+
+        // The padding is dropped when the texture is written normally.
+        result = ktxTexture_WriteToMemory(ktxTexture(aligned), &pRewrittenFile,
+                                          &rewrittenFileLen);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        ASSERT_EQ(rewrittenFileLen, ktxMemFileLen);
+        EXPECT_EQ(memcmp(pRewrittenFile, ktxMemFile, ktxMemFileLen), 0);
+
+        ktxTexture_Destroy(ktxTexture(aligned));
+        ktxTexture_Destroy(ktxTexture(texture));
+        free(pRewrittenFile);
+        free(pAlignedFile);
+    }
+}
+
+TEST_F(ktxTexture2_WriteAlignedTest, LoadAlignedFile) {
+    ktxTexture2* texture;
+    ktxTexture2* aligned;
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                              KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                              &texture);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        FILE* file = tmpfile();
+        ASSERT_TRUE(file != NULL);
+        result = ktxTexture2_WriteAlignedToStdioStream(texture, file, 4096);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        rewind(file);
+
+        // Takes the direct read path where the file system supports it.
+        result = ktxTexture2_CreateFromStdioStream(file,
+                                              KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                              &aligned);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        expectSameLevels(texture, aligned);
+
+        ktxTexture_Destroy(ktxTexture(aligned));
+        ktxTexture_Destroy(ktxTexture(texture));
+        fclose(file);
+    }
+}
+
+class ktxTexture2_LevelHashTest : public ktxTexture2TestBase<GLubyte, 4, GL_RGBA8>  { };
+
+/////////////////////////////////////////
+// ktxTexture2 level hash tests
+////////////////////////////////////////
+
+TEST_F(ktxTexture2_LevelHashTest, VerifyLevelHashes) {
+    ktxTexture2* texture;
+    ktxTexture2* hashed;
+    ktx_uint8_t* pHashedFile;
+    ktx_size_t hashedFileLen;
+    ktx_uint64_t hash0, hash1;
+    ktx_uint32_t badLevel = 0;
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                              KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                              &texture);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        EXPECT_EQ(ktxTexture2_VerifyLevelHashes(texture, 1, NULL),
+                  KTX_NOT_FOUND);
+        result = ktxTexture2_AddLevelHashes(texture);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        EXPECT_EQ(ktxTexture2_VerifyLevelHashes(texture, 4, NULL),
+                  KTX_SUCCESS);
+        result = ktxTexture_WriteToMemory(ktxTexture(texture), &pHashedFile,
+                                          &hashedFileLen);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+
+        // Check the data in the file without loading it.
+        result = ktxTexture2_CreateFromMemory(pHashedFile, hashedFileLen,
+                                              KTX_TEXTURE_CREATE_NO_FLAGS,
+                                              &hashed);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        EXPECT_EQ(ktxTexture2_VerifyLevelHashes(hashed, 4, NULL), KTX_SUCCESS);
+        for (ktx_uint32_t level = 0; level < hashed->numLevels; level++)
+            EXPECT_EQ(ktxTexture2_VerifyLevelHash(hashed, level), KTX_SUCCESS);
+        EXPECT_EQ(ktxTexture2_VerifyLevelHash(hashed, hashed->numLevels),
+                  KTX_INVALID_VALUE);
+        ASSERT_EQ(ktxTexture2_GetLevelHash(hashed, 0, &hash0), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_GetLevelHash(hashed, 1, &hash1), KTX_SUCCESS);
+        EXPECT_NE(hash0, hash1);
+        ktxTexture_Destroy(ktxTexture(hashed));
+
+        // Corrupt a byte of level 1.
+        ktxLevelIndexEntry* levelIndex
+            = (ktxLevelIndexEntry*)(pHashedFile + sizeof(KTX_header2));
+        pHashedFile[levelIndex[1].byteOffset + 1] ^= 0x40;
+        result = ktxTexture2_CreateFromMemory(pHashedFile, hashedFileLen,
+                                              KTX_TEXTURE_CREATE_NO_FLAGS,
+                                              &hashed);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        EXPECT_EQ(ktxTexture2_VerifyLevelHash(hashed, 0), KTX_SUCCESS);
+        EXPECT_EQ(ktxTexture2_VerifyLevelHash(hashed, 1), KTX_FILE_DATA_ERROR);
+        EXPECT_EQ(ktxTexture2_VerifyLevelHashes(hashed, 4, &badLevel),
+                  KTX_FILE_DATA_ERROR);
+        EXPECT_EQ(badLevel, 1U);
+
+        ktxTexture_Destroy(ktxTexture(hashed));
+        ktxTexture_Destroy(ktxTexture(texture));
+        free(pHashedFile);
+    }
+}
+
+TEST_F(ktxTexture2_LevelHashTest, HashesFollowSupercompression) {
+    ktxTexture2* texture;
+    ktxTexture2* hashed;
+    ktx_uint8_t* pHashedFile;
+    ktx_size_t hashedFileLen;
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                              KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                              &texture);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        ASSERT_EQ(ktxTexture2_AddLevelHashes(texture), KTX_SUCCESS);
+        // The hashes are refreshed when the deflated texture is written.
+        ASSERT_EQ(ktxTexture2_DeflateZstd(texture, 5), KTX_SUCCESS);
+        result = ktxTexture_WriteToMemory(ktxTexture(texture), &pHashedFile,
+                                          &hashedFileLen);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+
+        result = ktxTexture2_CreateFromMemory(pHashedFile, hashedFileLen,
+                                              KTX_TEXTURE_CREATE_NO_FLAGS,
+                                              &hashed);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        EXPECT_EQ(ktxTexture2_VerifyLevelHashes(hashed, 2, NULL), KTX_SUCCESS);
+        // Inflation on load removes them.
+        result = ktxTexture_LoadImageData(ktxTexture(hashed), NULL, 0);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        EXPECT_EQ(ktxTexture2_VerifyLevelHashes(hashed, 2, NULL),
+                  KTX_NOT_FOUND);
+
+        ktxTexture_Destroy(ktxTexture(hashed));
+        ktxTexture_Destroy(ktxTexture(texture));
+        free(pHashedFile);
+    }
+}
+
+#if !defined(_WIN32)
+class ktxTexture2_SharedTest : public ktxTexture2TestBase<GLubyte, 4, GL_RGBA8>  { };
+
+/////////////////////////////////////////
+// ktxTexture2 shared texture tests
+////////////////////////////////////////
+
+// Runs in a child process. Returns the exit status.
+static int
+viewSharedTexture(const char* name, ktxTexture2* original, int readyFd,
+                  int releaseFd)
+{
+    ktxTexture2* view;
+    char c = 0;
+
+    if (ktxTexture2_CreateFromShared(name, KTX_TEXTURE_CREATE_NO_FLAGS,
+                                     &view) != KTX_SUCCESS)
+        return 1;
+    if (write(readyFd, &c, 1) != 1)
+        return 2;
+    // Wait for the parent to invalidate the texture.
+    if (read(releaseFd, &c, 1) != 0)
+        return 3;
+    if (ktxTexture2_IsSharedViewValid(view))
+        return 4;
+    // The data stays mapped after invalidation.
+    for (ktx_uint32_t level = 0; level < view->numLevels; level++) {
+        ktxLevelIndexEntry& lo = original->_private->_levelIndex[level];
+        ktxLevelIndexEntry& lv = view->_private->_levelIndex[level];
+        if (lo.byteLength != lv.byteLength
+            || memcmp(original->pData + lo.byteOffset,
+                      view->pData + lv.byteOffset, lo.byteLength) != 0)
+            return 5;
+    }
+    ktxTexture_Destroy(ktxTexture(view));
+    return 0;
+}
+
+TEST_F(ktxTexture2_SharedTest, ViewFromOtherProcesses) {
+    const int numChildren = 3;
+    std::string name = "ktxtest-" + std::to_string(getpid());
+    ktxTexture2* texture;
+    ktx_uint32_t refCount;
+    int readyPipe[2], releasePipe[2];
+    pid_t children[numChildren];
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                              KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                              &texture);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        EXPECT_EQ(ktxTexture2_PublishShared(texture, "bad/name"),
+                  KTX_INVALID_VALUE);
+        result = ktxTexture2_PublishShared(texture, name.c_str());
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        EXPECT_EQ(ktxTexture2_PublishShared(texture, name.c_str()),
+                  KTX_INVALID_OPERATION);
+
+        ASSERT_EQ(pipe(readyPipe), 0);
+        ASSERT_EQ(pipe(releasePipe), 0);
+        for (int i = 0; i < numChildren; i++) {
+            children[i] = fork();
+            ASSERT_GE(children[i], 0);
+            if (children[i] == 0) {
+                close(readyPipe[0]);
+                close(releasePipe[1]);
+                _exit(viewSharedTexture(name.c_str(), texture, readyPipe[1],
+                                        releasePipe[0]));
+            }
+        }
+        close(readyPipe[1]);
+        close(releasePipe[0]);
+
+        // Wait for all the children to attach.
+        for (int i = 0; i < numChildren; i++) {
+            char c;
+            EXPECT_EQ(read(readyPipe[0], &c, 1), 1);
+        }
+        EXPECT_EQ(ktxTexture2_GetSharedRefCount(name.c_str(), &refCount),
+                  KTX_SUCCESS);
+        EXPECT_EQ(refCount, (ktx_uint32_t)numChildren);
+
+        EXPECT_EQ(ktxTexture2_InvalidateShared(name.c_str()), KTX_SUCCESS);
+        ktxTexture2* view;
+        EXPECT_EQ(ktxTexture2_CreateFromShared(name.c_str(),
+                                               KTX_TEXTURE_CREATE_NO_FLAGS,
+                                               &view),
+                  KTX_NOT_FOUND);
+        close(releasePipe[1]);
+        for (int i = 0; i < numChildren; i++) {
+            int status;
+            ASSERT_EQ(waitpid(children[i], &status, 0), children[i]);
+            EXPECT_TRUE(WIFEXITED(status));
+            EXPECT_EQ(WEXITSTATUS(status), 0) << "child " << i;
+        }
+        close(readyPipe[0]);
+        ktxTexture_Destroy(ktxTexture(texture));
+    }
+}
+
+TEST_F(ktxTexture2_SharedTest, ModifyingViewCopiesData) {
+    std::string name = "ktxtest-" + std::to_string(getpid());
+    ktxTexture2* texture;
+    ktxTexture2* view;
+    ktx_uint32_t refCount;
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                              KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                              &texture);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        result = ktxTexture2_PublishShared(texture, name.c_str());
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        result = ktxTexture2_CreateFromShared(name.c_str(),
+                                              KTX_TEXTURE_CREATE_NO_FLAGS,
+                                              &view);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        EXPECT_TRUE(ktxTexture2_IsSharedViewValid(view));
+        expectSameLevels(texture, view);
+
+        // The view's data is read-only so can't be set in place.
+        ktx_size_t imageSize = ktxTexture_GetImageSize(ktxTexture(view), 0);
+        std::vector<ktx_uint8_t> image(imageSize, 0);
+        EXPECT_EQ(ktxTexture_SetImageFromMemory(ktxTexture(view), 0, 0, 0,
+                                                image.data(), imageSize),
+                  KTX_INVALID_OPERATION);
+
+        ASSERT_EQ(ktxTexture2_DeflateZstd(view, 5), KTX_SUCCESS);
+        EXPECT_FALSE(ktxTexture2_IsSharedViewValid(view));
+        EXPECT_EQ(ktxTexture2_GetSharedRefCount(name.c_str(), &refCount),
+                  KTX_SUCCESS);
+        EXPECT_EQ(refCount, 0U);
+
+        EXPECT_EQ(ktxTexture2_InvalidateShared(name.c_str()), KTX_SUCCESS);
+        EXPECT_EQ(ktxTexture2_InvalidateShared(name.c_str()), KTX_NOT_FOUND);
+        ktxTexture_Destroy(ktxTexture(view));
+        ktxTexture_Destroy(ktxTexture(texture));
+    }
+}
+#endif
+
+class ktxTexture2_DeflateZstdFilteredTest : public ktxTexture2TestBase<GLushort, 2, GL_RG16>  { };
+
+TEST_F(ktxTexture2_DeflateZstdFilteredTest, IterateLoadImagesShuffleDelta) {
+    ktxTexture2* texture;
+    ktx_uint8_t* pDeflatedFile;
+    ktx_size_t deflatedFileLen;
+
+    if (ktxMemFile != NULL) {
+        ASSERT_EQ(ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                        KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                        &texture), KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture2_DeflateZstdFiltered(texture, 5,
+                                              KTX_ZSTD_FILTER_SHUFFLE_DELTA),
+                  KTX_SUCCESS);
+        ASSERT_EQ(ktxTexture_WriteToMemory(ktxTexture(texture),
+                                           &pDeflatedFile, &deflatedFileLen),
+                  KTX_SUCCESS);
+        ktxTexture_Destroy(ktxTexture(texture));
+        compareIterateLoadImages(pDeflatedFile, deflatedFileLen);
+        free(pDeflatedFile);
+    }
+}
+
+TEST_F(ktxTexture2_DeflateZstdFilteredTest, ShuffleDeltaRoundTrip) {
+    ktxTexture2* texture;
+    ktxTexture2* original;
+    ktxTexture2* inflated;
+    ktx_uint8_t* pDeflatedFile;
+    ktx_size_t deflatedFileLen;
+    KTX_error_code result;
+
+    if (ktxMemFile != NULL) {
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                              KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                              &texture);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        result = ktxTexture2_CreateFromMemory(ktxMemFile, ktxMemFileLen,
+                                              KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                              &original);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+
+        EXPECT_EQ(ktxTexture2_DeflateZstdFiltered(texture, 5,
+                                                  (ktx_zstd_filter_e)99),
+                  KTX_INVALID_VALUE);
+        result = ktxTexture2_DeflateZstdFiltered(texture, 5,
+                                                 KTX_ZSTD_FILTER_SHUFFLE_DELTA);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        EXPECT_EQ(texture->supercompressionScheme, KTX_SS_ZSTD_SHUFFLE_DELTA);
+        result = ktxTexture_WriteToMemory(ktxTexture(texture),
+                                          &pDeflatedFile, &deflatedFileLen);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+
+        result = ktxTexture2_CreateFromMemory(pDeflatedFile, deflatedFileLen,
+                                              KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                              &inflated);
+        ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+        EXPECT_EQ(inflated->supercompressionScheme, KTX_SS_NONE);
+        EXPECT_EQ(inflated->dataSize, original->dataSize);
+        EXPECT_EQ(memcmp(inflated->pData, original->pData, original->dataSize), 0);
+
+        ktxTexture_Destroy(ktxTexture(inflated));
+        ktxTexture_Destroy(ktxTexture(original));
+        ktxTexture_Destroy(ktxTexture(texture));
+        free(pDeflatedFile);
+    }
+}
+
+static void
+blockSplitRoundTrip(ktxTexture2* texture)
+{
+    ktxTexture2* inflated;
+    ktx_uint8_t* pDeflatedFile;
+    ktx_size_t deflatedFileLen;
+    KTX_error_code result;
+
+    for (ktx_size_t i = 0; i < texture->dataSize; i++)
+        texture->pData[i] = (ktx_uint8_t)(i * 7 + (i >> 5));
+    std::vector<ktx_uint8_t> original(texture->pData,
+                                      texture->pData + texture->dataSize);
+
+    EXPECT_EQ(ktxTexture2_DeflateZstdFiltered(texture, 5,
+                                              KTX_ZSTD_FILTER_SHUFFLE_DELTA),
+              KTX_INVALID_OPERATION);
+    result = ktxTexture2_DeflateZstdFiltered(texture, 5,
+                                             KTX_ZSTD_FILTER_BLOCK_SPLIT);
+    ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+    EXPECT_EQ(texture->supercompressionScheme, KTX_SS_ZSTD_BLOCK_SPLIT);
+    result = ktxTexture_WriteToMemory(ktxTexture(texture),
+                                      &pDeflatedFile, &deflatedFileLen);
+    ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+
+    result = ktxTexture2_CreateFromMemory(pDeflatedFile, deflatedFileLen,
+                                          KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                          &inflated);
+    ASSERT_EQ(result, KTX_SUCCESS) << ktxErrorString(result);
+    EXPECT_EQ(inflated->supercompressionScheme, KTX_SS_NONE);
+    ASSERT_EQ(inflated->dataSize, original.size());
+    EXPECT_EQ(memcmp(inflated->pData, original.data(), original.size()), 0);
+
+    ktxTexture_Destroy(ktxTexture(inflated));
+    free(pDeflatedFile);
+}
+
+TEST_F(ktxTexture2_CreateTest, DeflateZstdBlockSplitBC1) {
+    // Width is not a multiple of the block width or of the SIMD width.
+    ASSERT_EQ(create(VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 70, 36, 1, 2, 7),
+              KTX_SUCCESS);
+    blockSplitRoundTrip(texture);
+}
+
+TEST_F(ktxTexture2_CreateTest, DeflateZstdBlockSplitASTC) {
+    ASSERT_EQ(create(VK_FORMAT_ASTC_6x6_UNORM_BLOCK, 130, 36, 1, 2, 8, 2),
+              KTX_SUCCESS);
+    blockSplitRoundTrip(texture);
+}
+
+////////////////////////////////////////////
+// ktxFormatConversion tests
+///////////////////////////////////////////
+
+TEST(ktxFormatConversion, Candidates) {
+    ktxFormatConversion conversions[KTX_MAX_FORMAT_CONVERSIONS];
+
+    ASSERT_EQ(ktxFormatConversion_candidates(VK_FORMAT_B8G8R8_SNORM,
+                                             KTX_TRUE, conversions), 1U);
+    EXPECT_EQ(conversions[0].dstFormat, VK_FORMAT_B8G8R8A8_SNORM);
+    EXPECT_EQ(conversions[0].one, 0x7fU);
+    ASSERT_EQ(ktxFormatConversion_candidates(VK_FORMAT_R16G16B16_SFLOAT,
+                                             KTX_FALSE, conversions), 1U);
+    EXPECT_EQ(conversions[0].dstFormat, VK_FORMAT_R16G16B16A16_SFLOAT);
+    EXPECT_EQ(conversions[0].one, 0x3c00U);
+    ASSERT_EQ(ktxFormatConversion_candidates(VK_FORMAT_R32G32B32_SFLOAT,
+                                             KTX_TRUE, conversions), 2U);
+    EXPECT_EQ(conversions[0].dstFormat, VK_FORMAT_R32G32B32A32_SFLOAT);
+    EXPECT_FALSE(conversions[0].lossy);
+    EXPECT_EQ(conversions[1].dstFormat, VK_FORMAT_R16G16B16A16_SFLOAT);
+    EXPECT_TRUE(conversions[1].lossy);
+    EXPECT_EQ(ktxFormatConversion_candidates(VK_FORMAT_R32_SFLOAT,
+                                             KTX_FALSE, conversions), 0U);
+    ASSERT_EQ(ktxFormatConversion_candidates(VK_FORMAT_R64G64_SFLOAT,
+                                             KTX_TRUE, conversions), 2U);
+    EXPECT_EQ(conversions[0].dstFormat, VK_FORMAT_R32G32_SFLOAT);
+    EXPECT_EQ(conversions[1].dstFormat, VK_FORMAT_R16G16_SFLOAT);
+    EXPECT_EQ(ktxFormatConversion_candidates(VK_FORMAT_R8G8B8A8_UNORM,
+                                             KTX_TRUE, conversions), 0U);
+    EXPECT_EQ(ktxFormatConversion_candidates(VK_FORMAT_BC1_RGB_UNORM_BLOCK,
+                                             KTX_TRUE, conversions), 0U);
+}
+
+TEST(ktxFormatConversion, WidenRGB) {
+    const VkFormat formats[] = {
+        VK_FORMAT_R8G8B8_SRGB, VK_FORMAT_R16G16B16_UNORM,
+        VK_FORMAT_R32G32B32_UINT
+    };
+    // Not a multiple of any SIMD width.
+    const ktx_uint32_t numTexels = 37;
+
+    for (VkFormat format : formats) {
+        ktxFormatConversion conversions[KTX_MAX_FORMAT_CONVERSIONS];
+        ASSERT_EQ(ktxFormatConversion_candidates(format, KTX_FALSE,
+                                                 conversions), 1U);
+        const ktxFormatConversion& c = conversions[0];
+        ktx_uint32_t size = c.srcComponentSize;
+        std::vector<ktx_uint8_t> src(numTexels * 3 * size);
+        std::vector<ktx_uint8_t> dst(numTexels * 4 * size + 1, 0xcd);
+        for (size_t i = 0; i < src.size(); i++)
+            src[i] = (ktx_uint8_t)(i * 13 + 1);
+
+        ktxFormatConversion_convert(&c, src.data(), dst.data(), numTexels);
+        for (ktx_uint32_t t = 0; t < numTexels; t++) {
+            EXPECT_EQ(memcmp(&dst[t * 4 * size], &src[t * 3 * size], 3 * size),
+                      0) << "format " << format << " texel " << t;
+            ktx_uint64_t alpha = 0;
+            memcpy(&alpha, &dst[(t * 4 + 3) * size], size);
+            EXPECT_EQ(alpha, c.one) << "format " << format << " texel " << t;
+        }
+        EXPECT_EQ(dst.back(), 0xcd) << "Wrote past the end";
+    }
+}
+
+TEST(ktxFormatConversion, FloatToHalf) {
+    const struct { float f; ktx_uint16_t h; } cases[] = {
+        { 1.0f, 0x3c00 },
+        { -0.0f, 0x8000 },
+        { 65504.0f, 0x7bff },
+        { 65519.0f, 0x7bff },
+        { 65520.0f, 0x7c00 },
+        { 5.9604645e-8f, 0x0001 },        // 2^-24, smallest subnormal.
+        { 2.9802322e-8f, 0x0000 },        // 2^-25 ties to even, i.e. 0.
+        { 6.1035156e-5f, 0x0400 },        // 2^-14, smallest normal.
+        { 1.0f + 1.0f / 2048, 0x3c00 },   // Tie rounds to even.
+        { 1.0f + 3.0f / 2048, 0x3c02 },   // Tie rounds to even.
+        { 1.0f + 1.5f / 2048, 0x3c01 },
+        { INFINITY, 0x7c00 },
+    };
+    ktxFormatConversion conversions[KTX_MAX_FORMAT_CONVERSIONS];
+    ASSERT_EQ(ktxFormatConversion_candidates(VK_FORMAT_R32_SFLOAT, KTX_TRUE,
+                                             conversions), 1U);
+    for (const auto& testCase : cases) {
+        ktx_uint16_t h;
+        ktxFormatConversion_convert(&conversions[0],
+                                    (const ktx_uint8_t*)&testCase.f,
+                                    (ktx_uint8_t*)&h, 1);
+        EXPECT_EQ(h, testCase.h) << testCase.f;
+    }
+    float nan = NAN;
+    ktx_uint16_t h;
+    ktxFormatConversion_convert(&conversions[0], (const ktx_uint8_t*)&nan,
+                                (ktx_uint8_t*)&h, 1);
+    EXPECT_EQ(h & 0x7c00, 0x7c00);
+    EXPECT_NE(h & 0x3ff, 0);
+}
+
+TEST(ktxTexture2_CreateFromImagesTest, GenerateMipmaps) {
+    const ktx_uint32_t width = 8, height = 4, numLayers = 2;
+    std::vector<ktx_uint8_t> pixels[numLayers];
+    ktxSourceImage images[numLayers];
+    for (ktx_uint32_t layer = 0; layer < numLayers; layer++) {
+        pixels[layer].resize(width * height * 3);
+        for (ktx_uint32_t i = 0; i < width * height; i++) {
+            pixels[layer][i * 3] = 0x20 + (ktx_uint8_t)layer;
+            pixels[layer][i * 3 + 1] = 0x80;
+            pixels[layer][i * 3 + 2] = 0xc0;
+        }
+        images[layer] = { pixels[layer].data(), width, height, 3, 1,
+                          KHR_DF_TRANSFER_SRGB, KHR_DF_PRIMARIES_BT709,
+                          0, layer, 0 };
+    }
+
+    ktxImageParams params;
+    memset(&params, 0, sizeof(params));
+    params.structSize = sizeof(params);
+    params.threadCount = 2;
+    params.numLayers = numLayers;
+    params.isArray = KTX_TRUE;
+    params.generateMipmaps = KTX_TRUE;
+
+    ktxTexture2* texture;
+    ASSERT_EQ(ktxTexture2_CreateFromImages(images, numLayers, &params,
+                                           &texture), KTX_SUCCESS);
+    EXPECT_EQ(texture->vkFormat, (ktx_uint32_t)VK_FORMAT_R8G8B8_SRGB);
+    EXPECT_EQ(texture->numLevels, 4U);
+    EXPECT_EQ(texture->numLayers, numLayers);
+    EXPECT_TRUE(texture->isArray);
+    EXPECT_EQ(texture->numDimensions, 2U);
+    for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+        ktx_uint32_t levelPixels = std::max(1U, width >> level)
+                                 * std::max(1U, height >> level);
+        for (ktx_uint32_t layer = 0; layer < numLayers; layer++) {
+            ktx_size_t offset;
+            ASSERT_EQ(ktxTexture_GetImageOffset(ktxTexture(texture), level,
+                                                layer, 0, &offset),
+                      KTX_SUCCESS);
+            // Resampling a constant image gives the same constant.
+            for (ktx_uint32_t i = 0; i < levelPixels * 3; i++)
+                EXPECT_NEAR(texture->pData[offset + i],
+                            pixels[layer][i % 3], 1)
+                    << "level " << level << " layer " << layer;
+        }
+    }
+    char* orientation;
+    unsigned int len;
+    ASSERT_EQ(ktxHashList_FindValue(&texture->kvDataHead, KTX_ORIENTATION_KEY,
+                                    &len, (void**)&orientation), KTX_SUCCESS);
+    EXPECT_STREQ(orientation, "rd");
+    ktxTexture2_Destroy(texture);
+
+    // Only level 0 images may be given when generating mipmaps.
+    images[1].level = 1;
+    images[1].layer = 0;
+    images[1].width = width / 2;
+    images[1].height = height / 2;
+    EXPECT_EQ(ktxTexture2_CreateFromImages(images, numLayers, &params,
+                                           &texture),
+              KTX_INVALID_OPERATION);
+    // A missing image is an error.
+    EXPECT_EQ(ktxTexture2_CreateFromImages(images, 1, &params, &texture),
+              KTX_INVALID_VALUE);
+}
+
+TEST(ktxTexture2_CreateFromImagesTest, GenerateVolumeMipmaps) {
+    // 4x4x4 volume whose slices are 0, 64, 128 and 192.
+    const ktx_uint32_t size = 4;
+    std::vector<ktx_uint8_t> pixels[size];
+    ktxSourceImage images[size];
+    for (ktx_uint32_t z = 0; z < size; z++) {
+        pixels[z].assign(size * size, (ktx_uint8_t)(z * 64));
+        images[z] = { pixels[z].data(), size, size, 1, 1,
+                      KHR_DF_TRANSFER_LINEAR, KHR_DF_PRIMARIES_BT709,
+                      0, 0, z };
+    }
+
+    ktxImageParams params;
+    memset(&params, 0, sizeof(params));
+    params.structSize = sizeof(params);
+    params.threadCount = 2;
+    params.baseDepth = size;
+    params.generateMipmaps = KTX_TRUE;
+    params.mipFilter = "box";
+
+    ktxTexture2* texture;
+    ASSERT_EQ(ktxTexture2_CreateFromImages(images, size, &params, &texture),
+              KTX_SUCCESS);
+    EXPECT_EQ(texture->numDimensions, 3U);
+    EXPECT_EQ(texture->numLevels, 3U);
+    // Each slice of a level averages the 2 slices above it.
+    const ktx_uint8_t expected[][2] = { { 32, 160 }, { 96, 96 } };
+    for (ktx_uint32_t level = 1; level < texture->numLevels; level++) {
+        ktx_uint32_t levelSize = size >> level;
+        for (ktx_uint32_t z = 0; z < levelSize; z++) {
+            ktx_size_t offset;
+            ASSERT_EQ(ktxTexture_GetImageOffset(ktxTexture(texture), level,
+                                                0, z, &offset),
+                      KTX_SUCCESS);
+            for (ktx_uint32_t i = 0; i < levelSize * levelSize; i++)
+                EXPECT_EQ(texture->pData[offset + i], expected[level - 1][z])
+                    << "level " << level << " slice " << z;
+        }
+    }
+    ktxTexture2_Destroy(texture);
+}
+
+TEST(ktxTexture2_CreateFromImagesTest, ProcessImages) {
+    // 2x2 RG image. Top row is (1, 2), bottom row is (3, 4).
+    const ktx_uint8_t pixels[] = { 1, 2, 1, 2, 3, 4, 3, 4 };
+    ktxSourceImage image = { pixels, 2, 2, 2, 1, KHR_DF_TRANSFER_LINEAR,
+                             KHR_DF_PRIMARIES_BT709, 0, 0, 0 };
+
+    ktxImageParams params;
+    memset(&params, 0, sizeof(params));
+    params.structSize = sizeof(params);
+    params.targetComponentCount = 4;
+    params.lowerLeftMapsToS0T0 = KTX_TRUE;
+    memcpy(params.inputSwizzle, "gra1", 4);
+
+    ktxTexture2* texture;
+    ASSERT_EQ(ktxTexture2_CreateFromImages(&image, 1, &params, &texture),
+              KTX_SUCCESS);
+    EXPECT_EQ(texture->vkFormat, (ktx_uint32_t)VK_FORMAT_R8G8B8A8_UNORM);
+    EXPECT_EQ(texture->numLevels, 1U);
+    // Flipped, given 0 blue and 255 alpha, then swizzled.
+    const ktx_uint8_t expected[] = { 4, 3, 255, 255, 4, 3, 255, 255,
+                                     2, 1, 255, 255, 2, 1, 255, 255 };
+    ASSERT_EQ(texture->dataSize, sizeof(expected));
+    EXPECT_EQ(memcmp(texture->pData, expected, sizeof(expected)), 0);
+    char* orientation;
+    unsigned int len;
+    ASSERT_EQ(ktxHashList_FindValue(&texture->kvDataHead, KTX_ORIENTATION_KEY,
+                                    &len, (void**)&orientation), KTX_SUCCESS);
+    EXPECT_STREQ(orientation, "ru");
+    ktxTexture2_Destroy(texture);
+
+    // There are no 16-bit sRGB formats so 16-bit sRGB images are UNORM.
+    const ktx_uint16_t pixels16[] = { 1, 2, 1, 2, 3, 4, 3, 4 };
+    image.pData = (const ktx_uint8_t*)pixels16;
+    image.componentSize = 2;
+    image.oetf = KHR_DF_TRANSFER_SRGB;
+    ASSERT_EQ(ktxTexture2_CreateFromImages(&image, 1, &params, &texture),
+              KTX_SUCCESS);
+    EXPECT_EQ(texture->vkFormat, (ktx_uint32_t)VK_FORMAT_R16G16B16A16_UNORM);
+    ktxTexture2_Destroy(texture);
+
+    params.mipWrapMode = KTX_IMAGE_WRAP_REFLECT + 1;
+    EXPECT_EQ(ktxTexture2_CreateFromImages(&image, 1, &params, &texture),
+              KTX_INVALID_VALUE);
+}
+
+TEST(ktxTexture2_CreateCubemapFromEquirectTest, Prefilter) {
+    // Top half of the panorama is (2, 1, 0.5), the bottom half 0.
+    const ktx_uint32_t width = 32, height = 16;
+    std::vector<float> pixels(width * height * 3, 0.0f);
+    for (ktx_uint32_t i = 0; i < width * height / 2; i++) {
+        pixels[i * 3] = 2.0f;
+        pixels[i * 3 + 1] = 1.0f;
+        pixels[i * 3 + 2] = 0.5f;
+    }
+
+    ktxCubemapParams params;
+    memset(&params, 0, sizeof(params));
+    params.structSize = sizeof(params);
+    params.threadCount = 2;
+    params.vkFormat = VK_FORMAT_R32G32B32A32_SFLOAT;
+
+    ktxTexture2* texture;
+    ASSERT_EQ(ktxTexture2_CreateCubemapFromEquirect(pixels.data(), width,
+                                                    height, 3, &params,
+                                                    &texture),
+              KTX_SUCCESS);
+    EXPECT_TRUE(texture->isCubemap);
+    EXPECT_EQ(texture->baseWidth, width / 4);
+    EXPECT_EQ(texture->numLevels, 4U);
+    // Level 0 of +Y sees only the top half and -Y only the bottom half.
+    ktx_size_t offset;
+    ASSERT_EQ(ktxTexture_GetImageOffset(ktxTexture(texture), 0, 0, 2,
+                                        &offset), KTX_SUCCESS);
+    const float* texel = (const float*)(texture->pData + offset);
+    EXPECT_FLOAT_EQ(texel[0], 2.0f);
+    EXPECT_FLOAT_EQ(texel[3], 1.0f);
+    ASSERT_EQ(ktxTexture_GetImageOffset(ktxTexture(texture), 0, 0, 3,
+                                        &offset), KTX_SUCCESS);
+    texel = (const float*)(texture->pData + offset);
+    EXPECT_FLOAT_EQ(texel[0], 0.0f);
+    // The roughest level of +Y is lit by both halves but more by the top.
+    ktx_uint32_t last = texture->numLevels - 1;
+    ASSERT_EQ(ktxTexture_GetImageOffset(ktxTexture(texture), last, 0, 2,
+                                        &offset), KTX_SUCCESS);
+    texel = (const float*)(texture->pData + offset);
+    EXPECT_GT(texel[0], 1.0f);
+    EXPECT_LT(texel[0], 2.0f);
+    EXPECT_NEAR(texel[1], texel[0] / 2, 1e-5);
+    ktxTexture2_Destroy(texture);
+
+    // Prefiltering a constant panorama gives the same constant.
+    std::fill(pixels.begin(), pixels.end(), 0.75f);
+    params.vkFormat = 0;
+    ASSERT_EQ(ktxTexture2_CreateCubemapFromEquirect(pixels.data(), width,
+                                                    height, 3, &params,
+                                                    &texture),
+              KTX_SUCCESS);
+    EXPECT_EQ(texture->vkFormat,
+              (ktx_uint32_t)VK_FORMAT_R16G16B16A16_SFLOAT);
+    const ktx_uint16_t* halves = (const ktx_uint16_t*)texture->pData;
+    for (ktx_size_t i = 0; i < texture->dataSize / 2; i++)
+        EXPECT_EQ(halves[i], i % 4 == 3 ? 0x3c00 : 0x3a00) << i;
+    ktxTexture2_Destroy(texture);
+
+    params.numLevels = 5;
+    EXPECT_EQ(ktxTexture2_CreateCubemapFromEquirect(pixels.data(), width,
+                                                    height, 3, &params,
+                                                    &texture),
+              KTX_INVALID_VALUE);
+}
+
+////////////////////////////////////////////
+// ktxTexture_GetSubresourceLayouts tests
+///////////////////////////////////////////
+
+// Check the rows of every subresource were copied to their new layout.
+static void
+checkRelayout(ktxTexture* texture, const ktxSubresourceLayout* layouts,
+              ktx_uint32_t numLayouts, const std::vector<ktx_uint8_t>& dst)
+{
+    std::vector<ktxSubresourceLayout> src(numLayouts);
+    ASSERT_EQ(ktxTexture_GetSubresourceLayouts(texture, 0, 0, src.data(),
+                                               &numLayouts, nullptr),
+              KTX_SUCCESS);
+    for (ktx_uint32_t i = 0; i < numLayouts; i++) {
+        ktx_uint32_t numSlices
+                    = (ktx_uint32_t)(layouts[i].size / layouts[i].slicePitch);
+        for (ktx_uint32_t slice = 0; slice < numSlices; slice++) {
+            for (ktx_uint32_t row = 0; row < layouts[i].rowCount; row++) {
+                EXPECT_EQ(memcmp(&dst[layouts[i].offset
+                                     + slice * layouts[i].slicePitch
+                                     + row * layouts[i].rowPitch],
+                                 texture->pData + src[i].offset
+                                     + slice * src[i].slicePitch
+                                     + row * src[i].rowPitch,
+                                 layouts[i].rowSize), 0)
+                    << "subresource " << i << " slice " << slice
+                    << " row " << row;
+            }
+        }
+    }
+}
+
+TEST(ktxTexture_GetSubresourceLayoutsTest, PaddedRowsArray) {
+    ktxTextureCreateInfo createInfo;
+    ktxTexture1* texture;
+
+    createInfo.glInternalformat = GL_RGB8;
+    createInfo.baseWidth = 5;
+    createInfo.baseHeight = 3;
+    createInfo.baseDepth = 1;
+    createInfo.numDimensions = 2;
+    createInfo.numLevels = 2;
+    createInfo.numLayers = 2;
+    createInfo.numFaces = 1;
+    createInfo.isArray = KTX_TRUE;
+    createInfo.generateMipmaps = KTX_FALSE;
+    ASSERT_EQ(ktxTexture1_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+                                 &texture), KTX_SUCCESS);
+    for (ktx_size_t i = 0; i < texture->dataSize; i++)
+        texture->pData[i] = (ktx_uint8_t)(i * 7);
+
+    // Layouts of the texture's own data.
+    ktx_uint32_t numLayouts = 0;
+    ktx_size_t totalSize;
+    ASSERT_EQ(ktxTexture_GetSubresourceLayouts(ktxTexture(texture), 0, 0,
+                                               nullptr, &numLayouts,
+                                               &totalSize), KTX_SUCCESS);
+    ASSERT_EQ(numLayouts, 4U);
+    EXPECT_EQ(totalSize, texture->dataSize);
+    std::vector<ktxSubresourceLayout> layouts(numLayouts);
+    ASSERT_EQ(ktxTexture_GetSubresourceLayouts(ktxTexture(texture), 0, 0,
+                                               layouts.data(), &numLayouts,
+                                               nullptr), KTX_SUCCESS);
+    const ktx_uint32_t expectedLevel[] = { 0, 1, 0, 1 };
+    const ktx_uint32_t expectedLayer[] = { 0, 0, 1, 1 };
+    for (ktx_uint32_t i = 0; i < numLayouts; i++) {
+        ktx_size_t offset;
+        EXPECT_EQ(layouts[i].level, expectedLevel[i]);
+        EXPECT_EQ(layouts[i].layer, expectedLayer[i]);
+        ktxTexture_GetImageOffset(ktxTexture(texture), layouts[i].level,
+                                  layouts[i].layer, 0, &offset);
+        EXPECT_EQ(layouts[i].offset, offset);
+        EXPECT_EQ(layouts[i].rowPitch,
+                  ktxTexture_GetRowPitch(ktxTexture(texture), layouts[i].level));
+        EXPECT_EQ(layouts[i].size,
+                  ktxTexture_GetImageSize(ktxTexture(texture),
+                                          layouts[i].level));
+    }
+    EXPECT_EQ(layouts[0].rowSize, 15U);
+    EXPECT_EQ(layouts[0].rowPitch, 16U);
+    EXPECT_EQ(layouts[1].width, 2U);
+    EXPECT_EQ(layouts[1].rowCount, 1U);
+
+    // Layouts for a Direct3D 12 upload buffer.
+    ASSERT_EQ(ktxTexture_GetSubresourceLayouts(ktxTexture(texture), 256, 512,
+                                               layouts.data(), &numLayouts,
+                                               &totalSize), KTX_SUCCESS);
+    const ktx_size_t expectedOffset[] = { 0, 1024, 1536, 2560 };
+    for (ktx_uint32_t i = 0; i < numLayouts; i++) {
+        EXPECT_EQ(layouts[i].offset, expectedOffset[i]);
+        EXPECT_EQ(layouts[i].rowPitch, 256U);
+        EXPECT_EQ(layouts[i].size, 256U * layouts[i].rowCount);
+    }
+    EXPECT_EQ(totalSize, 2560U + 256U);
+    std::vector<ktx_uint8_t> dst(totalSize);
+    ASSERT_EQ(ktxTexture_CopyToSubresourceLayouts(ktxTexture(texture),
+                                                  layouts.data(), numLayouts,
+                                                  dst.data(), dst.size()),
+              KTX_SUCCESS);
+    checkRelayout(ktxTexture(texture), layouts.data(), numLayouts, dst);
+    EXPECT_EQ(ktxTexture_CopyToSubresourceLayouts(ktxTexture(texture),
+                                                  layouts.data(), numLayouts,
+                                                  dst.data(),
+                                                  expectedOffset[3]
+                                                  + layouts[3].rowSize - 1),
+              KTX_INVALID_VALUE);
+
+    ktxTexture_Destroy(ktxTexture(texture));
+}
+
+TEST(ktxTexture_GetSubresourceLayoutsTest, Volume) {
+    ktxTextureCreateInfo createInfo;
+    ktxTexture2* texture;
+
+    createInfo.vkFormat = VK_FORMAT_R8_UNORM;
+    createInfo.baseWidth = 6;
+    createInfo.baseHeight = 4;
+    createInfo.baseDepth = 4;
+    createInfo.numDimensions = 3;
+    createInfo.numLevels = 2;
+    createInfo.numLayers = 1;
+    createInfo.numFaces = 1;
+    createInfo.isArray = KTX_FALSE;
+    createInfo.generateMipmaps = KTX_FALSE;
+    ASSERT_EQ(ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+                                 &texture), KTX_SUCCESS);
+    for (ktx_size_t i = 0; i < texture->dataSize; i++)
+        texture->pData[i] = (ktx_uint8_t)(i * 13);
+
+    ktx_uint32_t numLayouts = 2;
+    ktx_size_t totalSize;
+    ktxSubresourceLayout layouts[2];
+    ASSERT_EQ(ktxTexture_GetSubresourceLayouts(ktxTexture(texture), 8, 4,
+                                               layouts, &numLayouts,
+                                               &totalSize), KTX_SUCCESS);
+    ASSERT_EQ(numLayouts, 2U);
+    EXPECT_EQ(layouts[0].depth, 4U);
+    EXPECT_EQ(layouts[0].rowPitch, 8U);
+    EXPECT_EQ(layouts[0].slicePitch, 32U);
+    EXPECT_EQ(layouts[0].size, 128U);
+    EXPECT_EQ(layouts[1].offset, 128U);
+    EXPECT_EQ(layouts[1].depth, 2U);
+    EXPECT_EQ(layouts[1].slicePitch, 16U);
+    EXPECT_EQ(totalSize, 128U + 32U);
+    std::vector<ktx_uint8_t> dst(totalSize);
+    ASSERT_EQ(ktxTexture_CopyToSubresourceLayouts(ktxTexture(texture),
+                                                  layouts, numLayouts,
+                                                  dst.data(), dst.size()),
+              KTX_SUCCESS);
+    checkRelayout(ktxTexture(texture), layouts, numLayouts, dst);
+
+    numLayouts = 1;
+    EXPECT_EQ(ktxTexture_GetSubresourceLayouts(ktxTexture(texture), 0, 0,
+                                               layouts, &numLayouts, nullptr),
+              KTX_INVALID_VALUE);
+
+    ktxTexture_Destroy(ktxTexture(texture));
+}
+
+////////////////////////////////////////////
+// ktxTexture_VkUpload tests
+///////////////////////////////////////////
+
+// A mock Vulkan device that records how the loader uses it.
+namespace vkmock {
+    std::vector<std::string> calls;
+    std::vector<VkMemoryToImageCopyEXT> hostCopyRegions;
+    VkImageLayout hostCopyLayout;
+    VkImageUsageFlags imageUsage;
+    std::vector<uint8_t> stagingMemory;
+    std::vector<VkBufferImageCopy> copyRegions;
+    std::vector<VkSparseImageMemoryBind> imageBinds;
+    std::vector<VkSparseMemoryBind> opaqueBinds;
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    uint64_t numMemories;
+    int liveMemories;
+    // Whether the application "enabled" VK_EXT_host_image_copy.
+    bool hostImageCopyEnabled;
+
+    // Stands in for the functions the tests never reach.
+    VKAPI_ATTR void VKAPI_CALL
+    Unreached(void) { ADD_FAILURE() << "Unexpected Vulkan call"; }
+    VKAPI_ATTR void VKAPI_CALL
+    GetPhysicalDeviceMemoryProperties(VkPhysicalDevice,
+                                      VkPhysicalDeviceMemoryProperties* p) {
+        memset(p, 0, sizeof(*p));
+        p->memoryTypeCount = 1;
+        p->memoryTypes[0].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                                        | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+                                        | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    }
+    VKAPI_ATTR VkResult VKAPI_CALL
+    GetPhysicalDeviceImageFormatProperties(VkPhysicalDevice, VkFormat,
+                                           VkImageType, VkImageTiling,
+                                           VkImageUsageFlags,
+                                           VkImageCreateFlags,
+                                           VkImageFormatProperties* p) {
+        memset(p, 0, sizeof(*p));
+        p->maxMipLevels = 16;
+        p->maxArrayLayers = 16;
+        return VK_SUCCESS;
+    }
+    // A format that can be sampled but not blitted.
+    VKAPI_ATTR void VKAPI_CALL
+    GetPhysicalDeviceFormatPropertiesNoBlit(VkPhysicalDevice, VkFormat,
+                                            VkFormatProperties* p) {
+        memset(p, 0, sizeof(*p));
+        p->optimalTilingFeatures = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
+                             | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    }
+    VKAPI_ATTR void VKAPI_CALL
+    GetPhysicalDeviceProperties2(VkPhysicalDevice,
+                                 VkPhysicalDeviceProperties2* p) {
+        static const VkImageLayout layouts[] = {
+            VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        };
+        auto hostCopy = (VkPhysicalDeviceHostImageCopyPropertiesEXT*)p->pNext;
+        if (hostCopy->pCopyDstLayouts) {
+            hostCopy->copyDstLayoutCount
+                = std::min(hostCopy->copyDstLayoutCount, 2U);
+            memcpy(hostCopy->pCopyDstLayouts, layouts,
+                   hostCopy->copyDstLayoutCount * sizeof(VkImageLayout));
+        } else {
+            hostCopy->copyDstLayoutCount = 2;
+        }
+    }
+    VKAPI_ATTR VkResult VKAPI_CALL
+    AllocateCommandBuffers(VkDevice, const VkCommandBufferAllocateInfo*,
+                           VkCommandBuffer* pCmdBuffer) {
+        *pCmdBuffer = (VkCommandBuffer)1;
+        return VK_SUCCESS;
+    }
+    VKAPI_ATTR void VKAPI_CALL
+    FreeCommandBuffers(VkDevice, VkCommandPool, uint32_t,
+                       const VkCommandBuffer*) { }
+    VKAPI_ATTR VkResult VKAPI_CALL
+    CreateImage(VkDevice, const VkImageCreateInfo* pInfo,
+                const VkAllocationCallbacks*, VkImage* pImage) {
+        imageUsage = pInfo->usage;
+        *pImage = (VkImage)2;
+        return VK_SUCCESS;
+    }
+    VKAPI_ATTR void VKAPI_CALL
+    DestroyImage(VkDevice, VkImage, const VkAllocationCallbacks*) { }
+    VKAPI_ATTR void VKAPI_CALL
+    GetImageMemoryRequirements(VkDevice, VkImage, VkMemoryRequirements* p) {
+        p->size = 1 << 16;
+        p->alignment = 256;
+        p->memoryTypeBits = 1;
+    }
+    VKAPI_ATTR VkResult VKAPI_CALL
+    CreateBuffer(VkDevice, const VkBufferCreateInfo* pInfo,
+                 const VkAllocationCallbacks*, VkBuffer* pBuffer) {
+        stagingMemory.resize(pInfo->size);
+        *pBuffer = (VkBuffer)3;
+        return VK_SUCCESS;
+    }
+    VKAPI_ATTR void VKAPI_CALL
+    DestroyBuffer(VkDevice, VkBuffer, const VkAllocationCallbacks*) { }
+    VKAPI_ATTR void VKAPI_CALL
+    GetBufferMemoryRequirements(VkDevice, VkBuffer, VkMemoryRequirements* p) {
+        p->size = stagingMemory.size();
+        p->alignment = 256;
+        p->memoryTypeBits = 1;
+    }
+    VKAPI_ATTR VkResult VKAPI_CALL
+    AllocateMemory(VkDevice, const VkMemoryAllocateInfo*,
+                   const VkAllocationCallbacks*, VkDeviceMemory* pMemory) {
+        *pMemory = (VkDeviceMemory)++numMemories;
+        liveMemories++;
+        return VK_SUCCESS;
+    }
+    VKAPI_ATTR void VKAPI_CALL
+    FreeMemory(VkDevice, VkDeviceMemory memory, const VkAllocationCallbacks*) {
+        if (memory != VK_NULL_HANDLE)
+            liveMemories--;
+    }
+    VKAPI_ATTR VkResult VKAPI_CALL
+    BindBufferMemory(VkDevice, VkBuffer, VkDeviceMemory, VkDeviceSize) {
+        return VK_SUCCESS;
+    }
+    VKAPI_ATTR VkResult VKAPI_CALL
+    BindImageMemory(VkDevice, VkImage, VkDeviceMemory, VkDeviceSize) {
+        return VK_SUCCESS;
+    }
+    VKAPI_ATTR VkResult VKAPI_CALL
+    MapMemory(VkDevice, VkDeviceMemory, VkDeviceSize, VkDeviceSize,
+              VkMemoryMapFlags, void** ppData) {
+        *ppData = stagingMemory.data();
+        return VK_SUCCESS;
+    }
+    VKAPI_ATTR void VKAPI_CALL
+    UnmapMemory(VkDevice, VkDeviceMemory) { }
+    VKAPI_ATTR VkResult VKAPI_CALL
+    BeginCommandBuffer(VkCommandBuffer, const VkCommandBufferBeginInfo*) {
+        calls.push_back("vkBeginCommandBuffer");
+        return VK_SUCCESS;
+    }
+    VKAPI_ATTR VkResult VKAPI_CALL
+    EndCommandBuffer(VkCommandBuffer) { return VK_SUCCESS; }
+    VKAPI_ATTR void VKAPI_CALL
+    CmdPipelineBarrier(VkCommandBuffer, VkPipelineStageFlags,
+                       VkPipelineStageFlags, VkDependencyFlags,
+                       uint32_t, const VkMemoryBarrier*,
+                       uint32_t, const VkBufferMemoryBarrier*,
+                       uint32_t imageMemoryBarrierCount,
+                       const VkImageMemoryBarrier* pImageMemoryBarriers) {
+        imageBarriers.insert(imageBarriers.end(), pImageMemoryBarriers,
+                             pImageMemoryBarriers + imageMemoryBarrierCount);
+    }
+    VKAPI_ATTR void VKAPI_CALL
+    CmdCopyBufferToImage(VkCommandBuffer, VkBuffer, VkImage, VkImageLayout,
+                         uint32_t regionCount,
+                         const VkBufferImageCopy* pRegions) {
+        calls.push_back("vkCmdCopyBufferToImage");
+        copyRegions.assign(pRegions, pRegions + regionCount);
+    }
+    VKAPI_ATTR VkResult VKAPI_CALL
+    CreateFence(VkDevice, const VkFenceCreateInfo*,
+                const VkAllocationCallbacks*, VkFence* pFence) {
+        *pFence = (VkFence)5;
+        return VK_SUCCESS;
+    }
+    VKAPI_ATTR void VKAPI_CALL
+    DestroyFence(VkDevice, VkFence, const VkAllocationCallbacks*) { }
+    VKAPI_ATTR VkResult VKAPI_CALL
+    QueueSubmit(VkQueue, uint32_t, const VkSubmitInfo*, VkFence) {
+        calls.push_back("vkQueueSubmit");
+        return VK_SUCCESS;
+    }
+    VKAPI_ATTR VkResult VKAPI_CALL
+    WaitForFences(VkDevice, uint32_t, const VkFence*, VkBool32, uint64_t) {
+        return VK_SUCCESS;
+    }
+    VKAPI_ATTR VkResult VKAPI_CALL
+    QueueWaitIdle(VkQueue) { return VK_SUCCESS; }
+    // 8x8 texel tiles with the levels below 8x8 in a tail per layer.
+    VKAPI_ATTR void VKAPI_CALL
+    GetImageSparseMemoryRequirements(VkDevice, VkImage, uint32_t* pCount,
+                                     VkSparseImageMemoryRequirements* p) {
+        if (p) {
+            memset(p, 0, sizeof(*p));
+            p->formatProperties.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            p->formatProperties.imageGranularity = { 8, 8, 1 };
+            p->imageMipTailFirstLod = 1;
+            p->imageMipTailSize = 256;
+            p->imageMipTailOffset = 1 << 14;
+            p->imageMipTailStride = 1 << 12;
+        }
+        *pCount = 1;
+    }
+    VKAPI_ATTR VkResult VKAPI_CALL
+    QueueBindSparse(VkQueue, uint32_t, const VkBindSparseInfo* pInfo,
+                    VkFence) {
+        calls.push_back("vkQueueBindSparse");
+        for (uint32_t i = 0; i < pInfo->imageBindCount; i++) {
+            imageBinds.insert(imageBinds.end(), pInfo->pImageBinds[i].pBinds,
+                              pInfo->pImageBinds[i].pBinds
+                              + pInfo->pImageBinds[i].bindCount);
+        }
+        for (uint32_t i = 0; i < pInfo->imageOpaqueBindCount; i++) {
+            opaqueBinds.insert(opaqueBinds.end(),
+                               pInfo->pImageOpaqueBinds[i].pBinds,
+                               pInfo->pImageOpaqueBinds[i].pBinds
+                               + pInfo->pImageOpaqueBinds[i].bindCount);
+        }
+        return VK_SUCCESS;
+    }
+    VKAPI_ATTR VkResult VKAPI_CALL
+    CopyMemoryToImageEXT(VkDevice, const VkCopyMemoryToImageInfoEXT* pInfo) {
+        calls.push_back("vkCopyMemoryToImageEXT");
+        hostCopyLayout = pInfo->dstImageLayout;
+        hostCopyRegions.assign(pInfo->pRegions,
+                               pInfo->pRegions + pInfo->regionCount);
+        return VK_SUCCESS;
+    }
+    VKAPI_ATTR VkResult VKAPI_CALL
+    TransitionImageLayoutEXT(VkDevice, uint32_t,
+                             const VkHostImageLayoutTransitionInfoEXT*) {
+        calls.push_back("vkTransitionImageLayoutEXT");
+        return VK_SUCCESS;
+    }
+
+    // The loader looks up extension and sparse commands by name.
+    VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL
+    GetInstanceProcAddr(VkInstance, const char* pName) {
+        if (!strcmp(pName, "vkGetPhysicalDeviceProperties2"))
+            return (PFN_vkVoidFunction)GetPhysicalDeviceProperties2;
+        return nullptr;
+    }
+    VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL
+    GetDeviceProcAddr(VkDevice, const char* pName) {
+        if (!strcmp(pName, "vkGetImageSparseMemoryRequirements"))
+            return (PFN_vkVoidFunction)GetImageSparseMemoryRequirements;
+        if (!strcmp(pName, "vkQueueBindSparse"))
+            return (PFN_vkVoidFunction)QueueBindSparse;
+        if (hostImageCopyEnabled) {
+            if (!strcmp(pName, "vkCopyMemoryToImageEXT"))
+                return (PFN_vkVoidFunction)CopyMemoryToImageEXT;
+            if (!strcmp(pName, "vkTransitionImageLayoutEXT"))
+                return (PFN_vkVoidFunction)TransitionImageLayoutEXT;
+        }
+        return nullptr;
+    }
+
+    ktxVulkanFunctions
+    functions(bool hostImageCopy)
+    {
+        ktxVulkanFunctions f;
+        hostImageCopyEnabled = hostImageCopy;
+        memset(&f, 0, sizeof(f));
+        f.vkGetInstanceProcAddr = GetInstanceProcAddr;
+        f.vkGetDeviceProcAddr = GetDeviceProcAddr;
+        f.vkAllocateCommandBuffers = AllocateCommandBuffers;
+        f.vkAllocateMemory = AllocateMemory;
+        f.vkBeginCommandBuffer = BeginCommandBuffer;
+        f.vkBindBufferMemory = BindBufferMemory;
+        f.vkBindImageMemory = BindImageMemory;
+        f.vkCmdBlitImage = (PFN_vkCmdBlitImage)Unreached;
+        f.vkCmdCopyBufferToImage = CmdCopyBufferToImage;
+        f.vkCmdPipelineBarrier = CmdPipelineBarrier;
+        f.vkCreateImage = CreateImage;
+        f.vkDestroyImage = DestroyImage;
+        f.vkCreateBuffer = CreateBuffer;
+        f.vkDestroyBuffer = DestroyBuffer;
+        f.vkCreateFence = CreateFence;
+        f.vkDestroyFence = DestroyFence;
+        f.vkEndCommandBuffer = EndCommandBuffer;
+        f.vkFreeCommandBuffers = FreeCommandBuffers;
+        f.vkFreeMemory = FreeMemory;
+        f.vkGetBufferMemoryRequirements = GetBufferMemoryRequirements;
+        f.vkGetImageMemoryRequirements = GetImageMemoryRequirements;
+        f.vkGetImageSubresourceLayout
+                    = (PFN_vkGetImageSubresourceLayout)Unreached;
+        f.vkGetPhysicalDeviceImageFormatProperties
+                    = GetPhysicalDeviceImageFormatProperties;
+        f.vkGetPhysicalDeviceFormatProperties
+                    = (PFN_vkGetPhysicalDeviceFormatProperties)Unreached;
+        f.vkGetPhysicalDeviceMemoryProperties
+                    = GetPhysicalDeviceMemoryProperties;
+        f.vkMapMemory = MapMemory;
+        f.vkQueueSubmit = QueueSubmit;
+        f.vkQueueWaitIdle = QueueWaitIdle;
+        f.vkUnmapMemory = UnmapMemory;
+        f.vkWaitForFences = WaitForFences;
+        return f;
+    }
+}
+
+class ktxTexture2_VkUploadTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        ktxTextureCreateInfo createInfo;
+
+        createInfo.vkFormat = VK_FORMAT_R8G8B8A8_UNORM;
+        createInfo.baseWidth = 16;
+        createInfo.baseHeight = 16;
+        createInfo.baseDepth = 1;
+        createInfo.numDimensions = 2;
+        createInfo.numLevels = 3;
+        createInfo.numLayers = 2;
+        createInfo.numFaces = 1;
+        createInfo.isArray = KTX_TRUE;
+        createInfo.generateMipmaps = KTX_FALSE;
+        ASSERT_EQ(ktxTexture2_Create(&createInfo,
+                                     KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+                                     &texture), KTX_SUCCESS);
+        vkmock::calls.clear();
+        vkmock::hostCopyRegions.clear();
+        vkmock::copyRegions.clear();
+        vkmock::imageBinds.clear();
+        vkmock::opaqueBinds.clear();
+        vkmock::imageBarriers.clear();
+        vkmock::imageUsage = 0;
+        vkmock::liveMemories = 0;
+        for (ktx_size_t i = 0; i < texture->dataSize; i++)
+            texture->pData[i] = (ktx_uint8_t)i;
+    }
+
+    void TearDown() override {
+        if (texture)
+            ktxTexture_Destroy(ktxTexture(texture));
+    }
+
+    KTX_error_code construct(ktxVulkanDeviceInfo& vdi, bool hostImageCopy) {
+        ktxVulkanFunctions functions = vkmock::functions(hostImageCopy);
+        return ktxVulkanDeviceInfo_ConstructEx(&vdi, (VkInstance)1,
+                                               (VkPhysicalDevice)1,
+                                               (VkDevice)1, (VkQueue)1,
+                                               (VkCommandPool)1, nullptr,
+                                               &functions);
+    }
+
+    // @a hostImageCopy says whether the device has VK_EXT_host_image_copy
+    // and @a uploadFlags whether the caller enabled its feature.
+    KTX_error_code upload(bool hostImageCopy, VkImageLayout finalLayout,
+                          ktxVulkanUploadFlags uploadFlags
+                                = KTX_VK_UPLOAD_HOST_IMAGE_COPY_BIT) {
+        ktxVulkanDeviceInfo vdi;
+        KTX_error_code result;
+
+        result = construct(vdi, hostImageCopy);
+        if (result != KTX_SUCCESS)
+            return result;
+        result = ktxTexture2_VkUploadEx_WithFlags(texture, &vdi, &vkTexture,
+                                                  VK_IMAGE_TILING_OPTIMAL,
+                                                  VK_IMAGE_USAGE_SAMPLED_BIT,
+                                                  finalLayout, uploadFlags);
+        ktxVulkanDeviceInfo_Destruct(&vdi);
+        return result;
+    }
+
+    ktxTexture2* texture = nullptr;
+    ktxVulkanTexture vkTexture;
+};
+
+TEST(ktxVulkanFunctionsTest, SizeIsStable) {
+    // Applications built against older headers allocate this, inside
+    // ktxVulkanDeviceInfo, so commands must not be added to it.
+    EXPECT_EQ(sizeof(ktxVulkanFunctions), 30 * sizeof(PFN_vkVoidFunction));
+}
+
+TEST_F(ktxTexture2_VkUploadTest, HostImageCopy) {
+    ASSERT_EQ(upload(true, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+              KTX_SUCCESS);
+    std::vector<std::string> expected = {
+        "vkTransitionImageLayoutEXT", "vkCopyMemoryToImageEXT"
+    };
+    EXPECT_EQ(vkmock::calls, expected);
+    EXPECT_NE(vkmock::imageUsage & VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT, 0U);
+    EXPECT_EQ(vkmock::hostCopyLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    ASSERT_EQ(vkmock::hostCopyRegions.size(), 3U);
+    for (auto& region : vkmock::hostCopyRegions) {
+        ktx_uint32_t level = region.imageSubresource.mipLevel;
+        ktx_size_t offset;
+        ASSERT_LT(level, 3U);
+        ktxTexture_GetImageOffset(ktxTexture(texture), level, 0, 0, &offset);
+        // The copies are straight from the texture's data.
+        EXPECT_EQ(region.pHostPointer, texture->pData + offset);
+        EXPECT_EQ(region.imageSubresource.layerCount, 2U);
+        EXPECT_EQ(region.imageExtent.width, 16U >> level);
+    }
+}
+
+TEST_F(ktxTexture2_VkUploadTest, StagingWithoutHostImageCopy) {
+    ASSERT_EQ(upload(false, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+              KTX_SUCCESS);
+    std::vector<std::string> expected = {
+        "vkBeginCommandBuffer", "vkCmdCopyBufferToImage", "vkQueueSubmit"
+    };
+    EXPECT_EQ(vkmock::calls, expected);
+    EXPECT_EQ(vkmock::imageUsage & VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT, 0U);
+}
+
+TEST_F(ktxTexture2_VkUploadTest, StagingUnlessHostImageCopyRequested) {
+    // The extension is there but the caller didn't say its feature is on.
+    ASSERT_EQ(upload(true, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0),
+              KTX_SUCCESS);
+    std::vector<std::string> expected = {
+        "vkBeginCommandBuffer", "vkCmdCopyBufferToImage", "vkQueueSubmit"
+    };
+    EXPECT_EQ(vkmock::calls, expected);
+    EXPECT_EQ(vkmock::imageUsage & VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT, 0U);
+}
+
+TEST_F(ktxTexture2_VkUploadTest, StagingForUnsupportedLayout) {
+    // The mock device can't copy from the host to this layout.
+    ASSERT_EQ(upload(true, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL),
+              KTX_SUCCESS);
+    EXPECT_TRUE(std::find(vkmock::calls.begin(), vkmock::calls.end(),
+                          "vkQueueSubmit") != vkmock::calls.end());
+    EXPECT_TRUE(vkmock::hostCopyRegions.empty());
+}
+
+TEST_F(ktxTexture2_VkUploadTest, Sparse) {
+    ktxVulkanDeviceInfo vdi;
+    ktxVulkanSparseTexture sparseTexture;
+
+    ASSERT_EQ(construct(vdi, false), KTX_SUCCESS);
+    ASSERT_EQ(ktxTexture_VkUploadSparse(ktxTexture(texture), &vdi,
+                                        &sparseTexture,
+                                        VK_IMAGE_USAGE_SAMPLED_BIT,
+                                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+              KTX_SUCCESS);
+    EXPECT_NE(vkmock::imageUsage & VK_IMAGE_USAGE_TRANSFER_DST_BIT, 0U);
+    EXPECT_EQ(sparseTexture.mipTailFirstLod, 1U);
+    EXPECT_EQ(sparseTexture.pageSize, 256U);
+    // 2x2 tiles in level 0 of each layer.
+    EXPECT_EQ(sparseTexture.numTiles, 8U);
+    VkExtent3D tileCount;
+    ktxVulkanSparseTexture_GetTileCount(&sparseTexture, 0, &tileCount);
+    EXPECT_EQ(tileCount.width, 2U);
+    EXPECT_EQ(tileCount.height, 2U);
+    EXPECT_EQ(tileCount.depth, 1U);
+
+    // Only the mip tail, levels 1 and 2, is resident and uploaded.
+    ASSERT_EQ(vkmock::opaqueBinds.size(), 2U);
+    EXPECT_EQ(vkmock::opaqueBinds[1].resourceOffset, (1U << 14) + (1U << 12));
+    EXPECT_EQ(vkmock::opaqueBinds[1].memoryOffset, 256U);
+    EXPECT_TRUE(vkmock::imageBinds.empty());
+    ASSERT_EQ(vkmock::copyRegions.size(), 4U);
+    for (auto& region : vkmock::copyRegions) {
+        ktx_uint32_t level = region.imageSubresource.mipLevel;
+        ktx_size_t offset;
+        ASSERT_GE(level, 1U);
+        ktxTexture_GetImageOffset(ktxTexture(texture), level,
+                                  region.imageSubresource.baseArrayLayer, 0,
+                                  &offset);
+        EXPECT_EQ(region.imageExtent.width, 16U >> level);
+        EXPECT_EQ(memcmp(&vkmock::stagingMemory[region.bufferOffset],
+                         texture->pData + offset,
+                         ktxTexture_GetImageSize(ktxTexture(texture), level)),
+                  0);
+    }
+    EXPECT_EQ(vkmock::liveMemories, 1);
+    // The new image is transitioned once, as a whole.
+    ASSERT_EQ(vkmock::imageBarriers.size(), 2U);
+    EXPECT_EQ(vkmock::imageBarriers[0].oldLayout, VK_IMAGE_LAYOUT_UNDEFINED);
+    EXPECT_EQ(vkmock::imageBarriers[0].subresourceRange.levelCount, 3U);
+    EXPECT_EQ(vkmock::imageBarriers[0].subresourceRange.layerCount, 2U);
+
+    // Page in the bottom right tile of layer 1, twice.
+    vkmock::copyRegions.clear();
+    vkmock::imageBarriers.clear();
+    ktxVulkanSparseTile tiles[2] = { { 0, 1, 1, 1, 0 }, { 0, 1, 1, 1, 0 } };
+    ASSERT_EQ(ktxVulkanSparseTexture_PageIn(&sparseTexture,
+                                            ktxTexture(texture), &vdi,
+                                            2, tiles), KTX_SUCCESS);
+    ASSERT_EQ(vkmock::imageBinds.size(), 1U);
+    EXPECT_EQ(vkmock::imageBinds[0].subresource.arrayLayer, 1U);
+    EXPECT_EQ(vkmock::imageBinds[0].offset.x, 8);
+    EXPECT_EQ(vkmock::imageBinds[0].offset.y, 8);
+    EXPECT_EQ(vkmock::imageBinds[0].extent.width, 8U);
+    EXPECT_NE(vkmock::imageBinds[0].memory, (VkDeviceMemory)VK_NULL_HANDLE);
+    EXPECT_EQ(vkmock::imageBinds[0].memoryOffset, 0U);
+    ASSERT_EQ(vkmock::copyRegions.size(), 1U);
+    ktx_size_t layerOffset;
+    ktxTexture_GetImageOffset(ktxTexture(texture), 0, 1, 0, &layerOffset);
+    for (ktx_uint32_t row = 0; row < 8; row++) {
+        EXPECT_EQ(memcmp(&vkmock::stagingMemory[vkmock::copyRegions[0].bufferOffset
+                                                + row * 8 * 4],
+                         texture->pData + layerOffset + (8 + row) * 16 * 4
+                         + 8 * 4, 8 * 4), 0) << "row " << row;
+    }
+    EXPECT_EQ(vkmock::liveMemories, 2);
+    // Only level 0 of layer 1 is transitioned, to and from the final layout.
+    ASSERT_EQ(vkmock::imageBarriers.size(), 2U);
+    for (auto& barrier : vkmock::imageBarriers) {
+        EXPECT_EQ(barrier.subresourceRange.baseMipLevel, 0U);
+        EXPECT_EQ(barrier.subresourceRange.levelCount, 1U);
+        EXPECT_EQ(barrier.subresourceRange.baseArrayLayer, 1U);
+        EXPECT_EQ(barrier.subresourceRange.layerCount, 1U);
+    }
+    EXPECT_EQ(vkmock::imageBarriers[0].oldLayout,
+              VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    EXPECT_EQ(vkmock::imageBarriers[1].newLayout,
+              VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    VkDeviceMemory block = vkmock::imageBinds[0].memory;
+
+    // Another tile takes the next page of the same block.
+    vkmock::imageBinds.clear();
+    ktxVulkanSparseTile otherTile = { 0, 0, 0, 0, 0 };
+    ASSERT_EQ(ktxVulkanSparseTexture_PageIn(&sparseTexture,
+                                            ktxTexture(texture), &vdi,
+                                            1, &otherTile), KTX_SUCCESS);
+    ASSERT_EQ(vkmock::imageBinds.size(), 1U);
+    EXPECT_EQ(vkmock::imageBinds[0].memory, block);
+    EXPECT_EQ(vkmock::imageBinds[0].memoryOffset, 256U);
+    EXPECT_EQ(vkmock::liveMemories, 2);
+
+    // Already resident.
+    vkmock::imageBinds.clear();
+    vkmock::calls.clear();
+    ASSERT_EQ(ktxVulkanSparseTexture_PageIn(&sparseTexture,
+                                            ktxTexture(texture), &vdi,
+                                            1, tiles), KTX_SUCCESS);
+    EXPECT_TRUE(vkmock::calls.empty());
+
+    // Tiles in the mip tail or outside the image.
+    ktxVulkanSparseTile tailTile = { 1, 0, 0, 0, 0 };
+    ktxVulkanSparseTile outsideTile = { 0, 0, 2, 0, 0 };
+    EXPECT_EQ(ktxVulkanSparseTexture_PageIn(&sparseTexture,
+                                            ktxTexture(texture), &vdi,
+                                            1, &tailTile), KTX_INVALID_VALUE);
+    EXPECT_EQ(ktxVulkanSparseTexture_PageOut(&sparseTexture, &vdi,
+                                             1, &outsideTile),
+              KTX_INVALID_VALUE);
+
+    ASSERT_EQ(ktxVulkanSparseTexture_PageOut(&sparseTexture, &vdi, 1, tiles),
+              KTX_SUCCESS);
+    ASSERT_EQ(vkmock::imageBinds.size(), 1U);
+    EXPECT_EQ(vkmock::imageBinds[0].memory, (VkDeviceMemory)VK_NULL_HANDLE);
+    // The block is kept for reuse.
+    EXPECT_EQ(vkmock::liveMemories, 2);
+
+    // The released page is reused.
+    vkmock::imageBinds.clear();
+    ASSERT_EQ(ktxVulkanSparseTexture_PageIn(&sparseTexture,
+                                            ktxTexture(texture), &vdi,
+                                            1, tiles), KTX_SUCCESS);
+    ASSERT_EQ(vkmock::imageBinds.size(), 1U);
+    EXPECT_EQ(vkmock::imageBinds[0].memory, block);
+    EXPECT_EQ(vkmock::imageBinds[0].memoryOffset, 0U);
+    EXPECT_EQ(vkmock::liveMemories, 2);
+    ktxVulkanSparseTexture_Destruct(&sparseTexture, vdi.device, nullptr);
+    EXPECT_EQ(vkmock::liveMemories, 0);
+    ktxVulkanDeviceInfo_Destruct(&vdi);
+}
+
+TEST_F(ktxTexture2_VkUploadTest, CpuMipmapsWithoutBlit) {
+    ktxTextureCreateInfo createInfo;
+    ktxTexture2* mipTexture;
+    ktxVulkanDeviceInfo vdi;
+
+    createInfo.vkFormat = VK_FORMAT_R8G8B8A8_UNORM;
+    createInfo.baseWidth = 4;
+    createInfo.baseHeight = 4;
+    createInfo.baseDepth = 1;
+    createInfo.numDimensions = 2;
+    createInfo.numLevels = 1;
+    createInfo.numLayers = 2;
+    createInfo.numFaces = 1;
+    createInfo.isArray = KTX_TRUE;
+    createInfo.generateMipmaps = KTX_TRUE;
+    ASSERT_EQ(ktxTexture2_Create(&createInfo,
+                                 KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+                                 &mipTexture), KTX_SUCCESS);
+    for (ktx_size_t i = 0; i < mipTexture->dataSize; i++)
+        mipTexture->pData[i] = (ktx_uint8_t)i;
+
+    ktxVulkanFunctions functions = vkmock::functions(false);
+    functions.vkGetPhysicalDeviceFormatProperties
+                    = vkmock::GetPhysicalDeviceFormatPropertiesNoBlit;
+    ASSERT_EQ(ktxVulkanDeviceInfo_ConstructEx(&vdi, (VkInstance)1,
+                                              (VkPhysicalDevice)1,
+                                              (VkDevice)1, (VkQueue)1,
+                                              (VkCommandPool)1, nullptr,
+                                              &functions), KTX_SUCCESS);
+    // vkCmdBlitImage is Unreached in the mock.
+    ASSERT_EQ(ktxTexture2_VkUploadEx(mipTexture, &vdi, &vkTexture,
+                                     VK_IMAGE_TILING_OPTIMAL,
+                                     VK_IMAGE_USAGE_SAMPLED_BIT,
+                                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+              KTX_SUCCESS);
+    EXPECT_EQ(vkTexture.levelCount, 3U);
+    ASSERT_EQ(vkmock::copyRegions.size(), 3U);
+    for (ktx_uint32_t level = 0; level < 3; level++) {
+        const VkBufferImageCopy& region = vkmock::copyRegions[level];
+        EXPECT_EQ(region.imageSubresource.mipLevel, level);
+        EXPECT_EQ(region.imageSubresource.layerCount, 2U);
+        EXPECT_EQ(region.imageExtent.width, 4U >> level);
+        EXPECT_EQ(region.bufferOffset % 4, 0U);
+    }
+    const uint8_t* level0 = &vkmock::stagingMemory[0];
+    const uint8_t* level1
+            = &vkmock::stagingMemory[vkmock::copyRegions[1].bufferOffset];
+    EXPECT_EQ(memcmp(level0, mipTexture->pData, mipTexture->dataSize), 0);
+    // Box filtered 2x2 blocks of the base level, rounding half up.
+    for (ktx_uint32_t layer = 0; layer < 2; layer++) {
+        for (ktx_uint32_t c = 0; c < 4; c++) {
+            uint32_t sum = level0[layer * 64 + c] + level0[layer * 64 + 4 + c]
+                         + level0[layer * 64 + 16 + c]
+                         + level0[layer * 64 + 20 + c];
+            EXPECT_EQ(level1[layer * 16 + c], (sum + 2) / 4);
+        }
+    }
+    ktxVulkanTexture_Destruct(&vkTexture, vdi.device, nullptr);
+    ktxVulkanDeviceInfo_Destruct(&vdi);
+    ktxTexture_Destroy(ktxTexture(mipTexture));
+}
+
 class ktxTexture2_GetNumComponentsTestR8 : public ktxTexture2TestBase<GLubyte, 1, GL_R8> { };
 class ktxTexture2_GetNumComponentsTestRG8 : public ktxTexture2TestBase<GLubyte, 2, GL_RG8> { };
 class ktxTexture2_GetNumComponentsTestRGB8 : public ktxTexture2TestBase<GLubyte, 3, GL_RGB8> { };
@@ -39,6 +39,9 @@ add_test( NAME toktx-scale-resize
 add_test( NAME toktx-mipmap-resize
     COMMAND toktx --mipmap --resize 10x40 a b c
 )
+add_test( NAME toktx-mipmap-scale
+    COMMAND toktx --mipmap --scale 0.5 a b c
+)
 add_test( NAME toktx-only-max-endpoints
     COMMAND toktx --max_endpoints 5000 a b
 )
@@ -92,7 +95,16 @@ add_test( NAME toktx-depth-layers
 )
 
 add_test( NAME toktx-depth-genmipmap
-    COMMAND toktx --test --depth 7 --genmipmap --t2 3dtex_7_mipmap_reference_u.ktx2 ../srcimages/red16.png ../srcimages/orange16.png ../srcimages/yellow16.png ../srcimages/green16.png ../srcimages/blue16.png ../srcimages/indigo16.png ../srcimages/violet16.png
+    COMMAND toktx --test --depth 2 --genmipmap --t2 --zcmp 5 -- - ../srcimages/level0.ppm ../srcimages/level0.ppm
+    WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}/testimages
+)
+
+# Build a 4x4x4 volume from solid red, green, blue and yellow slices and
+# check that a box filter averages adjacent slices into level 1 and both
+# level 1 slices into level 2.
+add_test( NAME toktx-depth-genmipmap-texels
+    COMMAND ${BASH_EXECUTABLE} -c "for c in r:'\\xff\\x00\\x00' g:'\\x00\\xff\\x00' b:'\\x00\\x00\\xff' y:'\\xff\\xff\\x00'; do { printf 'P6\\n4 4\\n255\\n'; printf \"\${c#*:}%.0s\" {1..16}; } > toktx.vol-\${c%%:*}.ppm; done && $<TARGET_FILE:toktx> --t2 --depth 4 --genmipmap --filter box --assign_oetf linear toktx.vol.ktx2 toktx.vol-r.ppm toktx.vol-g.ppm toktx.vol-b.ppm toktx.vol-y.ppm && level1=$(od -An -tu8 -j104 -N8 toktx.vol.ktx2) && level2=$(od -An -tu8 -j128 -N8 toktx.vol.ktx2) && test \"$(od -An -tu1 -v -j$level1 -N24 toktx.vol.ktx2 | tr -s ' \\n' ' ')\" = ' 128 128 0 128 128 0 128 128 0 128 128 0 128 128 128 128 128 128 128 128 128 128 128 128 ' && test \"$(od -An -tu1 -v -j$level2 -N3 toktx.vol.ktx2 | tr -s ' \\n' ' ')\" = ' 128 128 64 ' && rm toktx.vol.ktx2 toktx.vol-?.ppm"
+    WORKING_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}
 )
 
 add_test( NAME toktx-layers-lt-one
@@ -108,6 +120,7 @@ set_tests_properties(
     toktx-bcmp-uastc
     toktx-scale-resize
     toktx-mipmap-resize
+    toktx-mipmap-scale
     toktx-only-max-endpoints
     toktx-only-max-selectors
     toktx-swizzle-gt-4
@@ -116,7 +129,6 @@ set_tests_properties(
     toktx-different-colortype-second-file-error
     toktx-depth-layers
     toktx-depth-lt-two
-    toktx-depth-genmipmap
     toktx-layers-lt-one
 PROPERTIES
     WILL_FAIL TRUE
@@ -264,3 +276,18 @@ gencmpktx( 3dtex_7_reference_u 3dtex_7_reference_u.ktx2 "../srcimages/red16.png
 gencmpktx( arraytex_1_reference_u arraytex_1_reference_u.ktx2 "../srcimages/red16.png" "--test --t2 --layers 1" "" "")
 gencmpktx( arraytex_7_reference_u arraytex_7_reference_u.ktx2 "../srcimages/red16.png ../srcimages/orange16.png ../srcimages/yellow16.png ../srcimages/green16.png ../srcimages/blue16.png ../srcimages/indigo16.png ../srcimages/violet16.png" "--test --t2 --layers 7" "" "")
 gencmpktx( arraytex_7_mipmap_reference_u arraytex_7_mipmap_reference_u.ktx2 "../srcimages/red16.png ../srcimages/orange16.png ../srcimages/yellow16.png ../srcimages/green16.png ../srcimages/blue16.png ../srcimages/indigo16.png ../srcimages/violet16.png" "--test --t2 --layers 7 --genmipmap" "" "")
+
+# Each --output must be identical to the file written by a separate run
+# with the same encoding options.
+add_test( NAME toktx-multiple-outputs
+    COMMAND ${BASH_EXECUTABLE} -c "$<TARGET_FILE:toktx> --test --t2 --genmipmap --output 'toktx.multi_uastc.ktx2 --encode uastc --zcmp 5' --output 'toktx.multi_astc.ktx2 --encode astc --astc_blk_d 6x6' toktx.multi_u.ktx2 ../srcimages/level0.ppm && $<TARGET_FILE:toktx> --test --t2 --genmipmap toktx.single_u.ktx2 ../srcimages/level0.ppm && $<TARGET_FILE:toktx> --test --genmipmap --encode uastc --zcmp 5 toktx.single_uastc.ktx2 ../srcimages/level0.ppm && $<TARGET_FILE:toktx> --test --genmipmap --encode astc --astc_blk_d 6x6 toktx.single_astc.ktx2 ../srcimages/level0.ppm && diff toktx.single_u.ktx2 toktx.multi_u.ktx2 && diff toktx.single_uastc.ktx2 toktx.multi_uastc.ktx2 && diff toktx.single_astc.ktx2 toktx.multi_astc.ktx2 && rm toktx.single_*.ktx2 toktx.multi_*.ktx2"
+    WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}/testimages
+)
+add_test( NAME toktx-output-non-encoding-option
+    COMMAND toktx --output "b --genmipmap" a c
+)
+set_tests_properties(
+    toktx-output-non-encoding-option
+PROPERTIES
+    WILL_FAIL TRUE
+)
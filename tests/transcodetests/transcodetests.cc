@@ -20,6 +20,8 @@ extern "C" {
   #include "memstream.h"
 }
 #include "gtest/gtest.h"
+#include <chrono>
+#include <iostream>
 #include <vector>
 #include <cstring>
 
@@ -213,6 +215,112 @@ TEST_P(TextureCombinationsTest, Basic) {
     FormatFeature format = get<1>(GetParam());
     test_texture_set(ts,format);
 }
+
+// Formats whose ETC1S transcoders use the packed selector kernels.
+vector<ktx_transcode_fmt_e> selectorKernelFormats = {
+    KTX_TTF_ETC1_RGB,
+    KTX_TTF_ETC2_RGBA,
+    KTX_TTF_BC1_RGB,
+    KTX_TTF_BC3_RGBA,
+    KTX_TTF_BC4_R,
+    KTX_TTF_BC5_RG,
+    KTX_TTF_BC7_RGBA,
+    KTX_TTF_ETC2_EAC_R11,
+    KTX_TTF_ETC2_EAC_RG11
+};
+
+class SelectorKernelsTest :
+    public ::testing::TestWithParam<tuple<TextureSet,ktx_transcode_fmt_e>> {};
+
+INSTANTIATE_TEST_SUITE_P(AllCombinations,
+                        SelectorKernelsTest,
+                        ::testing::Combine(::testing::ValuesIn(allTextureSets),
+                                           ::testing::ValuesIn(selectorKernelFormats)));
+
+// Transcode every image and level of a .basis file to format, with or
+// without the packed selector kernels.
+vector<ktx_uint8_t>
+transcode_basis(void* basisData, unsigned long basisSize,
+                ktx_transcode_fmt_e format, bool packed)
+{
+    vector<ktx_uint8_t> out;
+    basis_file basisu;
+
+    basist::set_packed_selector_kernels(packed);
+    if (basisu.open((uint8_t*)basisData, (uint32_t)basisSize)
+        && basisu.startTranscoding()) {
+        for (uint32_t image = 0; image < basisu.getNumImages(); image++) {
+            for (uint32_t level = 0; level < basisu.getNumLevels(image); level++) {
+                uint32_t size = basisu.getImageTranscodedSizeInBytes(image, level, format);
+                size_t offset = out.size();
+                out.resize(offset + size);
+                if (!basisu.transcodeImage(&out[offset], size, image, level,
+                                           format, 0, 0)) {
+                    out.clear();
+                    break;
+                }
+            }
+        }
+    }
+    basisu.close();
+    basist::set_packed_selector_kernels(true);
+    return out;
+}
+
+TEST_P(SelectorKernelsTest, MatchScalar) {
+    TextureSet ts = get<0>(GetParam());
+    ktx_transcode_fmt_e format = get<1>(GetParam());
+    void* basisData = nullptr;
+    unsigned long basisSize = 0;
+
+    string path = combine_paths(image_path, ts.basisuPath);
+    ASSERT_TRUE(read_file(path, &basisData, &basisSize))
+        << "Could not open or read texture file " << path;
+
+    vector<ktx_uint8_t> scalar = transcode_basis(basisData, basisSize, format, false);
+    vector<ktx_uint8_t> packed = transcode_basis(basisData, basisSize, format, true);
+    free(basisData);
+
+    ASSERT_FALSE(scalar.empty());
+    ASSERT_EQ(scalar.size(), packed.size());
+    EXPECT_EQ(memcmp(scalar.data(), packed.data(), scalar.size()), 0);
+}
+
+// Reports the transcoding speed with and without the kernels. Does not
+// fail on timings as they depend on the machine.
+TEST(SelectorKernelsTest, Throughput) {
+    const uint32_t repeats = 8;
+
+    for (auto& format : selectorKernelFormats) {
+        double seconds[2] = { 0, 0 };
+        size_t bytes = 0;
+
+        for (auto& ts : allTextureSets) {
+            void* basisData = nullptr;
+            unsigned long basisSize = 0;
+
+            string path = combine_paths(image_path, ts.basisuPath);
+            ASSERT_TRUE(read_file(path, &basisData, &basisSize))
+                << "Could not open or read texture file " << path;
+            for (uint32_t packed = 0; packed < 2; packed++) {
+                for (uint32_t i = 0; i < repeats; i++) {
+                    auto start = std::chrono::steady_clock::now();
+                    size_t size = transcode_basis(basisData, basisSize,
+                                                  format, packed != 0).size();
+                    seconds[packed] += std::chrono::duration<double>(
+                                   std::chrono::steady_clock::now() - start).count();
+                    ASSERT_NE(size, 0U);
+                    if (packed)
+                        bytes += size;
+                }
+            }
+            free(basisData);
+        }
+        cout << "[          ] " << ktxTranscodeFormatString(format) << ": "
+             << bytes / seconds[0] / 1e6 << " MB/s scalar, "
+             << bytes / seconds[1] / 1e6 << " MB/s packed\n";
+    }
+}
 }  // namespace
 
 int main(int argc, char **argv) {
@@ -24,6 +24,7 @@
 #endif
 
 #include <string.h>
+#include <vector>
 #include "GL/glcorearb.h"
 #include "gl_format.h"
 #include "ktx.h"
@@ -31,6 +32,7 @@ extern "C" {
   #include "ktxint.h"
   #include "filestream.h"
   #include "memstream.h"
+  #include "zstdfilter.h"
 }
 #include "gtest/gtest.h"
 #include "wthelper.h"
@@ -194,6 +196,73 @@ TEST(MemStreamTest, WriteExpand) {
     ktxMemStream_destruct(&stream);
 }
 
+/////////////////////////////////
+// ShuffleDelta filter tests.
+/////////////////////////////////
+
+TEST(ShuffleDeltaTest, RowRoundTrip) {
+    // Cover the SIMD sizes, scalar sizes and partial SIMD blocks.
+    const ktx_uint32_t elementSizes[] = { 1, 2, 3, 4, 6, 8, 16 };
+    const ktx_uint32_t widths[] = { 1, 15, 16, 17, 33, 64 };
+
+    for (ktx_uint32_t es : elementSizes) {
+        for (ktx_uint32_t n : widths) {
+            std::vector<ktx_uint8_t> src(n * es), filtered(n * es),
+                                     decoded(n * es);
+            for (size_t i = 0; i < src.size(); i++)
+                src[i] = (ktx_uint8_t)(i * 37 + (i / es) * (i % es));
+            ktxShuffleDelta_encodeRow(src.data(), filtered.data(), n, es);
+            ktxShuffleDelta_decodeRow(filtered.data(), decoded.data(), n, es);
+            EXPECT_EQ(memcmp(src.data(), decoded.data(), src.size()), 0)
+                << "elementSize " << es << ", width " << n;
+        }
+    }
+}
+
+TEST(BlockSplitTest, RoundTrip) {
+    const ktx_uint32_t blockSizes[] = { 8, 16 };
+    const ktx_uint32_t rowBlocks[] = { 1, 7, 16, 19, 40 };
+    const ktx_uint32_t numRows = 3;
+
+    for (ktx_uint32_t bs : blockSizes) {
+        for (ktx_uint32_t n : rowBlocks) {
+            size_t size = n * bs * numRows;
+            std::vector<ktx_uint8_t> src(size), filtered(size);
+            for (size_t i = 0; i < size; i++)
+                src[i] = (ktx_uint8_t)(i * 13 + i / bs);
+            ktxBlockSplit_encode(src.data(), filtered.data(), size, n, bs);
+            // Byte 1 of the second block of the first row.
+            if (n > 1) {
+                EXPECT_EQ(filtered[n + 1], src[bs + 1]);
+            }
+            EXPECT_EQ(ktxBlockSplit_decode(filtered.data(), size, n, bs),
+                      KTX_SUCCESS);
+            EXPECT_EQ(memcmp(src.data(), filtered.data(), size), 0)
+                << "blockSize " << bs << ", rowBlocks " << n;
+        }
+    }
+}
+
+TEST(ShuffleDeltaTest, SplitsBytePlanes) {
+    // 16-bit ramp. Low bytes step by 1 and high bytes are constant so
+    // each plane should be delta coded to its first value then 1s or 0s.
+    const ktx_uint32_t n = 20;
+    ktx_uint16_t src[n];
+    ktx_uint8_t filtered[n * 2];
+
+    for (ktx_uint32_t i = 0; i < n; i++)
+        src[i] = (ktx_uint16_t)(0x1200 + i);
+    ktxShuffleDelta_encodeRow((ktx_uint8_t*)src, filtered, n, 2);
+    // Planes are in memory byte order.
+    ktx_uint8_t lowPlane = ((ktx_uint8_t*)src)[0] == 0x00 ? 0 : 1;
+    EXPECT_EQ(filtered[lowPlane * n], 0x00);
+    EXPECT_EQ(filtered[(1 - lowPlane) * n], 0x12);
+    for (ktx_uint32_t i = 1; i < n; i++) {
+        EXPECT_EQ(filtered[lowPlane * n + i], 1);
+        EXPECT_EQ(filtered[(1 - lowPlane) * n + i], 0);
+    }
+}
+
 //////////////////////////////
 // WriterTestHelper tests.
 //////////////////////////////
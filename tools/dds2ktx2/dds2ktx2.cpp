@@ -0,0 +1,148 @@
+// -*- tab-width: 4; -*-
+// vi: set sw=2 ts=4 sts=4 expandtab:
+
+// Copyright 2026 The Khronos Group Inc.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "convapp.h"
+
+#include <cstdlib>
+#include <errno.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <ktx.h>
+
+#include "argparser.h"
+#include "ddsimage.h"
+#include "version.h"
+
+using namespace std;
+
+/** @page dds2ktx2 dds2ktx2
+@~English
+
+Create a KTX 2 file from a DDS file.
+
+@section dds2ktx2_synopsis SYNOPSIS
+    dds2ktx2 [options] [@e infile ...]
+
+@section dds2ktx2_description DESCRIPTION
+    @b dds2ktx2 creates Khronos texture format version 2 files (KTX2) from
+    DirectDraw Surface (DDS) files. @b dds2ktx2 reads each named
+    @e infile. Output files have the same name as the input but with the
+    extension changed to @c .ktx2. When @b infile is not specified, a single
+    file will be read from stdin and the output written to standard out.
+    Multiple input files are converted in parallel.
+
+    Files with and without the DX10 header extension are supported,
+    including 1D, 2D and 3D textures, arrays, cube maps and cube map arrays
+    and their mip levels. The DXGI format, or the legacy FourCC or pixel
+    format masks, are mapped to the equivalent VkFormat and the images,
+    including those in BC1 - BC7 block-compressed formats, are copied
+    without being decoded or re-encoded. Formats without a Vulkan
+    equivalent, such as typeless formats, are not supported. Luminance and
+    alpha-only legacy formats are stored as R or RG formats with KTXswizzle
+    metadata. Premultiplied alpha is recorded in the data format descriptor.
+
+    The following options are available:
+    @snippet{doc} convapp.h convApp options
+    @snippet{doc} ktxapp.h ktxApp options
+
+@section dds2ktx2_exitstatus EXIT STATUS
+    @b dds2ktx2 exits 0 on success, 1 on command line errors and 2 on
+    functional errors.
+
+@section dds2ktx2_history HISTORY
+
+@par Version 4.0
+ - Initial version.
+*/
+
+
+#define QUOTE(x) #x
+#define STR(x) QUOTE(x)
+
+std::string myversion(STR(DDS2KTX2_VERSION));
+std::string mydefversion(STR(DDS2KTX2_DEFAULT_VERSION));
+
+class ddsConverter : public convApp {
+  public:
+    ddsConverter();
+
+    virtual void usage();
+
+  protected:
+    virtual int createTexture(const _tstring& infile,
+                              const std::vector<ktx_uint8_t>& data,
+                              ktxTexture** texture, std::ostream& err);
+
+    commandOptions options;
+};
+
+
+ddsConverter::ddsConverter() : convApp(myversion, mydefversion, options)
+{
+}
+
+
+void
+ddsConverter::usage()
+{
+    cerr <<
+        "Usage: " << name << " [options] [<infile> ...]\n"
+        "\n"
+        "  infile       The source dds file. The output is written to a file of the\n"
+        "               same name with the extension changed to '.ktx2'. If it is not\n"
+        "               specified input will be read from stdin and the converted texture\n"
+        "               written to stdout. Multiple infiles are converted in parallel.\n"
+        "\n"
+        "  Options are:\n"
+        "\n";
+        convApp::usage();
+}
+
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+    ddsConverter dds2ktx2;
+
+    return dds2ktx2.main(argc, argv);
+}
+
+
+/*
+ * @brief Create a KTX2 texture from the contents of a DDS file.
+ *
+ * @return   the exit code for the file.
+ */
+int
+ddsConverter::createTexture(const _tstring& infile,
+                            const std::vector<ktx_uint8_t>& data,
+                            ktxTexture** texture, std::ostream& err)
+{
+    ktxTexture2* texture2;
+
+    try {
+        texture2 = dds::createTexture(data.data(), data.size());
+    } catch (const std::exception& e) {
+        err << name << ": " << infile << ": " << e.what() << endl;
+        return 2;
+    }
+
+    addWriterMetadata(ktxTexture(texture2));
+
+    if (options.zcmp) {
+        KTX_error_code result = ktxTexture2_DeflateZstd(texture2,
+                                                        options.zcmpLevel);
+        if (result != KTX_SUCCESS) {
+            err << name
+                << " failed to supercompress " << infile << ": "
+                << ktxErrorString(result) << endl;
+            ktxTexture_Destroy(ktxTexture(texture2));
+            return 2;
+        }
+    }
+    *texture = ktxTexture(texture2);
+    return 0;
+}
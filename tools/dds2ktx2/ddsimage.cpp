@@ -0,0 +1,463 @@
+// -*- tab-width: 4; -*-
+// vi: set sw=2 ts=4 sts=4 expandtab:
+
+// Copyright 2026 The Khronos Group Inc.
+// SPDX-License-Identifier: Apache-2.0
+
+//!
+//! @internal
+//! @~English
+//! @file
+//!
+//! @brief Create a ktxTexture2 from a DirectDraw Surface (.dds) file.
+//!
+//! Both DX10 extended headers and legacy headers are read. Legacy formats
+//! are identified by FourCC codes or by bit masks. Images are copied
+//! without any conversion so block-compressed data arrives bit-exact.
+//!
+//! DDS files store the complete mip chain of each array element, or cube
+//! face, one after the other. KTX stores each level, smallest first, with
+//! all its layers and faces together, so images are copied one by one to
+//! their place in the texture.
+//!
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <KHR/khr_df.h>
+
+#include "ddsimage.h"
+#include "vkformat_enum.h"
+
+namespace dds {
+
+#define MAKEFOURCC(a, b, c, d) \
+    ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) \
+     | ((uint32_t)(d) << 24))
+
+static const uint32_t ddsMagic = MAKEFOURCC('D', 'D', 'S', ' ');
+
+// DDS_PIXELFORMAT dwFlags
+enum {
+    DDPF_ALPHAPIXELS = 0x1,
+    DDPF_ALPHA = 0x2,
+    DDPF_FOURCC = 0x4,
+    DDPF_RGB = 0x40,
+    DDPF_LUMINANCE = 0x20000,
+};
+
+// DDS_HEADER dwFlags, dwCaps2
+enum {
+    DDSD_MIPMAPCOUNT = 0x20000,
+    DDSD_DEPTH = 0x800000,
+    DDSCAPS2_CUBEMAP = 0x200,
+    DDSCAPS2_CUBEMAP_ALLFACES = 0xfc00,
+    DDSCAPS2_VOLUME = 0x200000,
+};
+
+// DDS_HEADER_DXT10 values
+enum {
+    D3D10_RESOURCE_DIMENSION_TEXTURE1D = 2,
+    D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3,
+    D3D10_RESOURCE_DIMENSION_TEXTURE3D = 4,
+    DDS_RESOURCE_MISC_TEXTURECUBE = 0x4,
+    DDS_ALPHA_MODE_PREMULTIPLIED = 2,
+};
+
+struct pixelFormat {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    uint32_t rBitMask;
+    uint32_t gBitMask;
+    uint32_t bBitMask;
+    uint32_t aBitMask;
+};
+
+struct header {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    pixelFormat ddspf;
+    uint32_t caps;
+    uint32_t caps2;
+    uint32_t caps3;
+    uint32_t caps4;
+    uint32_t reserved2;
+};
+
+struct headerDXT10 {
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+
+static_assert(sizeof(header) == 124, "DDS_HEADER must be 124 bytes");
+static_assert(sizeof(headerDXT10) == 20, "DDS_HEADER_DXT10 must be 20 bytes");
+
+//! Map a DXGI_FORMAT to a VkFormat. Typeless and video formats and those
+//! with no Vulkan equivalent map to VK_FORMAT_UNDEFINED.
+static VkFormat
+dxgiToVkFormat(uint32_t dxgiFormat)
+{
+    switch (dxgiFormat) {
+      case 2: return VK_FORMAT_R32G32B32A32_SFLOAT;
+      case 3: return VK_FORMAT_R32G32B32A32_UINT;
+      case 4: return VK_FORMAT_R32G32B32A32_SINT;
+      case 6: return VK_FORMAT_R32G32B32_SFLOAT;
+      case 7: return VK_FORMAT_R32G32B32_UINT;
+      case 8: return VK_FORMAT_R32G32B32_SINT;
+      case 10: return VK_FORMAT_R16G16B16A16_SFLOAT;
+      case 11: return VK_FORMAT_R16G16B16A16_UNORM;
+      case 12: return VK_FORMAT_R16G16B16A16_UINT;
+      case 13: return VK_FORMAT_R16G16B16A16_SNORM;
+      case 14: return VK_FORMAT_R16G16B16A16_SINT;
+      case 16: return VK_FORMAT_R32G32_SFLOAT;
+      case 17: return VK_FORMAT_R32G32_UINT;
+      case 18: return VK_FORMAT_R32G32_SINT;
+      case 24: return VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+      case 25: return VK_FORMAT_A2B10G10R10_UINT_PACK32;
+      case 26: return VK_FORMAT_B10G11R11_UFLOAT_PACK32;
+      case 28: return VK_FORMAT_R8G8B8A8_UNORM;
+      case 29: return VK_FORMAT_R8G8B8A8_SRGB;
+      case 30: return VK_FORMAT_R8G8B8A8_UINT;
+      case 31: return VK_FORMAT_R8G8B8A8_SNORM;
+      case 32: return VK_FORMAT_R8G8B8A8_SINT;
+      case 34: return VK_FORMAT_R16G16_SFLOAT;
+      case 35: return VK_FORMAT_R16G16_UNORM;
+      case 36: return VK_FORMAT_R16G16_UINT;
+      case 37: return VK_FORMAT_R16G16_SNORM;
+      case 38: return VK_FORMAT_R16G16_SINT;
+      case 40: return VK_FORMAT_D32_SFLOAT;
+      case 41: return VK_FORMAT_R32_SFLOAT;
+      case 42: return VK_FORMAT_R32_UINT;
+      case 43: return VK_FORMAT_R32_SINT;
+      case 49: return VK_FORMAT_R8G8_UNORM;
+      case 50: return VK_FORMAT_R8G8_UINT;
+      case 51: return VK_FORMAT_R8G8_SNORM;
+      case 52: return VK_FORMAT_R8G8_SINT;
+      case 54: return VK_FORMAT_R16_SFLOAT;
+      case 55: return VK_FORMAT_D16_UNORM;
+      case 56: return VK_FORMAT_R16_UNORM;
+      case 57: return VK_FORMAT_R16_UINT;
+      case 58: return VK_FORMAT_R16_SNORM;
+      case 59: return VK_FORMAT_R16_SINT;
+      case 61: return VK_FORMAT_R8_UNORM;
+      case 62: return VK_FORMAT_R8_UINT;
+      case 63: return VK_FORMAT_R8_SNORM;
+      case 64: return VK_FORMAT_R8_SINT;
+      case 67: return VK_FORMAT_E5B9G9R9_UFLOAT_PACK32;
+      case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+      case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+      case 74: return VK_FORMAT_BC2_UNORM_BLOCK;
+      case 75: return VK_FORMAT_BC2_SRGB_BLOCK;
+      case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+      case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+      case 80: return VK_FORMAT_BC4_UNORM_BLOCK;
+      case 81: return VK_FORMAT_BC4_SNORM_BLOCK;
+      case 83: return VK_FORMAT_BC5_UNORM_BLOCK;
+      case 84: return VK_FORMAT_BC5_SNORM_BLOCK;
+      case 85: return VK_FORMAT_R5G6B5_UNORM_PACK16;
+      case 86: return VK_FORMAT_A1R5G5B5_UNORM_PACK16;
+      case 87: return VK_FORMAT_B8G8R8A8_UNORM;
+      case 91: return VK_FORMAT_B8G8R8A8_SRGB;
+      case 95: return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+      case 96: return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+      case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+      case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+      case 115: return VK_FORMAT_A4R4G4B4_UNORM_PACK16_EXT;
+      default: return VK_FORMAT_UNDEFINED;
+    }
+}
+
+//! Map a legacy pixel format to a VkFormat. @a swizzle is set for
+//! luminance and alpha-only formats and @a premultiplied for DXT2 & 4.
+static VkFormat
+legacyToVkFormat(const pixelFormat& pf, const char*& swizzle,
+                 bool& premultiplied)
+{
+    if (pf.flags & DDPF_FOURCC) {
+        switch (pf.fourCC) {
+          case MAKEFOURCC('D', 'X', 'T', '1'):
+            return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+          case MAKEFOURCC('D', 'X', 'T', '2'):
+            premultiplied = true;
+            return VK_FORMAT_BC2_UNORM_BLOCK;
+          case MAKEFOURCC('D', 'X', 'T', '3'):
+            return VK_FORMAT_BC2_UNORM_BLOCK;
+          case MAKEFOURCC('D', 'X', 'T', '4'):
+            premultiplied = true;
+            return VK_FORMAT_BC3_UNORM_BLOCK;
+          case MAKEFOURCC('D', 'X', 'T', '5'):
+            return VK_FORMAT_BC3_UNORM_BLOCK;
+          case MAKEFOURCC('A', 'T', 'I', '1'):
+          case MAKEFOURCC('B', 'C', '4', 'U'):
+            return VK_FORMAT_BC4_UNORM_BLOCK;
+          case MAKEFOURCC('B', 'C', '4', 'S'):
+            return VK_FORMAT_BC4_SNORM_BLOCK;
+          case MAKEFOURCC('A', 'T', 'I', '2'):
+          case MAKEFOURCC('B', 'C', '5', 'U'):
+            return VK_FORMAT_BC5_UNORM_BLOCK;
+          case MAKEFOURCC('B', 'C', '5', 'S'):
+            return VK_FORMAT_BC5_SNORM_BLOCK;
+          // D3DFORMAT values written as FourCCs.
+          case 36: return VK_FORMAT_R16G16B16A16_UNORM;
+          case 110: return VK_FORMAT_R16G16B16A16_SNORM;
+          case 111: return VK_FORMAT_R16_SFLOAT;
+          case 112: return VK_FORMAT_R16G16_SFLOAT;
+          case 113: return VK_FORMAT_R16G16B16A16_SFLOAT;
+          case 114: return VK_FORMAT_R32_SFLOAT;
+          case 115: return VK_FORMAT_R32G32_SFLOAT;
+          case 116: return VK_FORMAT_R32G32B32A32_SFLOAT;
+          default: return VK_FORMAT_UNDEFINED;
+        }
+    }
+
+    // Formats described by masks. Only those whose bits are in the same
+    // place as in a VkFormat are supported.
+    const uint32_t a = (pf.flags & (DDPF_ALPHAPIXELS | DDPF_ALPHA))
+                       ? pf.aBitMask : 0;
+    const uint32_t r = pf.rBitMask, g = pf.gBitMask, b = pf.bBitMask;
+    if (pf.flags & DDPF_RGB) {
+        switch (pf.rgbBitCount) {
+          case 32:
+            if (r == 0xff && g == 0xff00 && b == 0xff0000 && a == 0xff000000)
+                return VK_FORMAT_R8G8B8A8_UNORM;
+            if (r == 0xff0000 && g == 0xff00 && b == 0xff && a == 0xff000000)
+                return VK_FORMAT_B8G8R8A8_UNORM;
+            if (r == 0x3ff && g == 0xffc00 && b == 0x3ff00000
+                && a == 0xc0000000)
+                return VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+            if (r == 0xffff && g == 0xffff0000 && b == 0 && a == 0)
+                return VK_FORMAT_R16G16_UNORM;
+            break;
+          case 24:
+            if (r == 0xff0000 && g == 0xff00 && b == 0xff)
+                return VK_FORMAT_B8G8R8_UNORM;
+            if (r == 0xff && g == 0xff00 && b == 0xff0000)
+                return VK_FORMAT_R8G8B8_UNORM;
+            break;
+          case 16:
+            if (r == 0xf800 && g == 0x7e0 && b == 0x1f && a == 0)
+                return VK_FORMAT_R5G6B5_UNORM_PACK16;
+            if (r == 0x7c00 && g == 0x3e0 && b == 0x1f && a == 0x8000)
+                return VK_FORMAT_A1R5G5B5_UNORM_PACK16;
+            if (r == 0xf00 && g == 0xf0 && b == 0xf && a == 0xf000)
+                return VK_FORMAT_A4R4G4B4_UNORM_PACK16_EXT;
+            break;
+        }
+    } else if (pf.flags & DDPF_LUMINANCE) {
+        if (pf.rgbBitCount == 8 && r == 0xff && a == 0) {
+            swizzle = "rrr1";
+            return VK_FORMAT_R8_UNORM;
+        }
+        if (pf.rgbBitCount == 16 && r == 0xffff && a == 0) {
+            swizzle = "rrr1";
+            return VK_FORMAT_R16_UNORM;
+        }
+        if (pf.rgbBitCount == 16 && r == 0xff && a == 0xff00) {
+            swizzle = "rrrg";
+            return VK_FORMAT_R8G8_UNORM;
+        }
+    } else if (pf.flags & DDPF_ALPHA) {
+        if (pf.rgbBitCount == 8 && a == 0xff) {
+            swizzle = "000r";
+            return VK_FORMAT_R8_UNORM;
+        }
+    }
+    return VK_FORMAT_UNDEFINED;
+}
+
+ktxTexture2*
+createTexture(const ktx_uint8_t* data, size_t size)
+{
+    header hdr;
+    headerDXT10 dx10 = { };
+    uint32_t magic;
+    size_t offset = sizeof(magic) + sizeof(hdr);
+
+    if (size < offset)
+        throw invalid_file("file is too small.");
+    memcpy(&magic, data, sizeof(magic));
+    memcpy(&hdr, data + sizeof(magic), sizeof(hdr));
+    if (magic != ddsMagic || hdr.size != sizeof(hdr)
+        || hdr.ddspf.size != sizeof(pixelFormat))
+        throw invalid_file("no DDS signature.");
+
+    bool hasDX10 = (hdr.ddspf.flags & DDPF_FOURCC)
+                   && hdr.ddspf.fourCC == MAKEFOURCC('D', 'X', '1', '0');
+    if (hasDX10) {
+        if (size < offset + sizeof(dx10))
+            throw invalid_file("file is too small.");
+        memcpy(&dx10, data + offset, sizeof(dx10));
+        offset += sizeof(dx10);
+    }
+
+    ktxTextureCreateInfo createInfo = { };
+    const char* swizzle = nullptr;
+    bool premultiplied = false;
+    VkFormat vkFormat;
+
+    createInfo.baseWidth = hdr.width;
+    createInfo.baseHeight = hdr.height;
+    createInfo.baseDepth = 1;
+    createInfo.numDimensions = 2;
+    // mipMapCount is only valid when flagged. Some writers leave garbage.
+    createInfo.numLevels = (hdr.flags & DDSD_MIPMAPCOUNT) && hdr.mipMapCount
+                           ? hdr.mipMapCount : 1;
+    createInfo.numLayers = 1;
+    createInfo.numFaces = 1;
+    createInfo.isArray = KTX_FALSE;
+    createInfo.generateMipmaps = KTX_FALSE;
+
+    if (hasDX10) {
+        vkFormat = dxgiToVkFormat(dx10.dxgiFormat);
+        if (vkFormat == VK_FORMAT_UNDEFINED) {
+            std::stringstream msg;
+            msg << "DXGI format " << dx10.dxgiFormat
+                << " has no Vulkan equivalent.";
+            throw unsupported(msg.str());
+        }
+        premultiplied = (dx10.miscFlags2 & 0x7)
+                        == DDS_ALPHA_MODE_PREMULTIPLIED;
+        if (dx10.arraySize == 0)
+            throw invalid_file("array size is 0.");
+        createInfo.numLayers = dx10.arraySize;
+        createInfo.isArray = dx10.arraySize > 1;
+        switch (dx10.resourceDimension) {
+          case D3D10_RESOURCE_DIMENSION_TEXTURE1D:
+            createInfo.numDimensions = 1;
+            createInfo.baseHeight = 1;
+            break;
+          case D3D10_RESOURCE_DIMENSION_TEXTURE2D:
+            if (dx10.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE)
+                createInfo.numFaces = 6;
+            break;
+          case D3D10_RESOURCE_DIMENSION_TEXTURE3D:
+            if (dx10.arraySize > 1)
+                throw invalid_file("3D texture with array size > 1.");
+            createInfo.numDimensions = 3;
+            createInfo.baseDepth = hdr.depth;
+            break;
+          default:
+            throw invalid_file("unknown resource dimension.");
+        }
+    } else {
+        vkFormat = legacyToVkFormat(hdr.ddspf, swizzle, premultiplied);
+        if (vkFormat == VK_FORMAT_UNDEFINED)
+            throw unsupported("pixel format has no Vulkan equivalent.");
+        if (hdr.caps2 & DDSCAPS2_CUBEMAP) {
+            if ((hdr.caps2 & DDSCAPS2_CUBEMAP_ALLFACES)
+                != DDSCAPS2_CUBEMAP_ALLFACES)
+                throw unsupported("cube map with missing faces.");
+            createInfo.numFaces = 6;
+        } else if ((hdr.caps2 & DDSCAPS2_VOLUME)
+                   && (hdr.flags & DDSD_DEPTH)) {
+            createInfo.numDimensions = 3;
+            createInfo.baseDepth = hdr.depth;
+        }
+    }
+    createInfo.vkFormat = vkFormat;
+
+    if (createInfo.baseWidth == 0 || createInfo.baseHeight == 0
+        || createInfo.baseDepth == 0)
+        throw invalid_file("image has 0 size.");
+
+    // Check the file holds all the images before allocating storage for
+    // them, so a corrupt header can't cause a huge allocation.
+    ktxTexture2* texture;
+    KTX_error_code result = ktxTexture2_Create(&createInfo,
+                                               KTX_TEXTURE_CREATE_NO_STORAGE,
+                                               &texture);
+    if (result == KTX_OUT_OF_MEMORY)
+        throw std::bad_alloc();
+    if (result != KTX_SUCCESS) {
+        // E.g. a non-square cube map or too many levels.
+        throw unsupported(std::string("cannot create KTX texture: ")
+                          + ktxErrorString(result));
+    }
+    // Header dimensions can be anything so check each step against the
+    // available size to avoid overflow.
+    const uint32_t* bdb = texture->pDfd + 1;
+    uint64_t blockWidth = KHR_DFDVAL(bdb, TEXELBLOCKDIMENSION0) + 1;
+    uint64_t blockHeight = KHR_DFDVAL(bdb, TEXELBLOCKDIMENSION1) + 1;
+    uint64_t itemSize = (uint64_t)ktxTexture_GetElementSize(ktxTexture(texture))
+                        * texture->numLayers * texture->numFaces;
+    uint64_t maxBlocks = (size - offset) / itemSize;
+    uint64_t totalBlocks = 0;
+    for (uint32_t level = 0; level < texture->numLevels; level++) {
+        uint64_t width = std::max(1U, texture->baseWidth >> level);
+        uint64_t height = std::max(1U, texture->baseHeight >> level);
+        uint64_t depth = std::max(1U, texture->baseDepth >> level);
+        uint64_t blocks = (width + blockWidth - 1) / blockWidth
+                          * ((height + blockHeight - 1) / blockHeight);
+        if (blocks > maxBlocks / depth
+            || totalBlocks + blocks * depth > maxBlocks) {
+            totalBlocks = maxBlocks + 1;
+            break;
+        }
+        totalBlocks += blocks * depth;
+    }
+    ktxTexture_Destroy(ktxTexture(texture));
+    if (totalBlocks > maxBlocks)
+        throw invalid_file("file is truncated.");
+
+    result = ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+                                &texture);
+    if (result == KTX_OUT_OF_MEMORY)
+        throw std::bad_alloc();
+    assert(result == KTX_SUCCESS);
+
+    // Walk the DDS data copying each image to its place in the texture.
+    uint32_t numItems = texture->numLayers * texture->numFaces;
+    for (uint32_t item = 0; item < numItems; item++) {
+        uint32_t layer = item / texture->numFaces;
+        uint32_t face = item % texture->numFaces;
+        for (uint32_t level = 0; level < texture->numLevels; level++) {
+            ktx_size_t imageSize =
+                        ktxTexture_GetImageSize(ktxTexture(texture), level);
+            uint32_t depth = std::max(1U, texture->baseDepth >> level);
+            for (uint32_t z = 0; z < depth; z++) {
+                if (size - offset < imageSize) {
+                    ktxTexture_Destroy(ktxTexture(texture));
+                    throw invalid_file("file is truncated.");
+                }
+                result = ktxTexture_SetImageFromMemory(ktxTexture(texture),
+                                             level, layer,
+                                             texture->numFaces > 1 ? face : z,
+                                             data + offset, imageSize);
+                assert(result == KTX_SUCCESS);
+                offset += imageSize;
+            }
+        }
+    }
+
+    if (premultiplied) {
+        uint32_t* bdb = texture->pDfd + 1;
+        KHR_DFDSETVAL(bdb, FLAGS, KHR_DFDVAL(bdb, FLAGS)
+                                  | KHR_DF_FLAG_ALPHA_PREMULTIPLIED);
+    }
+    if (swizzle) {
+        ktxHashList_AddKVPair(&texture->kvDataHead, KTX_SWIZZLE_KEY,
+                              (unsigned int)strlen(swizzle) + 1, swizzle);
+    }
+    // DDS images are stored top-down.
+    static const char* orientations[] = { "r", "rd", "rdi" };
+    const char* orientation = orientations[texture->numDimensions - 1];
+    ktxHashList_AddKVPair(&texture->kvDataHead, KTX_ORIENTATION_KEY,
+                          (unsigned int)strlen(orientation) + 1,
+                          orientation);
+    return texture;
+}
+
+} // namespace dds
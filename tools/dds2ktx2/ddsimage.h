@@ -0,0 +1,47 @@
+// -*- tab-width: 4; -*-
+// vi: set sw=2 ts=4 sts=4 expandtab:
+
+// Copyright 2026 The Khronos Group Inc.
+// SPDX-License-Identifier: Apache-2.0
+
+//!
+//! @internal
+//! @~English
+//! @file
+//!
+//! @brief Declarations for reading DirectDraw Surface (.dds) files.
+//!
+
+#ifndef DDSIMAGE_H
+#define DDSIMAGE_H
+
+#include <stdexcept>
+#include <string>
+#include <ktx.h>
+
+namespace dds {
+
+//! Thrown when a file is not a DDS file or is truncated or inconsistent.
+class invalid_file : public std::runtime_error {
+  public:
+    invalid_file(std::string error)
+        : std::runtime_error("Invalid DDS file: " + error) { }
+};
+
+//! Thrown for valid DDS files whose format or layout has no KTX equivalent.
+class unsupported : public std::runtime_error {
+  public:
+    unsupported(std::string error)
+        : std::runtime_error("Unsupported DDS file: " + error) { }
+};
+
+//! Create a ktxTexture2 holding the images of the DDS file in @a data.
+//!
+//! The DXGI or legacy pixel format is mapped to a VkFormat and the image
+//! data, block-compressed or not, is copied as is. Throws invalid_file or
+//! unsupported on error and std::bad_alloc if memory is exhausted.
+ktxTexture2* createTexture(const ktx_uint8_t* data, size_t size);
+
+} // namespace dds
+
+#endif /* DDSIMAGE_H */
@@ -105,6 +105,11 @@ Check the validity of a KTX 2 file.
         provided -q is not set.</dd>
     <dt>-w, --warn-as-error</dt>
     <dd>Treat warnings as errors. Changes exit code from success to error.
+    <dt>-c, --verify-hashes</dt>
+    <dd>Check the data of each mip level against the content hashes
+        recorded by libktx's ktxTexture2_AddLevelHashes(). Warns if the
+        file has no hashes. When the hashes match, the trial transcode of
+        Basis Universal data is skipped.</dd>
     </dl>
     @snippetdoc ktxapp.h ktxApp options
 
@@ -116,6 +121,7 @@ Check the validity of a KTX 2 file.
 
 @par Version 4.0
  - Initial version.
+ - Add --verify-hashes.
 
 @section ktx2check_author AUTHOR
     Mark Callow, Edgewise Consulting www.edgewise-consulting.com
@@ -456,6 +462,18 @@ struct {
     };
 } Transcode;
 
+struct {
+    issue Mismatch {
+        ERROR | 0x0110, "Level %d data does not match its content hash."
+    };
+    issue Missing {
+        WARNING | 0x0111, "No level content hashes to verify."
+    };
+    issue Failure {
+        ERROR | 0x0112, "Verification of level content hashes failed: %s"
+    };
+} LevelHash;
+
 /////////////////////////////////////////////////////////////////////
 //                       External Functions                        //
 //     These are in libktx but not part of its public API.         //
@@ -820,6 +838,7 @@ class ktxValidator : public ktxApp {
     void validateKvd(validationContext& ctx);
     void validateSgd(validationContext& ctx);
     void validateDataSize(validationContext& ctx);
+    bool validateLevelHashes(validationContext& ctx);
     bool validateTranscode(validationContext& ctx); // Must be called last.
     bool validateMetadata(validationContext& ctx, const char* key,
                           const uint8_t* value, uint32_t valueLen);
@@ -859,11 +878,13 @@ class ktxValidator : public ktxApp {
         uint32_t maxIssues;
         bool quiet;
         bool errorOnWarning;
+        bool verifyHashes;
 
         commandOptions() {
             maxIssues = 0xffffffffU;
             quiet = false;
 			errorOnWarning = false;
+            verifyHashes = false;
         }
     } options;
 
@@ -899,13 +920,14 @@ ktxValidator::ktxValidator() : ktxApp(myversion, mydefversion, options)
     argparser::option my_option_list[] = {
         { "quiet", argparser::option::no_argument, NULL, 'q' },
         { "max-issues", argparser::option::required_argument, NULL, 'm' },
-        { "warn-as-error", argparser::option::no_argument, NULL, 'w' }
+        { "warn-as-error", argparser::option::no_argument, NULL, 'w' },
+        { "verify-hashes", argparser::option::no_argument, NULL, 'c' }
     };
     const int lastOptionIndex = sizeof(my_option_list)
                                 / sizeof(argparser::option);
     option_list.insert(option_list.begin(), my_option_list,
                        my_option_list + lastOptionIndex);
-    short_opts += "qm:w";
+    short_opts += "qm:wc";
 }
 
 void
@@ -1100,7 +1122,11 @@ ktxValidator::usage()
         "               provided -q is not set.\n"
         "  -w, --warn-as-error\n"
         "               Treat warnings as errors. Changes error code from success\n"
-        "               to error\n";
+        "               to error\n"
+        "  -c, --verify-hashes\n"
+        "               Check each level against the content hashes recorded by\n"
+        "               libktx. Warn if there are none. Skip the trial transcode\n"
+        "               of Basis Universal data when the hashes match.\n";
     ktxApp::usage();
 }
 
@@ -1182,7 +1208,8 @@ ktxValidator::validateFile(const _tstring& filename)
             validateSgd(context);
             skipPadding(context, context.requiredLevelAlignment());
             validateDataSize(context);
-            validateTranscode(context);
+            if (!options.verifyHashes || !validateLevelHashes(context))
+                validateTranscode(context);
         } catch (fatal& e) {
             if (!options.quiet)
                 cout << "    " << e.what() << endl;
@@ -1209,6 +1236,9 @@ ktxValidator::processOption(argparser& parser, int opt)
       case 'w':
         options.errorOnWarning = true;
         break;
+      case 'c':
+        options.verifyHashes = true;
+        break;
       default:
         return false;
     }
@@ -1407,6 +1437,8 @@ ktxValidator::validateLevelIndex(validationContext& ctx)
     switch (ctx.header.supercompressionScheme) {
       case KTX_SS_NONE:
       case KTX_SS_ZSTD:
+      case KTX_SS_ZSTD_SHUFFLE_DELTA:
+      case KTX_SS_ZSTD_BLOCK_SPLIT:
         expectedOffset = padn(requiredLevelAlignment, ctx.kvDataEndOffset());
         break;
       case KTX_SS_BASIS_LZ:
@@ -1522,8 +1554,10 @@ ktxValidator::validateDfd(validationContext& ctx)
     switch (ctx.header.supercompressionScheme) {
       case KTX_SS_NONE:
       case KTX_SS_ZSTD:
+      case KTX_SS_ZSTD_SHUFFLE_DELTA:
+      case KTX_SS_ZSTD_BLOCK_SPLIT:
         if (ctx.header.vkFormat != VK_FORMAT_UNDEFINED) {
-            if (ctx.header.supercompressionScheme != KTX_SS_ZSTD) {
+            if (ctx.header.supercompressionScheme == KTX_SS_NONE) {
                 // Do a simple comparison with the expected DFD.
                 analyze = memcmp(ctx.pActualDfd, ctx.pDfd4Format,
                                   *ctx.pDfd4Format);
@@ -1876,6 +1910,10 @@ ktxValidator::validateKvd(validationContext& ctx)
                     writerFound = true;
                 if (strncmp(key, "KTXwriterScParams", 17) == 0)
                     writerScParamsFound = true;
+            } else if (strcmp(key, KTX_LEVEL_HASHES_KEY) == 0) {
+                uint32_t levelCount = max(ctx.header.levelCount, 1U);
+                if (valueLen != levelCount * sizeof(uint64_t))
+                    addIssue(logger::eError, Metadata.InvalidValue, key);
             } else {
                 addIssue(logger::eWarning, Metadata.CustomMetadata, key);
             }
@@ -2164,6 +2202,49 @@ ktxValidator::validateDataSize(validationContext& ctx)
         addIssue(logger::eError, FileError.IncorrectDataSize);
 }
 
+// Rewinds the file. Returns true if all levels match their hashes.
+bool
+ktxValidator::validateLevelHashes(validationContext& ctx)
+{
+    istream& is = *ctx.inp;
+    is.seekg(0);
+    streambuf* _streambuf = (is.rdbuf());
+    StreambufStream<streambuf*> ktx2Stream(_streambuf, ios::in);
+    KtxTexture<ktxTexture2> texture2;
+    ktx_error_code_e result = ktxTexture2_CreateFromStream(ktx2Stream.stream(),
+                                        KTX_TEXTURE_CREATE_NO_FLAGS,
+                                        texture2.pHandle());
+    if (result != KTX_SUCCESS) {
+        addIssue(logger::eError, FileError.CreateFailure,
+                 ktxErrorString(result));
+        return false;
+    }
+
+    ktx_uint32_t badLevel;
+    result = ktxTexture2_VerifyLevelHashes(texture2.handle(),
+                                           thread::hardware_concurrency(),
+                                           &badLevel);
+    switch (result) {
+      case KTX_SUCCESS:
+        return true;
+      case KTX_NOT_FOUND:
+        addIssue(logger::eWarning, LevelHash.Missing);
+        break;
+      case KTX_FILE_DATA_ERROR: {
+        // A wrongly sized value has already been reported by validateKvd.
+        ktx_uint64_t hash;
+        if (ktxTexture2_GetLevelHash(texture2.handle(), 0, &hash)
+            != KTX_FILE_DATA_ERROR)
+            addIssue(logger::eError, LevelHash.Mismatch, badLevel);
+        break;
+      }
+      default:
+        addIssue(logger::eError, LevelHash.Failure, ktxErrorString(result));
+        break;
+    }
+    return false;
+}
+
 // Must be called last as it rewinds the file.
 bool
 ktxValidator::validateTranscode(validationContext& ctx)
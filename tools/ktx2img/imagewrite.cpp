@@ -0,0 +1,164 @@
+// -*- tab-width: 4; -*-
+// vi: set sw=2 ts=4 sts=4 expandtab:
+
+// Copyright 2026 The Khronos Group Inc.
+// SPDX-License-Identifier: Apache-2.0
+
+//!
+//! @internal
+//! @~English
+//! @file imagewrite.cpp
+//!
+//! @brief Encoding of extracted images as PNG and OpenEXR files.
+//!
+//! PNG files are written by lodepng, shared with toktx, using the zlib
+//! implementation embedded in tinyexr at its fastest level instead of
+//! lodepng's own. OpenEXR files are written by the copy of tinyexr
+//! vendored with astc-encoder.
+//!
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+// Configure the TinyEXR library build as astc-encoder does.
+#include <assert.h>
+#define TEXR_ASSERT(x) assert(x)
+#define TINYEXR_IMPLEMENTATION
+#include "tinyexr.h"
+#include "lodepng.h"
+
+#include "imagewrite.h"
+
+namespace imagewrite {
+
+static unsigned
+fastZlib(unsigned char** out, size_t* outsize, const unsigned char* in,
+         size_t insize, const LodePNGCompressSettings*)
+{
+    using namespace tinyexr::miniz;
+
+    mz_ulong size = mz_compressBound((mz_ulong)insize);
+    *out = (unsigned char*)malloc(size);
+    if (!*out)
+        return 83; // lodepng's "memory allocation failed".
+    if (mz_compress2(*out, &size, in, (mz_ulong)insize, MZ_BEST_SPEED)
+        != MZ_OK) {
+        free(*out);
+        *out = nullptr;
+        return 111; // lodepng's "unknown compression method".
+    }
+    *outsize = size;
+    return 0;
+}
+
+bool
+encodePNG(const uint8_t* pixels, uint32_t width, uint32_t height,
+          uint32_t componentCount, uint32_t componentSize, bool srgb,
+          std::vector<uint8_t>& png, std::string& error)
+{
+    static const LodePNGColorType colorTypes[] = {
+        LCT_GREY, LCT_GREY_ALPHA, LCT_RGB, LCT_RGBA
+    };
+    LodePNGColorType colorType = colorTypes[componentCount - 1];
+    unsigned bitDepth = componentSize * 8;
+
+    // lodepng expects 16-bit components in big-endian order, as in the file.
+    std::vector<uint8_t> swapped;
+    if (componentSize == 2) {
+        size_t size = (size_t)width * height * componentCount * 2;
+        swapped.resize(size);
+        for (size_t i = 0; i < size; i += 2) {
+            uint16_t value;
+            memcpy(&value, pixels + i, 2);
+            swapped[i] = (uint8_t)(value >> 8);
+            swapped[i + 1] = (uint8_t)value;
+        }
+        pixels = swapped.data();
+    }
+
+    // Use the Up filter on every row, as fpng does. Choosing filters per
+    // row with lodepng's heuristics and its deflate implementation cost far
+    // more than they save.
+    std::vector<unsigned char> filters(height, 2);
+
+    lodepng::State state;
+    state.info_raw.colortype = colorType;
+    state.info_raw.bitdepth = bitDepth;
+    state.info_png.color.colortype = colorType;
+    state.info_png.color.bitdepth = bitDepth;
+    state.info_png.srgb_defined = srgb;
+    state.info_png.srgb_intent = 0;
+    state.encoder.auto_convert = 0;
+    state.encoder.filter_palette_zero = 0;
+    state.encoder.filter_strategy = LFS_PREDEFINED;
+    state.encoder.predefined_filters = filters.data();
+    state.encoder.zlibsettings.custom_zlib = fastZlib;
+
+    png.clear();
+    unsigned result = lodepng::encode(png, pixels, width, height, state);
+    if (result != 0) {
+        error = lodepng_error_text(result);
+        return false;
+    }
+    return true;
+}
+
+bool
+encodeEXR(const float* pixels, uint32_t width, uint32_t height,
+          uint32_t componentCount, bool half,
+          std::vector<uint8_t>& exr, std::string& error)
+{
+    // Channels are stored in the (A)BGR order most viewers expect.
+    static const char* names[] = { "R", "G", "B", "A" };
+    std::vector<float> planes[4];
+    float* planePtrs[4];
+    EXRChannelInfo channels[4];
+    int pixelTypes[4], requestedPixelTypes[4];
+    size_t pixelCount = (size_t)width * height;
+
+    EXRHeader header;
+    InitEXRHeader(&header);
+    EXRImage image;
+    InitEXRImage(&image);
+
+    for (uint32_t c = 0; c < componentCount; c++) {
+        uint32_t plane = componentCount - 1 - c;
+        // Single component images are stored as luminance.
+        const char* name = componentCount == 1 ? "Y" : names[c];
+        planes[plane].resize(pixelCount);
+        for (size_t i = 0; i < pixelCount; i++)
+            planes[plane][i] = pixels[i * componentCount + c];
+        planePtrs[plane] = planes[plane].data();
+        memset(&channels[plane], 0, sizeof(EXRChannelInfo));
+        strcpy(channels[plane].name, name);
+        pixelTypes[plane] = TINYEXR_PIXELTYPE_FLOAT;
+        requestedPixelTypes[plane] = half ? TINYEXR_PIXELTYPE_HALF
+                                          : TINYEXR_PIXELTYPE_FLOAT;
+    }
+
+    image.images = reinterpret_cast<unsigned char**>(planePtrs);
+    image.width = (int)width;
+    image.height = (int)height;
+    image.num_channels = (int)componentCount;
+    header.num_channels = (int)componentCount;
+    header.channels = channels;
+    header.pixel_types = pixelTypes;
+    header.requested_pixel_types = requestedPixelTypes;
+    header.compression_type = TINYEXR_COMPRESSIONTYPE_ZIP;
+
+    unsigned char* memory = nullptr;
+    const char* err = nullptr;
+    size_t size = SaveEXRImageToMemory(&image, &header, &memory, &err);
+    if (size == 0) {
+        error = err ? err : "unknown error";
+        if (err)
+            FreeEXRErrorMessage(err);
+        return false;
+    }
+    exr.assign(memory, memory + size);
+    free(memory);
+    return true;
+}
+
+} // namespace imagewrite
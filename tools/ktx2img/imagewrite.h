@@ -0,0 +1,40 @@
+// -*- tab-width: 4; -*-
+// vi: set sw=2 ts=4 sts=4 expandtab:
+
+// Copyright 2026 The Khronos Group Inc.
+// SPDX-License-Identifier: Apache-2.0
+
+//!
+//! @internal
+//! @~English
+//! @file imagewrite.h
+//!
+//! @brief Encoding of extracted images as PNG and OpenEXR files.
+//!
+
+#ifndef IMAGEWRITE_H
+#define IMAGEWRITE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace imagewrite {
+
+// Encode a 1, 3 or 4 component image with 8 or 16-bit components as PNG.
+// 16-bit components are in native byte order. Rows are tightly packed.
+// An sRGB chunk is added if @p srgb is set. The fastest zlib level and the
+// Up filter on every row are used, trading some file size for speed.
+bool encodePNG(const uint8_t* pixels, uint32_t width, uint32_t height,
+               uint32_t componentCount, uint32_t componentSize, bool srgb,
+               std::vector<uint8_t>& png, std::string& error);
+
+// Encode a 1, 3 or 4 component float image as OpenEXR with ZIP
+// compression. Components are stored as halfs if @p half is set.
+bool encodeEXR(const float* pixels, uint32_t width, uint32_t height,
+               uint32_t componentCount, bool half,
+               std::vector<uint8_t>& exr, std::string& error);
+
+} // namespace imagewrite
+
+#endif /* IMAGEWRITE_H */
@@ -0,0 +1,621 @@
+// -*- tab-width: 4; -*-
+// vi: set sw=2 ts=4 sts=4 expandtab:
+
+// Copyright 2026 The Khronos Group Inc.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "ktxapp.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <iostream>
+#include <math.h>
+#include <sstream>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <ktx.h>
+
+#include "argparser.h"
+#include "dfdutils/dfd.h"
+#include "imagewrite.h"
+#include "vkformat_convert.h"
+#include "vkformat_enum.h"
+#include "version.h"
+
+using namespace std;
+
+extern "C" {
+    char* vkFormatString(VkFormat format);
+}
+
+/** @page ktx2img ktx2img
+@~English
+
+Extract the images of KTX 2 files to PNG or OpenEXR files.
+
+@section ktx2img_synopsis SYNOPSIS
+    ktx2img [options] @e infile ...
+
+@section ktx2img_description DESCRIPTION
+    @b ktx2img writes the images of each named KTX2 @e infile to image files
+    for review. Images in Basis Universal formats are transcoded to RGBA8,
+    block-compressed images are decoded and supercompressed images are
+    inflated first. 8- and 16-bit UNORM and SRGB images are written as PNG
+    files and float images, including B10G11R11 and E5B9G9R9, as OpenEXR
+    files. Two component images are written with a zero blue component.
+    Images whose KTXorientation metadata indicates that their first row is
+    at the bottom are flipped so all files have the first row at the top.
+
+    Output files have the name of the @e infile, without its extension,
+    followed by _level<n>, _layer<n>, _face<n> and _slice<n> for each of
+    those dimensions the texture has more than one of, and the extension
+    @c .png or @c .exr. Multiple input files, and the images of each file,
+    are processed in parallel.
+
+    The following options are available:
+    <dl>
+    <dt>-d dir, --output_dir=dir</dt>
+    <dd>Write the output files to directory @e dir, which must exist. By
+        default they are written to the directory of each @e infile.</dd>
+    <dt>-f, --force</dt>
+    <dd>If a destination file already exists, overwrite it. Otherwise
+        an existing file is an error.</dd>
+    <dt>--level &lt;number&gt;</dt>
+    <dd>Only extract the images of mip level @e number.</dd>
+    <dt>--layer &lt;number&gt;</dt>
+    <dd>Only extract the images of array layer @e number.</dd>
+    <dt>--face &lt;number&gt;</dt>
+    <dd>Only extract the images of cube map face or depth slice
+        @e number.</dd>
+    <dt>--threads &lt;count&gt;</dt>
+    <dd>Explicitly set the number of threads to use. By default, the number
+        of threads reported by thread::hardware_concurrency or 1 if value
+        returned is 0 is used.</dd>
+    </dl>
+    @snippet{doc} ktxapp.h ktxApp options
+
+@section ktx2img_exitstatus EXIT STATUS
+    @b ktx2img exits 0 on success, 1 on command line errors and 2 on
+    functional errors.
+
+@section ktx2img_history HISTORY
+
+@par Version 4.0
+ - Initial version.
+*/
+
+
+#define QUOTE(x) #x
+#define STR(x) QUOTE(x)
+
+std::string myversion(STR(KTX2IMG_VERSION));
+std::string mydefversion(STR(KTX2IMG_DEFAULT_VERSION));
+
+class imageExtractor : public ktxApp {
+  public:
+    imageExtractor();
+
+    virtual int main(int argc, _TCHAR* argv[]);
+    virtual void usage();
+
+  protected:
+    virtual bool processOption(argparser& parser, int opt);
+    int extractFile(const _tstring& infile, ktx_uint32_t threadCount,
+                    std::ostream& err);
+
+    struct commandOptions : public ktxApp::commandOptions {
+        _tstring     outdir;
+        bool         force;
+        int          level;
+        int          layer;
+        int          faceSlice;
+        clamped<ktx_uint32_t> threadCount;
+
+        commandOptions() :
+            threadCount(std::max(1U, std::thread::hardware_concurrency()),
+                        1U, 10000U)
+        {
+            force = false;
+            level = layer = faceSlice = -1;
+        }
+    } options;
+};
+
+
+imageExtractor::imageExtractor() : ktxApp(myversion, mydefversion, options)
+{
+    argparser::option my_option_list[] = {
+        { "force", argparser::option::no_argument, NULL, 'f' },
+        { "output_dir", argparser::option::required_argument, NULL, 'd' },
+        { "level", argparser::option::required_argument, NULL, 1000 },
+        { "layer", argparser::option::required_argument, NULL, 1001 },
+        { "face", argparser::option::required_argument, NULL, 1002 },
+        { "threads", argparser::option::required_argument, NULL, 't' },
+    };
+    const int lastOptionIndex = sizeof(my_option_list)
+                                / sizeof(argparser::option);
+    option_list.insert(option_list.begin(), my_option_list,
+                       my_option_list + lastOptionIndex);
+    short_opts += "fd:t:";
+}
+
+
+void
+imageExtractor::usage()
+{
+    cerr <<
+        "Usage: " << name << " [options] <infile> ...\n"
+        "\n"
+        "  infile       The source KTX2 file. Its images are written to PNG files,\n"
+        "               or OpenEXR files for float formats, named after infile with\n"
+        "               _level<n>, _layer<n>, _face<n> and _slice<n> appended for each\n"
+        "               dimension of which the texture has more than one. Multiple\n"
+        "               infiles, and their images, are processed in parallel.\n"
+        "\n"
+        "  Options are:\n"
+        "\n"
+        "  -d dir, --output_dir=dir\n"
+        "               Write the output files to directory dir, which must exist.\n"
+        "               By default they are written to the directory of each infile.\n"
+        "  -f, --force  If a destination file already exists, overwrite it.\n"
+        "               Otherwise an existing file is an error.\n"
+        "  --level <number>\n"
+        "               Only extract the images of mip level number.\n"
+        "  --layer <number>\n"
+        "               Only extract the images of array layer number.\n"
+        "  --face <number>\n"
+        "               Only extract the images of cube map face or depth slice\n"
+        "               number.\n"
+        "  --threads <count>\n"
+        "               Explicitly set the number of threads to use. By default,\n"
+        "               the number of threads reported by\n"
+        "               thread::hardware_concurrency or 1 if value returned is 0 is\n"
+        "               used.\n";
+        ktxApp::usage();
+}
+
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+    imageExtractor ktx2img;
+
+    return ktx2img.main(argc, argv);
+}
+
+
+int
+imageExtractor::main(int argc, _TCHAR* argv[])
+{
+    processCommandLine(argc, argv, eDisallowStdin);
+
+    // Files are extracted in parallel. Any threads left over when there
+    // are fewer files than threads are shared out to extract the images of
+    // each file in parallel. Remaining files are still processed after a
+    // failure so a CI run reports every bad file.
+    size_t fileThreads = std::min<size_t>(options.threadCount,
+                                          options.infiles.size());
+    ktx_uint32_t imageThreads = std::max<ktx_uint32_t>(1,
+                              (ktx_uint32_t)(options.threadCount / fileThreads));
+    return processFiles(fileThreads, false,
+                        [&](const _tstring& infile, std::ostream& err) {
+                            return extractFile(infile, imageThreads, err);
+                        });
+}
+
+
+namespace {
+
+enum class componentType { u8, u16, f16, f32, b10g11r11, e5b9g9r9 };
+
+struct formatDesc {
+    componentType type;
+    ktx_uint32_t componentCount;
+    bool bgr;
+};
+
+/*
+ * @brief Describe the texels of the formats that can be written.
+ *
+ * @return   false if images of @p format cannot be written.
+ */
+bool
+describeFormat(VkFormat format, formatDesc& desc)
+{
+    desc.bgr = false;
+    switch (format) {
+      case VK_FORMAT_R8_UNORM:
+      case VK_FORMAT_R8_SRGB:
+        desc = { componentType::u8, 1, false }; break;
+      case VK_FORMAT_R8G8_UNORM:
+      case VK_FORMAT_R8G8_SRGB:
+        desc = { componentType::u8, 2, false }; break;
+      case VK_FORMAT_R8G8B8_UNORM:
+      case VK_FORMAT_R8G8B8_SRGB:
+        desc = { componentType::u8, 3, false }; break;
+      case VK_FORMAT_B8G8R8_UNORM:
+      case VK_FORMAT_B8G8R8_SRGB:
+        desc = { componentType::u8, 3, true }; break;
+      case VK_FORMAT_R8G8B8A8_UNORM:
+      case VK_FORMAT_R8G8B8A8_SRGB:
+        desc = { componentType::u8, 4, false }; break;
+      case VK_FORMAT_B8G8R8A8_UNORM:
+      case VK_FORMAT_B8G8R8A8_SRGB:
+        desc = { componentType::u8, 4, true }; break;
+      case VK_FORMAT_R16_UNORM:
+        desc = { componentType::u16, 1, false }; break;
+      case VK_FORMAT_R16G16_UNORM:
+        desc = { componentType::u16, 2, false }; break;
+      case VK_FORMAT_R16G16B16_UNORM:
+        desc = { componentType::u16, 3, false }; break;
+      case VK_FORMAT_R16G16B16A16_UNORM:
+        desc = { componentType::u16, 4, false }; break;
+      case VK_FORMAT_R16_SFLOAT:
+        desc = { componentType::f16, 1, false }; break;
+      case VK_FORMAT_R16G16_SFLOAT:
+        desc = { componentType::f16, 2, false }; break;
+      case VK_FORMAT_R16G16B16_SFLOAT:
+        desc = { componentType::f16, 3, false }; break;
+      case VK_FORMAT_R16G16B16A16_SFLOAT:
+        desc = { componentType::f16, 4, false }; break;
+      case VK_FORMAT_R32_SFLOAT:
+        desc = { componentType::f32, 1, false }; break;
+      case VK_FORMAT_R32G32_SFLOAT:
+        desc = { componentType::f32, 2, false }; break;
+      case VK_FORMAT_R32G32B32_SFLOAT:
+        desc = { componentType::f32, 3, false }; break;
+      case VK_FORMAT_R32G32B32A32_SFLOAT:
+        desc = { componentType::f32, 4, false }; break;
+      case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+        desc = { componentType::b10g11r11, 3, false }; break;
+      case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+        desc = { componentType::e5b9g9r9, 3, false }; break;
+      default:
+        return false;
+    }
+    return true;
+}
+
+/*
+ * @brief Convert an unsigned float with a 5-bit exponent and @p mantissaBits
+ *        bit mantissa, as in B10G11R11_UFLOAT_PACK32.
+ */
+float
+smallFloatToFloat(ktx_uint32_t bits, ktx_uint32_t mantissaBits)
+{
+    ktx_uint32_t exponent = (bits >> mantissaBits) & 0x1f;
+    ktx_uint32_t mantissa = bits & ((1U << mantissaBits) - 1);
+
+    if (exponent == 0)
+        return ldexpf((float)mantissa, -14 - (int)mantissaBits);
+    else if (exponent == 31)
+        return mantissa ? NAN : INFINITY;
+    return ldexpf((float)(mantissa | (1U << mantissaBits)),
+                  (int)exponent - 15 - (int)mantissaBits);
+}
+
+/*
+ * @brief Unpack texel @p src of a float format to @p dst.
+ */
+void
+unpackFloat(const formatDesc& desc, const ktx_uint8_t* src, float* dst)
+{
+    ktx_uint32_t packed;
+
+    switch (desc.type) {
+      case componentType::f16:
+        for (ktx_uint32_t c = 0; c < desc.componentCount; c++) {
+            ktx_uint16_t h;
+            memcpy(&h, src + c * 2, 2);
+            dst[c] = ktxHalfToFloat(h);
+        }
+        break;
+      case componentType::f32:
+        memcpy(dst, src, desc.componentCount * 4);
+        break;
+      case componentType::b10g11r11:
+        memcpy(&packed, src, 4);
+        dst[0] = smallFloatToFloat(packed & 0x7ff, 6);
+        dst[1] = smallFloatToFloat((packed >> 11) & 0x7ff, 6);
+        dst[2] = smallFloatToFloat(packed >> 22, 5);
+        break;
+      case componentType::e5b9g9r9:
+        {
+            memcpy(&packed, src, 4);
+            int exponent = (int)(packed >> 27) - 15 - 9;
+            dst[0] = ldexpf((float)(packed & 0x1ff), exponent);
+            dst[1] = ldexpf((float)((packed >> 9) & 0x1ff), exponent);
+            dst[2] = ldexpf((float)((packed >> 18) & 0x1ff), exponent);
+        }
+        break;
+      default:
+        assert(false);
+    }
+}
+
+struct imageJob {
+    ktx_uint32_t level;
+    ktx_uint32_t layer;
+    ktx_uint32_t faceSlice;
+};
+
+} // namespace
+
+
+/*
+ * @brief Extract the selected images of a single file.
+ *
+ * Messages are written to @p err so the caller can keep those of files
+ * extracted in parallel apart.
+ *
+ * @return   the exit code for the file.
+ */
+int
+imageExtractor::extractFile(const _tstring& infile, ktx_uint32_t threadCount,
+                            std::ostream& err)
+{
+    KTX_error_code result;
+    ktxTexture2* texture = nullptr;
+
+    result = ktxTexture2_CreateFromNamedFile(infile.c_str(),
+                                        KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                        &texture);
+    if (result != KTX_SUCCESS) {
+        err << name << ": " << infile << ": "
+            << (result == KTX_UNKNOWN_FILE_FORMAT
+                ? "not a KTX2 file" : ktxErrorString(result)) << endl;
+        return 2;
+    }
+
+    if (ktxTexture2_NeedsTranscoding(texture)) {
+        result = ktxTexture2_TranscodeBasis(texture, KTX_TTF_RGBA32, 0);
+    } else if (texture->isCompressed) {
+        result = ktxTexture2_DecodeBlockCompressed(texture, threadCount);
+    }
+    formatDesc desc;
+    if (result == KTX_SUCCESS
+        && !describeFormat((VkFormat)texture->vkFormat, desc))
+        result = KTX_UNSUPPORTED_TEXTURE_TYPE;
+    if (result != KTX_SUCCESS) {
+        err << name << ": " << infile << ": cannot decode images of "
+            << vkFormatString((VkFormat)texture->vkFormat) << ": "
+            << ktxErrorString(result) << endl;
+        ktxTexture_Destroy(ktxTexture(texture));
+        return 2;
+    }
+
+    if ((options.level >= 0 && (ktx_uint32_t)options.level >= texture->numLevels)
+        || (options.layer >= 0
+            && (ktx_uint32_t)options.layer >= texture->numLayers)
+        || (options.faceSlice >= 0
+            && (ktx_uint32_t)options.faceSlice
+               >= std::max(texture->numFaces, texture->baseDepth))) {
+        err << name << ": " << infile
+            << ": the texture has no images at the selected level, layer"
+            << " or face." << endl;
+        ktxTexture_Destroy(ktxTexture(texture));
+        return 2;
+    }
+
+    std::vector<imageJob> jobs;
+    for (ktx_uint32_t level = 0; level < texture->numLevels; level++) {
+        if (options.level >= 0 && (ktx_uint32_t)options.level != level)
+            continue;
+        ktx_uint32_t numFaceSlices = texture->isCubemap ? texture->numFaces
+                            : std::max(1U, texture->baseDepth >> level);
+        for (ktx_uint32_t layer = 0; layer < texture->numLayers; layer++) {
+            if (options.layer >= 0 && (ktx_uint32_t)options.layer != layer)
+                continue;
+            for (ktx_uint32_t faceSlice = 0; faceSlice < numFaceSlices;
+                 faceSlice++) {
+                if (options.faceSlice >= 0
+                    && (ktx_uint32_t)options.faceSlice != faceSlice)
+                    continue;
+                jobs.push_back({ level, layer, faceSlice });
+            }
+        }
+    }
+
+    // Flip images whose first row is at the bottom.
+    bool flip = false;
+    char* orientation;
+    unsigned int orientationLen;
+    if (ktxHashList_FindValue(&texture->kvDataHead, KTX_ORIENTATION_KEY,
+                              &orientationLen, (void**)&orientation)
+            == KTX_SUCCESS
+        && orientationLen >= 2 && orientation[1] == 'u')
+        flip = true;
+
+    bool srgb = ktxTexture2_GetOETF(texture) == KHR_DF_TRANSFER_SRGB;
+    bool exr = desc.type != componentType::u8
+               && desc.type != componentType::u16;
+    // 16-bit and packed floats lose nothing when stored as halfs.
+    bool half = desc.type != componentType::f32;
+    ktx_uint32_t outComponents = desc.componentCount == 2
+                                 ? 3 : desc.componentCount;
+    ktx_uint32_t texelSize = ktxTexture_GetElementSize(ktxTexture(texture));
+
+    _tstring stem = infile;
+    size_t slash = stem.find_last_of(_T("/\\"));
+    if (options.outdir.length()) {
+        if (slash != _tstring::npos)
+            stem.erase(0, slash + 1);
+        stem = options.outdir + _T("/") + stem;
+    }
+    size_t dot = stem.find_last_of(_T('.'));
+    if (dot != _tstring::npos
+        && (slash == _tstring::npos || options.outdir.length() || dot > slash))
+        stem.erase(dot, _tstring::npos);
+
+    // Images of the file are written in parallel. Messages are collected
+    // per image so they come out in order.
+    std::vector<std::stringstream> messages(jobs.size());
+    std::atomic<size_t> nextJob(0);
+    std::atomic<int> exitCode(0);
+    auto worker = [&]() {
+        size_t j;
+        while ((j = nextJob++) < jobs.size()) {
+            const imageJob& job = jobs[j];
+            std::stringstream outname;
+            outname << stem;
+            if (texture->numLevels > 1)
+                outname << "_level" << job.level;
+            if (texture->numLayers > 1)
+                outname << "_layer" << job.layer;
+            if (texture->isCubemap)
+                outname << "_face" << job.faceSlice;
+            else if (texture->baseDepth > 1)
+                outname << "_slice" << job.faceSlice;
+            outname << (exr ? ".exr" : ".png");
+            _tstring outfile = outname.str();
+
+            ktx_uint32_t width = std::max(1U, texture->baseWidth >> job.level);
+            ktx_uint32_t height = std::max(1U,
+                                           texture->baseHeight >> job.level);
+            ktx_size_t offset;
+            ktxTexture_GetImageOffset(ktxTexture(texture), job.level,
+                                      job.layer, job.faceSlice, &offset);
+            ktx_uint32_t rowPitch = ktxTexture_GetRowPitch(ktxTexture(texture),
+                                                           job.level);
+
+            std::vector<ktx_uint8_t> encoded;
+            std::string error;
+            bool ok;
+            try {
+                if (exr) {
+                    std::vector<float> pixels((size_t)width * height
+                                              * outComponents, 0.0f);
+                    for (ktx_uint32_t y = 0; y < height; y++) {
+                        const ktx_uint8_t* src = texture->pData + offset
+                                + (flip ? height - 1 - y : y) * rowPitch;
+                        float* dst = &pixels[(size_t)y * width * outComponents];
+                        for (ktx_uint32_t x = 0; x < width; x++) {
+                            unpackFloat(desc, src, dst);
+                            src += texelSize;
+                            dst += outComponents;
+                        }
+                    }
+                    ok = imagewrite::encodeEXR(pixels.data(), width, height,
+                                               outComponents, half, encoded,
+                                               error);
+                } else {
+                    ktx_uint32_t componentSize
+                                = desc.type == componentType::u16 ? 2 : 1;
+                    ktx_uint32_t outTexelSize = outComponents * componentSize;
+                    std::vector<ktx_uint8_t> pixels((size_t)width * height
+                                                    * outTexelSize, 0);
+                    for (ktx_uint32_t y = 0; y < height; y++) {
+                        const ktx_uint8_t* src = texture->pData + offset
+                                + (flip ? height - 1 - y : y) * rowPitch;
+                        ktx_uint8_t* dst
+                                = &pixels[(size_t)y * width * outTexelSize];
+                        if (texelSize == outTexelSize && !desc.bgr) {
+                            memcpy(dst, src, (size_t)width * texelSize);
+                            continue;
+                        }
+                        for (ktx_uint32_t x = 0; x < width; x++) {
+                            memcpy(dst, src, texelSize);
+                            if (desc.bgr)
+                                std::swap(dst[0], dst[2]);
+                            src += texelSize;
+                            dst += outTexelSize;
+                        }
+                    }
+                    ok = imagewrite::encodePNG(pixels.data(), width, height,
+                                               outComponents, componentSize,
+                                               srgb, encoded, error);
+                }
+            } catch (std::bad_alloc&) {
+                ok = false;
+                error = ktxErrorString(KTX_OUT_OF_MEMORY);
+            }
+            if (!ok) {
+                messages[j] << name << ": " << infile
+                            << ": failed to encode " << outfile << ": "
+                            << error << endl;
+                exitCode = 2;
+                continue;
+            }
+
+            FILE* outf = fopen_write_if_not_exists(outfile);
+            if (!outf && errno == EEXIST && options.force)
+                outf = _tfopen(outfile.c_str(), "wb");
+            if (!outf) {
+                messages[j] << name << ": could not open output file \""
+                            << outfile << "\". " << strerror(errno) << endl;
+                exitCode = 2;
+                continue;
+            }
+            bool written = fwrite(encoded.data(), 1, encoded.size(), outf)
+                           == encoded.size();
+            written = fclose(outf) == 0 && written;
+            if (!written) {
+                messages[j] << name << ": failed to write " << outfile
+                            << ". " << strerror(errno) << endl;
+                (void)_tunlink(outfile.c_str());
+                exitCode = 2;
+            }
+        }
+    };
+
+    threadCount = std::max(1U, std::min(threadCount,
+                                        (ktx_uint32_t)jobs.size()));
+    std::vector<std::thread> threads;
+    for (ktx_uint32_t t = 1; t < threadCount; t++) {
+        try {
+            threads.emplace_back(worker);
+        } catch (const std::system_error&) {
+            break; // Carry on with the threads we have.
+        }
+    }
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+
+    for (auto& message : messages)
+        err << message.str();
+    ktxTexture_Destroy(ktxTexture(texture));
+    return exitCode;
+}
+
+
+/*
+ * @brief process a command line option
+ *
+ * @return   true if option processed, false otherwise.
+ *
+ * @param[in]     parser,     an @c argparser holding the options to process.
+ * @param[in,out] options     commandOptions struct in which option information
+ *                            is set.
+ */
+bool
+imageExtractor::processOption(argparser& parser, int opt)
+{
+    switch (opt) {
+      case 'f':
+        options.force = true;
+        break;
+      case 'd':
+        options.outdir = parser.optarg;
+        break;
+      case 't':
+        options.threadCount = strtoi(parser.optarg.c_str());
+        break;
+      case 1000:
+        options.level = strtoi(parser.optarg.c_str());
+        break;
+      case 1001:
+        options.layer = strtoi(parser.optarg.c_str());
+        break;
+      case 1002:
+        options.faceSlice = strtoi(parser.optarg.c_str());
+        break;
+      default:
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,7 @@
+/*
+// [Code version]
+
+// [Code version]
+*/
+#define KTX2IMG_VERSION 
+#define KTX2IMG_DEFAULT_VERSION v4.0.__default__
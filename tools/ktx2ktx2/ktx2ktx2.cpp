@@ -10,7 +10,7 @@
 // add ..\imdebug.lib to the libraries list in the project properties.
 #define IMAGE_DEBUG 0
 
-#include "ktxapp.h"
+#include "convapp.h"
 
 #include <cstdlib>
 #include <errno.h>
@@ -30,9 +30,6 @@
 
 #if defined(_MSC_VER)
   #define strncasecmp _strnicmp
-  #define fileno _fileno
-  #define isatty _isatty
-  #define unlink _unlink
 #endif
 
 #if IMAGE_DEBUG
@@ -46,21 +43,27 @@ using namespace std;
 /** @page ktx2ktx2 ktx2ktx2
 @~English
 
-Create a KTX 2 file from a KTX file.
+Create a KTX 2 file from a KTX or .basis file.
 
 @section ktx2ktx2_synopsis SYNOPSIS
     ktx2ktx2 [options] [@e infile ...]
 
 @section ktx2ktx2_description DESCRIPTION
     @b ktx2ktx2 creates Khronos texture format version 2 files (KTX2) from
-    Khronos texture format version 1 files. @b ktx2ktx2 reads each named
-    @e infile. Output files have the same name as the input but with the
-    extension changed to @c .ktx2. When @b infile is not specified, a single
-    file will be read from stdin and the output written to standard out.
+    Khronos texture format version 1 files or Basis Universal .basis files.
+    @b ktx2ktx2 reads each named @e infile. Output files have the same name
+    as the input but with the extension changed to @c .ktx2. When @b infile
+    is not specified, a single file will be read from stdin and the output
+    written to standard out. Multiple input files are converted in parallel.
 
     If unrecognized metadata with keys beginning "KTX" or "ktx" is found in
     the input file, it is dropped and a warning is written to standard error.
 
+    The ETC1S or UASTC data of a .basis file is repacked without being
+    transcoded or re-encoded. ETC1S files become BasisLZ supercompressed
+    KTX2 files so @b --zcmp is ignored for them, with a warning. UASTC
+    files can be supercompressed with @b --zcmp.
+
     The following options are available:
     <dl>
     <dt>-b, --rewritebado</dt>
@@ -68,15 +71,8 @@ Create a KTX 2 file from a KTX file.
         have orientation metadata with the key "KTXOrientation"
         instead of KTXorientaion. This option will rewrite such
         bad metadata instead of dropping it.
-    <dt>-o outfile, --output=outfile</dt>
-    <dd>Name the output file @e outfile. If @e outfile is 'stdout', output will
-        be written to stdout. If there is more than 1 input file, the command
-        prints its usage message and exits.</dd>
-    <dt>-f, --force</dt>
-    <dd>If the destination file already exists, remove it and create a
-        new file, without prompting for confirmation regardless of its
-        permissions.</dd>
     </dl>
+    @snippet{doc} convapp.h convApp options
     @snippet{doc} ktxapp.h ktxApp options
 
 @section ktx2ktx2_exitstatus EXIT STATUS
@@ -99,43 +95,39 @@ Create a KTX 2 file from a KTX file.
 std::string myversion(STR(KTX2KTX2_VERSION));
 std::string mydefversion(STR(KTX2KTX2_DEFAULT_VERSION));
 
-class ktxUpgrader : public ktxApp {
+class ktxUpgrader : public convApp {
   public:
     ktxUpgrader();
 
-    virtual int main(int argc, _TCHAR* argv[]);
     virtual void usage();
 
   protected:
     virtual bool processOption(argparser& parser, int opt);
-    void validateOptions();
+    virtual int createTexture(const _tstring& infile,
+                              const std::vector<ktx_uint8_t>& data,
+                              ktxTexture** texture, std::ostream& err);
+    virtual KTX_error_code writeTexture(ktxTexture* texture, FILE* outf);
 
-    struct commandOptions : public ktxApp::commandOptions {
-        bool         useStdout;
-        bool         force;
+    struct commandOptions : public convApp::commandOptions {
         bool         rewriteBadOrientation;
 
         commandOptions() {
-            useStdout = false;
-            force = false;
             rewriteBadOrientation = false;
         }
     } options;
 };
 
 
-ktxUpgrader::ktxUpgrader() : ktxApp(myversion, mydefversion, options)
+ktxUpgrader::ktxUpgrader() : convApp(myversion, mydefversion, options)
 {
     argparser::option my_option_list[] = {
-        { "force", argparser::option::no_argument, NULL, 'f' },
-        { "outfile", argparser::option::required_argument, NULL, 'o' },
         { "rewritebado", argparser::option::no_argument, NULL, 'b' },
     };
     const int lastOptionIndex = sizeof(my_option_list)
                                 / sizeof(argparser::option);
     option_list.insert(option_list.begin(), my_option_list,
                        my_option_list + lastOptionIndex);
-    short_opts += "bd:fo:";
+    short_opts += "bd:";
 }
 
 
@@ -145,10 +137,12 @@ ktxUpgrader::usage()
     cerr <<
         "Usage: " << name << " [options] [<infile> ...]\n"
         "\n"
-        "  infile       The source ktx file. The output is written to a file of the\n"
-        "               same name with the extension changed to '.ktx2'. If it is not\n"
-        "               specified input will be read from stdin and the converted texture\n"
-        "               written to stdout.\n"
+        "  infile       The source ktx or .basis file. The output is written to a file\n"
+        "               of the same name with the extension changed to '.ktx2'. If it\n"
+        "               is not specified input will be read from stdin and the converted\n"
+        "               texture written to stdout. Multiple infiles are converted in\n"
+        "               parallel. --zcmp is ignored, with a warning, for ETC1S .basis\n"
+        "               files as their output is BasisLZ supercompressed.\n"
         "\n"
         "  Options are:\n"
         "\n"
@@ -156,15 +150,8 @@ ktxUpgrader::usage()
         "               Rewrite bad orientation metadata. Some in-the-wild KTX files\n"
         "               have orientation metadata with the key \"KTXOrientation\"\n"
         "               instead of \"KTXorientaion\". This option will rewrite such\n"
-        "               bad metadata instead of dropping it.\n"
-        "  -o outfile, --output=outfile\n"
-        "               Name the output file outfile. If @e outfile is 'stdout', output\n"
-        "               will be written to stdout. If there is more than 1 infile,\n"
-        "               the command prints its usage message and exits.\n"
-        "  -f, --force  If the output file already exists, remove it and create a\n"
-        "               new file, without prompting for confirmation regardless of\n"
-        "               its permissions.\n";
-        ktxApp::usage();
+        "               bad metadata instead of dropping it.\n";
+        convApp::usage();
 }
 
 
@@ -176,181 +163,132 @@ int _tmain(int argc, _TCHAR* argv[])
 }
 
 
+/*
+ * @brief Create a texture from the contents of a KTX v1 or .basis file.
+ *
+ * KTX v1 textures have their metadata checked, dropping unrecognized KTX
+ * metadata, and both have writer metadata added. With --zcmp, KTX v1
+ * textures are converted to KTX2 so they can be supercompressed.
+ *
+ * @return   the exit code for the file.
+ */
 int
-ktxUpgrader::main(int argc, _TCHAR* argv[])
+ktxUpgrader::createTexture(const _tstring& infile,
+                           const std::vector<ktx_uint8_t>& data,
+                           ktxTexture** texture, std::ostream& err)
 {
-    FILE *inf, *outf = nullptr;
     KTX_error_code result;
-    ktxTexture1* texture = 0;
-    int exitCode = 0;
-
-    processCommandLine(argc, argv);
-    validateOptions();
-
-    std::vector<_tstring>::const_iterator it, s, e;
-    for (it = options.infiles.begin(); it < options.infiles.end(); it++) {
-        _tstring infile = *it;
-        _tstring outfile;
-
-        if (infile.compare(_T("-")) == 0) {
-            inf = stdin;
-#if defined(_WIN32)
-            /* Set "stdin" to have binary mode */
-            (void)_setmode( _fileno( stdin ), _O_BINARY );
-#endif
+    static const ktx_uint8_t basisSig[] = { 's', 'B' };
+
+    if (data.size() >= sizeof(basisSig)
+        && memcmp(data.data(), basisSig, sizeof(basisSig)) == 0) {
+        result = ktxTexture2_CreateFromBasis(data.data(), data.size(),
+                                             (ktxTexture2**)texture);
+    } else {
+        result = ktxTexture1_CreateFromMemory(data.data(), data.size(),
+                                        KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                        (ktxTexture1**)texture);
+    }
+    if (result != KTX_SUCCESS) {
+        if (result == KTX_UNKNOWN_FILE_FORMAT) {
+            err << infile << " is not a KTX v1 file or a .basis file."
+                << endl;
         } else {
-            inf = _tfopen(infile.c_str(), "rb");
+            err << name
+                << " failed to create ktxTexture from " << infile
+                << ": " << ktxErrorString(result) << endl;
         }
+        return 2;
+    }
 
-        if (inf) {
-            if (infile.compare(_T("-"))
-                && !options.useStdout && !options.outfile.length())
-            {
-                size_t dot;
-
-                outfile = infile;
-                dot = outfile.find_last_of(_T('.'));
-                if (dot != _tstring::npos) {
-                    outfile.erase(dot, _tstring::npos);
-                }
-                outfile += _T(".ktx2");
-            } else if (options.outfile.length()) {
-                outfile = options.outfile;
-            }
-
-            if (options.useStdout) {
-                outf = stdout;
-#if defined(_WIN32)
-                /* Set "stdout" to have binary mode */
-                (void)_setmode( _fileno( stdout ), _O_BINARY );
-#endif
-            } else if (outfile.length()) {
-                outf = fopen_write_if_not_exists(outfile);
-            }
-
-            if (!outf && errno == EEXIST) {
-                bool force = options.force;
-                if (!force) {
-                    if (isatty(fileno(stdin))) {
-                        char answer;
-                        cout << "Output file " << options.outfile
-                             << " exists. Overwrite? [Y or n] ";
-                        cin >> answer;
-                        if (answer == 'Y') {
-                            force = true;
-                        }
+    if ((*texture)->classId == ktxTexture1_c) {
+        // Some in-the-wild KTX files have incorrect KTXOrientation
+        // Warn about dropping invalid metadata.
+        ktxHashListEntry* pEntry;
+        for (pEntry = (*texture)->kvDataHead;
+             pEntry != NULL;
+             pEntry = ktxHashList_Next(pEntry)) {
+            unsigned int keyLen;
+            char* key;
+
+            ktxHashListEntry_GetKey(pEntry, &keyLen, &key);
+            if (strncasecmp(key, "KTX", 3) == 0) {
+                if (strcmp(key, KTX_ORIENTATION_KEY)
+                    && strcmp(key, KTX_WRITER_KEY)) {
+                    if (strcmp(key, "KTXOrientation") == 0
+                        && options.rewriteBadOrientation) {
+                            unsigned int orientLen;
+                            char* orientation;
+                            ktxHashListEntry_GetValue(pEntry,
+                                                &orientLen,
+                                                (void**)&orientation);
+                            ktxHashList_AddKVPair(&(*texture)->kvDataHead,
+                                                  KTX_ORIENTATION_KEY,
+                                                  orientLen,
+                                                  orientation);
+                   } else {
+                        err << name
+                            << ": Warning: Dropping unrecognized "
+                            << "metadata \"" << key << "\""
+                            << std::endl;
                     }
-                }
-                if (force) {
-                    outf = _tfopen(outfile.c_str(), "wb");
+                    ktxHashList_DeleteEntry(&(*texture)->kvDataHead,
+                                            pEntry);
                 }
             }
+        }
+    }
 
-            if (outf) {
-                result = ktxTexture1_CreateFromStdioStream(inf,
+    addWriterMetadata(*texture);
+
+    if (options.zcmp) {
+        ktxTexture2* texture2 = nullptr;
+        if ((*texture)->classId == ktxTexture1_c) {
+            // There is no direct conversion so go via a KTX2 file in memory.
+            ktx_uint8_t* ktx2;
+            ktx_size_t ktx2Size;
+            result = ktxTexture1_WriteKTX2ToMemory((ktxTexture1*)*texture,
+                                                   &ktx2, &ktx2Size);
+            if (result == KTX_SUCCESS) {
+                result = ktxTexture2_CreateFromMemory(ktx2, ktx2Size,
                                         KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
-                                        &texture);
-                if (result != KTX_SUCCESS) {
-                    if (result == KTX_UNKNOWN_FILE_FORMAT) {
-                        cerr << infile << " is not a KTX v1 file." << endl;
-                    } else if (result != KTX_SUCCESS) {
-                        cerr << name
-                             << " failed to create ktxTexture from " << infile
-                             << ": " << ktxErrorString(result) << endl;
-                    }
-                    (void)fclose(inf);
-                    (void)fclose(outf);
-                    (void)_tunlink(options.outfile.c_str());
-                    exitCode = 2;
-                    goto cleanup;
-                }
-
-                // Some in-the-wild KTX files have incorrect KTXOrientation
-                // Warn about dropping invalid metadata.
-                ktxHashListEntry* pEntry;
-                for (pEntry = texture->kvDataHead;
-                     pEntry != NULL;
-                     pEntry = ktxHashList_Next(pEntry)) {
-                    unsigned int keyLen;
-                    char* key;
-
-                    ktxHashListEntry_GetKey(pEntry, &keyLen, &key);
-                    if (strncasecmp(key, "KTX", 3) == 0) {
-                        if (strcmp(key, KTX_ORIENTATION_KEY)
-                            && strcmp(key, KTX_WRITER_KEY)) {
-                            if (strcmp(key, "KTXOrientation") == 0
-                                && options.rewriteBadOrientation) {
-                                    unsigned int orientLen;
-                                    char* orientation;
-                                    ktxHashListEntry_GetValue(pEntry,
-                                                        &orientLen,
-                                                        (void**)&orientation);
-                                    ktxHashList_AddKVPair(&texture->kvDataHead,
-                                                          KTX_ORIENTATION_KEY,
-                                                          orientLen,
-                                                          orientation);
-                           } else {
-                                cerr << name
-                                     << ": Warning: Dropping unrecognized "
-                                     << "metadata \"" << key << "\""
-                                     << std::endl;
-                            }
-                            ktxHashList_DeleteEntry(&texture->kvDataHead,
-                                                    pEntry);
-                        }
-                    }
-                }
-
-                // Add required writer metadata.
-                std::stringstream writer;
-                writeId(writer, options.test != 0);
-                ktxHashList_AddKVPair(&texture->kvDataHead, KTX_WRITER_KEY,
-                                      (ktx_uint32_t)writer.str().length() + 1,
-                                      writer.str().c_str());
-
-                result = ktxTexture1_WriteKTX2ToStdioStream(texture, outf);
-                ktxTexture_Destroy(ktxTexture(texture));
-                (void)fclose(inf);
-                (void)fclose(outf);
-                if (result != KTX_SUCCESS) {
-                    cerr << name
-                         << " failed to write KTX2 file; "
-                         << ktxErrorString(result) << endl;
-                    (void)_tunlink(options.outfile.c_str());
-                    exitCode = 2;
-                    goto cleanup;
-                }
-            } else {
-                cerr << name
-                     << " could not open output file \""
-                     << (options.outfile.length() ? options.outfile.c_str()
-                                                  : "stdout")
-                     << "\". " << strerror(errno) << endl;
-                exitCode = 2;
-                goto cleanup;
+                                        &texture2);
+                free(ktx2);
             }
+            ktxTexture_Destroy(*texture);
+            *texture = ktxTexture(texture2);
         } else {
-            cerr << name
-                 << " could not open input file \""
-                 << (infile.compare(_T("-")) ? infile : "stdin") << "\". "
-                 << strerror(errno) << endl;
-            exitCode = 2;
-            goto cleanup;
+            texture2 = (ktxTexture2*)*texture;
+        }
+        if (result == KTX_SUCCESS) {
+            if (texture2->supercompressionScheme == KTX_SS_BASIS_LZ) {
+                err << name << ": Warning: not applying --zcmp to " << infile
+                    << " as it is BasisLZ supercompressed." << endl;
+            } else {
+                result = ktxTexture2_DeflateZstd(texture2, options.zcmpLevel);
+            }
+        }
+        if (result != KTX_SUCCESS) {
+            err << name
+                << " failed to supercompress " << infile << ": "
+                << ktxErrorString(result) << endl;
+            if (*texture)
+                ktxTexture_Destroy(*texture);
+            return 2;
         }
     }
-
-cleanup:
-    return exitCode;
+    return 0;
 }
 
 
-void
-ktxUpgrader::validateOptions()
+KTX_error_code
+ktxUpgrader::writeTexture(ktxTexture* texture, FILE* outf)
 {
-    if (options.infiles.size() > 1 && options.outfile.length()) {
-        cerr << "Can't use -o when there are multiple infiles." << endl;
-        usage();
-        exit(1);
+    if (texture->classId == ktxTexture1_c) {
+        return ktxTexture1_WriteKTX2ToStdioStream((ktxTexture1*)texture,
+                                                  outf);
+    } else {
+        return ktxTexture_WriteToStdioStream(texture, outf);
     }
 }
 
@@ -371,23 +309,8 @@ ktxUpgrader::processOption(argparser& parser, int opt)
       case 'b':
         options.rewriteBadOrientation = true;
         break;
-     case 'f':
-        options.force = true;
-        break;
-     case 'o':
-        options.outfile = parser.optarg;
-        if (!options.outfile.compare(_T("stdout"))) {
-            options.useStdout = true;
-        } else {
-            size_t dot;
-            dot = options.outfile.find_last_of('.');
-            if (dot == _tstring::npos) {
-                options.outfile += _T(".ktx2");
-            }
-        }
-        break;
       default:
-        return false;
+        return convApp::processOption(parser, opt);
     }
     return true;
 }
@@ -58,6 +58,18 @@ Supercompress the images in a KTX2 file.
     results with UASTC, the data should be conditioned for zstd by using the
     @e --uastc_rdo_q and, optionally, @e --uastc_rdo_d options.
 
+    Files that are already supercompressed with zstd can be given a new
+    @e --zcmp level or @e --zfilter. Each level is inflated and deflated
+    again separately, in parallel up to the @e --threads count, so the
+    whole texture is never inflated at once. The result is the same as
+    supercompressing the original uncompressed file with the new options.
+    If any encoding option is also given, the file is fully inflated first.
+
+    Block-compressed files in BC1-5, BC7, ETC2, EAC or LDR ASTC formats
+    can be re-encoded to ASTC, Basis Universal or UASTC. The images are
+    decoded in memory, in parallel up to the @e --threads count, and the
+    decoded images are passed to the encoder.
+
     @b ktxsc reads each named @e infile and compresses it in place. When
     @e infile is not specified, a single file will be read from @e stdin and the
     output written to @e stdout. When one or more files is specified each will
@@ -155,6 +167,18 @@ ktxSupercompressor::usage()
 }
 
 
+static bool isZstdScheme(ktxTexture2* texture)
+{
+    switch (texture->supercompressionScheme) {
+      case KTX_SS_ZSTD:
+      case KTX_SS_ZSTD_SHUFFLE_DELTA:
+      case KTX_SS_ZSTD_BLOCK_SPLIT:
+        return true;
+      default:
+        return false;
+    }
+}
+
 static _tstring dir_name(_tstring& path)
 {
     // Supports both Unix-style and Windows-style.
@@ -243,8 +267,11 @@ ktxSupercompressor::main(int argc, _TCHAR* argv[])
             }
 
             if (outf) {
+                // Don't load the image data yet. If it is already Zstd
+                // deflated and only a new level or filter is requested
+                // it is re-deflated without inflating the whole texture.
                 result = ktxTexture2_CreateFromStdioStream(inf,
-                                        KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                        KTX_TEXTURE_CREATE_NO_FLAGS,
                                         &texture);
 
                 if (result == KTX_UNKNOWN_FILE_FORMAT) {
@@ -258,7 +285,18 @@ ktxSupercompressor::main(int argc, _TCHAR* argv[])
                     exitCode = 2;
                     goto cleanup;
                 }
-                (void)fclose(inf);
+                if (!options.zcmp || options.astc || options.etc1s
+                    || options.bopts.uastc || !isZstdScheme(texture)) {
+                    result = ktxTexture_LoadImageData(ktxTexture(texture),
+                                                      nullptr, 0);
+                    if (result != KTX_SUCCESS) {
+                        cerr << name
+                             << " failed to load image data from " << infile
+                             << ": " << ktxErrorString(result) << endl;
+                        exitCode = 2;
+                        goto cleanup;
+                    }
+                }
 
                 if (texture->classId != ktxTexture2_c) {
                     cerr << name << ": "
@@ -267,7 +305,8 @@ ktxSupercompressor::main(int argc, _TCHAR* argv[])
                     exitCode = 1;
                     goto cleanup;
                 }
-                if (texture->supercompressionScheme != KTX_SS_NONE) {
+                if (texture->supercompressionScheme != KTX_SS_NONE
+                    && texture->pData != nullptr) {
                     cerr << name << ": "
                          << "Cannot supercompress already supercompressed files."
                          << endl;
@@ -275,12 +314,24 @@ ktxSupercompressor::main(int argc, _TCHAR* argv[])
                     goto cleanup;
                 }
                 if ((options.astc || options.etc1s || options.bopts.uastc) && texture->isCompressed) {
-                    cerr << name << ": "
-                         << "Cannot encode already block-compressed textures "
-                         << "to ASTC, Basis Universal or UASTC."
-                         << endl;
-                    exitCode = 1;
-                    goto cleanup;
+                    // Decode to uncompressed images for the encoders.
+                    result = ktxTexture2_DecodeBlockCompressed(texture,
+                                                        options.threadCount);
+                    if (result == KTX_UNSUPPORTED_TEXTURE_TYPE) {
+                        cerr << name << ": "
+                             << "Cannot decode the block-compressed format of "
+                             << infile << " for encoding to ASTC, "
+                             << "Basis Universal or UASTC."
+                             << endl;
+                        exitCode = 1;
+                        goto cleanup;
+                    } else if (result != KTX_SUCCESS) {
+                        cerr << name
+                             << " failed to decode " << infile
+                             << ": " << ktxErrorString(result) << endl;
+                        exitCode = 2;
+                        goto cleanup;
+                    }
                 }
 
                 // Modify the writer metadata.
@@ -294,6 +345,7 @@ ktxSupercompressor::main(int argc, _TCHAR* argv[])
                 exitCode = encode(texture, options.inputSwizzle, infile);
                 if (exitCode)
                     goto cleanup;
+                (void)fclose(inf);
                 result = ktxTexture_WriteToStdioStream(ktxTexture(texture), outf);
                 if (result != KTX_SUCCESS) {
                     cerr << name
@@ -18,16 +18,16 @@
 #include <stdexcept>
 #include <vector>
 
-#include "image.hpp"
+#include "imageio.hpp"
 
-const std::vector<Image::CreateFunction> Image::CreateFunctions = {
+const std::vector<CreateFunction> CreateFunctions = {
     CreateFromNPBM,
     CreateFromPNG,
     CreateFromJPG
 };
 
-Image* Image::CreateFromFile(const _tstring& name,
-                             bool transformOETF, rescale_e rescale) {
+Image* CreateFromFile(const _tstring& name,
+                      bool transformOETF, Image::rescale_e rescale) {
     FILE* f;
     Image* image;
 
@@ -47,7 +47,7 @@ Image* Image::CreateFromFile(const _tstring& name,
             image = (*func)(f, transformOETF, rescale);
             fclose(f);
             return image;
-        } catch (different_format&) {
+        } catch (Image::different_format&) {
             rewind(f);
             continue;
         }
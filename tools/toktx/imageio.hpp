@@ -0,0 +1,37 @@
+// -*- tab-width: 4; -*-
+// vi: set sw=2 ts=4 expandtab:
+
+// Copyright 2010-2020 The Khronos Group Inc.
+// SPDX-License-Identifier: Apache-2.0
+
+//!
+//! @internal
+//! @~English
+//! @file imageio.hpp
+//!
+//! @brief Creation of Images from files.
+//!
+
+#ifndef IMAGEIO_HPP
+#define IMAGEIO_HPP
+
+#include <stdio.h>
+#include <vector>
+
+#include "argparser.h"
+#include "image.hpp"
+
+typedef Image* (*CreateFunction)(FILE* f, bool transformOETF,
+                                 Image::rescale_e rescale);
+extern const std::vector<CreateFunction> CreateFunctions;
+
+Image* CreateFromNPBM(FILE*, bool transformOETF = true,
+                      Image::rescale_e rescale = Image::eNoRescale);
+Image* CreateFromJPG(FILE* f, bool transformOETF = true,
+                     Image::rescale_e rescale = Image::eNoRescale);
+Image* CreateFromPNG(FILE* f, bool transformOETF = true,
+                     Image::rescale_e rescale = Image::eNoRescale);
+Image* CreateFromFile(const _tstring& name, bool transformOETF = true,
+                      Image::rescale_e rescale = Image::eNoRescale);
+
+#endif /* IMAGEIO_HPP */
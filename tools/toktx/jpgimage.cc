@@ -20,7 +20,7 @@
 #include <sstream>
 #include <stdexcept>
 
-#include "image.hpp"
+#include "imageio.hpp"
 #include "encoder/jpgd.h"
 
 using namespace jpgd;
@@ -74,7 +74,7 @@ class myjpgdstream : public jpeg_decoder_file_stream {
 
 // All JPEG files are sRGB.
 Image*
-Image::CreateFromJPG(FILE* src, bool, rescale_e)
+CreateFromJPG(FILE* src, bool, Image::rescale_e)
 {
     myjpgdstream stream(src);
     uint32_t componentCount;
@@ -123,11 +123,11 @@ Image::CreateFromJPG(FILE* src, bool, rescale_e)
     switch (componentCount) {
       case 1: {
         image = new r8image(w, h, (r8color*)imageData);
-        image->colortype = Image::eLuminance;
+        image->setColortype(Image::eLuminance);
         break;
       } case 3: {
         image = new rgb8image(w, h, (rgb8color*)imageData);
-        image->colortype = Image::eRGB;
+        image->setColortype(Image::eRGB);
         break;
       }
     }
@@ -30,7 +30,7 @@
 #include "stdafx.h"
 #include <inttypes.h>
 #include <stdlib.h>
-#include "image.hpp"
+#include "imageio.hpp"
 
 
 static int tupleSize(const char* tupleType);
@@ -120,7 +120,7 @@ static void readImage(FILE* src, Image& image, int32_t maxval);
 //! @author Mark Callow
 //!
 Image*
-Image::CreateFromNPBM(FILE* src, bool transformOETF, Image::rescale_e rescale)
+CreateFromNPBM(FILE* src, bool transformOETF, Image::rescale_e rescale)
 {
     char line[255];
     int numvals;
@@ -139,7 +139,7 @@ Image::CreateFromNPBM(FILE* src, bool transformOETF, Image::rescale_e rescale)
             throw std::runtime_error("Plain PPM format is not supported.");
         }
     }
-    throw different_format();
+    throw Image::different_format();
 }
 
 
@@ -20,7 +20,7 @@
 #include <sstream>
 #include <stdexcept>
 
-#include "image.hpp"
+#include "imageio.hpp"
 #include "lodepng.h"
 #include <KHR/khr_df.h>
 #include "dfd.h"
@@ -28,7 +28,7 @@
 void warning(const char *pFmt, ...);
 
 Image*
-Image::CreateFromPNG(FILE* src, bool transformOETF, Image::rescale_e rescale)
+CreateFromPNG(FILE* src, bool transformOETF, Image::rescale_e rescale)
 {
     // Unfortunately LoadPNG doesn't believe in stdio plus
     // the function we need only reads from memory. To avoid
@@ -138,8 +138,8 @@ Image::CreateFromPNG(FILE* src, bool transformOETF, Image::rescale_e rescale)
         // To avoid potentially uninitialized variable warning.
         componentCount = 0;
     }
-    if (rescale == eAlwaysRescaleTo8Bits
-        || (rescale == eRescaleTo8BitsIfLess
+    if (rescale == Image::eAlwaysRescaleTo8Bits
+        || (rescale == Image::eRescaleTo8BitsIfLess
             && state.info_png.color.bitdepth < 8)) {
         state.info_raw.bitdepth = 8;
         if (state.info_png.color.bitdepth != 8) {
@@ -200,16 +200,16 @@ Image::CreateFromPNG(FILE* src, bool transformOETF, Image::rescale_e rescale)
     }
     switch (componentCount) {
       case 1:
-        image->colortype = Image::eLuminance;  // Defined in PNG spec.
+        image->setColortype(Image::eLuminance);  // Defined in PNG spec.
         break;
       case 2:
-        image->colortype = Image::eLuminanceAlpha; // ditto
+        image->setColortype(Image::eLuminanceAlpha); // ditto
         break;
       case 3:
-        image->colortype = Image::eRGB;
+        image->setColortype(Image::eRGB);
         break;
       case 4:
-        image->colortype = Image::eRGBA;
+        image->setColortype(Image::eRGBA);
         break;
     }
 
@@ -26,7 +26,7 @@
 #include "../../lib/vkformat_enum.h"
 #include "argparser.h"
 #include "version.h"
-#include "image.hpp"
+#include "imageio.hpp"
 #if (IMAGE_DEBUG) && defined(_DEBUG) && defined(_WIN32) && !defined(_WIN32_WCE)
 #  include "imdebug.h"
 #elif defined(IMAGE_DEBUG) && IMAGE_DEBUG
@@ -66,6 +66,8 @@ enum oetf_e {
 };
 
 static ktx_uint32_t log2(ktx_uint32_t v);
+static KTX_error_code createKtx1Copy(ktxTexture2* texture2,
+                                     ktxTexture1** texture1);
 #if IMAGE_DEBUG
 static void dumpImage(_TCHAR* name, int width, int height, int components,
                       int componentSize, unsigned char* srcImage);
@@ -171,7 +173,9 @@ Create a KTX file from JPEG, PNG or netpbm format files.
         z=1, etc. It is an error to specify this together with
         @b --layers or @b --cubemap.</dd>
     <dt>--genmipmap</dt>
-    <dd>Causes mipmaps to be generated for each input file. This option is
+    <dd>Causes mipmaps to be generated for each input file. With @b --depth
+        the mipmaps are generated from all the depth slices, filtering across
+        as well as within them. This option is
         mutually exclusive with @b --automipmap and @b --mipmap. When set,
         the following mipmap-generation related options become valid,
         otherwise they are ignored.
@@ -262,7 +266,8 @@ Create a KTX file from JPEG, PNG or netpbm format files.
         Resampler options can be set via @b --filter and  @b --fscale. </dd>
     <dt>--scale &lt;value&gt;</dt>
     <dd>Scale images by @e value as they are read. Resampler options can
-        be set via @b --filter and  @b --fscale. </dd>.
+        be set via @b --filter and  @b --fscale. It cannot be used with
+        @b --mipmap.</dd>.
     <dt>--swizzle &lt;swizzle&gt;
     <dd>Add swizzle metadata to the file being created. @e swizzle
         has the same syntax as the parameter for @b --input_swizzle.
@@ -277,6 +282,17 @@ Create a KTX file from JPEG, PNG or netpbm format files.
         1.0.
     <dt>--t2</dt>
     <dd>Output in KTX2 format. Default is KTX.</dd>
+    <dt>--output "&lt;outfile&gt; [&lt;encoding options&gt;]"</dt>
+    <dd>Also write the texture to @e outfile, encoded according to the
+        encoding options that follow the name. These are the options in the
+        list below apart from @b --input_swizzle and @b --normalize.
+        Encoding options not given take their default values rather than
+        those on the command line, except for @b --threads. The images are
+        read and processed, and any mipmaps generated, once for all outputs
+        and the outputs are then encoded concurrently, sharing the threads.
+        Can be given more than once. Implies @b --t2. When block-compressed
+        and uncompressed outputs are mixed, @b --input_swizzle is applied to
+        the images before encoding.</dd>
     </dl>
     @snippet{doc} scapp.h scApp options
 
@@ -338,7 +354,22 @@ class toktxApp : public scApp {
   protected:
     virtual bool processOption(argparser& parser, int opt);
     void processEnvOptions();
+    void processOutputOptions();
     void validateOptions();
+    int writeOutput(ktxTexture* texture, const _tstring& outfile,
+                    encodeSettings& settings, const string& defaultSwizzle,
+                    bool imageSwizzled);
+    int writeOutputs(ktxTexture* texture, const string& defaultSwizzle,
+                     bool imageSwizzled);
+
+    // An additional output requested with --output.
+    struct outputSpec {
+        _tstring outfile;
+        encodeSettings settings;
+    };
+    std::vector<outputSpec> extraOutputs;
+    // Set while the options given with --output are parsed.
+    bool parsingOutput;
 
     struct commandOptions : public scApp::commandOptions {
         struct mipgenOptions {
@@ -377,6 +408,7 @@ class toktxApp : public scApp {
             // These values are selected to match the number of components.
             eUnspecified=0, eR=1, eRG, eRGB, eRGBA
         } targetType;
+        std::vector<_tstring> outputs;
 
         commandOptions() {
             automipmap = 0;
@@ -406,7 +438,8 @@ class toktxApp : public scApp {
     } options;
 };
 
-toktxApp::toktxApp() : scApp(myversion, mydefversion, options)
+toktxApp::toktxApp() : scApp(myversion, mydefversion, options),
+                       parsingOutput(false)
 {
     argparser::option my_option_list[] = {
         { "2d", argparser::option::no_argument, &options.two_d, 1 },
@@ -434,6 +467,7 @@ toktxApp::toktxApp() : scApp(myversion, mydefversion, options)
         { "assign_oetf", argparser::option::required_argument, NULL, 1104},
         { "assign_primaries", argparser::option::required_argument, NULL, 1105},
         { "t2", argparser::option::no_argument, &options.ktx2, 1},
+        { "output", argparser::option::required_argument, NULL, 1106},
     };
 
     const int lastOptionIndex = sizeof(my_option_list)
@@ -514,8 +548,10 @@ toktxApp::usage()
         "               number > 0. Provide the file(s) for z=0 first then those for\n"
         "               z=1, etc. It is an error to specify this together with\n"
         "               --layers or --cubemap.\n"
-        "  --genmipmap  Causes mipmaps to be generated for each input file. This option\n"
-        "               is mutually exclusive with --automipmap and --mipmap. When set\n"
+        "  --genmipmap  Causes mipmaps to be generated for each input file. With --depth\n"
+        "               the mipmaps are generated from all the depth slices, filtering\n"
+        "               across as well as within them. This option is mutually\n"
+        "               exclusive with --automipmap and --mipmap. When set\n"
         "               the following mipmap-generation related options become valid,\n"
         "               otherwise they are ignored.\n"
         "      --filter <name>\n"
@@ -606,8 +642,20 @@ toktxApp::usage()
         "               size. Resampler options can be set via --filter and --fscale.\n"
         "  --scale <value>\n"
         "               Scale images by <value> as they are read. Resampler options can\n"
-        "               be set via --filter and --fscale.\n"
-        "  --t2         Output in KTX2 format. Default is KTX.\n";
+        "               be set via --filter and --fscale. It cannot be used with\n"
+        "               --mipmap.\n"
+        "  --t2         Output in KTX2 format. Default is KTX.\n"
+        "  --output \"<outfile> [<encoding options>]\"\n"
+        "               Also write the texture to outfile, encoded according to the\n"
+        "               encoding options that follow the name. These are the options\n"
+        "               below apart from --input_swizzle and --normalize. Encoding\n"
+        "               options not given take their default values rather than those\n"
+        "               on the command line, except for --threads. The images are read\n"
+        "               and processed, and any mipmaps generated, once for all outputs\n"
+        "               and the outputs are then encoded concurrently, sharing the\n"
+        "               threads. Can be given more than once. Implies --t2. When\n"
+        "               block-compressed and uncompressed outputs are mixed,\n"
+        "               --input_swizzle is applied to the images before encoding.\n";
     scApp::usage();
     cerr << endl <<
         "Options can also be set in the environment variable TOKTX_OPTIONS.\n"
@@ -633,6 +681,19 @@ imageCount(uint32_t levelCount, uint32_t layerCount,
     return layerCount * faceCount * levelPixelDepth;
 }
 
+static ktx_uint32_t
+imageWrapMode(basisu::Resampler::Boundary_Op wrapMode)
+{
+    switch (wrapMode) {
+      case basisu::Resampler::Boundary_Op::BOUNDARY_WRAP:
+        return KTX_IMAGE_WRAP_REPEAT;
+      case basisu::Resampler::Boundary_Op::BOUNDARY_REFLECT:
+        return KTX_IMAGE_WRAP_REFLECT;
+      default:
+        return KTX_IMAGE_WRAP_CLAMP;
+    }
+}
+
 int _tmain(int argc, _TCHAR* argv[])
 {
     return theApp.main(argc, argv);
@@ -642,11 +703,13 @@ int
 toktxApp::main(int argc, _TCHAR *argv[])
 {
     KTX_error_code ret;
-    ktxTextureCreateInfo createInfo;
-    ktxTexture* texture = 0;
+    ktxTexture2* texture2 = nullptr;
+    ktxTexture* texture = nullptr;
     int exitCode = 0;
-    unsigned int componentCount = 1, faceSlice, level, layer, levelCount = 1;
+    unsigned int faceSlice, level, layer, levelCount = 1;
     unsigned int levelWidth=0, levelHeight=0, levelDepth=0;
+    unsigned int numFaces, numLayers, numLevels = 1;
+    unsigned int baseWidth = 0, baseHeight = 0, baseDepth;
     struct _imageAttribs {
         khr_df_transfer_e oetf;
         khr_df_primaries_e primaries;
@@ -663,23 +726,35 @@ toktxApp::main(int argc, _TCHAR *argv[])
         false
     };
     string defaultSwizzle;
+    // The decoded images and their descriptions for
+    // ktxTexture2_CreateFromImages, which does all further processing.
+    std::vector<std::unique_ptr<Image>> images;
+    std::vector<ktxSourceImage> sourceImages;
+    ktxImageParams params;
 
     processEnvOptions();
     processCommandLine(argc, argv, eDisallowStdin, eFirst);
     validateOptions();
 
-    memset(&createInfo, 0, sizeof(createInfo));
-    if (options.cubemap)
-      createInfo.numFaces = 6;
-    else
-      createInfo.numFaces = 1;
-
-    if (options.layers) {
-        createInfo.numLayers = options.layers;
-        createInfo.isArray = KTX_TRUE;
-    } else {
-        createInfo.numLayers = 1;
+    numFaces = options.cubemap ? 6 : 1;
+    numLayers = options.layers ? options.layers : 1;
+    baseDepth = options.depth ? options.depth : 1;
+
+    // The images are read once for all outputs.
+    bool anyBasis = options.etc1s || options.bopts.uastc;
+    bool anyAstc = options.astc;
+    bool allBlockCompressed = options.etc1s || options.bopts.uastc
+                              || options.astc;
+    for (const auto& output : extraOutputs) {
+        anyBasis = anyBasis || output.settings.etc1s
+                   || output.settings.bopts.uastc;
+        anyAstc = anyAstc || output.settings.astc;
+        allBlockCompressed = allBlockCompressed
+                             && output.settings.blockCompressed();
     }
+    // inputSwizzle is otherwise handled during BasisU and astc encoding.
+    bool imageSwizzled = options.inputSwizzle.size() > 0
+                         && !allBlockCompressed;
 
     faceSlice = layer = level = 0;
     std::vector<_tstring>::const_iterator it;
@@ -693,16 +768,15 @@ toktxApp::main(int argc, _TCHAR *argv[])
         Image* image;
         try {
             Image::rescale_e rescale = Image::eNoRescale;
-            if (options.etc1s || options.bopts.uastc)
+            if (anyBasis)
                 rescale = Image::rescale_e::eAlwaysRescaleTo8Bits;
-            else if (options.astc)
+            else if (anyAstc)
                 rescale = Image::rescale_e::eRescaleTo8BitsIfLess;
 
             image =
-              Image::CreateFromFile(infile,
-                                    options.assign_oetf == KHR_DF_TRANSFER_UNSPECIFIED,
-                                    rescale);
-
+              CreateFromFile(infile,
+                             options.assign_oetf == KHR_DF_TRANSFER_UNSPECIFIED,
+                             rescale);
             // If input is > 8bit and user wants LDR issue quality loss warning
             if (options.astc && image->getComponentSize() > 1
                 && options.astcopts.mode == KTX_PACK_ASTC_ENCODER_MODE_LDR) {
@@ -730,6 +804,16 @@ toktxApp::main(int argc, _TCHAR *argv[])
                 else
                     options.astcopts.mode = KTX_PACK_ASTC_ENCODER_MODE_HDR;
             }
+            for (auto& output : extraOutputs) {
+                ktxAstcParams& astcopts = output.settings.astcopts;
+                if (output.settings.astc
+                    && astcopts.mode == KTX_PACK_ASTC_ENCODER_MODE_DEFAULT) {
+                    if (image->getComponentSize() <= 1)
+                        astcopts.mode = KTX_PACK_ASTC_ENCODER_MODE_LDR;
+                    else
+                        astcopts.mode = KTX_PACK_ASTC_ENCODER_MODE_HDR;
+                }
+            }
 
             // Check that all input files have matching oetf, primaries and
             // component count. Raise error or warning depending on attribute
@@ -800,20 +884,6 @@ toktxApp::main(int argc, _TCHAR *argv[])
                 image->setOetf(options.assign_oetf);
             }
 
-            if (options.convert_oetf != KHR_DF_TRANSFER_UNSPECIFIED &&
-                options.convert_oetf != image->getOetf()) {
-                OETFFunc decode, encode;
-                if (image->getOetf() == KHR_DF_TRANSFER_SRGB)
-                    decode = decode_sRGB;
-                else
-                    decode = decode_linear;
-                if (options.convert_oetf == KHR_DF_TRANSFER_SRGB)
-                    encode = encode_sRGB;
-                else
-                    encode = encode_linear;
-                image->transformOETF(decode, encode);
-                image->setOetf(options.convert_oetf);
-            }
             if (options.assign_primaries != KHR_DF_PRIMARIES_MAX) {
                 image->setPrimaries(options.assign_primaries);
             }
@@ -822,130 +892,16 @@ toktxApp::main(int argc, _TCHAR *argv[])
                       << infile << ". " << e.what() << endl;
             exit(2);
         }
+        images.emplace_back(image);
 
         /* Sanity check. */
         assert(image->getWidth() * image->getHeight() * image->getPixelSize()
                   == image->getByteCount());
 
-        if (options.scale != 1.0f || options.resize) {
-            Image* scaledImage;
-            if (options.scale != 1.0f) {
-                scaledImage = image->createImage(
-                              (uint32_t)(image->getWidth() * options.scale),
-                              (uint32_t)(image->getHeight() * options.scale));
-
-            } else {
-                scaledImage = image->createImage(options.newGeom.width,
-                                                 options.newGeom.height);
-            }
-
-            try {
-                image->resample(*scaledImage,
-                                image->getOetf() == KHR_DF_TRANSFER_SRGB,
-                                options.gmopts.filter.c_str(),
-                                options.gmopts.filterScale,
-                                basisu::Resampler::Boundary_Op::BOUNDARY_CLAMP);
-            } catch (runtime_error& e) {
-                cerr << name << ": Image::resample() failed! "
-                          << e.what() << endl;
-                exitCode = 1;
-                goto cleanup;
-            }
-            scaledImage->setOetf(image->getOetf());
-            scaledImage->setColortype(image->getColortype());
-            scaledImage->setPrimaries(image->getPrimaries());
-            delete image;
-            image = scaledImage;
-        }
-
-        if (image->getHeight() > 1 && options.lower_left_maps_to_s0t0) {
-            image->yflip();
-        }
-
-        if (options.normalize) {
-            image->normalize();
-        }
-
-        if (options.targetType != commandOptions::eUnspecified) {
-            if (options.targetType != (int)image->getComponentCount()) {
-                Image* newImage = nullptr;
-                // The casts in the following copyTo* definitions only work
-                // because, thanks to the switch, at runtime we always pass
-                // the image type being cast to.
-                if (image->getComponentSize() == 2) {
-                    switch (options.targetType) {
-                      case commandOptions::eR:
-                        newImage = new r16image(image->getWidth(), image->getHeight());
-                        image->copyToR(*newImage);
-                        break;
-                      case commandOptions::eRG:
-                        newImage = new rg16image(image->getWidth(), image->getHeight());
-                        image->copyToRG(*newImage);
-                        break;
-                      case commandOptions::eRGB:
-                        newImage = new rgb16image(image->getWidth(), image->getHeight());
-                        image->copyToRGB(*newImage);
-                        break;
-                      case commandOptions::eRGBA:
-                        newImage = new rgba16image(image->getWidth(), image->getHeight());
-                        image->copyToRGBA(*newImage);
-                        break;
-                      case commandOptions::eUnspecified:
-                        assert(false);
-                    }
-                } else {
-                    switch (options.targetType) {
-                      case commandOptions::eR:
-                        newImage = new r8image(image->getWidth(), image->getHeight());
-                        image->copyToR(*newImage);
-                        break;
-                      case commandOptions::eRG:
-                        newImage = new rg8image(image->getWidth(), image->getHeight());
-                        image->copyToRG(*newImage);
-                        break;
-                      case commandOptions::eRGB:
-                        newImage = new rgb8image(image->getWidth(), image->getHeight());
-                        image->copyToRGB(*newImage);
-                        break;
-                      case commandOptions::eRGBA:
-                        newImage = new rgba8image(image->getWidth(), image->getHeight());
-                        image->copyToRGBA(*newImage);
-                        break;
-                      case commandOptions::eUnspecified:
-                        assert(false);
-                    }
-                }
-                if (newImage) {
-                     delete image;
-                     image = newImage;
-                } else {
-                    cerr << name << ": creation of image for new target type"
-                                    " failed. Out of memory." << endl;
-                    exitCode = 1;
-                    goto cleanup;
-                }
-            } else {
-                if (image->getColortype() < Image::colortype_e::eR) {
-                    // Color type is currently set to luminance. Override.
-                    assert(image->getComponentCount() < 3);
-                    if (options.targetType == commandOptions::eR)
-                        image->setColortype(Image::colortype_e::eR);
-                    else
-                        image->setColortype(Image::colortype_e::eRG);
-                }
-            }
-        }
-
-        if (options.inputSwizzle.size() > 0
-            // inputSwizzle is handled during BasisU and astc encoding
-            && !options.etc1s && !options.bopts.uastc && !options.astc) {
-            image->swizzle(options.inputSwizzle);
-        }
-
         if (i == 0) {
             // First file.
 
-            if (image->getColortype() < Image::colortype_e::eR) {  // Luminance type?
+            if (options.targetType == commandOptions::eUnspecified) {
                 if (image->getColortype() == Image::colortype_e::eLuminance) {
                     defaultSwizzle = "rrr1";
                 } else if (image->getColortype() == Image::colortype_e::eLuminanceAlpha) {
@@ -953,176 +909,61 @@ toktxApp::main(int argc, _TCHAR *argv[])
                 }
             }
 
-            bool srgb = (image->getOetf() == KHR_DF_TRANSFER_SRGB);
-            componentCount = image->getComponentCount();
-            switch (componentCount) {
-              case 1:
-                switch (image->getComponentSize()) {
-                  case 1:
-                    createInfo.glInternalformat
-                                    = srgb ? GL_SR8 : GL_R8;
-                    createInfo.vkFormat
-                                    = srgb ? VK_FORMAT_R8_SRGB
-                                           : VK_FORMAT_R8_UNORM;
-                    break;
-                  case 2:
-                    createInfo.glInternalformat = GL_R16;
-                    createInfo.vkFormat = VK_FORMAT_R16_UNORM;
-                    break;
-                  case 4:
-                    createInfo.glInternalformat = GL_R32F;
-                    createInfo.vkFormat = VK_FORMAT_R32_SFLOAT;
-                    break;
-                }
-                break;
-
-              case 2:
-                 switch (image->getComponentSize()) {
-                  case 1:
-                    createInfo.glInternalformat
-                                    = srgb ? GL_SRG8 : GL_RG8;
-                    createInfo.vkFormat
-                                    = srgb ? VK_FORMAT_R8G8_SRGB
-                                           : VK_FORMAT_R8G8_UNORM;
-                    break;
-                  case 2:
-                    createInfo.glInternalformat = GL_RG16;
-                    createInfo.vkFormat = VK_FORMAT_R16G16_UNORM;
-                    break;
-                  case 4:
-                    createInfo.glInternalformat = GL_RG32F;
-                    createInfo.vkFormat = VK_FORMAT_R32G32_SFLOAT;
-                    break;
-                }
-                break;
-
-              case 3:
-                 switch (image->getComponentSize()) {
-                  case 1:
-                    createInfo.glInternalformat
-                                    = srgb ? GL_SRGB8 : GL_RGB8;
-                    createInfo.vkFormat
-                                    = srgb ? VK_FORMAT_R8G8B8_SRGB
-                                           : VK_FORMAT_R8G8B8_UNORM;
-                    break;
-                  case 2:
-                    createInfo.glInternalformat = GL_RGB16;
-                    createInfo.vkFormat = VK_FORMAT_R16G16B16_UNORM;
-                    break;
-                  case 4:
-                    createInfo.glInternalformat = GL_RGB32F;
-                    createInfo.vkFormat = VK_FORMAT_R32G32B32_SFLOAT;
-                    break;
-                }
-                break;
-
-              case 4:
-                 switch (image->getComponentSize()) {
-                  case 1:
-                    createInfo.glInternalformat
-                                    = srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
-                    createInfo.vkFormat
-                                    = srgb ? VK_FORMAT_R8G8B8A8_SRGB
-                                           : VK_FORMAT_R8G8B8A8_UNORM;
-                    break;
-                  case 2:
-                    createInfo.glInternalformat = GL_RGBA16;
-                    createInfo.vkFormat = VK_FORMAT_R16G16B16A16_UNORM;
-                    break;
-                  case 4:
-                    createInfo.glInternalformat = GL_RGBA32F;
-                    createInfo.vkFormat = VK_FORMAT_R32G32B32A32_SFLOAT;
-                    break;
-                }
-                break;
-
-              default:
-                /* If we get here there's a bug. */
-                assert(0);
-            }
-            if (createInfo.vkFormat == VK_FORMAT_R8_SRGB
-                || createInfo.vkFormat == VK_FORMAT_R8G8_SRGB) {
-                warning("GPU support of sRGB variants of R & RG formats is"
-                        " limited.\nConsider using '--convert_oetf linear'"
-                        " to avoid these formats.");
-            }
-            createInfo.baseWidth = levelWidth = image->getWidth();
-            createInfo.baseHeight = levelHeight = image->getHeight();
-            createInfo.baseDepth = levelDepth = options.depth ? options.depth : 1;
-            if (options.depth > 0) {
-                // In this case, don't care about image->getHeight(). Images are
-                // always considered to be 2d. No need to set options.two_d.
-                createInfo.numDimensions = 3;
-            } else if (image->getHeight() == 1 && !options.two_d)
-                createInfo.numDimensions = 1;
-            else
-                createInfo.numDimensions = 2;
-            if (options.automipmap) {
-                createInfo.numLevels = 1;
-                createInfo.generateMipmaps = KTX_TRUE;
+            levelWidth = image->getWidth();
+            levelHeight = image->getHeight();
+            levelDepth = baseDepth;
+            if (options.scale != 1.0f) {
+                baseWidth = (uint32_t)(image->getWidth() * options.scale);
+                baseHeight = (uint32_t)(image->getHeight() * options.scale);
+            } else if (options.resize) {
+                baseWidth = options.newGeom.width;
+                baseHeight = options.newGeom.height;
             } else {
-                createInfo.generateMipmaps = KTX_FALSE;
-                if (options.mipmap || options.genmipmap) {
-                    // Calculate number of miplevels
-                    GLuint max_dim = image->getWidth() > image->getHeight() ?
-                                     image->getWidth() : image->getHeight();
-                    createInfo.numLevels = log2(max_dim) + 1;
-                    if (options.levels > 1) {
-                        if (options.levels > createInfo.numLevels) {
-                            cerr << name << "--levels value is greater than "
-                                 << "the maximum levels for the image size."
-                                 << endl;
-                            exitCode = 1;
-                            goto cleanup;
-                        }
-                        // Override the above.
-                        createInfo.numLevels = options.levels;
+                baseWidth = image->getWidth();
+                baseHeight = image->getHeight();
+            }
+            if (options.mipmap || options.genmipmap) {
+                // Calculate number of miplevels
+                GLuint max_dim = baseWidth > baseHeight ? baseWidth
+                                                        : baseHeight;
+                max_dim = maximum<GLuint>(max_dim, baseDepth);
+                numLevels = log2(max_dim) + 1;
+                if (options.levels > 1) {
+                    if (options.levels > numLevels) {
+                        cerr << name << "--levels value is greater than "
+                             << "the maximum levels for the image size."
+                             << endl;
+                        exitCode = 1;
+                        goto cleanup;
                     }
-                } else {
-                    createInfo.numLevels = 1;
-                }
-                // Figure out how many levels we'll read from files.
-                if (options.mipmap) {
-                    levelCount = createInfo.numLevels;
-                } else {
-                    levelCount = 1;
+                    // Override the above.
+                    numLevels = options.levels;
                 }
             }
+            // Figure out how many levels we'll read from files.
+            if (options.mipmap) {
+                levelCount = numLevels;
+            } else {
+                levelCount = 1;
+            }
             // Check we have enough files.
-            uint32_t requiredFileCount = imageCount(options.genmipmap ? 1 : levelCount,
-                                             createInfo.numLayers,
-                                             createInfo.numFaces,
-                                             createInfo.baseDepth);
+            uint32_t requiredFileCount = imageCount(levelCount, numLayers,
+                                                    numFaces, baseDepth);
             if (requiredFileCount > options.infiles.size()) {
                 cerr << name << ": too few files for " << levelCount
-                     << " levels, " << createInfo.numLayers
-                     << " layers and " << createInfo.numFaces
+                     << " levels, " << numLayers
+                     << " layers and " << numFaces
                      << " faces." << endl;
                 exitCode = 1;
                 goto cleanup;
             } else if (requiredFileCount < options.infiles.size()) {
                 cerr << name << ": too many files for " << levelCount
-                     << " levels, " << createInfo.numLayers
-                     << " layers and " << createInfo.numFaces
+                     << " levels, " << numLayers
+                     << " layers and " << numFaces
                      << " faces. Extras will be ignored." << endl;
                 options.infiles.erase(options.infiles.begin() + requiredFileCount,
                                           options.infiles.end());
             }
-            if (options.ktx2) {
-                ret = ktxTexture2_Create(&createInfo,
-                                         KTX_TEXTURE_CREATE_ALLOC_STORAGE,
-                                         (ktxTexture2**)&texture);
-            } else {
-                ret = ktxTexture1_Create(&createInfo,
-                                         KTX_TEXTURE_CREATE_ALLOC_STORAGE,
-                                         (ktxTexture1**)&texture);
-            }
-            if (KTX_SUCCESS != ret) {
-                fprintf(stderr, "%s failed to create ktxTexture; KTX error: %s\n",
-                        name.c_str(), ktxErrorString(ret));
-                exitCode = 2;
-                goto cleanup;
-            }
         } else {
             // Input file order is layer, faceSlice, level. This seems easier
             // for a human to manage than the order in a KTX file. It keeps the
@@ -1134,13 +975,13 @@ toktxApp::main(int argc, _TCHAR *argv[])
             if (level == levelCount) {
                 faceSlice++;
                 level = 0;
-                levelWidth = createInfo.baseWidth;
-                levelHeight = createInfo.baseHeight;
-                levelDepth = createInfo.baseDepth;
+                levelWidth = images[0]->getWidth();
+                levelHeight = images[0]->getHeight();
+                levelDepth = baseDepth;
                 if (faceSlice == (options.cubemap ? 6 : levelDepth)) {
                     faceSlice = 0;
                     layer++;
-                    if (layer == createInfo.numLayers) {
+                    if (layer == numLayers) {
                         // We're done.
                         break;
                     }
@@ -1156,73 +997,75 @@ toktxApp::main(int argc, _TCHAR *argv[])
             exitCode = 1;
             goto cleanup;
         }
-#if TRAVIS_DEBUG
-        if (options.etc1s) {
-            cout << "level = " << level << ", faceSlice = " << faceSlice;
-            cout << ", srcImg = " << hex  << (void *)srcImg << dec;
-            cout << ", imageSize = " << imageSize << endl;
-        }
-#endif
-        ret = ktxTexture_SetImageFromMemory(ktxTexture(texture),
-                                            level,
-                                            layer,
-                                            faceSlice,
-                                            *image,
-                                            image->getByteCount());
-        // Only an error in this program could lead to ret != SUCCESS
-        // hence no user message.
-        assert(ret == KTX_SUCCESS);
-
-        // This does not work for mipmaps for 3d textures. For those it is
-        // necessary to present the base images for each slice to a
-        // resampler that can sample across images.
-        if (options.genmipmap) {
-            for (uint32_t glevel = 1; glevel < createInfo.numLevels; glevel++)
-            {
-                Image *levelImage = image->createImage(
-                    maximum<uint32_t>(1, image->getWidth() >> glevel),
-                    maximum<uint32_t>(1, image->getHeight() >> glevel));
-                levelImage->setOetf(image->getOetf());
-                levelImage->setColortype(image->getColortype());
-                levelImage->setPrimaries(image->getPrimaries());
-                try {
-                    image->resample(*levelImage,
-                                    image->getOetf() == KHR_DF_TRANSFER_SRGB,
-                                    options.gmopts.filter.c_str(),
-                                    options.gmopts.filterScale,
-                                    options.gmopts.wrapMode);
-                } catch (runtime_error& e) {
-                    cerr << name << ": Image::resample() failed! "
-                              << e.what() << endl;
-                    exitCode = 1;
-                    goto cleanup;
-                }
 
-                if (options.normalize)
-                    levelImage->normalize();
+        sourceImages.push_back({ (ktx_uint8_t*)*image, image->getWidth(),
+                                 image->getHeight(),
+                                 image->getComponentCount(),
+                                 image->getComponentSize(),
+                                 image->getOetf(), image->getPrimaries(),
+                                 level, layer, faceSlice });
+    }
 
-                ret = ktxTexture_SetImageFromMemory(ktxTexture(texture),
-                                              glevel,
-                                              layer,
-                                              faceSlice,
-                                              *levelImage,
-                                              levelImage->getByteCount());
-                assert(ret == KTX_SUCCESS);
-                delete levelImage;
-            }
-        }
+    // Resizing, OETF conversion, flipping, normalization, component count
+    // change, swizzling and mipmap generation are done by the library.
+    memset(&params, 0, sizeof(params));
+    params.structSize = sizeof(params);
+    params.threadCount = options.threadCount;
+    params.numLevels = numLevels;
+    params.numLayers = numLayers;
+    params.isArray = options.layers ? KTX_TRUE : KTX_FALSE;
+    params.cubemap = options.cubemap;
+    params.baseDepth = options.depth;
+    params.generateMipmaps = options.genmipmap;
+    if (options.scale != 1.0f || options.resize) {
+        params.resizeWidth = baseWidth;
+        params.resizeHeight = baseHeight;
+    }
+    params.convertOetf = options.convert_oetf;
+    params.targetComponentCount = options.targetType;
+    if (imageSwizzled)
+        memcpy(params.inputSwizzle, options.inputSwizzle.data(), 4);
+    params.lowerLeftMapsToS0T0 = options.lower_left_maps_to_s0t0;
+    params.normalize = options.normalize;
+    params.mipFilter = options.gmopts.filter.c_str();
+    params.mipFilterScale = options.gmopts.filterScale;
+    params.mipWrapMode = imageWrapMode(options.gmopts.wrapMode);
+
+    ret = ktxTexture2_CreateFromImages(sourceImages.data(),
+                                       (ktx_uint32_t)sourceImages.size(),
+                                       &params, &texture2);
+    images.clear();
+    if (KTX_SUCCESS != ret) {
+        fprintf(stderr, "%s failed to create ktxTexture; KTX error: %s\n",
+                name.c_str(), ktxErrorString(ret));
+        exitCode = 2;
+        goto cleanup;
+    }
+    if (texture2->vkFormat == VK_FORMAT_R8_SRGB
+        || texture2->vkFormat == VK_FORMAT_R8G8_SRGB) {
+        warning("GPU support of sRGB variants of R & RG formats is"
+                " limited.\nConsider using '--convert_oetf linear'"
+                " to avoid these formats.");
+    }
+    if (texture2->numDimensions == 1 && options.two_d)
+        texture2->numDimensions = 2;
+    if (options.automipmap)
+        texture2->generateMipmaps = KTX_TRUE;
+    // The KTXorientation added by the library does not account for --2d
+    // and KTX v1 files use a different format so replace it.
+    ktxHashList_DeleteKVPair(&texture2->kvDataHead, KTX_ORIENTATION_KEY);
 
-#if IMAGE_DEBUG
-        {
-            ktx_size_t offset;
-            ktxTexture_GetImageOffset(texture, level, 0, faceSlice, &offset);
-            dumpImage(infile, image->getWidth(), image->getHeight(),
-                      image->getComponentCount(), image->getComponentSize(),
-                      texture.pData + offset);
+    if (options.ktx2) {
+        texture = ktxTexture(texture2);
+        texture2 = nullptr;
+    } else {
+        ret = createKtx1Copy(texture2, (ktxTexture1**)&texture);
+        if (KTX_SUCCESS != ret) {
+            fprintf(stderr, "%s failed to create ktxTexture; KTX error: %s\n",
+                    name.c_str(), ktxErrorString(ret));
+            exitCode = 2;
+            goto cleanup;
         }
-#endif
-
-        delete image;
     }
 
     /*
@@ -1233,9 +1076,9 @@ toktxApp::main(int argc, _TCHAR *argv[])
         char orientation[20];
         if (options.ktx2) {
             orientation[0] = 'r';
-            if (createInfo.numDimensions > 1) {
+            if (texture->numDimensions > 1) {
                 orientation[1] = options.lower_left_maps_to_s0t0 ? 'u' : 'd';
-                if (createInfo.numDimensions > 2) {
+                if (texture->numDimensions > 2) {
                     orientation[2] = options.lower_left_maps_to_s0t0
                                    ? 'o'  : 'i';
                     orientation[3] = 0;
@@ -1247,10 +1090,10 @@ toktxApp::main(int argc, _TCHAR *argv[])
             }
         } else {
             assert(strlen(KTX_ORIENTATION3_FMT) < sizeof(orientation));
-            if (createInfo.numDimensions == 1) {
+            if (texture->numDimensions == 1) {
                 snprintf(orientation, sizeof(orientation), KTX_ORIENTATION1_FMT,
                          'r');
-            } else if (createInfo.numDimensions == 2) {
+            } else if (texture->numDimensions == 2) {
                 snprintf(orientation, sizeof(orientation), KTX_ORIENTATION2_FMT,
                          'r', options.lower_left_maps_to_s0t0 ? 'u' : 'd');
             } else
@@ -1269,13 +1112,125 @@ toktxApp::main(int argc, _TCHAR *argv[])
         ktxHashList_AddKVPair(&texture->kvDataHead, KTX_WRITER_KEY,
                               (ktx_uint32_t)writer.str().length() + 1,
                               writer.str().c_str());
+    }
+
+    exitCode = writeOutputs(texture, defaultSwizzle, imageSwizzled);
+
+cleanup:
+    if (texture2) ktxTexture_Destroy(ktxTexture(texture2));
+    if (texture) ktxTexture_Destroy(ktxTexture(texture));
+    return exitCode;
+}
+
+/*
+ * @brief Create a KTX v1 texture holding the same images as @p texture2.
+ *
+ * ktxTexture2_CreateFromImages only makes KTX2 textures. Metadata is not
+ * copied.
+ *
+ * @return KTX_SUCCESS on success, other KTX_* enum values on error.
+ *
+ * @param[in]  texture2 the texture to copy.
+ * @param[out] texture1 pointer to a location in which to store the address
+ *                      of the new texture.
+ */
+static KTX_error_code
+createKtx1Copy(ktxTexture2* texture2, ktxTexture1** texture1)
+{
+    ktxTextureCreateInfo createInfo;
+    KTX_error_code ret;
 
+    memset(&createInfo, 0, sizeof(createInfo));
+    switch (texture2->vkFormat) {
+      case VK_FORMAT_R8_UNORM: createInfo.glInternalformat = GL_R8; break;
+      case VK_FORMAT_R8_SRGB: createInfo.glInternalformat = GL_SR8; break;
+      case VK_FORMAT_R8G8_UNORM: createInfo.glInternalformat = GL_RG8; break;
+      case VK_FORMAT_R8G8_SRGB: createInfo.glInternalformat = GL_SRG8; break;
+      case VK_FORMAT_R8G8B8_UNORM: createInfo.glInternalformat = GL_RGB8; break;
+      case VK_FORMAT_R8G8B8_SRGB: createInfo.glInternalformat = GL_SRGB8; break;
+      case VK_FORMAT_R8G8B8A8_UNORM:
+        createInfo.glInternalformat = GL_RGBA8;
+        break;
+      case VK_FORMAT_R8G8B8A8_SRGB:
+        createInfo.glInternalformat = GL_SRGB8_ALPHA8;
+        break;
+      case VK_FORMAT_R16_UNORM: createInfo.glInternalformat = GL_R16; break;
+      case VK_FORMAT_R16G16_UNORM: createInfo.glInternalformat = GL_RG16; break;
+      case VK_FORMAT_R16G16B16_UNORM:
+        createInfo.glInternalformat = GL_RGB16;
+        break;
+      case VK_FORMAT_R16G16B16A16_UNORM:
+        createInfo.glInternalformat = GL_RGBA16;
+        break;
+      default:
+        /* If we get here there's a bug. */
+        assert(0);
+    }
+    createInfo.vkFormat = texture2->vkFormat;
+    createInfo.baseWidth = texture2->baseWidth;
+    createInfo.baseHeight = texture2->baseHeight;
+    createInfo.baseDepth = texture2->baseDepth;
+    createInfo.numDimensions = texture2->numDimensions;
+    createInfo.numLevels = texture2->numLevels;
+    createInfo.numLayers = texture2->numLayers;
+    createInfo.numFaces = texture2->numFaces;
+    createInfo.isArray = texture2->isArray;
+    createInfo.generateMipmaps = texture2->generateMipmaps;
+    ret = ktxTexture1_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE,
+                             texture1);
+    if (KTX_SUCCESS != ret)
+        return ret;
+
+    for (uint32_t level = 0; level < texture2->numLevels; level++) {
+        ktx_size_t imageSize = ktxTexture_GetImageSize(ktxTexture(texture2),
+                                                       level);
+        uint32_t numFaceSlices = texture2->isCubemap ? texture2->numFaces
+                   : maximum<uint32_t>(1, texture2->baseDepth >> level);
+        for (uint32_t layer = 0; layer < texture2->numLayers; layer++) {
+            for (uint32_t faceSlice = 0; faceSlice < numFaceSlices;
+                 faceSlice++) {
+                ktx_size_t offset;
+                ktxTexture_GetImageOffset(ktxTexture(texture2), level, layer,
+                                          faceSlice, &offset);
+                // Rows are padded to 4 bytes as they are copied.
+                ret = ktxTexture_SetImageFromMemory(ktxTexture(*texture1),
+                                                    level, layer, faceSlice,
+                                                    texture2->pData + offset,
+                                                    imageSize);
+                // Only an error in this program could lead to
+                // ret != SUCCESS.
+                assert(ret == KTX_SUCCESS);
+            }
+        }
+    }
+    return KTX_SUCCESS;
+}
+
+/*
+ * @brief Encode a texture according to @p settings and write it to a file.
+ *
+ * @return 0 on success, an exit code on error.
+ *
+ * @param[in] texture        the texture to write. It is encoded in place.
+ * @param[in] outfile        name of the file to write. "-" means stdout.
+ * @param[in] settings       the encoding to use.
+ * @param[in] defaultSwizzle swizzle implied by the input images' color type.
+ * @param[in] imageSwizzled  true if --input_swizzle was applied to the images.
+ */
+int
+toktxApp::writeOutput(ktxTexture* texture, const _tstring& outfile,
+                      encodeSettings& settings, const string& defaultSwizzle,
+                      bool imageSwizzled)
+{
+    KTX_error_code ret;
+    int exitCode = 0;
+
+    if (options.ktx2) {
         string swizzle;
         // Add Swizzle metadata
         if (options.swizzle.size()) {
             swizzle = options.swizzle;
-        } else if (!options.etc1s && !options.bopts.uastc && !options.astc
-                   && defaultSwizzle.size()) {
+        } else if (!settings.blockCompressed() && defaultSwizzle.size()) {
             swizzle = defaultSwizzle;
         }
         if (swizzle.size()) {
@@ -1284,57 +1239,185 @@ toktxApp::main(int argc, _TCHAR *argv[])
                                   // +1 is for the NUL on the c_str
                                   swizzle.c_str());
         }
-
-        if (options.ktx2 && expectedAttribs.primaries != KHR_DF_PRIMARIES_BT709) {
-            KHR_DFDSETVAL(((ktxTexture2*)texture)->pDfd + 1, PRIMARIES,
-                          expectedAttribs.primaries);
-        }
     }
 
     FILE* f;
-    if (options.outfile.compare("-") == 0) {
+    if (outfile.compare("-") == 0) {
         f = stdout;
 #if defined(_WIN32)
         /* Set "stdout" to have binary mode */
         (void)_setmode( _fileno( stdout ), _O_BINARY );
 #endif
     } else
-        f = _tfopen(options.outfile.c_str(), "wb");
+        f = _tfopen(outfile.c_str(), "wb");
 
     if (f) {
-        if (options.astc || options.etc1s || options.bopts.uastc || options.zcmp) {
-            string& swizzle = options.inputSwizzle.size() == 0 && defaultSwizzle.size() && !options.normalMode
-                            ? defaultSwizzle
-                            : options.inputSwizzle;
+        if (settings.blockCompressed() || settings.zcmp) {
+            string swizzle;
+            if (!imageSwizzled) {
+                swizzle = options.inputSwizzle.size() == 0
+                          && defaultSwizzle.size() && !settings.normalMode
+                        ? defaultSwizzle
+                        : options.inputSwizzle;
+            }
             exitCode = encode((ktxTexture2*)texture, swizzle,
-                               f == stdout ? "stdout" : options.outfile);
+                              f == stdout ? "stdout" : outfile, settings);
             if (exitCode)
                 goto closefileandcleanup;
         }
-        ret = ktxTexture_WriteToStdioStream(ktxTexture(texture), f);
+        ret = ktxTexture_WriteToStdioStream(texture, f);
         if (KTX_SUCCESS != ret) {
             cerr << name << ": "
-                 << "%s failed to write KTX file \"" << options.outfile
+                 << "%s failed to write KTX file \"" << outfile
                  << "\"; KTX error: " << ktxErrorString(ret) << endl;
             exitCode = 2;
         }
 closefileandcleanup:
         fclose(f);
         if (exitCode && (f != stdout)) {
-            _tunlink(options.outfile.c_str());
+            _tunlink(outfile.c_str());
         }
     } else {
         cerr << name << ": "
-             << "could not open output file \"" << options.outfile
+             << "could not open output file \"" << outfile
              << "\". " << strerror(errno) << endl;
         exitCode = 2;
     }
+    return exitCode;
+}
 
-cleanup:
-    if (texture) ktxTexture_Destroy(ktxTexture(texture));
+/*
+ * @brief Write @p texture to the output file and any --output files.
+ *
+ * Each additional output is encoded from its own copy of the texture. The
+ * outputs are encoded concurrently with the threads divided between them.
+ *
+ * @return 0 on success, the exit code of the first failed output on error.
+ */
+int
+toktxApp::writeOutputs(ktxTexture* texture, const string& defaultSwizzle,
+                       bool imageSwizzled)
+{
+    struct outputJob {
+        _tstring outfile;
+        encodeSettings settings;
+        ktxTexture* texture;
+        int exitCode;
+    };
+    std::vector<outputJob> jobs;
+    int exitCode = 0;
+
+    jobs.push_back({ options.outfile, getEncodeSettings(), texture, 0 });
+    for (auto& output : extraOutputs) {
+        ktxTexture2* copy;
+        KTX_error_code ret = ktxTexture2_CreateCopy((ktxTexture2*)texture,
+                                                    &copy);
+        if (KTX_SUCCESS != ret) {
+            cerr << name << ": failed to copy texture for \""
+                 << output.outfile << "\"; KTX error: "
+                 << ktxErrorString(ret) << endl;
+            exitCode = 2;
+            break;
+        }
+        jobs.push_back({ output.outfile, output.settings, ktxTexture(copy),
+                         0 });
+    }
+
+    if (exitCode == 0) {
+        ktx_uint32_t jobThreads = std::max(1U, options.threadCount
+                                                / (ktx_uint32_t)jobs.size());
+        if (jobs.size() > 1) {
+            for (auto& job : jobs) {
+                job.settings.threadCount = jobThreads;
+                job.settings.bopts.threadCount = jobThreads;
+                job.settings.astcopts.threadCount = jobThreads;
+            }
+        }
+        auto runJob = [&](outputJob* job) {
+            job->exitCode = writeOutput(job->texture, job->outfile,
+                                        job->settings, defaultSwizzle,
+                                        imageSwizzled);
+        };
+        std::vector<std::thread> threads;
+        size_t next;
+        for (next = 1; next < jobs.size(); next++) {
+            try {
+                threads.emplace_back(runJob, &jobs[next]);
+            } catch (std::system_error&) {
+                // Encode the rest on this thread.
+                break;
+            }
+        }
+        runJob(&jobs[0]);
+        for (; next < jobs.size(); next++)
+            runJob(&jobs[next]);
+        for (auto& thread : threads)
+            thread.join();
+        for (auto& job : jobs) {
+            if (job.exitCode && !exitCode)
+                exitCode = job.exitCode;
+        }
+    }
+
+    // The first job's texture belongs to the caller.
+    for (size_t i = 1; i < jobs.size(); i++)
+        ktxTexture_Destroy(jobs[i].texture);
     return exitCode;
 }
 
+/*
+ * @brief Parse the encoding options given with each --output.
+ */
+void
+toktxApp::processOutputOptions()
+{
+    if (options.outputs.empty())
+        return;
+
+    encodeSettings mainSettings = getEncodeSettings();
+    // Options with a flag, e.g. --genmipmap, are set by the parser without
+    // calling processOption so leave them out to have them rejected.
+    std::vector<argparser::option> fullOptionList = option_list;
+    option_list.erase(std::remove_if(option_list.begin(), option_list.end(),
+                                     [](const argparser::option& o) {
+                                         return o.flag != nullptr;
+                                     }),
+                      option_list.end());
+    parsingOutput = true;
+    for (const auto& spec : options.outputs) {
+        istringstream iss(spec);
+        argvector arglist;
+        for (_tstring w; iss >> w; )
+            arglist.push_back(w);
+        if (arglist.empty() || arglist[0][0] == _T('-')) {
+            error("--output requires a file name.");
+            usage();
+            exit(1);
+        }
+
+        outputSpec output;
+        output.outfile = arglist[0];
+        if (output.outfile.find_last_of('.') == _tstring::npos)
+            output.outfile.append(_T(".ktx2"));
+
+        setEncodeSettings(mainSettings);
+        resetEncodeSettings();
+        argparser optparser(arglist, 1);
+        processOptions(optparser);
+        if (optparser.optind != arglist.size()) {
+            error("only options may follow the file name in --output.");
+            usage();
+            exit(1);
+        }
+        scApp::validateOptions();
+        output.settings = getEncodeSettings();
+        extraOutputs.push_back(output);
+    }
+    parsingOutput = false;
+    option_list = fullOptionList;
+    setEncodeSettings(mainSettings);
+}
+
 
 void
 toktxApp::validateOptions()
@@ -1377,10 +1460,9 @@ toktxApp::validateOptions()
         usage();
         exit(1);
     }
-
-    if (options.depth > 1 && options.genmipmap) {
-        error("generation of mipmaps for 3d textures is not supported.\n"
-              "A PR to add this feature will be gratefully accepted!");
+    if (options.scale != 1.0 && options.mipmap) {
+        error("only one of --scale and --mipmap can be specified.");
+        usage();
         exit(1);
     }
 
@@ -1395,6 +1477,8 @@ toktxApp::validateOptions()
         error("too few input files.");
         exit(1);
     }
+
+    processOutputOptions();
     /* Whether there are enough input files for all the mipmap levels in
      * a full pyramid can only be checked when the first file has been
      * read and the size determined.
@@ -1441,6 +1525,16 @@ toktxApp::processOption(argparser& parser, int opt)
     // N.B. It is not possible for an optarg string to be a negative number
     // because the leading '-' will make the parser think it is an option
     // leading to a "missing required argument" error before this is ever called.
+    if (parsingOutput) {
+        // Options that change the images are shared by all outputs.
+        if (opt == 1100 || opt == 1017
+            || !scApp::processOption(parser, opt)) {
+            error("only encoding options may be given with --output.");
+            usage();
+            exit(1);
+        }
+        return true;
+    }
     switch (opt) {
       case 0:
         break;
@@ -1564,6 +1658,10 @@ toktxApp::processOption(argparser& parser, int opt)
         if (parser.optarg.compare("srgb") == 0)
             options.assign_primaries = KHR_DF_PRIMARIES_SRGB;
         break;
+      case 1106:
+        options.outputs.push_back(parser.optarg);
+        options.ktx2 = 1;
+        break;
       case ':':
       default:
         return scApp::processOption(parser, opt);
@@ -0,0 +1,293 @@
+// -*- tab-width: 4; -*-
+// vi: set sw=2 ts=4 sts=4 expandtab:
+
+// Copyright 2019-2020 The Khronos Group Inc.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "ktxapp.h"
+
+#include <zstd.h>
+
+#if defined(_MSC_VER)
+  #define fileno _fileno
+  #define isatty _isatty
+#endif
+
+/*
+// Options shared by the tools that convert other file formats to KTX2.
+//! [convApp options]
+  <dl>
+  <dt>-o outfile, --output=outfile</dt>
+  <dd>Name the output file @e outfile. If @e outfile is 'stdout', output will
+      be written to stdout. If there is more than 1 input file, the command
+      prints its usage message and exits.</dd>
+  <dt>-f, --force</dt>
+  <dd>If the destination file already exists, remove it and create a
+      new file, without prompting for confirmation regardless of its
+      permissions.</dd>
+  <dt>--zcmp [&lt;compressionLevel&gt;]</dt>
+  <dd>Supercompress the output with Zstandard. The optional
+      compressionLevel range is 1 - 22 and the default is 3. Lower
+      values=faster but give less compression.</dd>
+  <dt>--threads &lt;count&gt;</dt>
+  <dd>Explicitly set the number of files to convert in parallel. By
+      default, the number of threads reported by
+      thread::hardware_concurrency or 1 if value returned is 0 is
+      used.</dd>
+  </dl>
+//! [convApp options]
+*/
+
+/*
+ * Base for the tools that convert each of their input files to a KTX2
+ * file of the same name, in parallel. Derived classes create the texture
+ * from the contents of an input file.
+ */
+class convApp : public ktxApp {
+  public:
+    virtual int main(int argc, _TCHAR* argv[]) {
+        processCommandLine(argc, argv);
+        validateOptions();
+
+        // Each file is converted independently so convert them in parallel.
+        // No new files are started after a failure.
+        return processFiles(options.threadCount, true,
+                            [this](const _tstring& infile, std::ostream& err) {
+                                return convertFile(infile, err);
+                            });
+    }
+
+    virtual void usage() {
+        cerr <<
+          "  -o outfile, --output=outfile\n"
+          "               Name the output file outfile. If @e outfile is 'stdout', output\n"
+          "               will be written to stdout. If there is more than 1 infile,\n"
+          "               the command prints its usage message and exits.\n"
+          "  -f, --force  If the output file already exists, remove it and create a\n"
+          "               new file, without prompting for confirmation regardless of\n"
+          "               its permissions.\n"
+          "  --zcmp [<compressionLevel>]\n"
+          "               Supercompress the output with Zstandard. The optional\n"
+          "               compressionLevel range is 1 - 22 and the default is 3. Lower\n"
+          "               values=faster but give less compression.\n"
+          "  --threads <count>\n"
+          "               Explicitly set the number of files to convert in parallel.\n"
+          "               By default, the number of threads reported by\n"
+          "               thread::hardware_concurrency or 1 if value returned is 0 is\n"
+          "               used.\n";
+        ktxApp::usage();
+    }
+
+  protected:
+    struct commandOptions : public ktxApp::commandOptions {
+        bool         useStdout;
+        bool         force;
+        bool         zcmp;
+        clamped<ktx_uint32_t> zcmpLevel;
+        clamped<ktx_uint32_t> threadCount;
+
+        commandOptions() :
+            zcmpLevel(ZSTD_CLEVEL_DEFAULT, 1U, 22U),
+            threadCount(std::max(1U, std::thread::hardware_concurrency()),
+                        1U, 10000U)
+        {
+            useStdout = false;
+            force = false;
+            zcmp = false;
+        }
+    };
+
+    convApp(std::string& version, std::string& defaultVersion,
+            commandOptions& options)
+        : ktxApp(version, defaultVersion, options), options(options)
+    {
+        argparser::option my_option_list[] = {
+            { "force", argparser::option::no_argument, NULL, 'f' },
+            { "outfile", argparser::option::required_argument, NULL, 'o' },
+            { "zcmp", argparser::option::optional_argument, NULL, 'z' },
+            { "threads", argparser::option::required_argument, NULL, 't' },
+        };
+        const int lastOptionIndex = sizeof(my_option_list)
+                                    / sizeof(argparser::option);
+        option_list.insert(option_list.begin(), my_option_list,
+                           my_option_list + lastOptionIndex);
+        short_opts += "fo:t:z;";
+    }
+
+    /*
+     * @brief Create the texture to write from the contents, @p data, of
+     *        @p infile.
+     *
+     * Messages are written to @p err. On success @p texture must be a
+     * KTX2 texture, or a KTX v1 texture if writeTexture is overridden to
+     * handle it, with the writer metadata and any supercompression
+     * requested by the options applied.
+     *
+     * @return   the exit code for the file.
+     */
+    virtual int createTexture(const _tstring& infile,
+                              const std::vector<ktx_uint8_t>& data,
+                              ktxTexture** texture, std::ostream& err) = 0;
+
+    virtual KTX_error_code writeTexture(ktxTexture* texture, FILE* outf) {
+        return ktxTexture_WriteToStdioStream(texture, outf);
+    }
+
+    /*
+     * @brief Add the required writer metadata to @p texture.
+     */
+    void addWriterMetadata(ktxTexture* texture) {
+        std::stringstream writer;
+        writeId(writer, options.test != 0);
+        ktxHashList_AddKVPair(&texture->kvDataHead, KTX_WRITER_KEY,
+                              (ktx_uint32_t)writer.str().length() + 1,
+                              writer.str().c_str());
+    }
+
+    /*
+     * @brief Convert a single file.
+     *
+     * Messages are written to @p err so the caller can keep those of files
+     * converted in parallel apart.
+     *
+     * @return   the exit code for the file.
+     */
+    int convertFile(const _tstring& infile, std::ostream& err) {
+        FILE* outf = nullptr;
+        KTX_error_code result;
+        ktxTexture* texture = nullptr;
+        _tstring outfile;
+        std::vector<ktx_uint8_t> data;
+
+        if (!readFile(infile, data)) {
+            err << name
+                << " could not open input file \""
+                << (infile.compare(_T("-")) ? infile : "stdin") << "\". "
+                << strerror(errno) << endl;
+            return 2;
+        }
+
+        int exitCode = createTexture(infile, data, &texture, err);
+        if (exitCode != 0)
+            return exitCode;
+        data = std::vector<ktx_uint8_t>(); // Release the file data.
+
+        if (infile.compare(_T("-"))
+            && !options.useStdout && !options.outfile.length())
+        {
+            size_t dot;
+
+            outfile = infile;
+            dot = outfile.find_last_of(_T('.'));
+            if (dot != _tstring::npos) {
+                outfile.erase(dot, _tstring::npos);
+            }
+            outfile += _T(".ktx2");
+        } else if (options.outfile.length()) {
+            outfile = options.outfile;
+        }
+
+        if (options.useStdout || !outfile.length()) {
+            // Only stdin input with no -o leaves outfile empty.
+            outf = stdout;
+#if defined(_WIN32)
+            /* Set "stdout" to have binary mode */
+            (void)_setmode( _fileno( stdout ), _O_BINARY );
+#endif
+        } else {
+            outf = fopen_write_if_not_exists(outfile);
+        }
+
+        if (!outf && errno == EEXIST) {
+            bool force = options.force;
+            if (!force) {
+                std::lock_guard<std::mutex> lock(consoleMutex);
+                if (isatty(fileno(stdin))) {
+                    char answer;
+                    cout << "Output file " << outfile
+                         << " exists. Overwrite? [Y or n] ";
+                    cin >> answer;
+                    if (answer == 'Y') {
+                        force = true;
+                    }
+                }
+            }
+            if (force) {
+                outf = _tfopen(outfile.c_str(), "wb");
+            }
+        }
+
+        if (!outf) {
+            err << name
+                << " could not open output file \""
+                << (outfile.length() ? outfile.c_str() : "stdout")
+                << "\". " << strerror(errno) << endl;
+            ktxTexture_Destroy(texture);
+            return 2;
+        }
+
+        result = writeTexture(texture, outf);
+        ktxTexture_Destroy(texture);
+        if (outf != stdout)
+            (void)fclose(outf);
+        if (result != KTX_SUCCESS) {
+            err << name
+                << " failed to write KTX2 file; "
+                << ktxErrorString(result) << endl;
+            if (outf != stdout)
+                (void)_tunlink(outfile.c_str());
+            return 2;
+        }
+        return 0;
+    }
+
+    virtual void validateOptions() {
+        if (options.infiles.size() > 1 && options.outfile.length()) {
+            cerr << "Can't use -o when there are multiple infiles." << endl;
+            usage();
+            exit(1);
+        }
+    }
+
+    /*
+     * @brief process a command line option
+     *
+     * @return   true if option processed, false otherwise.
+     *
+     * @param[in]     parser,     an @c argparser holding the options to
+     *                            process.
+     * @param[in]     opt         the option to process.
+     */
+    virtual bool processOption(argparser& parser, int opt) {
+        switch (opt) {
+          case 'f':
+            options.force = true;
+            break;
+          case 'z':
+            options.zcmp = true;
+            if (parser.optarg.size() > 0)
+                options.zcmpLevel = strtoi(parser.optarg.c_str());
+            break;
+          case 't':
+            options.threadCount = strtoi(parser.optarg.c_str());
+            break;
+          case 'o':
+            options.outfile = parser.optarg;
+            if (!options.outfile.compare(_T("stdout"))) {
+                options.useStdout = true;
+            } else {
+                size_t dot;
+                dot = options.outfile.find_last_of('.');
+                if (dot == _tstring::npos) {
+                    options.outfile += _T(".ktx2");
+                }
+            }
+            break;
+          default:
+            return false;
+        }
+        return true;
+    }
+
+    commandOptions& options;
+};
@@ -7,11 +7,15 @@
 #include "stdafx.h"
 
 #include <stdarg.h>
-#if (_MSVC_LANG >= 201703L || __cplusplus >= 201703L)
-#include <algorithm>
-#endif
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <sstream>
+#include <system_error>
+#include <thread>
 #include <vector>
 #include <ktx.h>
 
@@ -146,6 +150,88 @@ class ktxApp {
         return file;
     }
 
+    /** @internal
+     * @~English
+     * @brief Read a file, or stdin if @p infile is "-", into memory.
+     *
+     * @return true on success, false with errno set otherwise.
+     */
+    static bool readFile(const _tstring& infile,
+                         std::vector<ktx_uint8_t>& data) {
+        FILE* inf;
+
+        if (infile.compare(_T("-")) == 0) {
+            inf = stdin;
+#if defined(_WIN32)
+            /* Set "stdin" to have binary mode */
+            (void)_setmode( _fileno( stdin ), _O_BINARY );
+#endif
+        } else {
+            inf = _tfopen(infile.c_str(), "rb");
+        }
+        if (!inf)
+            return false;
+
+        ktx_uint8_t buf[65536];
+        size_t count;
+        while ((count = fread(buf, 1, sizeof(buf), inf)) > 0)
+            data.insert(data.end(), buf, buf + count);
+        bool ok = !ferror(inf);
+        if (inf != stdin)
+            (void)fclose(inf);
+        return ok;
+    }
+
+    /** @internal
+     * @~English
+     * @brief Call @p processFile for each of the infiles, using up to
+     *        @p threadCount threads.
+     *
+     * @p processFile writes its messages to the stream it is given. They
+     * are written to stderr, under consoleMutex, when it returns so those
+     * of files processed in parallel are kept apart. If @p stopOnError is
+     * set no new files are started after one fails.
+     *
+     * @return the first non-zero exit code returned by @p processFile or 0.
+     */
+    int processFiles(size_t threadCount, bool stopOnError,
+                     const std::function<int(const _tstring&,
+                                             std::ostream&)>& processFile) {
+        std::atomic<size_t> nextFile(0);
+        std::atomic<int> exitCode(0);
+        auto worker = [&]() {
+            size_t i;
+            while ((!stopOnError || exitCode == 0)
+                   && (i = nextFile++) < options.infiles.size()) {
+                std::stringstream err;
+                int fileExitCode = processFile(options.infiles[i], err);
+                {
+                    std::lock_guard<std::mutex> lock(consoleMutex);
+                    cerr << err.str();
+                }
+                if (fileExitCode != 0) {
+                    int noError = 0;
+                    exitCode.compare_exchange_strong(noError, fileExitCode);
+                }
+            }
+        };
+
+        threadCount = std::min(threadCount, options.infiles.size());
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < threadCount; t++) {
+            try {
+                threads.emplace_back(worker);
+            } catch (const std::system_error&) {
+                break; // Carry on with the threads we have.
+            }
+        }
+        worker();
+        for (auto& thread : threads)
+            thread.join();
+
+        return exitCode;
+    }
+
     int strtoi(const char* str)
     {
         char* endptr;
@@ -348,6 +434,10 @@ class ktxApp {
 
     commandOptions& options;
 
+    // Serializes the messages, and any prompts, of files processed in
+    // parallel by processFiles.
+    std::mutex consoleMutex;
+
     virtual void validateOptions() { }
 
     std::vector<argparser::option> option_list {
@@ -370,6 +370,19 @@ astcEncoderMode(const char* mode) {
                  is 3. Lower values=faster but give less compression. Values
                  above 20 should be used with caution as they require more
                  memory.</dd>
+    <dt>--zfilter &lt;none | shuffle_delta | block_split&gt;</dt>
+                 <dd>Apply a reversible filter to the data before
+                 supercompressing it with @b --zcmp. @b shuffle_delta splits
+                 the bytes of each row into planes and delta codes them. It
+                 can greatly improve compression of uncompressed formats with
+                 16- or 32-bit components, such as height fields and float
+                 images, but is not valid for block-compressed formats.
+                 @b block_split splits the bytes of each row of blocks into
+                 planes, separating fields such as endpoints and indices. It
+                 is only valid for block-compressed formats, e.g. BCn, ETC or
+                 ASTC. The filter is recorded as a libktx vendor
+                 supercompression scheme so the output can only be read by
+                 libktx. Default is @b none.</dd>
     <dt>--threads &lt;count&gt;</dt>
                  <dd>Explicitly set the number of threads to use during
                  compression. By default, ETC1S / BasisLZ and ASTC compression
@@ -511,6 +524,7 @@ class scApp : public ktxApp {
         int          astc;
         ktx_bool_t   normalMode;
         ktx_bool_t   normalize;
+        ktx_zstd_filter_e zfilter;
         clamped<ktx_uint32_t> zcmpLevel;
         clamped<ktx_uint32_t> threadCount;
         string inputSwizzle;
@@ -524,6 +538,7 @@ class scApp : public ktxApp {
             ktx2 = false;
             etc1s = false;
             zcmp = false;
+            zfilter = KTX_ZSTD_FILTER_NONE;
             astc = false;
             normalMode = false;
             normalize = false;
@@ -534,6 +549,28 @@ class scApp : public ktxApp {
     const string scparamKey = "KTXwriterScParams";
     string scparams;
 
+    // A plain copy of the encoding options so several encodings can be
+    // described and run at once.
+    struct encodeSettings {
+        ktxBasisParams bopts;
+        ktxAstcParams astcopts;
+        int etc1s;
+        int zcmp;
+        int astc;
+        ktx_bool_t normalMode;
+        ktx_zstd_filter_e zfilter;
+        ktx_uint32_t zcmpLevel;
+        ktx_uint32_t threadCount;
+        string params;
+
+        bool blockCompressed() const {
+            return etc1s || bopts.uastc || astc;
+        }
+    };
+    encodeSettings getEncodeSettings();
+    void setEncodeSettings(const encodeSettings& settings);
+    void resetEncodeSettings();
+
     virtual bool processOption(argparser& parser, int opt);
     enum HasArg { eNone, eOptional, eRequired };
     void captureOption(const argparser& parser, HasArg hasArg);
@@ -559,6 +596,8 @@ class scApp : public ktxApp {
 
     int encode(ktxTexture2* texture, const string& swizzle,
                const _tstring& filename);
+    int encode(ktxTexture2* texture, const string& swizzle,
+               const _tstring& filename, encodeSettings& settings);
 
     void usage()
     {
@@ -754,6 +793,18 @@ class scApp : public ktxApp {
           "               optional compressionLevel range is 1 - 22 and the default is 3.\n"
           "               Lower values=faster but give less compression. Values above 20\n"
           "               should be used with caution as they require more memory.\n"
+          "  --zfilter <none | shuffle_delta | block_split>\n"
+          "               Apply a reversible filter to the data before supercompressing\n"
+          "               it with --zcmp. shuffle_delta splits the bytes of each row into\n"
+          "               planes and delta codes them. It can greatly improve compression\n"
+          "               of uncompressed formats with 16- or 32-bit components, such as\n"
+          "               height fields and float images, but is not valid for\n"
+          "               block-compressed formats. block_split splits the bytes of each\n"
+          "               row of blocks into planes, separating fields such as endpoints\n"
+          "               and indices. It is only valid for block-compressed formats,\n"
+          "               e.g. BCn, ETC or ASTC. The filter is recorded as a libktx\n"
+          "               vendor supercompression scheme so the output can only be read\n"
+          "               by libktx. Default is none.\n"
           "  --threads <count>\n"
           "               Explicitly set the number of threads to use during compression.\n"
           "               By default, ETC1S / BasisLZ and ASTC compression will use the\n"
@@ -808,6 +859,7 @@ scApp::scApp(string& version, string& defaultVersion,
       { "encode", argparser::option::required_argument, NULL, 1016 },
       { "input_swizzle", argparser::option::required_argument, NULL, 1100},
       { "normalize", argparser::option::no_argument, NULL, 1017 },
+      { "zfilter", argparser::option::required_argument, NULL, 1019 },
       // Deprecated options
       { "bcmp", argparser::option::no_argument, NULL, 'b' },
       { "uastc", argparser::option::optional_argument, NULL, 1018 }
@@ -845,6 +897,10 @@ scApp::validateOptions() {
         cerr << name << ": Warning: ignoring --qlevel as it, --max_endpoints"
              << " and --max_selectors are all set." << endl;
     }
+    if (options.zfilter != KTX_ZSTD_FILTER_NONE && !options.zcmp) {
+        cerr << name << ": Warning: ignoring --zfilter as --zcmp is not set."
+             << endl;
+    }
 }
 
 void
@@ -1045,6 +1101,21 @@ scApp::processOption(argparser& parser, int opt)
             hasArg = true;
         }
         break;
+      case 1019:
+        if (parser.optarg == "none") {
+            options.zfilter = KTX_ZSTD_FILTER_NONE;
+        } else if (parser.optarg == "shuffle_delta") {
+            options.zfilter = KTX_ZSTD_FILTER_SHUFFLE_DELTA;
+        } else if (parser.optarg == "block_split") {
+            options.zfilter = KTX_ZSTD_FILTER_BLOCK_SPLIT;
+        } else {
+            cerr << name << ": Invalid --zfilter \"" << parser.optarg << "\"."
+                 << endl;
+            usage();
+            exit(1);
+        }
+        hasArg = true;
+        break;
       case 1100:
         validateSwizzle(parser.optarg);
         options.inputSwizzle = parser.optarg;
@@ -1064,6 +1135,72 @@ scApp::processOption(argparser& parser, int opt)
     return true;
 }
 
+/* @internal
+ * @brief Return a copy of the current encoding options.
+ */
+scApp::encodeSettings
+scApp::getEncodeSettings()
+{
+    encodeSettings settings;
+
+    // Assign through the clamped options.
+    options.bopts.threadCount = options.threadCount;
+    options.bopts.normalMap = options.normalMode;
+    options.astcopts.threadCount = options.threadCount;
+    options.astcopts.normalMap = options.normalMode;
+
+    settings.bopts = options.bopts;
+    settings.astcopts = options.astcopts;
+    settings.etc1s = options.etc1s;
+    settings.zcmp = options.zcmp;
+    settings.astc = options.astc;
+    settings.normalMode = options.normalMode;
+    settings.zfilter = options.zfilter;
+    settings.zcmpLevel = options.zcmpLevel;
+    settings.threadCount = options.threadCount;
+    settings.params = getParamsStr();
+    return settings;
+}
+
+/* @internal
+ * @brief Replace the current encoding options with @p settings.
+ */
+void
+scApp::setEncodeSettings(const encodeSettings& settings)
+{
+    // Assigning the base structs leaves the clamped options referring to
+    // the same fields.
+    static_cast<ktxBasisParams&>(options.bopts) = settings.bopts;
+    static_cast<ktxAstcParams&>(options.astcopts) = settings.astcopts;
+    options.etc1s = settings.etc1s;
+    options.zcmp = settings.zcmp;
+    options.astc = settings.astc;
+    options.normalMode = settings.normalMode;
+    options.zfilter = settings.zfilter;
+    options.zcmpLevel = settings.zcmpLevel;
+    options.threadCount = settings.threadCount;
+    scparams = settings.params;
+}
+
+/* @internal
+ * @brief Reset the encoding options to their defaults.
+ */
+void
+scApp::resetEncodeSettings()
+{
+    commandOptions defaults;
+
+    static_cast<ktxBasisParams&>(options.bopts) = defaults.bopts;
+    static_cast<ktxAstcParams&>(options.astcopts) = defaults.astcopts;
+    options.etc1s = defaults.etc1s;
+    options.zcmp = defaults.zcmp;
+    options.astc = defaults.astc;
+    options.normalMode = defaults.normalMode;
+    options.zfilter = defaults.zfilter;
+    options.zcmpLevel = defaults.zcmpLevel;
+    scparams.clear();
+}
+
 /* @internal
  * @brief Compress a texture according to the specified @c options.
  *
@@ -1076,31 +1213,46 @@ scApp::processOption(argparser& parser, int opt)
 int
 scApp::encode(ktxTexture2* texture, const string& swizzle,
               const _tstring& filename)
+{
+    encodeSettings settings = getEncodeSettings();
+    return encode(texture, swizzle, filename, settings);
+}
+
+/* @internal
+ * @brief Compress a texture according to @p settings.
+ *
+ * Does not touch @c options so may be called from several threads at once
+ * for different textures.
+ *
+ * @param[in] texture    the texture to compress
+ * @param[in] swizzle    swizzle the encoder should apply to the input data
+ * @param[in] filename   Name of the file corresponding to the texture.
+ * @param[in] settings   the encoding to use.
+ *
+ * @return 0 on success, an exit code on error.
+ */
+int
+scApp::encode(ktxTexture2* texture, const string& swizzle,
+              const _tstring& filename, encodeSettings& settings)
 {
     ktx_error_code_e result;
 
     ktx_uint32_t oetf = ktxTexture2_GetOETF(texture);
-    if (options.normalMode && oetf != KHR_DF_TRANSFER_LINEAR) {
+    if (settings.normalMode && oetf != KHR_DF_TRANSFER_LINEAR) {
         cerr << name << ": "
              << "--normal_mode specified but input file(s) are not "
              << "linear." << endl;
         return 1;
 
     }
-    if (options.etc1s || options.bopts.uastc) {
-        commandOptions::basisOptions& bopts = options.bopts;
+    if (settings.etc1s || settings.bopts.uastc) {
+        ktxBasisParams& bopts = settings.bopts;
         if (swizzle.size()) {
-            for (uint32_t i = 0; i < swizzle.size(); i++) {
+            for (uint32_t i = 0; i < swizzle.size() && i < 4; i++) {
                  bopts.inputSwizzle[i] = swizzle[i];
             }
         }
 
-        bopts.threadCount = options.threadCount;
-        bopts.normalMap = options.normalMode;
-
-#if TRAVIS_DEBUG
-        bopts.print();
-#endif
         result = ktxTexture2_CompressBasisEx(texture, &bopts);
         if (KTX_SUCCESS != result) {
             cerr << name
@@ -1109,17 +1261,14 @@ scApp::encode(ktxTexture2* texture, const string& swizzle,
                  << ktxErrorString(result) << endl;
             return 2;
         }
-    } else if (options.astc) {
-        commandOptions::astcOptions& astcopts = options.astcopts;
+    } else if (settings.astc) {
+        ktxAstcParams& astcopts = settings.astcopts;
         if (swizzle.size()) {
-            for (uint32_t i = 0; i < swizzle.size(); i++) {
+            for (uint32_t i = 0; i < swizzle.size() && i < 4; i++) {
                  astcopts.inputSwizzle[i] = swizzle[i];
             }
         }
 
-        astcopts.threadCount = options.threadCount;
-        astcopts.normalMap = options.normalMode;
-
         result = ktxTexture2_CompressAstcEx((ktxTexture2*)texture,
                                          &astcopts);
         if (KTX_SUCCESS != result) {
@@ -1133,9 +1282,23 @@ scApp::encode(ktxTexture2* texture, const string& swizzle,
         result = KTX_SUCCESS;
     }
     if (KTX_SUCCESS == result) {
-        if (options.zcmp) {
-            result = ktxTexture2_DeflateZstd((ktxTexture2*)texture,
-                                              options.zcmpLevel);
+        if (settings.zcmp && texture->pData == nullptr) {
+            // Image data was not loaded because it is already deflated.
+            // Re-deflate it level by level.
+            result = ktxTexture2_RedeflateZstd((ktxTexture2*)texture,
+                                               settings.zcmpLevel,
+                                               settings.zfilter,
+                                               settings.threadCount);
+            if (KTX_SUCCESS != result) {
+                cerr << name << ": Zstd re-deflation of \"" << filename
+                     << "\" failed; KTX error: "
+                     << ktxErrorString(result) << endl;
+                return 2;
+            }
+        } else if (settings.zcmp) {
+            result = ktxTexture2_DeflateZstdFiltered((ktxTexture2*)texture,
+                                                     settings.zcmpLevel,
+                                                     settings.zfilter);
             if (KTX_SUCCESS != result) {
                 cerr << name << ": Zstd deflation of \"" << filename
                      << "\" failed; KTX error: "
@@ -1144,11 +1307,13 @@ scApp::encode(ktxTexture2* texture, const string& swizzle,
             }
         }
     }
-    if (!getParamsStr().empty()) {
+    if (!settings.params.empty()) {
+        // Replace any parameters recorded when the input was compressed.
+        ktxHashList_DeleteKVPair(&texture->kvDataHead, scparamKey.c_str());
         ktxHashList_AddKVPair(&texture->kvDataHead,
             scparamKey.c_str(),
-            (ktx_uint32_t)getParamsStr().length() + 1,
-            getParamsStr().c_str());
+            (ktx_uint32_t)settings.params.length() + 1,
+            settings.params.c_str());
     }
     return 0;
 }